@@ -4,6 +4,9 @@
 #include <SDL3/SDL_main.h>
 #include <stdlib.h>
 
+#include "gpumemory.h"
+#include "pixels.h"
+
 #define WINDOW_WIDTH  500
 #define WINDOW_HEIGHT 500
 
@@ -11,6 +14,12 @@ typedef struct
 {
     const char *base_path;
 
+    // Every buffer, texture and transfer buffer is created through it.
+    struct APP_GPUMemory *memory;
+    // Bytes of GPU memory the example may allocate, 0 for no budget. Set
+    // with --vram-budget.
+    Uint64 memory_budget;
+
     SDL_Window *window;
     SDL_GPUDevice *device;
 
@@ -27,16 +36,56 @@ typedef struct
     float u, v;
 } PositionTextureVertex;
 
+// ====================
+// GPU Memory
+// ====================
+
+// A hard budget: the allocation fails and init_renderer takes its error
+// path. The report shows what filled the budget.
+bool
+APP_OnGpuMemoryOverBudget(
+        const struct APP_GPUAllocation *request,
+        const struct APP_GPUMemoryStats *stats,
+        void *user_data
+)
+{
+    Context *context = user_data;
+
+    SDL_Log(
+            "ERROR: '%s' (%s, %llu bytes) exceeds the GPU memory budget of %llu bytes, %llu bytes are live.",
+            request->name,
+            APP_GPUMemory_CategoryName(request->category),
+            (unsigned long long)request->size,
+            (unsigned long long)stats->budget_bytes,
+            (unsigned long long)stats->live_bytes
+    );
+
+    APP_GPUMemory_LogReport(context->memory);
+    return false;
+}
+
+// ====================
+// END GPU Memory
+// ====================
+
 // ====================
 // Rendering
 // ====================
 
+// The surface keeps the format of the file, init_renderer converts it with
+// APP_ConvertSurfaceToABGR8888 straight into the upload buffer.
 SDL_Surface*
 APP_LoadImage(Context *context, const char *image_filenamen, int desired_channels)
 {
     char full_path[256];
     SDL_Surface *result;
-    SDL_PixelFormat format;
+
+    if(desired_channels != 4)
+    {
+        SDL_assert(!"Unexpected desiredChannels");
+        SDL_Log("ERROR: Unexpected desiredChannels");
+        return NULL;
+    }
 
     SDL_snprintf(full_path, sizeof(full_path), "%simages/%s", context->base_path, image_filenamen);
 
@@ -49,26 +98,7 @@ APP_LoadImage(Context *context, const char *image_filenamen, int desired_channel
         return NULL;
     }
 
-    if(desired_channels == 4)
-    {
-        format = SDL_PIXELFORMAT_ABGR8888;
-    }
-    else
-    {
-        SDL_assert(!"Unexpected desiredChannels");
-        SDL_DestroySurface(result);
-        SDL_Log("ERROR: Unexpected desiredChannels");
-        return NULL;
-    }
-
-    if(result->format != format)
-    {
-        SDL_Surface *next = SDL_ConvertSurface(result, format);
-        SDL_DestroySurface(result);
-        result = next;
-    }
-
-    SDL_Log("INFO: Image width: %i height: %i", result->w, result->w);
+    SDL_Log("INFO: Image width: %i height: %i", result->w, result->h);
     return result;
 }
 
@@ -271,26 +301,26 @@ init_renderer(Context *context)
             }
     );
 
-    context->vertex_buffer = SDL_CreateGPUBuffer(
-            context->device,
+    context->vertex_buffer = APP_GPUMemory_CreateBuffer(
+            context->memory,
             &(SDL_GPUBufferCreateInfo){
                 .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
                 .size  = sizeof(PositionTextureVertex) * 4,
-            }
+            },
+            "Vertex Buffer"
     );
 
-    SDL_SetGPUBufferName(context->device, context->vertex_buffer, "Vertex Buffer");
-
-    context->index_buffer = SDL_CreateGPUBuffer(
-            context->device, 
+    context->index_buffer = APP_GPUMemory_CreateBuffer(
+            context->memory, 
             &(SDL_GPUBufferCreateInfo){ 
                 .usage = SDL_GPU_BUFFERUSAGE_INDEX, 
                 .size = sizeof(Uint16) * 6 
-            }
+            },
+            "Index Buffer"
     );
 
-    context->texture = SDL_CreateGPUTexture(
-            context->device,
+    context->texture = APP_GPUMemory_CreateTexture(
+            context->memory,
             &(SDL_GPUTextureCreateInfo){ 
                 .type                 = SDL_GPU_TEXTURETYPE_2D,
                 .format               = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
@@ -299,19 +329,41 @@ init_renderer(Context *context)
                 .layer_count_or_depth = 1,
                 .num_levels           = 1,
                 .usage                = SDL_GPU_TEXTUREUSAGE_SAMPLER 
-            }
+            },
+            "Texture"
     );
 
-    SDL_SetGPUTextureName(context->device, context->texture, "Texture");
-
-    SDL_GPUTransferBuffer *buffer_transfer_buffer = SDL_CreateGPUTransferBuffer(
-            context->device,
+    SDL_GPUTransferBuffer *buffer_transfer_buffer = APP_GPUMemory_CreateTransferBuffer(
+            context->memory,
             &(SDL_GPUTransferBufferCreateInfo){ 
                 .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
                 .size  = (sizeof(PositionTextureVertex) * 4) + (sizeof(Uint16) * 6) 
-            }
+            },
+            "Buffer Upload"
     );
 
+    SDL_GPUTransferBuffer *texture_transfer_buffer = APP_GPUMemory_CreateTransferBuffer(
+            context->memory,
+            &(SDL_GPUTransferBufferCreateInfo){ 
+                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                .size  = image_data->w * image_data->h * 4 
+            },
+            "Texture Upload"
+    );
+
+    if(context->vertex_buffer == NULL 
+       || context->index_buffer == NULL 
+       || context->texture == NULL
+       || buffer_transfer_buffer == NULL 
+       || texture_transfer_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create GPU resources. %s", SDL_GetError());
+        APP_GPUMemory_ReleaseTransferBuffer(context->memory, buffer_transfer_buffer);
+        APP_GPUMemory_ReleaseTransferBuffer(context->memory, texture_transfer_buffer);
+        SDL_DestroySurface(image_data);
+        return -1;
+    }
+
     PositionTextureVertex *transfer_data = SDL_MapGPUTransferBuffer(context->device, buffer_transfer_buffer, false);
 
     transfer_data[0] = (PositionTextureVertex){ -1, 1, 0, 0, 0 };
@@ -330,19 +382,28 @@ init_renderer(Context *context)
 
     SDL_UnmapGPUTransferBuffer(context->device, buffer_transfer_buffer);
 
-    SDL_GPUTransferBuffer *texture_transfer_buffer = SDL_CreateGPUTransferBuffer(
-            context->device,
-            &(SDL_GPUTransferBufferCreateInfo){ 
-                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-                .size  = image_data->w * image_data->h * 4 
-            }
-    );
-
     Uint8 *texture_transfer_ptr = SDL_MapGPUTransferBuffer(context->device, texture_transfer_buffer, false);
 
-    SDL_memcpy(texture_transfer_ptr, image_data->pixels, image_data->w * image_data->h * 4);
+    Uint64 convert_start = SDL_GetPerformanceCounter();
+    bool converted = APP_ConvertSurfaceToABGR8888(image_data, texture_transfer_ptr, image_data->w * 4);
     SDL_UnmapGPUTransferBuffer(context->device, texture_transfer_buffer);
 
+    if(!converted)
+    {
+        SDL_Log("ERROR: Failed to convert image data.");
+        APP_GPUMemory_ReleaseTransferBuffer(context->memory, buffer_transfer_buffer);
+        APP_GPUMemory_ReleaseTransferBuffer(context->memory, texture_transfer_buffer);
+        SDL_DestroySurface(image_data);
+        return -1;
+    }
+
+    SDL_Log(
+            "INFO: Converted %s to ABGR8888 (%s) in %.3f ms",
+            SDL_GetPixelFormatName(image_data->format),
+            APP_PixelConverterName(image_data->format),
+            (double)(SDL_GetPerformanceCounter() - convert_start) * 1000.0 / (double)SDL_GetPerformanceFrequency()
+    );
+
     SDL_GPUCommandBuffer *upload_cmd_buffer = SDL_AcquireGPUCommandBuffer(context->device);
     SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(upload_cmd_buffer);
 
@@ -391,12 +452,30 @@ init_renderer(Context *context)
     SDL_EndGPUCopyPass(copy_pass);
     SDL_SubmitGPUCommandBuffer(upload_cmd_buffer);
     SDL_DestroySurface(image_data);
-    SDL_ReleaseGPUTransferBuffer(context->device, buffer_transfer_buffer);
-    SDL_ReleaseGPUTransferBuffer(context->device, texture_transfer_buffer);
+    APP_GPUMemory_ReleaseTransferBuffer(context->memory, buffer_transfer_buffer);
+    APP_GPUMemory_ReleaseTransferBuffer(context->memory, texture_transfer_buffer);
+
+    // The uploads close a frame of their own, the first drawn frame starts
+    // without them.
+    APP_GPUMemory_EndFrame(context->memory);
 
     return 0;
 }
 
+// Also runs when init_renderer failed half way, so everything it created
+// is released and the report lists what leaked.
+void
+release_renderer(Context *context)
+{
+    SDL_ReleaseGPUGraphicsPipeline(context->device, context->pipeline);
+    APP_GPUMemory_ReleaseBuffer(context->memory, context->vertex_buffer);
+    APP_GPUMemory_ReleaseBuffer(context->memory, context->index_buffer);
+    APP_GPUMemory_ReleaseTexture(context->memory, context->texture);
+    SDL_ReleaseGPUSampler(context->device, context->sampler);
+
+    APP_GPUMemory_LogReport(context->memory);
+}
+
 int
 draw(Context *context)
 {
@@ -459,6 +538,7 @@ draw(Context *context)
     }
 
     SDL_SubmitGPUCommandBuffer(cmd_buf);
+    APP_GPUMemory_EndFrame(context->memory);
 
     return 0;
 }
@@ -481,6 +561,16 @@ SDL_AppInit(void **appstate, int argc, char **argv)
     }
 
     Context *context = (Context *)malloc(sizeof(Context));
+    SDL_zerop(context);
+
+    // Usage: main [--vram-budget MB]
+    for(int i = 1; i < argc; ++i)
+    {
+        if(SDL_strcmp(argv[i], "--vram-budget") == 0 && i + 1 < argc)
+        {
+            context->memory_budget = (Uint64)SDL_atoi(argv[++i]) * 1024 * 1024;
+        }
+    }
 
     context->base_path = SDL_GetBasePath();
     context->device = SDL_CreateGPUDevice(
@@ -509,10 +599,25 @@ SDL_AppInit(void **appstate, int argc, char **argv)
         return SDL_APP_FAILURE;
     }
 
+    context->memory = APP_GPUMemory_Create(context->device);
+    if(context->memory == NULL)
+    {
+        SDL_Log("ERROR: Failed to create GPU memory registry.");
+        free(context);
+        return SDL_APP_FAILURE;
+    }
+
+    if(context->memory_budget > 0)
+    {
+        APP_GPUMemory_SetBudget(context->memory, context->memory_budget, APP_OnGpuMemoryOverBudget, context);
+    }
+
     int result = init_renderer(context);
     if(result)
     {
         SDL_Log("ERROR: Failed to init renderer.");
+        release_renderer(context);
+        APP_GPUMemory_Destroy(context->memory);
         free(context);
         return SDL_APP_FAILURE;
     }
@@ -550,11 +655,8 @@ SDL_AppQuit(void *appstate, SDL_AppResult result)
 {
     Context *context = appstate;
 
-    SDL_ReleaseGPUGraphicsPipeline(context->device, context->pipeline);
-    SDL_ReleaseGPUBuffer(context->device, context->vertex_buffer);
-    SDL_ReleaseGPUBuffer(context->device, context->index_buffer);
-    SDL_ReleaseGPUTexture(context->device, context->texture);
-    SDL_ReleaseGPUSampler(context->device, context->sampler);
+    release_renderer(context);
+    APP_GPUMemory_Destroy(context->memory);
 
     SDL_ReleaseWindowFromGPUDevice(context->device, context->window);
     SDL_DestroyWindow(context->window);
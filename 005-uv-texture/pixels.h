@@ -0,0 +1,22 @@
+#ifndef PIXELS_H
+#define PIXELS_H
+
+#include <SDL3/SDL.h>
+
+// Converts decoded images to ABGR8888 (RGBA bytes on little endian, the
+// layout of SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM). The destination is any
+// memory the caller owns, usually a mapped upload transfer buffer, so no
+// converted copy of the image is made.
+//
+// BGR24, ARGB8888/XRGB8888 (BGRA32), ABGR8888/XBGR8888, RGB565 and INDEX8
+// have their own row kernels with AVX2, SSE and NEON paths picked at
+// runtime. Every other format falls back to an SDL blit into the
+// destination.
+
+bool APP_ConvertSurfaceToABGR8888(SDL_Surface *surface, void *dst, int dst_pitch);
+
+// Name of the kernel APP_ConvertSurfaceToABGR8888 uses for the format on
+// this CPU, for the logs.
+const char *APP_PixelConverterName(SDL_PixelFormat format);
+
+#endif
@@ -4,16 +4,227 @@
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_stdinc.h>
 
+struct APP_Context;
+struct APP_DepthPyramid;
+struct APP_GPUMemory;
+struct APP_MegaBuffer;
+struct APP_MeshData;
+struct APP_Pack;
+struct APP_RenderGraph;
+struct APP_SceneObject;
+
+#define APP_MAX_MESH_LODS 4
+
+// The cull counters are read back this many frames later, by then the GPU
+// is done with the frame that wrote them.
+#define APP_CULL_READBACK_FRAMES 3
+
+enum APP_MeshId {
+    APP_MESH_CUBE,
+    APP_MESH_SPHERE,
+    APP_MESH_COUNT
+};
+
+struct APP_MeshLOD {
+    Uint32 first_index;
+    Uint32 index_count;
+    // Geometric error relative to the mesh radius.
+    float error;
+};
+
+// The vertices and indices of all meshes live in the shared mesh buffers,
+// the LOD first indices are relative to the first index of the mesh.
+struct APP_Mesh {
+    Uint32 vertex_allocation;
+    Uint32 index_allocation;
+    Sint32 base_vertex;
+    Uint32 first_index;
+    Uint32 vertex_count;
+    float radius;
+
+    Uint32 lod_count;
+    struct APP_MeshLOD lods[APP_MAX_MESH_LODS];
+};
+
+// Frame scoped storage buffer for per object data. Written once per frame
+// through a mapped transfer buffer, the shaders index into it.
+struct APP_UniformArena {
+    SDL_GPUBuffer *buffer;
+    SDL_GPUTransferBuffer *transfer_buffer;
+    Uint8 *mapped;
+    // Bytes.
+    Uint32 capacity;
+    Uint32 size;
+};
+
+// Range of a mesh LOD in the uniform arena, in objects.
+struct APP_DrawGroup {
+    Uint32 first;
+    Uint32 count;
+};
+
+// Scales the resolution the scene is rendered at to hold a frame time
+// budget. The scale applies to width and height.
+struct APP_DynamicResolution {
+    bool enabled;
+    float scale;
+    float min_scale;
+    float max_scale;
+    float target_ms;
+
+    // Smoothed frame time.
+    float average_ms;
+    Uint32 frames_since_change;
+    // Frames on budget before a higher scale is tried. Doubles every time a
+    // try misses the budget and halves every time one holds it.
+    Uint32 probe_interval;
+    bool probing;
+    float probe_from;
+    Uint32 change_count;
+};
+
+#define APP_MAX_STARTUP_PHASES 24
+#define APP_MAX_SHADER_BLOBS 8
+
+// Span of work between SDL_AppInit and the first presented frame. The lane
+// is the thread or task that did it.
+struct APP_StartupPhase {
+    char name[32];
+    const char *lane;
+    Uint64 start;
+    Uint64 end;
+};
+
+// Phases of the startup, the tasks add theirs from their own threads.
+struct APP_StartupReport {
+    // Off runs every task inline, in the order it is started.
+    bool parallel;
+    Uint64 origin;
+    SDL_Mutex *lock;
+    struct APP_StartupPhase phases[APP_MAX_STARTUP_PHASES];
+    Uint32 phase_count;
+    bool finished;
+};
+
+typedef int (*APP_StartupFn)(struct APP_Context *ctx);
+
+struct APP_StartupTask {
+    const char *name;
+    APP_StartupFn fn;
+    struct APP_Context *ctx;
+    SDL_Thread *thread;
+    bool started;
+    int result;
+};
+
+enum APP_StartupTaskId {
+    // Creates the device and reads the shader blobs for its backend.
+    APP_STARTUP_TASK_DEVICE,
+    // Builds the meshes and their LOD chains on the CPU.
+    APP_STARTUP_TASK_MESHES,
+    // Creates every pipeline from the preloaded blobs.
+    APP_STARTUP_TASK_PIPELINES,
+    APP_STARTUP_TASK_COUNT
+};
+
+// Compiled shader read ahead of the pipeline creation.
+struct APP_ShaderBlob {
+    const char *filename;
+    SDL_GPUShaderFormat format;
+    const void *code;
+    size_t code_size;
+    // The code if it was read from disk or decompressed, NULL if it points
+    // into the asset pack.
+    void *owned;
+};
+
+struct APP_FrameStats {
+    // CPU time spent recording culling and draw commands for the scene.
+    Uint64 record_ticks;
+    Uint32 frames;
+    Uint32 visible_objects;
+    // Only counted by the GPU culling.
+    Uint32 occluded_objects;
+    Uint32 draw_calls;
+    Uint64 triangles;
+};
+
+struct APP_Benchmark {
+    bool enabled;
+    Uint32 step;
+    Uint32 frame;
+};
+
 struct APP_Context {
     const char *base_path;
+    // NULL to read the loose files of the example.
+    struct APP_Pack *pack;
     float time;
 
+    struct APP_StartupReport startup;
+    struct APP_StartupTask startup_tasks[APP_STARTUP_TASK_COUNT];
+    // Meshes built by the mesh task, uploaded once the buffers exist.
+    struct APP_MeshData *startup_meshes;
+    struct APP_ShaderBlob shader_blobs[APP_MAX_SHADER_BLOBS];
+    Uint32 shader_blob_count;
+
     SDL_Window *window;
     SDL_GPUDevice *device;
     SDL_GPUGraphicsPipeline *pipeline;
 
-    SDL_GPUBuffer *scene_vertex_buffer;
-    SDL_GPUBuffer *scene_index_buffer;
+    struct APP_GPUMemory *gpu_memory;
+    // Bytes, 0 for no budget.
+    Uint64 gpu_memory_budget;
+
+    SDL_GPUTextureFormat depth_format;
+    // The depth pyramid needs a depth format that can be sampled.
+    bool depth_sampleable;
+
+    struct APP_RenderGraph *render_graph;
+    // Log the next compiled frame graph.
+    bool dump_render_graph;
+
+    struct APP_MegaBuffer *mesh_vertex_buffer;
+    struct APP_MegaBuffer *mesh_index_buffer;
+    struct APP_Mesh meshes[APP_MESH_COUNT];
+
+    bool lod_enabled;
+    struct APP_SceneObject *scene_objects;
+    Uint8 *scene_object_lods;
+    Uint32 scene_object_count;
+    SDL_GPUBuffer *scene_object_buffer;
+    SDL_GPUBuffer *visible_object_buffer;
+    SDL_GPUBuffer *lod_state_buffer;
+
+    // CPU culling either pushes the uniforms of every draw or writes them
+    // into the arena and draws every mesh LOD instanced.
+    bool uniform_arena;
+    SDL_GPUGraphicsPipeline *arena_pipeline;
+    struct APP_UniformArena object_arena;
+    struct APP_DrawGroup arena_groups[APP_MESH_COUNT * APP_MAX_MESH_LODS];
+    Uint32 *arena_visible_ids;
+    Uint8 *arena_visible_groups;
+
+    bool gpu_culling;
+    SDL_GPUComputePipeline *cull_pipeline;
+    SDL_GPUGraphicsPipeline *instanced_pipeline;
+    SDL_GPUBuffer *draw_command_buffer;
+    SDL_GPUTransferBuffer *draw_command_reset_buffer;
+    SDL_GPUTransferBuffer *cull_counter_readback[APP_CULL_READBACK_FRAMES];
+    Uint64 cull_frame;
+
+    // The GPU culling also drops objects hidden behind the depth of the
+    // last frame.
+    bool occlusion_culling;
+    struct APP_DepthPyramid *depth_pyramid;
+
+    struct APP_DynamicResolution dynamic_resolution;
+    Uint64 last_frame_counter;
+    // Size the scene was rendered at in the last frame.
+    Uint32 render_width, render_height;
+
+    struct APP_FrameStats stats;
+    struct APP_Benchmark benchmark;
 };
 
 #endif
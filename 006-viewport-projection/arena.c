@@ -0,0 +1,120 @@
+#include "arena.h"
+#include "app.h"
+#include "gpumemory.h"
+
+// Note(john): Entries are aligned to 16 bytes, the size of a float4 in the
+// StructuredBuffers reading the arena.
+#define ARENA_ALIGNMENT 16
+
+// Create the storage buffer and the transfer buffer the frame data is
+// written into. capacity is in bytes.
+int
+APP_UniformArena_Init(struct APP_Context *ctx, struct APP_UniformArena *arena, Uint32 capacity)
+{
+    SDL_zerop(arena);
+
+    capacity = (capacity + ARENA_ALIGNMENT - 1) & ~(Uint32)(ARENA_ALIGNMENT - 1);
+    capacity = SDL_max(capacity, ARENA_ALIGNMENT);
+
+    arena->buffer = APP_GPUMemory_CreateBuffer(
+            ctx->gpu_memory,
+            &(SDL_GPUBufferCreateInfo){
+                .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+                .size = capacity
+            },
+            "Uniform Arena"
+    );
+
+    arena->transfer_buffer = APP_GPUMemory_CreateTransferBuffer(
+            ctx->gpu_memory,
+            &(SDL_GPUTransferBufferCreateInfo){
+                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                .size = capacity
+            },
+            "Uniform Arena Upload"
+    );
+
+    if (arena->buffer == NULL || arena->transfer_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create uniform arena. %s", SDL_GetError());
+        return -1;
+    }
+
+    arena->capacity = capacity;
+    return 0;
+}
+
+void
+APP_UniformArena_Release(struct APP_Context *ctx, struct APP_UniformArena *arena)
+{
+    APP_GPUMemory_ReleaseBuffer(ctx->gpu_memory, arena->buffer);
+    APP_GPUMemory_ReleaseTransferBuffer(ctx->gpu_memory, arena->transfer_buffer);
+    SDL_zerop(arena);
+}
+
+// Map the arena for a new frame. The transfer buffer is cycled, so the
+// upload of the previous frame may still be in flight.
+bool
+APP_UniformArena_Begin(struct APP_Context *ctx, struct APP_UniformArena *arena)
+{
+    arena->size = 0;
+    arena->mapped = SDL_MapGPUTransferBuffer(ctx->device, arena->transfer_buffer, true);
+
+    if (arena->mapped == NULL)
+    {
+        SDL_Log("ERROR: Failed to map uniform arena. %s", SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+// Reserve size bytes for this frame. Returns NULL once the arena is full,
+// out_offset is the byte offset of the data in the storage buffer.
+void*
+APP_UniformArena_Alloc(struct APP_UniformArena *arena, Uint32 size, Uint32 *out_offset)
+{
+    Uint32 aligned_size = (size + ARENA_ALIGNMENT - 1) & ~(Uint32)(ARENA_ALIGNMENT - 1);
+
+    if (arena->mapped == NULL || arena->size + aligned_size > arena->capacity)
+    {
+        return NULL;
+    }
+
+    *out_offset = arena->size;
+    arena->size += aligned_size;
+
+    return arena->mapped + *out_offset;
+}
+
+// Upload everything written this frame with one copy. Has to be recorded
+// before the render pass that reads the arena.
+void
+APP_UniformArena_End(struct APP_Context *ctx, struct APP_UniformArena *arena, SDL_GPUCommandBuffer *cmd_buffer)
+{
+    SDL_UnmapGPUTransferBuffer(ctx->device, arena->transfer_buffer);
+    arena->mapped = NULL;
+
+    if (arena->size == 0)
+    {
+        return;
+    }
+
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(cmd_buffer);
+
+    SDL_UploadToGPUBuffer(
+            copy_pass,
+            &(SDL_GPUTransferBufferLocation){
+                .transfer_buffer = arena->transfer_buffer,
+                .offset = 0
+            },
+            &(SDL_GPUBufferRegion){
+                .buffer = arena->buffer,
+                .offset = 0,
+                .size = arena->size
+            },
+            true
+    );
+
+    SDL_EndGPUCopyPass(copy_pass);
+}
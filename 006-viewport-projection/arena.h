@@ -0,0 +1,17 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "app.h"
+
+int APP_UniformArena_Init(struct APP_Context *ctx, struct APP_UniformArena *arena, Uint32 capacity);
+void APP_UniformArena_Release(struct APP_Context *ctx, struct APP_UniformArena *arena);
+
+bool APP_UniformArena_Begin(struct APP_Context *ctx, struct APP_UniformArena *arena);
+void *APP_UniformArena_Alloc(struct APP_UniformArena *arena, Uint32 size, Uint32 *out_offset);
+void APP_UniformArena_End(
+        struct APP_Context *ctx, 
+        struct APP_UniformArena *arena, 
+        SDL_GPUCommandBuffer *cmd_buffer
+);
+
+#endif
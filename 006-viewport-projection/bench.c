@@ -0,0 +1,204 @@
+#include "bench.h"
+#include "app.h"
+#include "gpumemory.h"
+#include "scene.h"
+
+#define STATS_LOG_INTERVAL 120
+
+#define BENCH_WARMUP_FRAMES 30
+#define BENCH_MEASURE_FRAMES 120
+
+// Every object count is measured with each scene path, so the log shows how
+// they scale.
+static const Uint32 BENCH_OBJECT_COUNTS[] = { 1000, 10000, 100000, 250000 };
+
+enum APP_ScenePath {
+    APP_SCENE_PATH_CPU_PUSH,
+    APP_SCENE_PATH_CPU_ARENA,
+    APP_SCENE_PATH_GPU,
+    APP_SCENE_PATH_COUNT
+};
+
+static void
+APP_SetScenePath(struct APP_Context *ctx, enum APP_ScenePath path)
+{
+    ctx->gpu_culling = path == APP_SCENE_PATH_GPU;
+    ctx->uniform_arena = path == APP_SCENE_PATH_CPU_ARENA;
+}
+
+static const char*
+APP_ScenePathName(const struct APP_Context *ctx)
+{
+    if (ctx->gpu_culling)
+    {
+        return "GPU culling";
+    }
+
+    return ctx->uniform_arena ? "CPU culling, arena" : "CPU culling, push";
+}
+
+static double
+APP_AverageRecordMs(const struct APP_FrameStats *stats)
+{
+    if (stats->frames == 0)
+    {
+        return 0.0;
+    }
+
+    double ticks = (double)stats->record_ticks / stats->frames;
+    return ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+// CPU cost of a single draw call in microseconds, the whole scene record
+// time spread over the draws of the last frame.
+static double
+APP_AverageDrawUs(const struct APP_FrameStats *stats)
+{
+    if (stats->draw_calls == 0)
+    {
+        return 0.0;
+    }
+
+    return APP_AverageRecordMs(stats) * 1000.0 / stats->draw_calls;
+}
+
+// Log the average CPU cost of the scene every STATS_LOG_INTERVAL frames.
+void
+APP_LogFrameStats(struct APP_Context *ctx)
+{
+    if (ctx->stats.frames < STATS_LOG_INTERVAL)
+    {
+        return;
+    }
+
+    SDL_Log(
+            "INFO: %s, LOD %s, %u objects, scene record %.3f ms, %u draws (%.3f us per draw)",
+            APP_ScenePathName(ctx),
+            ctx->lod_enabled ? "on" : "off",
+            ctx->scene_object_count,
+            APP_AverageRecordMs(&ctx->stats),
+            ctx->stats.draw_calls,
+            APP_AverageDrawUs(&ctx->stats)
+    );
+
+    // Note(john): Only the CPU path knows what it submitted. The GPU path
+    // reads its cull counters back a few frames late, the triangle count
+    // would need a readback of the indirect commands.
+    if (!ctx->gpu_culling)
+    {
+        SDL_Log(
+                "INFO: %u visible objects, %llu triangles per frame",
+                ctx->stats.visible_objects,
+                (unsigned long long)(ctx->stats.triangles / ctx->stats.frames)
+        );
+    }
+    else
+    {
+        Uint32 in_frustum = ctx->stats.visible_objects + ctx->stats.occluded_objects;
+
+        SDL_Log(
+                "INFO: %u visible objects, %u of %u in the frustum occluded (%.1f%%), occlusion culling %s",
+                ctx->stats.visible_objects,
+                ctx->stats.occluded_objects,
+                in_frustum,
+                in_frustum > 0 ? 100.0f * (float)ctx->stats.occluded_objects / (float)in_frustum : 0.0f,
+                ctx->occlusion_culling ? "on" : "off"
+        );
+    }
+
+    const struct APP_DynamicResolution *dynres = &ctx->dynamic_resolution;
+    SDL_Log(
+            "INFO: Render %ux%u, dynamic resolution %s, scale %.2f (%.2f - %.2f), frame %.2f ms of %.2f ms, %u changes",
+            ctx->render_width,
+            ctx->render_height,
+            dynres->enabled ? "on" : "off",
+            dynres->enabled ? dynres->scale : 1.0f,
+            dynres->min_scale,
+            dynres->max_scale,
+            dynres->average_ms,
+            dynres->target_ms,
+            dynres->change_count
+    );
+
+    struct APP_GPUMemoryStats memory;
+    APP_GPUMemory_GetStats(ctx->gpu_memory, &memory);
+
+    SDL_Log(
+            "INFO: GPU memory %.2f MB live in %u allocations, high water %.2f MB, last frame %u allocations %u releases",
+            (double)memory.live_bytes / (1024.0 * 1024.0),
+            memory.live_count,
+            (double)memory.high_water_bytes / (1024.0 * 1024.0),
+            memory.frame_allocations,
+            memory.frame_releases
+    );
+
+    SDL_zero(ctx->stats);
+}
+
+// Step through the benchmark table. Returns true once every step has been
+// measured.
+bool
+APP_UpdateBenchmark(struct APP_Context *ctx)
+{
+    struct APP_Benchmark *bench = &ctx->benchmark;
+    Uint32 step_count = SDL_arraysize(BENCH_OBJECT_COUNTS) * APP_SCENE_PATH_COUNT;
+
+    bench->frame++;
+
+    if (bench->frame == BENCH_WARMUP_FRAMES)
+    {
+        SDL_zero(ctx->stats);
+    }
+
+    if (bench->frame < BENCH_WARMUP_FRAMES + BENCH_MEASURE_FRAMES)
+    {
+        return false;
+    }
+
+    SDL_Log(
+            "INFO: [bench] %-18s %7u objects: %8.3f ms scene record, %6u draws, %7.3f us per draw, %6.3f us per visible object, %6u occluded",
+            APP_ScenePathName(ctx),
+            ctx->scene_object_count,
+            APP_AverageRecordMs(&ctx->stats),
+            ctx->stats.draw_calls,
+            APP_AverageDrawUs(&ctx->stats),
+            ctx->stats.visible_objects > 0 
+                ? APP_AverageRecordMs(&ctx->stats) * 1000.0 / ctx->stats.visible_objects 
+                : 0.0,
+            ctx->stats.occluded_objects
+    );
+
+    bench->step++;
+    bench->frame = 0;
+    SDL_zero(ctx->stats);
+
+    if (bench->step >= step_count)
+    {
+        return true;
+    }
+
+    APP_SetScenePath(ctx, bench->step % APP_SCENE_PATH_COUNT);
+
+    Uint32 object_count = BENCH_OBJECT_COUNTS[bench->step / APP_SCENE_PATH_COUNT];
+    if (object_count != ctx->scene_object_count)
+    {
+        SDL_WaitForGPUIdle(ctx->device);
+        APP_ReleaseScene(ctx);
+
+        if (APP_CreateScene(ctx, object_count) == -1)
+        {
+            SDL_Log("ERROR: Failed to create benchmark scene.");
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// The benchmark starts with the first table entry and the push path.
+Uint32
+APP_BenchmarkFirstObjectCount(struct APP_Context *ctx)
+{
+    APP_SetScenePath(ctx, APP_SCENE_PATH_CPU_PUSH);
+    return BENCH_OBJECT_COUNTS[0];
+}
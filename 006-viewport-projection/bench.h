@@ -0,0 +1,10 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "app.h"
+
+void APP_LogFrameStats(struct APP_Context *ctx);
+bool APP_UpdateBenchmark(struct APP_Context *ctx);
+Uint32 APP_BenchmarkFirstObjectCount(struct APP_Context *ctx);
+
+#endif
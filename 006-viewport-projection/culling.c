@@ -0,0 +1,372 @@
+#include "culling.h"
+#include "app.h"
+#include "gpumemory.h"
+#include "hiz.h"
+#include "math.h"
+#include "mesh.h"
+#include "renderer.h"
+#include "utils.h"
+
+SDL_COMPILE_TIME_ASSERT(mesh_count, APP_MESH_COUNT <= 4);
+SDL_COMPILE_TIME_ASSERT(lod_count, APP_MAX_MESH_LODS == 4);
+SDL_COMPILE_TIME_ASSERT(hiz_levels, APP_HIZ_MAX_LEVELS % 4 == 0);
+
+// Uniform block of FrustumCull.comp.hlsl.
+struct APP_CullParams {
+    struct APP_Vector4 planes[6];
+    // xyz is the camera position, w the LOD projection scale.
+    struct APP_Vector4 camera;
+    float lod_errors[APP_MESH_COUNT][APP_MAX_MESH_LODS];
+    Uint32 lod_counts[4];
+    Uint32 object_count;
+    // A negative pixel error keeps every object at LOD 0.
+    float pixel_error;
+    float hysteresis;
+    Uint32 occlusion_enabled;
+    struct APP_Matrix4x4 pyramid_view_proj;
+    // xy is the size of level 0, z the level count.
+    Uint32 pyramid_size[4];
+    Uint32 pyramid_offsets[APP_HIZ_MAX_LEVELS];
+};
+
+// Uniform block of CulledInstance.vert.hlsl.
+struct APP_InstanceUniforms {
+    struct APP_Matrix4x4 view_proj;
+    Uint32 visible_offset;
+    Uint32 padding[3];
+};
+
+// Runs on the pipeline task, the buffers are created by APP_InitGPUCulling
+// on the main thread meanwhile.
+int
+APP_CreateCullPipelines(struct APP_Context *ctx)
+{
+    ctx->cull_pipeline = APP_LoadComputePipeline(
+            ctx,
+            "FrustumCull.comp",
+            &(SDL_GPUComputePipelineCreateInfo){
+                .num_readonly_storage_buffers = 2,
+                .num_readwrite_storage_buffers = 3,
+                .num_uniform_buffers = 1,
+                .threadcount_x = APP_CULL_THREADCOUNT,
+                .threadcount_y = 1,
+                .threadcount_z = 1,
+            }
+    );
+
+    if (ctx->cull_pipeline == NULL)
+    {
+        SDL_Log("ERROR: Failed to create 'FrustumCull' compute pipeline.");
+        return -1;
+    }
+
+    SDL_GPUShader *vertex_shader = APP_LoadShader(ctx, "CulledInstance.vert", 0, 1, 2, 0);
+    if (vertex_shader == NULL) 
+    {
+        SDL_Log("ERROR: Failed to create 'CulledInstance' vertex shader.");
+        return -1;
+    }
+
+    SDL_GPUShader *frag_shader = APP_LoadShader(ctx, "default.frag", 0, 1, 0, 0);
+    if (frag_shader == NULL) 
+    {
+        SDL_Log("ERROR: Failed to create fragment shader.");
+        return -1;
+    }
+
+    ctx->instanced_pipeline = APP_CreateGraphicsPipeline(ctx, vertex_shader, frag_shader);
+    if (ctx->instanced_pipeline == NULL) 
+    {
+        SDL_Log("ERROR: Failed to create instanced graphics pipeline. %s", SDL_GetError());
+        return -1;
+    }
+
+    SDL_ReleaseGPUShader(ctx->device, vertex_shader);
+    SDL_ReleaseGPUShader(ctx->device, frag_shader);
+
+    return 0;
+}
+
+int
+APP_InitGPUCulling(struct APP_Context *ctx)
+{
+    // Note(john): The cull shader counts the visible objects into
+    // num_instances, so the buffer has to be usable as indirect argument and
+    // as compute storage at the same time.
+    ctx->draw_command_buffer = APP_GPUMemory_CreateBuffer(
+            ctx->gpu_memory,
+            &(SDL_GPUBufferCreateInfo){
+                .usage = SDL_GPU_BUFFERUSAGE_INDIRECT | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+                .size = APP_DRAW_COMMANDS_SIZE + APP_CULL_COUNTERS_SIZE
+            },
+            "Indirect Draw Commands"
+    );
+
+    // The reset commands are written up front and copied over the draw
+    // command buffer at the start of every frame.
+    ctx->draw_command_reset_buffer = APP_GPUMemory_CreateTransferBuffer(
+            ctx->gpu_memory,
+            &(SDL_GPUTransferBufferCreateInfo){
+                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                .size = APP_DRAW_COMMANDS_SIZE + APP_CULL_COUNTERS_SIZE
+            },
+            "Draw Command Resets"
+    );
+
+    if (ctx->draw_command_buffer == NULL || ctx->draw_command_reset_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create indirect draw buffers. %s", SDL_GetError());
+        return -1;
+    }
+
+    for (Uint32 i = 0; i < APP_CULL_READBACK_FRAMES; ++i)
+    {
+        ctx->cull_counter_readback[i] = APP_GPUMemory_CreateTransferBuffer(
+                ctx->gpu_memory,
+                &(SDL_GPUTransferBufferCreateInfo){
+                    .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+                    .size = APP_CULL_COUNTERS_SIZE
+                },
+                "Cull Counter Readback"
+        );
+
+        if (ctx->cull_counter_readback[i] == NULL)
+        {
+            SDL_Log("ERROR: Failed to create cull counter readback buffer. %s", SDL_GetError());
+            return -1;
+        }
+    }
+
+    APP_WriteDrawCommandResets(ctx);
+
+    return 0;
+}
+
+// Write the commands every frame starts from. The mesh ranges are baked into
+// them, so they have to be written again when the mesh buffers change. The
+// transfer buffer is cycled, a copy of the last frame may still read it.
+void
+APP_WriteDrawCommandResets(struct APP_Context *ctx)
+{
+    SDL_GPUIndexedIndirectDrawCommand *reset_commands = SDL_MapGPUTransferBuffer(
+            ctx->device,
+            ctx->draw_command_reset_buffer,
+            true
+    );
+
+    // Also zeroes the counters behind the commands.
+    SDL_memset(reset_commands, 0, APP_DRAW_COMMANDS_SIZE + APP_CULL_COUNTERS_SIZE);
+
+    for (Uint32 mesh = 0; mesh < APP_MESH_COUNT; ++mesh)
+    {
+        for (Uint32 lod = 0; lod < ctx->meshes[mesh].lod_count; ++lod)
+        {
+            reset_commands[mesh * APP_MAX_MESH_LODS + lod] = (SDL_GPUIndexedIndirectDrawCommand){
+                .num_indices = ctx->meshes[mesh].lods[lod].index_count,
+                .num_instances = 0,
+                .first_index = ctx->meshes[mesh].first_index + ctx->meshes[mesh].lods[lod].first_index,
+                .vertex_offset = ctx->meshes[mesh].base_vertex,
+                .first_instance = 0
+            };
+        }
+    }
+
+    SDL_UnmapGPUTransferBuffer(ctx->device, ctx->draw_command_reset_buffer);
+}
+
+void
+APP_ReleaseGPUCulling(struct APP_Context *ctx)
+{
+    SDL_ReleaseGPUComputePipeline(ctx->device, ctx->cull_pipeline);
+    SDL_ReleaseGPUGraphicsPipeline(ctx->device, ctx->instanced_pipeline);
+    APP_GPUMemory_ReleaseBuffer(ctx->gpu_memory, ctx->draw_command_buffer);
+    APP_GPUMemory_ReleaseTransferBuffer(ctx->gpu_memory, ctx->draw_command_reset_buffer);
+
+    for (Uint32 i = 0; i < APP_CULL_READBACK_FRAMES; ++i)
+    {
+        APP_GPUMemory_ReleaseTransferBuffer(ctx->gpu_memory, ctx->cull_counter_readback[i]);
+    }
+}
+
+// Read the counters of the frame APP_CULL_READBACK_FRAMES - 1 frames ago.
+// Note(john): No fence needed, acquiring the swapchain texture already
+// waited for that frame since only two frames can be in flight.
+static void
+APP_ReadCullCounters(struct APP_Context *ctx)
+{
+    if (ctx->cull_frame < APP_CULL_READBACK_FRAMES - 1)
+    {
+        return;
+    }
+
+    Uint32 slot = (Uint32)((ctx->cull_frame + 1) % APP_CULL_READBACK_FRAMES);
+    const Uint32 *counters = SDL_MapGPUTransferBuffer(ctx->device, ctx->cull_counter_readback[slot], false);
+    if (counters == NULL)
+    {
+        return;
+    }
+
+    ctx->stats.occluded_objects = counters[APP_CULL_COUNTER_OCCLUDED];
+    ctx->stats.visible_objects = counters[APP_CULL_COUNTER_IN_FRUSTUM] - counters[APP_CULL_COUNTER_OCCLUDED];
+
+    SDL_UnmapGPUTransferBuffer(ctx->device, ctx->cull_counter_readback[slot]);
+}
+
+// Reset the indirect draw commands and let the compute shader append every
+// object inside the frustum, and not hidden behind the depth pyramid of the
+// last frame, to the visible list of its mesh LOD.
+void
+APP_CullSceneOnGPU(
+        struct APP_Context *ctx,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        const struct APP_Camera *camera
+)
+{
+    APP_ReadCullCounters(ctx);
+
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(cmd_buffer);
+
+    SDL_UploadToGPUBuffer(
+            copy_pass,
+            &(SDL_GPUTransferBufferLocation){
+                .transfer_buffer = ctx->draw_command_reset_buffer,
+                .offset = 0
+            },
+            &(SDL_GPUBufferRegion){
+                .buffer = ctx->draw_command_buffer,
+                .offset = 0,
+                .size = APP_DRAW_COMMANDS_SIZE + APP_CULL_COUNTERS_SIZE
+            },
+            false
+    );
+
+    SDL_EndGPUCopyPass(copy_pass);
+
+    struct APP_CullParams params = { 0 };
+    SDL_memcpy(params.planes, camera->frustum.planes, sizeof(params.planes));
+    params.camera = (struct APP_Vector4){
+        camera->position.x,
+        camera->position.y,
+        camera->position.z,
+        camera->lod_selector.projection_scale
+    };
+
+    for (Uint32 mesh = 0; mesh < APP_MESH_COUNT; ++mesh)
+    {
+        for (Uint32 lod = 0; lod < ctx->meshes[mesh].lod_count; ++lod)
+        {
+            params.lod_errors[mesh][lod] = ctx->meshes[mesh].lods[lod].error;
+        }
+
+        params.lod_counts[mesh] = ctx->meshes[mesh].lod_count;
+    }
+
+    params.object_count = ctx->scene_object_count;
+    params.pixel_error = ctx->lod_enabled ? camera->lod_selector.pixel_error : -1.0f;
+    params.hysteresis = camera->lod_selector.hysteresis;
+
+    const struct APP_DepthPyramid *pyramid = ctx->depth_pyramid;
+    if (ctx->occlusion_culling && pyramid->valid)
+    {
+        params.occlusion_enabled = 1;
+        params.pyramid_view_proj = pyramid->view_proj;
+        params.pyramid_size[0] = pyramid->level_widths[0];
+        params.pyramid_size[1] = pyramid->level_heights[0];
+        params.pyramid_size[2] = pyramid->level_count;
+        SDL_memcpy(params.pyramid_offsets, pyramid->level_offsets, sizeof(params.pyramid_offsets));
+    }
+
+    SDL_GPUComputePass *compute_pass = SDL_BeginGPUComputePass(
+            cmd_buffer,
+            NULL,
+            0,
+            (SDL_GPUStorageBufferReadWriteBinding[]){
+                { .buffer = ctx->draw_command_buffer, .cycle = false },
+                { .buffer = ctx->visible_object_buffer, .cycle = true },
+                { .buffer = ctx->lod_state_buffer, .cycle = false },
+            },
+            3
+    );
+
+    SDL_BindGPUComputePipeline(compute_pass, ctx->cull_pipeline);
+    SDL_BindGPUComputeStorageBuffers(
+            compute_pass, 
+            0, 
+            (SDL_GPUBuffer *[]){ ctx->scene_object_buffer, pyramid->buffer }, 
+            2
+    );
+    SDL_PushGPUComputeUniformData(cmd_buffer, 0, &params, sizeof(params));
+
+    Uint32 group_count = (ctx->scene_object_count + APP_CULL_THREADCOUNT - 1) / APP_CULL_THREADCOUNT;
+    SDL_DispatchGPUCompute(compute_pass, group_count, 1, 1);
+
+    SDL_EndGPUComputePass(compute_pass);
+
+    copy_pass = SDL_BeginGPUCopyPass(cmd_buffer);
+
+    SDL_DownloadFromGPUBuffer(
+            copy_pass,
+            &(SDL_GPUBufferRegion){
+                .buffer = ctx->draw_command_buffer,
+                .offset = APP_DRAW_COMMANDS_SIZE,
+                .size = APP_CULL_COUNTERS_SIZE
+            },
+            &(SDL_GPUTransferBufferLocation){
+                .transfer_buffer = ctx->cull_counter_readback[ctx->cull_frame % APP_CULL_READBACK_FRAMES],
+                .offset = 0
+            }
+    );
+
+    SDL_EndGPUCopyPass(copy_pass);
+
+    ctx->cull_frame++;
+}
+
+// Draw every object the cull pass kept with one indirect call per mesh LOD.
+// The CPU cost here does not depend on the object count.
+void
+APP_DrawSceneIndirect(
+        struct APP_Context *ctx,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        SDL_GPURenderPass *render_pass,
+        const struct APP_Camera *camera
+)
+{
+    SDL_BindGPUGraphicsPipeline(render_pass, ctx->instanced_pipeline);
+
+    Uint32 draw_count = 0;
+
+    SDL_BindGPUVertexStorageBuffers(
+            render_pass,
+            0,
+            (SDL_GPUBuffer *[]){ ctx->scene_object_buffer, ctx->visible_object_buffer },
+            2
+    );
+
+    APP_BindMeshBuffers(ctx, render_pass);
+
+    for (Uint32 mesh = 0; mesh < APP_MESH_COUNT; ++mesh)
+    {
+        for (Uint32 lod = 0; lod < ctx->meshes[mesh].lod_count; ++lod)
+        {
+            Uint32 group = mesh * APP_MAX_MESH_LODS + lod;
+
+            struct APP_InstanceUniforms uniforms = {
+                .view_proj = camera->view_proj,
+                .visible_offset = group * ctx->scene_object_count
+            };
+
+            SDL_PushGPUVertexUniformData(cmd_buffer, 0, &uniforms, sizeof(uniforms));
+            SDL_DrawGPUIndexedPrimitivesIndirect(
+                    render_pass,
+                    ctx->draw_command_buffer,
+                    group * sizeof(SDL_GPUIndexedIndirectDrawCommand),
+                    1
+            );
+
+            draw_count++;
+        }
+    }
+
+    ctx->stats.draw_calls = draw_count;
+}
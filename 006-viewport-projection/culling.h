@@ -0,0 +1,43 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include "app.h"
+#include "math.h"
+#include "scene.h"
+
+// Matches the threadcount of FrustumCull.comp.hlsl.
+#define APP_CULL_THREADCOUNT 64
+
+// Every mesh LOD is a draw group with its own indirect command and its own
+// region of object_count ids in the visible object buffer.
+#define APP_DRAW_GROUP_COUNT (APP_MESH_COUNT * APP_MAX_MESH_LODS)
+
+// Counters of the cull shader, stored as uints behind the indirect commands.
+enum APP_CullCounter {
+    APP_CULL_COUNTER_IN_FRUSTUM,
+    APP_CULL_COUNTER_OCCLUDED,
+    APP_CULL_COUNTER_COUNT
+};
+
+#define APP_DRAW_COMMANDS_SIZE (sizeof(SDL_GPUIndexedIndirectDrawCommand) * APP_DRAW_GROUP_COUNT)
+#define APP_CULL_COUNTERS_SIZE (sizeof(Uint32) * APP_CULL_COUNTER_COUNT)
+
+int APP_CreateCullPipelines(struct APP_Context *ctx);
+int APP_InitGPUCulling(struct APP_Context *ctx);
+void APP_ReleaseGPUCulling(struct APP_Context *ctx);
+void APP_WriteDrawCommandResets(struct APP_Context *ctx);
+
+void APP_CullSceneOnGPU(
+        struct APP_Context *ctx,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        const struct APP_Camera *camera
+);
+
+void APP_DrawSceneIndirect(
+        struct APP_Context *ctx,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        SDL_GPURenderPass *render_pass,
+        const struct APP_Camera *camera
+);
+
+#endif
@@ -0,0 +1,154 @@
+#include "dynres.h"
+#include "app.h"
+
+// Scales are multiples of this, so small frame time changes don't move
+// the resolution every few frames.
+#define DYNRES_SCALE_STEP 0.05f
+
+// Frames to wait after a change before the frame time is judged again.
+#define DYNRES_SETTLE_FRAMES 15
+
+// Frames above this part of the budget lower the scale, frames below the
+// lower bound raise it. In between the scale holds.
+#define DYNRES_OVER_BUDGET 1.05f
+#define DYNRES_UNDER_BUDGET 0.85f
+
+#define DYNRES_MIN_PROBE_INTERVAL 120
+#define DYNRES_MAX_PROBE_INTERVAL 1920
+
+static float
+APP_DynamicResolutionSnap(float scale)
+{
+    return SDL_floorf(scale / DYNRES_SCALE_STEP + 0.001f) * DYNRES_SCALE_STEP;
+}
+
+static float
+APP_DynamicResolutionClamp(const struct APP_DynamicResolution *dynres, float scale)
+{
+    return SDL_clamp(scale, dynres->min_scale, dynres->max_scale);
+}
+
+void
+APP_DynamicResolution_Init(
+        struct APP_DynamicResolution *dynres,
+        float target_fps,
+        float min_scale,
+        float max_scale
+)
+{
+    bool enabled = dynres->enabled;
+
+    SDL_zerop(dynres);
+
+    dynres->enabled = enabled;
+    dynres->min_scale = SDL_clamp(min_scale, 0.25f, 2.0f);
+    dynres->max_scale = SDL_clamp(max_scale, dynres->min_scale, 2.0f);
+    dynres->target_ms = 1000.0f / SDL_max(target_fps, 1.0f);
+    dynres->scale = APP_DynamicResolutionClamp(dynres, 1.0f);
+    dynres->probe_interval = DYNRES_MIN_PROBE_INTERVAL;
+}
+
+// Forget the measured frame times, e.g. after the window was resized.
+void
+APP_DynamicResolution_Reset(struct APP_DynamicResolution *dynres)
+{
+    dynres->average_ms = 0.0f;
+    dynres->frames_since_change = 0;
+    dynres->probing = false;
+}
+
+// Feed the time of the last frame. Returns true if the scale changed.
+//
+// Note(john): The GPU cost is roughly proportional to the pixel count, so a
+// frame time ratio r is a scale ratio of sqrt(r). With vsync the frame time
+// never drops below the refresh interval, which is the budget, so while on
+// budget a higher scale is tried every now and then. A try that misses the
+// budget goes back and waits twice as long before the next one, a try that
+// holds it halves the wait.
+bool
+APP_DynamicResolution_Update(struct APP_DynamicResolution *dynres, float frame_ms)
+{
+    if (!dynres->enabled)
+    {
+        return false;
+    }
+
+    dynres->average_ms = dynres->average_ms == 0.0f 
+        ? frame_ms 
+        : dynres->average_ms + (frame_ms - dynres->average_ms) * 0.1f;
+
+    dynres->frames_since_change++;
+    if (dynres->frames_since_change < DYNRES_SETTLE_FRAMES)
+    {
+        return false;
+    }
+
+    float scale = dynres->scale;
+    float ratio = dynres->average_ms / dynres->target_ms;
+
+    if (ratio > DYNRES_OVER_BUDGET)
+    {
+        if (dynres->probing)
+        {
+            scale = dynres->probe_from;
+            dynres->probe_interval = SDL_min(dynres->probe_interval * 2, DYNRES_MAX_PROBE_INTERVAL);
+        }
+        else
+        {
+            // The load changed, so try higher scales soon again.
+            scale = APP_DynamicResolutionSnap(scale * SDL_sqrtf(1.0f / ratio));
+            dynres->probe_interval = DYNRES_MIN_PROBE_INTERVAL;
+        }
+
+        dynres->probing = false;
+    }
+    else if (ratio < DYNRES_UNDER_BUDGET)
+    {
+        float raised = APP_DynamicResolutionSnap(scale * SDL_min(SDL_sqrtf(DYNRES_UNDER_BUDGET / ratio), 1.25f));
+        scale = SDL_max(raised, scale + DYNRES_SCALE_STEP);
+        dynres->probing = false;
+    }
+    else if (dynres->probing)
+    {
+        // The try held the budget long enough, the next one can come sooner.
+        if (dynres->frames_since_change >= DYNRES_SETTLE_FRAMES * 4)
+        {
+            dynres->probing = false;
+            dynres->probe_interval = SDL_max(dynres->probe_interval / 2, DYNRES_MIN_PROBE_INTERVAL);
+        }
+    }
+    else if (dynres->frames_since_change >= dynres->probe_interval && dynres->scale < dynres->max_scale)
+    {
+        dynres->probing = true;
+        dynres->probe_from = dynres->scale;
+        scale += DYNRES_SCALE_STEP;
+    }
+
+    scale = APP_DynamicResolutionClamp(dynres, scale);
+    if (SDL_fabsf(scale - dynres->scale) < DYNRES_SCALE_STEP * 0.5f)
+    {
+        return false;
+    }
+
+    // The frame times measured so far belong to the old scale.
+    dynres->scale = scale;
+    dynres->average_ms = 0.0f;
+    dynres->frames_since_change = 0;
+    dynres->change_count++;
+
+    return true;
+}
+
+// Size of width x height at the given scale, never smaller than one pixel.
+void
+APP_DynamicResolution_GetSize(
+        float scale,
+        Uint32 width,
+        Uint32 height,
+        Uint32 *out_width,
+        Uint32 *out_height
+)
+{
+    *out_width = SDL_max((Uint32)((float)width * scale + 0.5f), 1);
+    *out_height = SDL_max((Uint32)((float)height * scale + 0.5f), 1);
+}
@@ -0,0 +1,24 @@
+#ifndef DYNRES_H
+#define DYNRES_H
+
+#include "app.h"
+
+void APP_DynamicResolution_Init(
+        struct APP_DynamicResolution *dynres,
+        float target_fps,
+        float min_scale,
+        float max_scale
+);
+
+bool APP_DynamicResolution_Update(struct APP_DynamicResolution *dynres, float frame_ms);
+void APP_DynamicResolution_Reset(struct APP_DynamicResolution *dynres);
+
+void APP_DynamicResolution_GetSize(
+        float scale,
+        Uint32 width,
+        Uint32 height,
+        Uint32 *out_width,
+        Uint32 *out_height
+);
+
+#endif
@@ -0,0 +1,497 @@
+#include "gpumemory.h"
+
+#define GPU_MEMORY_MB (1024.0 * 1024.0)
+
+struct APP_GPUMemory {
+    SDL_GPUDevice *device;
+    // Resources are created and released from the startup tasks too.
+    SDL_Mutex *lock;
+
+    // Note(john): Unordered, a release searches linearly. There are a few
+    // dozen live resources, the lookup never shows up next to the driver
+    // call it sits next to.
+    struct APP_GPUAllocation *allocations;
+    Uint32 allocation_count;
+    Uint32 allocation_capacity;
+
+    struct APP_GPUMemoryStats stats;
+    // Churn of the frame in flight, moved to the stats by EndFrame.
+    Uint32 frame_allocations;
+    Uint32 frame_releases;
+    Uint64 frame_allocated_bytes;
+
+    APP_GPUBudgetFn on_over_budget;
+    void *budget_user_data;
+};
+
+static const char *const GPU_MEMORY_CATEGORY_NAMES[APP_GPU_MEMORY_CATEGORY_COUNT] = {
+    "geometry",
+    "storage",
+    "indirect",
+    "texture",
+    "render target",
+    "upload",
+    "download",
+};
+
+const char*
+APP_GPUMemory_CategoryName(enum APP_GPUMemoryCategory category)
+{
+    return category < APP_GPU_MEMORY_CATEGORY_COUNT ? GPU_MEMORY_CATEGORY_NAMES[category] : "unknown";
+}
+
+struct APP_GPUMemory*
+APP_GPUMemory_Create(SDL_GPUDevice *device)
+{
+    struct APP_GPUMemory *memory = SDL_calloc(1, sizeof(struct APP_GPUMemory));
+    if (memory == NULL)
+    {
+        return NULL;
+    }
+
+    memory->device = device;
+    memory->lock = SDL_CreateMutex();
+    if (memory->lock == NULL)
+    {
+        SDL_free(memory);
+        return NULL;
+    }
+
+    return memory;
+}
+
+// Doesn't release what is still alive, log the report first to find it.
+void
+APP_GPUMemory_Destroy(struct APP_GPUMemory *memory)
+{
+    if (memory == NULL)
+    {
+        return;
+    }
+
+    SDL_DestroyMutex(memory->lock);
+    SDL_free(memory->allocations);
+    SDL_free(memory);
+}
+
+void
+APP_GPUMemory_SetBudget(
+        struct APP_GPUMemory *memory,
+        Uint64 budget_bytes,
+        APP_GPUBudgetFn on_over_budget,
+        void *user_data
+)
+{
+    SDL_LockMutex(memory->lock);
+    memory->stats.budget_bytes = budget_bytes;
+    memory->on_over_budget = on_over_budget;
+    memory->budget_user_data = user_data;
+    SDL_UnlockMutex(memory->lock);
+}
+
+static void
+APP_GPUMemoryFillRequest(
+        struct APP_GPUMemory *memory,
+        struct APP_GPUAllocation *request,
+        enum APP_GPUMemoryCategory category,
+        Uint64 size,
+        const char *name
+)
+{
+    SDL_zerop(request);
+    SDL_strlcpy(request->name, name, sizeof(request->name));
+    request->category = category;
+    request->size = size;
+    request->frame = memory->stats.frame;
+}
+
+// Ask the budget whether the request may be created. Without a callback an
+// allocation over the budget is refused.
+static bool
+APP_GPUMemoryCheckBudget(struct APP_GPUMemory *memory, const struct APP_GPUAllocation *request)
+{
+    SDL_LockMutex(memory->lock);
+
+    struct APP_GPUMemoryStats stats = memory->stats;
+    APP_GPUBudgetFn on_over_budget = memory->on_over_budget;
+    void *user_data = memory->budget_user_data;
+
+    SDL_UnlockMutex(memory->lock);
+
+    if (stats.budget_bytes == 0 || stats.live_bytes + request->size <= stats.budget_bytes)
+    {
+        return true;
+    }
+
+    // Note(john): The callback runs without the lock, so it can release
+    // resources to make room before it lets the request through.
+    bool allowed = on_over_budget != NULL && on_over_budget(request, &stats, user_data);
+
+    if (!allowed)
+    {
+        SDL_LockMutex(memory->lock);
+        memory->stats.refused_count++;
+        SDL_UnlockMutex(memory->lock);
+
+        SDL_SetError(
+                "GPU memory budget exceeded by '%s' (%.2f MB live, %.2f MB requested, %.2f MB budget)",
+                request->name,
+                (double)stats.live_bytes / GPU_MEMORY_MB,
+                (double)request->size / GPU_MEMORY_MB,
+                (double)stats.budget_bytes / GPU_MEMORY_MB
+        );
+    }
+
+    return allowed;
+}
+
+static void
+APP_GPUMemoryTrack(struct APP_GPUMemory *memory, const struct APP_GPUAllocation *request, void *resource)
+{
+    SDL_LockMutex(memory->lock);
+
+    if (memory->allocation_count == memory->allocation_capacity)
+    {
+        Uint32 capacity = SDL_max(memory->allocation_capacity * 2, 64);
+        struct APP_GPUAllocation *allocations = SDL_realloc(
+                memory->allocations, 
+                sizeof(struct APP_GPUAllocation) * capacity
+        );
+
+        // Note(john): The resource still works, it is only missing from the
+        // totals.
+        if (allocations == NULL)
+        {
+            SDL_UnlockMutex(memory->lock);
+            SDL_Log("ERROR: Failed to track GPU allocation '%s'.", request->name);
+            return;
+        }
+
+        memory->allocations = allocations;
+        memory->allocation_capacity = capacity;
+    }
+
+    struct APP_GPUAllocation *allocation = &memory->allocations[memory->allocation_count++];
+    *allocation = *request;
+    allocation->resource = resource;
+
+    struct APP_GPUMemoryStats *stats = &memory->stats;
+    stats->live_bytes += request->size;
+    stats->live_count++;
+    stats->high_water_bytes = SDL_max(stats->high_water_bytes, stats->live_bytes);
+    stats->category_bytes[request->category] += request->size;
+    stats->category_high_water[request->category] = SDL_max(
+            stats->category_high_water[request->category],
+            stats->category_bytes[request->category]
+    );
+    stats->total_allocations++;
+
+    memory->frame_allocations++;
+    memory->frame_allocated_bytes += request->size;
+
+    SDL_UnlockMutex(memory->lock);
+}
+
+static void
+APP_GPUMemoryUntrack(struct APP_GPUMemory *memory, void *resource)
+{
+    SDL_LockMutex(memory->lock);
+
+    for (Uint32 i = 0; i < memory->allocation_count; ++i)
+    {
+        struct APP_GPUAllocation *allocation = &memory->allocations[i];
+        if (allocation->resource != resource)
+        {
+            continue;
+        }
+
+        memory->stats.live_bytes -= allocation->size;
+        memory->stats.live_count--;
+        memory->stats.category_bytes[allocation->category] -= allocation->size;
+        memory->frame_releases++;
+
+        *allocation = memory->allocations[--memory->allocation_count];
+        break;
+    }
+
+    SDL_UnlockMutex(memory->lock);
+}
+
+static enum APP_GPUMemoryCategory
+APP_GPUMemoryBufferCategory(SDL_GPUBufferUsageFlags usage)
+{
+    if (usage & SDL_GPU_BUFFERUSAGE_INDIRECT)
+    {
+        return APP_GPU_MEMORY_INDIRECT;
+    }
+
+    if (usage & (SDL_GPU_BUFFERUSAGE_VERTEX | SDL_GPU_BUFFERUSAGE_INDEX))
+    {
+        return APP_GPU_MEMORY_GEOMETRY;
+    }
+
+    return APP_GPU_MEMORY_STORAGE;
+}
+
+static Uint64
+APP_GPUMemoryTextureSize(const SDL_GPUTextureCreateInfo *create_info)
+{
+    bool volume = create_info->type == SDL_GPU_TEXTURETYPE_3D;
+    Uint64 size = 0;
+
+    for (Uint32 level = 0; level < SDL_max(create_info->num_levels, 1); ++level)
+    {
+        Uint32 width = SDL_max(create_info->width >> level, 1);
+        Uint32 height = SDL_max(create_info->height >> level, 1);
+        Uint32 depth = volume 
+            ? SDL_max(create_info->layer_count_or_depth >> level, 1) 
+            : SDL_max(create_info->layer_count_or_depth, 1);
+
+        size += SDL_CalculateGPUTextureFormatSize(create_info->format, width, height, depth);
+    }
+
+    // SDL_GPU_SAMPLECOUNT_1 is 0, every step doubles the samples.
+    return size << create_info->sample_count;
+}
+
+SDL_GPUBuffer*
+APP_GPUMemory_CreateBuffer(
+        struct APP_GPUMemory *memory,
+        const SDL_GPUBufferCreateInfo *create_info,
+        const char *name
+)
+{
+    struct APP_GPUAllocation request;
+    APP_GPUMemoryFillRequest(
+            memory, 
+            &request, 
+            APP_GPUMemoryBufferCategory(create_info->usage), 
+            create_info->size, 
+            name
+    );
+
+    if (!APP_GPUMemoryCheckBudget(memory, &request))
+    {
+        return NULL;
+    }
+
+    SDL_GPUBuffer *buffer = SDL_CreateGPUBuffer(memory->device, create_info);
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+
+    SDL_SetGPUBufferName(memory->device, buffer, name);
+    APP_GPUMemoryTrack(memory, &request, buffer);
+
+    return buffer;
+}
+
+SDL_GPUTexture*
+APP_GPUMemory_CreateTexture(
+        struct APP_GPUMemory *memory,
+        const SDL_GPUTextureCreateInfo *create_info,
+        const char *name
+)
+{
+    enum APP_GPUMemoryCategory category = 
+        (create_info->usage & (SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET)) 
+            ? APP_GPU_MEMORY_RENDER_TARGET 
+            : APP_GPU_MEMORY_TEXTURE;
+
+    struct APP_GPUAllocation request;
+    APP_GPUMemoryFillRequest(memory, &request, category, APP_GPUMemoryTextureSize(create_info), name);
+
+    if (!APP_GPUMemoryCheckBudget(memory, &request))
+    {
+        return NULL;
+    }
+
+    SDL_GPUTexture *texture = SDL_CreateGPUTexture(memory->device, create_info);
+    if (texture == NULL)
+    {
+        return NULL;
+    }
+
+    SDL_SetGPUTextureName(memory->device, texture, name);
+    APP_GPUMemoryTrack(memory, &request, texture);
+
+    return texture;
+}
+
+// Transfer buffers can't be named in SDL, the name only lives here.
+SDL_GPUTransferBuffer*
+APP_GPUMemory_CreateTransferBuffer(
+        struct APP_GPUMemory *memory,
+        const SDL_GPUTransferBufferCreateInfo *create_info,
+        const char *name
+)
+{
+    enum APP_GPUMemoryCategory category = create_info->usage == SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD 
+        ? APP_GPU_MEMORY_DOWNLOAD 
+        : APP_GPU_MEMORY_UPLOAD;
+
+    struct APP_GPUAllocation request;
+    APP_GPUMemoryFillRequest(memory, &request, category, create_info->size, name);
+
+    if (!APP_GPUMemoryCheckBudget(memory, &request))
+    {
+        return NULL;
+    }
+
+    SDL_GPUTransferBuffer *transfer_buffer = SDL_CreateGPUTransferBuffer(memory->device, create_info);
+    if (transfer_buffer == NULL)
+    {
+        return NULL;
+    }
+
+    APP_GPUMemoryTrack(memory, &request, transfer_buffer);
+
+    return transfer_buffer;
+}
+
+// The release functions take NULL like the SDL ones.
+void
+APP_GPUMemory_ReleaseBuffer(struct APP_GPUMemory *memory, SDL_GPUBuffer *buffer)
+{
+    if (buffer == NULL)
+    {
+        return;
+    }
+
+    APP_GPUMemoryUntrack(memory, buffer);
+    SDL_ReleaseGPUBuffer(memory->device, buffer);
+}
+
+void
+APP_GPUMemory_ReleaseTexture(struct APP_GPUMemory *memory, SDL_GPUTexture *texture)
+{
+    if (texture == NULL)
+    {
+        return;
+    }
+
+    APP_GPUMemoryUntrack(memory, texture);
+    SDL_ReleaseGPUTexture(memory->device, texture);
+}
+
+void
+APP_GPUMemory_ReleaseTransferBuffer(struct APP_GPUMemory *memory, SDL_GPUTransferBuffer *transfer_buffer)
+{
+    if (transfer_buffer == NULL)
+    {
+        return;
+    }
+
+    APP_GPUMemoryUntrack(memory, transfer_buffer);
+    SDL_ReleaseGPUTransferBuffer(memory->device, transfer_buffer);
+}
+
+// Close the churn counters of the frame. A steady frame allocates nothing,
+// anything else is a resize, a growing buffer or a per frame upload that
+// should come from a ring instead.
+void
+APP_GPUMemory_EndFrame(struct APP_GPUMemory *memory)
+{
+    SDL_LockMutex(memory->lock);
+
+    struct APP_GPUMemoryStats *stats = &memory->stats;
+    stats->frame_allocations = memory->frame_allocations;
+    stats->frame_releases = memory->frame_releases;
+    stats->frame_allocated_bytes = memory->frame_allocated_bytes;
+    stats->peak_frame_allocations = SDL_max(stats->peak_frame_allocations, memory->frame_allocations);
+    stats->frame++;
+
+    memory->frame_allocations = 0;
+    memory->frame_releases = 0;
+    memory->frame_allocated_bytes = 0;
+
+    SDL_UnlockMutex(memory->lock);
+}
+
+void
+APP_GPUMemory_GetStats(struct APP_GPUMemory *memory, struct APP_GPUMemoryStats *out_stats)
+{
+    SDL_LockMutex(memory->lock);
+    *out_stats = memory->stats;
+    SDL_UnlockMutex(memory->lock);
+}
+
+static int
+APP_CompareGPUAllocations(const void *a, const void *b)
+{
+    const struct APP_GPUAllocation *allocation_a = a;
+    const struct APP_GPUAllocation *allocation_b = b;
+
+    if (allocation_a->size != allocation_b->size)
+    {
+        return allocation_a->size > allocation_b->size ? -1 : 1;
+    }
+
+    return SDL_strcmp(allocation_a->name, allocation_b->name);
+}
+
+// Log the totals per category and every live allocation, largest first.
+// Logged at shutdown after everything was released, whatever is still
+// listed leaked.
+void
+APP_GPUMemory_LogReport(struct APP_GPUMemory *memory)
+{
+    SDL_LockMutex(memory->lock);
+
+    const struct APP_GPUMemoryStats *stats = &memory->stats;
+
+    char budget[32] = "none";
+    if (stats->budget_bytes > 0)
+    {
+        SDL_snprintf(budget, sizeof(budget), "%.2f MB", (double)stats->budget_bytes / GPU_MEMORY_MB);
+    }
+
+    SDL_Log(
+            "INFO: [gpu memory] %.2f MB live in %u allocations, high water %.2f MB, budget %s",
+            (double)stats->live_bytes / GPU_MEMORY_MB,
+            stats->live_count,
+            (double)stats->high_water_bytes / GPU_MEMORY_MB,
+            budget
+    );
+
+    for (Uint32 i = 0; i < APP_GPU_MEMORY_CATEGORY_COUNT; ++i)
+    {
+        SDL_Log(
+                "INFO: [gpu memory] %-14s %9.2f MB live %9.2f MB high water",
+                GPU_MEMORY_CATEGORY_NAMES[i],
+                (double)stats->category_bytes[i] / GPU_MEMORY_MB,
+                (double)stats->category_high_water[i] / GPU_MEMORY_MB
+        );
+    }
+
+    SDL_Log(
+            "INFO: [gpu memory] %llu allocations over %llu frames, at most %u in one frame, %u refused by the budget",
+            (unsigned long long)stats->total_allocations,
+            (unsigned long long)stats->frame,
+            stats->peak_frame_allocations,
+            stats->refused_count
+    );
+
+    SDL_qsort(
+            memory->allocations, 
+            memory->allocation_count, 
+            sizeof(struct APP_GPUAllocation), 
+            APP_CompareGPUAllocations
+    );
+
+    for (Uint32 i = 0; i < memory->allocation_count; ++i)
+    {
+        const struct APP_GPUAllocation *allocation = &memory->allocations[i];
+
+        SDL_Log(
+                "INFO: [gpu memory] live %-28s %-14s %10llu bytes, created in frame %llu",
+                allocation->name,
+                GPU_MEMORY_CATEGORY_NAMES[allocation->category],
+                (unsigned long long)allocation->size,
+                (unsigned long long)allocation->frame
+        );
+    }
+
+    SDL_UnlockMutex(memory->lock);
+}
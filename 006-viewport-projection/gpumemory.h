@@ -0,0 +1,107 @@
+#ifndef GPUMEMORY_H
+#define GPUMEMORY_H
+
+#include <SDL3/SDL.h>
+
+// Registry of every buffer, texture and transfer buffer created through it.
+// Keeps the size, category and name of each one, the live totals, the high
+// water mark and the allocations per frame, and enforces a budget.
+
+#define APP_GPU_MEMORY_NAME_LENGTH 32
+
+// Taken from the usage flags.
+enum APP_GPUMemoryCategory {
+    // Vertex and index buffers.
+    APP_GPU_MEMORY_GEOMETRY,
+    APP_GPU_MEMORY_STORAGE,
+    // Indirect argument buffers, also when they are written by a compute
+    // shader.
+    APP_GPU_MEMORY_INDIRECT,
+    APP_GPU_MEMORY_TEXTURE,
+    // Color and depth targets.
+    APP_GPU_MEMORY_RENDER_TARGET,
+    APP_GPU_MEMORY_UPLOAD,
+    APP_GPU_MEMORY_DOWNLOAD,
+    APP_GPU_MEMORY_CATEGORY_COUNT
+};
+
+struct APP_GPUAllocation {
+    void *resource;
+    char name[APP_GPU_MEMORY_NAME_LENGTH];
+    enum APP_GPUMemoryCategory category;
+    // Bytes the resource needs at least. The driver may round up, and a
+    // cycled resource can have more than one backing allocation.
+    Uint64 size;
+    // Frame the resource was created in.
+    Uint64 frame;
+};
+
+struct APP_GPUMemoryStats {
+    Uint64 live_bytes;
+    Uint32 live_count;
+    Uint64 high_water_bytes;
+    Uint64 category_bytes[APP_GPU_MEMORY_CATEGORY_COUNT];
+    Uint64 category_high_water[APP_GPU_MEMORY_CATEGORY_COUNT];
+
+    // 0 means no budget.
+    Uint64 budget_bytes;
+    Uint32 refused_count;
+
+    // Churn of the last finished frame.
+    Uint32 frame_allocations;
+    Uint32 frame_releases;
+    Uint64 frame_allocated_bytes;
+    // Most allocations a single frame made so far.
+    Uint32 peak_frame_allocations;
+
+    Uint64 total_allocations;
+    Uint64 frame;
+};
+
+struct APP_GPUMemory;
+
+// Called before an allocation that would exceed the budget. Return true to
+// let it through anyway, false refuses it and the create call fails.
+typedef bool (*APP_GPUBudgetFn)(
+        const struct APP_GPUAllocation *request,
+        const struct APP_GPUMemoryStats *stats,
+        void *user_data
+);
+
+struct APP_GPUMemory *APP_GPUMemory_Create(SDL_GPUDevice *device);
+void APP_GPUMemory_Destroy(struct APP_GPUMemory *memory);
+
+void APP_GPUMemory_SetBudget(
+        struct APP_GPUMemory *memory,
+        Uint64 budget_bytes,
+        APP_GPUBudgetFn on_over_budget,
+        void *user_data
+);
+
+SDL_GPUBuffer *APP_GPUMemory_CreateBuffer(
+        struct APP_GPUMemory *memory,
+        const SDL_GPUBufferCreateInfo *create_info,
+        const char *name
+);
+SDL_GPUTexture *APP_GPUMemory_CreateTexture(
+        struct APP_GPUMemory *memory,
+        const SDL_GPUTextureCreateInfo *create_info,
+        const char *name
+);
+SDL_GPUTransferBuffer *APP_GPUMemory_CreateTransferBuffer(
+        struct APP_GPUMemory *memory,
+        const SDL_GPUTransferBufferCreateInfo *create_info,
+        const char *name
+);
+
+void APP_GPUMemory_ReleaseBuffer(struct APP_GPUMemory *memory, SDL_GPUBuffer *buffer);
+void APP_GPUMemory_ReleaseTexture(struct APP_GPUMemory *memory, SDL_GPUTexture *texture);
+void APP_GPUMemory_ReleaseTransferBuffer(struct APP_GPUMemory *memory, SDL_GPUTransferBuffer *transfer_buffer);
+
+void APP_GPUMemory_EndFrame(struct APP_GPUMemory *memory);
+void APP_GPUMemory_GetStats(struct APP_GPUMemory *memory, struct APP_GPUMemoryStats *out_stats);
+
+const char *APP_GPUMemory_CategoryName(enum APP_GPUMemoryCategory category);
+void APP_GPUMemory_LogReport(struct APP_GPUMemory *memory);
+
+#endif
@@ -0,0 +1,232 @@
+#include "hiz.h"
+#include "app.h"
+#include "gpumemory.h"
+#include "math.h"
+#include "utils.h"
+
+// Uniform block of HiZBuild.comp.hlsl.
+struct APP_HiZBuildParams {
+    Uint32 source_size[2];
+    Uint32 destination_size[2];
+    Uint32 source_offset;
+    Uint32 destination_offset;
+    // Level 0 reads the depth texture, every other level the level above.
+    Uint32 from_depth;
+    Uint32 padding;
+};
+
+struct APP_DepthPyramid*
+APP_DepthPyramid_Create(struct APP_Context *ctx)
+{
+    struct APP_DepthPyramid *pyramid = SDL_calloc(1, sizeof(struct APP_DepthPyramid));
+    if (pyramid == NULL)
+    {
+        return NULL;
+    }
+
+    pyramid->sampler = SDL_CreateGPUSampler(
+            ctx->device,
+            &(SDL_GPUSamplerCreateInfo){
+                .min_filter = SDL_GPU_FILTER_NEAREST,
+                .mag_filter = SDL_GPU_FILTER_NEAREST,
+                .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+                .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+                .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+                .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+            }
+    );
+
+    if (pyramid->sampler == NULL)
+    {
+        SDL_Log("ERROR: Failed to create depth pyramid sampler. %s", SDL_GetError());
+        APP_DepthPyramid_Destroy(ctx, pyramid);
+        return NULL;
+    }
+
+    // Note(john): The cull pass binds the buffer even with occlusion culling
+    // turned off, so there always is one until the first real resize.
+    if (APP_DepthPyramid_Resize(ctx, pyramid, 1, 1) == -1)
+    {
+        APP_DepthPyramid_Destroy(ctx, pyramid);
+        return NULL;
+    }
+
+    return pyramid;
+}
+
+// The pipeline is created apart from the pyramid, the startup creates it on
+// the pipeline task.
+int
+APP_DepthPyramid_CreatePipeline(struct APP_Context *ctx, struct APP_DepthPyramid *pyramid)
+{
+    pyramid->pipeline = APP_LoadComputePipeline(
+            ctx,
+            "HiZBuild.comp",
+            &(SDL_GPUComputePipelineCreateInfo){
+                .num_samplers = 1,
+                .num_readwrite_storage_buffers = 1,
+                .num_uniform_buffers = 1,
+                .threadcount_x = APP_HIZ_THREADCOUNT,
+                .threadcount_y = APP_HIZ_THREADCOUNT,
+                .threadcount_z = 1,
+            }
+    );
+
+    if (pyramid->pipeline == NULL)
+    {
+        SDL_Log("ERROR: Failed to create depth pyramid pipeline.");
+        return -1;
+    }
+
+    return 0;
+}
+
+void
+APP_DepthPyramid_Destroy(struct APP_Context *ctx, struct APP_DepthPyramid *pyramid)
+{
+    if (pyramid == NULL)
+    {
+        return;
+    }
+
+    SDL_ReleaseGPUComputePipeline(ctx->device, pyramid->pipeline);
+    SDL_ReleaseGPUSampler(ctx->device, pyramid->sampler);
+    APP_GPUMemory_ReleaseBuffer(ctx->gpu_memory, pyramid->buffer);
+    SDL_free(pyramid);
+}
+
+// Lay out the levels for a depth buffer of the given size and grow the
+// storage buffer if it is too small. The pyramid is invalid until the next
+// build. On failure the old buffer is kept.
+int
+APP_DepthPyramid_Resize(
+        struct APP_Context *ctx,
+        struct APP_DepthPyramid *pyramid,
+        Uint32 depth_width,
+        Uint32 depth_height
+)
+{
+    if (pyramid->buffer != NULL && pyramid->depth_width == depth_width && pyramid->depth_height == depth_height)
+    {
+        return 0;
+    }
+
+    struct APP_DepthPyramid layout = { 0 };
+    Uint32 width = SDL_max(depth_width / 2, 1);
+    Uint32 height = SDL_max(depth_height / 2, 1);
+    Uint32 size = 0;
+
+    while (layout.level_count < APP_HIZ_MAX_LEVELS)
+    {
+        layout.level_widths[layout.level_count] = width;
+        layout.level_heights[layout.level_count] = height;
+        layout.level_offsets[layout.level_count] = size;
+        layout.level_count++;
+
+        size += width * height;
+
+        if (width == 1 && height == 1)
+        {
+            break;
+        }
+
+        width = SDL_max(width / 2, 1);
+        height = SDL_max(height / 2, 1);
+    }
+
+    if (pyramid->buffer == NULL || size > pyramid->capacity)
+    {
+        SDL_GPUBuffer *buffer = APP_GPUMemory_CreateBuffer(
+                ctx->gpu_memory,
+                &(SDL_GPUBufferCreateInfo){
+                    .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+                    .size = size * sizeof(float)
+                },
+                "Depth Pyramid"
+        );
+
+        if (buffer == NULL)
+        {
+            SDL_Log("ERROR: Failed to create depth pyramid buffer. %s", SDL_GetError());
+            return -1;
+        }
+
+        APP_GPUMemory_ReleaseBuffer(ctx->gpu_memory, pyramid->buffer);
+
+        pyramid->buffer = buffer;
+        pyramid->capacity = size;
+    }
+
+    pyramid->depth_width = depth_width;
+    pyramid->depth_height = depth_height;
+    pyramid->level_count = layout.level_count;
+    SDL_memcpy(pyramid->level_widths, layout.level_widths, sizeof(layout.level_widths));
+    SDL_memcpy(pyramid->level_heights, layout.level_heights, sizeof(layout.level_heights));
+    SDL_memcpy(pyramid->level_offsets, layout.level_offsets, sizeof(layout.level_offsets));
+    pyramid->valid = false;
+
+    return 0;
+}
+
+// Reduce the depth texture into the pyramid, every texel keeps the farthest
+// depth of the texels below it. One compute pass per level, so every level
+// sees the finished one above.
+void
+APP_DepthPyramid_Build(
+        struct APP_Context *ctx,
+        struct APP_DepthPyramid *pyramid,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        SDL_GPUTexture *depth_texture,
+        const struct APP_Matrix4x4 *view_proj
+)
+{
+    for (Uint32 level = 0; level < pyramid->level_count; ++level)
+    {
+        struct APP_HiZBuildParams params = {
+            .destination_size = { pyramid->level_widths[level], pyramid->level_heights[level] },
+            .destination_offset = pyramid->level_offsets[level],
+        };
+
+        if (level == 0)
+        {
+            params.source_size[0] = pyramid->depth_width;
+            params.source_size[1] = pyramid->depth_height;
+            params.from_depth = 1;
+        }
+        else
+        {
+            params.source_size[0] = pyramid->level_widths[level - 1];
+            params.source_size[1] = pyramid->level_heights[level - 1];
+            params.source_offset = pyramid->level_offsets[level - 1];
+        }
+
+        SDL_GPUComputePass *compute_pass = SDL_BeginGPUComputePass(
+                cmd_buffer,
+                NULL,
+                0,
+                &(SDL_GPUStorageBufferReadWriteBinding){ .buffer = pyramid->buffer, .cycle = false },
+                1
+        );
+
+        SDL_BindGPUComputePipeline(compute_pass, pyramid->pipeline);
+        SDL_BindGPUComputeSamplers(
+                compute_pass,
+                0,
+                &(SDL_GPUTextureSamplerBinding){ .texture = depth_texture, .sampler = pyramid->sampler },
+                1
+        );
+        SDL_PushGPUComputeUniformData(cmd_buffer, 0, &params, sizeof(params));
+
+        SDL_DispatchGPUCompute(
+                compute_pass,
+                (params.destination_size[0] + APP_HIZ_THREADCOUNT - 1) / APP_HIZ_THREADCOUNT,
+                (params.destination_size[1] + APP_HIZ_THREADCOUNT - 1) / APP_HIZ_THREADCOUNT,
+                1
+        );
+
+        SDL_EndGPUComputePass(compute_pass);
+    }
+
+    pyramid->view_proj = *view_proj;
+    pyramid->valid = true;
+}
@@ -0,0 +1,57 @@
+#ifndef HIZ_H
+#define HIZ_H
+
+#include "app.h"
+#include "math.h"
+
+// Enough for a 8192x8192 depth buffer, the first level is half its size.
+#define APP_HIZ_MAX_LEVELS 12
+
+// Matches the threadcount of HiZBuild.comp.hlsl.
+#define APP_HIZ_THREADCOUNT 8
+
+// Max depth pyramid of the last frame. All levels live in one storage buffer
+// of floats, row after row and level after level.
+struct APP_DepthPyramid {
+    SDL_GPUComputePipeline *pipeline;
+    SDL_GPUSampler *sampler;
+    SDL_GPUBuffer *buffer;
+    // Floats the buffer can hold. A smaller depth buffer, e.g. a lower
+    // dynamic resolution, reuses it.
+    Uint32 capacity;
+
+    // Size of the depth buffer the pyramid is built from.
+    Uint32 depth_width, depth_height;
+
+    Uint32 level_count;
+    Uint32 level_widths[APP_HIZ_MAX_LEVELS];
+    Uint32 level_heights[APP_HIZ_MAX_LEVELS];
+    // In floats.
+    Uint32 level_offsets[APP_HIZ_MAX_LEVELS];
+
+    // The pyramid holds the depth of a frame rendered with view_proj. Only
+    // valid once it has been built for the current size.
+    bool valid;
+    struct APP_Matrix4x4 view_proj;
+};
+
+struct APP_DepthPyramid *APP_DepthPyramid_Create(struct APP_Context *ctx);
+int APP_DepthPyramid_CreatePipeline(struct APP_Context *ctx, struct APP_DepthPyramid *pyramid);
+void APP_DepthPyramid_Destroy(struct APP_Context *ctx, struct APP_DepthPyramid *pyramid);
+
+int APP_DepthPyramid_Resize(
+        struct APP_Context *ctx,
+        struct APP_DepthPyramid *pyramid,
+        Uint32 depth_width,
+        Uint32 depth_height
+);
+
+void APP_DepthPyramid_Build(
+        struct APP_Context *ctx,
+        struct APP_DepthPyramid *pyramid,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        SDL_GPUTexture *depth_texture,
+        const struct APP_Matrix4x4 *view_proj
+);
+
+#endif
@@ -0,0 +1,542 @@
+#include "lod.h"
+#include "app.h"
+#include "math.h"
+
+// Symmetric 4x4 matrix of the plane quadric (Garland & Heckbert).
+struct APP_Quadric {
+    double a2, ab, ac, ad;
+    double b2, bc, bd;
+    double c2, cd;
+    double d2;
+    // Accumulated triangle area, used to turn the error into a distance.
+    double weight;
+};
+
+struct APP_Collapse {
+    Uint32 from;
+    Uint32 to;
+    double cost;
+};
+
+static void
+APP_Quadric_AddPlane(struct APP_Quadric *q, double a, double b, double c, double d, double weight)
+{
+    q->a2 += a * a * weight;
+    q->ab += a * b * weight;
+    q->ac += a * c * weight;
+    q->ad += a * d * weight;
+    q->b2 += b * b * weight;
+    q->bc += b * c * weight;
+    q->bd += b * d * weight;
+    q->c2 += c * c * weight;
+    q->cd += c * d * weight;
+    q->d2 += d * d * weight;
+    q->weight += weight;
+}
+
+static void
+APP_Quadric_Add(struct APP_Quadric *q, const struct APP_Quadric *other)
+{
+    q->a2 += other->a2;
+    q->ab += other->ab;
+    q->ac += other->ac;
+    q->ad += other->ad;
+    q->b2 += other->b2;
+    q->bc += other->bc;
+    q->bd += other->bd;
+    q->c2 += other->c2;
+    q->cd += other->cd;
+    q->d2 += other->d2;
+    q->weight += other->weight;
+}
+
+static double
+APP_Quadric_Error(const struct APP_Quadric *q, const struct APP_PositionColorVertex *v)
+{
+    double x = v->x, y = v->y, z = v->z;
+
+    double error = 
+        (q->a2 * x * x) + (2 * q->ab * x * y) + (2 * q->ac * x * z) + (2 * q->ad * x) +
+        (q->b2 * y * y) + (2 * q->bc * y * z) + (2 * q->bd * y) +
+        (q->c2 * z * z) + (2 * q->cd * z) +
+        q->d2;
+
+    if (error <= 0 || q->weight <= 0)
+    {
+        return 0;
+    }
+
+    // Note(john): Area weighted mean of the squared plane distances.
+    return error / q->weight;
+}
+
+static struct APP_Vector3
+APP_TriangleNormal(
+        const struct APP_PositionColorVertex *v0,
+        const struct APP_PositionColorVertex *v1,
+        const struct APP_PositionColorVertex *v2
+)
+{
+    struct APP_Vector3 e0 = { v1->x - v0->x, v1->y - v0->y, v1->z - v0->z };
+    struct APP_Vector3 e1 = { v2->x - v0->x, v2->y - v0->y, v2->z - v0->z };
+    return APP_Vector3_Cross(e0, e1);
+}
+
+static int
+APP_CompareCollapse(const void *a, const void *b)
+{
+    const struct APP_Collapse *ca = a;
+    const struct APP_Collapse *cb = b;
+    return (ca->cost > cb->cost) - (ca->cost < cb->cost);
+}
+
+// Build the vertex to triangle adjacency of the current index list.
+static void
+APP_BuildAdjacency(
+        const Uint16 *indices,
+        Uint32 index_count,
+        Uint32 vertex_count,
+        Uint32 *offsets,
+        Uint32 *counts,
+        Uint32 *triangles
+)
+{
+    SDL_memset(counts, 0, sizeof(Uint32) * vertex_count);
+
+    for (Uint32 i = 0; i < index_count; ++i)
+    {
+        counts[indices[i]]++;
+    }
+
+    Uint32 offset = 0;
+    for (Uint32 v = 0; v < vertex_count; ++v)
+    {
+        offsets[v] = offset;
+        offset += counts[v];
+        counts[v] = 0;
+    }
+
+    for (Uint32 i = 0; i < index_count; ++i)
+    {
+        Uint32 v = indices[i];
+        triangles[offsets[v] + counts[v]++] = i / 3;
+    }
+}
+
+// Collapsing from onto to must not flip any of the remaining triangles
+// around from.
+static bool
+APP_CollapseFlipsTriangle(
+        const struct APP_PositionColorVertex *vertices,
+        const Uint16 *indices,
+        const Uint32 *offsets,
+        const Uint32 *counts,
+        const Uint32 *triangles,
+        Uint32 from,
+        Uint32 to
+)
+{
+    for (Uint32 i = 0; i < counts[from]; ++i)
+    {
+        const Uint16 *tri = &indices[triangles[offsets[from] + i] * 3];
+
+        if (tri[0] == to || tri[1] == to || tri[2] == to)
+        {
+            continue;
+        }
+
+        const struct APP_PositionColorVertex *v[3];
+        const struct APP_PositionColorVertex *moved[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            v[k] = &vertices[tri[k]];
+            moved[k] = tri[k] == from ? &vertices[to] : v[k];
+        }
+
+        struct APP_Vector3 before = APP_TriangleNormal(v[0], v[1], v[2]);
+        struct APP_Vector3 after = APP_TriangleNormal(moved[0], moved[1], moved[2]);
+
+        float before_length = SDL_sqrtf(APP_Vector3_Dot(before, before));
+        float after_length = SDL_sqrtf(APP_Vector3_Dot(after, after));
+
+        // Note(john): Also reject collapses that leave a sliver behind.
+        if (APP_Vector3_Dot(before, after) < 0.25f * before_length * after_length)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// A vertex is locked when one of its edges is only used by a single
+// triangle. Open borders and attribute seams keep their silhouette that way.
+static void
+APP_FindBorderVertices(
+        const Uint16 *indices,
+        Uint32 index_count,
+        const Uint32 *offsets,
+        const Uint32 *counts,
+        const Uint32 *triangles,
+        bool *locked
+)
+{
+    for (Uint32 i = 0; i < index_count; ++i)
+    {
+        Uint32 a = indices[i];
+        Uint32 b = indices[(i % 3 == 2) ? i - 2 : i + 1];
+
+        bool has_opposite = false;
+        for (Uint32 t = 0; t < counts[b] && !has_opposite; ++t)
+        {
+            const Uint16 *tri = &indices[triangles[offsets[b] + t] * 3];
+            for (int k = 0; k < 3; ++k)
+            {
+                if (tri[k] == b && tri[(k + 1) % 3] == a)
+                {
+                    has_opposite = true;
+                    break;
+                }
+            }
+        }
+
+        if (!has_opposite)
+        {
+            locked[a] = true;
+            locked[b] = true;
+        }
+    }
+}
+
+static void
+APP_FreeSimplifyScratch(
+        struct APP_Quadric *quadrics,
+        Uint32 *offsets,
+        Uint32 *counts,
+        Uint32 *triangles,
+        bool *locked,
+        bool *touched,
+        Uint32 *remap,
+        struct APP_Collapse *collapses
+)
+{
+    SDL_free(quadrics);
+    SDL_free(offsets);
+    SDL_free(counts);
+    SDL_free(triangles);
+    SDL_free(locked);
+    SDL_free(touched);
+    SDL_free(remap);
+    SDL_free(collapses);
+}
+
+// Simplify the triangle list by collapsing edges onto one of their existing
+// vertices, so the result indexes the same vertex buffer as the input.
+// Collapses are ordered by quadric error and stop at target_index_count or
+// once the next collapse would exceed max_error. Returns -1 when the scratch
+// memory can't be allocated.
+int
+APP_SimplifyMesh(
+        const struct APP_PositionColorVertex *vertices,
+        Uint32 vertex_count,
+        const Uint16 *indices,
+        Uint32 index_count,
+        Uint32 target_index_count,
+        float max_error,
+        Uint16 *out_indices,
+        Uint32 *out_index_count,
+        float *out_error
+)
+{
+    struct APP_Quadric *quadrics = SDL_calloc(vertex_count, sizeof(struct APP_Quadric));
+    Uint32 *offsets = SDL_malloc(sizeof(Uint32) * vertex_count);
+    Uint32 *counts = SDL_malloc(sizeof(Uint32) * vertex_count);
+    Uint32 *triangles = SDL_malloc(sizeof(Uint32) * index_count);
+    bool *locked = SDL_calloc(vertex_count, sizeof(bool));
+    bool *touched = SDL_malloc(sizeof(bool) * vertex_count);
+    Uint32 *remap = SDL_malloc(sizeof(Uint32) * vertex_count);
+    struct APP_Collapse *collapses = SDL_malloc(sizeof(struct APP_Collapse) * index_count * 2);
+
+    if (quadrics == NULL
+        || offsets == NULL
+        || counts == NULL
+        || triangles == NULL
+        || locked == NULL
+        || touched == NULL
+        || remap == NULL
+        || collapses == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate simplifier memory.");
+        APP_FreeSimplifyScratch(quadrics, offsets, counts, triangles, locked, touched, remap, collapses);
+        return -1;
+    }
+
+    SDL_memcpy(out_indices, indices, sizeof(Uint16) * index_count);
+
+    for (Uint32 i = 0; i < index_count; i += 3)
+    {
+        const struct APP_PositionColorVertex *v0 = &vertices[indices[i + 0]];
+        struct APP_Vector3 normal = APP_TriangleNormal(v0, &vertices[indices[i + 1]], &vertices[indices[i + 2]]);
+
+        double length = SDL_sqrt(APP_Vector3_Dot(normal, normal));
+        if (length <= 0.0)
+        {
+            continue;
+        }
+
+        double a = normal.x / length;
+        double b = normal.y / length;
+        double c = normal.z / length;
+        double d = -(a * v0->x + b * v0->y + c * v0->z);
+
+        // Weighted by the triangle area.
+        for (int k = 0; k < 3; ++k)
+        {
+            APP_Quadric_AddPlane(&quadrics[indices[i + k]], a, b, c, d, length * 0.5);
+        }
+    }
+
+    APP_BuildAdjacency(out_indices, index_count, vertex_count, offsets, counts, triangles);
+    APP_FindBorderVertices(out_indices, index_count, offsets, counts, triangles, locked);
+
+    double max_cost = (double)max_error * (double)max_error;
+    double result_error = 0.0;
+
+    while (index_count > target_index_count)
+    {
+        APP_BuildAdjacency(out_indices, index_count, vertex_count, offsets, counts, triangles);
+
+        Uint32 collapse_count = 0;
+        for (Uint32 i = 0; i < index_count; ++i)
+        {
+            Uint32 a = out_indices[i];
+            Uint32 b = out_indices[(i % 3 == 2) ? i - 2 : i + 1];
+
+            struct APP_Quadric q = quadrics[a];
+            APP_Quadric_Add(&q, &quadrics[b]);
+
+            if (!locked[a])
+            {
+                collapses[collapse_count++] = (struct APP_Collapse){ a, b, APP_Quadric_Error(&q, &vertices[b]) };
+            }
+
+            if (!locked[b])
+            {
+                collapses[collapse_count++] = (struct APP_Collapse){ b, a, APP_Quadric_Error(&q, &vertices[a]) };
+            }
+        }
+
+        SDL_qsort(collapses, collapse_count, sizeof(struct APP_Collapse), APP_CompareCollapse);
+
+        for (Uint32 v = 0; v < vertex_count; ++v)
+        {
+            remap[v] = v;
+            touched[v] = false;
+        }
+
+        // Note(john): Every vertex takes part in at most one collapse per
+        // pass, so the adjacency stays valid while the pass runs.
+        Uint32 removed_indices = 0;
+        Uint32 applied = 0;
+
+        for (Uint32 i = 0; i < collapse_count; ++i)
+        {
+            const struct APP_Collapse *collapse = &collapses[i];
+
+            if (collapse->cost > max_cost || index_count - removed_indices <= target_index_count)
+            {
+                break;
+            }
+
+            if (touched[collapse->from] || touched[collapse->to])
+            {
+                continue;
+            }
+
+            if (APP_CollapseFlipsTriangle(vertices, out_indices, offsets, counts, triangles, collapse->from, collapse->to))
+            {
+                continue;
+            }
+
+            remap[collapse->from] = collapse->to;
+            APP_Quadric_Add(&quadrics[collapse->to], &quadrics[collapse->from]);
+
+            for (Uint32 t = 0; t < counts[collapse->from]; ++t)
+            {
+                const Uint16 *tri = &out_indices[triangles[offsets[collapse->from] + t] * 3];
+                touched[tri[0]] = true;
+                touched[tri[1]] = true;
+                touched[tri[2]] = true;
+
+                if (tri[0] == collapse->to || tri[1] == collapse->to || tri[2] == collapse->to)
+                {
+                    removed_indices += 3;
+                }
+            }
+
+            if (collapse->cost > result_error)
+            {
+                result_error = collapse->cost;
+            }
+
+            applied++;
+        }
+
+        if (applied == 0)
+        {
+            break;
+        }
+
+        Uint32 write = 0;
+        for (Uint32 i = 0; i < index_count; i += 3)
+        {
+            Uint16 a = (Uint16)remap[out_indices[i + 0]];
+            Uint16 b = (Uint16)remap[out_indices[i + 1]];
+            Uint16 c = (Uint16)remap[out_indices[i + 2]];
+
+            if (a == b || b == c || a == c)
+            {
+                continue;
+            }
+
+            out_indices[write++] = a;
+            out_indices[write++] = b;
+            out_indices[write++] = c;
+        }
+
+        index_count = write;
+    }
+
+    *out_index_count = index_count;
+    *out_error = (float)SDL_sqrt(result_error);
+
+    APP_FreeSimplifyScratch(quadrics, offsets, counts, triangles, locked, touched, remap, collapses);
+
+    return 0;
+}
+
+// Generate a LOD chain where every level targets half the triangles of the
+// previous one. All levels are concatenated into one index list that is
+// returned in out_indices (owned by the caller). The error of every LOD is
+// stored relative to the mesh radius. Returns the LOD count, 0 when out of
+// memory.
+Uint32
+APP_GenerateMeshLODs(
+        const struct APP_PositionColorVertex *vertices,
+        Uint32 vertex_count,
+        const Uint16 *indices,
+        Uint32 index_count,
+        float radius,
+        struct APP_MeshLOD *out_lods,
+        Uint16 **out_indices,
+        Uint32 *out_index_count
+)
+{
+    // Every level has at most as many indices as the full mesh.
+    Uint16 *lod_indices = SDL_malloc(sizeof(Uint16) * index_count * APP_MAX_MESH_LODS);
+    if (lod_indices == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate LOD indices.");
+        return 0;
+    }
+
+    SDL_memcpy(lod_indices, indices, sizeof(Uint16) * index_count);
+
+    out_lods[0] = (struct APP_MeshLOD){ .first_index = 0, .index_count = index_count, .error = 0.0f };
+
+    Uint32 lod_count = 1;
+    Uint32 total_index_count = index_count;
+    float max_error = APP_LOD_MAX_RELATIVE_ERROR * radius;
+
+    while (lod_count < APP_MAX_MESH_LODS)
+    {
+        const struct APP_MeshLOD *previous = &out_lods[lod_count - 1];
+        Uint32 target = (previous->index_count / 2) / 3 * 3;
+
+        Uint32 count;
+        float error;
+        if (APP_SimplifyMesh(
+                vertices,
+                vertex_count,
+                &lod_indices[previous->first_index],
+                previous->index_count,
+                target,
+                max_error,
+                &lod_indices[total_index_count],
+                &count,
+                &error) == -1)
+        {
+            SDL_free(lod_indices);
+            return 0;
+        }
+
+        // Stop once the simplifier can't make meaningful progress anymore.
+        if (count == 0 || count > previous->index_count * 9 / 10)
+        {
+            break;
+        }
+
+        // Note(john): Errors accumulate over the chain since every level is
+        // built from the previous one.
+        out_lods[lod_count] = (struct APP_MeshLOD){
+            .first_index = total_index_count,
+            .index_count = count,
+            .error = previous->error + error / radius,
+        };
+
+        total_index_count += count;
+        lod_count++;
+    }
+
+    *out_indices = lod_indices;
+    *out_index_count = total_index_count;
+
+    return lod_count;
+}
+
+// The selector uses the same field of view and viewport height as the
+// projection passed to APP_Matrix4x4_CreatePerspectiveFieldOfView.
+void
+APP_LODSelector_Init(struct APP_LODSelector *selector, float field_of_view, float viewport_height)
+{
+    selector->projection_scale = viewport_height / (2.0f * SDL_tanf(field_of_view * 0.5f));
+    selector->pixel_error = APP_LOD_DEFAULT_PIXEL_ERROR;
+    selector->hysteresis = APP_LOD_DEFAULT_HYSTERESIS;
+}
+
+// Pick the coarsest LOD whose projected error stays below the pixel error.
+// Switching to a coarser LOD requires the error to drop below the threshold
+// by the hysteresis margin, which keeps objects near a boundary from
+// flickering between two levels.
+Uint32
+APP_LODSelector_Select(
+        const struct APP_LODSelector *selector,
+        const struct APP_Mesh *mesh,
+        float radius,
+        float distance,
+        Uint32 current_lod
+)
+{
+    if (mesh->lod_count <= 1)
+    {
+        return 0;
+    }
+
+    // Pixels per unit of relative mesh error at this distance.
+    float scale = radius * selector->projection_scale / SDL_max(distance, 0.001f);
+    float coarsen_threshold = selector->pixel_error * (1.0f - selector->hysteresis);
+
+    Uint32 lod = SDL_min(current_lod, mesh->lod_count - 1);
+
+    while (lod > 0 && mesh->lods[lod].error * scale > selector->pixel_error)
+    {
+        lod--;
+    }
+
+    while (lod + 1 < mesh->lod_count && mesh->lods[lod + 1].error * scale <= coarsen_threshold)
+    {
+        lod++;
+    }
+
+    return lod;
+}
@@ -0,0 +1,60 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include "app.h"
+#include "math.h"
+
+// Collapses whose quadric error exceeds this fraction of the mesh radius are
+// rejected, which bounds the coarsest LOD that gets generated.
+#define APP_LOD_MAX_RELATIVE_ERROR 0.15f
+
+// Projected geometric error (in pixels) a LOD may have before the selector
+// switches to a finer one.
+#define APP_LOD_DEFAULT_PIXEL_ERROR 1.0f
+#define APP_LOD_DEFAULT_HYSTERESIS 0.25f
+
+struct APP_LODSelector {
+    // Pixels per world unit at a distance of one unit.
+    float projection_scale;
+    float pixel_error;
+    float hysteresis;
+};
+
+int APP_SimplifyMesh(
+        const struct APP_PositionColorVertex *vertices,
+        Uint32 vertex_count,
+        const Uint16 *indices,
+        Uint32 index_count,
+        Uint32 target_index_count,
+        float max_error,
+        Uint16 *out_indices,
+        Uint32 *out_index_count,
+        float *out_error
+);
+
+Uint32 APP_GenerateMeshLODs(
+        const struct APP_PositionColorVertex *vertices,
+        Uint32 vertex_count,
+        const Uint16 *indices,
+        Uint32 index_count,
+        float radius,
+        struct APP_MeshLOD *out_lods,
+        Uint16 **out_indices,
+        Uint32 *out_index_count
+);
+
+void APP_LODSelector_Init(
+        struct APP_LODSelector *selector,
+        float field_of_view,
+        float viewport_height
+);
+
+Uint32 APP_LODSelector_Select(
+        const struct APP_LODSelector *selector,
+        const struct APP_Mesh *mesh,
+        float radius,
+        float distance,
+        Uint32 current_lod
+);
+
+#endif
@@ -1,63 +1,210 @@
 #define SDL_MAIN_USE_CALLBACKS 1
 
 #include "app.h"
+#include "bench.h"
+#include "culling.h"
+#include "dynres.h"
+#include "gpumemory.h"
+#include "hiz.h"
+#include "megabuffer.h"
+#include "mesh.h"
+#include "pack.h"
+#include "rendergraph.h"
 #include "renderer.h"
+#include "scene.h"
+#include "startup.h"
 #include <SDL3/SDL_main.h>
 #include <stdlib.h>
 
+// Initial window size, the window can be resized.
 #define WINDOW_WIDTH 600
 #define WINDOW_HEIGHT 400
 
+#define DEFAULT_TARGET_FPS 60.0f
+#define DEFAULT_MIN_SCALE 0.5f
+#define DEFAULT_MAX_SCALE 1.0f
+
+#define DEFAULT_OBJECT_COUNT 10000
+
 SDL_AppResult 
 SDL_AppInit(void **appstate, int argc, char **argv) 
 {
+    Uint64 origin = SDL_GetPerformanceCounter();
+
     if (!SDL_Init(SDL_INIT_VIDEO)) 
     {
         SDL_Log("ERROR: Couldn't initialize SDL: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
-    struct APP_Context *ctx = malloc(sizeof(struct APP_Context));
+    struct APP_Context *ctx = calloc(1, sizeof(struct APP_Context));
+    bool parallel_startup = true;
+    bool loose_assets = false;
+
+    // Usage: main [--objects N] [--cpu-culling] [--push-uniforms] [--no-occlusion] [--no-lod] [--bench] [--dump-graph]
+    //             [--native] [--target-fps N] [--min-scale F] [--max-scale F] [--serial-startup] [--vram-budget MB]
+    //             [--loose-assets]
+    Uint32 object_count = DEFAULT_OBJECT_COUNT;
+    float target_fps = DEFAULT_TARGET_FPS;
+    float min_scale = DEFAULT_MIN_SCALE;
+    float max_scale = DEFAULT_MAX_SCALE;
+    ctx->dynamic_resolution.enabled = true;
+    ctx->gpu_culling = true;
+    ctx->occlusion_culling = true;
+    ctx->lod_enabled = true;
+    ctx->uniform_arena = true;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (SDL_strcmp(argv[i], "--objects") == 0 && i + 1 < argc)
+        {
+            object_count = (Uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--cpu-culling") == 0)
+        {
+            ctx->gpu_culling = false;
+        }
+        else if (SDL_strcmp(argv[i], "--push-uniforms") == 0)
+        {
+            ctx->uniform_arena = false;
+        }
+        else if (SDL_strcmp(argv[i], "--no-occlusion") == 0)
+        {
+            ctx->occlusion_culling = false;
+        }
+        else if (SDL_strcmp(argv[i], "--no-lod") == 0)
+        {
+            ctx->lod_enabled = false;
+        }
+        else if (SDL_strcmp(argv[i], "--bench") == 0)
+        {
+            ctx->benchmark.enabled = true;
+        }
+        else if (SDL_strcmp(argv[i], "--dump-graph") == 0)
+        {
+            ctx->dump_render_graph = true;
+        }
+        else if (SDL_strcmp(argv[i], "--native") == 0)
+        {
+            ctx->dynamic_resolution.enabled = false;
+        }
+        else if (SDL_strcmp(argv[i], "--target-fps") == 0 && i + 1 < argc)
+        {
+            target_fps = (float)SDL_atof(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--min-scale") == 0 && i + 1 < argc)
+        {
+            min_scale = (float)SDL_atof(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--max-scale") == 0 && i + 1 < argc)
+        {
+            max_scale = (float)SDL_atof(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--serial-startup") == 0)
+        {
+            parallel_startup = false;
+        }
+        else if (SDL_strcmp(argv[i], "--vram-budget") == 0 && i + 1 < argc)
+        {
+            ctx->gpu_memory_budget = (Uint64)SDL_atoi(argv[++i]) * 1024 * 1024;
+        }
+        else if (SDL_strcmp(argv[i], "--loose-assets") == 0)
+        {
+            loose_assets = true;
+        }
+    }
+
+    APP_Startup_Begin(&ctx->startup, origin, parallel_startup);
+    APP_Startup_AddPhase(&ctx->startup, "SDL_Init", "main", origin);
+
+    APP_DynamicResolution_Init(&ctx->dynamic_resolution, target_fps, min_scale, max_scale);
+
+    if (ctx->benchmark.enabled)
+    {
+        object_count = APP_BenchmarkFirstObjectCount(ctx);
+    }
 
     ctx->base_path = SDL_GetBasePath();
-    ctx->device = SDL_CreateGPUDevice(
-            SDL_GPU_SHADERFORMAT_SPIRV
-            | SDL_GPU_SHADERFORMAT_MSL
-            | SDL_GPU_SHADERFORMAT_DXIL, 
-            false, 
-            NULL
-    );
 
-    if (ctx->device == NULL) 
+    // Note(john): Without a pack next to the executable the assets are read
+    // from the loose files, as during development.
+    if (!loose_assets)
+    {
+        Uint64 pack_start = SDL_GetPerformanceCounter();
+        char pack_path[256];
+
+        SDL_snprintf(pack_path, sizeof(pack_path), "%sassets.pack", ctx->base_path);
+        ctx->pack = APP_Pack_Open(pack_path);
+
+        APP_Startup_AddPhase(&ctx->startup, "Asset Pack", "main", pack_start);
+    }
+
+    // Note(john): The device, the shader blobs and the meshes are made on
+    // task threads while the main thread creates the window. The pipelines
+    // are created in the background while the meshes are uploaded and the
+    // scene is built, the first frame waits for them.
+    if (APP_StartRenderer(ctx) == -1)
     {
-        SDL_Log("ERROR: Failed to create device. %s", SDL_GetError());
+        SDL_Log("ERROR: Failed to start renderer.");
+        APP_Startup_WaitAllTasks(ctx);
         free(ctx);
         return SDL_APP_FAILURE;
     }
 
-    ctx->window = SDL_CreateWindow("Viewport", WINDOW_WIDTH, WINDOW_HEIGHT, 0);
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    ctx->window = SDL_CreateWindow("Viewport", WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_RESIZABLE);
     if (ctx->window == NULL) 
     {
         SDL_Log("ERROR: Failed to create window. %s", SDL_GetError());
+        APP_Startup_WaitAllTasks(ctx);
+        free(ctx);
+        return SDL_APP_FAILURE;
+    }
+
+    APP_Startup_AddPhase(&ctx->startup, "Window", "main", start);
+
+    if (APP_WaitForDevice(ctx) == -1) 
+    {
+        SDL_Log("ERROR: Failed to create device.");
+        APP_Startup_WaitAllTasks(ctx);
         free(ctx);
         return SDL_APP_FAILURE;
     }
 
+    start = SDL_GetPerformanceCounter();
+
     if (!SDL_ClaimWindowForGPUDevice(ctx->device, ctx->window)) 
     {
         SDL_Log("ERROR: Failed to claim window. %s", SDL_GetError());
+        APP_Startup_WaitAllTasks(ctx);
         free(ctx);
         return SDL_APP_FAILURE;
     }
 
+    APP_Startup_AddPhase(&ctx->startup, "Claim Window", "main", start);
+
     int result = APP_InitRenderer(ctx);
     if (result == -1)
     { 
         SDL_Log("ERROR: Failed to init renderer.");
+        APP_Startup_WaitAllTasks(ctx);
+        free(ctx);
+        return SDL_APP_FAILURE;
+    }
+
+    start = SDL_GetPerformanceCounter();
+
+    if (APP_CreateScene(ctx, object_count) == -1)
+    {
+        SDL_Log("ERROR: Failed to create scene.");
+        APP_Startup_WaitAllTasks(ctx);
         free(ctx);
         return SDL_APP_FAILURE;
     }
 
+    APP_Startup_AddPhase(&ctx->startup, "Scene", "main", start);
+
     *appstate = ctx;
 
     return SDL_APP_CONTINUE;
@@ -66,13 +213,87 @@ SDL_AppInit(void **appstate, int argc, char **argv)
 SDL_AppResult 
 SDL_AppEvent(void *appstate, SDL_Event *event) 
 {
+    struct APP_Context *ctx = appstate;
+
     if(event->type == SDL_EVENT_QUIT)
     {
         return SDL_APP_SUCCESS;
     }
 
+    // The swapchain follows the window on its own, the frame times around a
+    // resize say nothing about the scene though.
+    if (event->type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED)
+    {
+        APP_DynamicResolution_Reset(&ctx->dynamic_resolution);
+        return SDL_APP_CONTINUE;
+    }
+
     if(event->type == SDL_EVENT_KEY_DOWN)
     {
+        // Note(john): C switches between CPU and GPU culling, U between
+        // the uniform arena and per draw pushes of the CPU path, O turns
+        // the occlusion culling of the GPU path on and off, L turns the LOD
+        // selection on and off, R the dynamic resolution, G dumps the next
+        // frame graph, M
+        // rebuilds the sphere with another resolution, K compacts the mesh
+        // buffers, every other key closes the example.
+        if (event->key.key == SDLK_C && !ctx->benchmark.enabled)
+        {
+            ctx->gpu_culling = !ctx->gpu_culling;
+            SDL_zero(ctx->stats);
+            return SDL_APP_CONTINUE;
+        }
+
+        if (event->key.key == SDLK_O && !ctx->benchmark.enabled && ctx->depth_sampleable)
+        {
+            ctx->occlusion_culling = !ctx->occlusion_culling;
+            SDL_zero(ctx->stats);
+            return SDL_APP_CONTINUE;
+        }
+
+        if (event->key.key == SDLK_R && !ctx->benchmark.enabled)
+        {
+            ctx->dynamic_resolution.enabled = !ctx->dynamic_resolution.enabled;
+            APP_DynamicResolution_Reset(&ctx->dynamic_resolution);
+            return SDL_APP_CONTINUE;
+        }
+
+        if (event->key.key == SDLK_L && !ctx->benchmark.enabled)
+        {
+            ctx->lod_enabled = !ctx->lod_enabled;
+            SDL_zero(ctx->stats);
+            return SDL_APP_CONTINUE;
+        }
+
+        if (event->key.key == SDLK_U && !ctx->benchmark.enabled)
+        {
+            ctx->uniform_arena = !ctx->uniform_arena;
+            SDL_zero(ctx->stats);
+            return SDL_APP_CONTINUE;
+        }
+
+        if (event->key.key == SDLK_G)
+        {
+            ctx->dump_render_graph = true;
+            return SDL_APP_CONTINUE;
+        }
+
+        if (event->key.key == SDLK_M && !ctx->benchmark.enabled)
+        {
+            static const Uint32 resolutions[][2] = { { 16, 8 }, { 96, 48 }, { 32, 16 }, { 64, 32 } };
+            static Uint32 next_resolution = 0;
+
+            const Uint32 *resolution = resolutions[next_resolution];
+            next_resolution = (next_resolution + 1) % SDL_arraysize(resolutions);
+
+            return APP_RebuildSphereMesh(ctx, resolution[0], resolution[1]) == -1 ? SDL_APP_FAILURE : SDL_APP_CONTINUE;
+        }
+
+        if (event->key.key == SDLK_K && !ctx->benchmark.enabled)
+        {
+            return APP_CompactMeshBuffers(ctx) == -1 ? SDL_APP_FAILURE : SDL_APP_CONTINUE;
+        }
+
         return SDL_APP_SUCCESS;
     }
 
@@ -86,7 +307,30 @@ SDL_AppIterate(void *appstate)
 
     ctx->time += 0.1f; 
 
-    APP_Draw(appstate);
+    if (!ctx->startup.finished)
+    {
+        if (APP_WaitForPipelines(ctx) == -1)
+        {
+            SDL_Log("ERROR: Failed to create pipelines.");
+            return SDL_APP_FAILURE;
+        }
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        APP_Draw(appstate);
+        APP_Startup_AddPhase(&ctx->startup, "First Frame", "main", start);
+        APP_Startup_Finish(&ctx->startup);
+    }
+    else
+    {
+        APP_Draw(appstate);
+    }
+
+    if (ctx->benchmark.enabled)
+    {
+        return APP_UpdateBenchmark(ctx) ? SDL_APP_SUCCESS : SDL_APP_CONTINUE;
+    }
+
+    APP_LogFrameStats(ctx);
     return SDL_APP_CONTINUE;
 }
 
@@ -96,13 +340,32 @@ SDL_AppQuit(void *appstate, SDL_AppResult result)
     struct APP_Context *ctx = appstate;
 
     SDL_ReleaseGPUGraphicsPipeline(ctx->device, ctx->pipeline);
+    SDL_ReleaseGPUGraphicsPipeline(ctx->device, ctx->arena_pipeline);
+    APP_ReleaseGPUCulling(ctx);
+    APP_DepthPyramid_Destroy(ctx, ctx->depth_pyramid);
+    APP_ReleaseScene(ctx);
+
+    for (int i = 0; i < APP_MESH_COUNT; ++i)
+    {
+        APP_ReleaseMesh(ctx, &ctx->meshes[i]);
+    }
 
-    SDL_ReleaseGPUBuffer(ctx->device, ctx->scene_vertex_buffer);
-    SDL_ReleaseGPUBuffer(ctx->device, ctx->scene_index_buffer);
+    APP_MegaBuffer_Destroy(ctx->mesh_vertex_buffer);
+    APP_MegaBuffer_Destroy(ctx->mesh_index_buffer);
+
+    APP_RenderGraph_Destroy(ctx->render_graph);
+
+    // Note(john): Everything is released by now, whatever the report still
+    // lists leaked.
+    APP_GPUMemory_LogReport(ctx->gpu_memory);
+    APP_GPUMemory_Destroy(ctx->gpu_memory);
 
     SDL_ReleaseWindowFromGPUDevice(ctx->device, ctx->window);
     SDL_DestroyWindow(ctx->window);
     SDL_DestroyGPUDevice(ctx->device);
 
+    APP_Pack_LogStats(ctx->pack);
+    APP_Pack_Close(ctx->pack);
+
     free(ctx);
 }
@@ -186,3 +186,85 @@ APP_Matrix4x4_Mutliply(struct APP_Matrix4x4 m_a, struct APP_Matrix4x4 m_b)
 
     return out;
 }
+
+struct APP_Matrix4x4
+APP_Matrix4x4_CreateTranslation(struct APP_Vector3 position)
+{
+    return (struct APP_Matrix4x4) {
+        1, 0, 0, 0,
+        0, 1, 0, 0,
+        0, 0, 1, 0,
+        position.x, position.y, position.z, 1
+    };
+}
+
+struct APP_Matrix4x4
+APP_Matrix4x4_CreateScale(float scale)
+{
+    return (struct APP_Matrix4x4) {
+        scale, 0, 0, 0,
+        0, scale, 0, 0,
+        0, 0, scale, 0,
+        0, 0, 0, 1
+    };
+}
+
+struct APP_Matrix4x4
+APP_Matrix4x4_CreateRotationY(float radians)
+{
+    float c = SDL_cosf(radians);
+    float s = SDL_sinf(radians);
+
+    return (struct APP_Matrix4x4) {
+        c, 0, -s, 0,
+        0, 1, 0, 0,
+        s, 0, c, 0,
+        0, 0, 0, 1
+    };
+}
+
+static struct APP_Vector4
+APP_Vector4_NormalizePlane(float a, float b, float c, float d)
+{
+    float magnitude = SDL_sqrtf((a * a) + (b * b) + (c * c));
+    return (struct APP_Vector4) { a / magnitude, b / magnitude, c / magnitude, d / magnitude };
+}
+
+// Extract the six clip planes (Gribb/Hartmann) from a row-vector view
+// projection matrix. Depth is expected in the [0, 1] range like the
+// projection from APP_Matrix4x4_CreatePerspectiveFieldOfView.
+struct APP_Frustum
+APP_Frustum_FromMatrix(struct APP_Matrix4x4 m)
+{
+    struct APP_Frustum frustum;
+
+    // left, right
+    frustum.planes[0] = APP_Vector4_NormalizePlane(m.m14 + m.m11, m.m24 + m.m21, m.m34 + m.m31, m.m44 + m.m41);
+    frustum.planes[1] = APP_Vector4_NormalizePlane(m.m14 - m.m11, m.m24 - m.m21, m.m34 - m.m31, m.m44 - m.m41);
+
+    // bottom, top
+    frustum.planes[2] = APP_Vector4_NormalizePlane(m.m14 + m.m12, m.m24 + m.m22, m.m34 + m.m32, m.m44 + m.m42);
+    frustum.planes[3] = APP_Vector4_NormalizePlane(m.m14 - m.m12, m.m24 - m.m22, m.m34 - m.m32, m.m44 - m.m42);
+
+    // near, far
+    frustum.planes[4] = APP_Vector4_NormalizePlane(m.m13, m.m23, m.m33, m.m43);
+    frustum.planes[5] = APP_Vector4_NormalizePlane(m.m14 - m.m13, m.m24 - m.m23, m.m34 - m.m33, m.m44 - m.m43);
+
+    return frustum;
+}
+
+bool
+APP_Frustum_ContainsSphere(const struct APP_Frustum *frustum, struct APP_Vector3 center, float radius)
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        const struct APP_Vector4 *plane = &frustum->planes[i];
+        float distance = (plane->x * center.x) + (plane->y * center.y) + (plane->z * center.z) + plane->w;
+        if (distance < -radius)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -7,6 +7,16 @@ struct APP_Vector3 {
     float x, y, z;
 };
 
+struct APP_Vector4 {
+    float x, y, z, w;
+};
+
+// Note(john): A plane is stored as (normal.xyz, distance) so a point p lies
+// in front of it when dot(normal, p) + distance >= 0.
+struct APP_Frustum {
+    struct APP_Vector4 planes[6];
+};
+
 struct APP_Matrix4x4 {
     float m11, m12, m13, m14;
     float m21, m22, m23, m24;
@@ -41,4 +51,11 @@ struct APP_Matrix4x4 APP_Matrix4x4_Mutliply(
         struct APP_Matrix4x4 m_b
 );
 
+struct APP_Matrix4x4 APP_Matrix4x4_CreateTranslation(struct APP_Vector3 position);
+struct APP_Matrix4x4 APP_Matrix4x4_CreateScale(float scale);
+struct APP_Matrix4x4 APP_Matrix4x4_CreateRotationY(float radians);
+
+struct APP_Frustum APP_Frustum_FromMatrix(struct APP_Matrix4x4 view_proj);
+bool APP_Frustum_ContainsSphere(const struct APP_Frustum *frustum, struct APP_Vector3 center, float radius);
+
 #endif
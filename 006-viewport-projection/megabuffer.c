@@ -0,0 +1,268 @@
+#include "megabuffer.h"
+#include "app.h"
+#include "gpumemory.h"
+#include "tlsf.h"
+
+struct APP_MegaBufferCopy {
+    SDL_GPUCopyPass *copy_pass;
+    SDL_GPUBuffer *source;
+    SDL_GPUBuffer *destination;
+    Uint32 stride;
+};
+
+static SDL_GPUBuffer*
+APP_MegaBufferCreateBuffer(const struct APP_MegaBuffer *mega_buffer, Uint32 capacity)
+{
+    return APP_GPUMemory_CreateBuffer(
+            mega_buffer->memory,
+            &(SDL_GPUBufferCreateInfo){
+                .usage = mega_buffer->usage,
+                .size = capacity * mega_buffer->stride
+            },
+            mega_buffer->name
+    );
+}
+
+static void
+APP_MegaBufferCopyRange(Uint32 handle, Uint32 old_offset, Uint32 new_offset, Uint32 size, void *user_data)
+{
+    const struct APP_MegaBufferCopy *copy = user_data;
+
+    SDL_CopyGPUBufferToBuffer(
+            copy->copy_pass,
+            &(SDL_GPUBufferLocation){
+                .buffer = copy->source,
+                .offset = old_offset * copy->stride
+            },
+            &(SDL_GPUBufferLocation){
+                .buffer = copy->destination,
+                .offset = new_offset * copy->stride
+            },
+            size * copy->stride,
+            false
+    );
+}
+
+// Copy all live ranges tightly packed into a new buffer of the given
+// capacity. Used for compaction and for growing, the old buffer is released
+// once the GPU is done with it. On failure the ranges and the buffer stay
+// as they were.
+static bool
+APP_MegaBufferRelocate(SDL_GPUDevice *device, struct APP_MegaBuffer *mega_buffer, Uint32 capacity)
+{
+    SDL_GPUBuffer *buffer = APP_MegaBufferCreateBuffer(mega_buffer, capacity);
+    if (buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create mega buffer '%s'. %s", mega_buffer->name, SDL_GetError());
+        return false;
+    }
+
+    SDL_GPUCommandBuffer *cmd_buffer = SDL_AcquireGPUCommandBuffer(device);
+    if (cmd_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to acquire command buffer. %s", SDL_GetError());
+        APP_GPUMemory_ReleaseBuffer(mega_buffer->memory, buffer);
+        return false;
+    }
+
+    // Note(john): Grown before anything is copied, the allocator needs a new
+    // block for the added space and can't move the ranges back once they
+    // were compacted.
+    if (!APP_TLSF_Grow(&mega_buffer->allocator, capacity))
+    {
+        SDL_Log("ERROR: Failed to grow the allocator of mega buffer '%s'.", mega_buffer->name);
+        SDL_CancelGPUCommandBuffer(cmd_buffer);
+        APP_GPUMemory_ReleaseBuffer(mega_buffer->memory, buffer);
+        return false;
+    }
+
+    struct APP_MegaBufferCopy copy = {
+        .copy_pass = SDL_BeginGPUCopyPass(cmd_buffer),
+        .source = mega_buffer->buffer,
+        .destination = buffer,
+        .stride = mega_buffer->stride
+    };
+
+    APP_TLSF_Compact(&mega_buffer->allocator, APP_MegaBufferCopyRange, &copy);
+
+    SDL_EndGPUCopyPass(copy.copy_pass);
+    SDL_SubmitGPUCommandBuffer(cmd_buffer);
+
+    APP_GPUMemory_ReleaseBuffer(mega_buffer->memory, mega_buffer->buffer);
+    mega_buffer->buffer = buffer;
+    mega_buffer->compaction_count++;
+
+    return true;
+}
+
+// capacity is in elements.
+struct APP_MegaBuffer*
+APP_MegaBuffer_Create(
+        struct APP_GPUMemory *memory,
+        const char *name,
+        SDL_GPUBufferUsageFlags usage,
+        Uint32 stride,
+        Uint32 capacity
+)
+{
+    struct APP_MegaBuffer *mega_buffer = SDL_calloc(1, sizeof(struct APP_MegaBuffer));
+    if (mega_buffer == NULL)
+    {
+        return NULL;
+    }
+
+    mega_buffer->name = name;
+    mega_buffer->memory = memory;
+    mega_buffer->usage = usage;
+    mega_buffer->stride = stride;
+
+    if (!APP_TLSF_Init(&mega_buffer->allocator, capacity))
+    {
+        SDL_free(mega_buffer);
+        return NULL;
+    }
+
+    mega_buffer->buffer = APP_MegaBufferCreateBuffer(mega_buffer, capacity);
+    if (mega_buffer->buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create mega buffer '%s'. %s", name, SDL_GetError());
+        APP_TLSF_Release(&mega_buffer->allocator);
+        SDL_free(mega_buffer);
+        return NULL;
+    }
+
+    return mega_buffer;
+}
+
+void
+APP_MegaBuffer_Destroy(struct APP_MegaBuffer *mega_buffer)
+{
+    if (mega_buffer == NULL)
+    {
+        return;
+    }
+
+    APP_GPUMemory_ReleaseBuffer(mega_buffer->memory, mega_buffer->buffer);
+    APP_TLSF_Release(&mega_buffer->allocator);
+    SDL_free(mega_buffer);
+}
+
+// Allocate count elements and upload the data into them. If there is no
+// free block big enough, the buffer is compacted and grown first. Returns
+// APP_TLSF_INVALID on failure.
+Uint32
+APP_MegaBuffer_Upload(
+        SDL_GPUDevice *device,
+        struct APP_MegaBuffer *mega_buffer,
+        const void *data,
+        Uint32 count
+)
+{
+    Uint32 handle = APP_TLSF_Alloc(&mega_buffer->allocator, count);
+    if (handle == APP_TLSF_INVALID)
+    {
+        const struct APP_TLSF *allocator = &mega_buffer->allocator;
+        Uint32 capacity = SDL_max(allocator->capacity * 2, allocator->used + count);
+
+        SDL_Log("INFO: Grow mega buffer '%s' to %u elements", mega_buffer->name, capacity);
+
+        if (!APP_MegaBufferRelocate(device, mega_buffer, capacity))
+        {
+            return APP_TLSF_INVALID;
+        }
+
+        handle = APP_TLSF_Alloc(&mega_buffer->allocator, count);
+        if (handle == APP_TLSF_INVALID)
+        {
+            return APP_TLSF_INVALID;
+        }
+    }
+
+    Uint32 size = count * mega_buffer->stride;
+
+    SDL_GPUTransferBuffer *transfer_buffer = APP_GPUMemory_CreateTransferBuffer(
+            mega_buffer->memory,
+            &(SDL_GPUTransferBufferCreateInfo){
+                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                .size = size
+            },
+            "Mega Buffer Upload"
+    );
+
+    if (transfer_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create transfer buffer. %s", SDL_GetError());
+        APP_TLSF_Free(&mega_buffer->allocator, handle);
+        return APP_TLSF_INVALID;
+    }
+
+    void *transfer_data = SDL_MapGPUTransferBuffer(device, transfer_buffer, false);
+    SDL_memcpy(transfer_data, data, size);
+    SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
+
+    SDL_GPUCommandBuffer *cmd_buffer = SDL_AcquireGPUCommandBuffer(device);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(cmd_buffer);
+
+    SDL_UploadToGPUBuffer(
+            copy_pass,
+            &(SDL_GPUTransferBufferLocation){
+                .transfer_buffer = transfer_buffer,
+                .offset = 0
+            },
+            &(SDL_GPUBufferRegion){
+                .buffer = mega_buffer->buffer,
+                .offset = APP_TLSF_Offset(&mega_buffer->allocator, handle) * mega_buffer->stride,
+                .size = size
+            },
+            false
+    );
+
+    SDL_EndGPUCopyPass(copy_pass);
+    SDL_SubmitGPUCommandBuffer(cmd_buffer);
+    APP_GPUMemory_ReleaseTransferBuffer(mega_buffer->memory, transfer_buffer);
+
+    return handle;
+}
+
+void
+APP_MegaBuffer_Free(struct APP_MegaBuffer *mega_buffer, Uint32 handle)
+{
+    APP_TLSF_Free(&mega_buffer->allocator, handle);
+}
+
+// Offset of the range in elements.
+Uint32
+APP_MegaBuffer_Offset(const struct APP_MegaBuffer *mega_buffer, Uint32 handle)
+{
+    return APP_TLSF_Offset(&mega_buffer->allocator, handle);
+}
+
+// Move all ranges to the start of the buffer, so the free space is one
+// block again. Offsets change, see APP_UpdateMeshRanges.
+bool
+APP_MegaBuffer_Compact(SDL_GPUDevice *device, struct APP_MegaBuffer *mega_buffer)
+{
+    return APP_MegaBufferRelocate(device, mega_buffer, mega_buffer->allocator.capacity);
+}
+
+void
+APP_MegaBuffer_LogStats(const struct APP_MegaBuffer *mega_buffer)
+{
+    struct APP_TLSFStats stats;
+    APP_TLSF_GetStats(&mega_buffer->allocator, &stats);
+
+    SDL_Log(
+            "INFO: [mega buffer] %s: %u / %u elements used (%.1f%%, %u KiB), %u allocations, "
+            "%u free blocks, largest free %u, fragmentation %.1f%%, %u compactions",
+            mega_buffer->name,
+            stats.used,
+            stats.capacity,
+            stats.capacity > 0 ? 100.0f * (float)stats.used / (float)stats.capacity : 0.0f,
+            (stats.capacity * mega_buffer->stride) / 1024,
+            stats.allocation_count,
+            stats.free_block_count,
+            stats.largest_free_block,
+            stats.fragmentation * 100.0f,
+            mega_buffer->compaction_count
+    );
+}
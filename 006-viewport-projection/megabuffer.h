@@ -0,0 +1,44 @@
+#ifndef MEGABUFFER_H
+#define MEGABUFFER_H
+
+#include "app.h"
+#include "gpumemory.h"
+#include "tlsf.h"
+
+// One GPU buffer shared by many meshes. Ranges are handed out by a TLSF
+// allocator in elements (vertices or indices), so the offset of a range is
+// directly the base vertex or first index of a draw.
+struct APP_MegaBuffer {
+    const char *name;
+    struct APP_GPUMemory *memory;
+    SDL_GPUBuffer *buffer;
+    SDL_GPUBufferUsageFlags usage;
+    // Bytes per element.
+    Uint32 stride;
+
+    struct APP_TLSF allocator;
+    Uint32 compaction_count;
+};
+
+struct APP_MegaBuffer *APP_MegaBuffer_Create(
+        struct APP_GPUMemory *memory,
+        const char *name,
+        SDL_GPUBufferUsageFlags usage,
+        Uint32 stride,
+        Uint32 capacity
+);
+void APP_MegaBuffer_Destroy(struct APP_MegaBuffer *mega_buffer);
+
+Uint32 APP_MegaBuffer_Upload(
+        SDL_GPUDevice *device,
+        struct APP_MegaBuffer *mega_buffer,
+        const void *data,
+        Uint32 count
+);
+void APP_MegaBuffer_Free(struct APP_MegaBuffer *mega_buffer, Uint32 handle);
+Uint32 APP_MegaBuffer_Offset(const struct APP_MegaBuffer *mega_buffer, Uint32 handle);
+
+bool APP_MegaBuffer_Compact(SDL_GPUDevice *device, struct APP_MegaBuffer *mega_buffer);
+void APP_MegaBuffer_LogStats(const struct APP_MegaBuffer *mega_buffer);
+
+#endif
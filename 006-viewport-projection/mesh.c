@@ -0,0 +1,348 @@
+#include "mesh.h"
+#include "app.h"
+#include "lod.h"
+#include "math.h"
+#include "megabuffer.h"
+
+// Compute the bounds and the LOD chain of a mesh on the CPU. Touches no GPU
+// state, so the startup builds the meshes on a task thread while the device
+// is created.
+int
+APP_BuildMeshData(
+        struct APP_MeshData *data,
+        const char *name,
+        const struct APP_PositionColorVertex *vertices,
+        Uint32 vertex_count,
+        const Uint16 *indices,
+        Uint32 index_count
+)
+{
+    SDL_zerop(data);
+    data->name = name;
+
+    float radius = 0.0f;
+    for (Uint32 i = 0; i < vertex_count; ++i)
+    {
+        const struct APP_PositionColorVertex *v = &vertices[i];
+        radius = SDL_max(radius, SDL_sqrtf((v->x * v->x) + (v->y * v->y) + (v->z * v->z)));
+    }
+
+    data->vertices = SDL_malloc(sizeof(struct APP_PositionColorVertex) * vertex_count);
+    if (data->vertices == NULL)
+    {
+        return -1;
+    }
+
+    SDL_memcpy(data->vertices, vertices, sizeof(struct APP_PositionColorVertex) * vertex_count);
+    data->vertex_count = vertex_count;
+    data->radius = radius;
+    data->lod_count = APP_GenerateMeshLODs(
+            vertices,
+            vertex_count,
+            indices,
+            index_count,
+            radius,
+            data->lods,
+            &data->lod_indices,
+            &data->lod_index_count
+    );
+
+    if (data->lod_count == 0)
+    {
+        APP_ReleaseMeshData(data);
+        return -1;
+    }
+
+    for (Uint32 i = 0; i < data->lod_count; ++i)
+    {
+        SDL_Log(
+                "INFO: Mesh '%s' LOD %u: %u triangles, error %.4f",
+                name,
+                i,
+                data->lods[i].index_count / 3,
+                data->lods[i].error
+        );
+    }
+
+    return 0;
+}
+
+void
+APP_ReleaseMeshData(struct APP_MeshData *data)
+{
+    SDL_free(data->vertices);
+    SDL_free(data->lod_indices);
+    SDL_zerop(data);
+}
+
+// Upload the vertices plus the index lists of every LOD into ranges of the
+// shared mesh buffers.
+int
+APP_UploadMesh(struct APP_Context *ctx, struct APP_Mesh *mesh, const struct APP_MeshData *data)
+{
+    mesh->vertex_count = data->vertex_count;
+    mesh->radius = data->radius;
+    mesh->lod_count = data->lod_count;
+    SDL_memcpy(mesh->lods, data->lods, sizeof(mesh->lods));
+
+    mesh->vertex_allocation = APP_MegaBuffer_Upload(
+            ctx->device, 
+            ctx->mesh_vertex_buffer, 
+            data->vertices, 
+            data->vertex_count
+    );
+    mesh->index_allocation = APP_MegaBuffer_Upload(
+            ctx->device, 
+            ctx->mesh_index_buffer, 
+            data->lod_indices, 
+            data->lod_index_count
+    );
+
+    if (mesh->vertex_allocation == APP_TLSF_INVALID || mesh->index_allocation == APP_TLSF_INVALID)
+    {
+        SDL_Log("ERROR: Failed to allocate mesh buffer ranges for mesh '%s'.", data->name);
+        APP_ReleaseMesh(ctx, mesh);
+        return -1;
+    }
+
+    APP_UpdateMeshRanges(ctx);
+
+    return 0;
+}
+
+// Generate the LOD chain for the mesh and upload it.
+int
+APP_CreateMesh(
+        struct APP_Context *ctx,
+        struct APP_Mesh *mesh,
+        const char *name,
+        const struct APP_PositionColorVertex *vertices,
+        Uint32 vertex_count,
+        const Uint16 *indices,
+        Uint32 index_count
+)
+{
+    struct APP_MeshData data;
+    if (APP_BuildMeshData(&data, name, vertices, vertex_count, indices, index_count) == -1)
+    {
+        SDL_Log("ERROR: Failed to build mesh '%s'.", name);
+        return -1;
+    }
+
+    int result = APP_UploadMesh(ctx, mesh, &data);
+    APP_ReleaseMeshData(&data);
+
+    return result;
+}
+
+// Read the offsets of all meshes back from the mesh buffers. Has to be called
+// whenever the buffers grew or were compacted.
+void
+APP_UpdateMeshRanges(struct APP_Context *ctx)
+{
+    for (Uint32 i = 0; i < APP_MESH_COUNT; ++i)
+    {
+        struct APP_Mesh *mesh = &ctx->meshes[i];
+        if (mesh->lod_count == 0)
+        {
+            continue;
+        }
+
+        mesh->base_vertex = (Sint32)APP_MegaBuffer_Offset(ctx->mesh_vertex_buffer, mesh->vertex_allocation);
+        mesh->first_index = APP_MegaBuffer_Offset(ctx->mesh_index_buffer, mesh->index_allocation);
+    }
+}
+
+// Bind the shared mesh buffers, every mesh is drawn from them with its base
+// vertex and first index.
+void
+APP_BindMeshBuffers(struct APP_Context *ctx, SDL_GPURenderPass *render_pass)
+{
+    SDL_BindGPUVertexBuffers(
+            render_pass, 
+            0, 
+            &(SDL_GPUBufferBinding){
+                .buffer = ctx->mesh_vertex_buffer->buffer, 
+                .offset = 0 
+            }, 
+            1
+    );
+
+    SDL_BindGPUIndexBuffer(
+            render_pass, 
+            &(SDL_GPUBufferBinding){ 
+                .buffer = ctx->mesh_index_buffer->buffer, 
+                .offset = 0 
+            }, 
+            SDL_GPU_INDEXELEMENTSIZE_16BIT
+    );
+}
+
+void
+APP_ReleaseMesh(struct APP_Context *ctx, struct APP_Mesh *mesh)
+{
+    APP_MegaBuffer_Free(ctx->mesh_vertex_buffer, mesh->vertex_allocation);
+    APP_MegaBuffer_Free(ctx->mesh_index_buffer, mesh->index_allocation);
+    SDL_zerop(mesh);
+
+    mesh->vertex_allocation = APP_TLSF_INVALID;
+    mesh->index_allocation = APP_TLSF_INVALID;
+}
+
+int
+APP_BuildCubeMeshData(struct APP_MeshData *data)
+{
+    struct APP_PositionColorVertex vertices[24] = {
+        {-10, -10, -10, 255, 0, 0, 255},
+        {10, -10, -10, 255, 0, 0, 255},
+        {10, 10, -10, 255, 0, 0, 255},
+        {-10, 10, -10, 255, 0, 0, 255},
+
+        {-10, -10, 10, 255, 0, 0, 255},
+        {10, -10, 10, 255, 0, 0, 255},
+        {10, 10, 10, 255, 0, 0, 255},
+        {-10, 10, 10, 255, 0, 0, 255},
+
+        {-10, -10, -10, 255, 0, 0, 255},
+        {-10, 10, -10, 255, 0, 0, 255},
+        {-10, 10, 10, 255, 0, 0, 255},
+        {-10, -10, 10, 255, 0, 0, 255},
+
+        {10, -10, -10, 0, 255, 0, 255},
+        {10, 10, -10, 0, 255, 0, 255},
+        {10, 10, 10, 0, 255, 0, 255},
+        {10, -10, 10, 0, 255, 0, 255},
+
+        {-10, -10, -10, 255, 0, 0, 255},
+        {-10, -10, 10, 255, 0, 0, 255},
+        {10, -10, 10, 255, 0, 0, 255},
+        {10, -10, -10, 255, 0, 0, 255},
+
+        {-10, 10, -10, 255, 0, 0, 255},
+        {-10, 10, 10, 255, 0, 0, 255},
+        {10, 10, 10, 255, 0, 0, 255},
+        {10, 10, -10, 255, 0, 0, 255},
+    };
+
+    Uint16 indices[] = {
+        0,  1,  2,  0,  2,  3,  
+        4,  5,  6,  4,  6,  7, 
+        8,  9,  10, 8,  10, 11, 
+        12, 13, 14, 12, 14, 15, 
+        16, 17, 18, 16, 18, 19, 
+        20, 21, 22, 20, 22, 23
+    };
+
+    return APP_BuildMeshData(data, "Cube", vertices, SDL_arraysize(vertices), indices, SDL_arraysize(indices));
+}
+
+// Create a closed sphere with the same radius as the cube's half extent. The
+// columns wrap around instead of duplicating a seam, so the simplifier can
+// collapse all of them without hitting a locked border.
+int
+APP_BuildSphereMeshData(struct APP_MeshData *data, Uint32 segments, Uint32 rings)
+{
+    const float radius = 10.0f;
+
+    Uint32 vertex_count = 2 + (rings - 1) * segments;
+    Uint32 index_count = segments * 6 + (rings - 2) * segments * 6;
+
+    struct APP_PositionColorVertex *vertices = SDL_malloc(sizeof(struct APP_PositionColorVertex) * vertex_count);
+    Uint16 *indices = SDL_malloc(sizeof(Uint16) * index_count);
+    if (vertices == NULL || indices == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate sphere mesh memory.");
+        SDL_free(vertices);
+        SDL_free(indices);
+        return -1;
+    }
+
+    Uint32 v = 0;
+    vertices[v++] = (struct APP_PositionColorVertex){ 0, radius, 0, 128, 255, 128, 255 };
+
+    for (Uint32 ring = 1; ring < rings; ++ring)
+    {
+        float phi = SDL_PI_F * (float)ring / (float)rings;
+
+        for (Uint32 segment = 0; segment < segments; ++segment)
+        {
+            float theta = 2.0f * SDL_PI_F * (float)segment / (float)segments;
+            float nx = SDL_sinf(phi) * SDL_cosf(theta);
+            float ny = SDL_cosf(phi);
+            float nz = SDL_sinf(phi) * SDL_sinf(theta);
+
+            vertices[v++] = (struct APP_PositionColorVertex){
+                nx * radius, ny * radius, nz * radius,
+                (Uint8)((nx * 0.5f + 0.5f) * 255),
+                (Uint8)((ny * 0.5f + 0.5f) * 255),
+                (Uint8)((nz * 0.5f + 0.5f) * 255),
+                255
+            };
+        }
+    }
+
+    Uint32 south_pole = v;
+    vertices[v++] = (struct APP_PositionColorVertex){ 0, -radius, 0, 128, 0, 128, 255 };
+
+    Uint32 i = 0;
+    for (Uint32 segment = 0; segment < segments; ++segment)
+    {
+        Uint32 next = (segment + 1) % segments;
+
+        indices[i++] = 0;
+        indices[i++] = (Uint16)(1 + next);
+        indices[i++] = (Uint16)(1 + segment);
+    }
+
+    for (Uint32 ring = 0; ring < rings - 2; ++ring)
+    {
+        Uint32 row = 1 + ring * segments;
+        Uint32 next_row = row + segments;
+
+        for (Uint32 segment = 0; segment < segments; ++segment)
+        {
+            Uint32 next = (segment + 1) % segments;
+
+            indices[i++] = (Uint16)(row + segment);
+            indices[i++] = (Uint16)(row + next);
+            indices[i++] = (Uint16)(next_row + segment);
+
+            indices[i++] = (Uint16)(row + next);
+            indices[i++] = (Uint16)(next_row + next);
+            indices[i++] = (Uint16)(next_row + segment);
+        }
+    }
+
+    Uint32 last_row = 1 + (rings - 2) * segments;
+    for (Uint32 segment = 0; segment < segments; ++segment)
+    {
+        Uint32 next = (segment + 1) % segments;
+
+        indices[i++] = (Uint16)south_pole;
+        indices[i++] = (Uint16)(last_row + segment);
+        indices[i++] = (Uint16)(last_row + next);
+    }
+
+    int result = APP_BuildMeshData(data, "Sphere", vertices, vertex_count, indices, index_count);
+
+    SDL_free(vertices);
+    SDL_free(indices);
+
+    return result;
+}
+
+int
+APP_CreateSphereMesh(struct APP_Context *ctx, struct APP_Mesh *mesh, Uint32 segments, Uint32 rings)
+{
+    struct APP_MeshData data;
+    if (APP_BuildSphereMeshData(&data, segments, rings) == -1)
+    {
+        SDL_Log("ERROR: Failed to build sphere mesh.");
+        return -1;
+    }
+
+    int result = APP_UploadMesh(ctx, mesh, &data);
+    APP_ReleaseMeshData(&data);
+
+    return result;
+}
@@ -0,0 +1,52 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include "app.h"
+#include "math.h"
+
+// CPU side of a mesh, its vertices and the index lists of all LODs back to
+// back, ready to be uploaded.
+struct APP_MeshData {
+    const char *name;
+    struct APP_PositionColorVertex *vertices;
+    Uint32 vertex_count;
+    Uint16 *lod_indices;
+    Uint32 lod_index_count;
+    float radius;
+
+    Uint32 lod_count;
+    struct APP_MeshLOD lods[APP_MAX_MESH_LODS];
+};
+
+int APP_BuildMeshData(
+        struct APP_MeshData *data,
+        const char *name,
+        const struct APP_PositionColorVertex *vertices,
+        Uint32 vertex_count,
+        const Uint16 *indices,
+        Uint32 index_count
+);
+
+void APP_ReleaseMeshData(struct APP_MeshData *data);
+int APP_UploadMesh(struct APP_Context *ctx, struct APP_Mesh *mesh, const struct APP_MeshData *data);
+
+int APP_CreateMesh(
+        struct APP_Context *ctx,
+        struct APP_Mesh *mesh,
+        const char *name,
+        const struct APP_PositionColorVertex *vertices,
+        Uint32 vertex_count,
+        const Uint16 *indices,
+        Uint32 index_count
+);
+
+void APP_ReleaseMesh(struct APP_Context *ctx, struct APP_Mesh *mesh);
+
+void APP_UpdateMeshRanges(struct APP_Context *ctx);
+void APP_BindMeshBuffers(struct APP_Context *ctx, SDL_GPURenderPass *render_pass);
+
+int APP_BuildCubeMeshData(struct APP_MeshData *data);
+int APP_BuildSphereMeshData(struct APP_MeshData *data, Uint32 segments, Uint32 rings);
+int APP_CreateSphereMesh(struct APP_Context *ctx, struct APP_Mesh *mesh, Uint32 segments, Uint32 rings);
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <SDL3/SDL.h>
+
+// A single file holding all assets of an example, built by tools/asset-pack.
+// The file is memory mapped once and the assets are found by name through a
+// hashed table of contents. Uncompressed assets are read without a copy,
+// straight from the mapping.
+//
+// Layout, all values little endian:
+//   struct APP_PackHeader
+//   struct APP_PackTocEntry[entry_count], sorted by name
+//   Uint32 buckets[bucket_count], entry index or APP_PACK_EMPTY_BUCKET,
+//     open addressing with linear probing on the name hash
+//   names, NUL terminated
+//   asset data, every asset starts at a multiple of the alignment
+
+#define APP_PACK_MAGIC SDL_FOURCC('P', 'A', 'C', 'K')
+#define APP_PACK_VERSION 1
+#define APP_PACK_EMPTY_BUCKET 0xFFFFFFFFu
+#define APP_PACK_HASH_SEED 0x5eed
+
+// The asset is compressed with the LZ block format of APP_Pack_Decompress.
+#define APP_PACK_ENTRY_COMPRESSED 0x1u
+
+struct APP_PackHeader {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 entry_count;
+    Uint32 bucket_count;
+    Uint64 toc_offset;
+    Uint64 names_offset;
+    Uint32 alignment;
+    Uint32 reserved;
+};
+
+struct APP_PackTocEntry {
+    Uint32 hash;
+    Uint32 name_offset;
+    Uint32 name_length;
+    Uint32 flags;
+    Uint64 offset;
+    // Bytes in the pack and bytes after decompression.
+    Uint64 size;
+    Uint64 raw_size;
+};
+
+SDL_COMPILE_TIME_ASSERT(pack_header_size, sizeof(struct APP_PackHeader) == 40);
+SDL_COMPILE_TIME_ASSERT(pack_toc_entry_size, sizeof(struct APP_PackTocEntry) == 40);
+
+struct APP_Pack;
+
+struct APP_PackStats {
+    Uint32 entry_count;
+    Uint64 file_size;
+    bool mapped;
+    // Reads served from the pack, without a copy and decompressed.
+    Uint32 zero_copy_reads;
+    Uint32 decompressed_reads;
+    Uint64 decompressed_bytes;
+};
+
+// NULL if the file doesn't exist or isn't a valid pack.
+struct APP_Pack *APP_Pack_Open(const char *path);
+void APP_Pack_Close(struct APP_Pack *pack);
+
+Uint32 APP_Pack_Hash(const char *name, size_t length);
+
+// Find an asset by its path relative to the example, e.g.
+// "images/default.bmp". Returns a pointer into the mapping for
+// uncompressed assets, decompressed ones go into a new buffer which is
+// returned in out_owned and released by the caller with SDL_free. NULL if
+// the pack doesn't have the asset.
+const void *APP_Pack_Read(struct APP_Pack *pack, const char *name, size_t *out_size, void **out_owned);
+
+// The asset as a read only stream, for the SDL loaders taking one.
+SDL_IOStream *APP_Pack_OpenIO(struct APP_Pack *pack, const char *name);
+
+// LZ block decompression, the format follows LZ4 blocks: a token
+// with the literal length in the high and the match length - 4 in the low
+// nibble, 255 bytes extend a length, a 16 bit match offset. Returns the
+// bytes written or 0 on corrupt input.
+size_t APP_Pack_Decompress(const Uint8 *src, size_t src_size, Uint8 *dst, size_t dst_size);
+
+void APP_Pack_GetStats(struct APP_Pack *pack, struct APP_PackStats *out_stats);
+void APP_Pack_LogStats(struct APP_Pack *pack);
+
+#endif
@@ -1,10 +1,86 @@
 #include "renderer.h"
 #include "app.h"
+#include "culling.h"
+#include "dynres.h"
+#include "gpumemory.h"
+#include "hiz.h"
+#include "lod.h"
 #include "math.h"
+#include "megabuffer.h"
+#include "mesh.h"
+#include "rendergraph.h"
+#include "scene.h"
+#include "startup.h"
 #include "utils.h"
 
-int 
-APP_InitRenderer(struct APP_Context *ctx) 
+// Initial size of the shared mesh buffers in elements, they grow on demand.
+#define MESH_VERTEX_CAPACITY (16 * 1024)
+#define MESH_INDEX_CAPACITY (64 * 1024)
+
+// Every shader the pipelines are created from, read by the device task.
+static const char *const STARTUP_SHADERS[] = {
+    "PositionColorTransform.vert",
+    "ArenaInstance.vert",
+    "CulledInstance.vert",
+    "default.frag",
+    "FrustumCull.comp",
+    "HiZBuild.comp",
+};
+
+// Device creation loads the driver and is the longest part of the startup
+// before the window exists, the shader blobs are read right after it on the
+// same thread.
+static int
+APP_DeviceTask(struct APP_Context *ctx)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    // Note(john): The device may be created on any thread, only the window
+    // calls (create, claim) have to stay on the main thread.
+    ctx->device = SDL_CreateGPUDevice(
+            SDL_GPU_SHADERFORMAT_SPIRV
+            | SDL_GPU_SHADERFORMAT_MSL
+            | SDL_GPU_SHADERFORMAT_DXIL, 
+            false, 
+            NULL
+    );
+
+    APP_Startup_AddPhase(&ctx->startup, "GPU Device", "device", start);
+
+    if (ctx->device == NULL) 
+    {
+        SDL_Log("ERROR: Failed to create device. %s", SDL_GetError());
+        return -1;
+    }
+
+    start = SDL_GetPerformanceCounter();
+    int result = APP_PreloadShaders(ctx, STARTUP_SHADERS, SDL_arraysize(STARTUP_SHADERS));
+    APP_Startup_AddPhase(&ctx->startup, "Shader I/O", "device", start);
+
+    return result;
+}
+
+// The LOD chains are the heaviest CPU work of the startup and need nothing
+// but the vertices.
+static int
+APP_MeshTask(struct APP_Context *ctx)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    int result = 0;
+    if (APP_BuildCubeMeshData(&ctx->startup_meshes[APP_MESH_CUBE]) == -1
+        || APP_BuildSphereMeshData(&ctx->startup_meshes[APP_MESH_SPHERE], 64, 32) == -1)
+    {
+        SDL_Log("ERROR: Failed to build meshes.");
+        result = -1;
+    }
+
+    APP_Startup_AddPhase(&ctx->startup, "Mesh LODs", "meshes", start);
+    return result;
+}
+
+static int
+APP_CreateScenePipelines(struct APP_Context *ctx)
 {
     SDL_GPUShader *vertex_shader = APP_LoadShader(ctx, "PositionColorTransform.vert", 0, 1, 0, 0);
     if (vertex_shader == NULL) 
@@ -28,136 +104,297 @@ APP_InitRenderer(struct APP_Context *ctx)
     }
 
     SDL_ReleaseGPUShader(ctx->device, vertex_shader);
+
+    SDL_GPUShader *arena_vertex_shader = APP_LoadShader(ctx, "ArenaInstance.vert", 0, 1, 1, 0);
+    if (arena_vertex_shader == NULL) 
+    {
+        SDL_Log("ERROR: Failed to create 'ArenaInstance' vertex shader.");
+        return -1;
+    }
+
+    ctx->arena_pipeline = APP_CreateGraphicsPipeline(ctx, arena_vertex_shader, frag_shader);
+    if (ctx->arena_pipeline == NULL) 
+    {
+        SDL_Log("ERROR: Failed to create arena graphics pipeline. %s", SDL_GetError());
+        return -1;
+    }
+
+    SDL_ReleaseGPUShader(ctx->device, arena_vertex_shader);
     SDL_ReleaseGPUShader(ctx->device, frag_shader);
 
-    ctx->scene_vertex_buffer = APP_CreateVertexBuffer(ctx);
-    ctx->scene_index_buffer = APP_CreateIndexBuffer(ctx);
+    return 0;
+}
 
-    APP_CreateAndSubmitCube(ctx);
+// Pipeline creation compiles the shaders for the driver. It runs in the
+// background while the main thread creates the buffers, uploads the meshes
+// and builds the scene, the first frame waits for it.
+static int
+APP_PipelineTask(struct APP_Context *ctx)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    // Note(john): Resources may be created from several threads at once,
+    // only a command buffer is bound to the thread that acquired it. All
+    // command buffers of the startup are recorded on the main thread.
+    int result = 0;
+    if (APP_CreateScenePipelines(ctx) == -1
+        || APP_CreateCullPipelines(ctx) == -1
+        || APP_DepthPyramid_CreatePipeline(ctx, ctx->depth_pyramid) == -1)
+    {
+        result = -1;
+    }
 
-    ctx->time = 0;
+    APP_ReleaseShaderBlobs(ctx);
+
+    APP_Startup_AddPhase(&ctx->startup, "Pipelines", "pipelines", start);
+    return result;
+}
+
+// Start the work that doesn't need the window: the device (plus the shader
+// blobs) and the meshes. The main thread creates the window meanwhile.
+int
+APP_StartRenderer(struct APP_Context *ctx)
+{
+    ctx->startup_meshes = SDL_calloc(APP_MESH_COUNT, sizeof(struct APP_MeshData));
+    if (ctx->startup_meshes == NULL)
+    {
+        return -1;
+    }
+
+    if (!APP_Startup_StartTask(ctx, &ctx->startup_tasks[APP_STARTUP_TASK_DEVICE], "device", APP_DeviceTask)
+        || !APP_Startup_StartTask(ctx, &ctx->startup_tasks[APP_STARTUP_TASK_MESHES], "meshes", APP_MeshTask))
+    {
+        return -1;
+    }
 
     return 0;
 }
 
-void 
-APP_CreateAndSubmitCube(struct APP_Context *ctx) 
+int
+APP_WaitForDevice(struct APP_Context *ctx)
 {
-    SDL_GPUTransferBufferCreateInfo transfer_buffer_create_info = {
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = (sizeof(struct APP_PositionColorVertex) * 24) + (sizeof(Uint16) * 36)
-    };
+    return APP_Startup_WaitTask(ctx, &ctx->startup_tasks[APP_STARTUP_TASK_DEVICE]);
+}
 
-    SDL_GPUTransferBuffer *transfer_buffer = SDL_CreateGPUTransferBuffer(
-            ctx->device, 
-            &transfer_buffer_create_info
-            );
-
-    struct APP_PositionColorVertex *transfer_data = SDL_MapGPUTransferBuffer(
-            ctx->device, 
-            transfer_buffer, 
-            false
-            );
-
-    transfer_data[0] = (struct APP_PositionColorVertex){-10, -10, -10, 255, 0, 0, 255};
-    transfer_data[1] = (struct APP_PositionColorVertex){10, -10, -10, 255, 0, 0, 255};
-    transfer_data[2] = (struct APP_PositionColorVertex){10, 10, -10, 255, 0, 0, 255};
-    transfer_data[3] = (struct APP_PositionColorVertex){-10, 10, -10, 255, 0, 0, 255};
-
-    transfer_data[4] = (struct APP_PositionColorVertex){-10, -10, 10, 255, 0, 0, 255};
-    transfer_data[5] = (struct APP_PositionColorVertex){10, -10, 10, 255, 0, 0, 255};
-    transfer_data[6] = (struct APP_PositionColorVertex){10, 10, 10, 255, 0, 0, 255};
-    transfer_data[7] = (struct APP_PositionColorVertex){-10, 10, 10, 255, 0, 0, 255};
-
-    transfer_data[8] = (struct APP_PositionColorVertex){-10, -10, -10, 255, 0, 0, 255};
-    transfer_data[9] = (struct APP_PositionColorVertex){-10, 10, -10, 255, 0, 0, 255};
-    transfer_data[10] = (struct APP_PositionColorVertex){-10, 10, 10, 255, 0, 0, 255};
-    transfer_data[11] = (struct APP_PositionColorVertex){-10, -10, 10, 255, 0, 0, 255};
-
-    transfer_data[12] = (struct APP_PositionColorVertex){10, -10, -10, 0, 255, 0, 255};
-    transfer_data[13] = (struct APP_PositionColorVertex){10, 10, -10, 0, 255, 0, 255};
-    transfer_data[14] = (struct APP_PositionColorVertex){10, 10, 10, 0, 255, 0, 255};
-    transfer_data[15] = (struct APP_PositionColorVertex){10, -10, 10, 0, 255, 0, 255};
-
-    transfer_data[16] = (struct APP_PositionColorVertex){-10, -10, -10, 255, 0, 0, 255};
-    transfer_data[17] = (struct APP_PositionColorVertex){-10, -10, 10, 255, 0, 0, 255};
-    transfer_data[18] = (struct APP_PositionColorVertex){10, -10, 10, 255, 0, 0, 255};
-    transfer_data[19] = (struct APP_PositionColorVertex){10, -10, -10, 255, 0, 0, 255};
-
-    transfer_data[20] = (struct APP_PositionColorVertex){-10, 10, -10, 255, 0, 0, 255};
-    transfer_data[21] = (struct APP_PositionColorVertex){-10, 10, 10, 255, 0, 0, 255};
-    transfer_data[22] = (struct APP_PositionColorVertex){10, 10, 10, 255, 0, 0, 255};
-    transfer_data[23] = (struct APP_PositionColorVertex){10, 10, -10, 255, 0, 0, 255};
-
-    Uint16 *index_data = (Uint16 *)&transfer_data[24];
-    Uint16 indices[] = {
-        0,  1,  2,  0,  2,  3,  
-        4,  5,  6,  4,  6,  7, 
-        8,  9,  10, 8,  10, 11, 
-        12, 13, 14, 12, 14, 15, 
-        16, 17, 18, 16, 18, 19, 
-        20, 21, 22, 20, 22, 23
-    };
+// Called by the first frame, every frame after it finds the task joined.
+int
+APP_WaitForPipelines(struct APP_Context *ctx)
+{
+    struct APP_StartupTask *task = &ctx->startup_tasks[APP_STARTUP_TASK_PIPELINES];
+    if (!task->started)
+    {
+        return 0;
+    }
 
-    SDL_memcpy(index_data, indices, sizeof(indices));
+    int result = APP_Startup_WaitTask(ctx, task);
+    task->started = false;
 
-    SDL_UnmapGPUTransferBuffer(ctx->device, transfer_buffer);
-    SDL_GPUCommandBuffer *upload_cmd_buffer = SDL_AcquireGPUCommandBuffer(ctx->device);
-    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(upload_cmd_buffer);
+    return result;
+}
 
-    SDL_UploadToGPUBuffer(
-            copy_pass,
-            &(SDL_GPUTransferBufferLocation){
-                .transfer_buffer = transfer_buffer,
-                .offset = 0
-            },
-            &(SDL_GPUBufferRegion){
-                .buffer = ctx->scene_vertex_buffer,
-                .offset = 0,
-                .size = sizeof(struct APP_PositionColorVertex) * 24
-            },
-            false
+// A hard budget: the allocation fails and the caller takes its error path.
+// The report shows what filled the budget.
+static bool
+APP_OnGPUMemoryOverBudget(
+        const struct APP_GPUAllocation *request,
+        const struct APP_GPUMemoryStats *stats,
+        void *user_data
+)
+{
+    struct APP_Context *ctx = user_data;
+
+    SDL_Log(
+            "ERROR: '%s' (%s, %llu bytes) exceeds the GPU memory budget of %llu bytes, %llu bytes are live.",
+            request->name,
+            APP_GPUMemory_CategoryName(request->category),
+            (unsigned long long)request->size,
+            (unsigned long long)stats->budget_bytes,
+            (unsigned long long)stats->live_bytes
     );
 
-    SDL_UploadToGPUBuffer(
-            copy_pass,
-            &(SDL_GPUTransferBufferLocation){
-                .transfer_buffer = transfer_buffer,
-                .offset = sizeof(struct APP_PositionColorVertex) * 24
-                },
-            &(SDL_GPUBufferRegion){
-                .buffer = ctx->scene_index_buffer,
-                .offset = 0,
-                .size = sizeof(Uint16) * 36
-            },
-            false
+    APP_GPUMemory_LogReport(ctx->gpu_memory);
+    return false;
+}
+
+// Needs the device and the claimed window, the swapchain format goes into
+// the pipelines.
+int 
+APP_InitRenderer(struct APP_Context *ctx) 
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    APP_SelectDepthFormat(ctx);
+
+    // Note(john): Every buffer, texture and transfer buffer is created
+    // through the registry, so it knows all bytes that are alive.
+    ctx->gpu_memory = APP_GPUMemory_Create(ctx->device);
+    if (ctx->gpu_memory == NULL)
+    {
+        SDL_Log("ERROR: Failed to create GPU memory registry.");
+        return -1;
+    }
+
+    if (ctx->gpu_memory_budget > 0)
+    {
+        APP_GPUMemory_SetBudget(ctx->gpu_memory, ctx->gpu_memory_budget, APP_OnGPUMemoryOverBudget, ctx);
+    }
+
+    ctx->render_graph = APP_RenderGraph_Create(ctx->device, ctx->gpu_memory);
+    if (ctx->render_graph == NULL)
+    {
+        SDL_Log("ERROR: Failed to create render graph.");
+        return -1;
+    }
+
+    ctx->depth_pyramid = APP_DepthPyramid_Create(ctx);
+    if (ctx->depth_pyramid == NULL)
+    {
+        SDL_Log("ERROR: Failed to create depth pyramid.");
+        return -1;
+    }
+
+    if (!APP_Startup_StartTask(ctx, &ctx->startup_tasks[APP_STARTUP_TASK_PIPELINES], "pipelines", APP_PipelineTask))
+    {
+        SDL_Log("ERROR: Failed to create pipelines.");
+        return -1;
+    }
+
+    ctx->mesh_vertex_buffer = APP_MegaBuffer_Create(
+            ctx->gpu_memory,
+            "Mesh Vertices",
+            SDL_GPU_BUFFERUSAGE_VERTEX,
+            sizeof(struct APP_PositionColorVertex),
+            MESH_VERTEX_CAPACITY
     );
 
-    SDL_EndGPUCopyPass(copy_pass);
-    SDL_SubmitGPUCommandBuffer(upload_cmd_buffer);
-    SDL_ReleaseGPUTransferBuffer(ctx->device, transfer_buffer);
+    ctx->mesh_index_buffer = APP_MegaBuffer_Create(
+            ctx->gpu_memory,
+            "Mesh Indices",
+            SDL_GPU_BUFFERUSAGE_INDEX,
+            sizeof(Uint16),
+            MESH_INDEX_CAPACITY
+    );
+
+    if (ctx->mesh_vertex_buffer == NULL || ctx->mesh_index_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create mesh buffers.");
+        return -1;
+    }
+
+    APP_Startup_AddPhase(&ctx->startup, "Renderer Setup", "main", start);
+
+    if (APP_Startup_WaitTask(ctx, &ctx->startup_tasks[APP_STARTUP_TASK_MESHES]) == -1)
+    {
+        SDL_Log("ERROR: Failed to create meshes.");
+        return -1;
+    }
+
+    start = SDL_GetPerformanceCounter();
+
+    for (Uint32 i = 0; i < APP_MESH_COUNT; ++i)
+    {
+        int result = APP_UploadMesh(ctx, &ctx->meshes[i], &ctx->startup_meshes[i]);
+        APP_ReleaseMeshData(&ctx->startup_meshes[i]);
+
+        if (result == -1)
+        {
+            SDL_Log("ERROR: Failed to create meshes.");
+            return -1;
+        }
+    }
+
+    SDL_free(ctx->startup_meshes);
+    ctx->startup_meshes = NULL;
+
+    APP_MegaBuffer_LogStats(ctx->mesh_vertex_buffer);
+    APP_MegaBuffer_LogStats(ctx->mesh_index_buffer);
+
+    if (APP_InitGPUCulling(ctx) == -1)
+    {
+        SDL_Log("ERROR: Failed to init gpu culling.");
+        return -1;
+    }
+
+    if (!ctx->depth_sampleable && ctx->occlusion_culling)
+    {
+        SDL_Log("INFO: Depth format can't be sampled, occlusion culling is disabled.");
+        ctx->occlusion_culling = false;
+    }
+
+    ctx->time = 0;
+
+    APP_Startup_AddPhase(&ctx->startup, "Mesh Upload", "main", start);
+
+    return 0;
 }
 
-SDL_GPUBuffer*
-APP_CreateVertexBuffer(struct APP_Context *ctx) 
+// Recreate the sphere with another resolution. Its old ranges are freed and
+// the new ones are taken from the free blocks of the mesh buffers, which is
+// what fragments them over time.
+int
+APP_RebuildSphereMesh(struct APP_Context *ctx, Uint32 segments, Uint32 rings)
 {
-    SDL_GPUBufferCreateInfo buffer_create_info = {
-        .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
-        .size = sizeof(struct APP_PositionColorVertex) * 24
-    };
+    APP_ReleaseMesh(ctx, &ctx->meshes[APP_MESH_SPHERE]);
+
+    if (APP_CreateSphereMesh(ctx, &ctx->meshes[APP_MESH_SPHERE], segments, rings) == -1)
+    {
+        SDL_Log("ERROR: Failed to rebuild sphere mesh.");
+        return -1;
+    }
+
+    APP_WriteDrawCommandResets(ctx);
+
+    APP_MegaBuffer_LogStats(ctx->mesh_vertex_buffer);
+    APP_MegaBuffer_LogStats(ctx->mesh_index_buffer);
 
-    return SDL_CreateGPUBuffer(ctx->device, &buffer_create_info);
+    return 0;
 }
 
-SDL_GPUBuffer*
-APP_CreateIndexBuffer(struct APP_Context *ctx) 
+// Move all mesh ranges to the start of the mesh buffers and refresh the
+// offsets baked into the meshes and the indirect draw commands. The offsets
+// are refreshed even if one buffer failed, the other one may have moved.
+int
+APP_CompactMeshBuffers(struct APP_Context *ctx)
 {
-    SDL_GPUBufferCreateInfo buffer_create_info = {
-        .usage = SDL_GPU_BUFFERUSAGE_INDEX, 
-        .size = sizeof(Uint16) * 36
-    };
+    bool vertices_compacted = APP_MegaBuffer_Compact(ctx->device, ctx->mesh_vertex_buffer);
+    bool indices_compacted = APP_MegaBuffer_Compact(ctx->device, ctx->mesh_index_buffer);
+
+    APP_UpdateMeshRanges(ctx);
+    APP_WriteDrawCommandResets(ctx);
 
-    return SDL_CreateGPUBuffer(ctx->device, &buffer_create_info);
+    if (!vertices_compacted || !indices_compacted)
+    {
+        SDL_Log("ERROR: Failed to compact mesh buffers.");
+        return -1;
+    }
+
+    APP_MegaBuffer_LogStats(ctx->mesh_vertex_buffer);
+    APP_MegaBuffer_LogStats(ctx->mesh_index_buffer);
+
+    return 0;
+}
+
+// The depth target is a transient texture of the render graph, only its
+// format has to be known up front for the pipelines.
+void
+APP_SelectDepthFormat(struct APP_Context *ctx)
+{
+    ctx->depth_format = SDL_GPU_TEXTUREFORMAT_D24_UNORM;
+    if (SDL_GPUTextureSupportsFormat(
+                ctx->device,
+                SDL_GPU_TEXTUREFORMAT_D32_FLOAT,
+                SDL_GPU_TEXTURETYPE_2D,
+                SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET))
+    {
+        ctx->depth_format = SDL_GPU_TEXTUREFORMAT_D32_FLOAT;
+    }
+
+    ctx->depth_sampleable = SDL_GPUTextureSupportsFormat(
+            ctx->device,
+            ctx->depth_format,
+            SDL_GPU_TEXTURETYPE_2D,
+            SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER
+    );
 }
 
 SDL_GPUGraphicsPipeline*
@@ -176,6 +413,13 @@ APP_CreateGraphicsPipeline(
                         .format = SDL_GetGPUSwapchainTextureFormat(ctx->device, ctx->window)
                     }
                 },
+            .has_depth_stencil_target = true,
+            .depth_stencil_format = ctx->depth_format,
+        },
+        .depth_stencil_state = (SDL_GPUDepthStencilState) {
+            .compare_op = SDL_GPU_COMPAREOP_LESS,
+            .enable_depth_test = true,
+            .enable_depth_write = true,
         },
         .rasterizer_state = (SDL_GPURasterizerState) {
             .cull_mode = SDL_GPU_CULLMODE_NONE,
@@ -202,7 +446,7 @@ APP_CreateGraphicsPipeline(
                 },
                 {
                     .buffer_slot = 0,
-                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM,
                     .location = 1,
                     .offset = sizeof(float) * 3
                 }
@@ -216,6 +460,217 @@ APP_CreateGraphicsPipeline(
     return SDL_CreateGPUGraphicsPipeline(ctx->device, &pipeline_create_info);
 }
 
+// Everything the passes of a frame need.
+struct APP_FrameData {
+    struct APP_Context *ctx;
+    struct APP_Camera camera;
+    float near_plane, far_plane;
+    // Swapchain size.
+    Uint32 width, height;
+    // The scene targets are allocated for the highest scale, the scene is
+    // rendered into the top left render_width x render_height of them.
+    Uint32 target_width, target_height;
+    Uint32 render_width, render_height;
+
+    Uint32 scene_color;
+    Uint32 scene_depth;
+    Uint32 backbuffer;
+};
+
+static void
+APP_CullPass(const struct APP_RGPassContext *pass, void *user_data)
+{
+    struct APP_FrameData *frame = user_data;
+    APP_CullSceneOnGPU(frame->ctx, pass->cmd_buffer, &frame->camera);
+}
+
+static void
+APP_ObjectUploadPass(const struct APP_RGPassContext *pass, void *user_data)
+{
+    struct APP_FrameData *frame = user_data;
+    APP_PrepareSceneArena(frame->ctx, pass->cmd_buffer, &frame->camera);
+}
+
+static void
+APP_ScenePass(const struct APP_RGPassContext *pass, void *user_data)
+{
+    struct APP_FrameData *frame = user_data;
+
+    SDL_SetGPUViewport(
+            pass->render_pass,
+            &(SDL_GPUViewport){
+                .x = 0,
+                .y = 0,
+                .w = (float)frame->render_width,
+                .h = (float)frame->render_height,
+                .min_depth = 0.0f,
+                .max_depth = 1.0f
+            }
+    );
+
+    SDL_SetGPUScissor(
+            pass->render_pass, 
+            &(SDL_Rect){ 0, 0, (int)frame->render_width, (int)frame->render_height }
+    );
+
+    SDL_PushGPUFragmentUniformData(pass->cmd_buffer, 0, (float[]) { frame->near_plane, frame->far_plane }, 8);
+
+    if (frame->ctx->gpu_culling)
+    {
+        APP_DrawSceneIndirect(frame->ctx, pass->cmd_buffer, pass->render_pass, &frame->camera);
+    }
+    else if (frame->ctx->uniform_arena)
+    {
+        APP_DrawSceneArena(frame->ctx, pass->cmd_buffer, pass->render_pass);
+    }
+    else
+    {
+        APP_DrawSceneCPU(frame->ctx, pass->cmd_buffer, pass->render_pass, &frame->camera);
+    }
+}
+
+static void
+APP_DepthPyramidPass(const struct APP_RGPassContext *pass, void *user_data)
+{
+    struct APP_FrameData *frame = user_data;
+
+    APP_DepthPyramid_Build(
+            frame->ctx,
+            frame->ctx->depth_pyramid,
+            pass->cmd_buffer,
+            APP_RenderGraph_GetTexture(pass->graph, frame->scene_depth),
+            &frame->camera.view_proj
+    );
+}
+
+// Upscale the rendered part of the scene color to the backbuffer, bilinear
+// if the sizes differ.
+static void
+APP_PresentPass(const struct APP_RGPassContext *pass, void *user_data)
+{
+    struct APP_FrameData *frame = user_data;
+    bool scaled = frame->render_width != frame->width || frame->render_height != frame->height;
+
+    SDL_BlitGPUTexture(
+            pass->cmd_buffer,
+            &(SDL_GPUBlitInfo){
+                .source = {
+                    .texture = APP_RenderGraph_GetTexture(pass->graph, frame->scene_color),
+                    .w = frame->render_width,
+                    .h = frame->render_height,
+                },
+                .destination = {
+                    .texture = APP_RenderGraph_GetTexture(pass->graph, frame->backbuffer),
+                    .w = frame->width,
+                    .h = frame->height,
+                },
+                .load_op = SDL_GPU_LOADOP_DONT_CARE,
+                .filter = scaled ? SDL_GPU_FILTER_LINEAR : SDL_GPU_FILTER_NEAREST,
+            }
+    );
+}
+
+// Declare the passes of the frame. The graph works out the order, drops
+// the GPU culling or object upload pass when nothing reads what they write
+// and picks the load and store ops of the targets.
+static void
+APP_BuildFrameGraph(struct APP_Context *ctx, struct APP_FrameData *frame, SDL_GPUTexture *swapchain_texture)
+{
+    struct APP_RenderGraph *graph = ctx->render_graph;
+
+    APP_RenderGraph_Begin(graph);
+
+    frame->backbuffer = APP_RenderGraph_ImportTexture(
+            graph,
+            &(struct APP_RGTextureDesc){
+                .name = "Backbuffer",
+                .width = frame->width,
+                .height = frame->height,
+                .format = SDL_GetGPUSwapchainTextureFormat(ctx->device, ctx->window),
+            },
+            swapchain_texture
+    );
+
+    Uint32 draw_commands = APP_RenderGraph_ImportBuffer(graph, "DrawCommands", ctx->draw_command_buffer);
+    Uint32 scene_objects = APP_RenderGraph_ImportBuffer(graph, "SceneObjects", ctx->scene_object_buffer);
+    Uint32 visible_objects = APP_RenderGraph_ImportBuffer(graph, "VisibleObjects", ctx->visible_object_buffer);
+    Uint32 lod_state = APP_RenderGraph_ImportBuffer(graph, "LODState", ctx->lod_state_buffer);
+    Uint32 depth_pyramid = APP_RenderGraph_ImportBuffer(graph, "DepthPyramid", ctx->depth_pyramid->buffer);
+    Uint32 object_arena = APP_RenderGraph_ImportBuffer(graph, "ObjectArena", ctx->object_arena.buffer);
+    Uint32 mesh_vertices = APP_RenderGraph_ImportBuffer(graph, "MeshVertices", ctx->mesh_vertex_buffer->buffer);
+    Uint32 mesh_indices = APP_RenderGraph_ImportBuffer(graph, "MeshIndices", ctx->mesh_index_buffer->buffer);
+
+    frame->scene_color = APP_RenderGraph_CreateTexture(
+            graph,
+            &(struct APP_RGTextureDesc){
+                .name = "SceneColor",
+                .width = frame->target_width,
+                .height = frame->target_height,
+                .format = SDL_GetGPUSwapchainTextureFormat(ctx->device, ctx->window),
+                .clear = true,
+                .clear_color = { 0.0f, 0.0f, 0.0f, 0.0f },
+            }
+    );
+
+    frame->scene_depth = APP_RenderGraph_CreateTexture(
+            graph,
+            &(struct APP_RGTextureDesc){
+                .name = "SceneDepth",
+                .width = frame->target_width,
+                .height = frame->target_height,
+                .format = ctx->depth_format,
+                .clear = true,
+                .clear_depth = 1.0f,
+            }
+    );
+
+    // Note(john): The cull pass tests against the pyramid of the last frame,
+    // so it runs before this frame's pyramid is built.
+    Uint32 cull_pass = APP_RenderGraph_AddPass(graph, "GPU Cull", APP_CullPass, frame);
+    APP_RenderGraph_Read(graph, cull_pass, scene_objects);
+    APP_RenderGraph_ReadPrevious(graph, cull_pass, depth_pyramid);
+    APP_RenderGraph_Write(graph, cull_pass, draw_commands);
+    APP_RenderGraph_Write(graph, cull_pass, visible_objects);
+    APP_RenderGraph_Write(graph, cull_pass, lod_state);
+
+    Uint32 upload_pass = APP_RenderGraph_AddPass(graph, "Object Upload", APP_ObjectUploadPass, frame);
+    APP_RenderGraph_Write(graph, upload_pass, object_arena);
+
+    Uint32 scene_pass = APP_RenderGraph_AddPass(graph, "Scene", APP_ScenePass, frame);
+    APP_RenderGraph_SetColorTarget(graph, scene_pass, frame->scene_color);
+    APP_RenderGraph_SetDepthTarget(graph, scene_pass, frame->scene_depth);
+    APP_RenderGraph_Read(graph, scene_pass, mesh_vertices);
+    APP_RenderGraph_Read(graph, scene_pass, mesh_indices);
+
+    if (ctx->gpu_culling)
+    {
+        APP_RenderGraph_Read(graph, scene_pass, draw_commands);
+        APP_RenderGraph_Read(graph, scene_pass, visible_objects);
+        APP_RenderGraph_Read(graph, scene_pass, scene_objects);
+    }
+    else if (ctx->uniform_arena)
+    {
+        APP_RenderGraph_Read(graph, scene_pass, object_arena);
+    }
+
+    // The pyramid pass is a side effect since only the next frame uses it.
+    if (ctx->gpu_culling && ctx->occlusion_culling)
+    {
+        Uint32 pyramid_pass = APP_RenderGraph_AddPass(graph, "Depth Pyramid", APP_DepthPyramidPass, frame);
+        APP_RenderGraph_Read(graph, pyramid_pass, frame->scene_depth);
+        APP_RenderGraph_Write(graph, pyramid_pass, depth_pyramid);
+        APP_RenderGraph_SetSideEffect(graph, pyramid_pass);
+    }
+    else
+    {
+        ctx->depth_pyramid->valid = false;
+    }
+
+    Uint32 present_pass = APP_RenderGraph_AddPass(graph, "Present", APP_PresentPass, frame);
+    APP_RenderGraph_Read(graph, present_pass, frame->scene_color);
+    APP_RenderGraph_Write(graph, present_pass, frame->backbuffer);
+}
+
 int 
 APP_Draw(struct APP_Context *ctx) 
 {
@@ -227,67 +682,106 @@ APP_Draw(struct APP_Context *ctx)
     }
 
     SDL_GPUTexture *swapchain_texture;
-    if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmd_buffer, ctx->window, &swapchain_texture, NULL, NULL)) 
+    Uint32 width, height;
+    if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmd_buffer, ctx->window, &swapchain_texture, &width, &height)) 
     {
         SDL_Log("ERROR: Failed to acquire swapchain texture. %s", SDL_GetError());
         return -1;
     }
 
+    Uint64 now = SDL_GetPerformanceCounter();
+    float frame_ms = ctx->last_frame_counter != 0
+        ? (float)((double)(now - ctx->last_frame_counter) * 1000.0 / (double)SDL_GetPerformanceFrequency())
+        : 0.0f;
+    ctx->last_frame_counter = now;
+
     if (swapchain_texture != NULL) {
-        float near_plane = 20.0f;
-        float far_plane = 60.0f;
+        struct APP_DynamicResolution *dynres = &ctx->dynamic_resolution;
+        if (frame_ms > 0.0f && !ctx->benchmark.enabled)
+        {
+            APP_DynamicResolution_Update(dynres, frame_ms);
+        }
+
+        struct APP_FrameData frame = { 0 };
+        frame.ctx = ctx;
+        frame.near_plane = 20.0f;
+        frame.far_plane = 60.0f;
+        frame.width = width;
+        frame.height = height;
+
+        APP_DynamicResolution_GetSize(
+                dynres->enabled ? dynres->max_scale : 1.0f, 
+                width, 
+                height, 
+                &frame.target_width, 
+                &frame.target_height
+        );
+        APP_DynamicResolution_GetSize(
+                dynres->enabled ? dynres->scale : 1.0f, 
+                width, 
+                height, 
+                &frame.render_width, 
+                &frame.render_height
+        );
+
+        // Note(john): Rounding may push the render size past the targets by a
+        // pixel when the scale is the highest one.
+        frame.render_width = SDL_min(frame.render_width, frame.target_width);
+        frame.render_height = SDL_min(frame.render_height, frame.target_height);
+
+        ctx->render_width = frame.render_width;
+        ctx->render_height = frame.render_height;
+
+        float field_of_view = 75.0f * SDL_PI_F / 180.0f;
 
         struct APP_Matrix4x4 proj = APP_Matrix4x4_CreatePerspectiveFieldOfView(
-                75.0f * SDL_PI_F / 180.0f, 600 / (float)400, 
-                near_plane, 
-                far_plane
+                field_of_view, 
+                (float)width / (float)height, 
+                frame.near_plane, 
+                frame.far_plane
         );
 
+        struct APP_Camera *camera = &frame.camera;
+        camera->position = (struct APP_Vector3) { SDL_cosf(ctx->time) * 30, 30, SDL_sinf(ctx->time) * 30 };
+
         struct APP_Matrix4x4 view = APP_Matrix4x4_CreateLookAt(
-                (struct APP_Vector3) { SDL_cosf(ctx->time) * 30, 30, SDL_sinf(ctx->time) * 30 },
+                camera->position,
                 (struct APP_Vector3) { 0, 0, 0 },
                 (struct APP_Vector3) { 0, 2, 0 }
         );
 
-        struct APP_Matrix4x4 view_proj = APP_Matrix4x4_Mutliply(view, proj);
-
-        SDL_GPUColorTargetInfo color_target_info = { 0 };
-        color_target_info.texture = swapchain_texture;
-        color_target_info.clear_color = (SDL_FColor) { 0.0f, 0.0f, 0.0f, 0.0f };
-        color_target_info.load_op = SDL_GPU_LOADOP_CLEAR;
-        color_target_info.store_op = SDL_GPU_STOREOP_STORE;
+        camera->view_proj = APP_Matrix4x4_Mutliply(view, proj);
+        camera->frustum = APP_Frustum_FromMatrix(camera->view_proj);
+        APP_LODSelector_Init(&camera->lod_selector, field_of_view, (float)frame.render_height);
 
-        SDL_PushGPUVertexUniformData(cmd_buffer, 0, &view_proj, sizeof(view_proj));
-        SDL_PushGPUFragmentUniformData(cmd_buffer, 0, (float[]) { near_plane, far_plane}, 8);
+        if (ctx->occlusion_culling
+            && APP_DepthPyramid_Resize(ctx, ctx->depth_pyramid, frame.render_width, frame.render_height) == -1)
+        {
+            SDL_Log("ERROR: Failed to resize depth pyramid, occlusion culling is disabled.");
+            ctx->occlusion_culling = false;
+        }
 
-        SDL_GPURenderPass *render_pass = SDL_BeginGPURenderPass(cmd_buffer, &color_target_info, 1, NULL);
-        SDL_BindGPUGraphicsPipeline(render_pass, ctx->pipeline);
+        Uint64 record_start = SDL_GetPerformanceCounter();
 
-        SDL_BindGPUVertexBuffers(
-                render_pass, 
-                0, 
-                &(SDL_GPUBufferBinding){
-                    .buffer = ctx->scene_vertex_buffer, 
-                    .offset = 0 
-                }, 
-                1
-        );
+        APP_BuildFrameGraph(ctx, &frame, swapchain_texture);
 
-        SDL_BindGPUIndexBuffer(
-                render_pass, 
-                &(SDL_GPUBufferBinding){ 
-                    .buffer = ctx->scene_index_buffer, 
-                    .offset = 0 
-                }, 
-                SDL_GPU_INDEXELEMENTSIZE_16BIT
-        );
+        if (APP_RenderGraph_Compile(ctx->render_graph))
+        {
+            if (ctx->dump_render_graph)
+            {
+                APP_RenderGraph_Dump(ctx->render_graph);
+                ctx->dump_render_graph = false;
+            }
 
+            APP_RenderGraph_Execute(ctx->render_graph, cmd_buffer);
+        }
 
-        SDL_DrawGPUIndexedPrimitives(render_pass, 36, 1, 0, 0, 0);
-        SDL_EndGPURenderPass(render_pass);
+        ctx->stats.record_ticks += SDL_GetPerformanceCounter() - record_start;
+        ctx->stats.frames++;
     }
 
     SDL_SubmitGPUCommandBuffer(cmd_buffer);
+    APP_GPUMemory_EndFrame(ctx->gpu_memory);
 
     return 0;
 }
@@ -4,9 +4,7 @@
 #include "app.h"
 #include "math.h"
 
-SDL_GPUBuffer* APP_CreateVertexBuffer(struct APP_Context *ctx);
-SDL_GPUBuffer* APP_CreateIndexBuffer(struct APP_Context *ctx);
-void APP_CreateAndSubmitCube(struct APP_Context *ctx);
+void APP_SelectDepthFormat(struct APP_Context *ctx);
 
 SDL_GPUGraphicsPipeline* APP_CreateGraphicsPipeline(
     struct APP_Context *ctx,
@@ -14,7 +12,13 @@ SDL_GPUGraphicsPipeline* APP_CreateGraphicsPipeline(
     SDL_GPUShader *fragment_shader
 );
 
+int APP_StartRenderer(struct APP_Context *ctx);
+int APP_WaitForDevice(struct APP_Context *ctx);
 int APP_InitRenderer(struct APP_Context *ctx);
+int APP_WaitForPipelines(struct APP_Context *ctx);
 int APP_Draw(struct APP_Context *ctx);
 
+int APP_RebuildSphereMesh(struct APP_Context *ctx, Uint32 segments, Uint32 rings);
+int APP_CompactMeshBuffers(struct APP_Context *ctx);
+
 #endif
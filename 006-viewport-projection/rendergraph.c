@@ -0,0 +1,927 @@
+#include "rendergraph.h"
+#include "gpumemory.h"
+
+static bool
+APP_RGIsWrite(enum APP_RGAccessType type)
+{
+    return type != APP_RG_ACCESS_READ && type != APP_RG_ACCESS_READ_PREVIOUS;
+}
+
+static bool
+APP_RGPassAccesses(const struct APP_RGPass *pass, Uint32 resource, bool write)
+{
+    for (Uint32 i = 0; i < pass->access_count; ++i)
+    {
+        const struct APP_RGAccess *access = &pass->accesses[i];
+        if (access->resource == resource 
+            && access->type != APP_RG_ACCESS_READ_PREVIOUS
+            && (!write || APP_RGIsWrite(access->type)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool
+APP_RGPassReadsPrevious(const struct APP_RGPass *pass, Uint32 resource)
+{
+    for (Uint32 i = 0; i < pass->access_count; ++i)
+    {
+        if (pass->accesses[i].resource == resource && pass->accesses[i].type == APP_RG_ACCESS_READ_PREVIOUS)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static Uint64
+APP_RGTextureBytes(SDL_GPUTextureFormat format, Uint32 width, Uint32 height, Uint32 num_levels)
+{
+    Uint64 bytes = 0;
+
+    for (Uint32 level = 0; level < num_levels; ++level)
+    {
+        bytes += SDL_CalculateGPUTextureFormatSize(format, SDL_max(width >> level, 1), SDL_max(height >> level, 1), 1);
+    }
+
+    return bytes;
+}
+
+static Uint64
+APP_RGDescBytes(const struct APP_RGTextureDesc *desc)
+{
+    return APP_RGTextureBytes(desc->format, desc->width, desc->height, desc->num_levels);
+}
+
+static Uint32
+APP_RGSizeClass(Uint32 size)
+{
+    return (size + APP_RG_SIZE_CLASS - 1) / APP_RG_SIZE_CLASS * APP_RG_SIZE_CLASS;
+}
+
+static const char*
+APP_RGLoadOpName(SDL_GPULoadOp op)
+{
+    switch (op)
+    {
+        case SDL_GPU_LOADOP_LOAD: return "load";
+        case SDL_GPU_LOADOP_CLEAR: return "clear";
+        default: return "dont care";
+    }
+}
+
+static const char*
+APP_RGStoreOpName(SDL_GPUStoreOp op)
+{
+    return op == SDL_GPU_STOREOP_STORE ? "store" : "dont care";
+}
+
+struct APP_RenderGraph*
+APP_RenderGraph_Create(SDL_GPUDevice *device, struct APP_GPUMemory *memory)
+{
+    struct APP_RenderGraph *graph = SDL_calloc(1, sizeof(struct APP_RenderGraph));
+    if (graph == NULL)
+    {
+        return NULL;
+    }
+
+    graph->device = device;
+    graph->memory = memory;
+    return graph;
+}
+
+void
+APP_RenderGraph_Destroy(struct APP_RenderGraph *graph)
+{
+    if (graph == NULL)
+    {
+        return;
+    }
+
+    for (Uint32 i = 0; i < graph->pool_count; ++i)
+    {
+        APP_GPUMemory_ReleaseTexture(graph->memory, graph->pool[i].texture);
+    }
+
+    SDL_free(graph);
+}
+
+// Start declaring the passes of a new frame. The pooled textures survive,
+// everything else is declared again every frame.
+void
+APP_RenderGraph_Begin(struct APP_RenderGraph *graph)
+{
+    graph->frame++;
+    graph->pass_count = 0;
+    graph->resource_count = 0;
+    graph->order_count = 0;
+    SDL_zero(graph->stats);
+}
+
+static Uint32
+APP_RenderGraph_AddResource(struct APP_RenderGraph *graph, const struct APP_RGResource *resource)
+{
+    if (graph->resource_count == APP_RG_MAX_RESOURCES)
+    {
+        SDL_Log("ERROR: Render graph is out of resources.");
+        return APP_RG_INVALID;
+    }
+
+    graph->resources[graph->resource_count] = *resource;
+    return graph->resource_count++;
+}
+
+// Textures created outside of the graph (e.g. the swapchain texture) are
+// the outputs of the frame, passes writing them are never culled.
+Uint32
+APP_RenderGraph_ImportTexture(
+        struct APP_RenderGraph *graph,
+        const struct APP_RGTextureDesc *desc,
+        SDL_GPUTexture *texture
+)
+{
+    struct APP_RGResource resource = {
+        .type = APP_RG_RESOURCE_TEXTURE,
+        .desc = *desc,
+        .imported = true,
+        .texture = texture,
+    };
+
+    if (resource.desc.num_levels == 0)
+    {
+        resource.desc.num_levels = 1;
+    }
+
+    return APP_RenderGraph_AddResource(graph, &resource);
+}
+
+// Buffers only take part in the ordering and culling, they are neither
+// outputs nor aliased.
+Uint32
+APP_RenderGraph_ImportBuffer(struct APP_RenderGraph *graph, const char *name, SDL_GPUBuffer *buffer)
+{
+    struct APP_RGResource resource = {
+        .type = APP_RG_RESOURCE_BUFFER,
+        .desc = { .name = name },
+        .imported = true,
+        .buffer = buffer,
+    };
+
+    return APP_RenderGraph_AddResource(graph, &resource);
+}
+
+// Declare a transient texture. It only lives from its first to its last
+// use in the frame and may share memory with other transient textures.
+Uint32
+APP_RenderGraph_CreateTexture(struct APP_RenderGraph *graph, const struct APP_RGTextureDesc *desc)
+{
+    struct APP_RGResource resource = {
+        .type = APP_RG_RESOURCE_TEXTURE,
+        .desc = *desc,
+    };
+
+    if (resource.desc.num_levels == 0)
+    {
+        resource.desc.num_levels = 1;
+    }
+
+    return APP_RenderGraph_AddResource(graph, &resource);
+}
+
+Uint32
+APP_RenderGraph_AddPass(
+        struct APP_RenderGraph *graph,
+        const char *name,
+        APP_RGExecuteFn execute,
+        void *user_data
+)
+{
+    if (graph->pass_count == APP_RG_MAX_PASSES)
+    {
+        SDL_Log("ERROR: Render graph is out of passes.");
+        return APP_RG_INVALID;
+    }
+
+    struct APP_RGPass *pass = &graph->passes[graph->pass_count];
+    SDL_zerop(pass);
+    pass->name = name;
+    pass->execute = execute;
+    pass->user_data = user_data;
+
+    return graph->pass_count++;
+}
+
+static void
+APP_RenderGraph_AddAccess(
+        struct APP_RenderGraph *graph,
+        Uint32 pass_index,
+        Uint32 resource,
+        enum APP_RGAccessType type
+)
+{
+    if (pass_index >= graph->pass_count || resource >= graph->resource_count)
+    {
+        return;
+    }
+
+    struct APP_RGPass *pass = &graph->passes[pass_index];
+    if (pass->access_count == APP_RG_MAX_PASS_ACCESSES)
+    {
+        SDL_Log("ERROR: Too many resources for render graph pass '%s'.", pass->name);
+        return;
+    }
+
+    pass->accesses[pass->access_count++] = (struct APP_RGAccess){
+        .resource = resource,
+        .type = type,
+    };
+}
+
+void
+APP_RenderGraph_Read(struct APP_RenderGraph *graph, Uint32 pass, Uint32 resource)
+{
+    APP_RenderGraph_AddAccess(graph, pass, resource, APP_RG_ACCESS_READ);
+}
+
+// For resources that carry over from one frame to the next, e.g. the depth
+// pyramid the culling tests against before this frame builds a new one.
+void
+APP_RenderGraph_ReadPrevious(struct APP_RenderGraph *graph, Uint32 pass, Uint32 resource)
+{
+    APP_RenderGraph_AddAccess(graph, pass, resource, APP_RG_ACCESS_READ_PREVIOUS);
+}
+
+void
+APP_RenderGraph_Write(struct APP_RenderGraph *graph, Uint32 pass, Uint32 resource)
+{
+    APP_RenderGraph_AddAccess(graph, pass, resource, APP_RG_ACCESS_WRITE);
+}
+
+void
+APP_RenderGraph_SetColorTarget(struct APP_RenderGraph *graph, Uint32 pass, Uint32 resource)
+{
+    APP_RenderGraph_AddAccess(graph, pass, resource, APP_RG_ACCESS_COLOR_TARGET);
+}
+
+void
+APP_RenderGraph_SetDepthTarget(struct APP_RenderGraph *graph, Uint32 pass, Uint32 resource)
+{
+    APP_RenderGraph_AddAccess(graph, pass, resource, APP_RG_ACCESS_DEPTH_TARGET);
+}
+
+void
+APP_RenderGraph_SetSideEffect(struct APP_RenderGraph *graph, Uint32 pass)
+{
+    if (pass < graph->pass_count)
+    {
+        graph->passes[pass].side_effect = true;
+    }
+}
+
+// Note(john): The pass dependencies are derived per resource. Writers of a
+// resource run in the order they were declared, readers run after all of
+// its writers and readers of the previous frame's content before them. So
+// passes can be declared in any order as long as every resource has one
+// logical producer chain. The culling leaves the previous frame reads out,
+// they order passes but don't make the writers needed.
+static void
+APP_RenderGraph_BuildDependencies(
+        const struct APP_RenderGraph *graph,
+        bool with_previous_reads,
+        bool before[APP_RG_MAX_PASSES][APP_RG_MAX_PASSES]
+)
+{
+    for (Uint32 resource = 0; resource < graph->resource_count; ++resource)
+    {
+        Uint32 last_writer = APP_RG_INVALID;
+
+        for (Uint32 pass = 0; pass < graph->pass_count; ++pass)
+        {
+            if (!APP_RGPassAccesses(&graph->passes[pass], resource, true))
+            {
+                continue;
+            }
+
+            if (last_writer != APP_RG_INVALID)
+            {
+                before[last_writer][pass] = true;
+            }
+
+            last_writer = pass;
+        }
+
+        for (Uint32 reader = 0; reader < graph->pass_count; ++reader)
+        {
+            if (!APP_RGPassAccesses(&graph->passes[reader], resource, false)
+                || APP_RGPassAccesses(&graph->passes[reader], resource, true))
+            {
+                continue;
+            }
+
+            for (Uint32 writer = 0; writer < graph->pass_count; ++writer)
+            {
+                if (APP_RGPassAccesses(&graph->passes[writer], resource, true))
+                {
+                    before[writer][reader] = true;
+                }
+            }
+        }
+
+        for (Uint32 reader = 0; reader < graph->pass_count; ++reader)
+        {
+            if (!with_previous_reads || !APP_RGPassReadsPrevious(&graph->passes[reader], resource))
+            {
+                continue;
+            }
+
+            for (Uint32 writer = 0; writer < graph->pass_count; ++writer)
+            {
+                if (writer != reader && APP_RGPassAccesses(&graph->passes[writer], resource, true))
+                {
+                    before[reader][writer] = true;
+                }
+            }
+        }
+    }
+}
+
+// Walk back from the passes writing imported textures (the outputs) and
+// side effect passes. Everything they don't depend on is culled.
+static void
+APP_RenderGraph_CullPasses(
+        struct APP_RenderGraph *graph,
+        bool before[APP_RG_MAX_PASSES][APP_RG_MAX_PASSES]
+)
+{
+    bool needed[APP_RG_MAX_PASSES] = { 0 };
+
+    for (Uint32 i = 0; i < graph->pass_count; ++i)
+    {
+        const struct APP_RGPass *pass = &graph->passes[i];
+        needed[i] = pass->side_effect;
+
+        for (Uint32 a = 0; a < pass->access_count; ++a)
+        {
+            const struct APP_RGResource *resource = &graph->resources[pass->accesses[a].resource];
+
+            if (APP_RGIsWrite(pass->accesses[a].type)
+                && resource->imported
+                && resource->type == APP_RG_RESOURCE_TEXTURE)
+            {
+                needed[i] = true;
+            }
+        }
+    }
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+
+        for (Uint32 pass = 0; pass < graph->pass_count; ++pass)
+        {
+            if (!needed[pass])
+            {
+                continue;
+            }
+
+            for (Uint32 other = 0; other < graph->pass_count; ++other)
+            {
+                if (before[other][pass] && !needed[other])
+                {
+                    needed[other] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for (Uint32 i = 0; i < graph->pass_count; ++i)
+    {
+        graph->passes[i].culled = !needed[i];
+        graph->stats.culled_pass_count += needed[i] ? 0 : 1;
+    }
+}
+
+// Topological sort of the remaining passes. Among the passes which are
+// ready the one declared first wins, so independent passes keep their
+// declaration order.
+static bool
+APP_RenderGraph_SortPasses(
+        struct APP_RenderGraph *graph,
+        bool before[APP_RG_MAX_PASSES][APP_RG_MAX_PASSES]
+)
+{
+    bool scheduled[APP_RG_MAX_PASSES] = { 0 };
+    Uint32 needed_count = graph->pass_count - graph->stats.culled_pass_count;
+
+    while (graph->order_count < needed_count)
+    {
+        Uint32 next = APP_RG_INVALID;
+
+        for (Uint32 pass = 0; pass < graph->pass_count && next == APP_RG_INVALID; ++pass)
+        {
+            if (scheduled[pass] || graph->passes[pass].culled)
+            {
+                continue;
+            }
+
+            bool ready = true;
+            for (Uint32 other = 0; other < graph->pass_count; ++other)
+            {
+                if (before[other][pass] && !scheduled[other] && !graph->passes[other].culled)
+                {
+                    ready = false;
+                    break;
+                }
+            }
+
+            if (ready)
+            {
+                next = pass;
+            }
+        }
+
+        if (next == APP_RG_INVALID)
+        {
+            SDL_Log("ERROR: Render graph has a dependency cycle.");
+            return false;
+        }
+
+        scheduled[next] = true;
+        graph->order[graph->order_count++] = next;
+    }
+
+    graph->stats.pass_count = graph->order_count;
+    return true;
+}
+
+// First and last use in the pass order and the usage flags every texture
+// needs for its accesses.
+static void
+APP_RenderGraph_ComputeLifetimes(struct APP_RenderGraph *graph)
+{
+    for (Uint32 i = 0; i < graph->resource_count; ++i)
+    {
+        struct APP_RGResource *resource = &graph->resources[i];
+        resource->first_use = APP_RG_INVALID;
+        resource->last_use = APP_RG_INVALID;
+        resource->physical = APP_RG_INVALID;
+        resource->usage = resource->desc.usage;
+    }
+
+    for (Uint32 position = 0; position < graph->order_count; ++position)
+    {
+        const struct APP_RGPass *pass = &graph->passes[graph->order[position]];
+
+        for (Uint32 a = 0; a < pass->access_count; ++a)
+        {
+            const struct APP_RGAccess *access = &pass->accesses[a];
+            struct APP_RGResource *resource = &graph->resources[access->resource];
+
+            if (resource->first_use == APP_RG_INVALID)
+            {
+                resource->first_use = position;
+            }
+            resource->last_use = position;
+
+            switch (access->type)
+            {
+                case APP_RG_ACCESS_READ:
+                case APP_RG_ACCESS_READ_PREVIOUS:
+                    resource->usage |= SDL_GPU_TEXTUREUSAGE_SAMPLER;
+                    break;
+                case APP_RG_ACCESS_COLOR_TARGET:
+                    resource->usage |= SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;
+                    break;
+                case APP_RG_ACCESS_DEPTH_TARGET:
+                    resource->usage |= SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+// The first write of a frame clears (or doesn't care about the old
+// content), later writes load. A write is only stored if a later pass
+// touches the texture again or the texture is an output.
+static void
+APP_RenderGraph_ComputeLoadStoreOps(struct APP_RenderGraph *graph)
+{
+    bool written[APP_RG_MAX_RESOURCES] = { 0 };
+
+    for (Uint32 position = 0; position < graph->order_count; ++position)
+    {
+        struct APP_RGPass *pass = &graph->passes[graph->order[position]];
+
+        for (Uint32 a = 0; a < pass->access_count; ++a)
+        {
+            struct APP_RGAccess *access = &pass->accesses[a];
+            const struct APP_RGResource *resource = &graph->resources[access->resource];
+
+            if (resource->type != APP_RG_RESOURCE_TEXTURE)
+            {
+                continue;
+            }
+
+            if (!APP_RGIsWrite(access->type))
+            {
+                if (access->type == APP_RG_ACCESS_READ && !written[access->resource] && !resource->imported)
+                {
+                    SDL_Log("WARN: '%s' reads '%s' before it is written.", pass->name, resource->desc.name);
+                }
+                continue;
+            }
+
+            if (written[access->resource])
+            {
+                access->load_op = SDL_GPU_LOADOP_LOAD;
+            }
+            else if (resource->desc.clear)
+            {
+                access->load_op = SDL_GPU_LOADOP_CLEAR;
+            }
+            else
+            {
+                access->load_op = resource->imported ? SDL_GPU_LOADOP_LOAD : SDL_GPU_LOADOP_DONT_CARE;
+            }
+
+            bool used_later = resource->last_use > position;
+            access->store_op = (used_later || resource->imported) ? SDL_GPU_STOREOP_STORE : SDL_GPU_STOREOP_DONT_CARE;
+
+            // Note(john): A transient texture starts over every frame, so
+            // SDL can hand out a fresh backing texture instead of waiting
+            // for the last frame to finish with it.
+            access->cycle = !resource->imported && access->load_op != SDL_GPU_LOADOP_LOAD;
+
+            written[access->resource] = true;
+        }
+    }
+}
+
+static void
+APP_RenderGraph_ReleaseUnusedTextures(struct APP_RenderGraph *graph)
+{
+    Uint32 i = 0;
+    while (i < graph->pool_count)
+    {
+        struct APP_RGPhysicalTexture *physical = &graph->pool[i];
+
+        if (graph->frame - physical->last_used_frame > APP_RG_POOL_KEEP_FRAMES)
+        {
+            APP_GPUMemory_ReleaseTexture(graph->memory, physical->texture);
+            graph->pool[i] = graph->pool[--graph->pool_count];
+            continue;
+        }
+
+        physical->busy_until = APP_RG_INVALID;
+        physical->used_this_frame = false;
+        ++i;
+    }
+}
+
+// A pooled texture fits a resource with the same format and mip count in
+// the same size class if it has at least the usages the resource needs. A
+// new one gets the usages of every transient texture of that kind in the
+// frame, so they can take turns in it.
+static Uint32
+APP_RenderGraph_AcquireTexture(struct APP_RenderGraph *graph, const struct APP_RGResource *resource)
+{
+    Uint32 width = APP_RGSizeClass(resource->desc.width);
+    Uint32 height = APP_RGSizeClass(resource->desc.height);
+
+    for (Uint32 i = 0; i < graph->pool_count; ++i)
+    {
+        struct APP_RGPhysicalTexture *physical = &graph->pool[i];
+
+        if (physical->width == width
+            && physical->height == height
+            && physical->num_levels == resource->desc.num_levels
+            && physical->format == resource->desc.format
+            && (physical->usage & resource->usage) == resource->usage
+            && (physical->busy_until == APP_RG_INVALID || physical->busy_until < resource->first_use))
+        {
+            return i;
+        }
+    }
+
+    SDL_GPUTextureUsageFlags usage = resource->usage;
+    for (Uint32 i = 0; i < graph->resource_count; ++i)
+    {
+        const struct APP_RGResource *other = &graph->resources[i];
+
+        if (!other->imported
+            && other->type == APP_RG_RESOURCE_TEXTURE
+            && other->first_use != APP_RG_INVALID
+            && other->desc.format == resource->desc.format
+            && other->desc.num_levels == resource->desc.num_levels
+            && APP_RGSizeClass(other->desc.width) == width
+            && APP_RGSizeClass(other->desc.height) == height)
+        {
+            usage |= other->usage;
+        }
+    }
+
+    if (graph->pool_count == APP_RG_MAX_PHYSICAL_TEXTURES)
+    {
+        SDL_Log("ERROR: Render graph texture pool is full.");
+        return APP_RG_INVALID;
+    }
+
+    SDL_GPUTexture *texture = APP_GPUMemory_CreateTexture(
+            graph->memory,
+            &(SDL_GPUTextureCreateInfo){
+                .type                 = SDL_GPU_TEXTURETYPE_2D,
+                .format               = resource->desc.format,
+                .width                = width,
+                .height               = height,
+                .layer_count_or_depth = 1,
+                .num_levels           = resource->desc.num_levels,
+                .usage                = usage
+            },
+            resource->desc.name
+    );
+
+    if (texture == NULL)
+    {
+        SDL_Log("ERROR: Failed to create render graph texture '%s'. %s", resource->desc.name, SDL_GetError());
+        return APP_RG_INVALID;
+    }
+
+    graph->pool[graph->pool_count] = (struct APP_RGPhysicalTexture){
+        .texture = texture,
+        .width = width,
+        .height = height,
+        .num_levels = resource->desc.num_levels,
+        .format = resource->desc.format,
+        .usage = usage,
+        .bytes = APP_RGTextureBytes(resource->desc.format, width, height, resource->desc.num_levels),
+        .busy_until = APP_RG_INVALID,
+    };
+
+    return graph->pool_count++;
+}
+
+// Hand out pooled textures to the transient textures in the order of
+// their first use. A pooled texture is reused as soon as the last use of
+// its previous resource lies before the first use of the next one.
+static bool
+APP_RenderGraph_AssignTextures(struct APP_RenderGraph *graph)
+{
+    APP_RenderGraph_ReleaseUnusedTextures(graph);
+
+    for (Uint32 position = 0; position < graph->order_count; ++position)
+    {
+        for (Uint32 i = 0; i < graph->resource_count; ++i)
+        {
+            struct APP_RGResource *resource = &graph->resources[i];
+
+            if (resource->imported
+                || resource->type != APP_RG_RESOURCE_TEXTURE
+                || resource->first_use != position)
+            {
+                continue;
+            }
+
+            Uint32 physical_index = APP_RenderGraph_AcquireTexture(graph, resource);
+            if (physical_index == APP_RG_INVALID)
+            {
+                return false;
+            }
+
+            struct APP_RGPhysicalTexture *physical = &graph->pool[physical_index];
+            physical->busy_until = resource->last_use;
+            physical->last_used_frame = graph->frame;
+
+            if (!physical->used_this_frame)
+            {
+                physical->used_this_frame = true;
+                graph->stats.physical_count++;
+                graph->stats.physical_bytes += physical->bytes;
+            }
+
+            resource->physical = physical_index;
+            resource->texture = physical->texture;
+
+            graph->stats.transient_count++;
+            graph->stats.transient_bytes += APP_RGDescBytes(&resource->desc);
+        }
+    }
+
+    return true;
+}
+
+// Turn the declared passes into an executable frame: order and cull the
+// passes, assign memory to the transient textures and pick the load and
+// store ops of every write.
+bool
+APP_RenderGraph_Compile(struct APP_RenderGraph *graph)
+{
+    bool needs[APP_RG_MAX_PASSES][APP_RG_MAX_PASSES] = { 0 };
+    bool before[APP_RG_MAX_PASSES][APP_RG_MAX_PASSES] = { 0 };
+
+    APP_RenderGraph_BuildDependencies(graph, false, needs);
+    APP_RenderGraph_BuildDependencies(graph, true, before);
+    APP_RenderGraph_CullPasses(graph, needs);
+
+    if (!APP_RenderGraph_SortPasses(graph, before))
+    {
+        return false;
+    }
+
+    APP_RenderGraph_ComputeLifetimes(graph);
+    APP_RenderGraph_ComputeLoadStoreOps(graph);
+
+    return APP_RenderGraph_AssignTextures(graph);
+}
+
+void
+APP_RenderGraph_Execute(struct APP_RenderGraph *graph, SDL_GPUCommandBuffer *cmd_buffer)
+{
+    for (Uint32 position = 0; position < graph->order_count; ++position)
+    {
+        const struct APP_RGPass *pass = &graph->passes[graph->order[position]];
+
+        SDL_GPUColorTargetInfo color_targets[APP_RG_MAX_COLOR_TARGETS] = { 0 };
+        Uint32 color_target_count = 0;
+
+        SDL_GPUDepthStencilTargetInfo depth_target = { 0 };
+        bool has_depth_target = false;
+
+        for (Uint32 a = 0; a < pass->access_count; ++a)
+        {
+            const struct APP_RGAccess *access = &pass->accesses[a];
+            const struct APP_RGResource *resource = &graph->resources[access->resource];
+
+            if (access->type == APP_RG_ACCESS_COLOR_TARGET && color_target_count < APP_RG_MAX_COLOR_TARGETS)
+            {
+                SDL_GPUColorTargetInfo *target = &color_targets[color_target_count++];
+                target->texture = resource->texture;
+                target->clear_color = resource->desc.clear_color;
+                target->load_op = access->load_op;
+                target->store_op = access->store_op;
+                target->cycle = access->cycle;
+            }
+            else if (access->type == APP_RG_ACCESS_DEPTH_TARGET)
+            {
+                depth_target.texture = resource->texture;
+                depth_target.clear_depth = resource->desc.clear_depth;
+                depth_target.load_op = access->load_op;
+                depth_target.store_op = access->store_op;
+                depth_target.stencil_load_op = SDL_GPU_LOADOP_DONT_CARE;
+                depth_target.stencil_store_op = SDL_GPU_STOREOP_DONT_CARE;
+                depth_target.cycle = access->cycle;
+                has_depth_target = true;
+            }
+        }
+
+        struct APP_RGPassContext pass_context = {
+            .graph = graph,
+            .cmd_buffer = cmd_buffer,
+        };
+
+        if (color_target_count == 0 && !has_depth_target)
+        {
+            pass->execute(&pass_context, pass->user_data);
+            continue;
+        }
+
+        pass_context.render_pass = SDL_BeginGPURenderPass(
+                cmd_buffer,
+                color_targets,
+                color_target_count,
+                has_depth_target ? &depth_target : NULL
+        );
+
+        pass->execute(&pass_context, pass->user_data);
+
+        SDL_EndGPURenderPass(pass_context.render_pass);
+    }
+}
+
+// Log the compiled frame: pass order with load and store ops, culled
+// passes, the lifetime and memory of every transient texture and how much
+// the aliasing saved.
+void
+APP_RenderGraph_Dump(const struct APP_RenderGraph *graph)
+{
+    const struct APP_RGFrameStats *stats = &graph->stats;
+
+    SDL_Log(
+            "INFO: [graph] frame %llu: %u passes, %u culled",
+            (unsigned long long)graph->frame,
+            stats->pass_count,
+            stats->culled_pass_count
+    );
+
+    for (Uint32 position = 0; position < graph->order_count; ++position)
+    {
+        const struct APP_RGPass *pass = &graph->passes[graph->order[position]];
+        SDL_Log("INFO: [graph] %2u %s%s", position, pass->name, pass->side_effect ? " (side effect)" : "");
+
+        for (Uint32 a = 0; a < pass->access_count; ++a)
+        {
+            const struct APP_RGAccess *access = &pass->accesses[a];
+            const struct APP_RGResource *resource = &graph->resources[access->resource];
+
+            if (!APP_RGIsWrite(access->type) || resource->type == APP_RG_RESOURCE_BUFFER)
+            {
+                SDL_Log(
+                        "INFO: [graph]      %-5s %s",
+                        APP_RGIsWrite(access->type) ? "write" : access->type == APP_RG_ACCESS_READ_PREVIOUS ? "prev" : "read",
+                        resource->desc.name
+                );
+                continue;
+            }
+
+            static const char *ACCESS_NAMES[] = { "read", "write", "color", "depth" };
+
+            SDL_Log(
+                    "INFO: [graph]      %-5s %s (%s / %s%s)",
+                    ACCESS_NAMES[access->type],
+                    resource->desc.name,
+                    APP_RGLoadOpName(access->load_op),
+                    APP_RGStoreOpName(access->store_op),
+                    access->cycle ? ", cycle" : ""
+            );
+        }
+    }
+
+    for (Uint32 i = 0; i < graph->pass_count; ++i)
+    {
+        if (graph->passes[i].culled)
+        {
+            SDL_Log("INFO: [graph]  - %s (culled)", graph->passes[i].name);
+        }
+    }
+
+    for (Uint32 i = 0; i < graph->resource_count; ++i)
+    {
+        const struct APP_RGResource *resource = &graph->resources[i];
+
+        if (resource->imported || resource->type != APP_RG_RESOURCE_TEXTURE)
+        {
+            continue;
+        }
+
+        if (resource->first_use == APP_RG_INVALID)
+        {
+            SDL_Log("INFO: [graph] %s unused", resource->desc.name);
+            continue;
+        }
+
+        SDL_Log(
+                "INFO: [graph] %s %ux%u format %d, passes %u-%u, %.2f MB -> texture %u",
+                resource->desc.name,
+                resource->desc.width,
+                resource->desc.height,
+                (int)resource->desc.format,
+                resource->first_use,
+                resource->last_use,
+                APP_RGDescBytes(&resource->desc) / (1024.0 * 1024.0),
+                resource->physical
+        );
+    }
+
+    // Note(john): Negative when the textures are rounded up to their size
+    // classes and nothing shares them.
+    Sint64 saved = (Sint64)stats->transient_bytes - (Sint64)stats->physical_bytes;
+
+    SDL_Log(
+            "INFO: [graph] %u transient textures in %u textures: %.2f MB instead of %.2f MB, saved %.2f MB (%.0f%%)",
+            stats->transient_count,
+            stats->physical_count,
+            stats->physical_bytes / (1024.0 * 1024.0),
+            stats->transient_bytes / (1024.0 * 1024.0),
+            saved / (1024.0 * 1024.0),
+            stats->transient_bytes > 0 ? 100.0 * saved / stats->transient_bytes : 0.0
+    );
+}
+
+SDL_GPUTexture*
+APP_RenderGraph_GetTexture(const struct APP_RenderGraph *graph, Uint32 resource)
+{
+    if (resource >= graph->resource_count)
+    {
+        return NULL;
+    }
+
+    return graph->resources[resource].texture;
+}
+
+SDL_GPUBuffer*
+APP_RenderGraph_GetBuffer(const struct APP_RenderGraph *graph, Uint32 resource)
+{
+    if (resource >= graph->resource_count)
+    {
+        return NULL;
+    }
+
+    return graph->resources[resource].buffer;
+}
@@ -0,0 +1,196 @@
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include <SDL3/SDL.h>
+
+#define APP_RG_MAX_PASSES 32
+#define APP_RG_MAX_RESOURCES 64
+#define APP_RG_MAX_PASS_ACCESSES 16
+#define APP_RG_MAX_COLOR_TARGETS 4
+#define APP_RG_MAX_PHYSICAL_TEXTURES 32
+
+// Pooled textures are allocated in steps of this many pixels. A transient
+// texture may get a larger one of the same size class, the passes only use
+// the top left width x height of it.
+#define APP_RG_SIZE_CLASS 64
+
+// Pooled textures which weren't used for this many frames are released.
+#define APP_RG_POOL_KEEP_FRAMES 8
+
+#define APP_RG_INVALID 0xFFFFFFFFu
+
+struct APP_GPUMemory;
+struct APP_RenderGraph;
+
+enum APP_RGResourceType {
+    APP_RG_RESOURCE_TEXTURE,
+    APP_RG_RESOURCE_BUFFER,
+};
+
+enum APP_RGAccessType {
+    // Sampled texture, storage buffer, indirect or vertex buffer.
+    APP_RG_ACCESS_READ,
+    // Compute, copy or blit destination. The usage for it has to be part of
+    // the texture description.
+    APP_RG_ACCESS_WRITE,
+    APP_RG_ACCESS_COLOR_TARGET,
+    APP_RG_ACCESS_DEPTH_TARGET,
+    // Read of what the last frame left in the resource. The pass runs before
+    // this frame's writers instead of after them.
+    APP_RG_ACCESS_READ_PREVIOUS,
+};
+
+struct APP_RGTextureDesc {
+    const char *name;
+    Uint32 width, height;
+    Uint32 num_levels;
+    SDL_GPUTextureFormat format;
+    // Usage on top of what the declared accesses need.
+    SDL_GPUTextureUsageFlags usage;
+
+    // Clear on the first write of the frame, otherwise the first write
+    // doesn't care about the old content (or loads it for imports).
+    bool clear;
+    SDL_FColor clear_color;
+    float clear_depth;
+};
+
+struct APP_RGAccess {
+    Uint32 resource;
+    enum APP_RGAccessType type;
+
+    // Filled in by APP_RenderGraph_Compile.
+    SDL_GPULoadOp load_op;
+    SDL_GPUStoreOp store_op;
+    bool cycle;
+};
+
+struct APP_RGPassContext {
+    struct APP_RenderGraph *graph;
+    SDL_GPUCommandBuffer *cmd_buffer;
+    // Only set for passes with color or depth targets.
+    SDL_GPURenderPass *render_pass;
+};
+
+typedef void (*APP_RGExecuteFn)(const struct APP_RGPassContext *pass, void *user_data);
+
+struct APP_RGPass {
+    const char *name;
+    APP_RGExecuteFn execute;
+    void *user_data;
+
+    struct APP_RGAccess accesses[APP_RG_MAX_PASS_ACCESSES];
+    Uint32 access_count;
+
+    // Never culled, even if nothing reads what it writes.
+    bool side_effect;
+    bool culled;
+};
+
+struct APP_RGResource {
+    enum APP_RGResourceType type;
+    struct APP_RGTextureDesc desc;
+    bool imported;
+
+    SDL_GPUTexture *texture;
+    SDL_GPUBuffer *buffer;
+
+    // Filled in by APP_RenderGraph_Compile, positions in the pass order.
+    SDL_GPUTextureUsageFlags usage;
+    Uint32 first_use;
+    Uint32 last_use;
+    Uint32 physical;
+};
+
+struct APP_RGPhysicalTexture {
+    SDL_GPUTexture *texture;
+    // Rounded up to the size class.
+    Uint32 width, height;
+    Uint32 num_levels;
+    SDL_GPUTextureFormat format;
+    // May have more usages than the resources living in it need.
+    SDL_GPUTextureUsageFlags usage;
+    Uint64 bytes;
+
+    Uint64 last_used_frame;
+    // Last pass order position of the resource currently living in it.
+    Uint32 busy_until;
+    bool used_this_frame;
+};
+
+struct APP_RGFrameStats {
+    Uint32 pass_count;
+    Uint32 culled_pass_count;
+    Uint32 transient_count;
+    Uint32 physical_count;
+    // Memory the transient textures would need without aliasing and what
+    // is actually bound to them.
+    Uint64 transient_bytes;
+    Uint64 physical_bytes;
+};
+
+struct APP_RenderGraph {
+    SDL_GPUDevice *device;
+    struct APP_GPUMemory *memory;
+    Uint64 frame;
+
+    struct APP_RGPass passes[APP_RG_MAX_PASSES];
+    Uint32 pass_count;
+
+    struct APP_RGResource resources[APP_RG_MAX_RESOURCES];
+    Uint32 resource_count;
+
+    // Indices into passes, culled passes are not part of the order.
+    Uint32 order[APP_RG_MAX_PASSES];
+    Uint32 order_count;
+
+    struct APP_RGPhysicalTexture pool[APP_RG_MAX_PHYSICAL_TEXTURES];
+    Uint32 pool_count;
+
+    struct APP_RGFrameStats stats;
+};
+
+struct APP_RenderGraph *APP_RenderGraph_Create(SDL_GPUDevice *device, struct APP_GPUMemory *memory);
+void APP_RenderGraph_Destroy(struct APP_RenderGraph *graph);
+
+void APP_RenderGraph_Begin(struct APP_RenderGraph *graph);
+
+Uint32 APP_RenderGraph_ImportTexture(
+        struct APP_RenderGraph *graph,
+        const struct APP_RGTextureDesc *desc,
+        SDL_GPUTexture *texture
+);
+
+Uint32 APP_RenderGraph_ImportBuffer(
+        struct APP_RenderGraph *graph,
+        const char *name,
+        SDL_GPUBuffer *buffer
+);
+
+Uint32 APP_RenderGraph_CreateTexture(
+        struct APP_RenderGraph *graph,
+        const struct APP_RGTextureDesc *desc
+);
+
+Uint32 APP_RenderGraph_AddPass(
+        struct APP_RenderGraph *graph,
+        const char *name,
+        APP_RGExecuteFn execute,
+        void *user_data
+);
+
+void APP_RenderGraph_Read(struct APP_RenderGraph *graph, Uint32 pass, Uint32 resource);
+void APP_RenderGraph_ReadPrevious(struct APP_RenderGraph *graph, Uint32 pass, Uint32 resource);
+void APP_RenderGraph_Write(struct APP_RenderGraph *graph, Uint32 pass, Uint32 resource);
+void APP_RenderGraph_SetColorTarget(struct APP_RenderGraph *graph, Uint32 pass, Uint32 resource);
+void APP_RenderGraph_SetDepthTarget(struct APP_RenderGraph *graph, Uint32 pass, Uint32 resource);
+void APP_RenderGraph_SetSideEffect(struct APP_RenderGraph *graph, Uint32 pass);
+
+bool APP_RenderGraph_Compile(struct APP_RenderGraph *graph);
+void APP_RenderGraph_Execute(struct APP_RenderGraph *graph, SDL_GPUCommandBuffer *cmd_buffer);
+void APP_RenderGraph_Dump(const struct APP_RenderGraph *graph);
+
+SDL_GPUTexture *APP_RenderGraph_GetTexture(const struct APP_RenderGraph *graph, Uint32 resource);
+SDL_GPUBuffer *APP_RenderGraph_GetBuffer(const struct APP_RenderGraph *graph, Uint32 resource);
+
+#endif
@@ -0,0 +1,418 @@
+#include "scene.h"
+#include "app.h"
+#include "arena.h"
+#include "gpumemory.h"
+#include "math.h"
+#include "mesh.h"
+
+#define SCENE_OBJECT_SCALE 0.1f
+#define SCENE_EXTENT 60.0f
+
+// Note(john): One in four objects is a cube, the rest are spheres.
+#define SCENE_CUBE_RATIO 4
+
+// Create count objects scattered around the origin and upload them into a
+// storage buffer the cull and vertex shaders can read.
+int
+APP_CreateScene(struct APP_Context *ctx, Uint32 object_count)
+{
+    ctx->scene_objects = SDL_malloc(sizeof(struct APP_SceneObject) * object_count);
+    if (ctx->scene_objects == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate %u scene objects.", object_count);
+        return -1;
+    }
+
+    ctx->scene_object_lods = SDL_calloc(object_count, sizeof(Uint8));
+    if (ctx->scene_object_lods == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate %u scene object lods.", object_count);
+        return -1;
+    }
+
+    ctx->arena_visible_ids = SDL_malloc(sizeof(Uint32) * object_count);
+    ctx->arena_visible_groups = SDL_malloc(sizeof(Uint8) * object_count);
+    if (ctx->arena_visible_ids == NULL || ctx->arena_visible_groups == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate %u visible object slots.", object_count);
+        return -1;
+    }
+
+    // One object more to align the objects in the arena, see
+    // APP_PrepareSceneArena.
+    Uint32 arena_objects = SDL_max(object_count, 1) + 1;
+    if (APP_UniformArena_Init(ctx, &ctx->object_arena, sizeof(struct APP_ObjectData) * arena_objects) == -1)
+    {
+        return -1;
+    }
+
+    ctx->scene_object_count = object_count;
+
+    // Note(john): Fixed seed so each run (and each benchmark step) sees the
+    // same scene.
+    SDL_srand(42);
+
+    for (Uint32 i = 0; i < object_count; ++i)
+    {
+        Uint32 mesh = SDL_rand(SCENE_CUBE_RATIO) == 0 ? APP_MESH_CUBE : APP_MESH_SPHERE;
+        float radius = ctx->meshes[mesh].radius * SCENE_OBJECT_SCALE;
+
+        struct APP_Vector3 position = {
+            (SDL_randf() * 2.0f - 1.0f) * SCENE_EXTENT,
+            (SDL_randf() * 2.0f - 1.0f) * SCENE_EXTENT,
+            (SDL_randf() * 2.0f - 1.0f) * SCENE_EXTENT,
+        };
+
+        struct APP_Matrix4x4 model = APP_Matrix4x4_Mutliply(
+                APP_Matrix4x4_CreateScale(SCENE_OBJECT_SCALE),
+                APP_Matrix4x4_CreateRotationY(SDL_randf() * 2.0f * SDL_PI_F)
+        );
+
+        ctx->scene_objects[i].model = APP_Matrix4x4_Mutliply(
+                model,
+                APP_Matrix4x4_CreateTranslation(position)
+        );
+        ctx->scene_objects[i].bounds = (struct APP_Vector4) { position.x, position.y, position.z, radius };
+        ctx->scene_objects[i].mesh = mesh;
+    }
+
+    Uint32 object_buffer_size = sizeof(struct APP_SceneObject) * object_count;
+    Uint32 lod_state_size = sizeof(Uint32) * object_count;
+
+    ctx->scene_object_buffer = APP_GPUMemory_CreateBuffer(
+            ctx->gpu_memory,
+            &(SDL_GPUBufferCreateInfo){
+                .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ,
+                .size = object_buffer_size
+            },
+            "Scene Objects"
+    );
+
+    ctx->visible_object_buffer = APP_GPUMemory_CreateBuffer(
+            ctx->gpu_memory,
+            &(SDL_GPUBufferCreateInfo){
+                .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+                .size = sizeof(Uint32) * object_count * APP_MESH_COUNT * APP_MAX_MESH_LODS
+            },
+            "Visible Objects"
+    );
+
+    ctx->lod_state_buffer = APP_GPUMemory_CreateBuffer(
+            ctx->gpu_memory,
+            &(SDL_GPUBufferCreateInfo){
+                .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+                .size = sizeof(Uint32) * object_count
+            },
+            "LOD State"
+    );
+
+    if (ctx->scene_object_buffer == NULL || ctx->visible_object_buffer == NULL || ctx->lod_state_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create scene buffers. %s", SDL_GetError());
+        return -1;
+    }
+
+    SDL_GPUTransferBuffer *transfer_buffer = APP_GPUMemory_CreateTransferBuffer(
+            ctx->gpu_memory,
+            &(SDL_GPUTransferBufferCreateInfo){
+                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                .size = object_buffer_size + lod_state_size
+            },
+            "Scene Upload"
+    );
+
+    if (transfer_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create scene transfer buffer. %s", SDL_GetError());
+        return -1;
+    }
+
+    // Every object starts at LOD 0.
+    Uint8 *transfer_data = SDL_MapGPUTransferBuffer(ctx->device, transfer_buffer, false);
+    SDL_memcpy(transfer_data, ctx->scene_objects, object_buffer_size);
+    SDL_memset(transfer_data + object_buffer_size, 0, lod_state_size);
+    SDL_UnmapGPUTransferBuffer(ctx->device, transfer_buffer);
+
+    SDL_GPUCommandBuffer *upload_cmd_buffer = SDL_AcquireGPUCommandBuffer(ctx->device);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(upload_cmd_buffer);
+
+    SDL_UploadToGPUBuffer(
+            copy_pass,
+            &(SDL_GPUTransferBufferLocation){
+                .transfer_buffer = transfer_buffer,
+                .offset = 0
+            },
+            &(SDL_GPUBufferRegion){
+                .buffer = ctx->scene_object_buffer,
+                .offset = 0,
+                .size = object_buffer_size
+            },
+            false
+    );
+
+    SDL_UploadToGPUBuffer(
+            copy_pass,
+            &(SDL_GPUTransferBufferLocation){
+                .transfer_buffer = transfer_buffer,
+                .offset = object_buffer_size
+            },
+            &(SDL_GPUBufferRegion){
+                .buffer = ctx->lod_state_buffer,
+                .offset = 0,
+                .size = lod_state_size
+            },
+            false
+    );
+
+    SDL_EndGPUCopyPass(copy_pass);
+    SDL_SubmitGPUCommandBuffer(upload_cmd_buffer);
+    APP_GPUMemory_ReleaseTransferBuffer(ctx->gpu_memory, transfer_buffer);
+
+    return 0;
+}
+
+void
+APP_ReleaseScene(struct APP_Context *ctx)
+{
+    APP_GPUMemory_ReleaseBuffer(ctx->gpu_memory, ctx->scene_object_buffer);
+    APP_GPUMemory_ReleaseBuffer(ctx->gpu_memory, ctx->visible_object_buffer);
+    APP_GPUMemory_ReleaseBuffer(ctx->gpu_memory, ctx->lod_state_buffer);
+    SDL_free(ctx->scene_objects);
+    SDL_free(ctx->scene_object_lods);
+    SDL_free(ctx->arena_visible_ids);
+    SDL_free(ctx->arena_visible_groups);
+    APP_UniformArena_Release(ctx, &ctx->object_arena);
+
+    ctx->scene_object_buffer = NULL;
+    ctx->visible_object_buffer = NULL;
+    ctx->lod_state_buffer = NULL;
+    ctx->scene_objects = NULL;
+    ctx->scene_object_lods = NULL;
+    ctx->arena_visible_ids = NULL;
+    ctx->arena_visible_groups = NULL;
+    ctx->scene_object_count = 0;
+}
+
+// Distance from the camera to the surface of the bounding sphere, this is
+// what the LOD selection is based on.
+float
+APP_DistanceToBounds(struct APP_Vector3 position, struct APP_Vector4 bounds)
+{
+    struct APP_Vector3 delta = { bounds.x - position.x, bounds.y - position.y, bounds.z - position.z };
+    float distance = SDL_sqrtf(APP_Vector3_Dot(delta, delta)) - bounds.w;
+    return SDL_max(distance, 0.0f);
+}
+
+// Frustum test and LOD selection shared by the CPU paths. Returns false if
+// the object is outside of the frustum.
+static bool
+APP_SelectObjectLOD(
+        struct APP_Context *ctx,
+        Uint32 index,
+        const struct APP_Camera *camera,
+        Uint32 *out_lod
+)
+{
+    const struct APP_SceneObject *object = &ctx->scene_objects[index];
+    struct APP_Vector3 center = { object->bounds.x, object->bounds.y, object->bounds.z };
+
+    if (!APP_Frustum_ContainsSphere(&camera->frustum, center, object->bounds.w))
+    {
+        return false;
+    }
+
+    *out_lod = 0;
+    if (ctx->lod_enabled)
+    {
+        *out_lod = APP_LODSelector_Select(
+                &camera->lod_selector,
+                &ctx->meshes[object->mesh],
+                object->bounds.w,
+                APP_DistanceToBounds(camera->position, object->bounds),
+                ctx->scene_object_lods[index]
+        );
+
+        ctx->scene_object_lods[index] = (Uint8)*out_lod;
+    }
+
+    return true;
+}
+
+// Reference path: cull and select the LOD on the CPU and issue one draw with
+// its own uniform push per visible object. Cost grows linearly with the
+// object count.
+void
+APP_DrawSceneCPU(
+        struct APP_Context *ctx,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        SDL_GPURenderPass *render_pass,
+        const struct APP_Camera *camera
+)
+{
+    SDL_BindGPUGraphicsPipeline(render_pass, ctx->pipeline);
+    APP_BindMeshBuffers(ctx, render_pass);
+
+    Uint32 visible_count = 0;
+    Uint64 triangle_count = 0;
+
+    for (Uint32 i = 0; i < ctx->scene_object_count; ++i)
+    {
+        Uint32 lod;
+        if (!APP_SelectObjectLOD(ctx, i, camera, &lod))
+        {
+            continue;
+        }
+
+        const struct APP_SceneObject *object = &ctx->scene_objects[i];
+        const struct APP_Mesh *mesh = &ctx->meshes[object->mesh];
+
+        struct APP_Matrix4x4 model_view_proj = APP_Matrix4x4_Mutliply(object->model, camera->view_proj);
+
+        SDL_PushGPUVertexUniformData(cmd_buffer, 0, &model_view_proj, sizeof(model_view_proj));
+        SDL_DrawGPUIndexedPrimitives(
+                render_pass, 
+                mesh->lods[lod].index_count, 
+                1, 
+                mesh->first_index + mesh->lods[lod].first_index, 
+                mesh->base_vertex, 
+                0
+        );
+
+        visible_count++;
+        triangle_count += mesh->lods[lod].index_count / 3;
+    }
+
+    ctx->stats.visible_objects = visible_count;
+    ctx->stats.draw_calls = visible_count;
+    ctx->stats.triangles += triangle_count;
+}
+
+// Cull on the CPU and write the data of every visible object into the
+// uniform arena, sorted by mesh LOD so every LOD is one contiguous range.
+// Has to run outside of a render pass, the arena is uploaded here.
+void
+APP_PrepareSceneArena(
+        struct APP_Context *ctx,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        const struct APP_Camera *camera
+)
+{
+    Uint32 visible_count = 0;
+    Uint32 group_counts[APP_MESH_COUNT * APP_MAX_MESH_LODS] = { 0 };
+
+    for (Uint32 i = 0; i < ctx->scene_object_count; ++i)
+    {
+        Uint32 lod;
+        if (!APP_SelectObjectLOD(ctx, i, camera, &lod))
+        {
+            continue;
+        }
+
+        Uint8 group = (Uint8)(ctx->scene_objects[i].mesh * APP_MAX_MESH_LODS + lod);
+
+        ctx->arena_visible_ids[visible_count] = i;
+        ctx->arena_visible_groups[visible_count] = group;
+        group_counts[group]++;
+        visible_count++;
+    }
+
+    if (!APP_UniformArena_Begin(ctx, &ctx->object_arena))
+    {
+        SDL_zeroa(ctx->arena_groups);
+        return;
+    }
+
+    // Note(john): The shader indexes the storage buffer in whole objects,
+    // the arena only aligns to 16 bytes. One object more is reserved, so the
+    // objects can start at the next multiple of their size wherever the
+    // allocation landed in the arena.
+    const Uint32 stride = sizeof(struct APP_ObjectData);
+    Uint32 offset;
+    Uint8 *memory = APP_UniformArena_Alloc(
+            &ctx->object_arena, 
+            stride * (SDL_max(visible_count, 1) + 1), 
+            &offset
+    );
+
+    if (memory == NULL)
+    {
+        SDL_zeroa(ctx->arena_groups);
+    }
+    else
+    {
+        Uint32 base_index = (offset + stride - 1) / stride;
+        struct APP_ObjectData *objects = (struct APP_ObjectData *)(memory + (base_index * stride - offset));
+
+        Uint32 first = base_index;
+        for (Uint32 group = 0; group < SDL_arraysize(ctx->arena_groups); ++group)
+        {
+            ctx->arena_groups[group] = (struct APP_DrawGroup){ first, 0 };
+            first += group_counts[group];
+        }
+
+        for (Uint32 i = 0; i < visible_count; ++i)
+        {
+            struct APP_DrawGroup *group = &ctx->arena_groups[ctx->arena_visible_groups[i]];
+            const struct APP_SceneObject *object = &ctx->scene_objects[ctx->arena_visible_ids[i]];
+
+            objects[group->first - base_index + group->count++].model_view_proj = APP_Matrix4x4_Mutliply(
+                    object->model, 
+                    camera->view_proj
+            );
+        }
+    }
+
+    APP_UniformArena_End(ctx, &ctx->object_arena, cmd_buffer);
+
+    ctx->stats.visible_objects = visible_count;
+}
+
+// Draw the objects written by APP_PrepareSceneArena. Per mesh LOD only the
+// index of its first object is pushed, the shader finds the data of an
+// instance at that index plus the instance id.
+void
+APP_DrawSceneArena(
+        struct APP_Context *ctx,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        SDL_GPURenderPass *render_pass
+)
+{
+    SDL_BindGPUGraphicsPipeline(render_pass, ctx->arena_pipeline);
+    SDL_BindGPUVertexStorageBuffers(render_pass, 0, &ctx->object_arena.buffer, 1);
+    APP_BindMeshBuffers(ctx, render_pass);
+
+    Uint32 draw_count = 0;
+    Uint64 triangle_count = 0;
+
+    for (Uint32 mesh_index = 0; mesh_index < APP_MESH_COUNT; ++mesh_index)
+    {
+        const struct APP_Mesh *mesh = &ctx->meshes[mesh_index];
+
+        for (Uint32 lod = 0; lod < mesh->lod_count; ++lod)
+        {
+            const struct APP_DrawGroup *group = &ctx->arena_groups[mesh_index * APP_MAX_MESH_LODS + lod];
+            if (group->count == 0)
+            {
+                continue;
+            }
+
+            Uint32 base_index[4] = { group->first, 0, 0, 0 };
+
+            SDL_PushGPUVertexUniformData(cmd_buffer, 0, base_index, sizeof(base_index));
+            SDL_DrawGPUIndexedPrimitives(
+                    render_pass, 
+                    mesh->lods[lod].index_count, 
+                    group->count, 
+                    mesh->first_index + mesh->lods[lod].first_index, 
+                    mesh->base_vertex, 
+                    0
+            );
+
+            draw_count++;
+            triangle_count += (Uint64)(mesh->lods[lod].index_count / 3) * group->count;
+        }
+    }
+
+    ctx->stats.draw_calls = draw_count;
+    ctx->stats.triangles += triangle_count;
+}
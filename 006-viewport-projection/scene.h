@@ -0,0 +1,55 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "app.h"
+#include "lod.h"
+#include "math.h"
+
+// Note(john): Layout has to match the SceneObject struct in the shaders,
+// so keep it a multiple of 16 bytes.
+struct APP_SceneObject {
+    struct APP_Matrix4x4 model;
+    struct APP_Vector4 bounds;
+    Uint32 mesh;
+    Uint32 padding[3];
+};
+
+// Entry of the uniform arena, matches ObjectData in ArenaInstance.vert.hlsl.
+struct APP_ObjectData {
+    struct APP_Matrix4x4 model_view_proj;
+};
+
+// Everything the culling and LOD selection need to know about the camera
+// of the current frame.
+struct APP_Camera {
+    struct APP_Vector3 position;
+    struct APP_Matrix4x4 view_proj;
+    struct APP_Frustum frustum;
+    struct APP_LODSelector lod_selector;
+};
+
+int APP_CreateScene(struct APP_Context *ctx, Uint32 object_count);
+void APP_ReleaseScene(struct APP_Context *ctx);
+
+void APP_DrawSceneCPU(
+        struct APP_Context *ctx,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        SDL_GPURenderPass *render_pass,
+        const struct APP_Camera *camera
+);
+
+void APP_PrepareSceneArena(
+        struct APP_Context *ctx,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        const struct APP_Camera *camera
+);
+
+void APP_DrawSceneArena(
+        struct APP_Context *ctx,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        SDL_GPURenderPass *render_pass
+);
+
+float APP_DistanceToBounds(struct APP_Vector3 position, struct APP_Vector4 bounds);
+
+#endif
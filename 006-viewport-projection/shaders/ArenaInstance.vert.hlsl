@@ -0,0 +1,36 @@
+// Per object data written into the uniform arena once per frame.
+struct ObjectData
+{
+    float4x4 ModelViewProj;
+};
+
+StructuredBuffer<ObjectData> Objects : register(t0, space0);
+
+cbuffer UniformBlock : register(b0, space1)
+{
+    // First object of the draw, the instances follow it in the arena.
+    uint BaseIndex : packoffset(c0);
+};
+
+struct Input
+{
+    float3 Position : TEXCOORD0;
+    float4 Color : TEXCOORD1;
+    uint InstanceIndex : SV_InstanceID;
+};
+
+struct Output
+{
+    float4 Color : TEXCOORD0;
+    float4 Position : SV_Position;
+};
+
+Output main(Input input)
+{
+    ObjectData object = Objects[BaseIndex + input.InstanceIndex];
+
+    Output output;
+    output.Color = input.Color;
+    output.Position = mul(object.ModelViewProj, float4(input.Position, 1.0f));
+    return output;
+}
@@ -0,0 +1,39 @@
+struct SceneObject
+{
+    float4x4 Model;
+    float4 Bounds;
+    uint Mesh;
+    uint3 Padding;
+};
+
+StructuredBuffer<SceneObject> Objects : register(t0, space0);
+StructuredBuffer<uint> VisibleIds : register(t1, space0);
+
+cbuffer UniformBlock : register(b0, space1)
+{
+    float4x4 ViewProj : packoffset(c0);
+    uint VisibleOffset : packoffset(c4);
+};
+
+struct Input
+{
+    float3 Position : TEXCOORD0;
+    float4 Color : TEXCOORD1;
+    uint InstanceIndex : SV_InstanceID;
+};
+
+struct Output
+{
+    float4 Color : TEXCOORD0;
+    float4 Position : SV_Position;
+};
+
+Output main(Input input)
+{
+    SceneObject object = Objects[VisibleIds[VisibleOffset + input.InstanceIndex]];
+
+    Output output;
+    output.Color = input.Color;
+    output.Position = mul(ViewProj, mul(object.Model, float4(input.Position, 1.0f)));
+    return output;
+}
@@ -0,0 +1,168 @@
+#define MESH_COUNT 2
+#define MAX_MESH_LODS 4
+#define DRAW_GROUP_COUNT (MESH_COUNT * MAX_MESH_LODS)
+#define HIZ_MAX_LEVELS 12
+
+struct SceneObject
+{
+    float4x4 Model;
+    float4 Bounds;
+    uint Mesh;
+    uint3 Padding;
+};
+
+StructuredBuffer<SceneObject> Objects : register(t0, space0);
+StructuredBuffer<float> DepthPyramid : register(t1, space0);
+
+RWStructuredBuffer<uint> DrawCommands : register(u0, space1);
+RWStructuredBuffer<uint> VisibleIds : register(u1, space1);
+RWStructuredBuffer<uint> LodState : register(u2, space1);
+
+cbuffer CullParams : register(b0, space2)
+{
+    float4 Planes[6];
+    float4 Camera;
+    float4 LodErrors[MESH_COUNT];
+    uint4 LodCounts;
+    uint ObjectCount;
+    float PixelError;
+    float Hysteresis;
+    uint OcclusionEnabled;
+    // The pyramid is from the last frame, the bounds are projected with the
+    // camera of that frame.
+    float4x4 PyramidViewProj;
+    uint4 PyramidSize;
+    uint4 PyramidOffsets[HIZ_MAX_LEVELS / 4];
+};
+
+// DrawCommands holds one SDL_GPUIndexedIndirectDrawCommand (5 uints) per
+// mesh LOD, the second uint of each is num_instances. The cull counters
+// follow the last command.
+#define DRAW_COMMAND_SIZE 5
+#define NUM_INSTANCES_OFFSET 1
+#define COUNTER_IN_FRUSTUM (DRAW_GROUP_COUNT * DRAW_COMMAND_SIZE)
+#define COUNTER_OCCLUDED (COUNTER_IN_FRUSTUM + 1)
+
+// PyramidSize.xy is the size of level 0, z the level count.
+bool IsOccluded(float4 bounds)
+{
+    float2 uv_min = float2(1.0f, 1.0f);
+    float2 uv_max = float2(0.0f, 0.0f);
+    float nearest = 1.0f;
+
+    [unroll]
+    for (uint i = 0; i < 8; ++i)
+    {
+        float3 corner = bounds.xyz + float3(
+                (i & 1) ? bounds.w : -bounds.w,
+                (i & 2) ? bounds.w : -bounds.w,
+                (i & 4) ? bounds.w : -bounds.w);
+
+        float4 clip = mul(PyramidViewProj, float4(corner, 1.0f));
+
+        // Crosses the near plane, the projection isn't usable.
+        if (clip.w <= 0.001f)
+        {
+            return false;
+        }
+
+        float3 ndc = clip.xyz / clip.w;
+        float2 uv = float2(ndc.x * 0.5f + 0.5f, 0.5f - ndc.y * 0.5f);
+
+        uv_min = min(uv_min, uv);
+        uv_max = max(uv_max, uv);
+        nearest = min(nearest, ndc.z);
+    }
+
+    uv_min = saturate(uv_min);
+    uv_max = saturate(uv_max);
+
+    // Pick the level where the bounds cover at most 2x2 texels.
+    float2 extent = (uv_max - uv_min) * float2(PyramidSize.xy);
+    uint level = (uint)clamp(ceil(log2(max(max(extent.x, extent.y), 1.0f))), 0.0f, (float)(PyramidSize.z - 1));
+
+    uint2 size = max(PyramidSize.xy >> level, uint2(1, 1));
+    uint offset = PyramidOffsets[level / 4][level % 4];
+
+    uint2 first = min((uint2)(uv_min * float2(size)), size - 1);
+    uint2 last = min((uint2)(uv_max * float2(size)), size - 1);
+
+    float farthest = 0.0f;
+
+    for (uint y = first.y; y <= last.y; ++y)
+    {
+        for (uint x = first.x; x <= last.x; ++x)
+        {
+            farthest = max(farthest, DepthPyramid[offset + y * size.x + x]);
+        }
+    }
+
+    return nearest > farthest;
+}
+
+// Same selection as APP_LODSelector_Select in lod.c.
+uint SelectLod(uint mesh, float radius, float distance, uint current)
+{
+    uint count = LodCounts[mesh];
+    if (PixelError < 0.0f || count <= 1)
+    {
+        return 0;
+    }
+
+    float scale = radius * Camera.w / max(distance, 0.001f);
+    float coarsen = PixelError * (1.0f - Hysteresis);
+
+    uint lod = min(current, count - 1);
+
+    while (lod > 0 && LodErrors[mesh][lod] * scale > PixelError)
+    {
+        lod--;
+    }
+
+    while (lod + 1 < count && LodErrors[mesh][lod + 1] * scale <= coarsen)
+    {
+        lod++;
+    }
+
+    return lod;
+}
+
+[numthreads(64, 1, 1)]
+void main(uint3 GlobalInvocationID : SV_DispatchThreadID)
+{
+    uint index = GlobalInvocationID.x;
+    if (index >= ObjectCount)
+    {
+        return;
+    }
+
+    SceneObject object = Objects[index];
+    float4 bounds = object.Bounds;
+
+    [unroll]
+    for (uint i = 0; i < 6; ++i)
+    {
+        if (dot(Planes[i].xyz, bounds.xyz) + Planes[i].w < -bounds.w)
+        {
+            return;
+        }
+    }
+
+    InterlockedAdd(DrawCommands[COUNTER_IN_FRUSTUM], 1);
+
+    if (OcclusionEnabled != 0 && IsOccluded(bounds))
+    {
+        InterlockedAdd(DrawCommands[COUNTER_OCCLUDED], 1);
+        return;
+    }
+
+    float distance = max(length(bounds.xyz - Camera.xyz) - bounds.w, 0.0f);
+    uint lod = SelectLod(object.Mesh, bounds.w, distance, LodState[index]);
+    LodState[index] = lod;
+
+    uint group = object.Mesh * MAX_MESH_LODS + lod;
+
+    uint slot;
+    InterlockedAdd(DrawCommands[group * DRAW_COMMAND_SIZE + NUM_INSTANCES_OFFSET], 1, slot);
+    VisibleIds[group * ObjectCount + slot] = index;
+}
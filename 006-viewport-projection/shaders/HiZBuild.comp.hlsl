@@ -0,0 +1,61 @@
+Texture2D<float> Depth : register(t0, space0);
+SamplerState DepthSampler : register(s0, space0);
+
+RWStructuredBuffer<float> Pyramid : register(u0, space1);
+
+cbuffer BuildParams : register(b0, space2)
+{
+    uint2 SourceSize;
+    uint2 DestinationSize;
+    uint SourceOffset;
+    uint DestinationOffset;
+    uint FromDepth;
+};
+
+float LoadSource(uint x, uint y)
+{
+    if (FromDepth != 0)
+    {
+        return Depth.Load(int3(x, y, 0));
+    }
+
+    return Pyramid[SourceOffset + y * SourceSize.x + x];
+}
+
+// Every texel keeps the farthest depth of the 2x2 texels below it. The last
+// column and row of an odd sized source are folded into the last texel, so
+// nothing is lost.
+[numthreads(8, 8, 1)]
+void main(uint3 GlobalInvocationID : SV_DispatchThreadID)
+{
+    uint2 texel = GlobalInvocationID.xy;
+    if (texel.x >= DestinationSize.x || texel.y >= DestinationSize.y)
+    {
+        return;
+    }
+
+    uint2 first = texel * 2;
+    uint2 last = min(first + 1, SourceSize - 1);
+
+    if (texel.x == DestinationSize.x - 1)
+    {
+        last.x = SourceSize.x - 1;
+    }
+
+    if (texel.y == DestinationSize.y - 1)
+    {
+        last.y = SourceSize.y - 1;
+    }
+
+    float depth = 0.0f;
+
+    for (uint y = first.y; y <= last.y; ++y)
+    {
+        for (uint x = first.x; x <= last.x; ++x)
+        {
+            depth = max(depth, LoadSource(x, y));
+        }
+    }
+
+    Pyramid[DestinationOffset + texel.y * DestinationSize.x + texel.x] = depth;
+}
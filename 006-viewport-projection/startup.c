@@ -0,0 +1,196 @@
+#include "startup.h"
+#include "app.h"
+
+static double
+APP_StartupMs(Uint64 ticks)
+{
+    return (double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+// Origin is taken before SDL_Init, so the report covers it.
+void
+APP_Startup_Begin(struct APP_StartupReport *report, Uint64 origin, bool parallel)
+{
+    SDL_zerop(report);
+    report->origin = origin;
+    report->parallel = parallel;
+    report->lock = SDL_CreateMutex();
+}
+
+// Record a phase from start until now. Safe to call from the task threads.
+void
+APP_Startup_AddPhase(
+        struct APP_StartupReport *report,
+        const char *name,
+        const char *lane,
+        Uint64 start
+)
+{
+    Uint64 end = SDL_GetPerformanceCounter();
+
+    SDL_LockMutex(report->lock);
+
+    if (!report->finished && report->phase_count < APP_MAX_STARTUP_PHASES)
+    {
+        struct APP_StartupPhase *phase = &report->phases[report->phase_count++];
+        SDL_strlcpy(phase->name, name, sizeof(phase->name));
+        phase->lane = lane;
+        phase->start = start;
+        phase->end = end;
+    }
+
+    SDL_UnlockMutex(report->lock);
+}
+
+static int
+APP_StartupTaskThread(void *data)
+{
+    struct APP_StartupTask *task = data;
+    return task->fn(task->ctx);
+}
+
+// Run fn on its own thread. Without the parallel startup it runs right
+// here, which gives the serial baseline to compare the report against.
+bool
+APP_Startup_StartTask(
+        struct APP_Context *ctx,
+        struct APP_StartupTask *task,
+        const char *name,
+        APP_StartupFn fn
+)
+{
+    SDL_zerop(task);
+    task->name = name;
+    task->fn = fn;
+    task->ctx = ctx;
+    task->started = true;
+
+    if (ctx->startup.parallel)
+    {
+        task->thread = SDL_CreateThread(APP_StartupTaskThread, name, task);
+        if (task->thread != NULL)
+        {
+            return true;
+        }
+
+        SDL_Log("INFO: Failed to start '%s' thread, running it inline. %s", name, SDL_GetError());
+    }
+
+    task->result = fn(ctx);
+    return task->result != -1;
+}
+
+// Join the task and return its result. The time the main thread spent
+// blocked on it is a phase of its own, ideally a short one.
+int
+APP_Startup_WaitTask(struct APP_Context *ctx, struct APP_StartupTask *task)
+{
+    if (!task->started)
+    {
+        return -1;
+    }
+
+    if (task->thread != NULL)
+    {
+        char name[32];
+        SDL_snprintf(name, sizeof(name), "Wait %s", task->name);
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        SDL_WaitThread(task->thread, &task->result);
+        task->thread = NULL;
+
+        APP_Startup_AddPhase(&ctx->startup, name, "main", start);
+    }
+
+    return task->result;
+}
+
+// Join whatever is still running, used when the startup fails half way.
+void
+APP_Startup_WaitAllTasks(struct APP_Context *ctx)
+{
+    for (Uint32 i = 0; i < APP_STARTUP_TASK_COUNT; ++i)
+    {
+        struct APP_StartupTask *task = &ctx->startup_tasks[i];
+        if (task->thread != NULL)
+        {
+            SDL_WaitThread(task->thread, &task->result);
+            task->thread = NULL;
+        }
+    }
+}
+
+static int
+APP_CompareStartupPhases(const void *a, const void *b)
+{
+    const struct APP_StartupPhase *phase_a = a;
+    const struct APP_StartupPhase *phase_b = b;
+
+    if (phase_a->start != phase_b->start)
+    {
+        return phase_a->start < phase_b->start ? -1 : 1;
+    }
+
+    return phase_a->end < phase_b->end ? -1 : (phase_a->end > phase_b->end ? 1 : 0);
+}
+
+// Called once the first frame is submitted. Logs every phase with its start
+// relative to SDL_AppInit and how much of the work the threads overlapped.
+void
+APP_Startup_Finish(struct APP_StartupReport *report)
+{
+    if (report->finished)
+    {
+        return;
+    }
+
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    SDL_LockMutex(report->lock);
+    report->finished = true;
+    SDL_UnlockMutex(report->lock);
+
+    SDL_qsort(report->phases, report->phase_count, sizeof(struct APP_StartupPhase), APP_CompareStartupPhases);
+
+    double first_frame_ms = APP_StartupMs(now - report->origin);
+
+    SDL_Log(
+            "INFO: [startup] %.2f ms to the first frame, %s startup",
+            first_frame_ms,
+            report->parallel ? "parallel" : "serial"
+    );
+
+    // Note(john): The waits are the main thread idling on a task, they are
+    // not work and don't count towards the sum.
+    Uint64 work_ticks = 0;
+
+    for (Uint32 i = 0; i < report->phase_count; ++i)
+    {
+        const struct APP_StartupPhase *phase = &report->phases[i];
+
+        SDL_Log(
+                "INFO: [startup] %-20s %-10s at %8.2f ms %8.2f ms",
+                phase->name,
+                phase->lane,
+                APP_StartupMs(phase->start - report->origin),
+                APP_StartupMs(phase->end - phase->start)
+        );
+
+        if (SDL_strncmp(phase->name, "Wait ", 5) != 0)
+        {
+            work_ticks += phase->end - phase->start;
+        }
+    }
+
+    double work_ms = APP_StartupMs(work_ticks);
+
+    SDL_Log(
+            "INFO: [startup] %.2f ms of work in %.2f ms, %.2f ms overlapped",
+            work_ms,
+            first_frame_ms,
+            SDL_max(work_ms - first_frame_ms, 0.0)
+    );
+
+    SDL_DestroyMutex(report->lock);
+    report->lock = NULL;
+}
@@ -0,0 +1,27 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include "app.h"
+
+void APP_Startup_Begin(struct APP_StartupReport *report, Uint64 origin, bool parallel);
+
+void APP_Startup_AddPhase(
+        struct APP_StartupReport *report,
+        const char *name,
+        const char *lane,
+        Uint64 start
+);
+
+bool APP_Startup_StartTask(
+        struct APP_Context *ctx,
+        struct APP_StartupTask *task,
+        const char *name,
+        APP_StartupFn fn
+);
+
+int APP_Startup_WaitTask(struct APP_Context *ctx, struct APP_StartupTask *task);
+void APP_Startup_WaitAllTasks(struct APP_Context *ctx);
+
+void APP_Startup_Finish(struct APP_StartupReport *report);
+
+#endif
@@ -0,0 +1,466 @@
+#include "tlsf.h"
+
+static int
+APP_TLSFHighestBit(Uint32 value)
+{
+    int bit = -1;
+    while (value != 0)
+    {
+        value >>= 1;
+        bit++;
+    }
+
+    return bit;
+}
+
+static int
+APP_TLSFLowestBit(Uint32 value)
+{
+    if (value == 0)
+    {
+        return -1;
+    }
+
+    int bit = 0;
+    while ((value & 1) == 0)
+    {
+        value >>= 1;
+        bit++;
+    }
+
+    return bit;
+}
+
+// Sizes below APP_TLSF_SL_COUNT get one bucket each in the first level 0,
+// above that every power of two is split into APP_TLSF_SL_COUNT buckets.
+static void
+APP_TLSFMapping(Uint32 size, int *out_fl, int *out_sl)
+{
+    if (size < APP_TLSF_SL_COUNT)
+    {
+        *out_fl = 0;
+        *out_sl = (int)size;
+        return;
+    }
+
+    int bit = APP_TLSFHighestBit(size);
+    *out_fl = bit - APP_TLSF_SL_BITS + 1;
+    *out_sl = (int)((size >> (bit - APP_TLSF_SL_BITS)) ^ APP_TLSF_SL_COUNT);
+}
+
+static Uint32
+APP_TLSFNewBlock(struct APP_TLSF *tlsf)
+{
+    if (tlsf->unused_blocks != APP_TLSF_INVALID)
+    {
+        Uint32 handle = tlsf->unused_blocks;
+        tlsf->unused_blocks = tlsf->blocks[handle].next_free;
+        return handle;
+    }
+
+    if (tlsf->block_count == tlsf->block_capacity)
+    {
+        Uint32 capacity = SDL_max(tlsf->block_capacity * 2, 64);
+        struct APP_TLSFBlock *blocks = SDL_realloc(tlsf->blocks, sizeof(struct APP_TLSFBlock) * capacity);
+        if (blocks == NULL)
+        {
+            return APP_TLSF_INVALID;
+        }
+
+        tlsf->blocks = blocks;
+        tlsf->block_capacity = capacity;
+    }
+
+    return tlsf->block_count++;
+}
+
+static void
+APP_TLSFDeleteBlock(struct APP_TLSF *tlsf, Uint32 handle)
+{
+    tlsf->blocks[handle].size = 0;
+    tlsf->blocks[handle].free = false;
+    tlsf->blocks[handle].next_free = tlsf->unused_blocks;
+    tlsf->unused_blocks = handle;
+}
+
+static void
+APP_TLSFInsertFree(struct APP_TLSF *tlsf, Uint32 handle)
+{
+    struct APP_TLSFBlock *block = &tlsf->blocks[handle];
+
+    int fl, sl;
+    APP_TLSFMapping(block->size, &fl, &sl);
+
+    Uint32 head = tlsf->free_heads[fl][sl];
+
+    block->free = true;
+    block->prev_free = APP_TLSF_INVALID;
+    block->next_free = head;
+
+    if (head != APP_TLSF_INVALID)
+    {
+        tlsf->blocks[head].prev_free = handle;
+    }
+
+    tlsf->free_heads[fl][sl] = handle;
+    tlsf->fl_bitmap |= 1u << fl;
+    tlsf->sl_bitmap[fl] |= 1u << sl;
+}
+
+static void
+APP_TLSFRemoveFree(struct APP_TLSF *tlsf, Uint32 handle)
+{
+    struct APP_TLSFBlock *block = &tlsf->blocks[handle];
+
+    int fl, sl;
+    APP_TLSFMapping(block->size, &fl, &sl);
+
+    if (block->prev_free != APP_TLSF_INVALID)
+    {
+        tlsf->blocks[block->prev_free].next_free = block->next_free;
+    }
+    else
+    {
+        tlsf->free_heads[fl][sl] = block->next_free;
+    }
+
+    if (block->next_free != APP_TLSF_INVALID)
+    {
+        tlsf->blocks[block->next_free].prev_free = block->prev_free;
+    }
+
+    if (tlsf->free_heads[fl][sl] == APP_TLSF_INVALID)
+    {
+        tlsf->sl_bitmap[fl] &= ~(1u << sl);
+        if (tlsf->sl_bitmap[fl] == 0)
+        {
+            tlsf->fl_bitmap &= ~(1u << fl);
+        }
+    }
+
+    block->free = false;
+    block->prev_free = APP_TLSF_INVALID;
+    block->next_free = APP_TLSF_INVALID;
+}
+
+// Find a free block of at least size units. The size is rounded up to the
+// next bucket first, so every block in the found bucket is big enough.
+static Uint32
+APP_TLSFFindFree(struct APP_TLSF *tlsf, Uint32 size)
+{
+    if (size >= APP_TLSF_SL_COUNT)
+    {
+        Uint32 round = (1u << (APP_TLSFHighestBit(size) - APP_TLSF_SL_BITS)) - 1;
+        if (size > 0xFFFFFFFFu - round)
+        {
+            return APP_TLSF_INVALID;
+        }
+
+        size += round;
+    }
+
+    int fl, sl;
+    APP_TLSFMapping(size, &fl, &sl);
+
+    Uint32 sl_map = tlsf->sl_bitmap[fl] & (~0u << sl);
+    if (sl_map == 0)
+    {
+        Uint32 fl_map = fl + 1 < APP_TLSF_FL_COUNT ? tlsf->fl_bitmap & (~0u << (fl + 1)) : 0;
+        if (fl_map == 0)
+        {
+            return APP_TLSF_INVALID;
+        }
+
+        fl = APP_TLSFLowestBit(fl_map);
+        sl_map = tlsf->sl_bitmap[fl];
+    }
+
+    sl = APP_TLSFLowestBit(sl_map);
+    return tlsf->free_heads[fl][sl];
+}
+
+// Append a free block at the end of the address range.
+static bool
+APP_TLSFAppendFree(struct APP_TLSF *tlsf, Uint32 last, Uint32 offset, Uint32 size)
+{
+    Uint32 handle = APP_TLSFNewBlock(tlsf);
+    if (handle == APP_TLSF_INVALID)
+    {
+        return false;
+    }
+
+    tlsf->blocks[handle] = (struct APP_TLSFBlock){
+        .offset = offset,
+        .size = size,
+        .prev_physical = last,
+        .next_physical = APP_TLSF_INVALID,
+    };
+
+    if (last != APP_TLSF_INVALID)
+    {
+        tlsf->blocks[last].next_physical = handle;
+    }
+    else
+    {
+        tlsf->first_physical = handle;
+    }
+
+    APP_TLSFInsertFree(tlsf, handle);
+    return true;
+}
+
+bool
+APP_TLSF_Init(struct APP_TLSF *tlsf, Uint32 capacity)
+{
+    SDL_zerop(tlsf);
+
+    tlsf->unused_blocks = APP_TLSF_INVALID;
+    tlsf->first_physical = APP_TLSF_INVALID;
+
+    for (int fl = 0; fl < APP_TLSF_FL_COUNT; ++fl)
+    {
+        for (int sl = 0; sl < APP_TLSF_SL_COUNT; ++sl)
+        {
+            tlsf->free_heads[fl][sl] = APP_TLSF_INVALID;
+        }
+    }
+
+    tlsf->capacity = capacity;
+    if (capacity == 0)
+    {
+        return true;
+    }
+
+    return APP_TLSFAppendFree(tlsf, APP_TLSF_INVALID, 0, capacity);
+}
+
+void
+APP_TLSF_Release(struct APP_TLSF *tlsf)
+{
+    SDL_free(tlsf->blocks);
+    SDL_zerop(tlsf);
+}
+
+// Returns a handle to a range of size units or APP_TLSF_INVALID if there is
+// no free block big enough.
+Uint32
+APP_TLSF_Alloc(struct APP_TLSF *tlsf, Uint32 size)
+{
+    if (size == 0)
+    {
+        return APP_TLSF_INVALID;
+    }
+
+    Uint32 handle = APP_TLSFFindFree(tlsf, size);
+    if (handle == APP_TLSF_INVALID)
+    {
+        return APP_TLSF_INVALID;
+    }
+
+    APP_TLSFRemoveFree(tlsf, handle);
+
+    // Split the remainder off into a new free block.
+    if (tlsf->blocks[handle].size > size)
+    {
+        Uint32 rest = APP_TLSFNewBlock(tlsf);
+        if (rest != APP_TLSF_INVALID)
+        {
+            struct APP_TLSFBlock *block = &tlsf->blocks[handle];
+
+            tlsf->blocks[rest] = (struct APP_TLSFBlock){
+                .offset = block->offset + size,
+                .size = block->size - size,
+                .prev_physical = handle,
+                .next_physical = block->next_physical,
+            };
+
+            if (block->next_physical != APP_TLSF_INVALID)
+            {
+                tlsf->blocks[block->next_physical].prev_physical = rest;
+            }
+
+            block->next_physical = rest;
+            block->size = size;
+
+            APP_TLSFInsertFree(tlsf, rest);
+        }
+    }
+
+    tlsf->used += tlsf->blocks[handle].size;
+    tlsf->allocation_count++;
+
+    return handle;
+}
+
+// Free the range and merge it with free neighbours, so there are never two
+// free blocks next to each other.
+void
+APP_TLSF_Free(struct APP_TLSF *tlsf, Uint32 handle)
+{
+    if (handle == APP_TLSF_INVALID || tlsf->blocks[handle].free)
+    {
+        return;
+    }
+
+    tlsf->used -= tlsf->blocks[handle].size;
+    tlsf->allocation_count--;
+
+    Uint32 next = tlsf->blocks[handle].next_physical;
+    if (next != APP_TLSF_INVALID && tlsf->blocks[next].free)
+    {
+        APP_TLSFRemoveFree(tlsf, next);
+
+        tlsf->blocks[handle].size += tlsf->blocks[next].size;
+        tlsf->blocks[handle].next_physical = tlsf->blocks[next].next_physical;
+        if (tlsf->blocks[next].next_physical != APP_TLSF_INVALID)
+        {
+            tlsf->blocks[tlsf->blocks[next].next_physical].prev_physical = handle;
+        }
+
+        APP_TLSFDeleteBlock(tlsf, next);
+    }
+
+    Uint32 prev = tlsf->blocks[handle].prev_physical;
+    if (prev != APP_TLSF_INVALID && tlsf->blocks[prev].free)
+    {
+        APP_TLSFRemoveFree(tlsf, prev);
+
+        tlsf->blocks[prev].size += tlsf->blocks[handle].size;
+        tlsf->blocks[prev].next_physical = tlsf->blocks[handle].next_physical;
+        if (tlsf->blocks[handle].next_physical != APP_TLSF_INVALID)
+        {
+            tlsf->blocks[tlsf->blocks[handle].next_physical].prev_physical = prev;
+        }
+
+        APP_TLSFDeleteBlock(tlsf, handle);
+        handle = prev;
+    }
+
+    APP_TLSFInsertFree(tlsf, handle);
+}
+
+Uint32
+APP_TLSF_Offset(const struct APP_TLSF *tlsf, Uint32 handle)
+{
+    return tlsf->blocks[handle].offset;
+}
+
+Uint32
+APP_TLSF_Size(const struct APP_TLSF *tlsf, Uint32 handle)
+{
+    return tlsf->blocks[handle].size;
+}
+
+// Slide every allocation down to the start of the range and leave one free
+// block at the end. Handles stay the same, only their offsets change. The
+// move callback has to copy the data, it is called for every allocation,
+// not only the ones that moved, so the data can go into a new buffer.
+void
+APP_TLSF_Compact(struct APP_TLSF *tlsf, APP_TLSFMoveFn move, void *user_data)
+{
+    Uint32 cursor = 0;
+    Uint32 last = APP_TLSF_INVALID;
+    Uint32 handle = tlsf->first_physical;
+
+    tlsf->first_physical = APP_TLSF_INVALID;
+
+    while (handle != APP_TLSF_INVALID)
+    {
+        struct APP_TLSFBlock *block = &tlsf->blocks[handle];
+        Uint32 next = block->next_physical;
+
+        if (block->free)
+        {
+            APP_TLSFRemoveFree(tlsf, handle);
+            APP_TLSFDeleteBlock(tlsf, handle);
+        }
+        else
+        {
+            if (move != NULL)
+            {
+                move(handle, block->offset, cursor, block->size, user_data);
+            }
+
+            block->offset = cursor;
+            block->prev_physical = last;
+            block->next_physical = APP_TLSF_INVALID;
+
+            if (last != APP_TLSF_INVALID)
+            {
+                tlsf->blocks[last].next_physical = handle;
+            }
+            else
+            {
+                tlsf->first_physical = handle;
+            }
+
+            cursor += block->size;
+            last = handle;
+        }
+
+        handle = next;
+    }
+
+    if (cursor < tlsf->capacity)
+    {
+        APP_TLSFAppendFree(tlsf, last, cursor, tlsf->capacity - cursor);
+    }
+}
+
+// Extend the range, the new space is added to the last block if it's free.
+bool
+APP_TLSF_Grow(struct APP_TLSF *tlsf, Uint32 capacity)
+{
+    if (capacity <= tlsf->capacity)
+    {
+        return true;
+    }
+
+    Uint32 last = tlsf->first_physical;
+    while (last != APP_TLSF_INVALID && tlsf->blocks[last].next_physical != APP_TLSF_INVALID)
+    {
+        last = tlsf->blocks[last].next_physical;
+    }
+
+    Uint32 added = capacity - tlsf->capacity;
+
+    if (last != APP_TLSF_INVALID && tlsf->blocks[last].free)
+    {
+        APP_TLSFRemoveFree(tlsf, last);
+        tlsf->blocks[last].size += added;
+        APP_TLSFInsertFree(tlsf, last);
+    }
+    else if (!APP_TLSFAppendFree(tlsf, last, tlsf->capacity, added))
+    {
+        return false;
+    }
+
+    tlsf->capacity = capacity;
+    return true;
+}
+
+void
+APP_TLSF_GetStats(const struct APP_TLSF *tlsf, struct APP_TLSFStats *out_stats)
+{
+    SDL_zerop(out_stats);
+
+    out_stats->capacity = tlsf->capacity;
+    out_stats->used = tlsf->used;
+    out_stats->allocation_count = tlsf->allocation_count;
+
+    for (Uint32 handle = tlsf->first_physical; handle != APP_TLSF_INVALID; handle = tlsf->blocks[handle].next_physical)
+    {
+        const struct APP_TLSFBlock *block = &tlsf->blocks[handle];
+        if (block->free)
+        {
+            out_stats->free_block_count++;
+            out_stats->largest_free_block = SDL_max(out_stats->largest_free_block, block->size);
+        }
+    }
+
+    Uint32 free_units = tlsf->capacity - tlsf->used;
+    if (free_units > 0)
+    {
+        out_stats->fragmentation = 1.0f - (float)out_stats->largest_free_block / (float)free_units;
+    }
+}
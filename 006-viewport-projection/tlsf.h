@@ -0,0 +1,79 @@
+#ifndef TLSF_H
+#define TLSF_H
+
+#include <SDL3/SDL.h>
+
+// Two level segregated fit allocator over an abstract range of units. It
+// only keeps the block bookkeeping on the CPU, the caller decides what a
+// unit is (a vertex, an index, a byte).
+
+// Second level buckets per power of two.
+#define APP_TLSF_SL_BITS 4
+#define APP_TLSF_SL_COUNT (1 << APP_TLSF_SL_BITS)
+#define APP_TLSF_FL_COUNT 32
+
+#define APP_TLSF_INVALID 0xFFFFFFFFu
+
+struct APP_TLSFBlock {
+    Uint32 offset;
+    Uint32 size;
+
+    // Neighbours in address order.
+    Uint32 prev_physical;
+    Uint32 next_physical;
+    // Neighbours in the free list of the bucket. next_free also links the
+    // unused block slots.
+    Uint32 prev_free;
+    Uint32 next_free;
+
+    bool free;
+};
+
+struct APP_TLSFStats {
+    Uint32 capacity;
+    Uint32 used;
+    Uint32 allocation_count;
+    Uint32 free_block_count;
+    Uint32 largest_free_block;
+    // 0 if all free space is one block, towards 1 the more it is split up.
+    float fragmentation;
+};
+
+struct APP_TLSF {
+    Uint32 capacity;
+
+    // Handles are indices into the block array, they stay valid when the
+    // array grows.
+    struct APP_TLSFBlock *blocks;
+    Uint32 block_capacity;
+    Uint32 block_count;
+    Uint32 unused_blocks;
+    Uint32 first_physical;
+
+    Uint32 fl_bitmap;
+    Uint32 sl_bitmap[APP_TLSF_FL_COUNT];
+    Uint32 free_heads[APP_TLSF_FL_COUNT][APP_TLSF_SL_COUNT];
+
+    Uint32 used;
+    Uint32 allocation_count;
+};
+
+// Called for every allocation during a compaction in address order, with the
+// old and the new offset.
+typedef void (*APP_TLSFMoveFn)(Uint32 handle, Uint32 old_offset, Uint32 new_offset, Uint32 size, void *user_data);
+
+bool APP_TLSF_Init(struct APP_TLSF *tlsf, Uint32 capacity);
+void APP_TLSF_Release(struct APP_TLSF *tlsf);
+
+Uint32 APP_TLSF_Alloc(struct APP_TLSF *tlsf, Uint32 size);
+void APP_TLSF_Free(struct APP_TLSF *tlsf, Uint32 handle);
+
+Uint32 APP_TLSF_Offset(const struct APP_TLSF *tlsf, Uint32 handle);
+Uint32 APP_TLSF_Size(const struct APP_TLSF *tlsf, Uint32 handle);
+
+void APP_TLSF_Compact(struct APP_TLSF *tlsf, APP_TLSFMoveFn move, void *user_data);
+bool APP_TLSF_Grow(struct APP_TLSF *tlsf, Uint32 capacity);
+
+void APP_TLSF_GetStats(const struct APP_TLSF *tlsf, struct APP_TLSFStats *out_stats);
+
+#endif
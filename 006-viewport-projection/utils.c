@@ -1,75 +1,38 @@
 #include "app.h"
+#include "pack.h"
 
-// Load a image from a specified path.
-SDL_Surface*
-APP_LoadImage(struct APP_Context *cxt, const char *image_filenamen, int desired_channels)
+// Read an asset by its path relative to the example, from the pack if it
+// has the asset and from the loose file otherwise. Data read from disk or
+// decompressed is returned in out_owned, release it with SDL_free. Data
+// from the pack stays valid as long as the pack is open.
+static const void*
+APP_ReadAsset(struct APP_Context *cxt, const char *asset_path, size_t *out_size, void **out_owned)
 {
-    char full_path[256];
-    SDL_Surface *result;
-    SDL_PixelFormat format;
-
-    SDL_snprintf(full_path, sizeof(full_path), "%simages/%s", cxt->base_path, image_filenamen);
-
-    SDL_Log("INFO: Load bmp from path: %s", full_path);
-
-    result = SDL_LoadBMP(full_path);
-    if(result == NULL)
-    {
-        SDL_Log("ERROR: Failed to load bmp: %s", SDL_GetError());
-        return NULL;
-    }
-
-    if(desired_channels == 4)
+    const void *data = APP_Pack_Read(cxt->pack, asset_path, out_size, out_owned);
+    if(data != NULL)
     {
-        format = SDL_PIXELFORMAT_ABGR8888;
-    }
-    else
-    {
-        SDL_assert(!"Unexpected desiredChannels");
-        SDL_DestroySurface(result);
-        SDL_Log("ERROR: Unexpected desiredChannels");
-        return NULL;
+        return data;
     }
 
-    if(result->format != format)
-    {
-        SDL_Surface *next = SDL_ConvertSurface(result, format);
-        SDL_DestroySurface(result);
-        result = next;
-    }
+    char full_path[256];
+    SDL_snprintf(full_path, sizeof(full_path), "%s%s", cxt->base_path, asset_path);
 
-    SDL_Log("INFO: Image width: %i height: %i", result->w, result->w);
-    return result;
+    *out_owned = SDL_LoadFile(full_path, out_size);
+    return *out_owned;
 }
 
-// Load the compiled shader from a specified path.
-SDL_GPUShader*
-APP_LoadShader(
-        struct APP_Context *cxt, 
-        const char *shader_filename, 
-        Uint32 sampler_count, 
-        Uint32 uniform_buffer_count,
-        Uint32 storage_buffer_count, 
-        Uint32 storage_texture_count
+// Resolve the compiled shader blob for the backend of the device and read
+// it from the pack or disk. Release out_owned with SDL_free.
+static const void*
+APP_ReadShaderCode(
+        struct APP_Context *cxt,
+        const char *shader_filename,
+        SDL_GPUShaderFormat *out_format,
+        size_t *out_code_size,
+        void **out_owned
 )
 {
-    SDL_GPUShaderStage stage;
-    if(SDL_strstr(shader_filename, ".vert"))
-    {
-        stage = SDL_GPU_SHADERSTAGE_VERTEX;
-    }
-    else if(SDL_strstr(shader_filename, ".frag"))
-    {
-        stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
-    }
-    else
-    {
-        SDL_Log("ERROR: Invalid shader stage");
-        return NULL;
-    }
-
-    char full_path[256];
-    const char *entrypoint;
+    char asset_path[256];
 
     SDL_GPUShaderFormat backend_formats = SDL_GetGPUShaderFormats(cxt->device);
     SDL_GPUShaderFormat format = SDL_GPU_SHADERFORMAT_INVALID;
@@ -79,44 +42,38 @@ APP_LoadShader(
         SDL_Log("INFO: Use SPIRV shader format");
         
         SDL_snprintf(
-                full_path, 
-                sizeof(full_path), 
-                "%sshaders/compiled/SPIRV/%s.spv", 
-                cxt->base_path, 
+                asset_path, 
+                sizeof(asset_path), 
+                "shaders/compiled/SPIRV/%s.spv", 
                 shader_filename
         );
         
         format = SDL_GPU_SHADERFORMAT_SPIRV;
-        entrypoint = "main";
     }
     else if(backend_formats & SDL_GPU_SHADERFORMAT_MSL)
     {
         SDL_Log("INFO: Use MSL shader format");
         SDL_snprintf(
-                full_path, 
-                sizeof(full_path), 
-                "%sshaders/compiled/MSL/%s.msl", 
-                cxt->base_path, 
+                asset_path, 
+                sizeof(asset_path), 
+                "shaders/compiled/MSL/%s.msl", 
                 shader_filename
         );
 
-        format     = SDL_GPU_SHADERFORMAT_MSL;
-        entrypoint = "main";
+        format = SDL_GPU_SHADERFORMAT_MSL;
     }
     else if(backend_formats & SDL_GPU_SHADERFORMAT_DXIL)
     {
         SDL_Log("INFO: Use DXIL shader format");
 
         SDL_snprintf(
-                full_path, 
-                sizeof(full_path), 
-                "%sshaders/compiled/DXIL/%s.dxil", 
-                cxt->base_path, 
+                asset_path, 
+                sizeof(asset_path), 
+                "shaders/compiled/DXIL/%s.dxil", 
                 shader_filename
         );
 
         format = SDL_GPU_SHADERFORMAT_DXIL;
-        entrypoint = "main";
     }
     else
     {
@@ -124,11 +81,122 @@ APP_LoadShader(
         return NULL;
     }
 
+    const void *code = APP_ReadAsset(cxt, asset_path, out_code_size, out_owned);
+    if(code == NULL)
+    {
+        SDL_Log("ERROR: Failed to load shader: %s", asset_path);
+        return NULL;
+    }
+
+    *out_format = format;
+    return code;
+}
+
+// Read the blobs of all shaders up front, so creating the pipelines later
+// doesn't wait on the disk. Runs on the device task right after the device
+// exists, since the backend decides the format.
+int
+APP_PreloadShaders(struct APP_Context *cxt, const char *const *shader_filenames, Uint32 count)
+{
+    for (Uint32 i = 0; i < count; ++i)
+    {
+        if (cxt->shader_blob_count == APP_MAX_SHADER_BLOBS)
+        {
+            SDL_Log("ERROR: Too many shader blobs to preload.");
+            return -1;
+        }
+
+        struct APP_ShaderBlob *blob = &cxt->shader_blobs[cxt->shader_blob_count];
+        blob->filename = shader_filenames[i];
+        blob->code = APP_ReadShaderCode(cxt, blob->filename, &blob->format, &blob->code_size, &blob->owned);
+
+        if (blob->code == NULL)
+        {
+            return -1;
+        }
+
+        cxt->shader_blob_count++;
+    }
+
+    return 0;
+}
+
+void
+APP_ReleaseShaderBlobs(struct APP_Context *cxt)
+{
+    for (Uint32 i = 0; i < cxt->shader_blob_count; ++i)
+    {
+        SDL_free(cxt->shader_blobs[i].owned);
+    }
+
+    SDL_zeroa(cxt->shader_blobs);
+    cxt->shader_blob_count = 0;
+}
+
+// Take the blob from the preloaded ones if it is there, read it otherwise.
+// Preloaded blobs stay around until APP_ReleaseShaderBlobs, a shader may
+// be created from them more than once, so only out_owned is released.
+static const void*
+APP_LoadShaderCode(
+        struct APP_Context *cxt,
+        const char *shader_filename,
+        SDL_GPUShaderFormat *out_format,
+        const char **out_entrypoint,
+        size_t *out_code_size,
+        void **out_owned
+)
+{
+    *out_entrypoint = "main";
+    *out_owned = NULL;
+
+    for (Uint32 i = 0; i < cxt->shader_blob_count; ++i)
+    {
+        const struct APP_ShaderBlob *blob = &cxt->shader_blobs[i];
+        if (SDL_strcmp(blob->filename, shader_filename) == 0)
+        {
+            *out_format = blob->format;
+            *out_code_size = blob->code_size;
+            return blob->code;
+        }
+    }
+
+    return APP_ReadShaderCode(cxt, shader_filename, out_format, out_code_size, out_owned);
+}
+
+// Load the compiled shader from a specified path.
+SDL_GPUShader*
+APP_LoadShader(
+        struct APP_Context *cxt, 
+        const char *shader_filename, 
+        Uint32 sampler_count, 
+        Uint32 uniform_buffer_count,
+        Uint32 storage_buffer_count, 
+        Uint32 storage_texture_count
+)
+{
+    SDL_GPUShaderStage stage;
+    if(SDL_strstr(shader_filename, ".vert"))
+    {
+        stage = SDL_GPU_SHADERSTAGE_VERTEX;
+    }
+    else if(SDL_strstr(shader_filename, ".frag"))
+    {
+        stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
+    }
+    else
+    {
+        SDL_Log("ERROR: Invalid shader stage");
+        return NULL;
+    }
+
+    SDL_GPUShaderFormat format;
+    const char *entrypoint;
     size_t code_size;
-    void *code = SDL_LoadFile(full_path, &code_size);
+    void *owned;
+
+    const void *code = APP_LoadShaderCode(cxt, shader_filename, &format, &entrypoint, &code_size, &owned);
     if(code == NULL)
     {
-        SDL_Log("ERROR: Failed to load shader from disk: %s", full_path);
         return NULL;
     }
 
@@ -148,10 +216,59 @@ APP_LoadShader(
     if(shader == NULL)
     {
         SDL_Log("ERROR: Failed to create shader.");
-        SDL_free(code);
+        SDL_free(owned);
         return NULL;
     }
 
-    SDL_free(code);
+    SDL_free(owned);
     return shader;
 }
+
+// Load a compiled compute shader and create the pipeline for it. The
+// resource counts and thread counts are taken from create_info, the code,
+// format and entrypoint are filled in here.
+SDL_GPUComputePipeline*
+APP_LoadComputePipeline(
+        struct APP_Context *cxt,
+        const char *shader_filename,
+        const SDL_GPUComputePipelineCreateInfo *create_info
+)
+{
+    if(!SDL_strstr(shader_filename, ".comp"))
+    {
+        SDL_Log("ERROR: Invalid shader stage");
+        return NULL;
+    }
+
+    SDL_GPUComputePipelineCreateInfo pipeline_info = *create_info;
+    size_t code_size;
+    void *owned;
+
+    const void *code = APP_LoadShaderCode(
+            cxt,
+            shader_filename,
+            &pipeline_info.format,
+            &pipeline_info.entrypoint,
+            &code_size,
+            &owned
+    );
+
+    if(code == NULL)
+    {
+        return NULL;
+    }
+
+    pipeline_info.code = code;
+    pipeline_info.code_size = code_size;
+
+    SDL_GPUComputePipeline *pipeline = SDL_CreateGPUComputePipeline(cxt->device, &pipeline_info);
+    if(pipeline == NULL)
+    {
+        SDL_Log("ERROR: Failed to create compute pipeline. %s", SDL_GetError());
+        SDL_free(owned);
+        return NULL;
+    }
+
+    SDL_free(owned);
+    return pipeline;
+}
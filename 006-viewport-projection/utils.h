@@ -3,12 +3,6 @@
 
 #include "app.h"
 
-SDL_Surface *APP_LoadImage(
-        struct APP_Context *cxt, 
-        const char *image_filenamen, 
-        int desired_channels
-);
-
 SDL_GPUShader *APP_LoadShader(
         struct APP_Context *context, 
         const char *shader_filename,
@@ -18,4 +12,18 @@ SDL_GPUShader *APP_LoadShader(
         Uint32 storage_texture_count
 );
 
+SDL_GPUComputePipeline *APP_LoadComputePipeline(
+        struct APP_Context *cxt,
+        const char *shader_filename,
+        const SDL_GPUComputePipelineCreateInfo *create_info
+);
+
+int APP_PreloadShaders(
+        struct APP_Context *cxt,
+        const char *const *shader_filenames,
+        Uint32 count
+);
+
+void APP_ReleaseShaderBlobs(struct APP_Context *cxt);
+
 #endif
@@ -0,0 +1,650 @@
+#include "adpcm.h"
+
+// Each channel's block header: the first sample, the step index and a
+// reserved byte.
+#define APP_ADPCM_HEADER_BYTES 4
+// Eight samples of one channel.
+#define APP_ADPCM_GROUP_BYTES 4
+#define APP_ADPCM_MAX_STEP_INDEX 88
+#define APP_ADPCM_SCALE (1.0f / 32768.0f)
+
+static const Sint16 APP_ADPCM_STEPS[APP_ADPCM_MAX_STEP_INDEX + 1] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const Sint8 APP_ADPCM_INDEX_STEPS[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+// What a nibble adds to the predictor, the encoder steps through the same
+// way so both sides agree on the state.
+static inline Sint32
+APP_ADPCM_Difference(Sint32 step_index, Uint32 nibble)
+{
+    Sint32 step = APP_ADPCM_STEPS[step_index];
+    Sint32 diff = step >> 3;
+    diff += (nibble & 4) ? step : 0;
+    diff += (nibble & 2) ? step >> 1 : 0;
+    diff += (nibble & 1) ? step >> 2 : 0;
+    return (nibble & 8) ? -diff : diff;
+}
+
+static inline Sint32
+APP_ADPCM_Step(Sint32 *predictor, Sint32 *step_index, Uint32 nibble)
+{
+    Sint32 value = *predictor + APP_ADPCM_Difference(*step_index, nibble);
+    *predictor = SDL_clamp(value, -32768, 32767);
+    *step_index = SDL_clamp(*step_index + APP_ADPCM_INDEX_STEPS[nibble], 0, APP_ADPCM_MAX_STEP_INDEX);
+    return *predictor;
+}
+
+// The decoder looks both halves of a step up, one row of 16 nibbles per
+// step index, which leaves only the add and the clamp of the predictor in
+// the chain from one sample to the next.
+struct APP_ADPCMEntry {
+    Sint32 diff;
+    // The next step index's row, the index times 16.
+    Sint32 next_row;
+};
+
+static struct APP_ADPCMEntry APP_ADPCM_TABLE[(APP_ADPCM_MAX_STEP_INDEX + 1) * 16];
+static SDL_InitState APP_ADPCM_table_init;
+
+// Once for every sound that gets loaded, the first fills the table.
+static void
+APP_ADPCM_InitTable(void)
+{
+    if (!SDL_ShouldInit(&APP_ADPCM_table_init))
+    {
+        return;
+    }
+
+    for (Sint32 index = 0; index <= APP_ADPCM_MAX_STEP_INDEX; ++index)
+    {
+        for (Uint32 nibble = 0; nibble < 16; ++nibble)
+        {
+            Sint32 next = SDL_clamp(index + APP_ADPCM_INDEX_STEPS[nibble], 0, APP_ADPCM_MAX_STEP_INDEX);
+            struct APP_ADPCMEntry *entry = &APP_ADPCM_TABLE[index * 16 + nibble];
+            entry->diff = APP_ADPCM_Difference(index, nibble);
+            entry->next_row = next * 16;
+        }
+    }
+
+    SDL_SetInitialized(&APP_ADPCM_table_init, true);
+}
+
+static inline float
+APP_ADPCM_Lookup(Sint32 *predictor, Sint32 *row, Uint32 nibble)
+{
+    const struct APP_ADPCMEntry *entry = &APP_ADPCM_TABLE[*row + nibble];
+    Sint32 value = *predictor + entry->diff;
+    *predictor = SDL_clamp(value, -32768, 32767);
+    *row = entry->next_row;
+    return (float)*predictor * APP_ADPCM_SCALE;
+}
+
+Uint32
+APP_ADPCM_GetBlockFrames(Uint32 block_bytes, Uint32 channels)
+{
+    return (block_bytes / channels - APP_ADPCM_HEADER_BYTES) * 2 + 1;
+}
+
+// ============================================================================
+// Loading
+// ============================================================================
+
+struct APP_ADPCMFormat {
+    Uint16 format_tag;
+    Uint16 channels;
+    Uint32 freq;
+    Uint16 block_align;
+    Uint16 bits;
+    // From the fact chunk, 0 without one.
+    Uint32 frame_count;
+};
+
+// Read chunks up to the samples, io is at the first of them after. Quiet
+// when it isn't a WAV, the caller decides whether that is an error.
+static bool
+APP_ADPCM_ReadHeader(SDL_IOStream *io, struct APP_ADPCMFormat *out_format, Uint32 *out_data_size)
+{
+    SDL_zerop(out_format);
+
+    Uint32 riff, riff_size, wave;
+    if (!SDL_ReadU32LE(io, &riff)
+        || !SDL_ReadU32LE(io, &riff_size)
+        || !SDL_ReadU32LE(io, &wave)
+        || riff != SDL_FOURCC('R', 'I', 'F', 'F')
+        || wave != SDL_FOURCC('W', 'A', 'V', 'E'))
+    {
+        return false;
+    }
+
+    bool has_format = false;
+
+    for (;;)
+    {
+        Uint32 id, chunk_size;
+        if (!SDL_ReadU32LE(io, &id) || !SDL_ReadU32LE(io, &chunk_size))
+        {
+            return false;
+        }
+
+        Uint32 consumed = 0;
+
+        if (id == SDL_FOURCC('f', 'm', 't', ' ') && chunk_size >= 16)
+        {
+            Uint32 byte_rate;
+            if (!SDL_ReadU16LE(io, &out_format->format_tag)
+                || !SDL_ReadU16LE(io, &out_format->channels)
+                || !SDL_ReadU32LE(io, &out_format->freq)
+                || !SDL_ReadU32LE(io, &byte_rate)
+                || !SDL_ReadU16LE(io, &out_format->block_align)
+                || !SDL_ReadU16LE(io, &out_format->bits))
+            {
+                return false;
+            }
+
+            consumed = 16;
+            has_format = true;
+        }
+        else if (id == SDL_FOURCC('f', 'a', 'c', 't') && chunk_size >= 4)
+        {
+            if (!SDL_ReadU32LE(io, &out_format->frame_count))
+            {
+                return false;
+            }
+
+            consumed = 4;
+        }
+        else if (id == SDL_FOURCC('d', 'a', 't', 'a'))
+        {
+            *out_data_size = chunk_size;
+            return has_format;
+        }
+
+        // Chunks are padded to an even size.
+        Uint32 skip = chunk_size - consumed + (chunk_size & 1);
+        if (SDL_SeekIO(io, skip, SDL_IO_SEEK_CUR) < 0)
+        {
+            return false;
+        }
+    }
+}
+
+bool
+APP_ADPCM_IsWAV(SDL_IOStream *io)
+{
+    Sint64 start = SDL_TellIO(io);
+    if (start < 0)
+    {
+        return false;
+    }
+
+    struct APP_ADPCMFormat format;
+    Uint32 data_size;
+    bool adpcm = APP_ADPCM_ReadHeader(io, &format, &data_size) && format.format_tag == APP_ADPCM_FORMAT_TAG;
+
+    SDL_SeekIO(io, start, SDL_IO_SEEK_SET);
+    return adpcm;
+}
+
+bool
+APP_ADPCM_LoadWAV(SDL_IOStream *io, struct APP_ADPCMSound *out_sound)
+{
+    SDL_zerop(out_sound);
+    APP_ADPCM_InitTable();
+
+    struct APP_ADPCMFormat format;
+    Uint32 data_size = 0;
+    if (!APP_ADPCM_ReadHeader(io, &format, &data_size) || format.format_tag != APP_ADPCM_FORMAT_TAG)
+    {
+        SDL_Log("ERROR: Not an IMA ADPCM WAV file.");
+        return false;
+    }
+
+    const Uint32 channels = format.channels;
+    const Uint32 header_bytes = APP_ADPCM_HEADER_BYTES * channels;
+    if (channels == 0
+        || channels > APP_ADPCM_MAX_CHANNELS
+        || format.freq == 0
+        || format.bits != 4
+        || format.block_align <= header_bytes
+        || format.block_align % (APP_ADPCM_GROUP_BYTES * channels) != 0)
+    {
+        SDL_Log(
+                "ERROR: Unsupported IMA ADPCM WAV, %u channels, %u bits, %u byte blocks.",
+                format.channels,
+                format.bits,
+                format.block_align
+        );
+        return false;
+    }
+
+    // Note(john): Recorders that were cut off leave the size open, the
+    // blocks go up to the end of the file then.
+    Sint64 file_size = SDL_GetIOSize(io);
+    Sint64 data_offset = SDL_TellIO(io);
+    if (file_size > 0 && data_offset + (Sint64)data_size > file_size)
+    {
+        data_size = (Uint32)(file_size - data_offset);
+    }
+
+    const Uint32 block_bytes = format.block_align;
+    const Uint32 block_frames = APP_ADPCM_GetBlockFrames(block_bytes, channels);
+    const Uint32 block_count = (data_size + block_bytes - 1) / block_bytes;
+
+    // A short last block holds the frames its groups reach.
+    Uint32 last_bytes = data_size - (block_count - 1) * block_bytes;
+    Uint32 last_frames = last_bytes > header_bytes
+        ? (last_bytes - header_bytes) / (APP_ADPCM_GROUP_BYTES * channels) * 8 + 1
+        : 1;
+    Uint32 frame_count = block_count > 0 ? (block_count - 1) * block_frames + last_frames : 0;
+
+    if (format.frame_count > 0)
+    {
+        frame_count = SDL_min(frame_count, format.frame_count);
+    }
+
+    if (frame_count == 0)
+    {
+        SDL_Log("ERROR: WAV file has no samples.");
+        return false;
+    }
+
+    // Whole blocks in memory, a short last one is padded with silence.
+    Uint8 *blocks = SDL_calloc(block_count, block_bytes);
+    if (blocks == NULL)
+    {
+        return false;
+    }
+
+    if (SDL_ReadIO(io, blocks, data_size) != data_size)
+    {
+        SDL_Log("ERROR: Failed to read IMA ADPCM samples. %s", SDL_GetError());
+        SDL_free(blocks);
+        return false;
+    }
+
+    out_sound->blocks = blocks;
+    out_sound->block_count = block_count;
+    out_sound->block_bytes = block_bytes;
+    out_sound->block_frames = block_frames;
+    out_sound->channels = channels;
+    out_sound->frame_count = frame_count;
+    out_sound->freq = (int)format.freq;
+    return true;
+}
+
+void
+APP_ADPCM_Free(struct APP_ADPCMSound *sound)
+{
+    if (sound == NULL)
+    {
+        return;
+    }
+
+    SDL_free(sound->blocks);
+    SDL_zerop(sound);
+}
+
+Uint64
+APP_ADPCM_GetSize(const struct APP_ADPCMSound *sound)
+{
+    return (Uint64)sound->block_count * sound->block_bytes;
+}
+
+// ============================================================================
+// Decoding
+// ============================================================================
+
+// count samples of channel c, starting at nibble first of the block. Whole
+// groups are taken a 32 bit word at a time, the low nibble comes first.
+static void
+APP_ADPCM_DecodeChannel(
+        const Uint8 *groups,
+        Uint32 channels,
+        Uint32 c,
+        Uint32 first,
+        Uint32 count,
+        Sint32 *predictor,
+        Sint32 *step_index,
+        float *dst
+)
+{
+    Sint32 value = *predictor;
+    Sint32 row = *step_index * 16;
+    Uint32 nibble = first;
+    Uint32 done = 0;
+
+    while (done < count)
+    {
+        const Uint8 *group = groups + ((nibble >> 3) * channels + c) * APP_ADPCM_GROUP_BYTES;
+
+        if ((nibble & 7) == 0 && count - done >= 8)
+        {
+            Uint32 word;
+            SDL_memcpy(&word, group, sizeof(word));
+            word = SDL_Swap32LE(word);
+
+            for (Uint32 k = 0; k < 8; ++k)
+            {
+                dst[done + k] = APP_ADPCM_Lookup(&value, &row, word & 15);
+                word >>= 4;
+            }
+
+            nibble += 8;
+            done += 8;
+            continue;
+        }
+
+        Uint32 k = nibble & 7;
+        Uint32 bits = (group[k >> 1] >> ((k & 1) * 4)) & 15;
+        dst[done++] = APP_ADPCM_Lookup(&value, &row, bits);
+        ++nibble;
+    }
+
+    *predictor = value;
+    *step_index = row / 16;
+}
+
+// Whole stereo groups, both channels side by side. Every sample waits for
+// the one before it in its channel, with two chains in one loop the core
+// works on the other while one waits.
+static void
+APP_ADPCM_DecodeStereo(
+        const Uint8 *groups,
+        Uint32 group_count,
+        struct APP_ADPCMDecoder *decoder,
+        float *left,
+        float *right
+)
+{
+    Sint32 left_value = decoder->predictor[0];
+    Sint32 right_value = decoder->predictor[1];
+    Sint32 left_row = decoder->step_index[0] * 16;
+    Sint32 right_row = decoder->step_index[1] * 16;
+
+    for (Uint32 g = 0; g < group_count; ++g)
+    {
+        Uint32 left_word, right_word;
+        SDL_memcpy(&left_word, groups, sizeof(left_word));
+        SDL_memcpy(&right_word, groups + APP_ADPCM_GROUP_BYTES, sizeof(right_word));
+        left_word = SDL_Swap32LE(left_word);
+        right_word = SDL_Swap32LE(right_word);
+        groups += APP_ADPCM_GROUP_BYTES * 2;
+
+        for (Uint32 k = 0; k < 8; ++k)
+        {
+            left[k] = APP_ADPCM_Lookup(&left_value, &left_row, left_word & 15);
+            right[k] = APP_ADPCM_Lookup(&right_value, &right_row, right_word & 15);
+            left_word >>= 4;
+            right_word >>= 4;
+        }
+
+        left += 8;
+        right += 8;
+    }
+
+    decoder->predictor[0] = left_value;
+    decoder->predictor[1] = right_value;
+    decoder->step_index[0] = left_row / 16;
+    decoder->step_index[1] = right_row / 16;
+}
+
+static void
+APP_ADPCM_DecodeEachChannel(
+        const struct APP_ADPCMSound *sound,
+        const Uint8 *groups,
+        Uint32 first,
+        Uint32 count,
+        struct APP_ADPCMDecoder *decoder,
+        float *const *dst,
+        Uint32 offset
+)
+{
+    for (Uint32 c = 0; c < sound->channels; ++c)
+    {
+        APP_ADPCM_DecodeChannel(
+                groups,
+                sound->channels,
+                c,
+                first,
+                count,
+                &decoder->predictor[c],
+                &decoder->step_index[c],
+                dst[c] + offset
+        );
+    }
+}
+
+Uint32
+APP_ADPCM_Decode(const struct APP_ADPCMSound *sound, struct APP_ADPCMDecoder *decoder, float *const *dst, Uint32 count)
+{
+    const Uint32 channels = sound->channels;
+    Uint32 done = 0;
+
+    while (done < count && decoder->frame < sound->frame_count)
+    {
+        Uint32 block = decoder->frame / sound->block_frames;
+        Uint32 in_block = decoder->frame - block * sound->block_frames;
+        const Uint8 *data = sound->blocks + (size_t)block * sound->block_bytes;
+
+        if (in_block == 0)
+        {
+            // Every block starts over with a full sample and the state.
+            for (Uint32 c = 0; c < channels; ++c)
+            {
+                const Uint8 *header = data + c * APP_ADPCM_HEADER_BYTES;
+                decoder->predictor[c] = (Sint16)(header[0] | (header[1] << 8));
+                decoder->step_index[c] = SDL_min(header[2], APP_ADPCM_MAX_STEP_INDEX);
+                dst[c][done] = (float)decoder->predictor[c] * APP_ADPCM_SCALE;
+            }
+
+            ++decoder->frame;
+            ++done;
+            continue;
+        }
+
+        Uint32 frames = SDL_min(count - done, sound->block_frames - in_block);
+        frames = SDL_min(frames, sound->frame_count - decoder->frame);
+
+        const Uint8 *groups = data + APP_ADPCM_HEADER_BYTES * channels;
+        const Uint32 first = in_block - 1;
+
+        // Note(john): Stereo goes a channel at a time only up to the next
+        // whole group and after the last.
+        Uint32 lead = frames;
+        Uint32 paired = 0;
+        if (channels == 2)
+        {
+            lead = SDL_min(frames, (8 - (first & 7)) & 7);
+            paired = (frames - lead) & ~7u;
+        }
+
+        APP_ADPCM_DecodeEachChannel(sound, groups, first, lead, decoder, dst, done);
+
+        if (paired > 0)
+        {
+            APP_ADPCM_DecodeStereo(
+                    groups + ((first + lead) >> 3) * APP_ADPCM_GROUP_BYTES * 2,
+                    paired / 8,
+                    decoder,
+                    dst[0] + done + lead,
+                    dst[1] + done + lead
+            );
+        }
+
+        APP_ADPCM_DecodeEachChannel(sound, groups, first + lead + paired, frames - lead - paired, decoder, dst, done + lead + paired);
+
+        decoder->frame += frames;
+        done += frames;
+    }
+
+    return done;
+}
+
+void
+APP_ADPCM_Seek(const struct APP_ADPCMSound *sound, struct APP_ADPCMDecoder *decoder, Uint32 frame)
+{
+    frame = SDL_min(frame, sound->frame_count);
+    decoder->frame = frame - frame % sound->block_frames;
+
+    // Note(john): The state inside a block only comes from decoding up to
+    // there, at most one block's worth.
+    float discard[APP_ADPCM_MAX_CHANNELS][64];
+    float *dst[APP_ADPCM_MAX_CHANNELS] = { discard[0], discard[1] };
+
+    while (decoder->frame < frame)
+    {
+        APP_ADPCM_Decode(sound, decoder, dst, SDL_min(frame - decoder->frame, (Uint32)SDL_arraysize(discard[0])));
+    }
+}
+
+// ============================================================================
+// Encoding
+// ============================================================================
+
+// The nibble that gets the predictor closest to sample, the state moves on
+// as the decoder's will.
+static Uint32
+APP_ADPCM_EncodeSample(Sint32 *predictor, Sint32 *step_index, Sint32 sample)
+{
+    Sint32 step = APP_ADPCM_STEPS[*step_index];
+    Sint32 diff = sample - *predictor;
+    Uint32 nibble = 0;
+
+    if (diff < 0)
+    {
+        nibble = 8;
+        diff = -diff;
+    }
+
+    for (Uint32 bit = 4; bit > 0; bit >>= 1)
+    {
+        if (diff >= step)
+        {
+            nibble |= bit;
+            diff -= step;
+        }
+
+        step >>= 1;
+    }
+
+    APP_ADPCM_Step(predictor, step_index, nibble);
+    return nibble;
+}
+
+static bool
+APP_ADPCM_WriteHeader(SDL_IOStream *out, Uint32 frame_count, Uint32 channels, int freq, Uint32 block_bytes, Uint32 data_size)
+{
+    const Uint32 block_frames = APP_ADPCM_GetBlockFrames(block_bytes, channels);
+    const Uint32 byte_rate = (Uint32)((Uint64)freq * block_bytes / block_frames);
+
+    bool ok = true;
+    ok &= SDL_WriteU32LE(out, SDL_FOURCC('R', 'I', 'F', 'F'));
+    ok &= SDL_WriteU32LE(out, 4 + (8 + 20) + (8 + 4) + (8 + data_size));
+    ok &= SDL_WriteU32LE(out, SDL_FOURCC('W', 'A', 'V', 'E'));
+
+    ok &= SDL_WriteU32LE(out, SDL_FOURCC('f', 'm', 't', ' '));
+    ok &= SDL_WriteU32LE(out, 20);
+    ok &= SDL_WriteU16LE(out, APP_ADPCM_FORMAT_TAG);
+    ok &= SDL_WriteU16LE(out, (Uint16)channels);
+    ok &= SDL_WriteU32LE(out, (Uint32)freq);
+    ok &= SDL_WriteU32LE(out, byte_rate);
+    ok &= SDL_WriteU16LE(out, (Uint16)block_bytes);
+    ok &= SDL_WriteU16LE(out, 4);
+    // The extension holds the frames per block.
+    ok &= SDL_WriteU16LE(out, 2);
+    ok &= SDL_WriteU16LE(out, (Uint16)block_frames);
+
+    ok &= SDL_WriteU32LE(out, SDL_FOURCC('f', 'a', 'c', 't'));
+    ok &= SDL_WriteU32LE(out, 4);
+    ok &= SDL_WriteU32LE(out, frame_count);
+
+    ok &= SDL_WriteU32LE(out, SDL_FOURCC('d', 'a', 't', 'a'));
+    ok &= SDL_WriteU32LE(out, data_size);
+    return ok;
+}
+
+bool
+APP_ADPCM_EncodeWAV(
+        const Sint16 *samples,
+        Uint32 frame_count,
+        Uint32 channels,
+        int freq,
+        Uint32 block_bytes,
+        SDL_IOStream *out
+)
+{
+    const Uint32 header_bytes = APP_ADPCM_HEADER_BYTES * channels;
+    if (channels == 0
+        || channels > APP_ADPCM_MAX_CHANNELS
+        || block_bytes <= header_bytes
+        || block_bytes > SDL_MAX_UINT16
+        || block_bytes % (APP_ADPCM_GROUP_BYTES * channels) != 0)
+    {
+        SDL_Log("ERROR: Can't encode %u channels in %u byte blocks.", channels, block_bytes);
+        return false;
+    }
+
+    const Uint32 block_frames = APP_ADPCM_GetBlockFrames(block_bytes, channels);
+    const Uint32 block_count = (frame_count + block_frames - 1) / block_frames;
+
+    Uint8 *block = SDL_malloc(block_bytes);
+    if (block == NULL)
+    {
+        return false;
+    }
+
+    bool ok = APP_ADPCM_WriteHeader(out, frame_count, channels, freq, block_bytes, block_count * block_bytes);
+
+    // The step index carries over from block to block, the predictor
+    // starts on each block's first sample.
+    Sint32 step_index[APP_ADPCM_MAX_CHANNELS] = { 0, 0 };
+
+    for (Uint32 b = 0; b < block_count && ok; ++b)
+    {
+        const Uint32 first = b * block_frames;
+        SDL_memset(block, 0, block_bytes);
+
+        for (Uint32 c = 0; c < channels; ++c)
+        {
+            Sint32 predictor = samples[(size_t)first * channels + c];
+            Uint8 *header = block + c * APP_ADPCM_HEADER_BYTES;
+            header[0] = (Uint8)(predictor & 0xFF);
+            header[1] = (Uint8)((predictor >> 8) & 0xFF);
+            header[2] = (Uint8)step_index[c];
+
+            Uint8 *groups = block + header_bytes;
+            for (Uint32 n = 0; n + 1 < block_frames; ++n)
+            {
+                // Silence after the last frame fills the last block.
+                Uint32 frame = first + 1 + n;
+                Sint32 sample = frame < frame_count ? samples[(size_t)frame * channels + c] : 0;
+                Uint32 nibble = APP_ADPCM_EncodeSample(&predictor, &step_index[c], sample);
+
+                Uint32 k = n & 7;
+                Uint8 *byte = groups + ((n >> 3) * channels + c) * APP_ADPCM_GROUP_BYTES + (k >> 1);
+                *byte |= (Uint8)(nibble << ((k & 1) * 4));
+            }
+        }
+
+        ok = SDL_WriteIO(out, block, block_bytes) == block_bytes;
+    }
+
+    SDL_free(block);
+
+    if (!ok)
+    {
+        SDL_Log("ERROR: Failed to write IMA ADPCM WAV. %s", SDL_GetError());
+    }
+
+    return ok;
+}
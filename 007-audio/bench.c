@@ -0,0 +1,740 @@
+#include "bench.h"
+
+#define BENCH_SECONDS 10
+#define BENCH_SEED 7
+
+static const int BENCH_RATES[] = { 44100, 48000 };
+static const Uint32 BENCH_VOICE_COUNTS[] = { 1, 16, 64, 256 };
+
+#define BENCH_RESAMPLE_SECONDS 5
+#define BENCH_RESAMPLE_AMPLITUDE 0.5
+// Outputs at either end left out of the error.
+#define BENCH_RESAMPLE_EDGE 64
+
+#define BENCH_SPATIAL_UPDATES 600
+#define BENCH_SPATIAL_VOICES 64
+#define BENCH_SPATIAL_RADIUS 400.0f
+#define BENCH_SPATIAL_PASS_ROUNDS 50
+
+static const Uint32 BENCH_EMITTER_COUNTS[] = { 256, 1024, 4096, 16384, 65536 };
+
+#define BENCH_ADPCM_FREQ 48000
+#define BENCH_ADPCM_DECODE_ROUNDS 20
+
+#define BENCH_EFFECTS_FREQ 48000
+// Buses that run each type of effect on their own.
+#define BENCH_EFFECTS_TYPE_BUSES 16
+
+static const Uint32 BENCH_EFFECT_BUS_COUNTS[] = { 1, 4, 16 };
+
+// One of every type. The chains run the last four.
+static const struct APP_EffectDesc BENCH_EFFECTS[] = {
+    { APP_EFFECT_LOWPASS, 2000.0f, 0.707f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+    { APP_EFFECT_HIGHPASS, 200.0f, 0.707f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+    { APP_EFFECT_EQ, 1000.0f, 1.0f, 6.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+    { APP_EFFECT_DELAY, 0.0f, 0.0f, 0.0f, 375.0f, 0.5f, 0.3f, 1.0f },
+    { APP_EFFECT_REVERB, 0.0f, 0.0f, 0.0f, 2500.0f, 0.0f, 0.4f, 1.0f },
+};
+
+#define BENCH_EFFECTS_CHAIN_FIRST 1
+
+struct APP_ResampleCase {
+    int src_freq;
+    int dst_freq;
+    double pitch;
+};
+
+static const struct APP_ResampleCase BENCH_RESAMPLE_CASES[] = {
+    { 44100, 48000, 1.0 },
+    { 48000, 44100, 1.0 },
+    { 22050, 48000, 1.0 },
+    { 48000, 22050, 1.0 },
+    { 44100, 44100, 1.37 },
+};
+
+// Render BENCH_SECONDS of voice_count looping voices, returns the mix time
+// in ms. Pitched voices play at random rates between half and twice the
+// sound's, the others at its own rate.
+static double
+APP_BenchmarkMix(const struct APP_Sound *sound, int freq, Uint32 voice_count, bool pitched)
+{
+    struct APP_Mixer *mixer = APP_Mixer_Create(freq);
+    if (mixer == NULL)
+    {
+        return 0.0;
+    }
+
+    SDL_srand(BENCH_SEED);
+
+    for (Uint32 i = 0; i < voice_count; ++i)
+    {
+        struct APP_VoiceParams params = {
+            1.0f / (float)voice_count,
+            SDL_randf() * 2.0f - 1.0f,
+            pitched ? 0.5f + SDL_randf() * 1.5f : 1.0f,
+            true,
+        };
+
+        APP_Mixer_Play(mixer, sound, &params);
+    }
+
+    float block[APP_MIXER_BLOCK_FRAMES * 2];
+    const Uint32 total_frames = (Uint32)freq * BENCH_SECONDS;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (Uint32 done = 0; done < total_frames; done += APP_MIXER_BLOCK_FRAMES)
+    {
+        APP_Mixer_Render(mixer, block, APP_MIXER_BLOCK_FRAMES);
+    }
+
+    double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+        / (double)SDL_GetPerformanceFrequency();
+
+    APP_Mixer_Destroy(mixer);
+    return ms;
+}
+
+void
+APP_BenchmarkMixer(const struct APP_Sound *sound)
+{
+    const double audio_ms = BENCH_SECONDS * 1000.0;
+
+    SDL_Log(
+            "INFO: [mix bench] %u Hz %s sound, %d s of audio per run",
+            (unsigned)sound->freq,
+            sound->channels == 1 ? "mono" : "stereo",
+            BENCH_SECONDS
+    );
+
+    for (size_t r = 0; r < SDL_arraysize(BENCH_RATES); ++r)
+    {
+        for (size_t v = 0; v < SDL_arraysize(BENCH_VOICE_COUNTS); ++v)
+        {
+            Uint32 voices = BENCH_VOICE_COUNTS[v];
+
+            for (int pitched = 0; pitched < 2; ++pitched)
+            {
+                double ms = APP_BenchmarkMix(sound, BENCH_RATES[r], voices, pitched != 0);
+
+                // Note(john): Microseconds of mixing per voice for every ms
+                // of audio, times 0.1 is the share of one core per voice in
+                // percent.
+                SDL_Log(
+                        "INFO: [mix bench] %d Hz, %3u voices, %-8s %.4f us per voice per ms, %.2f%% of one core",
+                        BENCH_RATES[r],
+                        voices,
+                        pitched ? "pitched" : "unpitched",
+                        ms * 1000.0 / (voices * audio_ms),
+                        ms * 100.0 / audio_ms
+                );
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Resampler
+// ============================================================================
+
+struct APP_ResampleRun {
+    const struct APP_Resampler *resampler;
+    enum APP_ResampleQuality quality;
+    int src_freq;
+    Uint64 step;
+    Uint32 src_frames;
+    Uint32 dst_frames;
+    float *src;
+    float *dst;
+};
+
+// A sine at tone Hz, with the frames the filter reads before the first and
+// after the last frame. Returns the first frame.
+static float *
+APP_BenchmarkFillSine(struct APP_ResampleRun *run, double tone)
+{
+    for (Sint64 i = -APP_RESAMPLER_MAX_TAPS; i < (Sint64)run->src_frames + APP_RESAMPLER_MAX_TAPS; ++i)
+    {
+        run->src[i + APP_RESAMPLER_MAX_TAPS] = (float)(BENCH_RESAMPLE_AMPLITUDE * SDL_sin(2.0 * SDL_PI_D * tone * (double)i / run->src_freq));
+    }
+
+    return run->src + APP_RESAMPLER_MAX_TAPS;
+}
+
+// Resample the whole source in mixer sized blocks, returns the seconds it
+// took.
+static double
+APP_BenchmarkResample(struct APP_ResampleRun *run, const float *first)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    Uint64 position = 0;
+    for (Uint32 done = 0; done < run->dst_frames; done += APP_MIXER_BLOCK_FRAMES)
+    {
+        Uint32 count = SDL_min(run->dst_frames - done, (Uint32)APP_MIXER_BLOCK_FRAMES);
+        APP_Resampler_Process(run->resampler, run->quality, run->dst + done, first, position, run->step, count);
+        position += run->step * count;
+    }
+
+    return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+// Signal to error of the output against the exact sine at the same times, in
+// dB.
+static double
+APP_BenchmarkSineError(const struct APP_ResampleRun *run, double tone)
+{
+    double signal = 0.0;
+    double error = 0.0;
+    const double step = (double)run->step / 4294967296.0;
+
+    for (Uint32 i = BENCH_RESAMPLE_EDGE; i + BENCH_RESAMPLE_EDGE < run->dst_frames; ++i)
+    {
+        double exact = BENCH_RESAMPLE_AMPLITUDE * SDL_sin(2.0 * SDL_PI_D * tone * (double)i * step / run->src_freq);
+        double diff = run->dst[i] - exact;
+        signal += exact * exact;
+        error += diff * diff;
+    }
+
+    return error > 0.0 ? 10.0 * SDL_log10(signal / error) : 200.0;
+}
+
+// Level of the output against the input, in dB.
+static double
+APP_BenchmarkLevel(const struct APP_ResampleRun *run)
+{
+    double power = 0.0;
+    Uint32 count = 0;
+
+    for (Uint32 i = BENCH_RESAMPLE_EDGE; i + BENCH_RESAMPLE_EDGE < run->dst_frames; ++i)
+    {
+        power += (double)run->dst[i] * run->dst[i];
+        ++count;
+    }
+
+    double input = BENCH_RESAMPLE_AMPLITUDE * BENCH_RESAMPLE_AMPLITUDE * 0.5;
+    return count > 0 && power > 0.0 ? 10.0 * SDL_log10(power / count / input) : -200.0;
+}
+
+void
+APP_BenchmarkResampler(void)
+{
+    struct APP_Resampler *resampler = APP_Resampler_Create();
+    if (resampler == NULL)
+    {
+        return;
+    }
+
+    SDL_Log("INFO: [resample bench] %d s of source per run, %d frame blocks", BENCH_RESAMPLE_SECONDS, APP_MIXER_BLOCK_FRAMES);
+
+    for (size_t c = 0; c < SDL_arraysize(BENCH_RESAMPLE_CASES); ++c)
+    {
+        const struct APP_ResampleCase *test = &BENCH_RESAMPLE_CASES[c];
+
+        struct APP_ResampleRun run;
+        run.resampler = resampler;
+        run.src_freq = test->src_freq;
+        run.src_frames = (Uint32)test->src_freq * BENCH_RESAMPLE_SECONDS;
+
+        double step = test->pitch * test->src_freq / test->dst_freq;
+        run.step = (Uint64)(step * 4294967296.0);
+        run.dst_frames = (Uint32)((double)(run.src_frames - 1) / step);
+
+        run.src = SDL_malloc(sizeof(float) * (run.src_frames + APP_RESAMPLER_MAX_TAPS * 2));
+        run.dst = SDL_malloc(sizeof(float) * run.dst_frames);
+        if (run.src == NULL || run.dst == NULL)
+        {
+            SDL_free(run.src);
+            SDL_free(run.dst);
+            break;
+        }
+
+        // Note(john): A low tone, one high in the band both rates share, and
+        // when the rate goes down one the output can't hold that has to be
+        // filtered out instead of folding back.
+        double output_nyquist = 0.5 * test->src_freq / step;
+        double band = SDL_min(0.5 * test->src_freq, output_nyquist);
+        double high_tone = 0.5 * band;
+        double alias_tone = 0.5 * (output_nyquist + 0.5 * test->src_freq);
+        bool down = step > 1.0;
+
+        for (int q = 0; q < APP_RESAMPLE_QUALITY_COUNT; ++q)
+        {
+            run.quality = (enum APP_ResampleQuality)q;
+
+            const float *first = APP_BenchmarkFillSine(&run, 1000.0);
+            double seconds = APP_BenchmarkResample(&run, first);
+            double low_snr = APP_BenchmarkSineError(&run, 1000.0);
+
+            first = APP_BenchmarkFillSine(&run, high_tone);
+            APP_BenchmarkResample(&run, first);
+            double high_snr = APP_BenchmarkSineError(&run, high_tone);
+
+            char alias[32] = "";
+            if (down)
+            {
+                first = APP_BenchmarkFillSine(&run, alias_tone);
+                APP_BenchmarkResample(&run, first);
+                SDL_snprintf(alias, sizeof(alias), ", alias %.1f dB", APP_BenchmarkLevel(&run));
+            }
+
+            SDL_Log(
+                    "INFO: [resample bench] %d -> %d Hz x%.2f %-6s %6.1f M samples/s, 1 kHz SNR %.1f dB, %.0f Hz SNR %.1f dB%s",
+                    test->src_freq,
+                    test->dst_freq,
+                    test->pitch,
+                    APP_Resampler_GetQualityName(run.quality),
+                    seconds > 0.0 ? (double)run.dst_frames / seconds / 1e6 : 0.0,
+                    low_snr,
+                    high_tone,
+                    high_snr,
+                    alias
+            );
+        }
+
+        SDL_free(run.src);
+        SDL_free(run.dst);
+    }
+
+    APP_Resampler_Destroy(resampler);
+}
+
+// ============================================================================
+// Spatial
+// ============================================================================
+
+static float
+APP_BenchmarkRandom(float range)
+{
+    return (SDL_randf() * 2.0f - 1.0f) * range;
+}
+
+void
+APP_BenchmarkSpatial(const struct APP_Sound *sound)
+{
+    const int freq = 48000;
+    const float dt = 1.0f / 60.0f;
+    const Uint32 frames_per_update = (Uint32)freq / 60;
+
+    SDL_Log(
+            "INFO: [spatial bench] %d updates at 60 Hz, %d voices, emitters within %.0f m",
+            BENCH_SPATIAL_UPDATES,
+            BENCH_SPATIAL_VOICES,
+            (double)BENCH_SPATIAL_RADIUS
+    );
+
+    for (size_t c = 0; c < SDL_arraysize(BENCH_EMITTER_COUNTS); ++c)
+    {
+        Uint32 count = BENCH_EMITTER_COUNTS[c];
+        struct APP_Mixer *mixer = APP_Mixer_Create(freq);
+        struct APP_Spatial *spatial = mixer != NULL ? APP_Spatial_Create(mixer, count, BENCH_SPATIAL_VOICES) : NULL;
+        float *block = SDL_malloc(sizeof(float) * 2 * frames_per_update);
+
+        if (spatial == NULL || block == NULL)
+        {
+            SDL_free(block);
+            APP_Spatial_Destroy(spatial);
+            APP_Mixer_Destroy(mixer);
+            return;
+        }
+
+        SDL_srand(BENCH_SEED);
+
+        for (Uint32 i = 0; i < count; ++i)
+        {
+            struct APP_EmitterDesc desc = {
+                sound,
+                { APP_BenchmarkRandom(BENCH_SPATIAL_RADIUS), APP_BenchmarkRandom(10.0f), APP_BenchmarkRandom(BENCH_SPATIAL_RADIUS) },
+                { APP_BenchmarkRandom(20.0f), 0.0f, APP_BenchmarkRandom(20.0f) },
+                1.0f,
+                2.0f,
+                BENCH_SPATIAL_RADIUS * 0.5f,
+                true,
+            };
+
+            APP_Spatial_AddEmitter(spatial, &desc);
+        }
+
+        // Note(john): The mixer renders the audio of every update so the
+        // voices the updates start and change go through the command ring
+        // like they would with a device.
+        double render_ms = 0.0;
+        struct APP_SpatialStats stats;
+        APP_Spatial_GetStats(spatial, &stats);
+
+        for (Uint32 u = 0; u < BENCH_SPATIAL_UPDATES; ++u)
+        {
+            struct APP_Listener listener = {
+                { (float)u * 0.5f, 0.0f, 0.0f },
+                { 30.0f, 0.0f, 0.0f },
+                { 0.0f, 0.0f, -1.0f },
+                { 0.0f, 1.0f, 0.0f },
+            };
+
+            APP_Spatial_SetListener(spatial, &listener);
+            APP_Spatial_Update(spatial, dt);
+
+            Uint64 start = SDL_GetPerformanceCounter();
+            APP_Mixer_Render(mixer, block, frames_per_update);
+            render_ms += (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+                / (double)SDL_GetPerformanceFrequency();
+        }
+
+        APP_Spatial_GetStats(spatial, &stats);
+        double scalar_rate = APP_Spatial_MeasurePass(spatial, false, BENCH_SPATIAL_PASS_ROUNDS);
+        double simd_rate = APP_Spatial_MeasurePass(spatial, true, BENCH_SPATIAL_PASS_ROUNDS);
+
+        SDL_Log(
+                "INFO: [spatial bench] %6u emitters, update %.3f ms mean %.3f ms max, %u audible, %u real, mix %.3f ms per update, pass %.0f emitters/us scalar, %.0f simd",
+                count,
+                stats.mean_update_ms,
+                stats.max_update_ms,
+                stats.audible,
+                stats.real,
+                render_ms / BENCH_SPATIAL_UPDATES,
+                scalar_rate,
+                simd_rate
+        );
+
+        SDL_free(block);
+        APP_Spatial_Destroy(spatial);
+        APP_Mixer_Destroy(mixer);
+    }
+}
+
+// ============================================================================
+// ADPCM
+// ============================================================================
+
+// The sound as interleaved 16 bit samples, what the encoder takes.
+static Sint16 *
+APP_BenchmarkToS16(const struct APP_Sound *sound)
+{
+    Sint16 *samples = SDL_malloc(sizeof(Sint16) * sound->channels * sound->frame_count);
+    if (samples == NULL)
+    {
+        return NULL;
+    }
+
+    for (Uint32 c = 0; c < sound->channels; ++c)
+    {
+        for (Uint32 i = 0; i < sound->frame_count; ++i)
+        {
+            float sample = SDL_clamp(sound->samples[c][i], -1.0f, 1.0f);
+            samples[i * sound->channels + c] = (Sint16)SDL_lroundf(sample * 32767.0f);
+        }
+    }
+
+    return samples;
+}
+
+static bool
+APP_BenchmarkEncode(const struct APP_Sound *sound, struct APP_Sound *out_sound)
+{
+    Sint16 *samples = APP_BenchmarkToS16(sound);
+    SDL_IOStream *io = SDL_IOFromDynamicMem();
+
+    bool ok = samples != NULL && io != NULL;
+    ok = ok && APP_ADPCM_EncodeWAV(
+            samples,
+            sound->frame_count,
+            sound->channels,
+            sound->freq,
+            APP_ADPCM_DEFAULT_CHANNEL_BLOCK_BYTES * sound->channels,
+            io
+    );
+    ok = ok && SDL_SeekIO(io, 0, SDL_IO_SEEK_SET) == 0;
+
+    SDL_free(samples);
+
+    if (!ok)
+    {
+        SDL_Log("ERROR: [adpcm bench] Failed to encode the sound. %s", SDL_GetError());
+        SDL_CloseIO(io);
+        return false;
+    }
+
+    // Closes io.
+    return APP_Sound_LoadWAV(io, out_sound);
+}
+
+// Decodes the whole sound in mixer sized pieces a few times over, returns
+// the nanoseconds per frame. The signal to error against the PCM sound goes
+// into out_snr_db.
+static double
+APP_BenchmarkDecode(const struct APP_Sound *pcm, const struct APP_Sound *adpcm, double *out_snr_db)
+{
+    float left[APP_MIXER_BLOCK_FRAMES];
+    float right[APP_MIXER_BLOCK_FRAMES];
+    float *const dst[2] = { left, right };
+
+    struct APP_ADPCMDecoder decoder;
+    double signal = 0.0;
+    double error = 0.0;
+    Uint64 ticks = 0;
+
+    for (int round = 0; round < BENCH_ADPCM_DECODE_ROUNDS; ++round)
+    {
+        APP_ADPCM_Seek(&adpcm->adpcm, &decoder, 0);
+
+        Uint32 done = 0;
+        while (done < adpcm->frame_count)
+        {
+            Uint64 start = SDL_GetPerformanceCounter();
+            Uint32 count = APP_ADPCM_Decode(&adpcm->adpcm, &decoder, dst, APP_MIXER_BLOCK_FRAMES);
+            ticks += SDL_GetPerformanceCounter() - start;
+
+            if (count == 0)
+            {
+                break;
+            }
+
+            // Note(john): Once is enough for the error, it's the same every
+            // round.
+            for (Uint32 c = 0; c < pcm->channels && round == 0; ++c)
+            {
+                for (Uint32 i = 0; i < count; ++i)
+                {
+                    double diff = dst[c][i] - pcm->samples[c][done + i];
+                    signal += (double)pcm->samples[c][done + i] * pcm->samples[c][done + i];
+                    error += diff * diff;
+                }
+            }
+
+            done += count;
+        }
+    }
+
+    *out_snr_db = error > 0.0 ? 10.0 * SDL_log10(signal / error) : 200.0;
+
+    double frames = (double)adpcm->frame_count * BENCH_ADPCM_DECODE_ROUNDS;
+    return (double)ticks * 1e9 / (double)SDL_GetPerformanceFrequency() / SDL_max(frames, 1.0);
+}
+
+void
+APP_BenchmarkADPCM(const struct APP_Sound *sound)
+{
+    if (sound->adpcm.blocks != NULL)
+    {
+        SDL_Log("ERROR: [adpcm bench] The sound is IMA ADPCM already, run it with a PCM WAV.");
+        return;
+    }
+
+    struct APP_Sound adpcm;
+    if (!APP_BenchmarkEncode(sound, &adpcm))
+    {
+        return;
+    }
+
+    const Uint64 float_bytes = APP_Sound_GetSize(sound);
+    const Uint64 s16_bytes = (Uint64)sound->frame_count * sound->channels * sizeof(Sint16);
+    const Uint64 adpcm_bytes = APP_Sound_GetSize(&adpcm);
+
+    double snr_db;
+    double decode_ns = APP_BenchmarkDecode(sound, &adpcm, &snr_db);
+
+    SDL_Log(
+            "INFO: [adpcm bench] %u Hz %s, %u frames, %llu bytes as float, %llu as 16 bit, %llu as ADPCM, %.1fx smaller than 16 bit",
+            (unsigned)sound->freq,
+            sound->channels == 1 ? "mono" : "stereo",
+            sound->frame_count,
+            (unsigned long long)float_bytes,
+            (unsigned long long)s16_bytes,
+            (unsigned long long)adpcm_bytes,
+            (double)s16_bytes / (double)SDL_max(adpcm_bytes, 1)
+    );
+
+    SDL_Log(
+            "INFO: [adpcm bench] decode %.2f ns per frame, %.1f M frames/s, SNR %.1f dB against the PCM sound",
+            decode_ns,
+            decode_ns > 0.0 ? 1000.0 / decode_ns : 0.0,
+            snr_db
+    );
+
+    const double audio_ms = BENCH_SECONDS * 1000.0;
+
+    for (size_t v = 0; v < SDL_arraysize(BENCH_VOICE_COUNTS); ++v)
+    {
+        Uint32 voices = BENCH_VOICE_COUNTS[v];
+
+        for (int pitched = 0; pitched < 2; ++pitched)
+        {
+            double pcm_ms = APP_BenchmarkMix(sound, BENCH_ADPCM_FREQ, voices, pitched != 0);
+            double adpcm_ms = APP_BenchmarkMix(&adpcm, BENCH_ADPCM_FREQ, voices, pitched != 0);
+
+            SDL_Log(
+                    "INFO: [adpcm bench] %d Hz, %3u voices, %-10s PCM %.2f%%, ADPCM %.2f%% of one core, %+.1f%%",
+                    BENCH_ADPCM_FREQ,
+                    voices,
+                    pitched ? "pitched" : "unpitched",
+                    pcm_ms * 100.0 / audio_ms,
+                    adpcm_ms * 100.0 / audio_ms,
+                    pcm_ms > 0.0 ? (adpcm_ms - pcm_ms) * 100.0 / pcm_ms : 0.0
+            );
+        }
+    }
+
+    APP_Sound_Free(&adpcm);
+}
+
+// ============================================================================
+// Effects
+// ============================================================================
+
+// bus_count buses with the same chain of chain_length effects each.
+static struct APP_Effects *
+APP_BenchmarkCreateEffects(const struct APP_EffectDesc *chain, Uint32 chain_length, Uint32 bus_count, bool simd)
+{
+    struct APP_Effects *effects = APP_Effects_Create(BENCH_EFFECTS_FREQ);
+    if (effects == NULL)
+    {
+        return NULL;
+    }
+
+    APP_Effects_UseSIMD(effects, simd);
+
+    for (Uint32 b = 0; b < bus_count; ++b)
+    {
+        for (Uint32 s = 0; s < chain_length; ++s)
+        {
+            struct APP_Effect *effect = APP_Effect_Create(&chain[s], BENCH_EFFECTS_FREQ);
+            if (effect == NULL)
+            {
+                APP_Effects_Destroy(effects);
+                return NULL;
+            }
+
+            APP_Effects_Swap(effects, b, s, effect);
+        }
+    }
+
+    return effects;
+}
+
+// Sends noise into the first bus_count buses for BENCH_SECONDS, returns the
+// time spent processing in ms.
+static double
+APP_BenchmarkEffectRun(struct APP_Effects *effects, Uint32 bus_count, struct APP_EffectStats *out_stats)
+{
+    float noise[2][APP_EFFECTS_BLOCK_FRAMES];
+    float dst[2][APP_EFFECTS_BLOCK_FRAMES];
+    const Uint32 blocks = BENCH_EFFECTS_FREQ * BENCH_SECONDS / APP_EFFECTS_BLOCK_FRAMES;
+
+    SDL_srand(BENCH_SEED);
+    for (Uint32 i = 0; i < APP_EFFECTS_BLOCK_FRAMES; ++i)
+    {
+        noise[0][i] = SDL_randf() - 0.5f;
+        noise[1][i] = SDL_randf() - 0.5f;
+    }
+
+    Uint64 ticks = 0;
+    for (Uint32 block = 0; block < blocks; ++block)
+    {
+        for (Uint32 b = 0; b < bus_count; ++b)
+        {
+            float *left, *right;
+            APP_Effects_GetInput(effects, b, &left, &right);
+            SDL_memcpy(left, noise[0], sizeof(noise[0]));
+            SDL_memcpy(right, noise[1], sizeof(noise[1]));
+        }
+
+        SDL_memset(dst, 0, sizeof(dst));
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        APP_Effects_Process(effects, dst[0], dst[1], APP_EFFECTS_BLOCK_FRAMES);
+        ticks += SDL_GetPerformanceCounter() - start;
+    }
+
+    APP_Effects_GetStats(effects, out_stats);
+    return (double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+// Microseconds per effect and block of one type, 0 when none ran.
+static double
+APP_BenchmarkEffectCost(const struct APP_EffectStats *stats, enum APP_EffectType type)
+{
+    return stats->runs[type] > 0 ? stats->ms[type] * 1000.0 / (double)stats->runs[type] : 0.0;
+}
+
+void
+APP_BenchmarkEffects(void)
+{
+    const double audio_ms = BENCH_SECONDS * 1000.0;
+    const Uint32 chain_length = (Uint32)SDL_arraysize(BENCH_EFFECTS) - BENCH_EFFECTS_CHAIN_FIRST;
+
+    struct APP_Effects *probe = APP_Effects_Create(BENCH_EFFECTS_FREQ);
+    if (probe == NULL)
+    {
+        return;
+    }
+
+    bool simd = APP_Effects_UseSIMD(probe, true);
+    APP_Effects_Destroy(probe);
+
+    SDL_Log(
+            "INFO: [effects bench] %d Hz, %d s of audio per run, blocks of %d frames, %s",
+            BENCH_EFFECTS_FREQ,
+            BENCH_SECONDS,
+            APP_EFFECTS_BLOCK_FRAMES,
+            simd ? "SIMD kernels against scalar" : "no SIMD kernels on this CPU"
+    );
+
+    for (size_t e = 0; e < SDL_arraysize(BENCH_EFFECTS); ++e)
+    {
+        double cost[2] = { 0.0, 0.0 };
+
+        for (int use_simd = 0; use_simd < 2; ++use_simd)
+        {
+            struct APP_Effects *effects = APP_BenchmarkCreateEffects(&BENCH_EFFECTS[e], 1, BENCH_EFFECTS_TYPE_BUSES, use_simd != 0);
+            if (effects == NULL)
+            {
+                return;
+            }
+
+            struct APP_EffectStats stats;
+            APP_BenchmarkEffectRun(effects, BENCH_EFFECTS_TYPE_BUSES, &stats);
+            cost[use_simd] = APP_BenchmarkEffectCost(&stats, BENCH_EFFECTS[e].type);
+            APP_Effects_Destroy(effects);
+        }
+
+        SDL_Log(
+                "INFO: [effects bench] %-8s on %d buses, %.2f us scalar, %.2f us simd per effect per block, %.1fx",
+                APP_Effect_GetTypeName(BENCH_EFFECTS[e].type),
+                BENCH_EFFECTS_TYPE_BUSES,
+                cost[0],
+                cost[1],
+                cost[1] > 0.0 ? cost[0] / cost[1] : 0.0
+        );
+    }
+
+    for (size_t c = 0; c < SDL_arraysize(BENCH_EFFECT_BUS_COUNTS); ++c)
+    {
+        Uint32 buses = BENCH_EFFECT_BUS_COUNTS[c];
+        double ms[2] = { 0.0, 0.0 };
+
+        for (int use_simd = 0; use_simd < 2; ++use_simd)
+        {
+            struct APP_Effects *effects = APP_BenchmarkCreateEffects(
+                    &BENCH_EFFECTS[BENCH_EFFECTS_CHAIN_FIRST],
+                    chain_length,
+                    buses,
+                    use_simd != 0
+            );
+
+            if (effects == NULL)
+            {
+                return;
+            }
+
+            struct APP_EffectStats stats;
+            ms[use_simd] = APP_BenchmarkEffectRun(effects, buses, &stats);
+            APP_Effects_Destroy(effects);
+        }
+
+        SDL_Log(
+                "INFO: [effects bench] %2u buses of highpass, eq, delay and reverb, %.2f%% of one core scalar, %.2f%% simd",
+                buses,
+                ms[0] * 100.0 / audio_ms,
+                ms[1] * 100.0 / audio_ms
+        );
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "mixer.h"
+#include "spatial.h"
+
+// Mix cost per voice at 44.1 and 48 kHz, rendered without a device.
+void APP_BenchmarkMixer(const struct APP_Sound *sound);
+// Throughput and error against exact sines of every resampler quality.
+void APP_BenchmarkResampler(void);
+// Update cost with growing emitter counts, and the batched pass with SIMD
+// and without.
+void APP_BenchmarkSpatial(const struct APP_Sound *sound);
+// Encodes the sound to IMA ADPCM in memory, then compares its size, error
+// and mix cost with the PCM sound.
+void APP_BenchmarkADPCM(const struct APP_Sound *sound);
+// Cost of every type of effect with SIMD and without, and of whole chains
+// on a growing number of buses.
+void APP_BenchmarkEffects(void);
+
+#endif
@@ -0,0 +1,1262 @@
+#include "effects.h"
+
+#if defined(SDL_SSE_INTRINSICS)
+#define APP_EFFECTS_SSE
+#endif
+#if defined(SDL_NEON_INTRINSICS)
+#define APP_EFFECTS_NEON
+#endif
+
+#define APP_EFFECTS_MIN_FREQUENCY 10.0f
+#define APP_EFFECTS_MAX_Q 20.0f
+#define APP_EFFECTS_MAX_GAIN_DB 24.0f
+#define APP_EFFECTS_MAX_FEEDBACK 0.95f
+#define APP_EFFECTS_MIN_REVERB_MS 100.0f
+#define APP_EFFECTS_MAX_REVERB_MS 20000.0f
+// How long a filter keeps ringing once nothing comes in, in seconds.
+#define APP_EFFECTS_FILTER_TAIL 0.1f
+
+// Lines of the reverb, in ms. Far enough apart that their echoes don't line
+// up, the shortest longer than the four frames a vector reads ahead.
+#define APP_REVERB_LINES 8
+static const float APP_REVERB_LINE_MS[APP_REVERB_LINES] = {
+    29.7f, 37.1f, 41.1f, 43.7f, 53.3f, 59.9f, 67.1f, 73.3f
+};
+// How the mono input is fed into each line.
+static const float APP_REVERB_INPUT_SIGNS[APP_REVERB_LINES] = {
+    1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f, -1.0f, -1.0f
+};
+#define APP_REVERB_INPUT_GAIN 0.5f
+#define APP_REVERB_OUTPUT_GAIN 0.35f
+
+struct APP_Effect {
+    enum APP_EffectType type;
+    int freq;
+
+    // Filters. The biquad with the mix folded into it, the state of both
+    // channels.
+    float b0, b1, b2, a1, a2;
+    float z1[2];
+    float z2[2];
+
+    // Delay and reverb. Lines of length frames each, a power of two, all
+    // written at the same index.
+    float *lines;
+    Uint32 line_count;
+    Uint32 length;
+    Uint32 write;
+    // The delay of each line in frames and the gain it comes back at.
+    Uint32 delays[APP_REVERB_LINES];
+    float gains[APP_REVERB_LINES];
+    // The longest delay the lines have room for.
+    Uint32 capacity;
+    float feedback;
+    // Half of the damping, the weight of the frame before.
+    float damping;
+    float mix;
+
+    // Frames it keeps sounding once nothing comes in.
+    Uint32 tail_frames;
+};
+
+// Four channels of up to two buses for the filter kernels.
+struct APP_BiquadLanes {
+    float *samples[4];
+    float b0[4];
+    float b1[4];
+    float b2[4];
+    float a1[4];
+    float a2[4];
+    float z1[4];
+    float z2[4];
+};
+
+typedef void (*APP_BiquadFunc)(struct APP_BiquadLanes *lanes, Uint32 frames);
+// Delay and reverb, in place on planar stereo.
+typedef void (*APP_EffectFunc)(struct APP_Effect *effect, float *left, float *right, Uint32 frames);
+
+struct APP_EffectKernels {
+    APP_BiquadFunc biquad;
+    APP_EffectFunc delay;
+    APP_EffectFunc reverb;
+};
+
+struct APP_EffectBus {
+    struct APP_Effect *chain[APP_EFFECTS_MAX_CHAIN];
+    float *samples[2];
+    int output;
+    float gain;
+    float current_gain;
+    // Something was sent in for this block.
+    bool fed;
+    bool awake;
+    // Frames since something was last sent in.
+    Uint32 quiet_frames;
+    Uint32 tail_frames;
+    // Buses that return into it before it, this block.
+    Uint32 level;
+};
+
+struct APP_Effects {
+    int freq;
+    struct APP_EffectKernels kernels;
+    struct APP_EffectKernels scalar_kernels;
+    struct APP_EffectKernels simd_kernels;
+    bool has_simd;
+    // MXCSR bits that flush denormals, 0 without SSE.
+    Uint32 flush_bits;
+
+    struct APP_EffectBus buses[APP_EFFECTS_MAX_BUSES];
+    void *memory;
+    // Where the unused lanes of a filter group go.
+    float *scratch;
+
+    Uint64 ticks[APP_EFFECT_TYPE_COUNT];
+    Uint64 runs[APP_EFFECT_TYPE_COUNT];
+    Uint32 count[APP_EFFECT_TYPE_COUNT];
+    Uint32 awake_buses;
+};
+
+static const char *APP_EFFECT_TYPE_NAMES[APP_EFFECT_TYPE_COUNT] = {
+    "none", "lowpass", "highpass", "eq", "delay", "reverb"
+};
+
+const char *
+APP_Effect_GetTypeName(enum APP_EffectType type)
+{
+    return (Uint32)type < APP_EFFECT_TYPE_COUNT ? APP_EFFECT_TYPE_NAMES[type] : "unknown";
+}
+
+static bool
+APP_Effect_IsFilter(enum APP_EffectType type)
+{
+    return type == APP_EFFECT_LOWPASS || type == APP_EFFECT_HIGHPASS || type == APP_EFFECT_EQ;
+}
+
+// ============================================================================
+// Kernels
+// ============================================================================
+
+// Transposed direct form II, from frame first on.
+static void
+APP_Biquad_ScalarFrom(struct APP_BiquadLanes *lanes, Uint32 first, Uint32 frames)
+{
+    for (Uint32 k = 0; k < 4; ++k)
+    {
+        float *samples = lanes->samples[k];
+        const float b0 = lanes->b0[k];
+        const float b1 = lanes->b1[k];
+        const float b2 = lanes->b2[k];
+        const float a1 = lanes->a1[k];
+        const float a2 = lanes->a2[k];
+        float z1 = lanes->z1[k];
+        float z2 = lanes->z2[k];
+
+        for (Uint32 i = first; i < frames; ++i)
+        {
+            float x = samples[i];
+            float y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            samples[i] = y;
+        }
+
+        lanes->z1[k] = z1;
+        lanes->z2[k] = z2;
+    }
+}
+
+static void
+APP_Biquad_Scalar(struct APP_BiquadLanes *lanes, Uint32 frames)
+{
+    APP_Biquad_ScalarFrom(lanes, 0, frames);
+}
+
+// Runs the delay frame by frame, from frame first on.
+static void
+APP_Delay_ScalarFrom(struct APP_Effect *effect, float *left, float *right, Uint32 first, Uint32 frames)
+{
+    const Uint32 mask = effect->length - 1;
+    const Uint32 delay = effect->delays[0];
+    const float feedback = effect->feedback;
+    const float damping = effect->damping;
+    const float mix = effect->mix;
+    float *samples[2] = { left, right };
+    float *lines[2] = { effect->lines, effect->lines + effect->length };
+
+    Uint32 write = effect->write;
+    for (Uint32 i = first; i < frames; ++i)
+    {
+        Uint32 read = (write - delay) & mask;
+        for (Uint32 c = 0; c < 2; ++c)
+        {
+            float x = samples[c][i];
+            float d = lines[c][read];
+            float p = lines[c][(read - 1) & mask];
+            lines[c][write] = x + feedback * (d + damping * (p - d));
+            samples[c][i] = x + mix * (d - x);
+        }
+
+        write = (write + 1) & mask;
+    }
+
+    effect->write = write;
+}
+
+static void
+APP_Delay_Scalar(struct APP_Effect *effect, float *left, float *right, Uint32 frames)
+{
+    APP_Delay_ScalarFrom(effect, left, right, 0, frames);
+}
+
+// u = H u / sqrt(8) with the sqrt folded into the gains, H the 8 by 8
+// Hadamard matrix.
+static void
+APP_Reverb_Hadamard(float *u)
+{
+    for (Uint32 span = 1; span < APP_REVERB_LINES; span *= 2)
+    {
+        for (Uint32 j = 0; j < APP_REVERB_LINES; j += span * 2)
+        {
+            for (Uint32 k = j; k < j + span; ++k)
+            {
+                float a = u[k];
+                float b = u[k + span];
+                u[k] = a + b;
+                u[k + span] = a - b;
+            }
+        }
+    }
+}
+
+// Runs the reverb frame by frame, from frame first on. Every line is damped
+// and turned down by its gain, the Hadamard matrix mixes them back into
+// each other with the input. Even lines make the left side, odd ones the
+// right.
+static void
+APP_Reverb_ScalarFrom(struct APP_Effect *effect, float *left, float *right, Uint32 first, Uint32 frames)
+{
+    const Uint32 mask = effect->length - 1;
+    const float damping = effect->damping;
+    const float mix = effect->mix;
+
+    Uint32 write = effect->write;
+    for (Uint32 i = first; i < frames; ++i)
+    {
+        float input = (left[i] + right[i]) * APP_REVERB_INPUT_GAIN;
+        float u[APP_REVERB_LINES];
+        float out[2] = { 0.0f, 0.0f };
+
+        for (Uint32 j = 0; j < APP_REVERB_LINES; ++j)
+        {
+            const float *line = effect->lines + (size_t)j * effect->length;
+            Uint32 read = (write - effect->delays[j]) & mask;
+            float d = line[read];
+            float f = d + damping * (line[(read - 1) & mask] - d);
+            out[j & 1] += f;
+            u[j] = f * effect->gains[j];
+        }
+
+        APP_Reverb_Hadamard(u);
+        for (Uint32 j = 0; j < APP_REVERB_LINES; ++j)
+        {
+            effect->lines[(size_t)j * effect->length + write] = u[j] + input * APP_REVERB_INPUT_SIGNS[j];
+        }
+
+        left[i] += mix * (out[0] * APP_REVERB_OUTPUT_GAIN - left[i]);
+        right[i] += mix * (out[1] * APP_REVERB_OUTPUT_GAIN - right[i]);
+        write = (write + 1) & mask;
+    }
+
+    effect->write = write;
+}
+
+static void
+APP_Reverb_Scalar(struct APP_Effect *effect, float *left, float *right, Uint32 frames)
+{
+    APP_Reverb_ScalarFrom(effect, left, right, 0, frames);
+}
+
+// Note(john): The vector kernels below take four frames at a time out of
+// the lines. A line is longer than that, so all four were written before
+// the block and none of them waits on the others. Groups that would read or
+// write across the end of a line go frame by frame.
+static bool
+APP_Effect_GroupFits(const struct APP_Effect *effect, Uint32 write)
+{
+    if (write + 4 > effect->length)
+    {
+        return false;
+    }
+
+    for (Uint32 j = 0; j < effect->line_count; ++j)
+    {
+        Uint32 read = (write - effect->delays[j]) & (effect->length - 1);
+        if (read == 0 || read + 4 > effect->length)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#ifdef APP_EFFECTS_SSE
+// Four frames of four channels at a time. The frames of each channel are
+// turned into a vector per frame across the channels and back.
+SDL_TARGETING("sse") static void
+APP_Biquad_SSE(struct APP_BiquadLanes *lanes, Uint32 frames)
+{
+    const __m128 b0 = _mm_loadu_ps(lanes->b0);
+    const __m128 b1 = _mm_loadu_ps(lanes->b1);
+    const __m128 b2 = _mm_loadu_ps(lanes->b2);
+    const __m128 a1 = _mm_loadu_ps(lanes->a1);
+    const __m128 a2 = _mm_loadu_ps(lanes->a2);
+    __m128 z1 = _mm_loadu_ps(lanes->z1);
+    __m128 z2 = _mm_loadu_ps(lanes->z2);
+    float *s0 = lanes->samples[0];
+    float *s1 = lanes->samples[1];
+    float *s2 = lanes->samples[2];
+    float *s3 = lanes->samples[3];
+
+    Uint32 i = 0;
+    for (; i + 4 <= frames; i += 4)
+    {
+        __m128 x0 = _mm_loadu_ps(s0 + i);
+        __m128 x1 = _mm_loadu_ps(s1 + i);
+        __m128 x2 = _mm_loadu_ps(s2 + i);
+        __m128 x3 = _mm_loadu_ps(s3 + i);
+        _MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+
+        __m128 y0 = _mm_add_ps(_mm_mul_ps(b0, x0), z1);
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x0), _mm_mul_ps(a1, y0)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x0), _mm_mul_ps(a2, y0));
+        __m128 y1 = _mm_add_ps(_mm_mul_ps(b0, x1), z1);
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x1), _mm_mul_ps(a1, y1)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x1), _mm_mul_ps(a2, y1));
+        __m128 y2 = _mm_add_ps(_mm_mul_ps(b0, x2), z1);
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x2), _mm_mul_ps(a1, y2)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x2), _mm_mul_ps(a2, y2));
+        __m128 y3 = _mm_add_ps(_mm_mul_ps(b0, x3), z1);
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x3), _mm_mul_ps(a1, y3)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x3), _mm_mul_ps(a2, y3));
+
+        _MM_TRANSPOSE4_PS(y0, y1, y2, y3);
+        _mm_storeu_ps(s0 + i, y0);
+        _mm_storeu_ps(s1 + i, y1);
+        _mm_storeu_ps(s2 + i, y2);
+        _mm_storeu_ps(s3 + i, y3);
+    }
+
+    _mm_storeu_ps(lanes->z1, z1);
+    _mm_storeu_ps(lanes->z2, z2);
+    APP_Biquad_ScalarFrom(lanes, i, frames);
+}
+
+SDL_TARGETING("sse") static void
+APP_Delay_SSE(struct APP_Effect *effect, float *left, float *right, Uint32 frames)
+{
+    const Uint32 mask = effect->length - 1;
+    const __m128 feedback = _mm_set1_ps(effect->feedback);
+    const __m128 damping = _mm_set1_ps(effect->damping);
+    const __m128 mix = _mm_set1_ps(effect->mix);
+    float *samples[2] = { left, right };
+    float *lines[2] = { effect->lines, effect->lines + effect->length };
+
+    Uint32 i = 0;
+    for (; i + 4 <= frames; i += 4)
+    {
+        Uint32 write = effect->write;
+        if (!APP_Effect_GroupFits(effect, write))
+        {
+            APP_Delay_ScalarFrom(effect, left, right, i, i + 4);
+            continue;
+        }
+
+        Uint32 read = (write - effect->delays[0]) & mask;
+        for (Uint32 c = 0; c < 2; ++c)
+        {
+            __m128 x = _mm_loadu_ps(samples[c] + i);
+            __m128 d = _mm_loadu_ps(lines[c] + read);
+            __m128 p = _mm_loadu_ps(lines[c] + read - 1);
+            __m128 f = _mm_add_ps(d, _mm_mul_ps(damping, _mm_sub_ps(p, d)));
+            _mm_storeu_ps(lines[c] + write, _mm_add_ps(x, _mm_mul_ps(feedback, f)));
+            _mm_storeu_ps(samples[c] + i, _mm_add_ps(x, _mm_mul_ps(mix, _mm_sub_ps(d, x))));
+        }
+
+        effect->write = (write + 4) & mask;
+    }
+
+    APP_Delay_ScalarFrom(effect, left, right, i, frames);
+}
+
+SDL_TARGETING("sse") static void
+APP_Reverb_SSE(struct APP_Effect *effect, float *left, float *right, Uint32 frames)
+{
+    const Uint32 mask = effect->length - 1;
+    const __m128 damping = _mm_set1_ps(effect->damping);
+    const __m128 mix = _mm_set1_ps(effect->mix);
+    const __m128 input_gain = _mm_set1_ps(APP_REVERB_INPUT_GAIN);
+    const __m128 output_gain = _mm_set1_ps(APP_REVERB_OUTPUT_GAIN);
+
+    Uint32 i = 0;
+    for (; i + 4 <= frames; i += 4)
+    {
+        Uint32 write = effect->write;
+        if (!APP_Effect_GroupFits(effect, write))
+        {
+            APP_Reverb_ScalarFrom(effect, left, right, i, i + 4);
+            continue;
+        }
+
+        __m128 x_l = _mm_loadu_ps(left + i);
+        __m128 x_r = _mm_loadu_ps(right + i);
+        __m128 input = _mm_mul_ps(_mm_add_ps(x_l, x_r), input_gain);
+        __m128 out_l = _mm_setzero_ps();
+        __m128 out_r = _mm_setzero_ps();
+        __m128 u[APP_REVERB_LINES];
+
+        for (Uint32 j = 0; j < APP_REVERB_LINES; ++j)
+        {
+            const float *line = effect->lines + (size_t)j * effect->length + ((write - effect->delays[j]) & mask);
+            __m128 d = _mm_loadu_ps(line);
+            __m128 f = _mm_add_ps(d, _mm_mul_ps(damping, _mm_sub_ps(_mm_loadu_ps(line - 1), d)));
+            if (j & 1)
+            {
+                out_r = _mm_add_ps(out_r, f);
+            }
+            else
+            {
+                out_l = _mm_add_ps(out_l, f);
+            }
+
+            u[j] = _mm_mul_ps(f, _mm_set1_ps(effect->gains[j]));
+        }
+
+        for (Uint32 span = 1; span < APP_REVERB_LINES; span *= 2)
+        {
+            for (Uint32 j = 0; j < APP_REVERB_LINES; j += span * 2)
+            {
+                for (Uint32 k = j; k < j + span; ++k)
+                {
+                    __m128 a = u[k];
+                    __m128 b = u[k + span];
+                    u[k] = _mm_add_ps(a, b);
+                    u[k + span] = _mm_sub_ps(a, b);
+                }
+            }
+        }
+
+        for (Uint32 j = 0; j < APP_REVERB_LINES; ++j)
+        {
+            __m128 fed = _mm_add_ps(u[j], _mm_mul_ps(input, _mm_set1_ps(APP_REVERB_INPUT_SIGNS[j])));
+            _mm_storeu_ps(effect->lines + (size_t)j * effect->length + write, fed);
+        }
+
+        out_l = _mm_mul_ps(out_l, output_gain);
+        out_r = _mm_mul_ps(out_r, output_gain);
+        _mm_storeu_ps(left + i, _mm_add_ps(x_l, _mm_mul_ps(mix, _mm_sub_ps(out_l, x_l))));
+        _mm_storeu_ps(right + i, _mm_add_ps(x_r, _mm_mul_ps(mix, _mm_sub_ps(out_r, x_r))));
+        effect->write = (write + 4) & mask;
+    }
+
+    APP_Reverb_ScalarFrom(effect, left, right, i, frames);
+}
+
+SDL_TARGETING("sse") static Uint32
+APP_Effects_FlushDenormals_SSE(Uint32 bits)
+{
+    Uint32 csr = _mm_getcsr();
+    _mm_setcsr(csr | bits);
+    return csr;
+}
+
+SDL_TARGETING("sse") static void
+APP_Effects_RestoreDenormals_SSE(Uint32 csr)
+{
+    _mm_setcsr(csr);
+}
+#endif
+
+#ifdef APP_EFFECTS_NEON
+static void
+APP_Transpose_NEON(float32x4_t *x0, float32x4_t *x1, float32x4_t *x2, float32x4_t *x3)
+{
+    float32x4x2_t t01 = vtrnq_f32(*x0, *x1);
+    float32x4x2_t t23 = vtrnq_f32(*x2, *x3);
+    *x0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    *x1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    *x2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    *x3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+static void
+APP_Biquad_NEON(struct APP_BiquadLanes *lanes, Uint32 frames)
+{
+    const float32x4_t b0 = vld1q_f32(lanes->b0);
+    const float32x4_t b1 = vld1q_f32(lanes->b1);
+    const float32x4_t b2 = vld1q_f32(lanes->b2);
+    const float32x4_t a1 = vld1q_f32(lanes->a1);
+    const float32x4_t a2 = vld1q_f32(lanes->a2);
+    float32x4_t z1 = vld1q_f32(lanes->z1);
+    float32x4_t z2 = vld1q_f32(lanes->z2);
+    float *s0 = lanes->samples[0];
+    float *s1 = lanes->samples[1];
+    float *s2 = lanes->samples[2];
+    float *s3 = lanes->samples[3];
+
+    Uint32 i = 0;
+    for (; i + 4 <= frames; i += 4)
+    {
+        float32x4_t x[4] = { vld1q_f32(s0 + i), vld1q_f32(s1 + i), vld1q_f32(s2 + i), vld1q_f32(s3 + i) };
+        APP_Transpose_NEON(&x[0], &x[1], &x[2], &x[3]);
+
+        for (Uint32 k = 0; k < 4; ++k)
+        {
+            float32x4_t y = vmlaq_f32(z1, b0, x[k]);
+            z1 = vmlsq_f32(vmlaq_f32(z2, b1, x[k]), a1, y);
+            z2 = vmlsq_f32(vmulq_f32(b2, x[k]), a2, y);
+            x[k] = y;
+        }
+
+        APP_Transpose_NEON(&x[0], &x[1], &x[2], &x[3]);
+        vst1q_f32(s0 + i, x[0]);
+        vst1q_f32(s1 + i, x[1]);
+        vst1q_f32(s2 + i, x[2]);
+        vst1q_f32(s3 + i, x[3]);
+    }
+
+    vst1q_f32(lanes->z1, z1);
+    vst1q_f32(lanes->z2, z2);
+    APP_Biquad_ScalarFrom(lanes, i, frames);
+}
+
+static void
+APP_Delay_NEON(struct APP_Effect *effect, float *left, float *right, Uint32 frames)
+{
+    const Uint32 mask = effect->length - 1;
+    const float32x4_t feedback = vdupq_n_f32(effect->feedback);
+    const float32x4_t damping = vdupq_n_f32(effect->damping);
+    const float32x4_t mix = vdupq_n_f32(effect->mix);
+    float *samples[2] = { left, right };
+    float *lines[2] = { effect->lines, effect->lines + effect->length };
+
+    Uint32 i = 0;
+    for (; i + 4 <= frames; i += 4)
+    {
+        Uint32 write = effect->write;
+        if (!APP_Effect_GroupFits(effect, write))
+        {
+            APP_Delay_ScalarFrom(effect, left, right, i, i + 4);
+            continue;
+        }
+
+        Uint32 read = (write - effect->delays[0]) & mask;
+        for (Uint32 c = 0; c < 2; ++c)
+        {
+            float32x4_t x = vld1q_f32(samples[c] + i);
+            float32x4_t d = vld1q_f32(lines[c] + read);
+            float32x4_t p = vld1q_f32(lines[c] + read - 1);
+            float32x4_t f = vmlaq_f32(d, damping, vsubq_f32(p, d));
+            vst1q_f32(lines[c] + write, vmlaq_f32(x, feedback, f));
+            vst1q_f32(samples[c] + i, vmlaq_f32(x, mix, vsubq_f32(d, x)));
+        }
+
+        effect->write = (write + 4) & mask;
+    }
+
+    APP_Delay_ScalarFrom(effect, left, right, i, frames);
+}
+
+static void
+APP_Reverb_NEON(struct APP_Effect *effect, float *left, float *right, Uint32 frames)
+{
+    const Uint32 mask = effect->length - 1;
+    const float32x4_t damping = vdupq_n_f32(effect->damping);
+    const float32x4_t mix = vdupq_n_f32(effect->mix);
+
+    Uint32 i = 0;
+    for (; i + 4 <= frames; i += 4)
+    {
+        Uint32 write = effect->write;
+        if (!APP_Effect_GroupFits(effect, write))
+        {
+            APP_Reverb_ScalarFrom(effect, left, right, i, i + 4);
+            continue;
+        }
+
+        float32x4_t x_l = vld1q_f32(left + i);
+        float32x4_t x_r = vld1q_f32(right + i);
+        float32x4_t input = vmulq_n_f32(vaddq_f32(x_l, x_r), APP_REVERB_INPUT_GAIN);
+        float32x4_t out_l = vdupq_n_f32(0.0f);
+        float32x4_t out_r = vdupq_n_f32(0.0f);
+        float32x4_t u[APP_REVERB_LINES];
+
+        for (Uint32 j = 0; j < APP_REVERB_LINES; ++j)
+        {
+            const float *line = effect->lines + (size_t)j * effect->length + ((write - effect->delays[j]) & mask);
+            float32x4_t d = vld1q_f32(line);
+            float32x4_t f = vmlaq_f32(d, damping, vsubq_f32(vld1q_f32(line - 1), d));
+            if (j & 1)
+            {
+                out_r = vaddq_f32(out_r, f);
+            }
+            else
+            {
+                out_l = vaddq_f32(out_l, f);
+            }
+
+            u[j] = vmulq_n_f32(f, effect->gains[j]);
+        }
+
+        for (Uint32 span = 1; span < APP_REVERB_LINES; span *= 2)
+        {
+            for (Uint32 j = 0; j < APP_REVERB_LINES; j += span * 2)
+            {
+                for (Uint32 k = j; k < j + span; ++k)
+                {
+                    float32x4_t a = u[k];
+                    float32x4_t b = u[k + span];
+                    u[k] = vaddq_f32(a, b);
+                    u[k + span] = vsubq_f32(a, b);
+                }
+            }
+        }
+
+        for (Uint32 j = 0; j < APP_REVERB_LINES; ++j)
+        {
+            float32x4_t fed = vmlaq_n_f32(u[j], input, APP_REVERB_INPUT_SIGNS[j]);
+            vst1q_f32(effect->lines + (size_t)j * effect->length + write, fed);
+        }
+
+        out_l = vmulq_n_f32(out_l, APP_REVERB_OUTPUT_GAIN);
+        out_r = vmulq_n_f32(out_r, APP_REVERB_OUTPUT_GAIN);
+        vst1q_f32(left + i, vmlaq_f32(x_l, mix, vsubq_f32(out_l, x_l)));
+        vst1q_f32(right + i, vmlaq_f32(x_r, mix, vsubq_f32(out_r, x_r)));
+        effect->write = (write + 4) & mask;
+    }
+
+    APP_Reverb_ScalarFrom(effect, left, right, i, frames);
+}
+#endif
+
+// ============================================================================
+// Effects
+// ============================================================================
+
+static Uint32
+APP_Effect_Frames(float ms, int freq)
+{
+    return (Uint32)(ms * 0.001f * (float)freq + 0.5f);
+}
+
+// The delay in frames the lines are sized for, at least the four frames a
+// vector reads ahead and the one before them.
+static Uint32
+APP_Effect_DelayFrames(const struct APP_EffectDesc *desc, int freq)
+{
+    float ms = SDL_clamp(desc->time_ms, 1.0f, APP_EFFECTS_MAX_DELAY_MS);
+    return SDL_max(APP_Effect_Frames(ms, freq), 5u);
+}
+
+// Robert Bristow-Johnson's cookbook filters, normalized by a0. A mix below
+// one blends the filter with the input: b' = mix * b + (1 - mix) * a.
+static void
+APP_Effect_SetBiquad(struct APP_Effect *effect, const struct APP_EffectDesc *desc)
+{
+    float frequency = SDL_clamp(desc->frequency, APP_EFFECTS_MIN_FREQUENCY, 0.45f * (float)effect->freq);
+    float q = SDL_clamp(desc->q, 0.1f, APP_EFFECTS_MAX_Q);
+    float gain_db = SDL_clamp(desc->gain_db, -APP_EFFECTS_MAX_GAIN_DB, APP_EFFECTS_MAX_GAIN_DB);
+    float mix = SDL_clamp(desc->mix, 0.0f, 1.0f);
+
+    float w0 = 2.0f * SDL_PI_F * frequency / (float)effect->freq;
+    float cos_w0 = SDL_cosf(w0);
+    float alpha = SDL_sinf(w0) / (2.0f * q);
+    float b0, b1, b2, a0, a1, a2;
+
+    switch (effect->type)
+    {
+        case APP_EFFECT_LOWPASS:
+            b0 = (1.0f - cos_w0) * 0.5f;
+            b1 = 1.0f - cos_w0;
+            b2 = b0;
+            a0 = 1.0f + alpha;
+            a2 = 1.0f - alpha;
+            break;
+        case APP_EFFECT_HIGHPASS:
+            b0 = (1.0f + cos_w0) * 0.5f;
+            b1 = -(1.0f + cos_w0);
+            b2 = b0;
+            a0 = 1.0f + alpha;
+            a2 = 1.0f - alpha;
+            break;
+        default:
+        {
+            float amplitude = SDL_powf(10.0f, gain_db / 40.0f);
+            b0 = 1.0f + alpha * amplitude;
+            b1 = -2.0f * cos_w0;
+            b2 = 1.0f - alpha * amplitude;
+            a0 = 1.0f + alpha / amplitude;
+            a2 = 1.0f - alpha / amplitude;
+            break;
+        }
+    }
+
+    a1 = -2.0f * cos_w0;
+    effect->a1 = a1 / a0;
+    effect->a2 = a2 / a0;
+    effect->b0 = mix * b0 / a0 + (1.0f - mix);
+    effect->b1 = mix * b1 / a0 + (1.0f - mix) * effect->a1;
+    effect->b2 = mix * b2 / a0 + (1.0f - mix) * effect->a2;
+    effect->tail_frames = APP_Effect_Frames(APP_EFFECTS_FILTER_TAIL * 1000.0f, effect->freq);
+}
+
+// Takes the parameters of desc, no allocation. Delays longer than the lines
+// have room for are cut to fit.
+static void
+APP_Effect_Configure(struct APP_Effect *effect, const struct APP_EffectDesc *desc)
+{
+    effect->mix = SDL_clamp(desc->mix, 0.0f, 1.0f);
+    effect->damping = SDL_clamp(desc->damping, 0.0f, 1.0f) * 0.5f;
+
+    if (APP_Effect_IsFilter(effect->type))
+    {
+        APP_Effect_SetBiquad(effect, desc);
+    }
+    else if (effect->type == APP_EFFECT_DELAY)
+    {
+        Uint32 delay = SDL_min(APP_Effect_DelayFrames(desc, effect->freq), effect->capacity);
+        effect->delays[0] = delay;
+        effect->feedback = SDL_clamp(desc->feedback, 0.0f, APP_EFFECTS_MAX_FEEDBACK);
+
+        // Until the echoes fall under -60 dB.
+        float echoes = effect->feedback > 0.0f ? SDL_logf(0.001f) / SDL_logf(effect->feedback) : 0.0f;
+        effect->tail_frames = (Uint32)((float)delay * (echoes + 1.0f));
+    }
+    else
+    {
+        float decay_ms = SDL_clamp(desc->time_ms, APP_EFFECTS_MIN_REVERB_MS, APP_EFFECTS_MAX_REVERB_MS);
+        float decay_frames = decay_ms * 0.001f * (float)effect->freq;
+
+        // Every pass through a line takes it down by its share of 60 dB.
+        for (Uint32 j = 0; j < APP_REVERB_LINES; ++j)
+        {
+            float gain = SDL_powf(10.0f, -3.0f * (float)effect->delays[j] / decay_frames);
+            effect->gains[j] = gain / SDL_sqrtf((float)APP_REVERB_LINES);
+        }
+
+        effect->tail_frames = (Uint32)decay_frames + effect->delays[APP_REVERB_LINES - 1];
+    }
+}
+
+struct APP_Effect *
+APP_Effect_Create(const struct APP_EffectDesc *desc, int freq)
+{
+    if (desc == NULL || desc->type <= APP_EFFECT_NONE || desc->type >= APP_EFFECT_TYPE_COUNT || freq <= 0)
+    {
+        return NULL;
+    }
+
+    struct APP_Effect *effect = SDL_calloc(1, sizeof(struct APP_Effect));
+    if (effect == NULL)
+    {
+        return NULL;
+    }
+
+    effect->type = desc->type;
+    effect->freq = freq;
+
+    Uint32 longest = 0;
+    if (desc->type == APP_EFFECT_DELAY)
+    {
+        effect->line_count = 2;
+        longest = APP_Effect_DelayFrames(desc, freq);
+    }
+    else if (desc->type == APP_EFFECT_REVERB)
+    {
+        effect->line_count = APP_REVERB_LINES;
+        for (Uint32 j = 0; j < APP_REVERB_LINES; ++j)
+        {
+            effect->delays[j] = SDL_max(APP_Effect_Frames(APP_REVERB_LINE_MS[j], freq), 5u);
+            longest = SDL_max(longest, effect->delays[j]);
+        }
+    }
+
+    if (effect->line_count > 0)
+    {
+        // Note(john): Rounded up to a power of two the lines have room for
+        // the delay to grow later, up to twice as long at most. The reads
+        // stay a vector behind the writes.
+        effect->length = 16;
+        while (effect->length < longest + 8)
+        {
+            effect->length *= 2;
+        }
+
+        effect->capacity = effect->length - 8;
+        effect->lines = SDL_calloc((size_t)effect->length * effect->line_count, sizeof(float));
+        if (effect->lines == NULL)
+        {
+            SDL_Log("ERROR: Failed to allocate %u frames of %s lines.", effect->length, APP_Effect_GetTypeName(desc->type));
+            APP_Effect_Destroy(effect);
+            return NULL;
+        }
+    }
+
+    APP_Effect_Configure(effect, desc);
+    return effect;
+}
+
+void
+APP_Effect_Destroy(struct APP_Effect *effect)
+{
+    if (effect == NULL)
+    {
+        return;
+    }
+
+    SDL_free(effect->lines);
+    SDL_free(effect);
+}
+
+bool
+APP_Effect_CanTake(const struct APP_Effect *effect, const struct APP_EffectDesc *desc)
+{
+    if (effect == NULL || desc == NULL || effect->type != desc->type)
+    {
+        return false;
+    }
+
+    return effect->type != APP_EFFECT_DELAY || APP_Effect_DelayFrames(desc, effect->freq) <= effect->capacity;
+}
+
+// Silence in the lines and the filter state, for a bus that went quiet.
+static void
+APP_Effect_Clear(struct APP_Effect *effect)
+{
+    effect->z1[0] = effect->z1[1] = 0.0f;
+    effect->z2[0] = effect->z2[1] = 0.0f;
+
+    if (effect->lines != NULL)
+    {
+        SDL_memset(effect->lines, 0, sizeof(float) * effect->length * effect->line_count);
+    }
+}
+
+// ============================================================================
+// Buses
+// ============================================================================
+
+struct APP_Effects *
+APP_Effects_Create(int freq)
+{
+    if (freq <= 0)
+    {
+        return NULL;
+    }
+
+    struct APP_Effects *effects = SDL_calloc(1, sizeof(struct APP_Effects));
+    if (effects == NULL)
+    {
+        return NULL;
+    }
+
+    // Both sides of every bus and the scratch lanes.
+    const size_t block_bytes = sizeof(float) * APP_EFFECTS_BLOCK_FRAMES;
+    const size_t bytes = block_bytes * (APP_EFFECTS_MAX_BUSES * 2 + 1);
+    effects->memory = SDL_aligned_alloc(16, bytes);
+    if (effects->memory == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate %u effect buses.", APP_EFFECTS_MAX_BUSES);
+        APP_Effects_Destroy(effects);
+        return NULL;
+    }
+
+    SDL_memset(effects->memory, 0, bytes);
+
+    float *memory = effects->memory;
+    for (Uint32 b = 0; b < APP_EFFECTS_MAX_BUSES; ++b)
+    {
+        struct APP_EffectBus *bus = &effects->buses[b];
+        bus->samples[0] = memory + (size_t)(b * 2) * APP_EFFECTS_BLOCK_FRAMES;
+        bus->samples[1] = memory + (size_t)(b * 2 + 1) * APP_EFFECTS_BLOCK_FRAMES;
+        bus->output = APP_EFFECTS_MASTER;
+        bus->gain = 1.0f;
+        bus->current_gain = 1.0f;
+    }
+
+    effects->scratch = memory + (size_t)APP_EFFECTS_MAX_BUSES * 2 * APP_EFFECTS_BLOCK_FRAMES;
+    effects->freq = freq;
+
+    effects->scalar_kernels.biquad = APP_Biquad_Scalar;
+    effects->scalar_kernels.delay = APP_Delay_Scalar;
+    effects->scalar_kernels.reverb = APP_Reverb_Scalar;
+    effects->simd_kernels = effects->scalar_kernels;
+
+#ifdef APP_EFFECTS_SSE
+    if (SDL_HasSSE())
+    {
+        effects->simd_kernels.biquad = APP_Biquad_SSE;
+        effects->simd_kernels.delay = APP_Delay_SSE;
+        effects->simd_kernels.reverb = APP_Reverb_SSE;
+        effects->has_simd = true;
+
+        // Note(john): Flush to zero, and denormals are zero where the CPU
+        // has it. A tail dying away in the lines would otherwise crawl
+        // through denormals for a while before the bus goes to sleep.
+        effects->flush_bits = 0x8000 | (SDL_HasSSE2() ? 0x0040 : 0);
+    }
+#endif
+#ifdef APP_EFFECTS_NEON
+    if (SDL_HasNEON())
+    {
+        effects->simd_kernels.biquad = APP_Biquad_NEON;
+        effects->simd_kernels.delay = APP_Delay_NEON;
+        effects->simd_kernels.reverb = APP_Reverb_NEON;
+        effects->has_simd = true;
+    }
+#endif
+
+    effects->kernels = effects->simd_kernels;
+    return effects;
+}
+
+void
+APP_Effects_Destroy(struct APP_Effects *effects)
+{
+    if (effects == NULL)
+    {
+        return;
+    }
+
+    for (Uint32 b = 0; b < APP_EFFECTS_MAX_BUSES; ++b)
+    {
+        for (Uint32 s = 0; s < APP_EFFECTS_MAX_CHAIN; ++s)
+        {
+            APP_Effect_Destroy(effects->buses[b].chain[s]);
+        }
+    }
+
+    SDL_aligned_free(effects->memory);
+    SDL_free(effects);
+}
+
+// A bus keeps running until what went through every effect of its chain
+// played out.
+static void
+APP_EffectBus_UpdateTail(struct APP_EffectBus *bus)
+{
+    Uint64 tail = 0;
+    for (Uint32 s = 0; s < APP_EFFECTS_MAX_CHAIN; ++s)
+    {
+        tail += bus->chain[s] != NULL ? bus->chain[s]->tail_frames : 0;
+    }
+
+    bus->tail_frames = (Uint32)SDL_min(tail, (Uint64)SDL_MAX_UINT32);
+}
+
+struct APP_Effect *
+APP_Effects_Swap(struct APP_Effects *effects, Uint32 bus, Uint32 slot, struct APP_Effect *effect)
+{
+    if (bus >= APP_EFFECTS_MAX_BUSES || slot >= APP_EFFECTS_MAX_CHAIN)
+    {
+        return effect;
+    }
+
+    struct APP_EffectBus *target = &effects->buses[bus];
+    struct APP_Effect *old = target->chain[slot];
+    target->chain[slot] = effect;
+    APP_EffectBus_UpdateTail(target);
+    return old;
+}
+
+void
+APP_Effects_SetParams(struct APP_Effects *effects, Uint32 bus, Uint32 slot, const struct APP_EffectDesc *desc)
+{
+    if (bus >= APP_EFFECTS_MAX_BUSES || slot >= APP_EFFECTS_MAX_CHAIN)
+    {
+        return;
+    }
+
+    struct APP_EffectBus *target = &effects->buses[bus];
+    struct APP_Effect *effect = target->chain[slot];
+    if (effect != NULL && effect->type == desc->type)
+    {
+        APP_Effect_Configure(effect, desc);
+        APP_EffectBus_UpdateTail(target);
+    }
+}
+
+void
+APP_Effects_SetOutput(struct APP_Effects *effects, Uint32 bus, int output, float gain)
+{
+    if (bus >= APP_EFFECTS_MAX_BUSES
+        || (output != APP_EFFECTS_MASTER && (output <= (int)bus || output >= APP_EFFECTS_MAX_BUSES)))
+    {
+        return;
+    }
+
+    struct APP_EffectBus *target = &effects->buses[bus];
+    if (target->output != output)
+    {
+        // Fades in where it goes now.
+        target->output = output;
+        target->current_gain = 0.0f;
+    }
+
+    target->gain = SDL_max(gain, 0.0f);
+}
+
+void
+APP_Effects_GetInput(struct APP_Effects *effects, Uint32 bus, float **out_left, float **out_right)
+{
+    struct APP_EffectBus *target = &effects->buses[SDL_min(bus, APP_EFFECTS_MAX_BUSES - 1u)];
+    target->fed = true;
+    *out_left = target->samples[0];
+    *out_right = target->samples[1];
+}
+
+// One run of the filter kernel over the effects in this slot of up to two
+// buses, their cost split between them.
+static void
+APP_Effects_RunFilterGroup(
+        struct APP_Effects *effects,
+        struct APP_EffectBus **buses,
+        Uint32 count,
+        Uint32 slot,
+        Uint32 frames
+)
+{
+    struct APP_BiquadLanes lanes;
+    SDL_zero(lanes);
+
+    for (Uint32 k = 0; k < 4; ++k)
+    {
+        lanes.samples[k] = effects->scratch;
+    }
+
+    for (Uint32 b = 0; b < count; ++b)
+    {
+        const struct APP_Effect *effect = buses[b]->chain[slot];
+        for (Uint32 c = 0; c < 2; ++c)
+        {
+            Uint32 k = b * 2 + c;
+            lanes.samples[k] = buses[b]->samples[c];
+            lanes.b0[k] = effect->b0;
+            lanes.b1[k] = effect->b1;
+            lanes.b2[k] = effect->b2;
+            lanes.a1[k] = effect->a1;
+            lanes.a2[k] = effect->a2;
+            lanes.z1[k] = effect->z1[c];
+            lanes.z2[k] = effect->z2[c];
+        }
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    effects->kernels.biquad(&lanes, frames);
+    Uint64 ticks = SDL_GetPerformanceCounter() - start;
+
+    for (Uint32 b = 0; b < count; ++b)
+    {
+        struct APP_Effect *effect = buses[b]->chain[slot];
+        for (Uint32 c = 0; c < 2; ++c)
+        {
+            effect->z1[c] = lanes.z1[b * 2 + c];
+            effect->z2[c] = lanes.z2[b * 2 + c];
+        }
+
+        effects->ticks[effect->type] += ticks / count;
+        ++effects->runs[effect->type];
+        ++effects->count[effect->type];
+    }
+}
+
+// This slot of every bus at this level. Filters go through the kernel two
+// buses at a time, delays and reverbs one by one.
+static void
+APP_Effects_RunSlot(struct APP_Effects *effects, Uint32 level, Uint32 slot, Uint32 frames)
+{
+    struct APP_EffectBus *group[2];
+    Uint32 grouped = 0;
+
+    for (Uint32 b = 0; b < APP_EFFECTS_MAX_BUSES; ++b)
+    {
+        struct APP_EffectBus *bus = &effects->buses[b];
+        struct APP_Effect *effect = bus->chain[slot];
+        if (!bus->awake || bus->level != level || effect == NULL)
+        {
+            continue;
+        }
+
+        if (APP_Effect_IsFilter(effect->type))
+        {
+            group[grouped++] = bus;
+            if (grouped == 2)
+            {
+                APP_Effects_RunFilterGroup(effects, group, grouped, slot, frames);
+                grouped = 0;
+            }
+
+            continue;
+        }
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (effect->type == APP_EFFECT_DELAY)
+        {
+            effects->kernels.delay(effect, bus->samples[0], bus->samples[1], frames);
+        }
+        else
+        {
+            effects->kernels.reverb(effect, bus->samples[0], bus->samples[1], frames);
+        }
+
+        effects->ticks[effect->type] += SDL_GetPerformanceCounter() - start;
+        ++effects->runs[effect->type];
+        ++effects->count[effect->type];
+    }
+
+    if (grouped > 0)
+    {
+        APP_Effects_RunFilterGroup(effects, group, grouped, slot, frames);
+    }
+}
+
+// Adds what the bus made into where it returns to, the gain ramping over
+// the block.
+static void
+APP_Effects_Return(struct APP_Effects *effects, struct APP_EffectBus *bus, float *dst_left, float *dst_right, Uint32 frames)
+{
+    float *dst[2] = { dst_left, dst_right };
+    if (bus->output != APP_EFFECTS_MASTER)
+    {
+        dst[0] = effects->buses[bus->output].samples[0];
+        dst[1] = effects->buses[bus->output].samples[1];
+    }
+
+    const float gain = bus->current_gain;
+    const float step = (bus->gain - gain) / (float)frames;
+    for (Uint32 c = 0; c < 2; ++c)
+    {
+        const float *src = bus->samples[c];
+        float *out = dst[c];
+        for (Uint32 i = 0; i < frames; ++i)
+        {
+            out[i] += src[i] * (gain + step * (float)i);
+        }
+    }
+
+    bus->current_gain = bus->gain;
+}
+
+void
+APP_Effects_Process(struct APP_Effects *effects, float *dst_left, float *dst_right, Uint32 frames)
+{
+    frames = SDL_min(frames, (Uint32)APP_EFFECTS_BLOCK_FRAMES);
+    if (frames == 0)
+    {
+        return;
+    }
+
+#ifdef APP_EFFECTS_SSE
+    Uint32 csr = effects->flush_bits != 0 ? APP_Effects_FlushDenormals_SSE(effects->flush_bits) : 0;
+#endif
+
+    SDL_zeroa(effects->count);
+    effects->awake_buses = 0;
+
+    // Note(john): A bus only returns into buses after it, so one pass in
+    // order knows everything that feeds a bus by the time it gets there.
+    // Buses on the same level wait on none of each other and run together.
+    Uint32 levels = 0;
+    for (Uint32 b = 0; b < APP_EFFECTS_MAX_BUSES; ++b)
+    {
+        struct APP_EffectBus *bus = &effects->buses[b];
+        bus->quiet_frames = bus->fed ? 0 : bus->quiet_frames;
+
+        bool awake = bus->fed || bus->quiet_frames < bus->tail_frames;
+        if (!awake)
+        {
+            if (bus->awake)
+            {
+                for (Uint32 s = 0; s < APP_EFFECTS_MAX_CHAIN; ++s)
+                {
+                    if (bus->chain[s] != NULL)
+                    {
+                        APP_Effect_Clear(bus->chain[s]);
+                    }
+                }
+            }
+
+            bus->awake = false;
+            bus->level = 0;
+            continue;
+        }
+
+        bus->awake = true;
+        bus->quiet_frames += bus->fed ? 0 : frames;
+        levels = SDL_max(levels, bus->level + 1);
+        ++effects->awake_buses;
+
+        if (bus->output != APP_EFFECTS_MASTER)
+        {
+            struct APP_EffectBus *target = &effects->buses[bus->output];
+            target->fed = true;
+            target->level = SDL_max(target->level, bus->level + 1);
+        }
+    }
+
+    for (Uint32 level = 0; level < levels; ++level)
+    {
+        for (Uint32 s = 0; s < APP_EFFECTS_MAX_CHAIN; ++s)
+        {
+            APP_Effects_RunSlot(effects, level, s, frames);
+        }
+
+        for (Uint32 b = 0; b < APP_EFFECTS_MAX_BUSES; ++b)
+        {
+            struct APP_EffectBus *bus = &effects->buses[b];
+            if (bus->awake && bus->level == level)
+            {
+                APP_Effects_Return(effects, bus, dst_left, dst_right, frames);
+                SDL_memset(bus->samples[0], 0, sizeof(float) * frames);
+                SDL_memset(bus->samples[1], 0, sizeof(float) * frames);
+            }
+        }
+    }
+
+    for (Uint32 b = 0; b < APP_EFFECTS_MAX_BUSES; ++b)
+    {
+        effects->buses[b].fed = false;
+        effects->buses[b].level = 0;
+    }
+
+#ifdef APP_EFFECTS_SSE
+    if (effects->flush_bits != 0)
+    {
+        APP_Effects_RestoreDenormals_SSE(csr);
+    }
+#endif
+}
+
+bool
+APP_Effects_UseSIMD(struct APP_Effects *effects, bool simd)
+{
+    effects->kernels = simd ? effects->simd_kernels : effects->scalar_kernels;
+    return !simd || effects->has_simd;
+}
+
+void
+APP_Effects_GetStats(const struct APP_Effects *effects, struct APP_EffectStats *out_stats)
+{
+    SDL_zerop(out_stats);
+
+    const double tick_ms = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    for (Uint32 t = 0; t < APP_EFFECT_TYPE_COUNT; ++t)
+    {
+        out_stats->ms[t] = (double)effects->ticks[t] * tick_ms;
+        out_stats->runs[t] = effects->runs[t];
+        out_stats->count[t] = effects->count[t];
+    }
+
+    out_stats->awake_buses = effects->awake_buses;
+}
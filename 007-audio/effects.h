@@ -0,0 +1,101 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <SDL3/SDL.h>
+
+// Effect buses for the mixer. Voices send into a bus, the bus runs its chain
+// of effects over what they sent and returns the result into the master bus
+// or into a later bus. Filters of all buses are run together, four channels
+// at a time with SSE or NEON. Delays and reverbs run four frames at a time,
+// the shortest line is longer than that so no frame waits on the ones next
+// to it.
+
+#define APP_EFFECTS_MAX_BUSES 16
+#define APP_EFFECTS_MAX_CHAIN 4
+// The most frames one call processes, the mixer's block.
+#define APP_EFFECTS_BLOCK_FRAMES 256
+// Where a bus returns to unless routed into another bus.
+#define APP_EFFECTS_MASTER -1
+// The longest delay an effect takes.
+#define APP_EFFECTS_MAX_DELAY_MS 4000.0f
+
+enum APP_EffectType {
+    APP_EFFECT_NONE,
+    APP_EFFECT_LOWPASS,
+    APP_EFFECT_HIGHPASS,
+    // A peaking band, boosts or cuts around its frequency.
+    APP_EFFECT_EQ,
+    APP_EFFECT_DELAY,
+    APP_EFFECT_REVERB,
+    APP_EFFECT_TYPE_COUNT,
+};
+
+struct APP_EffectDesc {
+    enum APP_EffectType type;
+    // Filters: the cutoff or the center in Hz, the resonance, and the EQ
+    // band's gain in dB.
+    float frequency;
+    float q;
+    float gain_db;
+    // Delay: the time between echoes. Reverb: the time it takes to fall by
+    // 60 dB.
+    float time_ms;
+    // Delay: the share of every echo that comes back, below 1.
+    float feedback;
+    // Delay and reverb: how much faster the highs die away, 0 to 1.
+    float damping;
+    // The share of the effect in what comes out, 1 for the effect alone.
+    float mix;
+};
+
+// Totals since the effects were created, the counts as of the last block.
+struct APP_EffectStats {
+    double ms[APP_EFFECT_TYPE_COUNT];
+    // Effect blocks run, one per effect and block.
+    Uint64 runs[APP_EFFECT_TYPE_COUNT];
+    Uint32 count[APP_EFFECT_TYPE_COUNT];
+    // Buses that ran in the last block, the others were quiet.
+    Uint32 awake_buses;
+};
+
+const char *APP_Effect_GetTypeName(enum APP_EffectType type);
+
+// One effect of a chain. It allocates its lines, so create and destroy it
+// off the audio thread. NULL for APP_EFFECT_NONE.
+struct APP_Effect;
+
+struct APP_Effect *APP_Effect_Create(const struct APP_EffectDesc *desc, int freq);
+void APP_Effect_Destroy(struct APP_Effect *effect);
+// Whether the effect can take desc in place, same type and room for the
+// delay. Only reads what never changes, safe while the audio thread runs
+// the effect.
+bool APP_Effect_CanTake(const struct APP_Effect *effect, const struct APP_EffectDesc *desc);
+
+struct APP_Effects;
+
+struct APP_Effects *APP_Effects_Create(int freq);
+// Destroys the effects still in the buses too.
+void APP_Effects_Destroy(struct APP_Effects *effects);
+
+// The rest on the thread that processes. Puts the effect into a chain and
+// returns the one that was there, NULL to clear the slot.
+struct APP_Effect *APP_Effects_Swap(struct APP_Effects *effects, Uint32 bus, Uint32 slot, struct APP_Effect *effect);
+// New parameters for the effect in the slot, see APP_Effect_CanTake.
+void APP_Effects_SetParams(struct APP_Effects *effects, Uint32 bus, Uint32 slot, const struct APP_EffectDesc *desc);
+// A bus returns into the master bus or into a bus after it, anything else
+// is ignored. The gain ramps over one block.
+void APP_Effects_SetOutput(struct APP_Effects *effects, Uint32 bus, int output, float gain);
+
+// Where the next block is sent into, planar stereo. Marks the bus as fed
+// for this block.
+void APP_Effects_GetInput(struct APP_Effects *effects, Uint32 bus, float **out_left, float **out_right);
+// Runs every bus that was fed or still has a tail to play out, adds the
+// returns into dst and clears the inputs for the next block.
+void APP_Effects_Process(struct APP_Effects *effects, float *dst_left, float *dst_right, Uint32 frames);
+
+// With the SSE or NEON kernels or without, for benchmarks. False when
+// there are none.
+bool APP_Effects_UseSIMD(struct APP_Effects *effects, bool simd);
+void APP_Effects_GetStats(const struct APP_Effects *effects, struct APP_EffectStats *out_stats);
+
+#endif
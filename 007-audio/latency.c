@@ -0,0 +1,195 @@
+#include "latency.h"
+
+struct APP_Latency {
+    struct APP_Mixer *mixer;
+    SDL_AudioDeviceID device;
+    bool adaptive;
+
+    int buffer_frames;
+    int device_freq;
+    // The largest size that had underruns, nothing at or below it is tried
+    // again.
+    int failed_frames;
+
+    Uint64 settled_since;
+    // Underruns the mixer had counted by the first update after opening.
+    Uint32 underruns_before;
+    bool opened;
+    // Underruns from the sizes before this one.
+    Uint32 underruns_total;
+    Uint32 underruns_now;
+
+    Uint32 shrinks;
+    Uint32 backoffs;
+    struct APP_MixerStats last;
+};
+
+static bool
+APP_Latency_Open(struct APP_Latency *latency, int buffer_frames)
+{
+    // Note(john): SDL reads the hint when it opens the physical device, the
+    // mixer's stream is the only one on it so closing the stream closes the
+    // device too.
+    if (buffer_frames > 0)
+    {
+        char frames[16];
+        SDL_snprintf(frames, sizeof(frames), "%d", buffer_frames);
+        SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, frames);
+    }
+
+    if (!APP_Mixer_OpenDevice(latency->mixer, latency->device))
+    {
+        return false;
+    }
+
+    SDL_AudioStream *stream = APP_Mixer_GetStream(latency->mixer);
+    SDL_AudioSpec spec;
+    int frames = 0;
+
+    if (!SDL_GetAudioDeviceFormat(SDL_GetAudioStreamDevice(stream), &spec, &frames) || frames <= 0)
+    {
+        spec.freq = APP_Mixer_GetFrequency(latency->mixer);
+        frames = buffer_frames;
+    }
+
+    latency->buffer_frames = frames;
+    latency->device_freq = spec.freq;
+    latency->opened = true;
+    latency->underruns_total += latency->underruns_now;
+    latency->underruns_now = 0;
+    latency->underruns_before = 0;
+    return true;
+}
+
+struct APP_Latency *
+APP_Latency_Create(struct APP_Mixer *mixer, SDL_AudioDeviceID device, int buffer_frames, bool adaptive)
+{
+    struct APP_Latency *latency = SDL_calloc(1, sizeof(struct APP_Latency));
+    if (latency == NULL)
+    {
+        return NULL;
+    }
+
+    latency->mixer = mixer;
+    latency->device = device;
+    latency->adaptive = adaptive;
+
+    if (buffer_frames > 0)
+    {
+        buffer_frames = SDL_clamp(buffer_frames, APP_LATENCY_MIN_FRAMES, APP_LATENCY_MAX_FRAMES);
+    }
+
+    if (!APP_Latency_Open(latency, buffer_frames))
+    {
+        SDL_free(latency);
+        return NULL;
+    }
+
+    return latency;
+}
+
+void
+APP_Latency_Destroy(struct APP_Latency *latency)
+{
+    SDL_free(latency);
+}
+
+// Open the device again at the new size and pick up playing where it was.
+static bool
+APP_Latency_Resize(struct APP_Latency *latency, int buffer_frames, const char *reason)
+{
+    int old_frames = latency->buffer_frames;
+
+    if (!APP_Latency_Open(latency, buffer_frames))
+    {
+        return false;
+    }
+
+    if (!SDL_ResumeAudioStreamDevice(APP_Mixer_GetStream(latency->mixer)))
+    {
+        SDL_Log("ERROR: Failed resume audio device. %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_Log(
+            "INFO: Device buffer %d -> %d frames (%.2f ms), %s",
+            old_frames,
+            latency->buffer_frames,
+            (double)latency->buffer_frames * 1000.0 / (double)latency->device_freq,
+            reason
+    );
+
+    // The device didn't go any smaller, there is nothing left to try.
+    if (latency->buffer_frames >= old_frames && buffer_frames < old_frames)
+    {
+        latency->failed_frames = SDL_max(latency->failed_frames, buffer_frames);
+    }
+
+    return true;
+}
+
+bool
+APP_Latency_Update(struct APP_Latency *latency, const struct APP_MixerStats *stats)
+{
+    latency->last = *stats;
+
+    Uint64 now = SDL_GetTicks();
+    if (latency->opened)
+    {
+        latency->opened = false;
+        latency->underruns_before = stats->underruns;
+        latency->settled_since = now;
+        return true;
+    }
+
+    latency->underruns_now = stats->underruns - SDL_min(latency->underruns_before, stats->underruns);
+
+    if (!latency->adaptive)
+    {
+        return true;
+    }
+
+    if (latency->underruns_now > 0)
+    {
+        latency->failed_frames = SDL_max(latency->failed_frames, latency->buffer_frames);
+        if (latency->buffer_frames >= APP_LATENCY_MAX_FRAMES)
+        {
+            return true;
+        }
+
+        ++latency->backoffs;
+        int frames = SDL_min(latency->buffer_frames * 2, APP_LATENCY_MAX_FRAMES);
+        return APP_Latency_Resize(latency, frames, "backing off after an underrun");
+    }
+
+    int smaller = latency->buffer_frames / 2;
+    if (now - latency->settled_since >= APP_LATENCY_SETTLE_MS
+        && smaller >= APP_LATENCY_MIN_FRAMES
+        && smaller > latency->failed_frames)
+    {
+        ++latency->shrinks;
+        return APP_Latency_Resize(latency, smaller, "no underruns");
+    }
+
+    return true;
+}
+
+void
+APP_Latency_GetStats(const struct APP_Latency *latency, struct APP_LatencyStats *out_stats)
+{
+    const struct APP_MixerStats *last = &latency->last;
+    double queued_ms = (double)last->max_queued_bytes * 1000.0
+        / ((double)sizeof(float) * 2.0 * (double)APP_Mixer_GetFrequency(latency->mixer));
+
+    SDL_zerop(out_stats);
+    out_stats->buffer_frames = latency->buffer_frames;
+    out_stats->device_freq = latency->device_freq;
+    out_stats->latency_ms = (float)((double)latency->buffer_frames * 1000.0 / (double)latency->device_freq + queued_ms);
+    out_stats->mean_callback_ms = last->callbacks > 0 ? (float)(last->callback_ms / last->callbacks) : 0.0f;
+    out_stats->max_callback_ms = last->max_callback_ms;
+    out_stats->max_interval_ms = last->max_interval_ms;
+    out_stats->underruns = latency->underruns_total + latency->underruns_now;
+    out_stats->shrinks = latency->shrinks;
+    out_stats->backoffs = latency->backoffs;
+    out_stats->adaptive = latency->adaptive;
+}
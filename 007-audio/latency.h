@@ -0,0 +1,46 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "mixer.h"
+
+// Owns the mixer's device stream and the size of the device buffer. With
+// adapting on it starts from the device's size and halves it every time the
+// device played a while without underruns, down to the smallest size that
+// holds up on this machine. An underrun doubles it again and the size that
+// failed is never tried again.
+
+#define APP_LATENCY_MIN_FRAMES 64
+#define APP_LATENCY_MAX_FRAMES 8192
+// Time without underruns before the buffer halves. Underruns up to the
+// first update after the device opened don't count.
+#define APP_LATENCY_SETTLE_MS 4000
+
+struct APP_LatencyStats {
+    // The device buffer as the device reports it.
+    int buffer_frames;
+    int device_freq;
+    // The device buffer and what the stream held on top, the least the
+    // audio takes to get from the mixer to the device.
+    float latency_ms;
+    float mean_callback_ms;
+    float max_callback_ms;
+    float max_interval_ms;
+    Uint32 underruns;
+    Uint32 shrinks;
+    Uint32 backoffs;
+    bool adaptive;
+};
+
+struct APP_Latency;
+
+// Opens the mixer's device stream paused. buffer_frames 0 keeps the
+// device's default.
+struct APP_Latency *APP_Latency_Create(struct APP_Mixer *mixer, SDL_AudioDeviceID device, int buffer_frames, bool adaptive);
+void APP_Latency_Destroy(struct APP_Latency *latency);
+
+// With the stats the game thread just got from the mixer. May reopen the
+// device with a new buffer size, false when that failed.
+bool APP_Latency_Update(struct APP_Latency *latency, const struct APP_MixerStats *stats);
+void APP_Latency_GetStats(const struct APP_Latency *latency, struct APP_LatencyStats *out_stats);
+
+#endif
@@ -3,70 +3,913 @@
 #include <SDL3/SDL_main.h>
 #include <SDL3/SDL.h>
 
+#include "bench.h"
+#include "latency.h"
+#include "mixer.h"
+#include "pack.h"
+#include "render.h"
+#include "soundbank.h"
+#include "spatial.h"
+#include "stress.h"
+#include "wavstream.h"
+
+#define DEFAULT_TRACK "audio/default.wav"
+#define STATS_LOG_INTERVAL_MS 1000
+// Mixer rate when the device doesn't tell its own.
+#define DEFAULT_MIXER_FREQ 48000
+#define DEFAULT_BANK_BUDGET_MB 64
+#define DEFAULT_SPATIAL_VOICES 32
+// The emitters circle the listener out to this distance.
+#define EMITTER_FIELD_RADIUS 300.0f
+// Echo and reverb send levels of the track with --effects.
+#define MUSIC_ECHO_SEND 0.2f
+#define MUSIC_REVERB_SEND 0.35f
+// An offline render stops here if the voices still play.
+#define DEFAULT_RENDER_SECONDS 600.0
+// Game updates per second of rendered audio.
+#define RENDER_UPDATE_HZ 60
+// The most a sample may differ from the reference, about -80 dBFS.
+#define RENDER_COMPARE_TOLERANCE 0.0001f
+// Seeds the random pan, pitch and orbits of --voices and --emitters.
+#define DEFAULT_SEED 1
+
+// An emitter circling the listener.
+struct APP_Orbit {
+    float radius;
+    float height;
+    float phase;
+    // Radians per second, negative for clockwise.
+    float speed;
+};
+
+struct APP_Context {
+    struct APP_Pack *pack;
+    struct APP_Mixer *mixer;
+    struct APP_Latency *latency;
+
+    // Streamed track, or the whole file with --whole-file.
+    struct APP_WavStream *music;
+    struct APP_SoundBank *bank;
+    // Held from the bank, NULL while streaming without the extra voices.
+    const struct APP_Sound *sound;
+    APP_VoiceID music_voice;
+    bool music_finished;
+
+    // Only with --stress.
+    struct APP_Stress *stress;
+
+    // Only with --emitters.
+    struct APP_Spatial *spatial;
+    struct APP_Orbit *orbits;
+    APP_EmitterID *emitters;
+    Uint32 emitter_count;
+    Uint64 last_update;
+    // Seconds of audio rendered, only with --render.
+    double render_time;
+
+    // Only with --effects.
+    Uint32 effect_buses;
+
+    Uint64 last_stats;
+};
+
+// The track from the asset pack next to the executable, or the loose file
+// relative to the working directory when the pack doesn't have it.
+static SDL_IOStream*
+APP_OpenTrack(struct APP_Context *ctx, const char *asset_path)
+{
+    SDL_IOStream *io = APP_Pack_OpenIO(ctx->pack, asset_path);
+    if (io != NULL)
+    {
+        return io;
+    }
+
+    return SDL_IOFromFile(asset_path, "rb");
+}
+
+// The share of the audio time the buses took and what one effect of each
+// type costs per block, with how many of them ran in the last block.
+static void
+APP_LogEffectStats(struct APP_Context *ctx, const struct APP_MixerStats *mixing)
+{
+    const struct APP_EffectStats *effects = &mixing->effects;
+    char costs[256] = "";
+    size_t length = 0;
+
+    for (int t = APP_EFFECT_NONE + 1; t < APP_EFFECT_TYPE_COUNT && length < sizeof(costs); ++t)
+    {
+        if (effects->runs[t] == 0)
+        {
+            continue;
+        }
+
+        length += (size_t)SDL_snprintf(
+                costs + length,
+                sizeof(costs) - length,
+                ", %u %s %.2f us",
+                effects->count[t],
+                APP_Effect_GetTypeName((enum APP_EffectType)t),
+                effects->ms[t] * 1000.0 / (double)effects->runs[t]
+        );
+    }
+
+    SDL_Log(
+            "INFO: Effects %u of %u buses awake, %.2f%% of the audio time, per effect and block%s",
+            effects->awake_buses,
+            ctx->effect_buses,
+            mixing->audio_ms > 0.0 ? mixing->effects_ms * 100.0 / mixing->audio_ms : 0.0,
+            costs
+    );
+}
+
+static void
+APP_LogMusicStats(struct APP_Context *ctx, const struct APP_MixerStats *mixing)
+{
+    struct APP_LatencyStats latency;
+    APP_Latency_GetStats(ctx->latency, &latency);
+
+    SDL_Log(
+            "INFO: Device %d frames at %d Hz, %.2f ms latency, callbacks %.3f ms mean, %.3f ms max, %.2f ms max apart, %u underruns%s",
+            latency.buffer_frames,
+            latency.device_freq,
+            latency.latency_ms,
+            latency.mean_callback_ms,
+            latency.max_callback_ms,
+            latency.max_interval_ms,
+            latency.underruns,
+            latency.adaptive ? " (adapting)" : ""
+    );
+
+    SDL_Log(
+            "INFO: Mixer %u voices (peak %u, %u rejected), %u commands dropped, %u late blocks, %.2f%% of the audio time mixing, limiter %.1f dB, %d bytes queued",
+            mixing->active_voices,
+            mixing->peak_voices,
+            mixing->rejected_voices,
+            mixing->dropped_commands,
+            mixing->late_blocks,
+            mixing->audio_ms > 0.0 ? mixing->mix_ms * 100.0 / mixing->audio_ms : 0.0,
+            -mixing->limiter_reduction_db,
+            SDL_GetAudioStreamQueued(APP_Mixer_GetStream(ctx->mixer))
+    );
+
+    if (ctx->effect_buses > 0)
+    {
+        APP_LogEffectStats(ctx, mixing);
+    }
+
+    if (ctx->spatial != NULL)
+    {
+        struct APP_SpatialStats spatial;
+        APP_Spatial_GetStats(ctx->spatial, &spatial);
+
+        SDL_Log(
+                "INFO: Spatial %u emitters, %u audible, %u real, %u virtual, %u promoted, %u demoted, %u without a voice, update %.3f ms mean %.3f ms max",
+                spatial.emitters,
+                spatial.audible,
+                spatial.real,
+                spatial.virtual_emitters,
+                spatial.promotions,
+                spatial.demotions,
+                spatial.failed_promotions,
+                spatial.mean_update_ms,
+                spatial.max_update_ms
+        );
+    }
+
+    struct APP_SoundBankStats bank;
+    APP_SoundBank_GetStats(ctx->bank, &bank);
+    Uint32 lookups = bank.hits + bank.misses;
+
+    SDL_Log(
+            "INFO: Sound bank %u sounds, %llu KB resident of %llu KB (high water %llu KB), %.1f%% hits (%u hits, %u misses, %u joined loads), %u loading, %u evicted",
+            bank.sound_count,
+            (unsigned long long)(bank.resident_bytes / 1024),
+            (unsigned long long)(bank.budget_bytes / 1024),
+            (unsigned long long)(bank.high_water_bytes / 1024),
+            lookups > 0 ? bank.hits * 100.0 / lookups : 0.0,
+            bank.hits,
+            bank.misses,
+            bank.joined_loads,
+            bank.pending_loads,
+            bank.evictions
+    );
+
+    if (ctx->music == NULL)
+    {
+        return;
+    }
+
+    const SDL_AudioSpec *spec = APP_WavStream_GetSpec(ctx->music);
+    struct APP_WavStreamStats stats;
+    APP_WavStream_GetStats(ctx->music, &stats);
+
+    SDL_Log(
+            "INFO: %.2f / %.2f s, %u KB resident, %u KB buffered, %llu KB streamed, %u underruns, %u loops",
+            (double)APP_WavStream_GetPosition(ctx->music) / spec->freq,
+            (double)APP_WavStream_GetFrameCount(ctx->music) / spec->freq,
+            stats.resident_bytes / 1024,
+            stats.buffered_bytes / 1024,
+            (unsigned long long)(stats.streamed_bytes / 1024),
+            stats.underruns,
+            stats.loops
+    );
+}
+
+// Effect buses, the last one a reverb that returns into the master bus.
+// Before it an echo, high-passed so it doesn't muddy the low end. The ones
+// before that filter and echo a group of the extra voices each and return
+// into the reverb.
+static bool
+APP_CreateEffectBuses(struct APP_Context *ctx, Uint32 count)
+{
+    count = SDL_min(count, (Uint32)APP_EFFECTS_MAX_BUSES);
+
+    const Uint32 reverb_bus = count - 1;
+    struct APP_EffectDesc reverb = { APP_EFFECT_REVERB, 0.0f, 0.0f, 0.0f, 2400.0f, 0.0f, 0.4f, 1.0f };
+    bool ok = APP_Mixer_SetEffect(ctx->mixer, reverb_bus, 0, &reverb);
+    ok = ok && APP_Mixer_SetBusOutput(ctx->mixer, reverb_bus, APP_EFFECTS_MASTER, 0.5f);
+
+    if (count > 1)
+    {
+        const Uint32 echo_bus = count - 2;
+        struct APP_EffectDesc highpass = { APP_EFFECT_HIGHPASS, 250.0f, 0.707f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+        struct APP_EffectDesc echo = { APP_EFFECT_DELAY, 0.0f, 0.0f, 0.0f, 375.0f, 0.45f, 0.3f, 1.0f };
+        ok = ok && APP_Mixer_SetEffect(ctx->mixer, echo_bus, 0, &highpass);
+        ok = ok && APP_Mixer_SetEffect(ctx->mixer, echo_bus, 1, &echo);
+        ok = ok && APP_Mixer_SetBusOutput(ctx->mixer, echo_bus, APP_EFFECTS_MASTER, 0.5f);
+    }
+
+    for (Uint32 b = 0; b + 2 < count; ++b)
+    {
+        struct APP_EffectDesc chain[] = {
+            { APP_EFFECT_HIGHPASS, 120.0f, 0.707f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+            { APP_EFFECT_EQ, 800.0f + 300.0f * (float)b, 1.0f, 4.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+            { APP_EFFECT_LOWPASS, 1500.0f + 700.0f * (float)b, 0.9f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+            { APP_EFFECT_DELAY, 0.0f, 0.0f, 0.0f, 90.0f + 23.0f * (float)b, 0.3f, 0.5f, 0.35f },
+        };
+
+        for (Uint32 s = 0; s < SDL_arraysize(chain); ++s)
+        {
+            ok = ok && APP_Mixer_SetEffect(ctx->mixer, b, s, &chain[s]);
+        }
+
+        ok = ok && APP_Mixer_SetBusOutput(ctx->mixer, b, (int)reverb_bus, 0.8f);
+    }
+
+    if (!ok)
+    {
+        SDL_Log("ERROR: Failed to set up %u effect buses.", count);
+        return false;
+    }
+
+    ctx->effect_buses = count;
+    SDL_Log("INFO: %u effect buses, the track sends into the echo and the reverb", count);
+    return true;
+}
+
+// Extra copies of the sound all over the stereo field, each at its own
+// pitch, to put some load on the mixer. With effect buses each sends into
+// one of the filtered groups, or into the reverb when there are none.
+static void
+APP_PlayExtraVoices(struct APP_Context *ctx, Uint32 count)
+{
+    for (Uint32 i = 0; i < count; ++i)
+    {
+        struct APP_VoiceParams params = {
+            0.5f / (float)count,
+            SDL_randf() * 2.0f - 1.0f,
+            0.5f + SDL_randf() * 1.5f,
+            true,
+        };
+
+        APP_VoiceID voice = APP_Mixer_Play(ctx->mixer, ctx->sound, &params);
+        if (voice == 0 || ctx->effect_buses == 0)
+        {
+            continue;
+        }
+
+        if (ctx->effect_buses > 2)
+        {
+            APP_Mixer_SetSend(ctx->mixer, voice, i % (ctx->effect_buses - 2), 1.0f);
+        }
+        else
+        {
+            APP_Mixer_SetSend(ctx->mixer, voice, ctx->effect_buses - 1, MUSIC_REVERB_SEND);
+        }
+    }
+}
+
+static void
+APP_OrbitEmitter(const struct APP_Orbit *orbit, float time, struct APP_Vector3 *out_position, struct APP_Vector3 *out_velocity)
+{
+    float angle = orbit->phase + orbit->speed * time;
+    float c = SDL_cosf(angle);
+    float s = SDL_sinf(angle);
+
+    *out_position = (struct APP_Vector3) { orbit->radius * c, orbit->height, orbit->radius * s };
+    *out_velocity = (struct APP_Vector3) { -orbit->radius * orbit->speed * s, 0.0f, orbit->radius * orbit->speed * c };
+}
+
+// Emitters playing the sound on random circles around the listener, the
+// spatial layer decides which of them are heard.
+static bool
+APP_CreateEmitters(struct APP_Context *ctx, Uint32 count, Uint32 voices)
+{
+    ctx->spatial = APP_Spatial_Create(ctx->mixer, count, voices);
+    ctx->orbits = SDL_malloc(sizeof(struct APP_Orbit) * count);
+    ctx->emitters = SDL_malloc(sizeof(APP_EmitterID) * count);
+
+    if (ctx->spatial == NULL || ctx->orbits == NULL || ctx->emitters == NULL)
+    {
+        return false;
+    }
+
+    for (Uint32 i = 0; i < count; ++i)
+    {
+        struct APP_Orbit orbit = {
+            5.0f + SDL_randf() * EMITTER_FIELD_RADIUS,
+            SDL_randf() * 10.0f - 5.0f,
+            SDL_randf() * 2.0f * SDL_PI_F,
+            (SDL_randf() * 2.0f - 1.0f) * 0.5f,
+        };
+
+        struct APP_Vector3 position;
+        struct APP_Vector3 velocity;
+        APP_OrbitEmitter(&orbit, 0.0f, &position, &velocity);
+
+        struct APP_EmitterDesc desc = { ctx->sound, position, velocity, 0.5f, 2.0f, EMITTER_FIELD_RADIUS * 0.5f, true };
+
+        ctx->orbits[i] = orbit;
+        ctx->emitters[i] = APP_Spatial_AddEmitter(ctx->spatial, &desc);
+    }
+
+    ctx->emitter_count = count;
+    ctx->last_update = SDL_GetTicksNS();
+
+    SDL_Log("INFO: %u emitters, the %u most audible get voices", count, voices);
+    return true;
+}
+
+static void
+APP_MoveEmitters(struct APP_Context *ctx, float time, float dt)
+{
+    for (Uint32 i = 0; i < ctx->emitter_count; ++i)
+    {
+        struct APP_Vector3 position;
+        struct APP_Vector3 velocity;
+        APP_OrbitEmitter(&ctx->orbits[i], time, &position, &velocity);
+        APP_Spatial_MoveEmitter(ctx->spatial, ctx->emitters[i], position, velocity);
+    }
+
+    APP_Spatial_Update(ctx->spatial, dt);
+}
+
+static void
+APP_UpdateEmitters(struct APP_Context *ctx)
+{
+    Uint64 now = SDL_GetTicksNS();
+    float dt = (float)((double)(now - ctx->last_update) / 1e9);
+    ctx->last_update = now;
+
+    APP_MoveEmitters(ctx, (float)((double)now / 1e9), dt);
+}
+
+// ============================================================================
+// Offline render
+// ============================================================================
+
+// The game update, on the clock of the rendered audio.
+static void
+APP_RenderUpdate(void *userdata, float dt)
+{
+    struct APP_Context *ctx = userdata;
+    ctx->render_time += (double)dt;
+
+    struct APP_MixerEvent event;
+    while (APP_Mixer_PollEvent(ctx->mixer, &event))
+    {
+        if (event.voice == ctx->music_voice)
+        {
+            ctx->music_finished = true;
+        }
+    }
+
+    if (ctx->spatial != NULL)
+    {
+        APP_MoveEmitters(ctx, (float)ctx->render_time, dt);
+    }
+}
+
+static void
+APP_LogRenderStats(const struct APP_RenderStats *stats)
+{
+    // Note(john): Whatever the mixer did besides the stages, taking in
+    // commands and clearing the bus, is the rest.
+    double rest_ms = stats->mix_ms - stats->stream_ms - stats->decode_ms - stats->resample_ms - stats->voice_ms
+        - stats->effects_ms - stats->master_ms;
+    double blocks = SDL_max((double)stats->frames / APP_MIXER_BLOCK_FRAMES, 1.0);
+
+    SDL_Log(
+            "INFO: [render] %.2f s of audio at %d Hz in %.1f ms, %.1fx real time, peak %.1f dBFS, limiter %.1f dB, %u voices at most",
+            stats->audio_ms / 1000.0,
+            stats->freq,
+            stats->render_ms,
+            stats->realtime_factor,
+            20.0f * SDL_log10f(SDL_max(stats->peak, 0.000001f)),
+            -stats->limiter_reduction_db,
+            stats->peak_voices
+    );
+
+    SDL_Log(
+            "INFO: [render] per block: update %.2f us, stream %.2f us, decode %.2f us, resample %.2f us, voices %.2f us, effects %.2f us, master %.2f us, rest %.2f us",
+            stats->update_ms * 1000.0 / blocks,
+            stats->stream_ms * 1000.0 / blocks,
+            stats->decode_ms * 1000.0 / blocks,
+            stats->resample_ms * 1000.0 / blocks,
+            stats->voice_ms * 1000.0 / blocks,
+            stats->effects_ms * 1000.0 / blocks,
+            stats->master_ms * 1000.0 / blocks,
+            SDL_max(rest_ms, 0.0) * 1000.0 / blocks
+    );
+}
+
+static bool
+APP_WriteRender(const struct APP_RenderBuffer *buffer, const char *path)
+{
+    SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+    if (io == NULL)
+    {
+        SDL_Log("ERROR: Could not create %s. %s", path, SDL_GetError());
+        return false;
+    }
+
+    bool ok = APP_Render_WriteWAV(buffer, io);
+    ok &= SDL_CloseIO(io);
+    return ok;
+}
+
+// Render into memory and hold it against the reference WAV. Differences
+// within RENDER_COMPARE_TOLERANCE pass, another length never does.
+static bool
+APP_CompareRender(const struct APP_RenderBuffer *buffer, const char *reference)
+{
+    SDL_IOStream *io = SDL_IOFromFile(reference, "rb");
+    if (io == NULL)
+    {
+        SDL_Log("ERROR: Could not open reference %s. %s", reference, SDL_GetError());
+        return false;
+    }
+
+    struct APP_RenderComparison comparison;
+    bool ok = APP_Render_Compare(buffer, io, &comparison);
+    SDL_CloseIO(io);
+
+    if (!ok)
+    {
+        return false;
+    }
+
+    bool passed = comparison.length_difference == 0 && comparison.peak_difference <= RENDER_COMPARE_TOLERANCE;
+
+    SDL_Log(
+            "%s: [render] %s against %s, %llu frames compared, %lld frames longer reference, peak difference %g, %.1f dB SNR",
+            passed ? "INFO" : "ERROR",
+            comparison.identical ? "identical" : passed ? "within tolerance" : "different",
+            reference,
+            (unsigned long long)comparison.frames,
+            (long long)comparison.length_difference,
+            comparison.peak_difference,
+            comparison.snr_db
+    );
+
+    return passed;
+}
+
+// Render the track and everything playing with it without a device, into a
+// WAV file, into memory to compare with a reference, or both.
+static bool
+APP_RenderOffline(struct APP_Context *ctx, const char *path, const char *reference, double seconds)
+{
+    const int freq = APP_Mixer_GetFrequency(ctx->mixer);
+    struct APP_RenderDesc desc = {
+        (Uint64)(seconds * freq),
+        APP_RenderUpdate,
+        ctx,
+        (Uint32)(freq / RENDER_UPDATE_HZ),
+    };
+
+    struct APP_RenderStats stats;
+    bool ok;
+
+    if (reference == NULL)
+    {
+        SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+        if (io == NULL)
+        {
+            SDL_Log("ERROR: Could not create %s. %s", path, SDL_GetError());
+            return false;
+        }
+
+        ok = APP_Render_ToWAV(ctx->mixer, &desc, io, &stats);
+        ok &= SDL_CloseIO(io);
+        APP_LogRenderStats(&stats);
+        return ok;
+    }
+
+    struct APP_RenderBuffer buffer;
+    ok = APP_Render_ToMemory(ctx->mixer, &desc, &buffer, &stats);
+    APP_LogRenderStats(&stats);
+
+    if (ok && path != NULL)
+    {
+        ok = APP_WriteRender(&buffer, path);
+    }
+
+    ok = ok && APP_CompareRender(&buffer, reference);
+
+    APP_Render_FreeBuffer(&buffer);
+    return ok;
+}
+
 SDL_AppResult
 SDL_AppInit(void **appstate, int argc, char **argv)
 {
-    if (!SDL_Init(SDL_INIT_AUDIO)) 
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    // Usage: main [--file PATH] [--loop] [--seek SECONDS] [--whole-file]
+    //             [--voices N] [--quality NAME] [--stress SECONDS]
+    //             [--audio-driver NAME] [--buffer-frames N] [--adapt-latency]
+    //             [--bank LIST] [--bank-budget MB]
+    //             [--emitters N] [--spatial-voices N]
+    //             [--render PATH] [--render-compare REF] [--render-seconds S]
+    //             [--seed N] [--effects N]
+    //             [--mix-bench] [--resample-bench] [--spatial-bench] [--adpcm-bench]
+    //             [--effects-bench]
+    const char *track = DEFAULT_TRACK;
+    bool loop = false;
+    bool whole_file = false;
+    bool mix_bench = false;
+    bool resample_bench = false;
+    bool spatial_bench = false;
+    bool adpcm_bench = false;
+    bool effects_bench = false;
+    enum APP_ResampleQuality quality = APP_RESAMPLE_MEDIUM;
+    double seek_seconds = 0.0;
+    double stress_seconds = 0.0;
+    Uint32 extra_voices = 0;
+    int buffer_frames = 0;
+    const char *bank_list = NULL;
+    Uint64 bank_budget_mb = DEFAULT_BANK_BUDGET_MB;
+    Uint32 emitter_count = 0;
+    Uint32 spatial_voices = DEFAULT_SPATIAL_VOICES;
+    Uint32 effect_buses = 0;
+    bool adapt_latency = false;
+    const char *render_path = NULL;
+    const char *render_reference = NULL;
+    double render_seconds = DEFAULT_RENDER_SECONDS;
+    Uint64 seed = DEFAULT_SEED;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (SDL_strcmp(argv[i], "--file") == 0 && i + 1 < argc)
+        {
+            track = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--loop") == 0)
+        {
+            loop = true;
+        }
+        else if (SDL_strcmp(argv[i], "--seek") == 0 && i + 1 < argc)
+        {
+            seek_seconds = SDL_atof(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--whole-file") == 0)
+        {
+            whole_file = true;
+        }
+        else if (SDL_strcmp(argv[i], "--voices") == 0 && i + 1 < argc)
+        {
+            extra_voices = (Uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--quality") == 0 && i + 1 < argc)
+        {
+            if (!APP_Resampler_ParseQuality(argv[++i], &quality))
+            {
+                SDL_Log("ERROR: Unknown quality %s, use linear, fast, medium or best.", argv[i]);
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (SDL_strcmp(argv[i], "--stress") == 0 && i + 1 < argc)
+        {
+            stress_seconds = SDL_atof(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--audio-driver") == 0 && i + 1 < argc)
+        {
+            // Has to be set before the audio subsystem starts.
+            SDL_SetHint(SDL_HINT_AUDIO_DRIVER, argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--buffer-frames") == 0 && i + 1 < argc)
+        {
+            buffer_frames = SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--adapt-latency") == 0)
+        {
+            adapt_latency = true;
+        }
+        else if (SDL_strcmp(argv[i], "--bank") == 0 && i + 1 < argc)
+        {
+            bank_list = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--bank-budget") == 0 && i + 1 < argc)
+        {
+            bank_budget_mb = (Uint64)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--emitters") == 0 && i + 1 < argc)
+        {
+            emitter_count = (Uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--spatial-voices") == 0 && i + 1 < argc)
+        {
+            spatial_voices = (Uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--effects") == 0 && i + 1 < argc)
+        {
+            effect_buses = (Uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--render") == 0 && i + 1 < argc)
+        {
+            render_path = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--render-compare") == 0 && i + 1 < argc)
+        {
+            render_reference = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--render-seconds") == 0 && i + 1 < argc)
+        {
+            render_seconds = SDL_atof(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = (Uint64)SDL_strtoull(argv[++i], NULL, 10);
+        }
+        else if (SDL_strcmp(argv[i], "--spatial-bench") == 0)
+        {
+            spatial_bench = true;
+        }
+        else if (SDL_strcmp(argv[i], "--mix-bench") == 0)
+        {
+            mix_bench = true;
+        }
+        else if (SDL_strcmp(argv[i], "--resample-bench") == 0)
+        {
+            resample_bench = true;
+        }
+        else if (SDL_strcmp(argv[i], "--adpcm-bench") == 0)
+        {
+            adpcm_bench = true;
+        }
+        else if (SDL_strcmp(argv[i], "--effects-bench") == 0)
+        {
+            effects_bench = true;
+        }
+    }
+
+    // Note(john): An offline render never touches the audio subsystem, it
+    // works where there is no audio device at all. It plays the track from
+    // memory, a stream's I/O thread can't keep up with rendering faster
+    // than real time and wouldn't come out the same twice.
+    bool render = render_path != NULL || render_reference != NULL;
+    whole_file = whole_file || render;
+
+    if (!SDL_Init(render ? 0 : SDL_INIT_AUDIO))
     {
         SDL_Log("ERROR: Couldn't initialize SDL: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
-    int i, num_devices;
-    SDL_AudioDeviceID *devices = SDL_GetAudioPlaybackDevices(&num_devices);
-    if (!devices) 
+    if (resample_bench)
+    {
+        APP_BenchmarkResampler();
+        return SDL_APP_SUCCESS;
+    }
+
+    if (effects_bench)
+    {
+        APP_BenchmarkEffects();
+        return SDL_APP_SUCCESS;
+    }
+
+    struct APP_Context *ctx = SDL_calloc(1, sizeof(struct APP_Context));
+    if (ctx == NULL)
+    {
+        return SDL_APP_FAILURE;
+    }
+
+    *appstate = ctx;
+
+    char pack_path[256];
+    SDL_snprintf(pack_path, sizeof(pack_path), "%sassets.pack", SDL_GetBasePath());
+    ctx->pack = APP_Pack_Open(pack_path);
+
+    ctx->bank = APP_SoundBank_Create(ctx->pack, bank_budget_mb * 1024 * 1024);
+    if (ctx->bank == NULL)
     {
-        SDL_Log("ERROR: No audio devices found.");
         return SDL_APP_FAILURE;
     }
 
-    for (i = 0; i < num_devices; ++i) 
+    // Note(john): The declared bank loads in the background while the
+    // device opens and the track starts.
+    if (bank_list != NULL)
+    {
+        APP_SoundBank_PreloadList(ctx->bank, bank_list);
+    }
+
+    // The extra voices, the emitters, the stress test and the benchmarks
+    // play the track from memory.
+    bool in_memory = whole_file || extra_voices > 0 || emitter_count > 0 || stress_seconds > 0.0 || mix_bench || spatial_bench || adpcm_bench;
+    if (in_memory)
     {
-        SDL_AudioDeviceID instance_id = devices[i];
-        SDL_Log("INFO: AudioDevice %s", SDL_GetAudioDeviceName(instance_id));
+        ctx->sound = APP_SoundBank_Acquire(ctx->bank, track, true);
+        if (ctx->sound == NULL)
+        {
+            return SDL_APP_FAILURE;
+        }
     }
 
-    SDL_AudioSpec desired = { 0 };
-    desired.freq = 44100;
-    desired.format = SDL_AUDIO_S16;
-    desired.channels = 1;
+    if (mix_bench)
+    {
+        APP_BenchmarkMixer(ctx->sound);
+        return SDL_APP_SUCCESS;
+    }
+
+    if (spatial_bench)
+    {
+        APP_BenchmarkSpatial(ctx->sound);
+        return SDL_APP_SUCCESS;
+    }
 
-    SDL_AudioStream *stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &desired, NULL, NULL);
-    if (!stream) 
+    if (adpcm_bench)
     {
-        SDL_Log("ERROR: Failed to open audio stream. %s", SDL_GetError());
+        APP_BenchmarkADPCM(ctx->sound);
+        return SDL_APP_SUCCESS;
+    }
+
+    int mixer_freq = DEFAULT_MIXER_FREQ;
+
+    if (!render)
+    {
+        int i, num_devices;
+        SDL_AudioDeviceID *devices = SDL_GetAudioPlaybackDevices(&num_devices);
+        if (!devices)
+        {
+            SDL_Log("ERROR: No audio devices found.");
+            return SDL_APP_FAILURE;
+        }
+
+        for (i = 0; i < num_devices; ++i)
+        {
+            SDL_AudioDeviceID instance_id = devices[i];
+            SDL_Log("INFO: AudioDevice %s", SDL_GetAudioDeviceName(instance_id));
+        }
+
         SDL_free(devices);
+
+        // Note(john): The mixer runs at the device rate so only the voices
+        // get resampled, not the whole mix a second time.
+        SDL_AudioSpec device_spec;
+        if (SDL_GetAudioDeviceFormat(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &device_spec, NULL) && device_spec.freq > 0)
+        {
+            mixer_freq = device_spec.freq;
+        }
+    }
+
+    ctx->mixer = APP_Mixer_Create(mixer_freq);
+    if (ctx->mixer == NULL)
+    {
         return SDL_APP_FAILURE;
     }
 
-    SDL_AudioDeviceID device = SDL_GetAudioStreamDevice(stream);
-    if (!SDL_ResumeAudioDevice(device)) 
+    if (!render)
+    {
+        ctx->latency = APP_Latency_Create(ctx->mixer, SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, buffer_frames, adapt_latency);
+        if (ctx->latency == NULL)
+        {
+            return SDL_APP_FAILURE;
+        }
+    }
+
+    APP_Mixer_SetQuality(ctx->mixer, quality);
+
+    if (effect_buses > 0 && !APP_CreateEffectBuses(ctx, effect_buses))
     {
-        SDL_Log("ERROR: Failed resume audio device. %s", SDL_GetError());
-        SDL_free(devices);
         return SDL_APP_FAILURE;
     }
 
-    SDL_AudioSpec wav_spec;
-    Uint8 *wav_buffer;
-    Uint32 wav_length;
-    if (!SDL_LoadWAV("audio/default.wav", &wav_spec, &wav_buffer, &wav_length)) {
-        SDL_Log("ERROR: Could not load WAV file: %s\n", SDL_GetError());
-        SDL_free(wav_buffer);
-        SDL_free(devices);
+    struct APP_VoiceParams music_params = { 1.0f, 0.0f, 1.0f, loop };
+    SDL_AudioSpec spec;
+
+    if (whole_file)
+    {
+        spec.freq = ctx->sound->freq;
+        spec.channels = (int)ctx->sound->channels;
+        Uint64 start_frame = (Uint64)(seek_seconds * ctx->sound->freq);
+        ctx->music_voice = APP_Mixer_PlayFrom(ctx->mixer, ctx->sound, &music_params, start_frame);
+    }
+    else
+    {
+        ctx->music = APP_WavStream_Open(APP_OpenTrack(ctx, track), loop);
+        if (ctx->music == NULL)
+        {
+            SDL_Log("ERROR: Could not stream WAV file: %s", track);
+            return SDL_APP_FAILURE;
+        }
+
+        spec = *APP_WavStream_GetSpec(ctx->music);
+
+        if (seek_seconds > 0.0)
+        {
+            APP_WavStream_Seek(ctx->music, (Uint64)(seek_seconds * spec.freq));
+        }
+
+        // Note(john): The samples are pulled by the mixer in small pieces
+        // instead of being queued up front.
+        ctx->music_voice = APP_Mixer_PlayStream(ctx->mixer, ctx->music, &music_params);
+    }
+
+    if (ctx->music_voice == 0)
+    {
+        SDL_Log("ERROR: No voice for the track.");
         return SDL_APP_FAILURE;
     }
 
-    if (!SDL_PutAudioStreamData(stream, wav_buffer, wav_length)) 
+    if (ctx->effect_buses > 1)
+    {
+        APP_Mixer_SetSend(ctx->mixer, ctx->music_voice, ctx->effect_buses - 2, MUSIC_ECHO_SEND);
+    }
+
+    if (ctx->effect_buses > 0)
+    {
+        APP_Mixer_SetSend(ctx->mixer, ctx->music_voice, ctx->effect_buses - 1, MUSIC_REVERB_SEND);
+    }
+
+    // Note(john): Seeded, so a render with the same seed places every voice
+    // and emitter the same and comes out the same on every run.
+    SDL_srand(seed);
+
+    APP_PlayExtraVoices(ctx, extra_voices);
+
+    if (emitter_count > 0 && !APP_CreateEmitters(ctx, emitter_count, spatial_voices))
     {
-        SDL_Log("ERROR: Failed to put audio stream data. %s", SDL_GetError());
-        SDL_free(wav_buffer);
-        SDL_free(devices);
         return SDL_APP_FAILURE;
-    } 
+    }
+
+    // Note(john): The stress test runs on the wall clock, it only plays
+    // against a device.
+    if (render)
+    {
+        SDL_Log(
+                "INFO: Rendering %s, %d Hz, %d channels, at %d Hz (%s resampling)",
+                track,
+                ctx->sound->freq,
+                (int)ctx->sound->channels,
+                mixer_freq,
+                APP_Resampler_GetQualityName(quality)
+        );
 
-    SDL_free(wav_buffer);
-    SDL_free(devices);
+        bool rendered = APP_RenderOffline(ctx, render_path, render_reference, render_seconds);
+        return rendered ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    if (stress_seconds > 0.0)
+    {
+        ctx->stress = APP_Stress_Create(ctx->mixer, ctx->sound, stress_seconds);
+        if (ctx->stress == NULL)
+        {
+            return SDL_APP_FAILURE;
+        }
+    }
+
+    if (!SDL_ResumeAudioStreamDevice(APP_Mixer_GetStream(ctx->mixer)))
+    {
+        SDL_Log("ERROR: Failed resume audio device. %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
+    double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+        / (double)SDL_GetPerformanceFrequency();
+
+    SDL_Log(
+            "INFO: %s %s, %d Hz, %d channels, mixed at %d Hz (%s resampling), playing after %.2f ms",
+            whole_file ? "Loaded" : "Streaming",
+            track,
+            spec.freq,
+            spec.channels,
+            mixer_freq,
+            APP_Resampler_GetQualityName(quality),
+            ms
+    );
+
+    ctx->last_stats = SDL_GetTicks();
     return SDL_APP_CONTINUE;
 }
 
@@ -88,12 +931,80 @@ SDL_AppEvent(void *appstate, SDL_Event *event)
 SDL_AppResult
 SDL_AppIterate(void *appstate)
 {
+    struct APP_Context *ctx = appstate;
+
+    struct APP_MixerEvent event;
+    while (APP_Mixer_PollEvent(ctx->mixer, &event))
+    {
+        if (event.voice == ctx->music_voice)
+        {
+            ctx->music_finished = true;
+        }
+        else if (ctx->stress != NULL)
+        {
+            APP_Stress_OnEvent(ctx->stress, &event);
+        }
+    }
+
+    if (ctx->spatial != NULL)
+    {
+        APP_UpdateEmitters(ctx);
+    }
+
+    if (ctx->stress != NULL && !APP_Stress_Update(ctx->stress))
+    {
+        APP_Stress_Destroy(ctx->stress);
+        ctx->stress = NULL;
+    }
+
+    Uint64 now = SDL_GetTicks();
+    if (now - ctx->last_stats >= STATS_LOG_INTERVAL_MS)
+    {
+        ctx->last_stats = now;
+
+        struct APP_MixerStats mixing;
+        APP_Mixer_GetStats(ctx->mixer, &mixing);
+
+        if (!APP_Latency_Update(ctx->latency, &mixing))
+        {
+            return SDL_APP_FAILURE;
+        }
+
+        APP_LogMusicStats(ctx, &mixing);
+    }
+
+    // Done once the track played out and the device took the last samples.
+    bool finished = ctx->music_finished && ctx->stress == NULL;
+    if (finished && SDL_GetAudioStreamQueued(APP_Mixer_GetStream(ctx->mixer)) == 0)
+    {
+        return SDL_APP_SUCCESS;
+    }
+
+    // There is no window to wait on, don't spin.
+    SDL_Delay(10);
     return SDL_APP_CONTINUE;
 }
 
 void
 SDL_AppQuit(void *appstate, SDL_AppResult result)
 {
-}
-
+    struct APP_Context *ctx = appstate;
+    if (ctx == NULL)
+    {
+        return;
+    }
 
+    // Note(john): Destroying the mixer stops the callback before the
+    // sounds it reads from go away.
+    APP_Stress_Destroy(ctx->stress);
+    APP_Spatial_Destroy(ctx->spatial);
+    SDL_free(ctx->orbits);
+    SDL_free(ctx->emitters);
+    APP_Mixer_Destroy(ctx->mixer);
+    APP_Latency_Destroy(ctx->latency);
+    APP_WavStream_Close(ctx->music);
+    APP_SoundBank_Release(ctx->bank, ctx->sound);
+    APP_SoundBank_Destroy(ctx->bank);
+    APP_Pack_Close(ctx->pack);
+    SDL_free(ctx);
+}
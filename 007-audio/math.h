@@ -0,0 +1,61 @@
+#ifndef MATH_H
+#define MATH_H
+
+#include <SDL3/SDL_stdinc.h>
+
+struct APP_Vector3 {
+    float x, y, z;
+};
+
+struct APP_Vector4 {
+    float x, y, z, w;
+};
+
+// Note(john): A plane is stored as (normal.xyz, distance) so a point p lies
+// in front of it when dot(normal, p) + distance >= 0.
+struct APP_Frustum {
+    struct APP_Vector4 planes[6];
+};
+
+struct APP_Matrix4x4 {
+    float m11, m12, m13, m14;
+    float m21, m22, m23, m24;
+    float m31, m32, m33, m34;
+    float m41, m42, m43, m44;
+};
+
+struct APP_PositionColorVertex {
+    float x, y, z;
+    Uint8 f, g, b, a;
+};
+
+float APP_Vector3_Dot(struct APP_Vector3 vec_a, struct APP_Vector3 vec_b);
+struct APP_Vector3 APP_VECTOR3_Normalize(struct APP_Vector3 v3);
+struct APP_Vector3 APP_Vector3_Cross(struct APP_Vector3 vec_a, struct APP_Vector3 vec_b); 
+
+struct APP_Matrix4x4 APP_Matrix4x4_CreatePerspectiveFieldOfView(
+        float field_of_view, 
+        float aspect_ratio, 
+        float near_plane_distance,
+        float far_plane_distance
+);
+
+struct APP_Matrix4x4 APP_Matrix4x4_CreateLookAt(
+        struct APP_Vector3 camera_pos,
+        struct APP_Vector3 camera_target,
+        struct APP_Vector3 camera_up_vector
+);
+
+struct APP_Matrix4x4 APP_Matrix4x4_Mutliply(
+        struct APP_Matrix4x4 m_a,
+        struct APP_Matrix4x4 m_b
+);
+
+struct APP_Matrix4x4 APP_Matrix4x4_CreateTranslation(struct APP_Vector3 position);
+struct APP_Matrix4x4 APP_Matrix4x4_CreateScale(float scale);
+struct APP_Matrix4x4 APP_Matrix4x4_CreateRotationY(float radians);
+
+struct APP_Frustum APP_Frustum_FromMatrix(struct APP_Matrix4x4 view_proj);
+bool APP_Frustum_ContainsSphere(const struct APP_Frustum *frustum, struct APP_Vector3 center, float radius);
+
+#endif
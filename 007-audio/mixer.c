@@ -0,0 +1,1972 @@
+#include "mixer.h"
+#include "ring.h"
+
+#if defined(SDL_SSE_INTRINSICS)
+#define APP_MIXER_SSE
+#endif
+#if defined(SDL_NEON_INTRINSICS)
+#define APP_MIXER_NEON
+#endif
+
+// Positions are 32.32 fixed point frames.
+#define APP_MIXER_FRACTION_ONE ((Uint64)1 << 32)
+#define APP_MIXER_FRACTION_MASK (APP_MIXER_FRACTION_ONE - 1)
+#define APP_MIXER_FRACTION_SCALE (1.0f / 4294967296.0f)
+
+#define APP_MIXER_MIN_PITCH 0.125f
+// Frames a stream source keeps before the position for the filter, and room
+// for a block at the highest step with the frames the filter reads around it.
+#define APP_MIXER_STREAM_HISTORY (APP_RESAMPLER_MAX_TAPS / 2 - 1)
+#define APP_MIXER_STREAM_FRAMES (APP_MIXER_BLOCK_FRAMES * APP_RESAMPLER_MAX_STEP + APP_RESAMPLER_MAX_TAPS * 2)
+#define APP_MIXER_STREAM_READ_BYTES 4096
+// Effects replaced on the audio thread and not yet destroyed, one for every
+// slot of every bus at most.
+#define APP_MIXER_MAX_RETIRED (APP_EFFECTS_MAX_BUSES * APP_EFFECTS_MAX_CHAIN)
+
+SDL_COMPILE_TIME_ASSERT(effects_block, APP_EFFECTS_BLOCK_FRAMES == APP_MIXER_BLOCK_FRAMES);
+
+enum APP_VoiceState {
+    APP_VOICE_FREE,
+    APP_VOICE_PLAYING,
+    // Ramps to silence over the next block, then goes back to the pool.
+    APP_VOICE_STOPPING,
+};
+
+// Converted samples of a streamed WAV waiting to be resampled. The voice
+// position counts from the first of them.
+struct APP_StreamSource {
+    struct APP_WavStream *stream;
+    float samples[2][APP_MIXER_STREAM_FRAMES];
+    Uint32 channels;
+    Uint32 frame_count;
+    // The stream ended and silence was added after its last frame.
+    bool drained;
+};
+
+// What a voice sends into an effect bus, -1 for an unused send.
+struct APP_VoiceSend {
+    int bus;
+    float level;
+    // What the last block ended on.
+    float current;
+};
+
+struct APP_Voice {
+    enum APP_VoiceState state;
+    Uint16 generation;
+    bool loop;
+
+    const struct APP_Sound *sound;
+    struct APP_StreamSource *source;
+
+    // IMA ADPCM sounds only. The frames before the position the filter
+    // still reads and the ones after it decoded for the last block, the
+    // position counts from the first of them.
+    struct APP_ADPCMDecoder decoder;
+    float carry[2][APP_RESAMPLER_MAX_TAPS];
+    Uint32 carry_frames;
+    // The decoder ran past the end of a sound that doesn't loop, the end is
+    // this many frames in.
+    bool decoded_end;
+    Uint32 end_frame;
+
+    Uint64 position;
+    Uint64 step;
+
+    float gain;
+    float pan;
+    float pitch;
+    // What the last block ended on, the next one ramps from here.
+    float gain_l;
+    float gain_r;
+
+    struct APP_VoiceSend sends[APP_MIXER_MAX_SENDS];
+};
+
+enum APP_MixerCommandType {
+    APP_MIXER_COMMAND_PLAY,
+    APP_MIXER_COMMAND_STOP,
+    APP_MIXER_COMMAND_STOP_ALL,
+    APP_MIXER_COMMAND_SET_PARAMS,
+    APP_MIXER_COMMAND_SET_QUALITY,
+    APP_MIXER_COMMAND_SET_MASTER_GAIN,
+    APP_MIXER_COMMAND_SET_SEND,
+    APP_MIXER_COMMAND_SET_EFFECT,
+    APP_MIXER_COMMAND_SET_BUS_OUTPUT,
+};
+
+// Game thread to audio thread.
+struct APP_MixerCommand {
+    enum APP_MixerCommandType type;
+    APP_VoiceID voice;
+    // Play either a sound or a stream through one of the stream sources.
+    const struct APP_Sound *sound;
+    struct APP_WavStream *stream;
+    int source;
+    Uint64 start_frame;
+    struct APP_VoiceParams params;
+    enum APP_ResampleQuality quality;
+    float gain;
+    // Effect buses. Either a new effect for the slot, NULL to clear it, or
+    // new parameters for the one in it.
+    Uint32 bus;
+    Uint32 slot;
+    int output;
+    bool replace_effect;
+    struct APP_Effect *effect;
+    struct APP_EffectDesc effect_desc;
+};
+
+enum APP_MixerMessageType {
+    APP_MIXER_MESSAGE_FINISHED,
+    APP_MIXER_MESSAGE_STATS,
+    // An effect that was replaced, the game thread destroys it.
+    APP_MIXER_MESSAGE_RETIRED_EFFECT,
+};
+
+// Audio thread to game thread.
+struct APP_MixerMessage {
+    enum APP_MixerMessageType type;
+    APP_VoiceID voice;
+    struct APP_Effect *effect;
+    struct APP_MixerStats stats;
+};
+
+// Game thread side of a voice.
+struct APP_VoiceSlot {
+    Uint16 generation;
+    bool playing;
+    // The stream source it holds, -1 for none.
+    int source;
+};
+
+// dst_l += src_l * gain_l, dst_r += src_r * gain_r, the gains change by their
+// step every frame. src_r is src_l for a mono source.
+typedef void (*APP_MixFunc)(
+        float *dst_l,
+        float *dst_r,
+        const float *src_l,
+        const float *src_r,
+        Uint32 count,
+        float gain_l,
+        float step_l,
+        float gain_r,
+        float step_r
+);
+
+struct APP_Mixer {
+    int freq;
+    SDL_AudioStream *stream;
+
+    APP_MixFunc mix;
+    struct APP_Resampler *resampler;
+    enum APP_ResampleQuality quality;
+
+    struct APP_Ring *commands;
+    struct APP_Ring *messages;
+
+    // Game thread only. A voice goes back to the pool once its finished
+    // message came back, its generation changes so old IDs stop matching.
+    struct APP_VoiceSlot slots[APP_MIXER_MAX_VOICES];
+    Uint16 free_slots[APP_MIXER_MAX_VOICES];
+    Uint32 free_slot_count;
+    bool sources_used[APP_MIXER_MAX_STREAMS];
+    APP_VoiceID finished[APP_MIXER_MAX_VOICES];
+    Uint32 finished_first;
+    Uint32 finished_count;
+    struct APP_MixerStats game_stats;
+    // The effects as the game thread last posted them, and how many it
+    // replaced that didn't come back yet.
+    struct APP_Effect *bus_effects[APP_EFFECTS_MAX_BUSES][APP_EFFECTS_MAX_CHAIN];
+    Uint32 retiring_effects;
+
+    // Audio thread only from here on.
+    struct APP_Voice voices[APP_MIXER_MAX_VOICES];
+    Uint16 active_voices[APP_MIXER_MAX_VOICES];
+    Uint32 active_count;
+
+    struct APP_StreamSource sources[APP_MIXER_MAX_STREAMS];
+    Uint8 stream_bytes[APP_MIXER_STREAM_READ_BYTES];
+
+    float bus[2][APP_MIXER_BLOCK_FRAMES];
+    float scratch[2][APP_MIXER_BLOCK_FRAMES];
+    // One block of an IMA ADPCM voice, decoded.
+    float decoded[2][APP_MIXER_STREAM_FRAMES];
+    struct APP_Effects *effects;
+
+    float master_gain;
+    float master_current;
+    float limiter_gain;
+    float limiter_release;
+
+    struct APP_MixerStats stats;
+    // Performance counter ticks per stage, voice_ticks holds the whole voice
+    // loop with the stream, decode and resample ticks in it.
+    Uint64 stream_ticks;
+    Uint64 decode_ticks;
+    Uint64 resample_ticks;
+    Uint64 voice_ticks;
+    Uint64 effects_ticks;
+    Uint64 master_ticks;
+    float limiter_min_gain;
+    Uint32 blocks_since_stats;
+    // When the last device callback started, 0 before the first.
+    Uint64 last_callback_ns;
+};
+
+// ============================================================================
+// Kernels
+// ============================================================================
+
+static void
+APP_Mix_Scalar(
+        float *dst_l,
+        float *dst_r,
+        const float *src_l,
+        const float *src_r,
+        Uint32 count,
+        float gain_l,
+        float step_l,
+        float gain_r,
+        float step_r
+)
+{
+    for (Uint32 i = 0; i < count; ++i)
+    {
+        dst_l[i] += src_l[i] * (gain_l + step_l * (float)i);
+        dst_r[i] += src_r[i] * (gain_r + step_r * (float)i);
+    }
+}
+
+#ifdef APP_MIXER_SSE
+SDL_TARGETING("sse") static void
+APP_Mix_SSE(
+        float *dst_l,
+        float *dst_r,
+        const float *src_l,
+        const float *src_r,
+        Uint32 count,
+        float gain_l,
+        float step_l,
+        float gain_r,
+        float step_r
+)
+{
+    const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    __m128 gl = _mm_add_ps(_mm_set1_ps(gain_l), _mm_mul_ps(_mm_set1_ps(step_l), lanes));
+    __m128 gr = _mm_add_ps(_mm_set1_ps(gain_r), _mm_mul_ps(_mm_set1_ps(step_r), lanes));
+    const __m128 gl_step = _mm_set1_ps(step_l * 4.0f);
+    const __m128 gr_step = _mm_set1_ps(step_r * 4.0f);
+
+    Uint32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 l = _mm_loadu_ps(dst_l + i);
+        __m128 r = _mm_loadu_ps(dst_r + i);
+        l = _mm_add_ps(l, _mm_mul_ps(_mm_loadu_ps(src_l + i), gl));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(src_r + i), gr));
+        _mm_storeu_ps(dst_l + i, l);
+        _mm_storeu_ps(dst_r + i, r);
+        gl = _mm_add_ps(gl, gl_step);
+        gr = _mm_add_ps(gr, gr_step);
+    }
+
+    APP_Mix_Scalar(
+            dst_l + i,
+            dst_r + i,
+            src_l + i,
+            src_r + i,
+            count - i,
+            gain_l + step_l * (float)i,
+            step_l,
+            gain_r + step_r * (float)i,
+            step_r
+    );
+}
+#endif
+
+#ifdef APP_MIXER_NEON
+static void
+APP_Mix_NEON(
+        float *dst_l,
+        float *dst_r,
+        const float *src_l,
+        const float *src_r,
+        Uint32 count,
+        float gain_l,
+        float step_l,
+        float gain_r,
+        float step_r
+)
+{
+    const float lane_values[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    const float32x4_t lanes = vld1q_f32(lane_values);
+    float32x4_t gl = vmlaq_f32(vdupq_n_f32(gain_l), vdupq_n_f32(step_l), lanes);
+    float32x4_t gr = vmlaq_f32(vdupq_n_f32(gain_r), vdupq_n_f32(step_r), lanes);
+    const float32x4_t gl_step = vdupq_n_f32(step_l * 4.0f);
+    const float32x4_t gr_step = vdupq_n_f32(step_r * 4.0f);
+
+    Uint32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        vst1q_f32(dst_l + i, vmlaq_f32(vld1q_f32(dst_l + i), vld1q_f32(src_l + i), gl));
+        vst1q_f32(dst_r + i, vmlaq_f32(vld1q_f32(dst_r + i), vld1q_f32(src_r + i), gr));
+        gl = vaddq_f32(gl, gl_step);
+        gr = vaddq_f32(gr, gr_step);
+    }
+
+    APP_Mix_Scalar(
+            dst_l + i,
+            dst_r + i,
+            src_l + i,
+            src_r + i,
+            count - i,
+            gain_l + step_l * (float)i,
+            step_l,
+            gain_r + step_r * (float)i,
+            step_r
+    );
+}
+#endif
+
+// ============================================================================
+// Sounds
+// ============================================================================
+
+bool
+APP_Sound_LoadWAV(SDL_IOStream *io, struct APP_Sound *out_sound)
+{
+    SDL_zerop(out_sound);
+
+    SDL_AudioSpec spec;
+    Uint8 *wav = NULL;
+    Uint32 wav_length = 0;
+
+    if (io != NULL && APP_ADPCM_IsWAV(io))
+    {
+        bool loaded = APP_ADPCM_LoadWAV(io, &out_sound->adpcm);
+        SDL_CloseIO(io);
+
+        out_sound->channels = out_sound->adpcm.channels;
+        out_sound->frame_count = out_sound->adpcm.frame_count;
+        out_sound->freq = out_sound->adpcm.freq;
+        return loaded;
+    }
+
+    if (io == NULL || !SDL_LoadWAV_IO(io, true, &spec, &wav, &wav_length))
+    {
+        SDL_Log("ERROR: Could not load WAV file: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_AudioSpec float_spec = { SDL_AUDIO_F32, SDL_min(spec.channels, 2), spec.freq };
+    Uint8 *converted = NULL;
+    int converted_length = 0;
+
+    bool ok = SDL_ConvertAudioSamples(&spec, wav, (int)wav_length, &float_spec, &converted, &converted_length);
+    SDL_free(wav);
+
+    if (!ok)
+    {
+        SDL_Log("ERROR: Could not convert WAV samples: %s", SDL_GetError());
+        return false;
+    }
+
+    Uint32 channels = (Uint32)float_spec.channels;
+    Uint32 frame_count = (Uint32)converted_length / (Uint32)(sizeof(float) * channels);
+    if (frame_count == 0)
+    {
+        SDL_Log("ERROR: WAV file has no samples.");
+        SDL_free(converted);
+        return false;
+    }
+
+    float *samples = SDL_malloc(sizeof(float) * channels * frame_count);
+    if (samples == NULL)
+    {
+        SDL_free(converted);
+        return false;
+    }
+
+    const float *interleaved = (const float *)converted;
+    for (Uint32 c = 0; c < channels; ++c)
+    {
+        float *dst = samples + (size_t)c * frame_count;
+        for (Uint32 i = 0; i < frame_count; ++i)
+        {
+            dst[i] = interleaved[i * channels + c];
+        }
+
+        out_sound->samples[c] = dst;
+    }
+
+    SDL_free(converted);
+
+    out_sound->channels = channels;
+    out_sound->frame_count = frame_count;
+    out_sound->freq = spec.freq;
+    return true;
+}
+
+void
+APP_Sound_Free(struct APP_Sound *sound)
+{
+    if (sound == NULL)
+    {
+        return;
+    }
+
+    // Both channels share one allocation.
+    SDL_free(sound->samples[0]);
+    APP_ADPCM_Free(&sound->adpcm);
+    SDL_zerop(sound);
+}
+
+Uint64
+APP_Sound_GetSize(const struct APP_Sound *sound)
+{
+    if (sound->adpcm.blocks != NULL)
+    {
+        return APP_ADPCM_GetSize(&sound->adpcm);
+    }
+
+    return (Uint64)sound->frame_count * sound->channels * sizeof(float);
+}
+
+// ============================================================================
+// Voices
+// ============================================================================
+
+static APP_VoiceID
+APP_Mixer_MakeVoiceID(Uint32 index, Uint16 generation)
+{
+    return ((Uint32)generation << 16) | (index + 1);
+}
+
+// The pool index of a voice ID, APP_MIXER_MAX_VOICES when it can't be one.
+static Uint32
+APP_Mixer_VoiceIndex(APP_VoiceID id)
+{
+    Uint32 index = (id & 0xFFFF) - 1;
+    return id == 0 || index >= APP_MIXER_MAX_VOICES ? APP_MIXER_MAX_VOICES : index;
+}
+
+// Audio thread. The voice while it plays, NULL once it finished.
+static struct APP_Voice *
+APP_Mixer_FindVoice(struct APP_Mixer *mixer, APP_VoiceID id)
+{
+    Uint32 index = APP_Mixer_VoiceIndex(id);
+    if (index == APP_MIXER_MAX_VOICES)
+    {
+        return NULL;
+    }
+
+    struct APP_Voice *voice = &mixer->voices[index];
+    if (voice->state == APP_VOICE_FREE || voice->generation != (Uint16)(id >> 16))
+    {
+        return NULL;
+    }
+
+    return voice;
+}
+
+static void
+APP_Mixer_SetStep(struct APP_Voice *voice, int source_freq, int mixer_freq)
+{
+    double step = (double)voice->pitch * (double)source_freq / (double)mixer_freq;
+    step = SDL_clamp(step, 1.0 / 256.0, (double)APP_RESAMPLER_MAX_STEP);
+    voice->step = (Uint64)(step * (double)APP_MIXER_FRACTION_ONE);
+}
+
+static void
+APP_Mixer_ApplyParams(struct APP_Mixer *mixer, struct APP_Voice *voice, const struct APP_VoiceParams *params)
+{
+    voice->gain = SDL_max(params->gain, 0.0f);
+    voice->pan = SDL_clamp(params->pan, -1.0f, 1.0f);
+    voice->pitch = SDL_clamp(params->pitch, APP_MIXER_MIN_PITCH, APP_MIXER_MAX_PITCH);
+    voice->loop = params->loop;
+
+    int source_freq = voice->sound != NULL
+        ? voice->sound->freq
+        : APP_WavStream_GetSpec(voice->source->stream)->freq;
+    APP_Mixer_SetStep(voice, source_freq, mixer->freq);
+}
+
+// Audio thread. The game thread picked the voice and the source, they are
+// free on this side by the time the command arrives.
+static void
+APP_Mixer_StartVoice(struct APP_Mixer *mixer, const struct APP_MixerCommand *command)
+{
+    Uint32 index = APP_Mixer_VoiceIndex(command->voice);
+    struct APP_Voice *voice = &mixer->voices[index];
+
+    voice->state = APP_VOICE_PLAYING;
+    voice->generation = (Uint16)(command->voice >> 16);
+    voice->sound = command->sound;
+    voice->source = NULL;
+    voice->position = 0;
+
+    if (command->sound != NULL)
+    {
+        // Past the end a voice that doesn't loop finishes in its first block.
+        Uint64 frames = command->sound->frame_count;
+        Uint64 start = command->params.loop ? command->start_frame % frames : SDL_min(command->start_frame, frames);
+        voice->position = start << 32;
+
+        if (command->sound->adpcm.blocks != NULL)
+        {
+            // Start with silence for the filter to read before the first
+            // frame, like a stream.
+            APP_ADPCM_Seek(&command->sound->adpcm, &voice->decoder, (Uint32)start);
+            SDL_memset(voice->carry, 0, sizeof(voice->carry));
+            voice->carry_frames = APP_MIXER_STREAM_HISTORY;
+            voice->decoded_end = false;
+            voice->position = (Uint64)APP_MIXER_STREAM_HISTORY << 32;
+        }
+    }
+
+    // Start silent and ramp in over the first block.
+    voice->gain_l = 0.0f;
+    voice->gain_r = 0.0f;
+
+    for (Uint32 s = 0; s < APP_MIXER_MAX_SENDS; ++s)
+    {
+        voice->sends[s].bus = -1;
+    }
+
+    if (command->stream != NULL)
+    {
+        struct APP_StreamSource *source = &mixer->sources[command->source];
+        source->stream = command->stream;
+        source->channels = SDL_min((Uint32)APP_WavStream_GetSpec(command->stream)->channels, 2u);
+        source->drained = false;
+
+        // Start with silence for the filter to read before the first frame.
+        source->frame_count = APP_MIXER_STREAM_HISTORY;
+        SDL_memset(source->samples, 0, sizeof(source->samples));
+
+        voice->source = source;
+        voice->position = (Uint64)APP_MIXER_STREAM_HISTORY << 32;
+    }
+
+    APP_Mixer_ApplyParams(mixer, voice, &command->params);
+
+    mixer->active_voices[mixer->active_count++] = (Uint16)index;
+    mixer->stats.peak_voices = SDL_max(mixer->stats.peak_voices, mixer->active_count);
+}
+
+// Audio thread. Take the voice at this slot of the active list out and tell
+// the game thread.
+static void
+APP_Mixer_FinishVoice(struct APP_Mixer *mixer, Uint32 active_index)
+{
+    Uint16 index = mixer->active_voices[active_index];
+    struct APP_Voice *voice = &mixer->voices[index];
+
+    struct APP_MixerMessage message;
+    SDL_zero(message);
+    message.type = APP_MIXER_MESSAGE_FINISHED;
+    message.voice = APP_Mixer_MakeVoiceID(index, voice->generation);
+
+    // Note(john): The ring holds a finished message for every voice plus the
+    // stats, this never fails.
+    APP_Ring_Push(mixer->messages, &message);
+
+    voice->state = APP_VOICE_FREE;
+    voice->sound = NULL;
+    voice->source = NULL;
+
+    mixer->active_voices[active_index] = mixer->active_voices[--mixer->active_count];
+}
+
+// Audio thread. The send to this bus if the voice has one, a free send if
+// it doesn't, ignored when the voice sends into as many buses as it can.
+static void
+APP_Mixer_SetVoiceSend(struct APP_Voice *voice, int bus, float level)
+{
+    struct APP_VoiceSend *free_send = NULL;
+    for (Uint32 s = 0; s < APP_MIXER_MAX_SENDS; ++s)
+    {
+        struct APP_VoiceSend *send = &voice->sends[s];
+        if (send->bus == bus)
+        {
+            send->level = level;
+            return;
+        }
+
+        if (send->bus < 0 && free_send == NULL)
+        {
+            free_send = send;
+        }
+    }
+
+    if (free_send != NULL && level > 0.0f)
+    {
+        // Ramps in from silence like a new voice.
+        free_send->bus = bus;
+        free_send->level = level;
+        free_send->current = 0.0f;
+    }
+}
+
+// Audio thread. Swaps the effect in, the one it replaces goes back to the
+// game thread.
+static void
+APP_Mixer_ReplaceEffect(struct APP_Mixer *mixer, const struct APP_MixerCommand *command)
+{
+    struct APP_Effect *old = APP_Effects_Swap(mixer->effects, command->bus, command->slot, command->effect);
+    if (old == NULL)
+    {
+        return;
+    }
+
+    struct APP_MixerMessage message;
+    SDL_zero(message);
+    message.type = APP_MIXER_MESSAGE_RETIRED_EFFECT;
+    message.effect = old;
+
+    // Note(john): The game thread counts the effects it replaced and keeps
+    // them under APP_MIXER_MAX_RETIRED, the ring has room for all of them.
+    APP_Ring_Push(mixer->messages, &message);
+}
+
+// Audio thread, at the start of every block.
+static void
+APP_Mixer_ApplyCommands(struct APP_Mixer *mixer)
+{
+    struct APP_MixerCommand command;
+    while (APP_Ring_Pop(mixer->commands, &command))
+    {
+        struct APP_Voice *voice = NULL;
+
+        switch (command.type)
+        {
+            case APP_MIXER_COMMAND_PLAY:
+                APP_Mixer_StartVoice(mixer, &command);
+                break;
+            case APP_MIXER_COMMAND_STOP:
+                voice = APP_Mixer_FindVoice(mixer, command.voice);
+                if (voice != NULL)
+                {
+                    voice->state = APP_VOICE_STOPPING;
+                }
+                break;
+            case APP_MIXER_COMMAND_STOP_ALL:
+                for (Uint32 i = 0; i < mixer->active_count; ++i)
+                {
+                    mixer->voices[mixer->active_voices[i]].state = APP_VOICE_STOPPING;
+                }
+                break;
+            case APP_MIXER_COMMAND_SET_PARAMS:
+                voice = APP_Mixer_FindVoice(mixer, command.voice);
+                if (voice != NULL && voice->state == APP_VOICE_PLAYING)
+                {
+                    APP_Mixer_ApplyParams(mixer, voice, &command.params);
+                }
+                break;
+            case APP_MIXER_COMMAND_SET_QUALITY:
+                mixer->quality = command.quality;
+                break;
+            case APP_MIXER_COMMAND_SET_MASTER_GAIN:
+                mixer->master_gain = command.gain;
+                break;
+            case APP_MIXER_COMMAND_SET_SEND:
+                voice = APP_Mixer_FindVoice(mixer, command.voice);
+                if (voice != NULL)
+                {
+                    APP_Mixer_SetVoiceSend(voice, (int)command.bus, command.gain);
+                }
+                break;
+            case APP_MIXER_COMMAND_SET_EFFECT:
+                if (command.replace_effect)
+                {
+                    APP_Mixer_ReplaceEffect(mixer, &command);
+                }
+                else
+                {
+                    APP_Effects_SetParams(mixer->effects, command.bus, command.slot, &command.effect_desc);
+                }
+                break;
+            case APP_MIXER_COMMAND_SET_BUS_OUTPUT:
+                APP_Effects_SetOutput(mixer->effects, command.bus, command.output, command.gain);
+                break;
+        }
+    }
+}
+
+// Audio thread. Every APP_MIXER_STATS_BLOCKS blocks, when the ring has room
+// for it next to a finished message for every voice and every effect that
+// can be replaced.
+static void
+APP_Mixer_PostStats(struct APP_Mixer *mixer)
+{
+    Uint32 capacity = APP_Ring_GetCapacity(mixer->messages);
+    if (mixer->blocks_since_stats < APP_MIXER_STATS_BLOCKS
+        || APP_Ring_GetCount(mixer->messages) + APP_MIXER_MAX_VOICES + APP_MIXER_MAX_RETIRED >= capacity)
+    {
+        return;
+    }
+
+    struct APP_MixerMessage message;
+    SDL_zero(message);
+    message.type = APP_MIXER_MESSAGE_STATS;
+    message.stats = mixer->stats;
+    message.stats.active_voices = mixer->active_count;
+    message.stats.limiter_reduction_db = -20.0f * SDL_log10f(mixer->limiter_min_gain);
+
+    const double tick_ms = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    Uint64 voice_ticks = mixer->voice_ticks - mixer->stream_ticks - mixer->decode_ticks - mixer->resample_ticks;
+    message.stats.stream_ms = (double)mixer->stream_ticks * tick_ms;
+    message.stats.decode_ms = (double)mixer->decode_ticks * tick_ms;
+    message.stats.resample_ms = (double)mixer->resample_ticks * tick_ms;
+    message.stats.voice_ms = (double)voice_ticks * tick_ms;
+    message.stats.effects_ms = (double)mixer->effects_ticks * tick_ms;
+    message.stats.master_ms = (double)mixer->master_ticks * tick_ms;
+    APP_Effects_GetStats(mixer->effects, &message.stats.effects);
+    APP_Ring_Push(mixer->messages, &message);
+
+    mixer->stats.peak_voices = mixer->active_count;
+    mixer->stats.max_queued_bytes = 0;
+    mixer->stats.max_callback_ms = 0.0f;
+    mixer->stats.max_interval_ms = 0.0f;
+    mixer->limiter_min_gain = mixer->limiter_gain;
+    mixer->blocks_since_stats = 0;
+}
+
+// Constant power for mono sources, the center is -3 dB on both sides. A
+// stereo source keeps its image, pan only turns the far side down.
+static void
+APP_Mixer_PanGains(const struct APP_Voice *voice, Uint32 channels, float *out_l, float *out_r)
+{
+    if (voice->state == APP_VOICE_STOPPING)
+    {
+        *out_l = 0.0f;
+        *out_r = 0.0f;
+        return;
+    }
+
+    if (channels == 1)
+    {
+        float angle = (voice->pan + 1.0f) * SDL_PI_F * 0.25f;
+        *out_l = voice->gain * SDL_cosf(angle);
+        *out_r = voice->gain * SDL_sinf(angle);
+    }
+    else
+    {
+        *out_l = voice->gain * (voice->pan > 0.0f ? 1.0f - voice->pan : 1.0f);
+        *out_r = voice->gain * (voice->pan < 0.0f ? 1.0f + voice->pan : 1.0f);
+    }
+}
+
+// Frames from position on whose filter stays inside the source, the ones
+// starting on a frame from first up to before end.
+static Uint32
+APP_Mixer_SafeFrames(Uint64 position, Uint64 step, Uint32 first, Uint32 end, Uint32 frames)
+{
+    Uint64 index = position >> 32;
+    if (index < first || index >= end)
+    {
+        return 0;
+    }
+
+    Uint64 safe = (((Uint64)end << 32) - position + step - 1) / step;
+    return (Uint32)SDL_min(safe, (Uint64)frames);
+}
+
+// ============================================================================
+// Rendering
+// ============================================================================
+
+// Mixes count frames of the voice into the master bus from frame offset on,
+// and into every effect bus it sends to. The gains ramp from where the last
+// block ended to the targets over the whole block.
+static void
+APP_Mixer_MixVoice(
+        struct APP_Mixer *mixer,
+        const struct APP_Voice *voice,
+        const float *src_l,
+        const float *src_r,
+        Uint32 offset,
+        Uint32 count,
+        Uint32 frames,
+        float target_l,
+        float target_r
+)
+{
+    float step_l = (target_l - voice->gain_l) / (float)frames;
+    float step_r = (target_r - voice->gain_r) / (float)frames;
+    mixer->mix(
+            mixer->bus[0] + offset,
+            mixer->bus[1] + offset,
+            src_l,
+            src_r,
+            count,
+            voice->gain_l + step_l * (float)offset,
+            step_l,
+            voice->gain_r + step_r * (float)offset,
+            step_r
+    );
+
+    for (Uint32 s = 0; s < APP_MIXER_MAX_SENDS; ++s)
+    {
+        const struct APP_VoiceSend *send = &voice->sends[s];
+        if (send->bus < 0 || (send->level == 0.0f && send->current == 0.0f))
+        {
+            continue;
+        }
+
+        float *dst_l, *dst_r;
+        APP_Effects_GetInput(mixer->effects, (Uint32)send->bus, &dst_l, &dst_r);
+
+        float from_l = voice->gain_l * send->current;
+        float from_r = voice->gain_r * send->current;
+        step_l = (target_l * send->level - from_l) / (float)frames;
+        step_r = (target_r * send->level - from_r) / (float)frames;
+        mixer->mix(
+                dst_l + offset,
+                dst_r + offset,
+                src_l,
+                src_r,
+                count,
+                from_l + step_l * (float)offset,
+                step_l,
+                from_r + step_r * (float)offset,
+                step_r
+        );
+    }
+}
+
+// Resamples a sound in memory. Returns the frames written, fewer than asked
+// for once a sound that doesn't loop ran out.
+static Uint32
+APP_Mixer_ResampleSound(struct APP_Mixer *mixer, struct APP_Voice *voice, Uint32 frames)
+{
+    const struct APP_Sound *sound = voice->sound;
+    const Uint64 end = (Uint64)sound->frame_count << 32;
+    const Uint32 taps = APP_Resampler_GetTaps(mixer->quality);
+    const Uint32 before = taps / 2 - 1;
+    const Uint32 after = taps / 2;
+    const Uint32 safe_end = sound->frame_count > after ? sound->frame_count - after : 0;
+
+    Uint32 done = 0;
+    while (done < frames)
+    {
+        if (voice->position >= end)
+        {
+            if (!voice->loop)
+            {
+                break;
+            }
+
+            voice->position %= end;
+        }
+
+        Uint32 safe = APP_Mixer_SafeFrames(voice->position, voice->step, before, safe_end, frames - done);
+        if (safe > 0)
+        {
+            for (Uint32 c = 0; c < sound->channels; ++c)
+            {
+                APP_Resampler_Process(
+                        mixer->resampler,
+                        mixer->quality,
+                        mixer->scratch[c] + done,
+                        sound->samples[c],
+                        voice->position,
+                        voice->step,
+                        safe
+                );
+            }
+
+            voice->position += voice->step * safe;
+            done += safe;
+            continue;
+        }
+
+        // Note(john): Near either end the filter reaches past the sound. Those
+        // frames are gathered one by one, wrapped around when the sound loops
+        // and silent when it doesn't.
+        Sint64 index = (Sint64)(voice->position >> 32);
+        for (Uint32 c = 0; c < sound->channels; ++c)
+        {
+            float window[APP_RESAMPLER_MAX_TAPS];
+            for (Uint32 k = 0; k < taps; ++k)
+            {
+                Sint64 frame = index - before + k;
+                if (voice->loop)
+                {
+                    frame %= sound->frame_count;
+                    frame += frame < 0 ? sound->frame_count : 0;
+                }
+
+                bool inside = frame >= 0 && frame < sound->frame_count;
+                window[k] = inside ? sound->samples[c][frame] : 0.0f;
+            }
+
+            APP_Resampler_Process(
+                    mixer->resampler,
+                    mixer->quality,
+                    mixer->scratch[c] + done,
+                    window + before,
+                    voice->position & APP_MIXER_FRACTION_MASK,
+                    voice->step,
+                    1
+            );
+        }
+
+        voice->position += voice->step;
+        ++done;
+    }
+
+    return done;
+}
+
+static Uint32
+APP_Mixer_RenderSound(struct APP_Mixer *mixer, struct APP_Voice *voice, Uint32 frames, float target_l, float target_r)
+{
+    const struct APP_Sound *sound = voice->sound;
+
+    // Note(john): At the sound's own rate the samples are mixed straight
+    // from the sound, nothing to interpolate.
+    if (voice->step == APP_MIXER_FRACTION_ONE && (voice->position & APP_MIXER_FRACTION_MASK) == 0)
+    {
+        Uint32 done = 0;
+        while (done < frames)
+        {
+            Uint32 index = (Uint32)(voice->position >> 32);
+            if (index >= sound->frame_count)
+            {
+                if (!voice->loop)
+                {
+                    break;
+                }
+
+                index = 0;
+            }
+
+            Uint32 count = SDL_min(frames - done, sound->frame_count - index);
+            APP_Mixer_MixVoice(
+                    mixer,
+                    voice,
+                    sound->samples[0] + index,
+                    sound->samples[sound->channels - 1] + index,
+                    done,
+                    count,
+                    frames,
+                    target_l,
+                    target_r
+            );
+
+            voice->position = (Uint64)(index + count) << 32;
+            done += count;
+        }
+
+        return done;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint32 done = APP_Mixer_ResampleSound(mixer, voice, frames);
+    mixer->resample_ticks += SDL_GetPerformanceCounter() - start;
+
+    APP_Mixer_MixVoice(
+            mixer,
+            voice,
+            mixer->scratch[0],
+            mixer->scratch[sound->channels - 1],
+            0,
+            done,
+            frames,
+            target_l,
+            target_r
+    );
+
+    return done;
+}
+
+// Decodes an IMA ADPCM sound as far as this block reads, behind what the
+// last block left over, then resamples from there like a stream. Returns
+// the frames written, fewer than asked for once a sound that doesn't loop
+// ran out.
+static Uint32
+APP_Mixer_RenderADPCM(struct APP_Mixer *mixer, struct APP_Voice *voice, Uint32 frames, float target_l, float target_r)
+{
+    const struct APP_Sound *sound = voice->sound;
+    const Uint32 channels = sound->channels;
+    const Uint32 after = APP_Resampler_GetTaps(mixer->quality) / 2;
+
+    // Up to the last frame the filter reads for this block.
+    Uint64 last = voice->position + voice->step * (frames - 1);
+    Uint32 needed = (Uint32)(last >> 32) + after + 1;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    for (Uint32 c = 0; c < channels; ++c)
+    {
+        SDL_memcpy(mixer->decoded[c], voice->carry[c], sizeof(float) * voice->carry_frames);
+    }
+
+    Uint32 have = voice->carry_frames;
+    while (have < needed)
+    {
+        float *dst[2] = { mixer->decoded[0] + have, mixer->decoded[1] + have };
+        have += APP_ADPCM_Decode(&sound->adpcm, &voice->decoder, dst, needed - have);
+
+        if (have == needed)
+        {
+            break;
+        }
+
+        if (voice->loop)
+        {
+            APP_ADPCM_Seek(&sound->adpcm, &voice->decoder, 0);
+            continue;
+        }
+
+        // Note(john): Silence after the last frame lets the filter play it
+        // out, the voice ends on the frame after it.
+        if (!voice->decoded_end)
+        {
+            voice->decoded_end = true;
+            voice->end_frame = have;
+        }
+
+        for (Uint32 c = 0; c < channels; ++c)
+        {
+            SDL_memset(mixer->decoded[c] + have, 0, sizeof(float) * (needed - have));
+        }
+
+        have = needed;
+    }
+
+    Uint64 decoded = SDL_GetPerformanceCounter();
+    mixer->decode_ticks += decoded - start;
+
+    Uint32 done = frames;
+    if (voice->decoded_end)
+    {
+        done = APP_Mixer_SafeFrames(voice->position, voice->step, 0, voice->end_frame, frames);
+    }
+
+    const float *src[2] = { mixer->decoded[0], mixer->decoded[channels - 1] };
+
+    // Note(john): At the sound's own rate the decoded frames are mixed
+    // straight, nothing to interpolate.
+    if (voice->step != APP_MIXER_FRACTION_ONE || (voice->position & APP_MIXER_FRACTION_MASK) != 0)
+    {
+        for (Uint32 c = 0; c < channels; ++c)
+        {
+            APP_Resampler_Process(
+                    mixer->resampler,
+                    mixer->quality,
+                    mixer->scratch[c],
+                    mixer->decoded[c],
+                    voice->position,
+                    voice->step,
+                    done
+            );
+        }
+
+        mixer->resample_ticks += SDL_GetPerformanceCounter() - decoded;
+        src[0] = mixer->scratch[0];
+        src[1] = mixer->scratch[channels - 1];
+    }
+    else
+    {
+        src[0] += voice->position >> 32;
+        src[1] += voice->position >> 32;
+    }
+
+    APP_Mixer_MixVoice(mixer, voice, src[0], src[1], 0, done, frames, target_l, target_r);
+
+    // Keep the history the filter reads before the position and what was
+    // decoded past it.
+    voice->position += voice->step * done;
+    Uint32 consumed = SDL_min((Uint32)(voice->position >> 32) - APP_MIXER_STREAM_HISTORY, have);
+    voice->carry_frames = SDL_min(have - consumed, (Uint32)APP_RESAMPLER_MAX_TAPS);
+    voice->position -= (Uint64)consumed << 32;
+    voice->end_frame -= voice->decoded_end ? consumed : 0;
+
+    for (Uint32 c = 0; c < channels; ++c)
+    {
+        SDL_memcpy(voice->carry[c], mixer->decoded[c] + consumed, sizeof(float) * voice->carry_frames);
+    }
+
+    return done;
+}
+
+// Convert whole frames of the stream's format to planar float, the first
+// two channels only.
+static void
+APP_Mixer_ConvertFrames(const SDL_AudioSpec *spec, const Uint8 *src, Uint32 frames, float *dst_l, float *dst_r)
+{
+    const Uint32 channels = (Uint32)spec->channels;
+    const Uint32 used = SDL_min(channels, 2u);
+    float *dst[2] = { dst_l, dst_r };
+
+    for (Uint32 i = 0; i < frames; ++i)
+    {
+        for (Uint32 c = 0; c < used; ++c)
+        {
+            Uint32 sample = i * channels + c;
+            float value;
+
+            switch (spec->format)
+            {
+                case SDL_AUDIO_U8:
+                    value = ((float)src[sample] - 128.0f) * (1.0f / 128.0f);
+                    break;
+                case SDL_AUDIO_S16LE:
+                {
+                    Sint16 s;
+                    SDL_memcpy(&s, src + sample * 2, 2);
+                    value = (float)(Sint16)SDL_Swap16LE(s) * (1.0f / 32768.0f);
+                    break;
+                }
+                case SDL_AUDIO_S32LE:
+                {
+                    Sint32 s;
+                    SDL_memcpy(&s, src + sample * 4, 4);
+                    value = (float)(Sint32)SDL_Swap32LE(s) * (1.0f / 2147483648.0f);
+                    break;
+                }
+                default:
+                {
+                    Uint32 bits;
+                    SDL_memcpy(&bits, src + sample * 4, 4);
+                    bits = SDL_Swap32LE(bits);
+                    SDL_memcpy(&value, &bits, 4);
+                    break;
+                }
+            }
+
+            dst[c][i] = value;
+        }
+    }
+}
+
+// Read from the stream until the source holds needed frames or the stream
+// has nothing more right now.
+static void
+APP_Mixer_FillSource(struct APP_Mixer *mixer, struct APP_StreamSource *source, Uint32 needed)
+{
+    const SDL_AudioSpec *spec = APP_WavStream_GetSpec(source->stream);
+    const Uint32 frame_bytes = (Uint32)SDL_AUDIO_FRAMESIZE(*spec);
+    const Uint32 chunk_frames = APP_MIXER_STREAM_READ_BYTES / frame_bytes;
+
+    needed = SDL_min(needed, (Uint32)APP_MIXER_STREAM_FRAMES);
+
+    while (source->frame_count < needed)
+    {
+        Uint32 want = SDL_min(needed - source->frame_count, chunk_frames);
+        int read = APP_WavStream_Read(source->stream, mixer->stream_bytes, (int)(want * frame_bytes));
+        Uint32 frames = (Uint32)read / frame_bytes;
+        if (frames == 0)
+        {
+            break;
+        }
+
+        APP_Mixer_ConvertFrames(
+                spec,
+                mixer->stream_bytes,
+                frames,
+                source->samples[0] + source->frame_count,
+                source->samples[1] + source->frame_count
+        );
+        source->frame_count += frames;
+
+        if (frames < want)
+        {
+            break;
+        }
+    }
+}
+
+// Returns false once the stream ended and every frame of it was mixed.
+static bool
+APP_Mixer_RenderStream(struct APP_Mixer *mixer, struct APP_Voice *voice, Uint32 frames, float target_l, float target_r)
+{
+    struct APP_StreamSource *source = voice->source;
+    const Uint32 after = APP_Resampler_GetTaps(mixer->quality) / 2;
+
+    // Up to the last frame the filter reads for this block.
+    Uint64 last = voice->position + voice->step * (frames - 1);
+    Uint64 start = SDL_GetPerformanceCounter();
+    APP_Mixer_FillSource(mixer, source, (Uint32)(last >> 32) + after + 1);
+    Uint64 filled = SDL_GetPerformanceCounter();
+    mixer->stream_ticks += filled - start;
+
+    // Note(john): Silence after the last frame lets the filter play it out.
+    if (!source->drained
+        && APP_WavStream_IsFinished(source->stream)
+        && source->frame_count + APP_RESAMPLER_MAX_TAPS <= APP_MIXER_STREAM_FRAMES)
+    {
+        for (Uint32 c = 0; c < source->channels; ++c)
+        {
+            SDL_memset(source->samples[c] + source->frame_count, 0, sizeof(float) * APP_RESAMPLER_MAX_TAPS);
+        }
+
+        source->frame_count += APP_RESAMPLER_MAX_TAPS;
+        source->drained = true;
+    }
+
+    Uint32 safe_end = source->frame_count > after ? source->frame_count - after : 0;
+    Uint32 safe = APP_Mixer_SafeFrames(voice->position, voice->step, APP_MIXER_STREAM_HISTORY, safe_end, frames);
+    if (safe == 0 && source->drained)
+    {
+        return false;
+    }
+
+    // Note(john): An underrun leaves the rest of the block silent, the voice
+    // picks up where it was on the next one.
+    for (Uint32 c = 0; c < source->channels; ++c)
+    {
+        APP_Resampler_Process(
+                mixer->resampler,
+                mixer->quality,
+                mixer->scratch[c],
+                source->samples[c],
+                voice->position,
+                voice->step,
+                safe
+        );
+    }
+
+    mixer->resample_ticks += SDL_GetPerformanceCounter() - filled;
+
+    APP_Mixer_MixVoice(
+            mixer,
+            voice,
+            mixer->scratch[0],
+            mixer->scratch[source->channels - 1],
+            0,
+            safe,
+            frames,
+            target_l,
+            target_r
+    );
+
+    // Keep the history the filter reads before the position.
+    voice->position += voice->step * safe;
+    Uint32 consumed = (Uint32)(voice->position >> 32) - APP_MIXER_STREAM_HISTORY;
+    source->frame_count -= consumed;
+    voice->position -= (Uint64)consumed << 32;
+
+    for (Uint32 c = 0; c < source->channels; ++c)
+    {
+        SDL_memmove(source->samples[c], source->samples[c] + consumed, sizeof(float) * source->frame_count);
+    }
+
+    return true;
+}
+
+// Master gain and the limiter, then interleave into dst.
+static void
+APP_Mixer_Limit(struct APP_Mixer *mixer, float *dst, Uint32 frames)
+{
+    const float *bus_l = mixer->bus[0];
+    const float *bus_r = mixer->bus[1];
+
+    float master = mixer->master_current;
+    const float master_step = (mixer->master_gain - master) / (float)frames;
+    float envelope = mixer->limiter_gain;
+    float lowest = mixer->limiter_min_gain;
+
+    for (Uint32 i = 0; i < frames; ++i)
+    {
+        float l = bus_l[i] * master;
+        float r = bus_r[i] * master;
+        master += master_step;
+
+        // Note(john): The gain drops at once so no peak gets past the
+        // threshold, and comes back up slowly so it doesn't pump.
+        float peak = SDL_max(SDL_fabsf(l), SDL_fabsf(r));
+        float target = peak > APP_MIXER_LIMITER_THRESHOLD ? APP_MIXER_LIMITER_THRESHOLD / peak : 1.0f;
+        if (target < envelope)
+        {
+            envelope = target;
+        }
+        else
+        {
+            envelope = target + (envelope - target) * mixer->limiter_release;
+        }
+
+        lowest = SDL_min(lowest, envelope);
+        dst[i * 2] = l * envelope;
+        dst[i * 2 + 1] = r * envelope;
+    }
+
+    mixer->master_current = mixer->master_gain;
+    mixer->limiter_gain = envelope;
+    mixer->limiter_min_gain = lowest;
+}
+
+static void
+APP_Mixer_RenderBlock(struct APP_Mixer *mixer, float *dst, Uint32 frames)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    APP_Mixer_ApplyCommands(mixer);
+    SDL_memset(mixer->bus, 0, sizeof(mixer->bus));
+    Uint64 voices_start = SDL_GetPerformanceCounter();
+
+    Uint32 i = 0;
+    while (i < mixer->active_count)
+    {
+        struct APP_Voice *voice = &mixer->voices[mixer->active_voices[i]];
+        Uint32 channels = voice->sound != NULL ? voice->sound->channels : voice->source->channels;
+
+        float target_l, target_r;
+        APP_Mixer_PanGains(voice, channels, &target_l, &target_r);
+
+        bool playing;
+        if (voice->sound != NULL && voice->sound->adpcm.blocks != NULL)
+        {
+            playing = APP_Mixer_RenderADPCM(mixer, voice, frames, target_l, target_r) == frames;
+        }
+        else if (voice->sound != NULL)
+        {
+            playing = APP_Mixer_RenderSound(mixer, voice, frames, target_l, target_r) == frames;
+        }
+        else
+        {
+            playing = APP_Mixer_RenderStream(mixer, voice, frames, target_l, target_r);
+        }
+
+        voice->gain_l = target_l;
+        voice->gain_r = target_r;
+
+        for (Uint32 s = 0; s < APP_MIXER_MAX_SENDS; ++s)
+        {
+            struct APP_VoiceSend *send = &voice->sends[s];
+            send->current = send->level;
+            send->bus = send->level > 0.0f ? send->bus : -1;
+        }
+
+        if (!playing || voice->state == APP_VOICE_STOPPING)
+        {
+            // The last voice moves into this slot.
+            APP_Mixer_FinishVoice(mixer, i);
+            continue;
+        }
+
+        ++i;
+    }
+
+    Uint64 voices_done = SDL_GetPerformanceCounter();
+    APP_Effects_Process(mixer->effects, mixer->bus[0], mixer->bus[1], frames);
+    Uint64 effects_done = SDL_GetPerformanceCounter();
+    APP_Mixer_Limit(mixer, dst, frames);
+    Uint64 end = SDL_GetPerformanceCounter();
+
+    mixer->voice_ticks += voices_done - voices_start;
+    mixer->effects_ticks += effects_done - voices_done;
+    mixer->master_ticks += end - effects_done;
+
+    Uint64 ticks = end - start;
+    if ((double)ticks * mixer->freq > (double)frames * SDL_GetPerformanceFrequency())
+    {
+        ++mixer->stats.late_blocks;
+    }
+
+    ++mixer->blocks_since_stats;
+}
+
+void
+APP_Mixer_Render(struct APP_Mixer *mixer, float *dst, Uint32 frames)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint32 total = frames;
+
+    while (frames > 0)
+    {
+        Uint32 block = SDL_min(frames, (Uint32)APP_MIXER_BLOCK_FRAMES);
+        APP_Mixer_RenderBlock(mixer, dst, block);
+        dst += block * 2;
+        frames -= block;
+    }
+
+    mixer->stats.mixed_frames += total;
+    mixer->stats.mix_ms += (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+        / (double)SDL_GetPerformanceFrequency();
+    mixer->stats.audio_ms += (double)total * 1000.0 / (double)mixer->freq;
+
+    APP_Mixer_PostStats(mixer);
+}
+
+// Runs on the audio thread whenever the device needs more samples.
+static void
+APP_Mixer_Feed(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount)
+{
+    struct APP_Mixer *mixer = userdata;
+    float block[APP_MIXER_BLOCK_FRAMES * 2];
+    const int frame_bytes = (int)sizeof(float) * 2;
+
+    Uint64 start = SDL_GetTicksNS();
+    int queued = SDL_GetAudioStreamQueued(stream);
+
+    while (additional_amount > 0)
+    {
+        Uint32 frames = (Uint32)SDL_min((additional_amount + frame_bytes - 1) / frame_bytes, APP_MIXER_BLOCK_FRAMES);
+        APP_Mixer_Render(mixer, block, frames);
+        SDL_PutAudioStreamData(stream, block, (int)frames * frame_bytes);
+        additional_amount -= (int)frames * frame_bytes;
+    }
+
+    struct APP_MixerStats *stats = &mixer->stats;
+    Uint64 end = SDL_GetTicksNS();
+    Uint32 period = (Uint32)(total_amount / frame_bytes);
+    double period_ms = (double)period * 1000.0 / (double)mixer->freq;
+    double callback_ms = (double)(end - start) / 1e6;
+
+    // Note(john): The device thread asks once per period. Coming back much
+    // later than that, or taking longer than a period to fill it, means the
+    // device had nothing to play for a while.
+    bool underrun = callback_ms > period_ms;
+    if (mixer->last_callback_ns != 0)
+    {
+        double interval_ms = (double)(start - mixer->last_callback_ns) / 1e6;
+        stats->max_interval_ms = SDL_max(stats->max_interval_ms, (float)interval_ms);
+        underrun = underrun || interval_ms > period_ms * APP_MIXER_UNDERRUN_PERIODS;
+    }
+
+    mixer->last_callback_ns = start;
+
+    ++stats->callbacks;
+    stats->underruns += underrun ? 1 : 0;
+    stats->period_frames = period;
+    stats->max_queued_bytes = SDL_max(stats->max_queued_bytes, (Uint32)SDL_max(queued, 0));
+    stats->callback_ms += callback_ms;
+    stats->max_callback_ms = SDL_max(stats->max_callback_ms, (float)callback_ms);
+}
+
+// ============================================================================
+// Mixer
+// ============================================================================
+
+struct APP_Mixer *
+APP_Mixer_Create(int freq)
+{
+    if (freq <= 0)
+    {
+        SDL_Log("ERROR: Invalid mixer rate %d Hz.", freq);
+        return NULL;
+    }
+
+    struct APP_Mixer *mixer = SDL_calloc(1, sizeof(struct APP_Mixer));
+    if (mixer == NULL)
+    {
+        return NULL;
+    }
+
+    mixer->resampler = APP_Resampler_Create();
+    mixer->effects = APP_Effects_Create(freq);
+    mixer->commands = APP_Ring_Create(sizeof(struct APP_MixerCommand), APP_MIXER_COMMAND_CAPACITY);
+    // A finished message for every voice, every effect that can be replaced
+    // and a few stats besides.
+    mixer->messages = APP_Ring_Create(
+            sizeof(struct APP_MixerMessage),
+            APP_MIXER_MAX_VOICES * 2 + APP_MIXER_MAX_RETIRED
+    );
+
+    if (mixer->resampler == NULL || mixer->effects == NULL || mixer->commands == NULL || mixer->messages == NULL)
+    {
+        APP_Mixer_Destroy(mixer);
+        return NULL;
+    }
+
+    mixer->freq = freq;
+    mixer->quality = APP_RESAMPLE_MEDIUM;
+    mixer->mix = APP_Mix_Scalar;
+
+#ifdef APP_MIXER_SSE
+    if (SDL_HasSSE())
+    {
+        mixer->mix = APP_Mix_SSE;
+    }
+#endif
+#ifdef APP_MIXER_NEON
+    if (SDL_HasNEON())
+    {
+        mixer->mix = APP_Mix_NEON;
+    }
+#endif
+
+    // Hand out the lowest voices first.
+    for (Uint32 i = 0; i < APP_MIXER_MAX_VOICES; ++i)
+    {
+        mixer->free_slots[i] = (Uint16)(APP_MIXER_MAX_VOICES - 1 - i);
+        mixer->slots[i].source = -1;
+    }
+
+    mixer->free_slot_count = APP_MIXER_MAX_VOICES;
+
+    mixer->master_gain = 1.0f;
+    mixer->master_current = 1.0f;
+    mixer->limiter_gain = 1.0f;
+    mixer->limiter_min_gain = 1.0f;
+    mixer->limiter_release = SDL_expf(-1000.0f / (APP_MIXER_LIMITER_RELEASE_MS * (float)freq));
+
+    return mixer;
+}
+
+void
+APP_Mixer_Destroy(struct APP_Mixer *mixer)
+{
+    if (mixer == NULL)
+    {
+        return;
+    }
+
+    SDL_DestroyAudioStream(mixer->stream);
+
+    // Note(john): With the stream gone no block runs anymore. Effects on
+    // their way in either direction are destroyed here, the ones in the
+    // buses with the buses.
+    struct APP_MixerMessage message;
+    while (mixer->messages != NULL && APP_Ring_Pop(mixer->messages, &message))
+    {
+        if (message.type == APP_MIXER_MESSAGE_RETIRED_EFFECT)
+        {
+            APP_Effect_Destroy(message.effect);
+        }
+    }
+
+    struct APP_MixerCommand command;
+    while (mixer->commands != NULL && APP_Ring_Pop(mixer->commands, &command))
+    {
+        if (command.type == APP_MIXER_COMMAND_SET_EFFECT && command.replace_effect)
+        {
+            APP_Effect_Destroy(command.effect);
+        }
+    }
+
+    APP_Effects_Destroy(mixer->effects);
+    APP_Resampler_Destroy(mixer->resampler);
+    APP_Ring_Destroy(mixer->commands);
+    APP_Ring_Destroy(mixer->messages);
+    SDL_free(mixer);
+}
+
+bool
+APP_Mixer_OpenDevice(struct APP_Mixer *mixer, SDL_AudioDeviceID device)
+{
+    SDL_AudioSpec spec = { SDL_AUDIO_F32, 2, mixer->freq };
+
+    // Note(john): No callback runs once the old stream is gone, the audio
+    // thread's callback state is safe to reset from here.
+    SDL_DestroyAudioStream(mixer->stream);
+    mixer->last_callback_ns = 0;
+    mixer->stats.callbacks = 0;
+    mixer->stats.underruns = 0;
+    mixer->stats.callback_ms = 0.0;
+
+    mixer->stream = SDL_OpenAudioDeviceStream(device, &spec, APP_Mixer_Feed, mixer);
+    if (mixer->stream == NULL)
+    {
+        SDL_Log("ERROR: Failed to open audio stream. %s", SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+SDL_AudioStream *
+APP_Mixer_GetStream(struct APP_Mixer *mixer)
+{
+    return mixer->stream;
+}
+
+int
+APP_Mixer_GetFrequency(const struct APP_Mixer *mixer)
+{
+    return mixer->freq;
+}
+
+// Game thread. Take in what the audio thread sent back: finished voices go
+// back to the pool and into the queue for polling, replaced effects are
+// destroyed, stats replace the last.
+static void
+APP_Mixer_Receive(struct APP_Mixer *mixer)
+{
+    struct APP_MixerMessage message;
+    while (APP_Ring_Pop(mixer->messages, &message))
+    {
+        if (message.type == APP_MIXER_MESSAGE_RETIRED_EFFECT)
+        {
+            APP_Effect_Destroy(message.effect);
+            --mixer->retiring_effects;
+            continue;
+        }
+
+        if (message.type == APP_MIXER_MESSAGE_STATS)
+        {
+            struct APP_MixerStats *stats = &mixer->game_stats;
+            Uint32 peak = SDL_max(stats->peak_voices, message.stats.peak_voices);
+            float reduction = SDL_max(stats->limiter_reduction_db, message.stats.limiter_reduction_db);
+
+            stats->active_voices = message.stats.active_voices;
+            stats->peak_voices = peak;
+            stats->late_blocks = message.stats.late_blocks;
+            stats->mixed_frames = message.stats.mixed_frames;
+            stats->mix_ms = message.stats.mix_ms;
+            stats->audio_ms = message.stats.audio_ms;
+            stats->stream_ms = message.stats.stream_ms;
+            stats->decode_ms = message.stats.decode_ms;
+            stats->resample_ms = message.stats.resample_ms;
+            stats->voice_ms = message.stats.voice_ms;
+            stats->effects_ms = message.stats.effects_ms;
+            stats->master_ms = message.stats.master_ms;
+            stats->effects = message.stats.effects;
+            stats->limiter_reduction_db = reduction;
+
+            stats->callbacks = message.stats.callbacks;
+            stats->underruns = message.stats.underruns;
+            stats->period_frames = message.stats.period_frames;
+            stats->callback_ms = message.stats.callback_ms;
+            stats->max_queued_bytes = SDL_max(stats->max_queued_bytes, message.stats.max_queued_bytes);
+            stats->max_callback_ms = SDL_max(stats->max_callback_ms, message.stats.max_callback_ms);
+            stats->max_interval_ms = SDL_max(stats->max_interval_ms, message.stats.max_interval_ms);
+            continue;
+        }
+
+        Uint32 index = APP_Mixer_VoiceIndex(message.voice);
+        struct APP_VoiceSlot *slot = &mixer->slots[index];
+
+        if (slot->source >= 0)
+        {
+            mixer->sources_used[slot->source] = false;
+        }
+
+        slot->playing = false;
+        slot->source = -1;
+        ++slot->generation;
+        mixer->free_slots[mixer->free_slot_count++] = (Uint16)index;
+
+        if (mixer->finished_count == APP_MIXER_MAX_VOICES)
+        {
+            // The oldest event makes room.
+            mixer->finished_first = (mixer->finished_first + 1) % APP_MIXER_MAX_VOICES;
+            --mixer->finished_count;
+            ++mixer->game_stats.dropped_events;
+        }
+
+        Uint32 last = (mixer->finished_first + mixer->finished_count) % APP_MIXER_MAX_VOICES;
+        mixer->finished[last] = message.voice;
+        ++mixer->finished_count;
+    }
+}
+
+// Game thread. False when the ring is full.
+static bool
+APP_Mixer_Post(struct APP_Mixer *mixer, const struct APP_MixerCommand *command)
+{
+    if (!APP_Ring_Push(mixer->commands, command))
+    {
+        ++mixer->game_stats.dropped_commands;
+        return false;
+    }
+
+    return true;
+}
+
+// Game thread. Picks a free voice for the command and posts it.
+static APP_VoiceID
+APP_Mixer_PostPlay(struct APP_Mixer *mixer, struct APP_MixerCommand *command, const struct APP_VoiceParams *params)
+{
+    APP_Mixer_Receive(mixer);
+
+    if (mixer->free_slot_count == 0)
+    {
+        ++mixer->game_stats.rejected_voices;
+        return 0;
+    }
+
+    struct APP_VoiceParams defaults = { 1.0f, 0.0f, 1.0f, false };
+    command->type = APP_MIXER_COMMAND_PLAY;
+    command->params = params != NULL ? *params : defaults;
+
+    Uint16 index = mixer->free_slots[mixer->free_slot_count - 1];
+    struct APP_VoiceSlot *slot = &mixer->slots[index];
+    command->voice = APP_Mixer_MakeVoiceID(index, slot->generation);
+
+    if (!APP_Mixer_Post(mixer, command))
+    {
+        ++mixer->game_stats.rejected_voices;
+        return 0;
+    }
+
+    --mixer->free_slot_count;
+    slot->playing = true;
+    slot->source = command->stream != NULL ? command->source : -1;
+    return command->voice;
+}
+
+APP_VoiceID
+APP_Mixer_Play(struct APP_Mixer *mixer, const struct APP_Sound *sound, const struct APP_VoiceParams *params)
+{
+    return APP_Mixer_PlayFrom(mixer, sound, params, 0);
+}
+
+APP_VoiceID
+APP_Mixer_PlayFrom(
+        struct APP_Mixer *mixer,
+        const struct APP_Sound *sound,
+        const struct APP_VoiceParams *params,
+        Uint64 start_frame
+)
+{
+    if (sound == NULL || sound->frame_count == 0)
+    {
+        return 0;
+    }
+
+    struct APP_MixerCommand command;
+    SDL_zero(command);
+    command.sound = sound;
+    command.start_frame = start_frame;
+
+    return APP_Mixer_PostPlay(mixer, &command, params);
+}
+
+APP_VoiceID
+APP_Mixer_PlayStream(struct APP_Mixer *mixer, struct APP_WavStream *stream, const struct APP_VoiceParams *params)
+{
+    if (stream == NULL)
+    {
+        return 0;
+    }
+
+    APP_Mixer_Receive(mixer);
+
+    struct APP_MixerCommand command;
+    SDL_zero(command);
+    command.stream = stream;
+    command.source = -1;
+
+    for (int i = 0; i < APP_MIXER_MAX_STREAMS; ++i)
+    {
+        if (!mixer->sources_used[i])
+        {
+            command.source = i;
+            break;
+        }
+    }
+
+    if (command.source < 0)
+    {
+        ++mixer->game_stats.rejected_voices;
+        return 0;
+    }
+
+    APP_VoiceID id = APP_Mixer_PostPlay(mixer, &command, params);
+    if (id != 0)
+    {
+        mixer->sources_used[command.source] = true;
+    }
+
+    return id;
+}
+
+void
+APP_Mixer_Stop(struct APP_Mixer *mixer, APP_VoiceID id)
+{
+    struct APP_MixerCommand command;
+    SDL_zero(command);
+    command.type = APP_MIXER_COMMAND_STOP;
+    command.voice = id;
+
+    APP_Mixer_Post(mixer, &command);
+}
+
+void
+APP_Mixer_StopAll(struct APP_Mixer *mixer)
+{
+    struct APP_MixerCommand command;
+    SDL_zero(command);
+    command.type = APP_MIXER_COMMAND_STOP_ALL;
+
+    APP_Mixer_Post(mixer, &command);
+}
+
+void
+APP_Mixer_SetParams(struct APP_Mixer *mixer, APP_VoiceID id, const struct APP_VoiceParams *params)
+{
+    struct APP_MixerCommand command;
+    SDL_zero(command);
+    command.type = APP_MIXER_COMMAND_SET_PARAMS;
+    command.voice = id;
+    command.params = *params;
+
+    APP_Mixer_Post(mixer, &command);
+}
+
+bool
+APP_Mixer_IsPlaying(struct APP_Mixer *mixer, APP_VoiceID id)
+{
+    APP_Mixer_Receive(mixer);
+
+    Uint32 index = APP_Mixer_VoiceIndex(id);
+    if (index == APP_MIXER_MAX_VOICES)
+    {
+        return false;
+    }
+
+    const struct APP_VoiceSlot *slot = &mixer->slots[index];
+    return slot->playing && slot->generation == (Uint16)(id >> 16);
+}
+
+Uint32
+APP_Mixer_GetVoiceCount(struct APP_Mixer *mixer)
+{
+    APP_Mixer_Receive(mixer);
+    return APP_MIXER_MAX_VOICES - mixer->free_slot_count;
+}
+
+void
+APP_Mixer_SetQuality(struct APP_Mixer *mixer, enum APP_ResampleQuality quality)
+{
+    struct APP_MixerCommand command;
+    SDL_zero(command);
+    command.type = APP_MIXER_COMMAND_SET_QUALITY;
+    command.quality = quality;
+
+    APP_Mixer_Post(mixer, &command);
+}
+
+void
+APP_Mixer_SetMasterGain(struct APP_Mixer *mixer, float gain)
+{
+    struct APP_MixerCommand command;
+    SDL_zero(command);
+    command.type = APP_MIXER_COMMAND_SET_MASTER_GAIN;
+    command.gain = SDL_max(gain, 0.0f);
+
+    APP_Mixer_Post(mixer, &command);
+}
+
+bool
+APP_Mixer_SetEffect(struct APP_Mixer *mixer, Uint32 bus, Uint32 slot, const struct APP_EffectDesc *desc)
+{
+    if (bus >= APP_EFFECTS_MAX_BUSES || slot >= APP_EFFECTS_MAX_CHAIN)
+    {
+        SDL_Log("ERROR: No effect slot %u on bus %u.", slot, bus);
+        return false;
+    }
+
+    APP_Mixer_Receive(mixer);
+
+    struct APP_MixerCommand command;
+    SDL_zero(command);
+    command.type = APP_MIXER_COMMAND_SET_EFFECT;
+    command.bus = bus;
+    command.slot = slot;
+
+    struct APP_Effect *current = mixer->bus_effects[bus][slot];
+    bool clear = desc == NULL || desc->type == APP_EFFECT_NONE;
+
+    if (!clear && APP_Effect_CanTake(current, desc))
+    {
+        command.effect_desc = *desc;
+        return APP_Mixer_Post(mixer, &command);
+    }
+
+    if (clear && current == NULL)
+    {
+        return true;
+    }
+
+    // Note(john): Until the audio thread sends back what it replaced there
+    // is no room in the ring for more of them.
+    if (current != NULL && mixer->retiring_effects == APP_MIXER_MAX_RETIRED)
+    {
+        return false;
+    }
+
+    command.replace_effect = true;
+    if (!clear)
+    {
+        command.effect = APP_Effect_Create(desc, mixer->freq);
+        if (command.effect == NULL)
+        {
+            return false;
+        }
+    }
+
+    if (!APP_Mixer_Post(mixer, &command))
+    {
+        APP_Effect_Destroy(command.effect);
+        return false;
+    }
+
+    mixer->bus_effects[bus][slot] = command.effect;
+    mixer->retiring_effects += current != NULL ? 1 : 0;
+    return true;
+}
+
+bool
+APP_Mixer_SetBusOutput(struct APP_Mixer *mixer, Uint32 bus, int output, float gain)
+{
+    if (bus >= APP_EFFECTS_MAX_BUSES
+        || (output != APP_EFFECTS_MASTER && (output <= (int)bus || output >= APP_EFFECTS_MAX_BUSES)))
+    {
+        SDL_Log("ERROR: Bus %u can't return into %d.", bus, output);
+        return false;
+    }
+
+    struct APP_MixerCommand command;
+    SDL_zero(command);
+    command.type = APP_MIXER_COMMAND_SET_BUS_OUTPUT;
+    command.bus = bus;
+    command.output = output;
+    command.gain = SDL_max(gain, 0.0f);
+
+    return APP_Mixer_Post(mixer, &command);
+}
+
+void
+APP_Mixer_SetSend(struct APP_Mixer *mixer, APP_VoiceID id, Uint32 bus, float level)
+{
+    if (bus >= APP_EFFECTS_MAX_BUSES)
+    {
+        return;
+    }
+
+    struct APP_MixerCommand command;
+    SDL_zero(command);
+    command.type = APP_MIXER_COMMAND_SET_SEND;
+    command.voice = id;
+    command.bus = bus;
+    command.gain = SDL_max(level, 0.0f);
+
+    APP_Mixer_Post(mixer, &command);
+}
+
+bool
+APP_Mixer_PollEvent(struct APP_Mixer *mixer, struct APP_MixerEvent *out_event)
+{
+    APP_Mixer_Receive(mixer);
+
+    if (mixer->finished_count == 0)
+    {
+        return false;
+    }
+
+    out_event->type = APP_MIXER_EVENT_VOICE_FINISHED;
+    out_event->voice = mixer->finished[mixer->finished_first];
+    mixer->finished_first = (mixer->finished_first + 1) % APP_MIXER_MAX_VOICES;
+    --mixer->finished_count;
+    return true;
+}
+
+void
+APP_Mixer_GetStats(struct APP_Mixer *mixer, struct APP_MixerStats *out_stats)
+{
+    APP_Mixer_Receive(mixer);
+
+    *out_stats = mixer->game_stats;
+
+    mixer->game_stats.peak_voices = mixer->game_stats.active_voices;
+    mixer->game_stats.limiter_reduction_db = 0.0f;
+    mixer->game_stats.max_queued_bytes = 0;
+    mixer->game_stats.max_callback_ms = 0.0f;
+    mixer->game_stats.max_interval_ms = 0.0f;
+}
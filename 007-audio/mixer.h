@@ -0,0 +1,196 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <SDL3/SDL.h>
+
+#include "adpcm.h"
+#include "effects.h"
+#include "resampler.h"
+#include "wavstream.h"
+
+// Mixes any number of voices into one float stereo device stream. Voices
+// come out of a fixed pool, playing, stopping and changing a voice never
+// allocates. Each voice has its own gain, pan and pitch, the sum goes
+// through a limiter before it reaches the device. A voice can also send
+// into effect buses, what they return goes into the master bus before the
+// limiter.
+//
+// Everything but APP_Mixer_Render is called from one game thread. Those
+// calls post commands into a lock-free ring the audio thread applies at the
+// start of the next block, finished voices and stats come back through a
+// second one. Neither side ever waits on the other.
+
+#define APP_MIXER_MAX_VOICES 256
+// Voices that read from a streamed WAV instead of a sound in memory.
+#define APP_MIXER_MAX_STREAMS 4
+// The mixer renders in blocks of this many frames, gain and pan changes
+// ramp over one block.
+#define APP_MIXER_BLOCK_FRAMES 256
+#define APP_MIXER_MAX_PITCH 4.0f
+// Effect buses one voice can send into at once.
+#define APP_MIXER_MAX_SENDS 4
+
+// Commands the game thread can post before the audio thread takes them.
+#define APP_MIXER_COMMAND_CAPACITY 1024
+// Blocks between two stats updates from the audio thread.
+#define APP_MIXER_STATS_BLOCKS 16
+
+// A gap between two device callbacks this many times the audio the last
+// one asked for means the device ran dry.
+#define APP_MIXER_UNDERRUN_PERIODS 2.0
+
+// The limiter holds the master bus under this peak and lets go over the
+// release time.
+#define APP_MIXER_LIMITER_THRESHOLD 0.95f
+#define APP_MIXER_LIMITER_RELEASE_MS 80.0f
+
+// Samples in memory as planar float, one or two channels. IMA ADPCM sounds
+// stay compressed instead, each voice decodes the blocks it plays.
+struct APP_Sound {
+    float *samples[2];
+    Uint32 channels;
+    Uint32 frame_count;
+    int freq;
+    // Blocks only for IMA ADPCM sounds, samples are NULL then.
+    struct APP_ADPCMSound adpcm;
+};
+
+// Load a WAV and convert it to planar float, more than two channels are
+// mixed down to stereo. IMA ADPCM WAVs are kept as they are.
+bool APP_Sound_LoadWAV(SDL_IOStream *io, struct APP_Sound *out_sound);
+void APP_Sound_Free(struct APP_Sound *sound);
+// Bytes the sound keeps in memory.
+Uint64 APP_Sound_GetSize(const struct APP_Sound *sound);
+
+struct APP_VoiceParams {
+    float gain;
+    // -1 left, 0 center, 1 right.
+    float pan;
+    // Playback rate, 1 is the sound's own pitch.
+    float pitch;
+    bool loop;
+};
+
+// 0 is never a valid voice.
+typedef Uint32 APP_VoiceID;
+
+enum APP_MixerEventType {
+    APP_MIXER_EVENT_VOICE_FINISHED,
+};
+
+struct APP_MixerEvent {
+    enum APP_MixerEventType type;
+    APP_VoiceID voice;
+};
+
+// Stats from the audio thread are as of its last update.
+struct APP_MixerStats {
+    Uint32 active_voices;
+    Uint32 peak_voices;
+    // Play calls the pool had no free voice for.
+    Uint32 rejected_voices;
+    // Commands the ring had no room for, they never reached the audio
+    // thread.
+    Uint32 dropped_commands;
+    // Finished events no one polled for before the queue of them filled.
+    Uint32 dropped_events;
+    // Blocks that took longer to mix than they play for.
+    Uint32 late_blocks;
+    Uint64 mixed_frames;
+    // Time spent mixing against the length of the audio it produced.
+    double mix_ms;
+    double audio_ms;
+    // Where the mix time went: reading streamed sources, decoding IMA
+    // ADPCM, resampling, mixing the voices into the buses, the effect buses,
+    // and the master gain and limiter.
+    double stream_ms;
+    double decode_ms;
+    double resample_ms;
+    double voice_ms;
+    double effects_ms;
+    double master_ms;
+    // The effects time by type of effect.
+    struct APP_EffectStats effects;
+    // The most the limiter pulled the master bus down, in dB.
+    float limiter_reduction_db;
+
+    // Device callbacks since the device opened. An underrun is a callback
+    // that came too late or took longer than the audio it was asked for.
+    Uint32 callbacks;
+    Uint32 underruns;
+    // Frames the device asked for in its last callback.
+    Uint32 period_frames;
+    // What the stream still held when the device asked, the most since the
+    // last GetStats.
+    Uint32 max_queued_bytes;
+    double callback_ms;
+    // The longest callback and the longest gap between two since the last
+    // GetStats.
+    float max_callback_ms;
+    float max_interval_ms;
+};
+
+struct APP_Mixer;
+
+struct APP_Mixer *APP_Mixer_Create(int freq);
+void APP_Mixer_Destroy(struct APP_Mixer *mixer);
+
+// Open a float stereo stream on the device that pulls from the mixer. Until
+// then the mixer only renders through APP_Mixer_Render. Opening again
+// closes the stream it had first, the callback stats start over.
+bool APP_Mixer_OpenDevice(struct APP_Mixer *mixer, SDL_AudioDeviceID device);
+SDL_AudioStream *APP_Mixer_GetStream(struct APP_Mixer *mixer);
+int APP_Mixer_GetFrequency(const struct APP_Mixer *mixer);
+
+// Interleaved stereo float. The device stream calls this on the audio
+// thread, call it directly only when no device is open.
+void APP_Mixer_Render(struct APP_Mixer *mixer, float *dst, Uint32 frames);
+
+// The sound has to stay loaded while a voice plays it. Returns 0 when every
+// voice is in use or the command ring is full.
+APP_VoiceID APP_Mixer_Play(struct APP_Mixer *mixer, const struct APP_Sound *sound, const struct APP_VoiceParams *params);
+// Starts start_frame frames into the sound, wrapped around for looping
+// voices.
+APP_VoiceID APP_Mixer_PlayFrom(
+        struct APP_Mixer *mixer,
+        const struct APP_Sound *sound,
+        const struct APP_VoiceParams *params,
+        Uint64 start_frame
+);
+// Plays what the audio thread reads from the stream, looping is up to the
+// stream.
+APP_VoiceID APP_Mixer_PlayStream(struct APP_Mixer *mixer, struct APP_WavStream *stream, const struct APP_VoiceParams *params);
+// Fades the voice out over one block, then it finishes.
+void APP_Mixer_Stop(struct APP_Mixer *mixer, APP_VoiceID voice);
+void APP_Mixer_StopAll(struct APP_Mixer *mixer);
+void APP_Mixer_SetParams(struct APP_Mixer *mixer, APP_VoiceID voice, const struct APP_VoiceParams *params);
+// Until its finished event came back from the audio thread.
+bool APP_Mixer_IsPlaying(struct APP_Mixer *mixer, APP_VoiceID voice);
+// Voices playing or about to, the same way as APP_Mixer_IsPlaying.
+Uint32 APP_Mixer_GetVoiceCount(struct APP_Mixer *mixer);
+// How every voice not at its source's own rate is resampled, medium unless
+// set.
+void APP_Mixer_SetQuality(struct APP_Mixer *mixer, enum APP_ResampleQuality quality);
+void APP_Mixer_SetMasterGain(struct APP_Mixer *mixer, float gain);
+
+// Puts an effect into a slot of a bus's chain, the chain runs from slot 0
+// up. The same type of effect changes in place, anything else is created
+// here and the one it replaces comes back to be destroyed on a later call.
+// NULL or APP_EFFECT_NONE clears the slot.
+bool APP_Mixer_SetEffect(struct APP_Mixer *mixer, Uint32 bus, Uint32 slot, const struct APP_EffectDesc *desc);
+// Where the bus returns to, APP_EFFECTS_MASTER or a bus with a higher index.
+// Every bus starts out returning into the master bus at gain 1.
+bool APP_Mixer_SetBusOutput(struct APP_Mixer *mixer, Uint32 bus, int output, float gain);
+// How much of the voice goes into the bus, on top of what it plays
+// directly and after its gain and pan. 0 takes the send away.
+void APP_Mixer_SetSend(struct APP_Mixer *mixer, APP_VoiceID voice, Uint32 bus, float level);
+
+// The next voice that finished, false when there is none. Finished voices
+// go back to the pool whether or not they are polled, the last
+// APP_MIXER_MAX_VOICES events are kept for polling.
+bool APP_Mixer_PollEvent(struct APP_Mixer *mixer, struct APP_MixerEvent *out_event);
+
+// The limiter reduction and the peak voices start over after each call.
+void APP_Mixer_GetStats(struct APP_Mixer *mixer, struct APP_MixerStats *out_stats);
+
+#endif
@@ -0,0 +1,346 @@
+#include "render.h"
+
+#define APP_RENDER_WAV_FORMAT_FLOAT 3
+// Reserved up front when rendering into memory without a limit.
+#define APP_RENDER_INITIAL_SECONDS 10
+
+// Takes every chunk as it comes out of the mixer, false stops the render.
+typedef bool (*APP_RenderSink)(void *userdata, const float *samples, Uint32 frames);
+
+struct APP_RenderMemory {
+    struct APP_RenderBuffer *buffer;
+    Uint64 capacity;
+};
+
+static double
+APP_Render_Milliseconds(Uint64 ticks)
+{
+    return (double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+static bool
+APP_Render_Run(
+        struct APP_Mixer *mixer,
+        const struct APP_RenderDesc *desc,
+        APP_RenderSink sink,
+        void *sink_data,
+        struct APP_RenderStats *out_stats
+)
+{
+    SDL_zerop(out_stats);
+    out_stats->freq = APP_Mixer_GetFrequency(mixer);
+
+    if (APP_Mixer_GetStream(mixer) != NULL)
+    {
+        SDL_Log("ERROR: Can't render offline while the mixer has a device open.");
+        return false;
+    }
+
+    float *chunk = SDL_malloc(sizeof(float) * 2 * APP_RENDER_CHUNK_FRAMES);
+    if (chunk == NULL)
+    {
+        return false;
+    }
+
+    // Note(john): Only what this render adds counts, the mixer may have
+    // rendered before.
+    struct APP_MixerStats before;
+    APP_Mixer_GetStats(mixer, &before);
+
+    const Uint32 update_frames = desc->update_frames > 0 ? desc->update_frames : APP_RENDER_CHUNK_FRAMES;
+    const float update_dt = (float)update_frames / (float)out_stats->freq;
+    Uint32 until_update = 0;
+    Uint64 update_ticks = 0;
+    float peak = 0.0f;
+    bool ok = true;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    while (desc->max_frames == 0 || out_stats->frames < desc->max_frames)
+    {
+        if (desc->update != NULL && until_update == 0)
+        {
+            Uint64 update_start = SDL_GetPerformanceCounter();
+            desc->update(desc->userdata, update_dt);
+            update_ticks += SDL_GetPerformanceCounter() - update_start;
+            until_update = update_frames;
+        }
+
+        // Checked after the update, it may just have started voices.
+        if (APP_Mixer_GetVoiceCount(mixer) == 0)
+        {
+            break;
+        }
+
+        Uint32 frames = APP_RENDER_CHUNK_FRAMES;
+        if (desc->update != NULL)
+        {
+            frames = SDL_min(frames, until_update);
+            until_update -= frames;
+        }
+
+        if (desc->max_frames > 0)
+        {
+            frames = (Uint32)SDL_min((Uint64)frames, desc->max_frames - out_stats->frames);
+        }
+
+        APP_Mixer_Render(mixer, chunk, frames);
+
+        for (Uint32 i = 0; i < frames * 2; ++i)
+        {
+            peak = SDL_max(peak, SDL_fabsf(chunk[i]));
+        }
+
+        out_stats->frames += frames;
+
+        if (!sink(sink_data, chunk, frames))
+        {
+            ok = false;
+            break;
+        }
+    }
+
+    out_stats->render_ms = APP_Render_Milliseconds(SDL_GetPerformanceCounter() - start);
+    SDL_free(chunk);
+
+    // Note(john): The mixer's times are as of its last stats update, up to
+    // APP_MIXER_STATS_BLOCKS blocks before the end.
+    struct APP_MixerStats after;
+    APP_Mixer_GetStats(mixer, &after);
+
+    out_stats->audio_ms = (double)out_stats->frames * 1000.0 / (double)out_stats->freq;
+    out_stats->realtime_factor = out_stats->render_ms > 0.0 ? out_stats->audio_ms / out_stats->render_ms : 0.0;
+    out_stats->update_ms = APP_Render_Milliseconds(update_ticks);
+    out_stats->mix_ms = after.mix_ms - before.mix_ms;
+    out_stats->stream_ms = after.stream_ms - before.stream_ms;
+    out_stats->decode_ms = after.decode_ms - before.decode_ms;
+    out_stats->resample_ms = after.resample_ms - before.resample_ms;
+    out_stats->voice_ms = after.voice_ms - before.voice_ms;
+    out_stats->effects_ms = after.effects_ms - before.effects_ms;
+    out_stats->master_ms = after.master_ms - before.master_ms;
+    out_stats->peak_voices = after.peak_voices;
+    out_stats->limiter_reduction_db = after.limiter_reduction_db;
+    out_stats->peak = peak;
+
+    return ok;
+}
+
+// ============================================================================
+// Memory
+// ============================================================================
+
+static bool
+APP_Render_AppendMemory(void *userdata, const float *samples, Uint32 frames)
+{
+    struct APP_RenderMemory *memory = userdata;
+    struct APP_RenderBuffer *buffer = memory->buffer;
+
+    if (buffer->frames + frames > memory->capacity)
+    {
+        Uint64 capacity = SDL_max(memory->capacity * 2, buffer->frames + frames);
+        float *grown = SDL_realloc(buffer->samples, sizeof(float) * 2 * capacity);
+        if (grown == NULL)
+        {
+            SDL_Log("ERROR: Out of memory after %llu rendered frames.", (unsigned long long)buffer->frames);
+            return false;
+        }
+
+        buffer->samples = grown;
+        memory->capacity = capacity;
+    }
+
+    SDL_memcpy(buffer->samples + buffer->frames * 2, samples, sizeof(float) * 2 * frames);
+    buffer->frames += frames;
+    return true;
+}
+
+bool
+APP_Render_ToMemory(
+        struct APP_Mixer *mixer,
+        const struct APP_RenderDesc *desc,
+        struct APP_RenderBuffer *out_buffer,
+        struct APP_RenderStats *out_stats
+)
+{
+    SDL_zerop(out_buffer);
+    out_buffer->freq = APP_Mixer_GetFrequency(mixer);
+
+    struct APP_RenderMemory memory = { out_buffer, 0 };
+    memory.capacity = desc->max_frames > 0
+        ? desc->max_frames
+        : (Uint64)out_buffer->freq * APP_RENDER_INITIAL_SECONDS;
+
+    out_buffer->samples = SDL_malloc(sizeof(float) * 2 * memory.capacity);
+    if (out_buffer->samples == NULL)
+    {
+        return false;
+    }
+
+    return APP_Render_Run(mixer, desc, APP_Render_AppendMemory, &memory, out_stats);
+}
+
+void
+APP_Render_FreeBuffer(struct APP_RenderBuffer *buffer)
+{
+    SDL_free(buffer->samples);
+    SDL_zerop(buffer);
+}
+
+// ============================================================================
+// WAV
+// ============================================================================
+
+static bool
+APP_Render_WriteHeader(SDL_IOStream *io, int freq, Uint64 frames)
+{
+    const Uint32 data_bytes = (Uint32)SDL_min(frames * 8, (Uint64)SDL_MAX_UINT32 - 36);
+
+    bool ok = true;
+    ok &= SDL_WriteIO(io, "RIFF", 4) == 4;
+    ok &= SDL_WriteU32LE(io, 36 + data_bytes);
+    ok &= SDL_WriteIO(io, "WAVE", 4) == 4;
+
+    ok &= SDL_WriteIO(io, "fmt ", 4) == 4;
+    ok &= SDL_WriteU32LE(io, 16);
+    ok &= SDL_WriteU16LE(io, APP_RENDER_WAV_FORMAT_FLOAT);
+    ok &= SDL_WriteU16LE(io, 2);
+    ok &= SDL_WriteU32LE(io, (Uint32)freq);
+    ok &= SDL_WriteU32LE(io, (Uint32)freq * 8);
+    ok &= SDL_WriteU16LE(io, 8);
+    ok &= SDL_WriteU16LE(io, 32);
+
+    ok &= SDL_WriteIO(io, "data", 4) == 4;
+    ok &= SDL_WriteU32LE(io, data_bytes);
+    return ok;
+}
+
+static bool
+APP_Render_WriteSamples(void *userdata, const float *samples, Uint32 frames)
+{
+    SDL_IOStream *io = userdata;
+    const size_t size = sizeof(float) * 2 * frames;
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    bool ok = true;
+    for (Uint32 i = 0; i < frames * 2 && ok; ++i)
+    {
+        Uint32 bits;
+        SDL_memcpy(&bits, &samples[i], 4);
+        ok = SDL_WriteU32LE(io, bits);
+    }
+#else
+    bool ok = SDL_WriteIO(io, samples, size) == size;
+#endif
+
+    if (!ok)
+    {
+        SDL_Log("ERROR: Failed to write rendered audio. %s", SDL_GetError());
+    }
+
+    return ok;
+}
+
+bool
+APP_Render_ToWAV(
+        struct APP_Mixer *mixer,
+        const struct APP_RenderDesc *desc,
+        SDL_IOStream *io,
+        struct APP_RenderStats *out_stats
+)
+{
+    Sint64 header = SDL_TellIO(io);
+    if (header < 0 || !APP_Render_WriteHeader(io, APP_Mixer_GetFrequency(mixer), 0))
+    {
+        SDL_Log("ERROR: Failed to write WAV header. %s", SDL_GetError());
+        SDL_zerop(out_stats);
+        return false;
+    }
+
+    bool ok = APP_Render_Run(mixer, desc, APP_Render_WriteSamples, io, out_stats);
+
+    // Note(john): Whatever was written is a valid file, even after a failed
+    // write.
+    Sint64 end = SDL_TellIO(io);
+    ok &= SDL_SeekIO(io, header, SDL_IO_SEEK_SET) >= 0;
+    ok &= APP_Render_WriteHeader(io, out_stats->freq, out_stats->frames);
+    ok &= SDL_SeekIO(io, end, SDL_IO_SEEK_SET) >= 0;
+    return ok;
+}
+
+bool
+APP_Render_WriteWAV(const struct APP_RenderBuffer *buffer, SDL_IOStream *io)
+{
+    if (!APP_Render_WriteHeader(io, buffer->freq, buffer->frames))
+    {
+        SDL_Log("ERROR: Failed to write WAV header. %s", SDL_GetError());
+        return false;
+    }
+
+    // In pieces, one write of a long render could be more than size_t
+    // holds on 32 bit.
+    for (Uint64 done = 0; done < buffer->frames; done += APP_RENDER_CHUNK_FRAMES)
+    {
+        Uint32 frames = (Uint32)SDL_min(buffer->frames - done, (Uint64)APP_RENDER_CHUNK_FRAMES);
+        if (!APP_Render_WriteSamples(io, buffer->samples + done * 2, frames))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+APP_Render_Compare(
+        const struct APP_RenderBuffer *buffer,
+        SDL_IOStream *reference,
+        struct APP_RenderComparison *out_comparison
+)
+{
+    SDL_zerop(out_comparison);
+
+    SDL_AudioSpec spec;
+    Uint8 *data = NULL;
+    Uint32 length = 0;
+    if (!SDL_LoadWAV_IO(reference, false, &spec, &data, &length))
+    {
+        SDL_Log("ERROR: Failed to load the reference WAV. %s", SDL_GetError());
+        return false;
+    }
+
+    const SDL_AudioSpec want = { SDL_AUDIO_F32, 2, buffer->freq };
+    float *expected = NULL;
+    int expected_bytes = 0;
+    bool converted = SDL_ConvertAudioSamples(&spec, data, (int)length, &want, (Uint8 **)&expected, &expected_bytes);
+    SDL_free(data);
+
+    if (!converted)
+    {
+        SDL_Log("ERROR: Failed to convert the reference WAV. %s", SDL_GetError());
+        return false;
+    }
+
+    const Uint64 expected_frames = (Uint64)expected_bytes / (sizeof(float) * 2);
+    const Uint64 frames = SDL_min(expected_frames, buffer->frames);
+
+    double signal = 0.0;
+    double noise = 0.0;
+    float peak = 0.0f;
+
+    for (Uint64 i = 0; i < frames * 2; ++i)
+    {
+        float difference = buffer->samples[i] - expected[i];
+        signal += (double)expected[i] * expected[i];
+        noise += (double)difference * difference;
+        peak = SDL_max(peak, SDL_fabsf(difference));
+    }
+
+    SDL_free(expected);
+
+    out_comparison->frames = frames;
+    out_comparison->length_difference = (Sint64)expected_frames - (Sint64)buffer->frames;
+    out_comparison->peak_difference = peak;
+    out_comparison->identical = noise == 0.0 && out_comparison->length_difference == 0;
+    out_comparison->snr_db = noise > 0.0 && signal > 0.0 ? 10.0 * SDL_log10(signal / noise) : 0.0;
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "mixer.h"
+
+// Renders the mixer offline, as fast as it goes and without a device, into
+// memory or a WAV file. The game logic that drives the voices runs on the
+// rendered audio's clock through an update callback, so a render comes out
+// the same on every run and on machines without audio. Used for
+// benchmarks, for comparing the output of two builds and for processing
+// assets in batches.
+
+// The most rendered between two checks for finished voices.
+#define APP_RENDER_CHUNK_FRAMES (APP_MIXER_BLOCK_FRAMES * APP_MIXER_STATS_BLOCKS)
+
+// Called before every update_frames frames, dt in seconds of audio.
+typedef void (*APP_RenderUpdateFunc)(void *userdata, float dt);
+
+struct APP_RenderDesc {
+    // Stops here even if voices still play, 0 renders until every voice
+    // finished.
+    Uint64 max_frames;
+    // NULL for none.
+    APP_RenderUpdateFunc update;
+    void *userdata;
+    Uint32 update_frames;
+};
+
+struct APP_RenderStats {
+    Uint64 frames;
+    int freq;
+    double audio_ms;
+    // Wall time for the whole render, the updates included.
+    double render_ms;
+    // Seconds of audio per second of rendering.
+    double realtime_factor;
+    double update_ms;
+    // The mixer's own times, see struct APP_MixerStats. As of its last
+    // stats update, which may be a few blocks before the end.
+    double mix_ms;
+    double stream_ms;
+    double decode_ms;
+    double resample_ms;
+    double voice_ms;
+    double effects_ms;
+    double master_ms;
+    Uint32 peak_voices;
+    float limiter_reduction_db;
+    // The loudest sample that came out.
+    float peak;
+};
+
+// Interleaved stereo float.
+struct APP_RenderBuffer {
+    float *samples;
+    Uint64 frames;
+    int freq;
+};
+
+// Differences from a reference render.
+struct APP_RenderComparison {
+    Uint64 frames;
+    // Frames the reference has more, negative when the render is longer.
+    Sint64 length_difference;
+    float peak_difference;
+    // Reference against the difference, 0 when there is no difference.
+    double snr_db;
+    bool identical;
+};
+
+// The mixer must not have a device open. Both return false when they
+// couldn't allocate or write, what was rendered up to then is kept.
+bool APP_Render_ToMemory(
+        struct APP_Mixer *mixer,
+        const struct APP_RenderDesc *desc,
+        struct APP_RenderBuffer *out_buffer,
+        struct APP_RenderStats *out_stats
+);
+// Writes 32 bit float stereo as it renders, the sizes in the header are
+// filled in at the end so io has to be seekable. Doesn't close io.
+bool APP_Render_ToWAV(
+        struct APP_Mixer *mixer,
+        const struct APP_RenderDesc *desc,
+        SDL_IOStream *io,
+        struct APP_RenderStats *out_stats
+);
+void APP_Render_FreeBuffer(struct APP_RenderBuffer *buffer);
+
+bool APP_Render_WriteWAV(const struct APP_RenderBuffer *buffer, SDL_IOStream *io);
+// The reference is any WAV SDL loads, converted to the buffer's rate and
+// float stereo first. Doesn't close reference.
+bool APP_Render_Compare(
+        const struct APP_RenderBuffer *buffer,
+        SDL_IOStream *reference,
+        struct APP_RenderComparison *out_comparison
+);
+
+#endif
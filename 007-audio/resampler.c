@@ -0,0 +1,426 @@
+#include "resampler.h"
+
+#if defined(SDL_SSE_INTRINSICS)
+#define APP_RESAMPLER_SSE
+#endif
+#if defined(SDL_NEON_INTRINSICS)
+#define APP_RESAMPLER_NEON
+#endif
+
+#define APP_RESAMPLER_FRACTION_SCALE (1.0f / 4294967296.0f)
+
+// The fraction of a position picks one of the phases by its top bits, the
+// rest interpolates towards the next one.
+#define APP_RESAMPLER_PHASE_BITS 7
+#define APP_RESAMPLER_PHASES (1 << APP_RESAMPLER_PHASE_BITS)
+#define APP_RESAMPLER_PHASE_SHIFT (32 - APP_RESAMPLER_PHASE_BITS)
+#define APP_RESAMPLER_PHASE_SCALE (1.0f / (float)(1u << APP_RESAMPLER_PHASE_SHIFT))
+
+// Steps up to each of these share one cutoff.
+static const float APP_RESAMPLER_BAND_STEPS[] = { 1.0f, 1.1f, 1.25f, 1.5f, 2.0f, 2.5f, 3.0f, 4.0f, 6.0f, (float)APP_RESAMPLER_MAX_STEP };
+#define APP_RESAMPLER_BANDS SDL_arraysize(APP_RESAMPLER_BAND_STEPS)
+
+struct APP_SincDesc {
+    const char *name;
+    Uint32 taps;
+    // Kaiser window, higher is less ripple and a wider transition.
+    float beta;
+    // Cutoff as a share of the Nyquist frequency.
+    float rolloff;
+};
+
+static const struct APP_SincDesc APP_RESAMPLER_QUALITIES[APP_RESAMPLE_QUALITY_COUNT] = {
+    { "linear", 2, 0.0f, 1.0f },
+    { "fast", 8, 5.0f, 0.80f },
+    { "medium", 16, 7.0f, 0.88f },
+    { "best", APP_RESAMPLER_MAX_TAPS, 9.0f, 0.94f },
+};
+
+// One band of one quality: taps coefficients for each phase plus one more
+// phase to interpolate towards, and the difference to that next phase.
+struct APP_SincTable {
+    Uint32 taps;
+    float *coeffs;
+    float *deltas;
+};
+
+typedef void (*APP_SincFunc)(const struct APP_SincTable *table, float *dst, const float *src, Uint64 position, Uint64 step, Uint32 count);
+typedef void (*APP_LinearFunc)(float *dst, const float *src, Uint64 position, Uint64 step, Uint32 count);
+
+struct APP_Resampler {
+    APP_SincFunc sinc;
+    APP_LinearFunc linear;
+    struct APP_SincTable tables[APP_RESAMPLE_QUALITY_COUNT][APP_RESAMPLER_BANDS];
+    float *memory;
+};
+
+// ============================================================================
+// Kernels
+// ============================================================================
+
+static void
+APP_Linear_Scalar(float *dst, const float *src, Uint64 position, Uint64 step, Uint32 count)
+{
+    for (Uint32 i = 0; i < count; ++i)
+    {
+        const float *s = src + (position >> 32);
+        float t = (float)(Uint32)position * APP_RESAMPLER_FRACTION_SCALE;
+        dst[i] = s[0] + (s[1] - s[0]) * t;
+        position += step;
+    }
+}
+
+static void
+APP_Sinc_Scalar(const struct APP_SincTable *table, float *dst, const float *src, Uint64 position, Uint64 step, Uint32 count)
+{
+    const Uint32 taps = table->taps;
+    const Uint32 before = taps / 2 - 1;
+
+    for (Uint32 i = 0; i < count; ++i)
+    {
+        const float *s = src + (position >> 32) - before;
+        Uint32 fraction = (Uint32)position;
+        Uint32 phase = fraction >> APP_RESAMPLER_PHASE_SHIFT;
+        float t = (float)(fraction & ((1u << APP_RESAMPLER_PHASE_SHIFT) - 1)) * APP_RESAMPLER_PHASE_SCALE;
+
+        const float *c = table->coeffs + phase * taps;
+        const float *d = table->deltas + phase * taps;
+
+        float sum = 0.0f;
+        for (Uint32 k = 0; k < taps; ++k)
+        {
+            sum += s[k] * (c[k] + d[k] * t);
+        }
+
+        dst[i] = sum;
+        position += step;
+    }
+}
+
+#ifdef APP_RESAMPLER_SSE
+// Note(john): There is no gather before AVX2, the four frame pairs are
+// loaded one by one and only the interpolation runs four wide.
+SDL_TARGETING("sse") static void
+APP_Linear_SSE(float *dst, const float *src, Uint64 position, Uint64 step, Uint32 count)
+{
+    const __m128 scale = _mm_set1_ps(APP_RESAMPLER_FRACTION_SCALE);
+
+    Uint32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        Uint64 p0 = position;
+        Uint64 p1 = p0 + step;
+        Uint64 p2 = p1 + step;
+        Uint64 p3 = p2 + step;
+        const float *s0 = src + (p0 >> 32);
+        const float *s1 = src + (p1 >> 32);
+        const float *s2 = src + (p2 >> 32);
+        const float *s3 = src + (p3 >> 32);
+
+        __m128 a = _mm_setr_ps(s0[0], s1[0], s2[0], s3[0]);
+        __m128 b = _mm_setr_ps(s0[1], s1[1], s2[1], s3[1]);
+        __m128 t = _mm_mul_ps(
+                _mm_setr_ps((float)(Uint32)p0, (float)(Uint32)p1, (float)(Uint32)p2, (float)(Uint32)p3),
+                scale
+        );
+
+        _mm_storeu_ps(dst + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t)));
+        position = p3 + step;
+    }
+
+    APP_Linear_Scalar(dst + i, src, position, step, count - i);
+}
+
+// The taps run four wide, the tables are aligned and a multiple of four.
+SDL_TARGETING("sse") static void
+APP_Sinc_SSE(const struct APP_SincTable *table, float *dst, const float *src, Uint64 position, Uint64 step, Uint32 count)
+{
+    const Uint32 taps = table->taps;
+    const Uint32 before = taps / 2 - 1;
+
+    for (Uint32 i = 0; i < count; ++i)
+    {
+        const float *s = src + (position >> 32) - before;
+        Uint32 fraction = (Uint32)position;
+        Uint32 phase = fraction >> APP_RESAMPLER_PHASE_SHIFT;
+        __m128 t = _mm_set1_ps((float)(fraction & ((1u << APP_RESAMPLER_PHASE_SHIFT) - 1)) * APP_RESAMPLER_PHASE_SCALE);
+
+        const float *c = table->coeffs + phase * taps;
+        const float *d = table->deltas + phase * taps;
+
+        __m128 sum = _mm_setzero_ps();
+        for (Uint32 k = 0; k < taps; k += 4)
+        {
+            __m128 coeff = _mm_add_ps(_mm_load_ps(c + k), _mm_mul_ps(_mm_load_ps(d + k), t));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(s + k), coeff));
+        }
+
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+        _mm_store_ss(dst + i, sum);
+        position += step;
+    }
+}
+#endif
+
+#ifdef APP_RESAMPLER_NEON
+static void
+APP_Linear_NEON(float *dst, const float *src, Uint64 position, Uint64 step, Uint32 count)
+{
+    const float32x4_t scale = vdupq_n_f32(APP_RESAMPLER_FRACTION_SCALE);
+
+    Uint32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        float a[4], b[4], t[4];
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const float *s = src + (position >> 32);
+            a[lane] = s[0];
+            b[lane] = s[1];
+            t[lane] = (float)(Uint32)position;
+            position += step;
+        }
+
+        float32x4_t va = vld1q_f32(a);
+        float32x4_t vt = vmulq_f32(vld1q_f32(t), scale);
+        vst1q_f32(dst + i, vmlaq_f32(va, vsubq_f32(vld1q_f32(b), va), vt));
+    }
+
+    APP_Linear_Scalar(dst + i, src, position, step, count - i);
+}
+
+static void
+APP_Sinc_NEON(const struct APP_SincTable *table, float *dst, const float *src, Uint64 position, Uint64 step, Uint32 count)
+{
+    const Uint32 taps = table->taps;
+    const Uint32 before = taps / 2 - 1;
+
+    for (Uint32 i = 0; i < count; ++i)
+    {
+        const float *s = src + (position >> 32) - before;
+        Uint32 fraction = (Uint32)position;
+        Uint32 phase = fraction >> APP_RESAMPLER_PHASE_SHIFT;
+        float t = (float)(fraction & ((1u << APP_RESAMPLER_PHASE_SHIFT) - 1)) * APP_RESAMPLER_PHASE_SCALE;
+
+        const float *c = table->coeffs + phase * taps;
+        const float *d = table->deltas + phase * taps;
+
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (Uint32 k = 0; k < taps; k += 4)
+        {
+            float32x4_t coeff = vmlaq_n_f32(vld1q_f32(c + k), vld1q_f32(d + k), t);
+            sum = vmlaq_f32(sum, vld1q_f32(s + k), coeff);
+        }
+
+        float32x2_t pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+        dst[i] = vget_lane_f32(vpadd_f32(pair, pair), 0);
+        position += step;
+    }
+}
+#endif
+
+// ============================================================================
+// Tables
+// ============================================================================
+
+// Zeroth order modified Bessel function of the first kind, for the window.
+static double
+APP_BesselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double half = x * 0.5;
+
+    for (int k = 1; k < 32; ++k)
+    {
+        term *= half / k;
+        sum += term * term;
+        if (term * term < sum * 1e-12)
+        {
+            break;
+        }
+    }
+
+    return sum;
+}
+
+// Fill every phase of one table. Tap k multiplies the frame at
+// index - (taps / 2 - 1) + k, the position lies fraction frames after index.
+static void
+APP_Resampler_BuildTable(struct APP_SincTable *table, const struct APP_SincDesc *desc, float band_step)
+{
+    const Uint32 taps = desc->taps;
+    const double half = taps * 0.5;
+    // Cycles per source frame.
+    const double cutoff = 0.5 * desc->rolloff / band_step;
+    const double window_scale = 1.0 / APP_BesselI0(desc->beta);
+
+    for (Uint32 phase = 0; phase <= APP_RESAMPLER_PHASES; ++phase)
+    {
+        double fraction = (double)phase / APP_RESAMPLER_PHASES;
+        float *c = table->coeffs + phase * taps;
+        double sum = 0.0;
+
+        for (Uint32 k = 0; k < taps; ++k)
+        {
+            double x = (double)k - (half - 1.0) - fraction;
+            double sinc = x == 0.0 ? 1.0 : SDL_sin(2.0 * SDL_PI_D * cutoff * x) / (2.0 * SDL_PI_D * cutoff * x);
+            double w = x / half;
+            double window = SDL_fabs(w) >= 1.0 ? 0.0 : APP_BesselI0(desc->beta * SDL_sqrt(1.0 - w * w)) * window_scale;
+
+            c[k] = (float)(sinc * window);
+            sum += c[k];
+        }
+
+        // Note(john): Every phase passes DC at exactly 1, otherwise a steady
+        // signal picks up a ripple at the rate the phases change.
+        for (Uint32 k = 0; k < taps; ++k)
+        {
+            c[k] = (float)(c[k] / sum);
+        }
+    }
+
+    for (Uint32 phase = 0; phase < APP_RESAMPLER_PHASES; ++phase)
+    {
+        for (Uint32 k = 0; k < taps; ++k)
+        {
+            Uint32 i = phase * taps + k;
+            table->deltas[i] = table->coeffs[i + taps] - table->coeffs[i];
+        }
+    }
+}
+
+struct APP_Resampler *
+APP_Resampler_Create(void)
+{
+    struct APP_Resampler *resampler = SDL_calloc(1, sizeof(struct APP_Resampler));
+    if (resampler == NULL)
+    {
+        return NULL;
+    }
+
+    resampler->sinc = APP_Sinc_Scalar;
+    resampler->linear = APP_Linear_Scalar;
+
+#ifdef APP_RESAMPLER_SSE
+    if (SDL_HasSSE())
+    {
+        resampler->sinc = APP_Sinc_SSE;
+        resampler->linear = APP_Linear_SSE;
+    }
+#endif
+#ifdef APP_RESAMPLER_NEON
+    if (SDL_HasNEON())
+    {
+        resampler->sinc = APP_Sinc_NEON;
+        resampler->linear = APP_Linear_NEON;
+    }
+#endif
+
+    // One allocation for every table, each one starts 16 byte aligned.
+    size_t floats = 0;
+    for (int q = APP_RESAMPLE_FAST; q < APP_RESAMPLE_QUALITY_COUNT; ++q)
+    {
+        floats += APP_RESAMPLER_BANDS * (APP_RESAMPLER_PHASES + 1) * APP_RESAMPLER_QUALITIES[q].taps * 2;
+    }
+
+    resampler->memory = SDL_aligned_alloc(16, floats * sizeof(float));
+    if (resampler->memory == NULL)
+    {
+        SDL_free(resampler);
+        return NULL;
+    }
+
+    float *next = resampler->memory;
+    for (int q = APP_RESAMPLE_FAST; q < APP_RESAMPLE_QUALITY_COUNT; ++q)
+    {
+        const struct APP_SincDesc *desc = &APP_RESAMPLER_QUALITIES[q];
+        size_t table_floats = (APP_RESAMPLER_PHASES + 1) * desc->taps;
+
+        for (size_t b = 0; b < APP_RESAMPLER_BANDS; ++b)
+        {
+            struct APP_SincTable *table = &resampler->tables[q][b];
+            table->taps = desc->taps;
+            table->coeffs = next;
+            table->deltas = next + table_floats;
+            next += table_floats * 2;
+
+            APP_Resampler_BuildTable(table, desc, APP_RESAMPLER_BAND_STEPS[b]);
+        }
+    }
+
+    return resampler;
+}
+
+void
+APP_Resampler_Destroy(struct APP_Resampler *resampler)
+{
+    if (resampler == NULL)
+    {
+        return;
+    }
+
+    SDL_aligned_free(resampler->memory);
+    SDL_free(resampler);
+}
+
+const char *
+APP_Resampler_GetQualityName(enum APP_ResampleQuality quality)
+{
+    return APP_RESAMPLER_QUALITIES[quality].name;
+}
+
+bool
+APP_Resampler_ParseQuality(const char *name, enum APP_ResampleQuality *out_quality)
+{
+    for (int q = 0; q < APP_RESAMPLE_QUALITY_COUNT; ++q)
+    {
+        if (SDL_strcmp(name, APP_RESAMPLER_QUALITIES[q].name) == 0)
+        {
+            *out_quality = (enum APP_ResampleQuality)q;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+Uint32
+APP_Resampler_GetTaps(enum APP_ResampleQuality quality)
+{
+    return APP_RESAMPLER_QUALITIES[quality].taps;
+}
+
+void
+APP_Resampler_Process(
+        const struct APP_Resampler *resampler,
+        enum APP_ResampleQuality quality,
+        float *dst,
+        const float *src,
+        Uint64 position,
+        Uint64 step,
+        Uint32 count
+)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (quality == APP_RESAMPLE_LINEAR)
+    {
+        resampler->linear(dst, src, position, step, count);
+        return;
+    }
+
+    // The band with the lowest cutoff the step still needs.
+    float step_frames = (float)step * APP_RESAMPLER_FRACTION_SCALE;
+    size_t band = 0;
+    while (band + 1 < APP_RESAMPLER_BANDS && step_frames > APP_RESAMPLER_BAND_STEPS[band])
+    {
+        ++band;
+    }
+
+    resampler->sinc(&resampler->tables[quality][band], dst, src, position, step, count);
+}
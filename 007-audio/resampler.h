@@ -0,0 +1,49 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <SDL3/SDL.h>
+
+// Sample rate conversion and pitch for the mixer. Above linear every output
+// frame is a Kaiser windowed sinc over the source frames around it. The
+// filter comes from polyphase tables built once, the phases in between are
+// interpolated, so any ratio works and it can change every block. Going
+// down in rate the cutoff goes down with it so nothing aliases.
+
+enum APP_ResampleQuality {
+    APP_RESAMPLE_LINEAR,
+    APP_RESAMPLE_FAST,
+    APP_RESAMPLE_MEDIUM,
+    APP_RESAMPLE_BEST,
+    APP_RESAMPLE_QUALITY_COUNT,
+};
+
+#define APP_RESAMPLER_MAX_TAPS 32
+// The most source frames one output frame may advance, the filter cutoff
+// stops going down there.
+#define APP_RESAMPLER_MAX_STEP 8
+
+struct APP_Resampler;
+
+struct APP_Resampler *APP_Resampler_Create(void);
+void APP_Resampler_Destroy(struct APP_Resampler *resampler);
+
+const char *APP_Resampler_GetQualityName(enum APP_ResampleQuality quality);
+// "linear", "fast", "medium" or "best".
+bool APP_Resampler_ParseQuality(const char *name, enum APP_ResampleQuality *out_quality);
+Uint32 APP_Resampler_GetTaps(enum APP_ResampleQuality quality);
+
+// Writes count frames of src starting at position, advancing by step. Both
+// are 32.32 fixed point frames. For the frame at index the filter reads
+// src[index - (taps / 2 - 1)] up to src[index + taps / 2], all of them have
+// to be there.
+void APP_Resampler_Process(
+        const struct APP_Resampler *resampler,
+        enum APP_ResampleQuality quality,
+        float *dst,
+        const float *src,
+        Uint64 position,
+        Uint64 step,
+        Uint32 count
+);
+
+#endif
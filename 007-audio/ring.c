@@ -0,0 +1,100 @@
+#include "ring.h"
+
+struct APP_Ring {
+    Uint32 item_size;
+    Uint32 mask;
+    Uint8 *items;
+
+    // Free running, the producer only writes write_pos and the consumer only
+    // read_pos. The difference is the number of queued items.
+    SDL_AtomicInt write_pos;
+    SDL_AtomicInt read_pos;
+};
+
+struct APP_Ring *
+APP_Ring_Create(Uint32 item_size, Uint32 capacity)
+{
+    Uint32 size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+
+    struct APP_Ring *ring = SDL_calloc(1, sizeof(struct APP_Ring));
+    if (ring == NULL)
+    {
+        return NULL;
+    }
+
+    ring->items = SDL_malloc((size_t)item_size * size);
+    if (ring->items == NULL)
+    {
+        SDL_free(ring);
+        return NULL;
+    }
+
+    ring->item_size = item_size;
+    ring->mask = size - 1;
+    return ring;
+}
+
+void
+APP_Ring_Destroy(struct APP_Ring *ring)
+{
+    if (ring == NULL)
+    {
+        return;
+    }
+
+    SDL_free(ring->items);
+    SDL_free(ring);
+}
+
+bool
+APP_Ring_Push(struct APP_Ring *ring, const void *item)
+{
+    Uint32 write = (Uint32)SDL_GetAtomicInt(&ring->write_pos);
+    Uint32 read = (Uint32)SDL_GetAtomicInt(&ring->read_pos);
+
+    if (write - read > ring->mask)
+    {
+        return false;
+    }
+
+    SDL_memcpy(ring->items + (size_t)(write & ring->mask) * ring->item_size, item, ring->item_size);
+
+    // Note(john): The atomic store orders the copy before it, the consumer
+    // never sees the new position without the item.
+    SDL_SetAtomicInt(&ring->write_pos, (int)(write + 1));
+    return true;
+}
+
+bool
+APP_Ring_Pop(struct APP_Ring *ring, void *out_item)
+{
+    Uint32 read = (Uint32)SDL_GetAtomicInt(&ring->read_pos);
+    Uint32 write = (Uint32)SDL_GetAtomicInt(&ring->write_pos);
+
+    if (read == write)
+    {
+        return false;
+    }
+
+    SDL_memcpy(out_item, ring->items + (size_t)(read & ring->mask) * ring->item_size, ring->item_size);
+    SDL_SetAtomicInt(&ring->read_pos, (int)(read + 1));
+    return true;
+}
+
+Uint32
+APP_Ring_GetCount(struct APP_Ring *ring)
+{
+    Uint32 write = (Uint32)SDL_GetAtomicInt(&ring->write_pos);
+    Uint32 read = (Uint32)SDL_GetAtomicInt(&ring->read_pos);
+    return write - read;
+}
+
+Uint32
+APP_Ring_GetCapacity(const struct APP_Ring *ring)
+{
+    return ring->mask + 1;
+}
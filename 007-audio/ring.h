@@ -0,0 +1,25 @@
+#ifndef RING_H
+#define RING_H
+
+#include <SDL3/SDL.h>
+
+// Fixed size items passed from one thread to exactly one other. Push and pop
+// never lock, never allocate and never wait on the other side, each is a
+// copy, two atomic loads and one atomic store.
+
+struct APP_Ring;
+
+// capacity is rounded up to a power of two.
+struct APP_Ring *APP_Ring_Create(Uint32 item_size, Uint32 capacity);
+void APP_Ring_Destroy(struct APP_Ring *ring);
+
+// Producer thread only. False when the ring is full, the item isn't queued.
+bool APP_Ring_Push(struct APP_Ring *ring, const void *item);
+// Consumer thread only. False when the ring is empty.
+bool APP_Ring_Pop(struct APP_Ring *ring, void *out_item);
+
+// Either thread, a snapshot that may be stale by the time it returns.
+Uint32 APP_Ring_GetCount(struct APP_Ring *ring);
+Uint32 APP_Ring_GetCapacity(const struct APP_Ring *ring);
+
+#endif
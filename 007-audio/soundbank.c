@@ -0,0 +1,488 @@
+#include "soundbank.h"
+
+enum APP_BankEntryState {
+    APP_BANK_ENTRY_FREE,
+    APP_BANK_ENTRY_QUEUED,
+    APP_BANK_ENTRY_LOADING,
+    APP_BANK_ENTRY_RESIDENT,
+    // Kept so the load isn't tried again every time the sound is asked for.
+    APP_BANK_ENTRY_FAILED,
+};
+
+struct APP_BankEntry {
+    enum APP_BankEntryState state;
+    char name[APP_SOUNDBANK_MAX_NAME];
+    Uint32 hash;
+    struct APP_Sound sound;
+    Uint64 bytes;
+    // Acquires not released yet.
+    Uint32 refs;
+    // Bank clock at the last acquire, or when it was queued.
+    Uint64 last_used;
+};
+
+struct APP_SoundBank {
+    struct APP_Pack *pack;
+    Uint64 budget_bytes;
+
+    // Everything below and the entries are guarded by the lock, the loader
+    // only works on an entry without it while the entry is loading.
+    SDL_Mutex *lock;
+    SDL_Condition *wake;
+    SDL_Condition *loaded;
+    SDL_Thread *thread;
+    bool quit;
+
+    struct APP_BankEntry entries[APP_SOUNDBANK_MAX_SOUNDS];
+    Uint64 clock;
+    Uint64 resident_bytes;
+    Uint64 high_water_bytes;
+
+    Uint32 hits;
+    Uint32 misses;
+    Uint32 joined_loads;
+    Uint32 loads;
+    Uint32 failed_loads;
+    Uint32 evictions;
+    double load_ms;
+};
+
+static struct APP_BankEntry *
+APP_FindEntry(struct APP_SoundBank *bank, const char *name, Uint32 hash)
+{
+    for (Uint32 i = 0; i < APP_SOUNDBANK_MAX_SOUNDS; ++i)
+    {
+        struct APP_BankEntry *entry = &bank->entries[i];
+        if (entry->state != APP_BANK_ENTRY_FREE && entry->hash == hash && SDL_strcmp(entry->name, name) == 0)
+        {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+APP_EvictEntry(struct APP_SoundBank *bank, struct APP_BankEntry *entry)
+{
+    APP_Sound_Free(&entry->sound);
+    bank->resident_bytes -= entry->bytes;
+    ++bank->evictions;
+    SDL_zerop(entry);
+}
+
+// The resident entry nothing holds that was used the longest time ago.
+static struct APP_BankEntry *
+APP_LeastRecentlyUsed(struct APP_SoundBank *bank, const struct APP_BankEntry *keep)
+{
+    struct APP_BankEntry *oldest = NULL;
+
+    for (Uint32 i = 0; i < APP_SOUNDBANK_MAX_SOUNDS; ++i)
+    {
+        struct APP_BankEntry *entry = &bank->entries[i];
+        if (entry == keep || entry->state != APP_BANK_ENTRY_RESIDENT || entry->refs > 0)
+        {
+            continue;
+        }
+
+        if (oldest == NULL || entry->last_used < oldest->last_used)
+        {
+            oldest = entry;
+        }
+    }
+
+    return oldest;
+}
+
+// Evict down to the budget, keep is spared. Held sounds can leave the bank
+// over its budget until they are released.
+static void
+APP_MakeRoom(struct APP_SoundBank *bank, const struct APP_BankEntry *keep)
+{
+    while (bank->budget_bytes > 0 && bank->resident_bytes > bank->budget_bytes)
+    {
+        struct APP_BankEntry *entry = APP_LeastRecentlyUsed(bank, keep);
+        if (entry == NULL)
+        {
+            return;
+        }
+
+        SDL_Log("INFO: Sound bank evicted %s, %llu KB", entry->name, (unsigned long long)(entry->bytes / 1024));
+        APP_EvictEntry(bank, entry);
+    }
+}
+
+// The entry for the name, queued for loading when the bank didn't have it.
+// NULL when every entry is taken and none can be evicted.
+static struct APP_BankEntry *
+APP_QueueEntry(struct APP_SoundBank *bank, const char *name)
+{
+    Uint32 hash = APP_Pack_Hash(name, SDL_strlen(name));
+    struct APP_BankEntry *entry = APP_FindEntry(bank, name, hash);
+
+    if (entry != NULL)
+    {
+        if (entry->state == APP_BANK_ENTRY_QUEUED || entry->state == APP_BANK_ENTRY_LOADING)
+        {
+            ++bank->joined_loads;
+        }
+
+        return entry;
+    }
+
+    if (SDL_strlen(name) >= APP_SOUNDBANK_MAX_NAME)
+    {
+        SDL_Log("ERROR: Sound name too long: %s", name);
+        return NULL;
+    }
+
+    for (Uint32 i = 0; i < APP_SOUNDBANK_MAX_SOUNDS && entry == NULL; ++i)
+    {
+        if (bank->entries[i].state == APP_BANK_ENTRY_FREE)
+        {
+            entry = &bank->entries[i];
+        }
+    }
+
+    // Note(john): A failed entry only saves retrying its load, it goes
+    // before any sound. Otherwise enough bad names would fill the bank.
+    for (Uint32 i = 0; i < APP_SOUNDBANK_MAX_SOUNDS && entry == NULL; ++i)
+    {
+        if (bank->entries[i].state == APP_BANK_ENTRY_FAILED && bank->entries[i].refs == 0)
+        {
+            entry = &bank->entries[i];
+            SDL_zerop(entry);
+        }
+    }
+
+    if (entry == NULL)
+    {
+        entry = APP_LeastRecentlyUsed(bank, NULL);
+        if (entry == NULL)
+        {
+            SDL_Log("ERROR: Sound bank is full, can't load %s", name);
+            return NULL;
+        }
+
+        APP_EvictEntry(bank, entry);
+    }
+
+    SDL_strlcpy(entry->name, name, sizeof(entry->name));
+    entry->hash = hash;
+    entry->state = APP_BANK_ENTRY_QUEUED;
+    entry->last_used = ++bank->clock;
+
+    SDL_SignalCondition(bank->wake);
+    return entry;
+}
+
+static SDL_IOStream *
+APP_OpenSound(struct APP_SoundBank *bank, const char *name)
+{
+    SDL_IOStream *io = APP_Pack_OpenIO(bank->pack, name);
+    if (io != NULL)
+    {
+        return io;
+    }
+
+    return SDL_IOFromFile(name, "rb");
+}
+
+// The loader thread. Takes queued entries in the order they were queued.
+static int
+APP_SoundBank_Loader(void *data)
+{
+    struct APP_SoundBank *bank = data;
+
+    SDL_LockMutex(bank->lock);
+
+    while (!bank->quit)
+    {
+        struct APP_BankEntry *entry = NULL;
+
+        for (Uint32 i = 0; i < APP_SOUNDBANK_MAX_SOUNDS; ++i)
+        {
+            struct APP_BankEntry *candidate = &bank->entries[i];
+            if (candidate->state == APP_BANK_ENTRY_QUEUED && (entry == NULL || candidate->last_used < entry->last_used))
+            {
+                entry = candidate;
+            }
+        }
+
+        if (entry == NULL)
+        {
+            SDL_WaitCondition(bank->wake, bank->lock);
+            continue;
+        }
+
+        entry->state = APP_BANK_ENTRY_LOADING;
+        SDL_UnlockMutex(bank->lock);
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        struct APP_Sound sound;
+        bool ok = APP_Sound_LoadWAV(APP_OpenSound(bank, entry->name), &sound);
+        double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+            / (double)SDL_GetPerformanceFrequency();
+
+        SDL_LockMutex(bank->lock);
+        bank->load_ms += ms;
+
+        if (ok)
+        {
+            entry->sound = sound;
+            entry->bytes = APP_Sound_GetSize(&sound);
+            entry->state = APP_BANK_ENTRY_RESIDENT;
+
+            ++bank->loads;
+            bank->resident_bytes += entry->bytes;
+            bank->high_water_bytes = SDL_max(bank->high_water_bytes, bank->resident_bytes);
+            APP_MakeRoom(bank, entry);
+        }
+        else
+        {
+            SDL_Log("ERROR: Sound bank couldn't load %s", entry->name);
+            entry->state = APP_BANK_ENTRY_FAILED;
+            ++bank->failed_loads;
+        }
+
+        SDL_BroadcastCondition(bank->loaded);
+    }
+
+    SDL_UnlockMutex(bank->lock);
+    return 0;
+}
+
+struct APP_SoundBank *
+APP_SoundBank_Create(struct APP_Pack *pack, Uint64 budget_bytes)
+{
+    struct APP_SoundBank *bank = SDL_calloc(1, sizeof(struct APP_SoundBank));
+    if (bank == NULL)
+    {
+        return NULL;
+    }
+
+    bank->pack = pack;
+    bank->budget_bytes = budget_bytes;
+    bank->lock = SDL_CreateMutex();
+    bank->wake = SDL_CreateCondition();
+    bank->loaded = SDL_CreateCondition();
+
+    if (bank->lock == NULL || bank->wake == NULL || bank->loaded == NULL)
+    {
+        SDL_Log("ERROR: Failed to create sound bank lock. %s", SDL_GetError());
+        APP_SoundBank_Destroy(bank);
+        return NULL;
+    }
+
+    bank->thread = SDL_CreateThread(APP_SoundBank_Loader, "Sound Bank", bank);
+    if (bank->thread == NULL)
+    {
+        SDL_Log("ERROR: Failed to create sound bank thread. %s", SDL_GetError());
+        APP_SoundBank_Destroy(bank);
+        return NULL;
+    }
+
+    return bank;
+}
+
+void
+APP_SoundBank_Destroy(struct APP_SoundBank *bank)
+{
+    if (bank == NULL)
+    {
+        return;
+    }
+
+    if (bank->thread != NULL)
+    {
+        SDL_LockMutex(bank->lock);
+        bank->quit = true;
+        SDL_SignalCondition(bank->wake);
+        SDL_UnlockMutex(bank->lock);
+
+        SDL_WaitThread(bank->thread, NULL);
+    }
+
+    for (Uint32 i = 0; i < APP_SOUNDBANK_MAX_SOUNDS; ++i)
+    {
+        APP_Sound_Free(&bank->entries[i].sound);
+    }
+
+    SDL_DestroyCondition(bank->loaded);
+    SDL_DestroyCondition(bank->wake);
+    SDL_DestroyMutex(bank->lock);
+    SDL_free(bank);
+}
+
+const struct APP_Sound *
+APP_SoundBank_Acquire(struct APP_SoundBank *bank, const char *name, bool wait)
+{
+    SDL_LockMutex(bank->lock);
+
+    struct APP_BankEntry *entry = APP_QueueEntry(bank, name);
+    const struct APP_Sound *sound = NULL;
+
+    if (entry != NULL)
+    {
+        if (entry->state == APP_BANK_ENTRY_RESIDENT)
+        {
+            ++bank->hits;
+        }
+        else
+        {
+            ++bank->misses;
+        }
+
+        // Note(john): Held while waiting so the entry can't be evicted or
+        // reused for another name in between.
+        ++entry->refs;
+
+        while (wait && (entry->state == APP_BANK_ENTRY_QUEUED || entry->state == APP_BANK_ENTRY_LOADING))
+        {
+            SDL_WaitCondition(bank->loaded, bank->lock);
+        }
+
+        if (entry->state == APP_BANK_ENTRY_RESIDENT)
+        {
+            entry->last_used = ++bank->clock;
+            sound = &entry->sound;
+        }
+        else
+        {
+            --entry->refs;
+        }
+    }
+
+    SDL_UnlockMutex(bank->lock);
+    return sound;
+}
+
+void
+APP_SoundBank_Release(struct APP_SoundBank *bank, const struct APP_Sound *sound)
+{
+    if (sound == NULL)
+    {
+        return;
+    }
+
+    SDL_LockMutex(bank->lock);
+
+    for (Uint32 i = 0; i < APP_SOUNDBANK_MAX_SOUNDS; ++i)
+    {
+        struct APP_BankEntry *entry = &bank->entries[i];
+        if (&entry->sound == sound && entry->refs > 0)
+        {
+            --entry->refs;
+            APP_MakeRoom(bank, NULL);
+            break;
+        }
+    }
+
+    SDL_UnlockMutex(bank->lock);
+}
+
+void
+APP_SoundBank_Preload(struct APP_SoundBank *bank, const char *const *names, Uint32 count)
+{
+    SDL_LockMutex(bank->lock);
+
+    for (Uint32 i = 0; i < count; ++i)
+    {
+        APP_QueueEntry(bank, names[i]);
+    }
+
+    SDL_UnlockMutex(bank->lock);
+}
+
+bool
+APP_SoundBank_PreloadList(struct APP_SoundBank *bank, const char *list_name)
+{
+    size_t size = 0;
+    void *owned = NULL;
+    const char *text = APP_Pack_Read(bank->pack, list_name, &size, &owned);
+
+    if (text == NULL)
+    {
+        text = owned = SDL_LoadFile(list_name, &size);
+        if (text == NULL)
+        {
+            SDL_Log("ERROR: Could not read sound bank list %s", list_name);
+            return false;
+        }
+    }
+
+    Uint32 count = 0;
+    size_t line = 0;
+
+    while (line < size)
+    {
+        size_t end = line;
+        while (end < size && text[end] != '\n')
+        {
+            ++end;
+        }
+
+        // Trim the comment, then the white space around the name.
+        size_t stop = line;
+        while (stop < end && text[stop] != '#')
+        {
+            ++stop;
+        }
+
+        size_t first = line;
+        while (first < stop && SDL_isspace(text[first]))
+        {
+            ++first;
+        }
+
+        while (stop > first && SDL_isspace(text[stop - 1]))
+        {
+            --stop;
+        }
+
+        if (stop > first && stop - first < APP_SOUNDBANK_MAX_NAME)
+        {
+            char name[APP_SOUNDBANK_MAX_NAME];
+            SDL_memcpy(name, text + first, stop - first);
+            name[stop - first] = '\0';
+
+            const char *names[1] = { name };
+            APP_SoundBank_Preload(bank, names, 1);
+            ++count;
+        }
+
+        line = end + 1;
+    }
+
+    SDL_free(owned);
+    SDL_Log("INFO: Preloading %u sounds from %s", count, list_name);
+    return true;
+}
+
+void
+APP_SoundBank_GetStats(struct APP_SoundBank *bank, struct APP_SoundBankStats *out_stats)
+{
+    SDL_zerop(out_stats);
+
+    SDL_LockMutex(bank->lock);
+
+    for (Uint32 i = 0; i < APP_SOUNDBANK_MAX_SOUNDS; ++i)
+    {
+        enum APP_BankEntryState state = bank->entries[i].state;
+        out_stats->sound_count += state == APP_BANK_ENTRY_RESIDENT ? 1 : 0;
+        out_stats->pending_loads += state == APP_BANK_ENTRY_QUEUED || state == APP_BANK_ENTRY_LOADING ? 1 : 0;
+    }
+
+    out_stats->resident_bytes = bank->resident_bytes;
+    out_stats->high_water_bytes = bank->high_water_bytes;
+    out_stats->budget_bytes = bank->budget_bytes;
+    out_stats->hits = bank->hits;
+    out_stats->misses = bank->misses;
+    out_stats->joined_loads = bank->joined_loads;
+    out_stats->loads = bank->loads;
+    out_stats->failed_loads = bank->failed_loads;
+    out_stats->evictions = bank->evictions;
+    out_stats->load_ms = bank->load_ms;
+
+    SDL_UnlockMutex(bank->lock);
+}
@@ -0,0 +1,58 @@
+#ifndef SOUNDBANK_H
+#define SOUNDBANK_H
+
+#include "mixer.h"
+#include "pack.h"
+
+// Sounds by asset name, loaded once and shared by everything that plays
+// them. Loads run on a loader thread; asking for a sound that is already on
+// its way joins that load instead of starting another. Under the memory
+// budget the least recently used sounds nothing holds are evicted.
+//
+// All calls are safe from any thread.
+
+#define APP_SOUNDBANK_MAX_SOUNDS 256
+#define APP_SOUNDBANK_MAX_NAME 128
+
+struct APP_SoundBankStats {
+    Uint32 sound_count;
+    Uint32 pending_loads;
+    Uint64 resident_bytes;
+    Uint64 high_water_bytes;
+    // 0 for no budget.
+    Uint64 budget_bytes;
+
+    // Acquires that found the sound resident and those that didn't.
+    Uint32 hits;
+    Uint32 misses;
+    // Acquires and preloads that joined a load already queued or running.
+    Uint32 joined_loads;
+    Uint32 loads;
+    Uint32 failed_loads;
+    Uint32 evictions;
+    double load_ms;
+};
+
+struct APP_SoundBank;
+
+// Assets come from the pack, or as loose files relative to the working
+// directory when the pack doesn't have them. The pack may be NULL.
+struct APP_SoundBank *APP_SoundBank_Create(struct APP_Pack *pack, Uint64 budget_bytes);
+void APP_SoundBank_Destroy(struct APP_SoundBank *bank);
+
+// The sound, held until it is released, evicting never takes it while
+// held. Not resident yet, with wait it blocks until the load finished,
+// without the load is queued and NULL returned. NULL as well when the
+// sound can't be loaded.
+const struct APP_Sound *APP_SoundBank_Acquire(struct APP_SoundBank *bank, const char *name, bool wait);
+void APP_SoundBank_Release(struct APP_SoundBank *bank, const struct APP_Sound *sound);
+
+// Queue loads for the sounds that aren't resident, returns right away.
+void APP_SoundBank_Preload(struct APP_SoundBank *bank, const char *const *names, Uint32 count);
+// A bank declared in an asset: one sound name per line, # starts a
+// comment.
+bool APP_SoundBank_PreloadList(struct APP_SoundBank *bank, const char *list_name);
+
+void APP_SoundBank_GetStats(struct APP_SoundBank *bank, struct APP_SoundBankStats *out_stats);
+
+#endif
@@ -0,0 +1,755 @@
+#include "spatial.h"
+
+#if defined(SDL_SSE_INTRINSICS)
+#define APP_SPATIAL_SSE
+#endif
+#if defined(SDL_NEON_INTRINSICS)
+#define APP_SPATIAL_NEON
+#endif
+
+// Keeps the pass from dividing by zero for an emitter right on the listener.
+#define APP_SPATIAL_MIN_DISTANCE 0.0001f
+// Faster than this along the line to the listener doppler stops following.
+#define APP_SPATIAL_MAX_RADIAL_SPEED (APP_SPATIAL_SPEED_OF_SOUND * 0.5f)
+
+// Structure of arrays, padded to a multiple of four emitters. Unused
+// emitters have gain 0 so the pass needs no test for them.
+struct APP_EmitterArrays {
+    float *position_x;
+    float *position_y;
+    float *position_z;
+    float *velocity_x;
+    float *velocity_y;
+    float *velocity_z;
+    float *gain;
+    float *min_distance;
+    float *max_distance;
+
+    // What the pass computed.
+    float *out_gain;
+    float *out_pan;
+    float *out_pitch;
+};
+
+#define APP_EMITTER_ARRAY_COUNT 12
+
+// The listener as the pass needs it.
+struct APP_ListenerFrame {
+    float position[3];
+    float velocity[3];
+    float right[3];
+};
+
+typedef void (*APP_SpatialFunc)(
+        const struct APP_EmitterArrays *arrays,
+        const struct APP_ListenerFrame *listener,
+        Uint32 first,
+        Uint32 count
+);
+
+struct APP_Emitter {
+    bool active;
+    // A sound that doesn't loop played out.
+    bool done;
+    bool loop;
+    const struct APP_Sound *sound;
+    // Spatial clock when it started playing.
+    double start_time;
+    // Picked for a voice. The voice comes at the end of the update, the
+    // picks change while the update runs.
+    bool real;
+    APP_VoiceID voice;
+    // Index in the real list while real.
+    Uint32 real_index;
+};
+
+struct APP_Spatial {
+    struct APP_Mixer *mixer;
+    APP_SpatialFunc pass;
+    APP_SpatialFunc simd_pass;
+
+    struct APP_EmitterArrays arrays;
+    void *array_memory;
+    struct APP_Emitter *emitters;
+    Uint32 capacity;
+    // Emitters in use are all below this, rounded up to four.
+    Uint32 used;
+    Uint32 *free_emitters;
+    Uint32 free_count;
+
+    struct APP_ListenerFrame listener;
+    double clock;
+    // Where the pass starts next update.
+    Uint32 cursor;
+
+    Uint32 *real;
+    Uint32 real_count;
+    Uint32 max_voices;
+
+    Uint32 promotions;
+    Uint32 demotions;
+    Uint32 failed_promotions;
+    Uint32 updates;
+    double update_ms;
+    double max_update_ms;
+};
+
+// ============================================================================
+// Kernels
+// ============================================================================
+
+static void
+APP_SpatialPass_Scalar(
+        const struct APP_EmitterArrays *arrays,
+        const struct APP_ListenerFrame *listener,
+        Uint32 first,
+        Uint32 count
+)
+{
+    for (Uint32 i = first; i < first + count; ++i)
+    {
+        float dx = arrays->position_x[i] - listener->position[0];
+        float dy = arrays->position_y[i] - listener->position[1];
+        float dz = arrays->position_z[i] - listener->position[2];
+        float distance = SDL_max(SDL_sqrtf(dx * dx + dy * dy + dz * dz), APP_SPATIAL_MIN_DISTANCE);
+        float inverse = 1.0f / distance;
+
+        float min_distance = arrays->min_distance[i];
+        float max_distance = arrays->max_distance[i];
+        float attenuation = min_distance / SDL_max(distance, min_distance);
+        float fade = (max_distance - distance) / SDL_max(max_distance - min_distance, APP_SPATIAL_MIN_DISTANCE);
+        arrays->out_gain[i] = arrays->gain[i] * attenuation * SDL_clamp(fade, 0.0f, 1.0f);
+
+        float side = (dx * listener->right[0] + dy * listener->right[1] + dz * listener->right[2]) * inverse;
+        arrays->out_pan[i] = SDL_clamp(side, -1.0f, 1.0f);
+
+        // Positive when the listener moves toward the emitter and when the
+        // emitter moves away from the listener.
+        float listener_speed = (dx * listener->velocity[0] + dy * listener->velocity[1] + dz * listener->velocity[2]) * inverse;
+        float emitter_speed = (dx * arrays->velocity_x[i] + dy * arrays->velocity_y[i] + dz * arrays->velocity_z[i]) * inverse;
+        listener_speed = SDL_clamp(listener_speed, -APP_SPATIAL_MAX_RADIAL_SPEED, APP_SPATIAL_MAX_RADIAL_SPEED);
+        emitter_speed = SDL_clamp(emitter_speed, -APP_SPATIAL_MAX_RADIAL_SPEED, APP_SPATIAL_MAX_RADIAL_SPEED);
+
+        float pitch = (APP_SPATIAL_SPEED_OF_SOUND + listener_speed) / (APP_SPATIAL_SPEED_OF_SOUND + emitter_speed);
+        arrays->out_pitch[i] = SDL_clamp(pitch, APP_SPATIAL_MIN_PITCH, APP_SPATIAL_MAX_PITCH);
+    }
+}
+
+#ifdef APP_SPATIAL_SSE
+// first and count are multiples of four, the arrays are aligned.
+SDL_TARGETING("sse") static void
+APP_SpatialPass_SSE(
+        const struct APP_EmitterArrays *arrays,
+        const struct APP_ListenerFrame *listener,
+        Uint32 first,
+        Uint32 count
+)
+{
+    const __m128 lx = _mm_set1_ps(listener->position[0]);
+    const __m128 ly = _mm_set1_ps(listener->position[1]);
+    const __m128 lz = _mm_set1_ps(listener->position[2]);
+    const __m128 lvx = _mm_set1_ps(listener->velocity[0]);
+    const __m128 lvy = _mm_set1_ps(listener->velocity[1]);
+    const __m128 lvz = _mm_set1_ps(listener->velocity[2]);
+    const __m128 rx = _mm_set1_ps(listener->right[0]);
+    const __m128 ry = _mm_set1_ps(listener->right[1]);
+    const __m128 rz = _mm_set1_ps(listener->right[2]);
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 min_distance_floor = _mm_set1_ps(APP_SPATIAL_MIN_DISTANCE);
+    const __m128 speed_of_sound = _mm_set1_ps(APP_SPATIAL_SPEED_OF_SOUND);
+    const __m128 max_speed = _mm_set1_ps(APP_SPATIAL_MAX_RADIAL_SPEED);
+    const __m128 min_speed = _mm_set1_ps(-APP_SPATIAL_MAX_RADIAL_SPEED);
+    const __m128 min_pitch = _mm_set1_ps(APP_SPATIAL_MIN_PITCH);
+    const __m128 max_pitch = _mm_set1_ps(APP_SPATIAL_MAX_PITCH);
+
+    for (Uint32 i = first; i < first + count; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_load_ps(arrays->position_x + i), lx);
+        __m128 dy = _mm_sub_ps(_mm_load_ps(arrays->position_y + i), ly);
+        __m128 dz = _mm_sub_ps(_mm_load_ps(arrays->position_z + i), lz);
+        __m128 distance_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        __m128 distance = _mm_max_ps(_mm_sqrt_ps(distance_sq), min_distance_floor);
+        __m128 inverse = _mm_div_ps(one, distance);
+
+        __m128 min_distance = _mm_load_ps(arrays->min_distance + i);
+        __m128 max_distance = _mm_load_ps(arrays->max_distance + i);
+        __m128 attenuation = _mm_div_ps(min_distance, _mm_max_ps(distance, min_distance));
+        __m128 range = _mm_max_ps(_mm_sub_ps(max_distance, min_distance), min_distance_floor);
+        __m128 fade = _mm_div_ps(_mm_sub_ps(max_distance, distance), range);
+        fade = _mm_min_ps(_mm_max_ps(fade, zero), one);
+        __m128 gain = _mm_mul_ps(_mm_mul_ps(_mm_load_ps(arrays->gain + i), attenuation), fade);
+        _mm_store_ps(arrays->out_gain + i, gain);
+
+        __m128 side = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, rx), _mm_mul_ps(dy, ry)), _mm_mul_ps(dz, rz));
+        side = _mm_mul_ps(side, inverse);
+        _mm_store_ps(arrays->out_pan + i, _mm_min_ps(_mm_max_ps(side, _mm_sub_ps(zero, one)), one));
+
+        __m128 listener_speed = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, lvx), _mm_mul_ps(dy, lvy)), _mm_mul_ps(dz, lvz));
+        __m128 vx = _mm_load_ps(arrays->velocity_x + i);
+        __m128 vy = _mm_load_ps(arrays->velocity_y + i);
+        __m128 vz = _mm_load_ps(arrays->velocity_z + i);
+        __m128 emitter_speed = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, vx), _mm_mul_ps(dy, vy)), _mm_mul_ps(dz, vz));
+        listener_speed = _mm_min_ps(_mm_max_ps(_mm_mul_ps(listener_speed, inverse), min_speed), max_speed);
+        emitter_speed = _mm_min_ps(_mm_max_ps(_mm_mul_ps(emitter_speed, inverse), min_speed), max_speed);
+
+        __m128 pitch = _mm_div_ps(_mm_add_ps(speed_of_sound, listener_speed), _mm_add_ps(speed_of_sound, emitter_speed));
+        _mm_store_ps(arrays->out_pitch + i, _mm_min_ps(_mm_max_ps(pitch, min_pitch), max_pitch));
+    }
+}
+#endif
+
+#ifdef APP_SPATIAL_NEON
+// Note(john): 32 bit ARM has no vector divide or square root, both come
+// from the estimates refined twice, close enough for gains and pitch.
+static float32x4_t
+APP_Reciprocal_NEON(float32x4_t x)
+{
+    float32x4_t r = vrecpeq_f32(x);
+    r = vmulq_f32(r, vrecpsq_f32(x, r));
+    return vmulq_f32(r, vrecpsq_f32(x, r));
+}
+
+static float32x4_t
+APP_ReciprocalSqrt_NEON(float32x4_t x)
+{
+    float32x4_t r = vrsqrteq_f32(x);
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+    return vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+}
+
+static void
+APP_SpatialPass_NEON(
+        const struct APP_EmitterArrays *arrays,
+        const struct APP_ListenerFrame *listener,
+        Uint32 first,
+        Uint32 count
+)
+{
+    const float32x4_t lx = vdupq_n_f32(listener->position[0]);
+    const float32x4_t ly = vdupq_n_f32(listener->position[1]);
+    const float32x4_t lz = vdupq_n_f32(listener->position[2]);
+    const float32x4_t lvx = vdupq_n_f32(listener->velocity[0]);
+    const float32x4_t lvy = vdupq_n_f32(listener->velocity[1]);
+    const float32x4_t lvz = vdupq_n_f32(listener->velocity[2]);
+    const float32x4_t rx = vdupq_n_f32(listener->right[0]);
+    const float32x4_t ry = vdupq_n_f32(listener->right[1]);
+    const float32x4_t rz = vdupq_n_f32(listener->right[2]);
+
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t min_distance_floor = vdupq_n_f32(APP_SPATIAL_MIN_DISTANCE);
+    const float32x4_t speed_of_sound = vdupq_n_f32(APP_SPATIAL_SPEED_OF_SOUND);
+    const float32x4_t max_speed = vdupq_n_f32(APP_SPATIAL_MAX_RADIAL_SPEED);
+    const float32x4_t min_speed = vdupq_n_f32(-APP_SPATIAL_MAX_RADIAL_SPEED);
+    const float32x4_t min_pitch = vdupq_n_f32(APP_SPATIAL_MIN_PITCH);
+    const float32x4_t max_pitch = vdupq_n_f32(APP_SPATIAL_MAX_PITCH);
+
+    for (Uint32 i = first; i < first + count; i += 4)
+    {
+        float32x4_t dx = vsubq_f32(vld1q_f32(arrays->position_x + i), lx);
+        float32x4_t dy = vsubq_f32(vld1q_f32(arrays->position_y + i), ly);
+        float32x4_t dz = vsubq_f32(vld1q_f32(arrays->position_z + i), lz);
+        float32x4_t distance_sq = vmlaq_f32(vmlaq_f32(vmulq_f32(dx, dx), dy, dy), dz, dz);
+        distance_sq = vmaxq_f32(distance_sq, vmulq_f32(min_distance_floor, min_distance_floor));
+        float32x4_t inverse = APP_ReciprocalSqrt_NEON(distance_sq);
+        float32x4_t distance = vmulq_f32(distance_sq, inverse);
+
+        float32x4_t min_distance = vld1q_f32(arrays->min_distance + i);
+        float32x4_t max_distance = vld1q_f32(arrays->max_distance + i);
+        float32x4_t attenuation = vmulq_f32(min_distance, APP_Reciprocal_NEON(vmaxq_f32(distance, min_distance)));
+        float32x4_t range = vmaxq_f32(vsubq_f32(max_distance, min_distance), min_distance_floor);
+        float32x4_t fade = vmulq_f32(vsubq_f32(max_distance, distance), APP_Reciprocal_NEON(range));
+        fade = vminq_f32(vmaxq_f32(fade, zero), one);
+        float32x4_t gain = vmulq_f32(vmulq_f32(vld1q_f32(arrays->gain + i), attenuation), fade);
+        vst1q_f32(arrays->out_gain + i, gain);
+
+        float32x4_t side = vmlaq_f32(vmlaq_f32(vmulq_f32(dx, rx), dy, ry), dz, rz);
+        side = vmulq_f32(side, inverse);
+        vst1q_f32(arrays->out_pan + i, vminq_f32(vmaxq_f32(side, vnegq_f32(one)), one));
+
+        float32x4_t listener_speed = vmlaq_f32(vmlaq_f32(vmulq_f32(dx, lvx), dy, lvy), dz, lvz);
+        float32x4_t vx = vld1q_f32(arrays->velocity_x + i);
+        float32x4_t vy = vld1q_f32(arrays->velocity_y + i);
+        float32x4_t vz = vld1q_f32(arrays->velocity_z + i);
+        float32x4_t emitter_speed = vmlaq_f32(vmlaq_f32(vmulq_f32(dx, vx), dy, vy), dz, vz);
+        listener_speed = vminq_f32(vmaxq_f32(vmulq_f32(listener_speed, inverse), min_speed), max_speed);
+        emitter_speed = vminq_f32(vmaxq_f32(vmulq_f32(emitter_speed, inverse), min_speed), max_speed);
+
+        float32x4_t pitch = vmulq_f32(
+                vaddq_f32(speed_of_sound, listener_speed),
+                APP_Reciprocal_NEON(vaddq_f32(speed_of_sound, emitter_speed))
+        );
+        vst1q_f32(arrays->out_pitch + i, vminq_f32(vmaxq_f32(pitch, min_pitch), max_pitch));
+    }
+}
+#endif
+
+// ============================================================================
+// Emitters
+// ============================================================================
+
+struct APP_Spatial *
+APP_Spatial_Create(struct APP_Mixer *mixer, Uint32 max_emitters, Uint32 max_voices)
+{
+    struct APP_Spatial *spatial = SDL_calloc(1, sizeof(struct APP_Spatial));
+    if (spatial == NULL)
+    {
+        return NULL;
+    }
+
+    Uint32 capacity = (SDL_max(max_emitters, 1u) + 3) & ~3u;
+
+    spatial->mixer = mixer;
+    spatial->capacity = capacity;
+    spatial->max_voices = SDL_clamp(max_voices, 1u, (Uint32)APP_MIXER_MAX_VOICES);
+    spatial->array_memory = SDL_aligned_alloc(16, sizeof(float) * capacity * APP_EMITTER_ARRAY_COUNT);
+    spatial->emitters = SDL_calloc(capacity, sizeof(struct APP_Emitter));
+    spatial->free_emitters = SDL_malloc(sizeof(Uint32) * capacity);
+    spatial->real = SDL_malloc(sizeof(Uint32) * spatial->max_voices);
+
+    if (spatial->array_memory == NULL || spatial->emitters == NULL || spatial->free_emitters == NULL || spatial->real == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate %u emitters.", capacity);
+        APP_Spatial_Destroy(spatial);
+        return NULL;
+    }
+
+    float *memory = spatial->array_memory;
+    SDL_memset(memory, 0, sizeof(float) * capacity * APP_EMITTER_ARRAY_COUNT);
+
+    float **arrays[APP_EMITTER_ARRAY_COUNT] = {
+        &spatial->arrays.position_x,
+        &spatial->arrays.position_y,
+        &spatial->arrays.position_z,
+        &spatial->arrays.velocity_x,
+        &spatial->arrays.velocity_y,
+        &spatial->arrays.velocity_z,
+        &spatial->arrays.gain,
+        &spatial->arrays.min_distance,
+        &spatial->arrays.max_distance,
+        &spatial->arrays.out_gain,
+        &spatial->arrays.out_pan,
+        &spatial->arrays.out_pitch,
+    };
+
+    for (Uint32 i = 0; i < APP_EMITTER_ARRAY_COUNT; ++i)
+    {
+        *arrays[i] = memory + (size_t)capacity * i;
+    }
+
+    // Hand out the lowest emitters first so the pass covers few.
+    for (Uint32 i = 0; i < capacity; ++i)
+    {
+        spatial->free_emitters[i] = capacity - 1 - i;
+    }
+
+    spatial->free_count = capacity;
+
+    spatial->pass = APP_SpatialPass_Scalar;
+#ifdef APP_SPATIAL_SSE
+    if (SDL_HasSSE())
+    {
+        spatial->pass = APP_SpatialPass_SSE;
+    }
+#endif
+#ifdef APP_SPATIAL_NEON
+    if (SDL_HasNEON())
+    {
+        spatial->pass = APP_SpatialPass_NEON;
+    }
+#endif
+    spatial->simd_pass = spatial->pass;
+
+    struct APP_Listener listener = {
+        { 0.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, -1.0f },
+        { 0.0f, 1.0f, 0.0f },
+    };
+    APP_Spatial_SetListener(spatial, &listener);
+
+    return spatial;
+}
+
+void
+APP_Spatial_Destroy(struct APP_Spatial *spatial)
+{
+    if (spatial == NULL)
+    {
+        return;
+    }
+
+    for (Uint32 i = 0; i < spatial->real_count; ++i)
+    {
+        APP_VoiceID voice = spatial->emitters[spatial->real[i]].voice;
+        if (voice != 0)
+        {
+            APP_Mixer_Stop(spatial->mixer, voice);
+        }
+    }
+
+    SDL_aligned_free(spatial->array_memory);
+    SDL_free(spatial->emitters);
+    SDL_free(spatial->free_emitters);
+    SDL_free(spatial->real);
+    SDL_free(spatial);
+}
+
+void
+APP_Spatial_SetListener(struct APP_Spatial *spatial, const struct APP_Listener *listener)
+{
+    struct APP_Vector3 right = APP_Vector3_Cross(listener->forward, listener->up);
+    float length = SDL_sqrtf(APP_Vector3_Dot(right, right));
+    if (length > 0.0f)
+    {
+        right = APP_VECTOR3_Normalize(right);
+    }
+
+    struct APP_ListenerFrame *frame = &spatial->listener;
+    frame->position[0] = listener->position.x;
+    frame->position[1] = listener->position.y;
+    frame->position[2] = listener->position.z;
+    frame->velocity[0] = listener->velocity.x;
+    frame->velocity[1] = listener->velocity.y;
+    frame->velocity[2] = listener->velocity.z;
+    frame->right[0] = right.x;
+    frame->right[1] = right.y;
+    frame->right[2] = right.z;
+}
+
+static Uint32
+APP_Spatial_EmitterIndex(const struct APP_Spatial *spatial, APP_EmitterID id)
+{
+    Uint32 index = id - 1;
+    return id == 0 || index >= spatial->capacity || !spatial->emitters[index].active ? spatial->capacity : index;
+}
+
+APP_EmitterID
+APP_Spatial_AddEmitter(struct APP_Spatial *spatial, const struct APP_EmitterDesc *desc)
+{
+    if (spatial->free_count == 0 || desc->sound == NULL || desc->sound->frame_count == 0)
+    {
+        return 0;
+    }
+
+    Uint32 index = spatial->free_emitters[--spatial->free_count];
+    struct APP_Emitter *emitter = &spatial->emitters[index];
+    SDL_zerop(emitter);
+    emitter->active = true;
+    emitter->loop = desc->loop;
+    emitter->sound = desc->sound;
+    emitter->start_time = spatial->clock;
+
+    struct APP_EmitterArrays *arrays = &spatial->arrays;
+    arrays->gain[index] = SDL_max(desc->gain, 0.0f);
+    arrays->min_distance[index] = SDL_max(desc->min_distance, APP_SPATIAL_MIN_DISTANCE);
+    arrays->max_distance[index] = SDL_max(desc->max_distance, arrays->min_distance[index]);
+    arrays->out_gain[index] = 0.0f;
+    spatial->used = SDL_max(spatial->used, (index + 4) & ~3u);
+
+    APP_EmitterID id = index + 1;
+    APP_Spatial_MoveEmitter(spatial, id, desc->position, desc->velocity);
+    return id;
+}
+
+// The emitter gives its voice back if it had one yet, the last real one
+// takes its place in the list.
+static void
+APP_Spatial_Demote(struct APP_Spatial *spatial, Uint32 index)
+{
+    struct APP_Emitter *emitter = &spatial->emitters[index];
+
+    if (emitter->voice != 0)
+    {
+        APP_Mixer_Stop(spatial->mixer, emitter->voice);
+        emitter->voice = 0;
+        ++spatial->demotions;
+    }
+
+    emitter->real = false;
+
+    Uint32 last = spatial->real[--spatial->real_count];
+    spatial->real[emitter->real_index] = last;
+    spatial->emitters[last].real_index = emitter->real_index;
+}
+
+void
+APP_Spatial_RemoveEmitter(struct APP_Spatial *spatial, APP_EmitterID id)
+{
+    Uint32 index = APP_Spatial_EmitterIndex(spatial, id);
+    if (index == spatial->capacity)
+    {
+        return;
+    }
+
+    if (spatial->emitters[index].real)
+    {
+        APP_Spatial_Demote(spatial, index);
+    }
+
+    spatial->emitters[index].active = false;
+    spatial->arrays.gain[index] = 0.0f;
+    spatial->arrays.out_gain[index] = 0.0f;
+    spatial->free_emitters[spatial->free_count++] = index;
+}
+
+void
+APP_Spatial_MoveEmitter(
+        struct APP_Spatial *spatial,
+        APP_EmitterID id,
+        struct APP_Vector3 position,
+        struct APP_Vector3 velocity
+)
+{
+    Uint32 index = APP_Spatial_EmitterIndex(spatial, id);
+    if (index == spatial->capacity)
+    {
+        return;
+    }
+
+    struct APP_EmitterArrays *arrays = &spatial->arrays;
+    arrays->position_x[index] = position.x;
+    arrays->position_y[index] = position.y;
+    arrays->position_z[index] = position.z;
+    arrays->velocity_x[index] = velocity.x;
+    arrays->velocity_y[index] = velocity.y;
+    arrays->velocity_z[index] = velocity.z;
+}
+
+// ============================================================================
+// Voices
+// ============================================================================
+
+// Where the emitter's sound is on the spatial clock. Virtual emitters don't
+// follow their doppler pitch, only real ones would be heard doing so.
+static Uint64
+APP_Spatial_PlaybackFrame(const struct APP_Spatial *spatial, const struct APP_Emitter *emitter)
+{
+    double seconds = spatial->clock - emitter->start_time;
+    return (Uint64)(seconds * (double)emitter->sound->freq);
+}
+
+// The gain an emitter competes for a voice with, 0 when it can't have one.
+static float
+APP_Spatial_Audibility(struct APP_Spatial *spatial, Uint32 index)
+{
+    struct APP_Emitter *emitter = &spatial->emitters[index];
+    if (!emitter->active || emitter->done)
+    {
+        return 0.0f;
+    }
+
+    if (!emitter->loop && APP_Spatial_PlaybackFrame(spatial, emitter) >= emitter->sound->frame_count)
+    {
+        emitter->done = true;
+        return 0.0f;
+    }
+
+    float gain = spatial->arrays.out_gain[index];
+    return gain >= APP_SPATIAL_AUDIBLE_GAIN ? gain : 0.0f;
+}
+
+static void
+APP_Spatial_Pick(struct APP_Spatial *spatial, Uint32 index)
+{
+    struct APP_Emitter *emitter = &spatial->emitters[index];
+    emitter->real = true;
+    emitter->real_index = spatial->real_count;
+    spatial->real[spatial->real_count++] = index;
+}
+
+// Start the voice of a picked emitter, it stays virtual when the mixer has
+// none left.
+static void
+APP_Spatial_Promote(struct APP_Spatial *spatial, Uint32 index)
+{
+    struct APP_Emitter *emitter = &spatial->emitters[index];
+    struct APP_VoiceParams params = {
+        spatial->arrays.out_gain[index],
+        spatial->arrays.out_pan[index],
+        spatial->arrays.out_pitch[index],
+        emitter->loop,
+    };
+
+    emitter->voice = APP_Mixer_PlayFrom(spatial->mixer, emitter->sound, &params, APP_Spatial_PlaybackFrame(spatial, emitter));
+    if (emitter->voice == 0)
+    {
+        ++spatial->failed_promotions;
+        APP_Spatial_Demote(spatial, index);
+        return;
+    }
+
+    ++spatial->promotions;
+}
+
+// The real emitter that is quietest right now.
+static Uint32
+APP_Spatial_QuietestReal(struct APP_Spatial *spatial, float *out_gain)
+{
+    Uint32 quietest = 0;
+    *out_gain = 0.0f;
+
+    for (Uint32 i = 0; i < spatial->real_count; ++i)
+    {
+        float gain = spatial->arrays.out_gain[spatial->real[i]];
+        if (i == 0 || gain < *out_gain)
+        {
+            *out_gain = gain;
+            quietest = spatial->real[i];
+        }
+    }
+
+    return quietest;
+}
+
+void
+APP_Spatial_Update(struct APP_Spatial *spatial, float dt)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    spatial->clock += (double)dt;
+
+    // The next window of emitters through the batched pass.
+    Uint32 window = SDL_min(spatial->used, (Uint32)APP_SPATIAL_UPDATE_EMITTERS);
+    if (spatial->cursor >= spatial->used)
+    {
+        spatial->cursor = 0;
+    }
+
+    Uint32 first = spatial->cursor;
+    Uint32 first_count = SDL_min(window, spatial->used - first);
+    spatial->pass(&spatial->arrays, &spatial->listener, first, first_count);
+    spatial->pass(&spatial->arrays, &spatial->listener, 0, window - first_count);
+    spatial->cursor = first + window;
+
+    // The real ones are heard, they are always up to date.
+    for (Uint32 i = 0; i < spatial->real_count; ++i)
+    {
+        APP_SpatialPass_Scalar(&spatial->arrays, &spatial->listener, spatial->real[i], 1);
+    }
+
+    for (Uint32 i = 0; i < spatial->real_count;)
+    {
+        Uint32 index = spatial->real[i];
+        if (APP_Spatial_Audibility(spatial, index) == 0.0f)
+        {
+            // The last real one moves into this slot.
+            APP_Spatial_Demote(spatial, index);
+            continue;
+        }
+
+        ++i;
+    }
+
+    float quietest_gain = 0.0f;
+    Uint32 quietest = APP_Spatial_QuietestReal(spatial, &quietest_gain);
+
+    for (Uint32 n = 0; n < window; ++n)
+    {
+        Uint32 index = (first + n) % spatial->used;
+        if (spatial->emitters[index].real)
+        {
+            continue;
+        }
+
+        float gain = APP_Spatial_Audibility(spatial, index);
+        if (gain == 0.0f)
+        {
+            continue;
+        }
+
+        if (spatial->real_count < spatial->max_voices)
+        {
+            APP_Spatial_Pick(spatial, index);
+            quietest = APP_Spatial_QuietestReal(spatial, &quietest_gain);
+        }
+        else if (gain > quietest_gain * APP_SPATIAL_HYSTERESIS)
+        {
+            APP_Spatial_Demote(spatial, quietest);
+            APP_Spatial_Pick(spatial, index);
+            quietest = APP_Spatial_QuietestReal(spatial, &quietest_gain);
+        }
+    }
+
+    // Only now the voices change, an emitter picked and dropped again in
+    // the same update never gets one.
+    for (Uint32 i = 0; i < spatial->real_count;)
+    {
+        Uint32 index = spatial->real[i];
+        struct APP_Emitter *emitter = &spatial->emitters[index];
+
+        if (emitter->voice == 0)
+        {
+            // A failed one leaves the list, the last one moves here.
+            APP_Spatial_Promote(spatial, index);
+            if (!emitter->real)
+            {
+                continue;
+            }
+        }
+        else
+        {
+            struct APP_VoiceParams params = {
+                spatial->arrays.out_gain[index],
+                spatial->arrays.out_pan[index],
+                spatial->arrays.out_pitch[index],
+                emitter->loop,
+            };
+
+            APP_Mixer_SetParams(spatial->mixer, emitter->voice, &params);
+        }
+
+        ++i;
+    }
+
+    double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+        / (double)SDL_GetPerformanceFrequency();
+    ++spatial->updates;
+    spatial->update_ms += ms;
+    spatial->max_update_ms = SDL_max(spatial->max_update_ms, ms);
+}
+
+double
+APP_Spatial_MeasurePass(struct APP_Spatial *spatial, bool simd, Uint32 rounds)
+{
+    APP_SpatialFunc pass = simd ? spatial->simd_pass : APP_SpatialPass_Scalar;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (Uint32 i = 0; i < rounds; ++i)
+    {
+        pass(&spatial->arrays, &spatial->listener, 0, spatial->used);
+    }
+
+    double us = (double)(SDL_GetPerformanceCounter() - start) * 1e6
+        / (double)SDL_GetPerformanceFrequency();
+    return us > 0.0 ? (double)spatial->used * rounds / us : 0.0;
+}
+
+void
+APP_Spatial_GetStats(struct APP_Spatial *spatial, struct APP_SpatialStats *out_stats)
+{
+    SDL_zerop(out_stats);
+
+    for (Uint32 i = 0; i < spatial->used; ++i)
+    {
+        const struct APP_Emitter *emitter = &spatial->emitters[i];
+        out_stats->emitters += emitter->active ? 1 : 0;
+        out_stats->audible += emitter->active && !emitter->done && spatial->arrays.out_gain[i] >= APP_SPATIAL_AUDIBLE_GAIN ? 1 : 0;
+    }
+
+    out_stats->real = spatial->real_count;
+    out_stats->virtual_emitters = out_stats->emitters - spatial->real_count;
+    out_stats->promotions = spatial->promotions;
+    out_stats->demotions = spatial->demotions;
+    out_stats->failed_promotions = spatial->failed_promotions;
+    out_stats->mean_update_ms = spatial->updates > 0 ? spatial->update_ms / spatial->updates : 0.0;
+    out_stats->max_update_ms = spatial->max_update_ms;
+
+    spatial->promotions = 0;
+    spatial->demotions = 0;
+    spatial->failed_promotions = 0;
+    spatial->updates = 0;
+    spatial->update_ms = 0.0;
+    spatial->max_update_ms = 0.0;
+}
@@ -0,0 +1,96 @@
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include "math.h"
+#include "mixer.h"
+
+// Sounds placed in the world around one listener. Distance attenuation,
+// pan and doppler pitch of the emitters are computed in one batched pass,
+// four emitters at a time with SSE or NEON. Only the APP_Spatial_Create
+// max_voices loudest emitters get a mixer voice, the others are virtual:
+// they keep their playback position on the spatial clock and start there
+// when they become loud enough again.
+//
+// Each update runs the pass over at most APP_SPATIAL_UPDATE_EMITTERS
+// emitters and over the ones with voices, so the cost stays the same
+// however many emitters there are. With more of them it takes a few updates
+// for a new emitter to be heard.
+
+#define APP_SPATIAL_UPDATE_EMITTERS 4096
+#define APP_SPATIAL_SPEED_OF_SOUND 343.0f
+// Emitters quieter than this never get a voice, -60 dB.
+#define APP_SPATIAL_AUDIBLE_GAIN 0.001f
+// A virtual emitter has to be this much louder than the quietest one with a
+// voice to take its voice, so two emitters at about the same gain don't
+// swap every update.
+#define APP_SPATIAL_HYSTERESIS 1.25f
+#define APP_SPATIAL_MIN_PITCH 0.5f
+#define APP_SPATIAL_MAX_PITCH 2.0f
+
+// 0 is never a valid emitter.
+typedef Uint32 APP_EmitterID;
+
+struct APP_Listener {
+    struct APP_Vector3 position;
+    struct APP_Vector3 velocity;
+    struct APP_Vector3 forward;
+    struct APP_Vector3 up;
+};
+
+struct APP_EmitterDesc {
+    // Stays loaded while the emitter exists.
+    const struct APP_Sound *sound;
+    struct APP_Vector3 position;
+    struct APP_Vector3 velocity;
+    float gain;
+    // Full gain up to the min distance, then falling off with the inverse
+    // of the distance and fading out to silence at the max distance.
+    float min_distance;
+    float max_distance;
+    bool loop;
+};
+
+struct APP_SpatialStats {
+    Uint32 emitters;
+    Uint32 audible;
+    Uint32 real;
+    Uint32 virtual_emitters;
+    // Since the last call.
+    Uint32 promotions;
+    Uint32 demotions;
+    // Promotions the mixer had no voice for.
+    Uint32 failed_promotions;
+    double mean_update_ms;
+    double max_update_ms;
+};
+
+struct APP_Spatial;
+
+struct APP_Spatial *APP_Spatial_Create(struct APP_Mixer *mixer, Uint32 max_emitters, Uint32 max_voices);
+void APP_Spatial_Destroy(struct APP_Spatial *spatial);
+
+void APP_Spatial_SetListener(struct APP_Spatial *spatial, const struct APP_Listener *listener);
+
+// The emitter starts playing at once, virtual until the next update gives
+// it a voice. Returns 0 when every emitter is taken. IDs are reused after
+// an emitter is removed.
+APP_EmitterID APP_Spatial_AddEmitter(struct APP_Spatial *spatial, const struct APP_EmitterDesc *desc);
+void APP_Spatial_RemoveEmitter(struct APP_Spatial *spatial, APP_EmitterID emitter);
+void APP_Spatial_MoveEmitter(
+        struct APP_Spatial *spatial,
+        APP_EmitterID emitter,
+        struct APP_Vector3 position,
+        struct APP_Vector3 velocity
+);
+
+// Once per game frame. Advances the spatial clock, updates the voices and
+// hands them to the loudest emitters.
+void APP_Spatial_Update(struct APP_Spatial *spatial, float dt);
+
+// Emitters per microsecond through the batched pass alone, with the SIMD
+// kernel or without.
+double APP_Spatial_MeasurePass(struct APP_Spatial *spatial, bool simd, Uint32 rounds);
+
+void APP_Spatial_GetStats(struct APP_Spatial *spatial, struct APP_SpatialStats *out_stats);
+
+#endif
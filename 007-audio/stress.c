@@ -0,0 +1,174 @@
+#include "stress.h"
+
+// Commands posted per update, more than the ring holds so it fills up
+// when the audio thread falls behind.
+#define STRESS_BURST 1500
+// Leaves room in the pool for the music and the extra voices.
+#define STRESS_MAX_LIVE (APP_MIXER_MAX_VOICES - 32)
+// How long the voices have to come back once the time is up.
+#define STRESS_DRAIN_MS 2000
+
+struct APP_Stress {
+    struct APP_Mixer *mixer;
+    const struct APP_Sound *sound;
+    Uint64 start;
+    Uint64 end;
+
+    // Started and not back yet.
+    APP_VoiceID live[STRESS_MAX_LIVE];
+    Uint32 live_count;
+
+    Uint64 posted;
+    Uint32 started;
+    Uint32 finished;
+    // Finished events for voices the test didn't have live.
+    Uint32 unexpected;
+    Uint32 late_blocks_before;
+    Uint32 dropped_before;
+};
+
+struct APP_Stress *
+APP_Stress_Create(struct APP_Mixer *mixer, const struct APP_Sound *sound, double seconds)
+{
+    struct APP_Stress *stress = SDL_calloc(1, sizeof(struct APP_Stress));
+    if (stress == NULL)
+    {
+        return NULL;
+    }
+
+    struct APP_MixerStats stats;
+    APP_Mixer_GetStats(mixer, &stats);
+
+    stress->mixer = mixer;
+    stress->sound = sound;
+    stress->start = SDL_GetTicks();
+    stress->end = stress->start + (Uint64)(seconds * 1000.0);
+    stress->late_blocks_before = stats.late_blocks;
+    stress->dropped_before = stats.dropped_commands;
+
+    SDL_Log("INFO: Stress test for %.1f s, %d commands per update", seconds, STRESS_BURST);
+    return stress;
+}
+
+void
+APP_Stress_Destroy(struct APP_Stress *stress)
+{
+    SDL_free(stress);
+}
+
+static void
+APP_Stress_RandomParams(struct APP_VoiceParams *out_params)
+{
+    out_params->gain = SDL_randf() / (float)STRESS_MAX_LIVE;
+    out_params->pan = SDL_randf() * 2.0f - 1.0f;
+    out_params->pitch = 0.25f + SDL_randf() * 3.0f;
+    out_params->loop = SDL_rand(2) == 0;
+}
+
+static void
+APP_Stress_Post(struct APP_Stress *stress)
+{
+    struct APP_VoiceParams params;
+    Sint32 action = SDL_rand(3);
+
+    if (action == 0 || stress->live_count == 0)
+    {
+        if (stress->live_count == STRESS_MAX_LIVE)
+        {
+            return;
+        }
+
+        APP_Stress_RandomParams(&params);
+        APP_VoiceID id = APP_Mixer_Play(stress->mixer, stress->sound, &params);
+        if (id != 0)
+        {
+            stress->live[stress->live_count++] = id;
+            ++stress->started;
+        }
+    }
+    else if (action == 1)
+    {
+        APP_Stress_RandomParams(&params);
+        APP_Mixer_SetParams(stress->mixer, stress->live[SDL_rand((Sint32)stress->live_count)], &params);
+    }
+    else
+    {
+        APP_Mixer_Stop(stress->mixer, stress->live[SDL_rand((Sint32)stress->live_count)]);
+    }
+
+    ++stress->posted;
+}
+
+static void
+APP_Stress_LogResult(struct APP_Stress *stress)
+{
+    struct APP_MixerStats stats;
+    APP_Mixer_GetStats(stress->mixer, &stats);
+
+    Uint32 late_blocks = stats.late_blocks - stress->late_blocks_before;
+    bool passed = late_blocks == 0 && stress->unexpected == 0 && stress->live_count == 0;
+
+    SDL_Log(
+            "INFO: Stress test %s: %llu commands, %u dropped, %u voices started, %u finished, %u unexpected, %u never finished, %u late blocks",
+            passed ? "passed" : "FAILED",
+            (unsigned long long)stress->posted,
+            stats.dropped_commands - stress->dropped_before,
+            stress->started,
+            stress->finished,
+            stress->unexpected,
+            stress->live_count,
+            late_blocks
+    );
+}
+
+bool
+APP_Stress_Update(struct APP_Stress *stress)
+{
+    Uint64 now = SDL_GetTicks();
+
+    if (now < stress->end)
+    {
+        for (Uint32 i = 0; i < STRESS_BURST; ++i)
+        {
+            APP_Stress_Post(stress);
+        }
+
+        return true;
+    }
+
+    // Note(john): Stops can be dropped when the ring is full, so every
+    // voice still out gets one again each update until it came back.
+    for (Uint32 i = 0; i < stress->live_count; ++i)
+    {
+        APP_Mixer_Stop(stress->mixer, stress->live[i]);
+    }
+
+    if (stress->live_count > 0 && now < stress->end + STRESS_DRAIN_MS)
+    {
+        return true;
+    }
+
+    APP_Stress_LogResult(stress);
+    return false;
+}
+
+void
+APP_Stress_OnEvent(struct APP_Stress *stress, const struct APP_MixerEvent *event)
+{
+    if (event->type != APP_MIXER_EVENT_VOICE_FINISHED)
+    {
+        return;
+    }
+
+    for (Uint32 i = 0; i < stress->live_count; ++i)
+    {
+        if (stress->live[i] == event->voice)
+        {
+            stress->live[i] = stress->live[--stress->live_count];
+            ++stress->finished;
+            return;
+        }
+    }
+
+    ++stress->unexpected;
+}
@@ -0,0 +1,22 @@
+#ifndef STRESS_H
+#define STRESS_H
+
+#include "mixer.h"
+
+// Hammers the mixer's command ring from the game thread while the device
+// plays: bursts of plays, parameter changes and stops every update. Checks
+// that every voice it started finishes exactly once and counts the blocks
+// the audio thread was late with.
+
+struct APP_Stress;
+
+struct APP_Stress *APP_Stress_Create(struct APP_Mixer *mixer, const struct APP_Sound *sound, double seconds);
+void APP_Stress_Destroy(struct APP_Stress *stress);
+
+// Once per game frame. False once the time is up and the last voice came
+// back, the result is logged then.
+bool APP_Stress_Update(struct APP_Stress *stress);
+// Every event polled from the mixer while the test runs.
+void APP_Stress_OnEvent(struct APP_Stress *stress, const struct APP_MixerEvent *event);
+
+#endif
@@ -0,0 +1,546 @@
+#include "wavstream.h"
+
+#define WAVE_FORMAT_PCM 0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+// How long the I/O thread sleeps when the ring is full and nobody wakes it.
+#define WAVSTREAM_IDLE_MS 50
+
+SDL_COMPILE_TIME_ASSERT(wavstream_ring_pow2, (APP_WAVSTREAM_RING_BYTES & (APP_WAVSTREAM_RING_BYTES - 1)) == 0);
+
+struct APP_WavStream {
+    SDL_IOStream *io;
+    SDL_AudioSpec spec;
+    Uint32 frame_size;
+    Uint64 data_offset;
+    // Whole frames only.
+    Uint64 data_size;
+    Uint64 frame_count;
+
+    Uint8 *ring;
+    // Free running byte counters, written by the I/O thread and by the
+    // audio thread.
+    SDL_AtomicInt write_pos;
+    SDL_AtomicInt read_pos;
+
+    // Published by the I/O thread after a seek: the audio thread skips the
+    // ring to flush_pos, where the samples of flush_frame start.
+    SDL_AtomicInt flush_seq;
+    SDL_AtomicInt flush_pos;
+    SDL_AtomicInt flush_frame;
+
+    // Audio thread.
+    Uint32 seen_flush_seq;
+    Uint64 read_frame;
+    SDL_AtomicInt position;
+    SDL_AtomicInt finished;
+    SDL_AtomicInt underruns;
+
+    // I/O thread.
+    Uint64 file_pos;
+    SDL_AtomicInt ended;
+    SDL_AtomicInt loops;
+    SDL_AtomicInt looping;
+
+    // Seek requests and the read counter, shared by the I/O and game
+    // thread only.
+    SDL_SpinLock lock;
+    bool seek_requested;
+    Uint64 seek_frame;
+    Uint64 streamed_bytes;
+
+    SDL_Thread *thread;
+    SDL_Semaphore *wake;
+    SDL_AtomicInt quit;
+};
+
+// ====================
+// Header
+// ====================
+
+static bool
+APP_WavStream_ReadFormat(struct APP_WavStream *stream, Uint32 chunk_size)
+{
+    Uint16 format_tag, channels, block_align, bits;
+    Uint32 freq, byte_rate;
+
+    if (chunk_size < 16
+        || !SDL_ReadU16LE(stream->io, &format_tag)
+        || !SDL_ReadU16LE(stream->io, &channels)
+        || !SDL_ReadU32LE(stream->io, &freq)
+        || !SDL_ReadU32LE(stream->io, &byte_rate)
+        || !SDL_ReadU16LE(stream->io, &block_align)
+        || !SDL_ReadU16LE(stream->io, &bits))
+    {
+        return false;
+    }
+
+    Uint32 consumed = 16;
+
+    // The sub format of an extensible WAV starts with the format tag.
+    if (format_tag == WAVE_FORMAT_EXTENSIBLE && chunk_size >= 40)
+    {
+        Uint16 extension_size, valid_bits;
+        Uint32 channel_mask;
+
+        if (!SDL_ReadU16LE(stream->io, &extension_size)
+            || !SDL_ReadU16LE(stream->io, &valid_bits)
+            || !SDL_ReadU32LE(stream->io, &channel_mask)
+            || !SDL_ReadU16LE(stream->io, &format_tag))
+        {
+            return false;
+        }
+
+        consumed += 10;
+    }
+
+    if (format_tag == WAVE_FORMAT_PCM && bits == 8)
+    {
+        stream->spec.format = SDL_AUDIO_U8;
+    }
+    else if (format_tag == WAVE_FORMAT_PCM && bits == 16)
+    {
+        stream->spec.format = SDL_AUDIO_S16LE;
+    }
+    else if (format_tag == WAVE_FORMAT_PCM && bits == 32)
+    {
+        stream->spec.format = SDL_AUDIO_S32LE;
+    }
+    else if (format_tag == WAVE_FORMAT_IEEE_FLOAT && bits == 32)
+    {
+        stream->spec.format = SDL_AUDIO_F32LE;
+    }
+    else
+    {
+        SDL_Log("ERROR: Unsupported WAV format %#x with %u bits.", format_tag, bits);
+        return false;
+    }
+
+    if (channels == 0 || channels > 8 || freq == 0 || block_align != channels * (bits / 8))
+    {
+        SDL_Log("ERROR: Invalid WAV format, %u channels at %u Hz.", channels, freq);
+        return false;
+    }
+
+    stream->spec.channels = channels;
+    stream->spec.freq = (int)freq;
+    stream->frame_size = block_align;
+
+    // Chunks are padded to an even size.
+    Uint32 skip = chunk_size - consumed + (chunk_size & 1);
+    return SDL_SeekIO(stream->io, skip, SDL_IO_SEEK_CUR) >= 0;
+}
+
+// Find the format and the samples, the data chunk has to come after the
+// format chunk.
+static bool
+APP_WavStream_ReadHeader(struct APP_WavStream *stream)
+{
+    Uint32 riff, riff_size, wave;
+
+    if (!SDL_ReadU32LE(stream->io, &riff)
+        || !SDL_ReadU32LE(stream->io, &riff_size)
+        || !SDL_ReadU32LE(stream->io, &wave)
+        || riff != SDL_FOURCC('R', 'I', 'F', 'F')
+        || wave != SDL_FOURCC('W', 'A', 'V', 'E'))
+    {
+        SDL_Log("ERROR: Not a WAV file.");
+        return false;
+    }
+
+    bool has_format = false;
+    Sint64 file_size = SDL_GetIOSize(stream->io);
+
+    for (;;)
+    {
+        Uint32 id, chunk_size;
+        if (!SDL_ReadU32LE(stream->io, &id) || !SDL_ReadU32LE(stream->io, &chunk_size))
+        {
+            SDL_Log("ERROR: WAV file without samples.");
+            return false;
+        }
+
+        if (id == SDL_FOURCC('f', 'm', 't', ' '))
+        {
+            if (!APP_WavStream_ReadFormat(stream, chunk_size))
+            {
+                return false;
+            }
+
+            has_format = true;
+        }
+        else if (id == SDL_FOURCC('d', 'a', 't', 'a'))
+        {
+            if (!has_format)
+            {
+                SDL_Log("ERROR: WAV samples before the format.");
+                return false;
+            }
+
+            stream->data_offset = (Uint64)SDL_TellIO(stream->io);
+            stream->data_size = chunk_size;
+
+            // Note(john): Recorders that were cut off leave the size open,
+            // the samples go up to the end of the file then.
+            if (file_size > 0 && stream->data_offset + stream->data_size > (Uint64)file_size)
+            {
+                stream->data_size = (Uint64)file_size - stream->data_offset;
+            }
+
+            stream->data_size -= stream->data_size % stream->frame_size;
+            stream->frame_count = stream->data_size / stream->frame_size;
+
+            if (stream->frame_count == 0)
+            {
+                SDL_Log("ERROR: WAV file without samples.");
+                return false;
+            }
+
+            return true;
+        }
+        else if (SDL_SeekIO(stream->io, (Sint64)chunk_size + (chunk_size & 1), SDL_IO_SEEK_CUR) < 0)
+        {
+            return false;
+        }
+    }
+}
+
+// ====================
+// I/O thread
+// ====================
+
+static void
+APP_WavStream_ApplySeek(struct APP_WavStream *stream)
+{
+    SDL_LockSpinlock(&stream->lock);
+    bool requested = stream->seek_requested;
+    Uint64 frame = stream->seek_frame;
+    stream->seek_requested = false;
+    SDL_UnlockSpinlock(&stream->lock);
+
+    if (!requested)
+    {
+        return;
+    }
+
+    if (frame >= stream->frame_count)
+    {
+        frame = 0;
+    }
+
+    stream->file_pos = frame * stream->frame_size;
+    SDL_SeekIO(stream->io, (Sint64)(stream->data_offset + stream->file_pos), SDL_IO_SEEK_SET);
+    SDL_SetAtomicInt(&stream->ended, 0);
+
+    // Everything written so far is from before the seek.
+    SDL_SetAtomicInt(&stream->flush_pos, SDL_GetAtomicInt(&stream->write_pos));
+    SDL_SetAtomicInt(&stream->flush_frame, (int)frame);
+    SDL_AddAtomicInt(&stream->flush_seq, 1);
+}
+
+// Read the next chunk into the ring. Returns false if there was nothing to
+// do, the ring is full or the end was reached.
+static bool
+APP_WavStream_Fill(struct APP_WavStream *stream)
+{
+    if (SDL_GetAtomicInt(&stream->ended))
+    {
+        // Looping turned on after the last chunk was read, the start follows
+        // it in the ring like any other loop. Not after a failed read.
+        if (!SDL_GetAtomicInt(&stream->looping) || stream->file_pos != stream->data_size)
+        {
+            return false;
+        }
+
+        stream->file_pos = 0;
+        SDL_SeekIO(stream->io, (Sint64)stream->data_offset, SDL_IO_SEEK_SET);
+        SDL_AddAtomicInt(&stream->loops, 1);
+        SDL_SetAtomicInt(&stream->ended, 0);
+    }
+
+    Uint32 write = (Uint32)SDL_GetAtomicInt(&stream->write_pos);
+    Uint32 read = (Uint32)SDL_GetAtomicInt(&stream->read_pos);
+
+    Uint32 size = APP_WAVSTREAM_RING_BYTES - (write - read);
+    if (size > APP_WAVSTREAM_CHUNK_BYTES)
+    {
+        size = APP_WAVSTREAM_CHUNK_BYTES;
+    }
+
+    Uint64 left = stream->data_size - stream->file_pos;
+    if (size > left)
+    {
+        size = (Uint32)left;
+    }
+
+    size -= size % stream->frame_size;
+
+    if (size == 0 && left > 0)
+    {
+        return false;
+    }
+
+    // The ring wraps, the chunk is read in up to two parts.
+    Uint32 offset = write & (APP_WAVSTREAM_RING_BYTES - 1);
+    Uint32 first = SDL_min(size, APP_WAVSTREAM_RING_BYTES - offset);
+
+    size_t got = SDL_ReadIO(stream->io, stream->ring + offset, first);
+    if (got == first && size > first)
+    {
+        got += SDL_ReadIO(stream->io, stream->ring, size - first);
+    }
+
+    // A failed read ends the stream with the frames that arrived.
+    bool failed = got != size;
+    if (failed)
+    {
+        SDL_Log("ERROR: WAV stream read failed. %s", SDL_GetError());
+        size = (Uint32)(got - got % stream->frame_size);
+        left = size;
+    }
+
+    SDL_SetAtomicInt(&stream->write_pos, (int)(write + size));
+    stream->file_pos += size;
+
+    SDL_LockSpinlock(&stream->lock);
+    stream->streamed_bytes += size;
+    SDL_UnlockSpinlock(&stream->lock);
+
+    if (size == left)
+    {
+        // Note(john): The first samples follow the last ones right in the
+        // ring, so the loop has no gap.
+        if (SDL_GetAtomicInt(&stream->looping) && !failed)
+        {
+            stream->file_pos = 0;
+            SDL_SeekIO(stream->io, (Sint64)stream->data_offset, SDL_IO_SEEK_SET);
+            SDL_AddAtomicInt(&stream->loops, 1);
+        }
+        else
+        {
+            SDL_SetAtomicInt(&stream->ended, 1);
+        }
+    }
+
+    return true;
+}
+
+static int
+APP_WavStream_Worker(void *data)
+{
+    struct APP_WavStream *stream = data;
+
+    while (!SDL_GetAtomicInt(&stream->quit))
+    {
+        APP_WavStream_ApplySeek(stream);
+
+        if (!APP_WavStream_Fill(stream))
+        {
+            SDL_WaitSemaphoreTimeout(stream->wake, WAVSTREAM_IDLE_MS);
+        }
+    }
+
+    return 0;
+}
+
+// ====================
+// Stream
+// ====================
+
+struct APP_WavStream*
+APP_WavStream_Open(SDL_IOStream *io, bool loop)
+{
+    if (io == NULL)
+    {
+        return NULL;
+    }
+
+    struct APP_WavStream *stream = SDL_calloc(1, sizeof(struct APP_WavStream));
+    if (stream == NULL)
+    {
+        SDL_CloseIO(io);
+        return NULL;
+    }
+
+    stream->io = io;
+    SDL_SetAtomicInt(&stream->looping, loop);
+
+    if (!APP_WavStream_ReadHeader(stream))
+    {
+        APP_WavStream_Close(stream);
+        return NULL;
+    }
+
+    stream->ring = SDL_malloc(APP_WAVSTREAM_RING_BYTES);
+    stream->wake = SDL_CreateSemaphore(0);
+    if (stream->ring == NULL || stream->wake == NULL)
+    {
+        SDL_Log("ERROR: Failed to create WAV stream. %s", SDL_GetError());
+        APP_WavStream_Close(stream);
+        return NULL;
+    }
+
+    // Note(john): The first chunk is read right here, so the first callback
+    // has samples and playback starts right away.
+    APP_WavStream_Fill(stream);
+
+    stream->thread = SDL_CreateThread(APP_WavStream_Worker, "WAV Stream", stream);
+    if (stream->thread == NULL)
+    {
+        SDL_Log("ERROR: Failed to create WAV stream thread. %s", SDL_GetError());
+        APP_WavStream_Close(stream);
+        return NULL;
+    }
+
+    return stream;
+}
+
+void
+APP_WavStream_Close(struct APP_WavStream *stream)
+{
+    if (stream == NULL)
+    {
+        return;
+    }
+
+    if (stream->thread != NULL)
+    {
+        SDL_SetAtomicInt(&stream->quit, 1);
+        SDL_SignalSemaphore(stream->wake);
+        SDL_WaitThread(stream->thread, NULL);
+    }
+
+    SDL_DestroySemaphore(stream->wake);
+    SDL_free(stream->ring);
+    SDL_CloseIO(stream->io);
+    SDL_free(stream);
+}
+
+const SDL_AudioSpec*
+APP_WavStream_GetSpec(const struct APP_WavStream *stream)
+{
+    return &stream->spec;
+}
+
+Uint64
+APP_WavStream_GetFrameCount(const struct APP_WavStream *stream)
+{
+    return stream->frame_count;
+}
+
+int
+APP_WavStream_Read(struct APP_WavStream *stream, void *dst, int size)
+{
+    // Note(john): The write position is loaded before the flush, the seek
+    // is published before any sample after it is written. Samples from
+    // after a seek that wasn't seen yet can't be read that way. A flush
+    // moves the read position up to where the write position was at the
+    // seek, so the write position is loaded again after it, until no seek
+    // came in meanwhile. Otherwise the write position may be from before
+    // the flush position.
+    Uint32 write = (Uint32)SDL_GetAtomicInt(&stream->write_pos);
+
+    Uint32 flush_seq = (Uint32)SDL_GetAtomicInt(&stream->flush_seq);
+    while (flush_seq != stream->seen_flush_seq)
+    {
+        stream->seen_flush_seq = flush_seq;
+        stream->read_frame = (Uint32)SDL_GetAtomicInt(&stream->flush_frame);
+        SDL_SetAtomicInt(&stream->read_pos, SDL_GetAtomicInt(&stream->flush_pos));
+        SDL_SetAtomicInt(&stream->finished, 0);
+
+        write = (Uint32)SDL_GetAtomicInt(&stream->write_pos);
+        flush_seq = (Uint32)SDL_GetAtomicInt(&stream->flush_seq);
+    }
+
+    Uint32 read = (Uint32)SDL_GetAtomicInt(&stream->read_pos);
+    Uint32 available = write - read;
+
+    Uint32 wanted = size > 0 ? (Uint32)size : 0;
+    wanted -= wanted % stream->frame_size;
+
+    Uint32 count = SDL_min(available, wanted);
+    Uint32 offset = read & (APP_WAVSTREAM_RING_BYTES - 1);
+    Uint32 first = SDL_min(count, APP_WAVSTREAM_RING_BYTES - offset);
+
+    SDL_memcpy(dst, stream->ring + offset, first);
+    SDL_memcpy((Uint8 *)dst + first, stream->ring, count - first);
+
+    SDL_SetAtomicInt(&stream->read_pos, (int)(read + count));
+
+    // Frames after the end, the stream was looped again.
+    if (count > 0)
+    {
+        SDL_SetAtomicInt(&stream->finished, 0);
+    }
+
+    // Frames past the end are from the next loop.
+    stream->read_frame += count / stream->frame_size;
+    if (stream->read_frame > stream->frame_count)
+    {
+        stream->read_frame %= stream->frame_count;
+    }
+
+    SDL_SetAtomicInt(&stream->position, (int)stream->read_frame);
+
+    if (count < wanted)
+    {
+        if (SDL_GetAtomicInt(&stream->ended) && count == available)
+        {
+            SDL_SetAtomicInt(&stream->finished, 1);
+        }
+        else
+        {
+            SDL_AddAtomicInt(&stream->underruns, 1);
+        }
+    }
+
+    SDL_SignalSemaphore(stream->wake);
+    return (int)count;
+}
+
+void
+APP_WavStream_Seek(struct APP_WavStream *stream, Uint64 frame)
+{
+    SDL_LockSpinlock(&stream->lock);
+    stream->seek_requested = true;
+    stream->seek_frame = frame;
+    SDL_UnlockSpinlock(&stream->lock);
+
+    SDL_SignalSemaphore(stream->wake);
+}
+
+void
+APP_WavStream_SetLooping(struct APP_WavStream *stream, bool loop)
+{
+    SDL_SetAtomicInt(&stream->looping, loop);
+    SDL_SignalSemaphore(stream->wake);
+}
+
+Uint64
+APP_WavStream_GetPosition(struct APP_WavStream *stream)
+{
+    return (Uint32)SDL_GetAtomicInt(&stream->position);
+}
+
+bool
+APP_WavStream_IsFinished(struct APP_WavStream *stream)
+{
+    return SDL_GetAtomicInt(&stream->finished) != 0;
+}
+
+void
+APP_WavStream_GetStats(struct APP_WavStream *stream, struct APP_WavStreamStats *out_stats)
+{
+    SDL_zerop(out_stats);
+
+    out_stats->resident_bytes = (Uint32)(APP_WAVSTREAM_RING_BYTES + sizeof(struct APP_WavStream));
+    out_stats->buffered_bytes =
+        (Uint32)SDL_GetAtomicInt(&stream->write_pos) - (Uint32)SDL_GetAtomicInt(&stream->read_pos);
+    out_stats->underruns = (Uint32)SDL_GetAtomicInt(&stream->underruns);
+    out_stats->loops = (Uint32)SDL_GetAtomicInt(&stream->loops);
+
+    SDL_LockSpinlock(&stream->lock);
+    out_stats->streamed_bytes = stream->streamed_bytes;
+    SDL_UnlockSpinlock(&stream->lock);
+}
@@ -0,0 +1,53 @@
+#ifndef WAVSTREAM_H
+#define WAVSTREAM_H
+
+#include <SDL3/SDL.h>
+
+// Plays a WAV without loading it whole. An I/O thread reads the samples in
+// small chunks into a ring buffer, the audio thread takes them out of it
+// without locks. Seeking and looping happen on the I/O thread, a loop
+// continues right after the last sample without a gap.
+
+#define APP_WAVSTREAM_RING_BYTES (64 * 1024)
+// The most the I/O thread reads at once.
+#define APP_WAVSTREAM_CHUNK_BYTES (8 * 1024)
+
+struct APP_WavStream;
+
+struct APP_WavStreamStats {
+    // What the stream keeps in memory, the ring buffer and its state.
+    Uint32 resident_bytes;
+    Uint32 buffered_bytes;
+    Uint64 streamed_bytes;
+    // Reads of the audio thread the ring couldn't fill.
+    Uint32 underruns;
+    Uint32 loops;
+};
+
+// Parse the header and fill the ring with the first chunk, the stream owns
+// io from here on. NULL if it isn't a PCM or float WAV.
+struct APP_WavStream *APP_WavStream_Open(SDL_IOStream *io, bool loop);
+void APP_WavStream_Close(struct APP_WavStream *stream);
+
+const SDL_AudioSpec *APP_WavStream_GetSpec(const struct APP_WavStream *stream);
+Uint64 APP_WavStream_GetFrameCount(const struct APP_WavStream *stream);
+
+// Audio thread: copy up to size bytes of whole frames into dst, never
+// blocks. Returns the bytes copied, less than size on an underrun or at the
+// end.
+int APP_WavStream_Read(struct APP_WavStream *stream, void *dst, int size);
+
+// Any thread. Samples already handed out by APP_WavStream_Read still play,
+// clear the audio stream to drop them.
+void APP_WavStream_Seek(struct APP_WavStream *stream, Uint64 frame);
+// Turned on after the end was read, the stream goes on from the start.
+void APP_WavStream_SetLooping(struct APP_WavStream *stream, bool loop);
+
+// The frame the audio thread reads next.
+Uint64 APP_WavStream_GetPosition(struct APP_WavStream *stream);
+// Not looping and every frame was read.
+bool APP_WavStream_IsFinished(struct APP_WavStream *stream);
+
+void APP_WavStream_GetStats(struct APP_WavStream *stream, struct APP_WavStreamStats *out_stats);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef APP_H
+#define APP_H
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_stdinc.h>
+
+struct APP_SpriteBatch;
+struct APP_MovingSprite;
+struct APP_Pack;
+struct APP_TextureStream;
+
+#define APP_WINDOW_WIDTH 1280
+#define APP_WINDOW_HEIGHT 720
+
+#define APP_SPRITE_TEXTURE_COUNT 3
+
+struct APP_Benchmark {
+    bool enabled;
+    Uint32 step;
+    Uint32 frame;
+};
+
+struct APP_FrameStats {
+    // CPU time for submit, sort, upload and draw recording of the sprites.
+    Uint64 batch_ticks;
+    Uint64 frame_ticks;
+    Uint64 last_frame;
+    Uint32 frames;
+    Uint32 batches;
+};
+
+struct APP_Context {
+    const char *base_path;
+    // NULL to read the loose files of the example.
+    struct APP_Pack *pack;
+    float time;
+
+    SDL_Window *window;
+    SDL_GPUDevice *device;
+    SDL_GPUGraphicsPipeline *pipeline;
+    SDL_GPUSampler *sampler;
+
+    // Owned by the texture stream, refreshed every frame since streaming
+    // replaces them.
+    struct APP_TextureStream *texture_stream;
+    Uint32 texture_handles[APP_SPRITE_TEXTURE_COUNT];
+    SDL_GPUTexture *textures[APP_SPRITE_TEXTURE_COUNT];
+    Uint64 texture_budget;
+
+    // Scales every sprite when drawn, so the textures need finer mips.
+    float sprite_zoom;
+
+    struct APP_SpriteBatch *sprite_batch;
+    struct APP_MovingSprite *sprites;
+    Uint32 sprite_count;
+
+    struct APP_FrameStats stats;
+    struct APP_Benchmark benchmark;
+};
+
+#endif
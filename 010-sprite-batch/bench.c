@@ -0,0 +1,293 @@
+#include "bench.h"
+#include "app.h"
+#include "pixels.h"
+#include "qoi.h"
+#include "scene.h"
+#include "texstream.h"
+#include "utils.h"
+
+#define STATS_LOG_INTERVAL 120
+
+#define BENCH_WARMUP_FRAMES 30
+#define BENCH_MEASURE_FRAMES 300
+
+static const Uint32 BENCH_SPRITE_COUNTS[] = { 10000, 50000, 100000, 200000 };
+
+static double
+APP_TicksToMs(Uint64 ticks, Uint32 frames)
+{
+    if (frames == 0)
+    {
+        return 0.0;
+    }
+
+    return (double)ticks * 1000.0 / ((double)SDL_GetPerformanceFrequency() * frames);
+}
+
+// Log the average batch and frame time every STATS_LOG_INTERVAL frames.
+void
+APP_LogFrameStats(struct APP_Context *ctx)
+{
+    if (ctx->stats.frames < STATS_LOG_INTERVAL)
+    {
+        return;
+    }
+
+    double frame_ms = APP_TicksToMs(ctx->stats.frame_ticks, ctx->stats.frames);
+
+    SDL_Log(
+            "INFO: %u sprites in %u batches, batch %.3f ms, frame %.3f ms (%.1f FPS)",
+            ctx->sprite_count,
+            ctx->stats.batches,
+            APP_TicksToMs(ctx->stats.batch_ticks, ctx->stats.frames),
+            frame_ms,
+            frame_ms > 0.0 ? 1000.0 / frame_ms : 0.0
+    );
+
+    struct APP_TextureStreamStats streaming;
+    APP_TextureStream_GetStats(ctx->texture_stream, &streaming);
+
+    char budget[32] = "no budget";
+    if (streaming.budget_bytes > 0)
+    {
+        SDL_snprintf(budget, sizeof(budget), "budget %.2f MB", (double)streaming.budget_bytes / (1024.0 * 1024.0));
+    }
+
+    SDL_Log(
+            "INFO: Textures %.2f MB resident (%s, high water %.2f MB), %u pending, %.2f MB/s streamed, %.2f ms latency, %u mips loaded, %u evicted, %u budget misses",
+            (double)streaming.resident_bytes / (1024.0 * 1024.0),
+            budget,
+            (double)streaming.high_water_bytes / (1024.0 * 1024.0),
+            streaming.pending_requests,
+            streaming.bandwidth_mb_per_s,
+            streaming.average_latency_ms,
+            streaming.loaded_mips,
+            streaming.evicted_mips,
+            streaming.budget_misses
+    );
+
+    ctx->stats.batch_ticks = 0;
+    ctx->stats.frame_ticks = 0;
+    ctx->stats.frames = 0;
+}
+
+// Step through the benchmark table. Returns true once every sprite count
+// has been measured.
+bool
+APP_UpdateBenchmark(struct APP_Context *ctx)
+{
+    struct APP_Benchmark *bench = &ctx->benchmark;
+
+    bench->frame++;
+
+    if (bench->frame == BENCH_WARMUP_FRAMES)
+    {
+        ctx->stats.batch_ticks = 0;
+        ctx->stats.frame_ticks = 0;
+        ctx->stats.frames = 0;
+    }
+
+    if (bench->frame < BENCH_WARMUP_FRAMES + BENCH_MEASURE_FRAMES)
+    {
+        return false;
+    }
+
+    double frame_ms = APP_TicksToMs(ctx->stats.frame_ticks, ctx->stats.frames);
+
+    SDL_Log(
+            "INFO: [bench] %7u sprites %3u batches: %8.3f ms batch, %8.3f ms frame, %7.1f FPS",
+            ctx->sprite_count,
+            ctx->stats.batches,
+            APP_TicksToMs(ctx->stats.batch_ticks, ctx->stats.frames),
+            frame_ms,
+            frame_ms > 0.0 ? 1000.0 / frame_ms : 0.0
+    );
+
+    bench->step++;
+    bench->frame = 0;
+
+    if (bench->step >= SDL_arraysize(BENCH_SPRITE_COUNTS))
+    {
+        return true;
+    }
+
+    APP_ReleaseSprites(ctx);
+
+    if (APP_CreateSprites(ctx, BENCH_SPRITE_COUNTS[bench->step]) == -1)
+    {
+        SDL_Log("ERROR: Failed to create benchmark sprites.");
+        return true;
+    }
+
+    return false;
+}
+
+// The benchmark starts with the first table entry.
+Uint32
+APP_BenchmarkFirstSpriteCount(void)
+{
+    return BENCH_SPRITE_COUNTS[0];
+}
+
+// ====================
+// Image decoding
+// ====================
+
+#define IMAGE_BENCH_RUNS 20
+#define IMAGE_BENCH_UPSCALE 10
+
+static double
+APP_BenchmarkMs(Uint64 start)
+{
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+        / ((double)SDL_GetPerformanceFrequency() * IMAGE_BENCH_RUNS);
+}
+
+// Decode both files from memory into the same ABGR8888 pixels the loaders
+// write into the upload buffer, so only the decoding is measured.
+static void
+APP_BenchmarkImagePair(const char *name, const void *bmp, size_t bmp_size, const void *qoi, size_t qoi_size)
+{
+    struct APP_QOIInfo info;
+    if (!APP_QOI_ReadInfo(qoi, qoi_size, &info))
+    {
+        SDL_Log("ERROR: [image bench] %s is not a valid QOI.", name);
+        return;
+    }
+
+    void *pixels = SDL_malloc((size_t)info.width * info.height * 4);
+    if (pixels == NULL)
+    {
+        return;
+    }
+
+    int pitch = (int)info.width * 4;
+    bool valid = true;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < IMAGE_BENCH_RUNS && valid; ++i)
+    {
+        SDL_Surface *image = SDL_LoadBMP_IO(SDL_IOFromConstMem(bmp, bmp_size), true);
+        valid = image != NULL && APP_ConvertSurfaceToABGR8888(image, pixels, pitch);
+        SDL_DestroySurface(image);
+    }
+    double bmp_ms = APP_BenchmarkMs(start);
+
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < IMAGE_BENCH_RUNS && valid; ++i)
+    {
+        valid = APP_QOI_Decode(qoi, qoi_size, pixels, pitch, 1);
+    }
+    double qoi_ms = APP_BenchmarkMs(start);
+
+    Uint32 thread_count = (Uint32)SDL_GetNumLogicalCPUCores();
+
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < IMAGE_BENCH_RUNS && valid; ++i)
+    {
+        valid = APP_QOI_Decode(qoi, qoi_size, pixels, pitch, thread_count);
+    }
+    double parallel_ms = APP_BenchmarkMs(start);
+
+    SDL_free(pixels);
+
+    if (!valid)
+    {
+        SDL_Log("ERROR: [image bench] Failed to decode %s.", name);
+        return;
+    }
+
+    SDL_Log(
+            "INFO: [image bench] %-16s %5ux%-5u BMP %9zu bytes %8.3f ms | QOI %9zu bytes (%5.1f%%) %8.3f ms, %u slices on %u threads %8.3f ms",
+            name,
+            info.width,
+            info.height,
+            bmp_size,
+            bmp_ms,
+            qoi_size,
+            100.0 * (double)qoi_size / (double)bmp_size,
+            qoi_ms,
+            info.slice_count,
+            thread_count,
+            parallel_ms
+    );
+}
+
+// The sample image blown up, so there are enough pixels for the slices to
+// be decoded in parallel. Both files are written into memory.
+static void
+APP_BenchmarkUpscaledImage(const void *bmp, size_t bmp_size)
+{
+    SDL_Surface *image = SDL_LoadBMP_IO(SDL_IOFromConstMem(bmp, bmp_size), true);
+    if (image == NULL)
+    {
+        return;
+    }
+
+    SDL_Surface *large_bgr = SDL_ScaleSurface(
+            image,
+            image->w * IMAGE_BENCH_UPSCALE,
+            image->h * IMAGE_BENCH_UPSCALE,
+            SDL_SCALEMODE_NEAREST
+    );
+
+    SDL_Surface *large = NULL;
+    SDL_IOStream *large_bmp = SDL_IOFromDynamicMem();
+    SDL_IOStream *large_qoi = SDL_IOFromDynamicMem();
+
+    if (large_bgr != NULL
+        && large_bmp != NULL
+        && large_qoi != NULL
+        && (large = SDL_ConvertSurface(large_bgr, SDL_PIXELFORMAT_ABGR8888)) != NULL
+        && SDL_SaveBMP_IO(large_bgr, large_bmp, false)
+        && APP_QOI_Encode(large, 64, large_qoi))
+    {
+        SDL_PropertiesID bmp_props = SDL_GetIOProperties(large_bmp);
+        SDL_PropertiesID qoi_props = SDL_GetIOProperties(large_qoi);
+
+        APP_BenchmarkImagePair(
+                "default (10x)",
+                SDL_GetPointerProperty(bmp_props, SDL_PROP_IOSTREAM_DYNAMIC_MEMORY_POINTER, NULL),
+                (size_t)SDL_GetIOSize(large_bmp),
+                SDL_GetPointerProperty(qoi_props, SDL_PROP_IOSTREAM_DYNAMIC_MEMORY_POINTER, NULL),
+                (size_t)SDL_GetIOSize(large_qoi)
+        );
+    }
+    else
+    {
+        SDL_Log("ERROR: [image bench] Failed to build the upscaled image. %s", SDL_GetError());
+    }
+
+    SDL_CloseIO(large_bmp);
+    SDL_CloseIO(large_qoi);
+    SDL_DestroySurface(large_bgr);
+    SDL_DestroySurface(large);
+    SDL_DestroySurface(image);
+}
+
+// Compare the bytes on disk and the decode time of the BMP and QOI sample
+// images, read like the loaders do from the asset pack or the loose files.
+void
+APP_BenchmarkImages(struct APP_Context *ctx)
+{
+    size_t bmp_size;
+    size_t qoi_size;
+    void *bmp_owned;
+    void *qoi_owned;
+
+    const void *bmp = APP_ReadAsset(ctx, "images/default.bmp", &bmp_size, &bmp_owned);
+    const void *qoi = APP_ReadAsset(ctx, "images/default.qoi", &qoi_size, &qoi_owned);
+
+    if (bmp != NULL && qoi != NULL)
+    {
+        APP_BenchmarkImagePair("default", bmp, bmp_size, qoi, qoi_size);
+        APP_BenchmarkUpscaledImage(bmp, bmp_size);
+    }
+    else
+    {
+        SDL_Log("ERROR: [image bench] images/default.bmp and images/default.qoi are needed.");
+    }
+
+    SDL_free(bmp_owned);
+    SDL_free(qoi_owned);
+}
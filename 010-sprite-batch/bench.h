@@ -0,0 +1,11 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "app.h"
+
+void APP_LogFrameStats(struct APP_Context *ctx);
+bool APP_UpdateBenchmark(struct APP_Context *ctx);
+Uint32 APP_BenchmarkFirstSpriteCount(void);
+void APP_BenchmarkImages(struct APP_Context *ctx);
+
+#endif
@@ -0,0 +1,218 @@
+#define SDL_MAIN_USE_CALLBACKS 1
+
+#include "app.h"
+#include "bench.h"
+#include "pack.h"
+#include "renderer.h"
+#include "scene.h"
+#include <SDL3/SDL_main.h>
+#include <stdlib.h>
+
+#define DEFAULT_SPRITE_COUNT 100000
+
+SDL_AppResult 
+SDL_AppInit(void **appstate, int argc, char **argv) 
+{
+    if (!SDL_Init(SDL_INIT_VIDEO)) 
+    {
+        SDL_Log("ERROR: Couldn't initialize SDL: %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
+    struct APP_Context *ctx = calloc(1, sizeof(struct APP_Context));
+
+    // Usage: main [--sprites N] [--bench] [--texture-budget KB] [--loose-assets] [--image-bench]
+    Uint32 sprite_count = DEFAULT_SPRITE_COUNT;
+    bool loose_assets = false;
+    bool image_bench = false;
+    ctx->sprite_zoom = 1.0f;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (SDL_strcmp(argv[i], "--sprites") == 0 && i + 1 < argc)
+        {
+            sprite_count = (Uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--bench") == 0)
+        {
+            ctx->benchmark.enabled = true;
+        }
+        else if (SDL_strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc)
+        {
+            ctx->texture_budget = (Uint64)SDL_atoi(argv[++i]) * 1024;
+        }
+        else if (SDL_strcmp(argv[i], "--loose-assets") == 0)
+        {
+            loose_assets = true;
+        }
+        else if (SDL_strcmp(argv[i], "--image-bench") == 0)
+        {
+            image_bench = true;
+        }
+    }
+
+    if (ctx->benchmark.enabled)
+    {
+        sprite_count = APP_BenchmarkFirstSpriteCount();
+    }
+
+    ctx->base_path = SDL_GetBasePath();
+
+    // Note(john): Without a pack next to the executable the assets are read
+    // from the loose files, as during development.
+    if (!loose_assets)
+    {
+        char pack_path[256];
+        SDL_snprintf(pack_path, sizeof(pack_path), "%sassets.pack", ctx->base_path);
+        ctx->pack = APP_Pack_Open(pack_path);
+    }
+
+    if (image_bench)
+    {
+        APP_BenchmarkImages(ctx);
+        APP_Pack_Close(ctx->pack);
+        free(ctx);
+        return SDL_APP_SUCCESS;
+    }
+
+    ctx->device = SDL_CreateGPUDevice(
+            SDL_GPU_SHADERFORMAT_SPIRV
+            | SDL_GPU_SHADERFORMAT_MSL
+            | SDL_GPU_SHADERFORMAT_DXIL, 
+            false, 
+            NULL
+    );
+
+    if (ctx->device == NULL) 
+    {
+        SDL_Log("ERROR: Failed to create device. %s", SDL_GetError());
+        free(ctx);
+        return SDL_APP_FAILURE;
+    }
+
+    ctx->window = SDL_CreateWindow("Sprite Batch", APP_WINDOW_WIDTH, APP_WINDOW_HEIGHT, 0);
+    if (ctx->window == NULL) 
+    {
+        SDL_Log("ERROR: Failed to create window. %s", SDL_GetError());
+        free(ctx);
+        return SDL_APP_FAILURE;
+    }
+
+    if (!SDL_ClaimWindowForGPUDevice(ctx->device, ctx->window)) 
+    {
+        SDL_Log("ERROR: Failed to claim window. %s", SDL_GetError());
+        free(ctx);
+        return SDL_APP_FAILURE;
+    }
+
+    // Note(john): Without vsync the benchmark measures what the batcher can
+    // do instead of the refresh rate of the display.
+    if (ctx->benchmark.enabled
+        && SDL_WindowSupportsGPUPresentMode(ctx->device, ctx->window, SDL_GPU_PRESENTMODE_IMMEDIATE))
+    {
+        SDL_SetGPUSwapchainParameters(
+                ctx->device,
+                ctx->window,
+                SDL_GPU_SWAPCHAINCOMPOSITION_SDR,
+                SDL_GPU_PRESENTMODE_IMMEDIATE
+        );
+    }
+
+    if (APP_CreateSprites(ctx, sprite_count) == -1)
+    {
+        SDL_Log("ERROR: Failed to create sprites.");
+        free(ctx);
+        return SDL_APP_FAILURE;
+    }
+
+    int result = APP_InitRenderer(ctx);
+    if (result == -1)
+    { 
+        SDL_Log("ERROR: Failed to init renderer.");
+        free(ctx);
+        return SDL_APP_FAILURE;
+    }
+
+    ctx->stats.last_frame = SDL_GetPerformanceCounter();
+
+    *appstate = ctx;
+
+    return SDL_APP_CONTINUE;
+}
+
+SDL_AppResult 
+SDL_AppEvent(void *appstate, SDL_Event *event) 
+{
+    if(event->type == SDL_EVENT_QUIT)
+    {
+        return SDL_APP_SUCCESS;
+    }
+
+    if(event->type == SDL_EVENT_KEY_DOWN)
+    {
+        struct APP_Context *ctx = appstate;
+
+        // Zoom 1x, 4x, 16x, the textures stream finer mips in and the
+        // budget evicts them again.
+        if (event->key.key == SDLK_Z)
+        {
+            ctx->sprite_zoom = ctx->sprite_zoom >= 16.0f ? 1.0f : ctx->sprite_zoom * 4.0f;
+            SDL_Log("INFO: Sprite zoom %.0fx", ctx->sprite_zoom);
+            return SDL_APP_CONTINUE;
+        }
+
+        return SDL_APP_SUCCESS;
+    }
+
+    return SDL_APP_CONTINUE;
+}
+
+SDL_AppResult 
+SDL_AppIterate(void *appstate) 
+{
+    struct APP_Context *ctx = appstate;
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 frame_ticks = now - ctx->stats.last_frame;
+    float delta_time = (float)((double)frame_ticks / (double)SDL_GetPerformanceFrequency());
+
+    ctx->stats.last_frame = now;
+    ctx->stats.frame_ticks += frame_ticks;
+    ctx->stats.frames++;
+    ctx->time += delta_time;
+
+    APP_UpdateSprites(ctx, delta_time);
+    APP_Draw(ctx);
+
+    if (ctx->benchmark.enabled)
+    {
+        return APP_UpdateBenchmark(ctx) ? SDL_APP_SUCCESS : SDL_APP_CONTINUE;
+    }
+
+    APP_LogFrameStats(ctx);
+    return SDL_APP_CONTINUE;
+}
+
+void 
+SDL_AppQuit(void *appstate, SDL_AppResult result) 
+{
+    struct APP_Context *ctx = appstate;
+
+    // Note(john): Quit runs even if init didn't get as far as the context.
+    if (ctx == NULL)
+    {
+        return;
+    }
+
+    APP_ReleaseRenderer(ctx);
+    APP_ReleaseSprites(ctx);
+
+    SDL_ReleaseWindowFromGPUDevice(ctx->device, ctx->window);
+    SDL_DestroyWindow(ctx->window);
+    SDL_DestroyGPUDevice(ctx->device);
+
+    APP_Pack_LogStats(ctx->pack);
+    APP_Pack_Close(ctx->pack);
+
+    free(ctx);
+}
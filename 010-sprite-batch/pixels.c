@@ -0,0 +1,571 @@
+#include "pixels.h"
+
+// Note(john): The SIMD kernels work on the bytes in memory, which only
+// match the packed formats on little endian. Big endian takes the scalar
+// rows, they work on the packed values.
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#if defined(SDL_AVX2_INTRINSICS)
+#define APP_PIXELS_AVX2
+#endif
+#if defined(SDL_SSE2_INTRINSICS)
+#define APP_PIXELS_SSE2
+#endif
+#if defined(SDL_SSE4_1_INTRINSICS)
+#define APP_PIXELS_SSE41
+#endif
+#if defined(SDL_NEON_INTRINSICS)
+#define APP_PIXELS_NEON
+#endif
+#endif
+
+#define APP_ALPHA_MASK 0xFF000000u
+
+struct APP_PixelRow {
+    // ABGR8888 colors of the palette, INDEX8 only.
+    const Uint32 *palette;
+    // Or'ed into every pixel, set for formats without alpha.
+    Uint32 alpha;
+};
+
+typedef void (*APP_PixelRowFn)(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row);
+
+static inline Uint32
+APP_ExpandRGB565(Uint16 pixel)
+{
+    Uint32 r = pixel >> 11;
+    Uint32 g = (pixel >> 5) & 0x3F;
+    Uint32 b = pixel & 0x1F;
+
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+
+    return (b << 16) | (g << 8) | r;
+}
+
+// ====================
+// Scalar rows
+// ====================
+
+// BGR24 is a byte array, B first.
+static void
+APP_Row_BGR24_Scalar(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    for (int x = 0; x < count; ++x, src += 3)
+    {
+        dst[x] = row->alpha | ((Uint32)src[0] << 16) | ((Uint32)src[1] << 8) | src[2];
+    }
+}
+
+// ARGB8888 to ABGR8888 swaps the red and the blue channel.
+static void
+APP_Row_ARGB8888_Scalar(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    const Uint32 *pixels = (const Uint32 *)src;
+
+    for (int x = 0; x < count; ++x)
+    {
+        Uint32 p = pixels[x];
+        dst[x] = (p & 0xFF00FF00u) | ((p >> 16) & 0xFFu) | ((p & 0xFFu) << 16) | row->alpha;
+    }
+}
+
+static void
+APP_Row_ABGR8888_Scalar(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    const Uint32 *pixels = (const Uint32 *)src;
+
+    for (int x = 0; x < count; ++x)
+    {
+        dst[x] = pixels[x] | row->alpha;
+    }
+}
+
+static void
+APP_Row_RGB565_Scalar(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    const Uint16 *pixels = (const Uint16 *)src;
+
+    for (int x = 0; x < count; ++x)
+    {
+        dst[x] = APP_ExpandRGB565(pixels[x]) | row->alpha;
+    }
+}
+
+// Note(john): A 256 entry table lookup is already about one load per pixel,
+// AVX2 gathers measured no faster, so INDEX8 has no SIMD kernel.
+static void
+APP_Row_INDEX8_Table(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    const Uint32 *palette = row->palette;
+    int x = 0;
+
+    for (; x + 4 <= count; x += 4)
+    {
+        dst[x + 0] = palette[src[x + 0]];
+        dst[x + 1] = palette[src[x + 1]];
+        dst[x + 2] = palette[src[x + 2]];
+        dst[x + 3] = palette[src[x + 3]];
+    }
+
+    for (; x < count; ++x)
+    {
+        dst[x] = palette[src[x]];
+    }
+}
+
+// ====================
+// SSE rows
+// ====================
+
+#ifdef APP_PIXELS_SSE2
+// Swap the 16 bit halves of the red/blue lanes, which moves B into the low
+// byte and R into the third byte.
+SDL_TARGETING("sse2") static void
+APP_Row_ARGB8888_SSE2(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    const __m128i rb_mask = _mm_set1_epi32(0x00FF00FF);
+    const __m128i ga_mask = _mm_set1_epi32((int)0xFF00FF00u);
+    const __m128i alpha = _mm_set1_epi32((int)row->alpha);
+    int x = 0;
+
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i *)(src + x * 4));
+        __m128i rb = _mm_and_si128(p, rb_mask);
+        rb = _mm_shufflelo_epi16(rb, _MM_SHUFFLE(2, 3, 0, 1));
+        rb = _mm_shufflehi_epi16(rb, _MM_SHUFFLE(2, 3, 0, 1));
+
+        __m128i out = _mm_or_si128(_mm_or_si128(_mm_and_si128(p, ga_mask), rb), alpha);
+        _mm_storeu_si128((__m128i *)(dst + x), out);
+    }
+
+    APP_Row_ARGB8888_Scalar(dst + x, src + x * 4, count - x, row);
+}
+
+// Expand the channels in 16 bit lanes, then interleave R|G and B|A into
+// 32 bit pixels.
+SDL_TARGETING("sse2") static void
+APP_Row_RGB565_SSE2(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    const __m128i mask6 = _mm_set1_epi16(0x3F);
+    const __m128i alpha = _mm_set1_epi16((short)(row->alpha >> 16));
+    int x = 0;
+
+    for (; x + 8 <= count; x += 8)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i *)(src + x * 2));
+
+        __m128i r = _mm_srli_epi16(p, 11);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(p, 5), mask6);
+        __m128i b = _mm_and_si128(p, mask5);
+
+        r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+        g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+        b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+
+        __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        __m128i ba = _mm_or_si128(b, alpha);
+
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128((__m128i *)(dst + x + 4), _mm_unpackhi_epi16(rg, ba));
+    }
+
+    APP_Row_RGB565_Scalar(dst + x, src + x * 2, count - x, row);
+}
+#endif
+
+#ifdef APP_PIXELS_SSE41
+// Note(john): The byte shuffle is SSSE3, SDL only reports SSE4.1 which
+// implies it. A 16 byte load covers 5 pixels, only 4 are used, so the loop
+// stops while at least 6 pixels are left to not read past the row.
+SDL_TARGETING("sse4.1") static void
+APP_Row_BGR24_SSE41(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i alpha = _mm_set1_epi32((int)row->alpha);
+    int x = 0;
+
+    for (; x + 6 <= count; x += 4)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i *)(src + x * 3));
+        __m128i out = _mm_or_si128(_mm_shuffle_epi8(p, shuffle), alpha);
+        _mm_storeu_si128((__m128i *)(dst + x), out);
+    }
+
+    APP_Row_BGR24_Scalar(dst + x, src + x * 3, count - x, row);
+}
+#endif
+
+// ====================
+// AVX2 rows
+// ====================
+
+#ifdef APP_PIXELS_AVX2
+// Two 12 byte groups, one per 128 bit lane, since the byte shuffle doesn't
+// cross lanes. The second load reads 16 bytes from byte 12, the loop keeps
+// 10 pixels ahead.
+SDL_TARGETING("avx2") static void
+APP_Row_BGR24_AVX2(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    const __m256i shuffle = _mm256_setr_epi8(
+            2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+            2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1
+    );
+    const __m256i alpha = _mm256_set1_epi32((int)row->alpha);
+    int x = 0;
+
+    for (; x + 10 <= count; x += 8)
+    {
+        const Uint8 *p = src + x * 3;
+        __m128i lo = _mm_loadu_si128((const __m128i *)p);
+        __m128i hi = _mm_loadu_si128((const __m128i *)(p + 12));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+        __m256i out = _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha);
+        _mm256_storeu_si256((__m256i *)(dst + x), out);
+    }
+
+    APP_Row_BGR24_Scalar(dst + x, src + x * 3, count - x, row);
+}
+
+SDL_TARGETING("avx2") static void
+APP_Row_ARGB8888_AVX2(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    const __m256i shuffle = _mm256_setr_epi8(
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+    );
+    const __m256i alpha = _mm256_set1_epi32((int)row->alpha);
+    int x = 0;
+
+    for (; x + 8 <= count; x += 8)
+    {
+        __m256i p = _mm256_loadu_si256((const __m256i *)(src + x * 4));
+        __m256i out = _mm256_or_si256(_mm256_shuffle_epi8(p, shuffle), alpha);
+        _mm256_storeu_si256((__m256i *)(dst + x), out);
+    }
+
+    APP_Row_ARGB8888_Scalar(dst + x, src + x * 4, count - x, row);
+}
+
+// The unpacks interleave inside the 128 bit lanes, lo holds the pixels 0-3
+// and 8-11, hi 4-7 and 12-15. The lane permutes put them back in order.
+SDL_TARGETING("avx2") static void
+APP_Row_RGB565_AVX2(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    const __m256i mask5 = _mm256_set1_epi16(0x1F);
+    const __m256i mask6 = _mm256_set1_epi16(0x3F);
+    const __m256i alpha = _mm256_set1_epi16((short)(row->alpha >> 16));
+    int x = 0;
+
+    for (; x + 16 <= count; x += 16)
+    {
+        __m256i p = _mm256_loadu_si256((const __m256i *)(src + x * 2));
+
+        __m256i r = _mm256_srli_epi16(p, 11);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi16(p, 5), mask6);
+        __m256i b = _mm256_and_si256(p, mask5);
+
+        r = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2));
+        g = _mm256_or_si256(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(g, 4));
+        b = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2));
+
+        __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+        __m256i ba = _mm256_or_si256(b, alpha);
+
+        __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+        __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+
+        _mm256_storeu_si256((__m256i *)(dst + x), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + x + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    APP_Row_RGB565_Scalar(dst + x, src + x * 2, count - x, row);
+}
+#endif
+
+// ====================
+// NEON rows
+// ====================
+
+#ifdef APP_PIXELS_NEON
+// The structured loads and stores do the (de)interleaving, the kernels only
+// reorder the channels.
+static void
+APP_Row_BGR24_NEON(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    int x = 0;
+
+    for (; x + 16 <= count; x += 16)
+    {
+        uint8x16x3_t bgr = vld3q_u8(src + x * 3);
+        uint8x16x4_t rgba;
+        rgba.val[0] = bgr.val[2];
+        rgba.val[1] = bgr.val[1];
+        rgba.val[2] = bgr.val[0];
+        rgba.val[3] = vdupq_n_u8((Uint8)(row->alpha >> 24));
+        vst4q_u8((Uint8 *)(dst + x), rgba);
+    }
+
+    APP_Row_BGR24_Scalar(dst + x, src + x * 3, count - x, row);
+}
+
+static void
+APP_Row_ARGB8888_NEON(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    const uint8x16_t alpha = vdupq_n_u8((Uint8)(row->alpha >> 24));
+    int x = 0;
+
+    for (; x + 16 <= count; x += 16)
+    {
+        uint8x16x4_t bgra = vld4q_u8(src + x * 4);
+        uint8x16_t b = bgra.val[0];
+        bgra.val[0] = bgra.val[2];
+        bgra.val[2] = b;
+        bgra.val[3] = vorrq_u8(bgra.val[3], alpha);
+        vst4q_u8((Uint8 *)(dst + x), bgra);
+    }
+
+    APP_Row_ARGB8888_Scalar(dst + x, src + x * 4, count - x, row);
+}
+
+static void
+APP_Row_RGB565_NEON(Uint32 *dst, const Uint8 *src, int count, const struct APP_PixelRow *row)
+{
+    const uint16x8_t mask5 = vdupq_n_u16(0x1F);
+    const uint16x8_t mask6 = vdupq_n_u16(0x3F);
+    int x = 0;
+
+    for (; x + 8 <= count; x += 8)
+    {
+        uint16x8_t p = vld1q_u16((const Uint16 *)(src + x * 2));
+
+        uint16x8_t r = vshrq_n_u16(p, 11);
+        uint16x8_t g = vandq_u16(vshrq_n_u16(p, 5), mask6);
+        uint16x8_t b = vandq_u16(p, mask5);
+
+        uint8x8x4_t rgba;
+        rgba.val[0] = vmovn_u16(vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2)));
+        rgba.val[1] = vmovn_u16(vorrq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(g, 4)));
+        rgba.val[2] = vmovn_u16(vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2)));
+        rgba.val[3] = vdup_n_u8((Uint8)(row->alpha >> 24));
+        vst4_u8((Uint8 *)(dst + x), rgba);
+    }
+
+    APP_Row_RGB565_Scalar(dst + x, src + x * 2, count - x, row);
+}
+#endif
+
+// ====================
+// Dispatch
+// ====================
+
+// Pick the widest kernel the CPU supports for the format, NULL if the
+// format has none.
+static APP_PixelRowFn
+APP_FindPixelRow(SDL_PixelFormat format, Uint32 *out_alpha, const char **out_name)
+{
+    *out_alpha = 0;
+
+    switch (format)
+    {
+        case SDL_PIXELFORMAT_BGR24:
+            *out_alpha = APP_ALPHA_MASK;
+#ifdef APP_PIXELS_AVX2
+            if (SDL_HasAVX2())
+            {
+                *out_name = "avx2";
+                return APP_Row_BGR24_AVX2;
+            }
+#endif
+#ifdef APP_PIXELS_SSE41
+            if (SDL_HasSSE41())
+            {
+                *out_name = "sse4.1";
+                return APP_Row_BGR24_SSE41;
+            }
+#endif
+#ifdef APP_PIXELS_NEON
+            if (SDL_HasNEON())
+            {
+                *out_name = "neon";
+                return APP_Row_BGR24_NEON;
+            }
+#endif
+            *out_name = "scalar";
+            return APP_Row_BGR24_Scalar;
+
+        case SDL_PIXELFORMAT_XRGB8888:
+            *out_alpha = APP_ALPHA_MASK;
+            SDL_FALLTHROUGH;
+        case SDL_PIXELFORMAT_ARGB8888:
+#ifdef APP_PIXELS_AVX2
+            if (SDL_HasAVX2())
+            {
+                *out_name = "avx2";
+                return APP_Row_ARGB8888_AVX2;
+            }
+#endif
+#ifdef APP_PIXELS_SSE2
+            if (SDL_HasSSE2())
+            {
+                *out_name = "sse2";
+                return APP_Row_ARGB8888_SSE2;
+            }
+#endif
+#ifdef APP_PIXELS_NEON
+            if (SDL_HasNEON())
+            {
+                *out_name = "neon";
+                return APP_Row_ARGB8888_NEON;
+            }
+#endif
+            *out_name = "scalar";
+            return APP_Row_ARGB8888_Scalar;
+
+        case SDL_PIXELFORMAT_RGB565:
+            *out_alpha = APP_ALPHA_MASK;
+#ifdef APP_PIXELS_AVX2
+            if (SDL_HasAVX2())
+            {
+                *out_name = "avx2";
+                return APP_Row_RGB565_AVX2;
+            }
+#endif
+#ifdef APP_PIXELS_SSE2
+            if (SDL_HasSSE2())
+            {
+                *out_name = "sse2";
+                return APP_Row_RGB565_SSE2;
+            }
+#endif
+#ifdef APP_PIXELS_NEON
+            if (SDL_HasNEON())
+            {
+                *out_name = "neon";
+                return APP_Row_RGB565_NEON;
+            }
+#endif
+            *out_name = "scalar";
+            return APP_Row_RGB565_Scalar;
+
+        // Already the right layout, the compiler vectorizes the copy.
+        case SDL_PIXELFORMAT_XBGR8888:
+            *out_alpha = APP_ALPHA_MASK;
+            SDL_FALLTHROUGH;
+        case SDL_PIXELFORMAT_ABGR8888:
+            *out_name = "copy";
+            return APP_Row_ABGR8888_Scalar;
+
+        case SDL_PIXELFORMAT_INDEX8:
+            *out_name = "table";
+            return APP_Row_INDEX8_Table;
+
+        default:
+            *out_name = "blit";
+            return NULL;
+    }
+}
+
+const char*
+APP_PixelConverterName(SDL_PixelFormat format)
+{
+    Uint32 alpha;
+    const char *name;
+
+    APP_FindPixelRow(format, &alpha, &name);
+    return name;
+}
+
+// Formats without a kernel (INDEX1/4, 1555, 4444, ...) are blitted by SDL
+// into a surface that wraps the destination, still without a copy.
+static bool
+APP_BlitToABGR8888(SDL_Surface *surface, void *dst, int dst_pitch)
+{
+    SDL_Surface *target = SDL_CreateSurfaceFrom(
+            surface->w,
+            surface->h,
+            SDL_PIXELFORMAT_ABGR8888,
+            dst,
+            dst_pitch
+    );
+
+    if (target == NULL)
+    {
+        SDL_Log("ERROR: Failed to wrap the pixel destination. %s", SDL_GetError());
+        return false;
+    }
+
+    // A blended blit would mix with whatever the destination held.
+    SDL_BlendMode blend_mode;
+    SDL_GetSurfaceBlendMode(surface, &blend_mode);
+    SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+
+    bool result = SDL_BlitSurface(surface, NULL, target, NULL);
+    if (!result)
+    {
+        SDL_Log("ERROR: Failed to blit the pixels. %s", SDL_GetError());
+    }
+
+    SDL_SetSurfaceBlendMode(surface, blend_mode);
+    SDL_DestroySurface(target);
+    return result;
+}
+
+// Convert every row of the surface into dst, rows are dst_pitch bytes apart.
+bool
+APP_ConvertSurfaceToABGR8888(SDL_Surface *surface, void *dst, int dst_pitch)
+{
+    struct APP_PixelRow row = { 0 };
+    const char *name;
+
+    APP_PixelRowFn convert = APP_FindPixelRow(surface->format, &row.alpha, &name);
+    if (convert == NULL)
+    {
+        return APP_BlitToABGR8888(surface, dst, dst_pitch);
+    }
+
+    Uint32 palette[256];
+    if (surface->format == SDL_PIXELFORMAT_INDEX8)
+    {
+        SDL_Palette *surface_palette = SDL_GetSurfacePalette(surface);
+        if (surface_palette == NULL)
+        {
+            SDL_Log("ERROR: Paletted image without a palette.");
+            return false;
+        }
+
+        // Indices past the palette end up opaque black.
+        for (int i = 0; i < 256; ++i)
+        {
+            SDL_Color color = i < surface_palette->ncolors
+                ? surface_palette->colors[i]
+                : (SDL_Color){ 0, 0, 0, SDL_ALPHA_OPAQUE };
+
+            palette[i] = ((Uint32)color.a << 24) | ((Uint32)color.b << 16) | ((Uint32)color.g << 8) | color.r;
+        }
+
+        row.palette = palette;
+    }
+
+    if (!SDL_LockSurface(surface))
+    {
+        SDL_Log("ERROR: Failed to lock the image. %s", SDL_GetError());
+        return false;
+    }
+
+    const Uint8 *src = surface->pixels;
+    Uint8 *out = dst;
+
+    for (int y = 0; y < surface->h; ++y)
+    {
+        convert((Uint32 *)out, src, surface->w, &row);
+        src += surface->pitch;
+        out += dst_pitch;
+    }
+
+    SDL_UnlockSurface(surface);
+    return true;
+}
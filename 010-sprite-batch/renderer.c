@@ -0,0 +1,457 @@
+#include "renderer.h"
+#include "scene.h"
+#include "sprite_batch.h"
+#include "texstream.h"
+#include "utils.h"
+
+#define CHECKER_TEXTURE_SIZE 512
+
+// Preference folder the baked tiles of loose images are kept in.
+#define TILES_CACHE_ORG "com.up"
+#define TILES_CACHE_APP "sprite-batch"
+
+// Uniforms of the Sprite.vert shader. Maps window pixels (origin top left)
+// into clip space.
+struct APP_SpriteUniforms {
+    float scale_x, scale_y;
+    float offset_x, offset_y;
+};
+
+// Add a baked texture from memory, for textures that only exist at
+// runtime or when the baked file can't be written.
+static Uint32
+APP_AddBakedTexture(struct APP_Context *ctx, SDL_Surface *surface, const char *name)
+{
+    SDL_IOStream *io = SDL_IOFromDynamicMem();
+    if (io == NULL)
+    {
+        SDL_Log("ERROR: Failed to create texture stream memory. %s", SDL_GetError());
+        return APP_TEXSTREAM_INVALID;
+    }
+
+    if (!APP_TextureStream_Bake(surface, io) || SDL_SeekIO(io, 0, SDL_IO_SEEK_SET) != 0)
+    {
+        SDL_CloseIO(io);
+        return APP_TEXSTREAM_INVALID;
+    }
+
+    return APP_TextureStream_Add(ctx->texture_stream, io, name);
+}
+
+// Stream an image from its baked tiles in the asset pack or next to it.
+// Without them the image is baked once into the user's preference folder,
+// the example never writes next to the executable.
+static Uint32
+APP_AddImageTexture(struct APP_Context *ctx, const char *image_filename, const char *tiles_filename, const char *name)
+{
+    char asset_path[256];
+    SDL_snprintf(asset_path, sizeof(asset_path), "images/%s", tiles_filename);
+
+    SDL_IOStream *io = APP_OpenAsset(ctx, asset_path);
+    if (io != NULL)
+    {
+        return APP_TextureStream_Add(ctx->texture_stream, io, name);
+    }
+
+    char full_path[256] = "";
+    char *pref_path = SDL_GetPrefPath(TILES_CACHE_ORG, TILES_CACHE_APP);
+    if (pref_path != NULL)
+    {
+        SDL_snprintf(full_path, sizeof(full_path), "%s%s", pref_path, tiles_filename);
+        SDL_free(pref_path);
+
+        io = SDL_IOFromFile(full_path, "rb");
+        if (io != NULL)
+        {
+            return APP_TextureStream_Add(ctx->texture_stream, io, name);
+        }
+    }
+
+    SDL_Surface *image = APP_LoadImage(ctx, image_filename, 4);
+    if (image == NULL)
+    {
+        SDL_Log("ERROR: Could not load image data.");
+        return APP_TEXSTREAM_INVALID;
+    }
+
+    Uint32 handle = APP_TEXSTREAM_INVALID;
+
+    io = full_path[0] != '\0' ? SDL_IOFromFile(full_path, "wb") : NULL;
+    if (io != NULL)
+    {
+        bool baked = APP_TextureStream_Bake(image, io);
+        SDL_CloseIO(io);
+
+        if (baked)
+        {
+            SDL_Log("INFO: Baked %s into %s", image_filename, full_path);
+            handle = APP_TextureStream_Add(ctx->texture_stream, SDL_IOFromFile(full_path, "rb"), name);
+        }
+    }
+
+    if (handle == APP_TEXSTREAM_INVALID)
+    {
+        SDL_Log("INFO: Can't write %s, streaming %s from memory", tiles_filename, image_filename);
+        handle = APP_AddBakedTexture(ctx, image, name);
+    }
+
+    SDL_DestroySurface(image);
+    return handle;
+}
+
+// Procedural checker board, the cells of the two colors alternate.
+static Uint32
+APP_AddCheckerTexture(
+        struct APP_Context *ctx,
+        Uint32 cell_size,
+        Uint32 color_a,
+        Uint32 color_b,
+        const char *name
+)
+{
+    SDL_Surface *surface = SDL_CreateSurface(CHECKER_TEXTURE_SIZE, CHECKER_TEXTURE_SIZE, SDL_PIXELFORMAT_ABGR8888);
+    if (surface == NULL)
+    {
+        SDL_Log("ERROR: Failed to create checker surface. %s", SDL_GetError());
+        return APP_TEXSTREAM_INVALID;
+    }
+
+    for (Uint32 y = 0; y < CHECKER_TEXTURE_SIZE; ++y)
+    {
+        Uint32 *row = (Uint32 *)((Uint8 *)surface->pixels + y * surface->pitch);
+
+        for (Uint32 x = 0; x < CHECKER_TEXTURE_SIZE; ++x)
+        {
+            bool odd = ((x / cell_size) + (y / cell_size)) % 2;
+            row[x] = odd ? color_b : color_a;
+        }
+    }
+
+    Uint32 handle = APP_AddBakedTexture(ctx, surface, name);
+    SDL_DestroySurface(surface);
+    return handle;
+}
+
+static int
+APP_CreateTextures(struct APP_Context *ctx)
+{
+    ctx->texture_stream = APP_TextureStream_Create(ctx->device, ctx->texture_budget);
+    if (ctx->texture_stream == NULL)
+    {
+        return -1;
+    }
+
+    // Note(john): Colors are ABGR8888, on little endian the bytes end up
+    // as RGBA in memory.
+    ctx->texture_handles[0] = APP_AddImageTexture(ctx, "default.qoi", "default.tiles", "Default");
+    ctx->texture_handles[1] = APP_AddCheckerTexture(ctx, CHECKER_TEXTURE_SIZE / 2, 0xFF3050E0, 0xFFE0A030, "Atlas");
+    ctx->texture_handles[2] = APP_AddCheckerTexture(ctx, CHECKER_TEXTURE_SIZE / 8, 0xFFFFFFFF, 0xFF404040, "Checker");
+
+    for (int i = 0; i < APP_SPRITE_TEXTURE_COUNT; ++i)
+    {
+        if (ctx->texture_handles[i] == APP_TEXSTREAM_INVALID)
+        {
+            return -1;
+        }
+
+        ctx->textures[i] = APP_TextureStream_GetTexture(ctx->texture_stream, ctx->texture_handles[i]);
+    }
+
+    return 0;
+}
+
+// Tell the stream how large every texture is on screen, a sprite with a
+// part of the texture (an atlas cell) needs the texels of the whole
+// texture at that density. Then stream and hand the new textures to the
+// batch.
+static void
+APP_StreamTextures(struct APP_Context *ctx, SDL_GPUCommandBuffer *cmd_buf)
+{
+    float screen_sizes[APP_SPRITE_TEXTURE_COUNT] = { 0 };
+
+    for (Uint32 i = 0; i < ctx->sprite_count; ++i)
+    {
+        const struct APP_Sprite *sprite = &ctx->sprites[i].sprite;
+
+        float size_u = sprite->scale_x / SDL_max(sprite->u1 - sprite->u0, 1.0f / 4096.0f);
+        float size_v = sprite->scale_y / SDL_max(sprite->v1 - sprite->v0, 1.0f / 4096.0f);
+        float size = SDL_max(size_u, size_v) * ctx->sprite_zoom;
+
+        screen_sizes[sprite->texture] = SDL_max(screen_sizes[sprite->texture], size);
+    }
+
+    for (int i = 0; i < APP_SPRITE_TEXTURE_COUNT; ++i)
+    {
+        if (screen_sizes[i] > 0.0f)
+        {
+            APP_TextureStream_Request(ctx->texture_stream, ctx->texture_handles[i], screen_sizes[i]);
+        }
+    }
+
+    APP_TextureStream_Update(ctx->texture_stream, cmd_buf);
+
+    for (int i = 0; i < APP_SPRITE_TEXTURE_COUNT; ++i)
+    {
+        ctx->textures[i] = APP_TextureStream_GetTexture(ctx->texture_stream, ctx->texture_handles[i]);
+        APP_SpriteBatch_SetTexture(ctx->sprite_batch, (Uint16)i, ctx->textures[i]);
+    }
+}
+
+static SDL_GPUGraphicsPipeline*
+APP_CreateSpritePipeline(
+        struct APP_Context *ctx,
+        SDL_GPUShader *vertex_shader,
+        SDL_GPUShader *fragment_shader
+)
+{
+    SDL_GPUGraphicsPipelineCreateInfo pipeline_create_info = {
+        .target_info = {
+            .num_color_targets = 1,
+            .color_target_descriptions = (SDL_GPUColorTargetDescription[]){
+                {
+                    .format = SDL_GetGPUSwapchainTextureFormat(ctx->device, ctx->window),
+                    .blend_state = {
+                        .enable_blend = true,
+                        .src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
+                        .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                        .color_blend_op = SDL_GPU_BLENDOP_ADD,
+                        .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                        .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                        .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
+                    }
+                }
+            },
+        },
+        // Note(john): Slot 0 is the unit quad of 005-uv-texture, slot 1 the
+        // sprite instances. The instance attributes follow the layout of
+        // struct APP_SpriteInstance.
+        .vertex_input_state = (SDL_GPUVertexInputState){
+            .num_vertex_buffers = 2,
+            .vertex_buffer_descriptions = (SDL_GPUVertexBufferDescription[]){
+                {
+                    .slot = 0,
+                    .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
+                    .instance_step_rate = 0,
+                    .pitch = sizeof(float) * 5
+                },
+                {
+                    .slot = 1,
+                    .input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE,
+                    .instance_step_rate = 0,
+                    .pitch = sizeof(struct APP_SpriteInstance)
+                }
+            },
+            .num_vertex_attributes = 7,
+            .vertex_attributes = (SDL_GPUVertexAttribute[]){
+                {
+                    .buffer_slot = 0,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+                    .location = 0,
+                    .offset = 0
+                },
+                {
+                    .buffer_slot = 0,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
+                    .location = 1,
+                    .offset = sizeof(float) * 3
+                },
+                {
+                    .buffer_slot = 1,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
+                    .location = 2,
+                    .offset = offsetof(struct APP_SpriteInstance, x)
+                },
+                {
+                    .buffer_slot = 1,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT,
+                    .location = 3,
+                    .offset = offsetof(struct APP_SpriteInstance, rotation)
+                },
+                {
+                    .buffer_slot = 1,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
+                    .location = 4,
+                    .offset = offsetof(struct APP_SpriteInstance, scale_x)
+                },
+                {
+                    .buffer_slot = 1,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
+                    .location = 5,
+                    .offset = offsetof(struct APP_SpriteInstance, u0)
+                },
+                {
+                    .buffer_slot = 1,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM,
+                    .location = 6,
+                    .offset = offsetof(struct APP_SpriteInstance, r)
+                }
+            }
+        },
+        .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+        .vertex_shader = vertex_shader,
+        .fragment_shader = fragment_shader
+    };
+
+    return SDL_CreateGPUGraphicsPipeline(ctx->device, &pipeline_create_info);
+}
+
+int
+APP_InitRenderer(struct APP_Context *ctx)
+{
+    SDL_GPUShader *vertex_shader = APP_LoadShader(ctx, "Sprite.vert", 0, 1, 0, 0);
+    if (vertex_shader == NULL)
+    {
+        SDL_Log("ERROR: Failed to create vertex shader.");
+        return -1;
+    }
+
+    SDL_GPUShader *fragment_shader = APP_LoadShader(ctx, "Sprite.frag", 1, 0, 0, 0);
+    if (fragment_shader == NULL)
+    {
+        SDL_Log("ERROR: Failed to create fragment shader.");
+        SDL_ReleaseGPUShader(ctx->device, vertex_shader);
+        return -1;
+    }
+
+    ctx->pipeline = APP_CreateSpritePipeline(ctx, vertex_shader, fragment_shader);
+
+    SDL_ReleaseGPUShader(ctx->device, vertex_shader);
+    SDL_ReleaseGPUShader(ctx->device, fragment_shader);
+
+    if (ctx->pipeline == NULL)
+    {
+        SDL_Log("ERROR: Failed to create pipeline. %s", SDL_GetError());
+        return -1;
+    }
+
+    ctx->sampler = SDL_CreateGPUSampler(
+            ctx->device,
+            &(SDL_GPUSamplerCreateInfo){
+                .min_filter     = SDL_GPU_FILTER_LINEAR,
+                .mag_filter     = SDL_GPU_FILTER_LINEAR,
+                .mipmap_mode    = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
+                .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+                .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+                .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+            }
+    );
+
+    if (APP_CreateTextures(ctx) == -1)
+    {
+        SDL_Log("ERROR: Failed to create textures.");
+        return -1;
+    }
+
+    ctx->sprite_batch = APP_SpriteBatch_Create(ctx->device, ctx->sprite_count);
+    if (ctx->sprite_batch == NULL)
+    {
+        SDL_Log("ERROR: Failed to create sprite batch.");
+        return -1;
+    }
+
+    // Note(john): The scene uses the texture index as the sprite texture id,
+    // they are added in order.
+    for (int i = 0; i < APP_SPRITE_TEXTURE_COUNT; ++i)
+    {
+        Uint16 texture;
+        if (!APP_SpriteBatch_AddTexture(ctx->sprite_batch, ctx->textures[i], &texture))
+        {
+            SDL_Log("ERROR: Failed to add sprite texture. %s", SDL_GetError());
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void
+APP_ReleaseRenderer(struct APP_Context *ctx)
+{
+    APP_SpriteBatch_Destroy(ctx->sprite_batch);
+
+    APP_TextureStream_Destroy(ctx->texture_stream);
+
+    SDL_ReleaseGPUSampler(ctx->device, ctx->sampler);
+    SDL_ReleaseGPUGraphicsPipeline(ctx->device, ctx->pipeline);
+}
+
+int
+APP_Draw(struct APP_Context *ctx)
+{
+    SDL_GPUCommandBuffer *cmd_buf = SDL_AcquireGPUCommandBuffer(ctx->device);
+    if (cmd_buf == NULL)
+    {
+        SDL_Log("ERROR: Failed to acquire gpu command buffer. %s", SDL_GetError());
+        return -1;
+    }
+
+    SDL_GPUTexture *swapchain_texture;
+    if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmd_buf, ctx->window, &swapchain_texture, NULL, NULL))
+    {
+        SDL_Log("ERROR: Failed to acquire gpu swapchain texture. %s", SDL_GetError());
+        return -1;
+    }
+
+    APP_StreamTextures(ctx, cmd_buf);
+
+    if (swapchain_texture != NULL)
+    {
+        Uint64 batch_start = SDL_GetPerformanceCounter();
+
+        APP_SpriteBatch_Begin(ctx->sprite_batch);
+
+        if (ctx->sprite_zoom == 1.0f)
+        {
+            for (Uint32 i = 0; i < ctx->sprite_count; ++i)
+            {
+                APP_SpriteBatch_Draw(ctx->sprite_batch, &ctx->sprites[i].sprite);
+            }
+        }
+        else
+        {
+            for (Uint32 i = 0; i < ctx->sprite_count; ++i)
+            {
+                struct APP_Sprite sprite = ctx->sprites[i].sprite;
+                sprite.scale_x *= ctx->sprite_zoom;
+                sprite.scale_y *= ctx->sprite_zoom;
+                APP_SpriteBatch_Draw(ctx->sprite_batch, &sprite);
+            }
+        }
+
+        // Note(john): End records the instance upload into a copy pass, so
+        // it has to happen before the render pass begins.
+        APP_SpriteBatch_End(ctx->sprite_batch, cmd_buf);
+
+        SDL_GPUColorTargetInfo color_target_info = { 0 };
+        color_target_info.texture = swapchain_texture;
+        color_target_info.clear_color = (SDL_FColor){ 0.1f, 0.1f, 0.1f, 1.0f };
+        color_target_info.load_op = SDL_GPU_LOADOP_CLEAR;
+        color_target_info.store_op = SDL_GPU_STOREOP_STORE;
+
+        SDL_GPURenderPass *render_pass = SDL_BeginGPURenderPass(cmd_buf, &color_target_info, 1, NULL);
+
+        SDL_BindGPUGraphicsPipeline(render_pass, ctx->pipeline);
+
+        // The sprites are placed in pixels of the initial window size, a
+        // resized window stretches the whole scene.
+        struct APP_SpriteUniforms uniforms = {
+            .scale_x  = 2.0f / APP_WINDOW_WIDTH,
+            .scale_y  = -2.0f / APP_WINDOW_HEIGHT,
+            .offset_x = -1.0f,
+            .offset_y = 1.0f,
+        };
+
+        SDL_PushGPUVertexUniformData(cmd_buf, 0, &uniforms, sizeof(uniforms));
+
+        APP_SpriteBatch_Render(ctx->sprite_batch, render_pass, ctx->sampler);
+
+        SDL_EndGPURenderPass(render_pass);
+
+        ctx->stats.batch_ticks += SDL_GetPerformanceCounter() - batch_start;
+        ctx->stats.batches = ctx->sprite_batch->batch_count;
+    }
+
+    SDL_SubmitGPUCommandBuffer(cmd_buf);
+
+    return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "app.h"
+
+int APP_InitRenderer(struct APP_Context *ctx);
+void APP_ReleaseRenderer(struct APP_Context *ctx);
+int APP_Draw(struct APP_Context *ctx);
+
+#endif
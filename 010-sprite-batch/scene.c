@@ -0,0 +1,105 @@
+#include "scene.h"
+
+#define SPRITE_MIN_SIZE 8.0f
+#define SPRITE_MAX_SIZE 24.0f
+#define SPRITE_MAX_SPEED 120.0f
+#define SPRITE_LAYER_COUNT 4
+
+static float
+APP_RandomRange(float min, float max)
+{
+    return min + (max - min) * SDL_randf();
+}
+
+// Create count sprites with a random texture, layer, tint and velocity.
+// The second texture is a 2x2 atlas, its sprites pick one of the cells.
+int
+APP_CreateSprites(struct APP_Context *ctx, Uint32 count)
+{
+    ctx->sprites = SDL_malloc(sizeof(struct APP_MovingSprite) * count);
+    if (ctx->sprites == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate %u sprites.", count);
+        return -1;
+    }
+
+    // Note(john): Fixed seed, so every run of the benchmark draws the same
+    // sprites.
+    SDL_srand(42);
+
+    for (Uint32 i = 0; i < count; ++i)
+    {
+        struct APP_MovingSprite *moving = &ctx->sprites[i];
+        struct APP_Sprite *sprite = &moving->sprite;
+        float size = APP_RandomRange(SPRITE_MIN_SIZE, SPRITE_MAX_SIZE);
+
+        sprite->x = APP_RandomRange(0.0f, APP_WINDOW_WIDTH);
+        sprite->y = APP_RandomRange(0.0f, APP_WINDOW_HEIGHT);
+        sprite->rotation = APP_RandomRange(0.0f, 2.0f * SDL_PI_F);
+        sprite->scale_x = size;
+        sprite->scale_y = size;
+        sprite->texture = (Uint16)SDL_rand(APP_SPRITE_TEXTURE_COUNT);
+        sprite->layer = (Uint16)SDL_rand(SPRITE_LAYER_COUNT);
+
+        sprite->u0 = 0.0f;
+        sprite->v0 = 0.0f;
+        sprite->u1 = 1.0f;
+        sprite->v1 = 1.0f;
+
+        if (sprite->texture == 1)
+        {
+            int cell = SDL_rand(4);
+            sprite->u0 = (cell % 2) * 0.5f;
+            sprite->v0 = (cell / 2) * 0.5f;
+            sprite->u1 = sprite->u0 + 0.5f;
+            sprite->v1 = sprite->v0 + 0.5f;
+        }
+
+        sprite->r = (Uint8)(128 + SDL_rand(128));
+        sprite->g = (Uint8)(128 + SDL_rand(128));
+        sprite->b = (Uint8)(128 + SDL_rand(128));
+        sprite->a = 255;
+
+        moving->velocity_x = APP_RandomRange(-SPRITE_MAX_SPEED, SPRITE_MAX_SPEED);
+        moving->velocity_y = APP_RandomRange(-SPRITE_MAX_SPEED, SPRITE_MAX_SPEED);
+        moving->spin = APP_RandomRange(-2.0f, 2.0f);
+    }
+
+    ctx->sprite_count = count;
+    return 0;
+}
+
+void
+APP_ReleaseSprites(struct APP_Context *ctx)
+{
+    SDL_free(ctx->sprites);
+    ctx->sprites = NULL;
+    ctx->sprite_count = 0;
+}
+
+// Move the sprites and let them bounce off the window borders.
+void
+APP_UpdateSprites(struct APP_Context *ctx, float delta_time)
+{
+    for (Uint32 i = 0; i < ctx->sprite_count; ++i)
+    {
+        struct APP_MovingSprite *moving = &ctx->sprites[i];
+        struct APP_Sprite *sprite = &moving->sprite;
+
+        sprite->x += moving->velocity_x * delta_time;
+        sprite->y += moving->velocity_y * delta_time;
+        sprite->rotation += moving->spin * delta_time;
+
+        if (sprite->x < 0.0f || sprite->x > APP_WINDOW_WIDTH)
+        {
+            moving->velocity_x = -moving->velocity_x;
+            sprite->x = SDL_clamp(sprite->x, 0.0f, (float)APP_WINDOW_WIDTH);
+        }
+
+        if (sprite->y < 0.0f || sprite->y > APP_WINDOW_HEIGHT)
+        {
+            moving->velocity_y = -moving->velocity_y;
+            sprite->y = SDL_clamp(sprite->y, 0.0f, (float)APP_WINDOW_HEIGHT);
+        }
+    }
+}
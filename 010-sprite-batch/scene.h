@@ -0,0 +1,18 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "app.h"
+#include "sprite_batch.h"
+
+// A sprite bouncing around in the window.
+struct APP_MovingSprite {
+    struct APP_Sprite sprite;
+    float velocity_x, velocity_y;
+    float spin;
+};
+
+int APP_CreateSprites(struct APP_Context *ctx, Uint32 count);
+void APP_ReleaseSprites(struct APP_Context *ctx);
+void APP_UpdateSprites(struct APP_Context *ctx, float delta_time);
+
+#endif
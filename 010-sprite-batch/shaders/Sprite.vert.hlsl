@@ -0,0 +1,40 @@
+cbuffer UniformBlock : register(b0, space1)
+{
+    // xy scales window pixels into clip space, zw is the offset.
+    float4 ScreenTransform : packoffset(c0);
+};
+
+struct Input
+{
+    float3 Position : TEXCOORD0;
+    float2 TexCoord : TEXCOORD1;
+
+    // Per instance, see struct APP_SpriteInstance.
+    float2 Translation : TEXCOORD2;
+    float Rotation : TEXCOORD3;
+    float2 Scale : TEXCOORD4;
+    float4 UVRect : TEXCOORD5;
+    float4 Color : TEXCOORD6;
+};
+
+struct Output
+{
+    float2 TexCoord : TEXCOORD0;
+    float4 Color : TEXCOORD1;
+    float4 Position : SV_Position;
+};
+
+Output main(Input input)
+{
+    float s, c;
+    sincos(input.Rotation, s, c);
+
+    float2 local = input.Position.xy * input.Scale;
+    float2 world = float2(local.x * c - local.y * s, local.x * s + local.y * c) + input.Translation;
+
+    Output output;
+    output.TexCoord = lerp(input.UVRect.xy, input.UVRect.zw, input.TexCoord);
+    output.Color = input.Color;
+    output.Position = float4(world * ScreenTransform.xy + ScreenTransform.zw, 0.0f, 1.0f);
+    return output;
+}
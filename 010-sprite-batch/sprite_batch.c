@@ -0,0 +1,463 @@
+#include "sprite_batch.h"
+#include "app.h"
+
+struct APP_QuadVertex {
+    float x, y, z;
+    float u, v;
+};
+
+// Note(john): Sort key is layer in the upper and texture in the lower 16
+// bits, so the draw order follows the layers and sprites of one layer are
+// grouped by texture.
+#define APP_SPRITE_SORT_KEY(sprite) (((Uint32)(sprite)->layer << 16) | (Uint32)(sprite)->texture)
+
+static bool
+APP_SpriteBatch_Reserve(struct APP_SpriteBatch *batch, Uint32 capacity)
+{
+    if (capacity <= batch->sprite_capacity)
+    {
+        return true;
+    }
+
+    Uint32 new_capacity = SDL_max(batch->sprite_capacity * 2, capacity);
+
+    struct APP_Sprite *sprites = SDL_realloc(batch->sprites, sizeof(struct APP_Sprite) * new_capacity);
+    if (sprites == NULL)
+    {
+        return false;
+    }
+    batch->sprites = sprites;
+
+    Uint32 **arrays[] = { &batch->keys, &batch->indices, &batch->scratch_keys, &batch->scratch_indices };
+    for (size_t i = 0; i < SDL_arraysize(arrays); ++i)
+    {
+        Uint32 *array = SDL_realloc(*arrays[i], sizeof(Uint32) * new_capacity);
+        if (array == NULL)
+        {
+            return false;
+        }
+        *arrays[i] = array;
+    }
+
+    struct APP_SpriteDrawBatch *batches = SDL_realloc(batch->batches, sizeof(struct APP_SpriteDrawBatch) * new_capacity);
+    if (batches == NULL)
+    {
+        return false;
+    }
+    batch->batches = batches;
+
+    batch->sprite_capacity = new_capacity;
+    return true;
+}
+
+// Grow the GPU instance buffer and its transfer buffer. Old buffers are
+// released right away, SDL keeps them alive until the GPU is done with them.
+static bool
+APP_SpriteBatch_ReserveInstances(struct APP_SpriteBatch *batch, Uint32 capacity)
+{
+    if (capacity <= batch->instance_capacity)
+    {
+        return true;
+    }
+
+    Uint32 new_capacity = SDL_max(batch->instance_capacity * 2, capacity);
+    Uint32 size = sizeof(struct APP_SpriteInstance) * new_capacity;
+
+    SDL_ReleaseGPUBuffer(batch->device, batch->instance_buffer);
+    SDL_ReleaseGPUTransferBuffer(batch->device, batch->instance_transfer_buffer);
+
+    batch->instance_buffer = SDL_CreateGPUBuffer(
+            batch->device,
+            &(SDL_GPUBufferCreateInfo){
+                .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+                .size = size
+            }
+    );
+
+    batch->instance_transfer_buffer = SDL_CreateGPUTransferBuffer(
+            batch->device,
+            &(SDL_GPUTransferBufferCreateInfo){
+                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                .size = size
+            }
+    );
+
+    if (batch->instance_buffer == NULL || batch->instance_transfer_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create sprite instance buffers. %s", SDL_GetError());
+        batch->instance_capacity = 0;
+        return false;
+    }
+
+    SDL_SetGPUBufferName(batch->device, batch->instance_buffer, "Sprite Instances");
+
+    batch->instance_capacity = new_capacity;
+    return true;
+}
+
+// LSD radix sort of the keys (8 bits per pass), indices are moved along.
+// Passes where every key has the same digit are skipped, with only a few
+// layers and textures most of the passes fall away.
+static void
+APP_RadixSort(Uint32 *keys, Uint32 *indices, Uint32 *scratch_keys, Uint32 *scratch_indices, Uint32 count)
+{
+    Uint32 *src_keys = keys;
+    Uint32 *src_indices = indices;
+    Uint32 *dst_keys = scratch_keys;
+    Uint32 *dst_indices = scratch_indices;
+
+    for (Uint32 shift = 0; shift < 32; shift += 8)
+    {
+        Uint32 histogram[256] = { 0 };
+
+        for (Uint32 i = 0; i < count; ++i)
+        {
+            histogram[(src_keys[i] >> shift) & 0xFF]++;
+        }
+
+        if (histogram[(src_keys[0] >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        Uint32 offset = 0;
+        for (Uint32 digit = 0; digit < 256; ++digit)
+        {
+            Uint32 digit_count = histogram[digit];
+            histogram[digit] = offset;
+            offset += digit_count;
+        }
+
+        for (Uint32 i = 0; i < count; ++i)
+        {
+            Uint32 slot = histogram[(src_keys[i] >> shift) & 0xFF]++;
+            dst_keys[slot] = src_keys[i];
+            dst_indices[slot] = src_indices[i];
+        }
+
+        Uint32 *swap_keys = src_keys;
+        Uint32 *swap_indices = src_indices;
+        src_keys = dst_keys;
+        src_indices = dst_indices;
+        dst_keys = swap_keys;
+        dst_indices = swap_indices;
+    }
+
+    if (src_keys != keys)
+    {
+        SDL_memcpy(keys, src_keys, sizeof(Uint32) * count);
+        SDL_memcpy(indices, src_indices, sizeof(Uint32) * count);
+    }
+}
+
+struct APP_SpriteBatch*
+APP_SpriteBatch_Create(SDL_GPUDevice *device, Uint32 initial_capacity)
+{
+    struct APP_SpriteBatch *batch = SDL_calloc(1, sizeof(struct APP_SpriteBatch));
+    if (batch == NULL)
+    {
+        return NULL;
+    }
+
+    batch->device = device;
+
+    if (!APP_SpriteBatch_Reserve(batch, initial_capacity)
+        || !APP_SpriteBatch_ReserveInstances(batch, initial_capacity))
+    {
+        APP_SpriteBatch_Destroy(batch);
+        return NULL;
+    }
+
+    // Same quad as in 005-uv-texture, centered around the origin so
+    // rotation and scale happen around the sprite center.
+    batch->quad_vertex_buffer = SDL_CreateGPUBuffer(
+            device,
+            &(SDL_GPUBufferCreateInfo){
+                .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+                .size  = sizeof(struct APP_QuadVertex) * 4,
+            }
+    );
+
+    batch->quad_index_buffer = SDL_CreateGPUBuffer(
+            device, 
+            &(SDL_GPUBufferCreateInfo){ 
+                .usage = SDL_GPU_BUFFERUSAGE_INDEX, 
+                .size = sizeof(Uint16) * 6 
+            }
+    );
+
+    if (batch->quad_vertex_buffer == NULL || batch->quad_index_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create sprite quad buffers. %s", SDL_GetError());
+        APP_SpriteBatch_Destroy(batch);
+        return NULL;
+    }
+
+    SDL_GPUTransferBuffer *transfer_buffer = SDL_CreateGPUTransferBuffer(
+            device,
+            &(SDL_GPUTransferBufferCreateInfo){ 
+                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                .size  = (sizeof(struct APP_QuadVertex) * 4) + (sizeof(Uint16) * 6) 
+            }
+    );
+
+    struct APP_QuadVertex *transfer_data = SDL_MapGPUTransferBuffer(device, transfer_buffer, false);
+
+    transfer_data[0] = (struct APP_QuadVertex){ -0.5f, -0.5f, 0, 0, 0 };
+    transfer_data[1] = (struct APP_QuadVertex){ 0.5f, -0.5f, 0, 1, 0 };
+    transfer_data[2] = (struct APP_QuadVertex){ 0.5f, 0.5f, 0, 1, 1 };
+    transfer_data[3] = (struct APP_QuadVertex){ -0.5f, 0.5f, 0, 0, 1 };
+
+    Uint16 *index_data = (Uint16 *)&transfer_data[4];
+
+    index_data[0] = 0;
+    index_data[1] = 1;
+    index_data[2] = 2;
+    index_data[3] = 0;
+    index_data[4] = 2;
+    index_data[5] = 3;
+
+    SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
+
+    SDL_GPUCommandBuffer *upload_cmd_buffer = SDL_AcquireGPUCommandBuffer(device);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(upload_cmd_buffer);
+
+    SDL_UploadToGPUBuffer(
+            copy_pass,
+            &(SDL_GPUTransferBufferLocation){ 
+                .transfer_buffer = transfer_buffer, 
+                .offset = 0 
+            },
+            &(SDL_GPUBufferRegion){ 
+                .buffer = batch->quad_vertex_buffer, 
+                .offset = 0, 
+                .size = sizeof(struct APP_QuadVertex) * 4 
+            },
+            false
+    );
+
+    SDL_UploadToGPUBuffer(
+            copy_pass,
+            &(SDL_GPUTransferBufferLocation){ 
+                .transfer_buffer = transfer_buffer,
+                .offset          = sizeof(struct APP_QuadVertex) * 4 
+            },
+            &(SDL_GPUBufferRegion){ 
+                .buffer = batch->quad_index_buffer, 
+                .offset = 0, .size = sizeof(Uint16) * 6 
+            },
+            false
+    );
+
+    SDL_EndGPUCopyPass(copy_pass);
+    SDL_SubmitGPUCommandBuffer(upload_cmd_buffer);
+    SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
+
+    return batch;
+}
+
+void
+APP_SpriteBatch_Destroy(struct APP_SpriteBatch *batch)
+{
+    if (batch == NULL)
+    {
+        return;
+    }
+
+    SDL_ReleaseGPUBuffer(batch->device, batch->quad_vertex_buffer);
+    SDL_ReleaseGPUBuffer(batch->device, batch->quad_index_buffer);
+    SDL_ReleaseGPUBuffer(batch->device, batch->instance_buffer);
+    SDL_ReleaseGPUTransferBuffer(batch->device, batch->instance_transfer_buffer);
+
+    SDL_free(batch->sprites);
+    SDL_free(batch->keys);
+    SDL_free(batch->indices);
+    SDL_free(batch->scratch_keys);
+    SDL_free(batch->scratch_indices);
+    SDL_free(batch->batches);
+    SDL_free(batch);
+}
+
+// The batch doesn't own the texture, the id in out_texture goes into
+// APP_Sprite.texture. Fails once APP_SPRITE_BATCH_MAX_TEXTURES are added.
+bool
+APP_SpriteBatch_AddTexture(struct APP_SpriteBatch *batch, SDL_GPUTexture *texture, Uint16 *out_texture)
+{
+    if (batch->texture_count == APP_SPRITE_BATCH_MAX_TEXTURES)
+    {
+        SDL_SetError("Sprite batch is out of texture slots (%d)", APP_SPRITE_BATCH_MAX_TEXTURES);
+        return false;
+    }
+
+    batch->textures[batch->texture_count] = texture;
+    *out_texture = (Uint16)batch->texture_count++;
+    return true;
+}
+
+// Swap the texture behind an id, e.g. after the texture stream replaced it.
+void
+APP_SpriteBatch_SetTexture(struct APP_SpriteBatch *batch, Uint16 texture, SDL_GPUTexture *gpu_texture)
+{
+    SDL_assert(texture < batch->texture_count);
+
+    batch->textures[texture] = gpu_texture;
+}
+
+void
+APP_SpriteBatch_Begin(struct APP_SpriteBatch *batch)
+{
+    batch->sprite_count = 0;
+    batch->batch_count = 0;
+}
+
+void
+APP_SpriteBatch_Draw(struct APP_SpriteBatch *batch, const struct APP_Sprite *sprite)
+{
+    if (batch->sprite_count == batch->sprite_capacity
+        && !APP_SpriteBatch_Reserve(batch, batch->sprite_count + 1))
+    {
+        SDL_Log("ERROR: Failed to grow sprite batch.");
+        return;
+    }
+
+    batch->sprites[batch->sprite_count++] = *sprite;
+}
+
+// Sort the submitted sprites by layer and texture, write them in that order
+// into the instance buffer and upload it. Has to be called outside of a
+// render pass, APP_SpriteBatch_Render then draws one instanced call per run
+// of sprites sharing a texture.
+bool
+APP_SpriteBatch_End(struct APP_SpriteBatch *batch, SDL_GPUCommandBuffer *cmd_buffer)
+{
+    Uint32 count = batch->sprite_count;
+    if (count == 0)
+    {
+        return true;
+    }
+
+    for (Uint32 i = 0; i < count; ++i)
+    {
+        batch->keys[i] = APP_SPRITE_SORT_KEY(&batch->sprites[i]);
+        batch->indices[i] = i;
+    }
+
+    APP_RadixSort(batch->keys, batch->indices, batch->scratch_keys, batch->scratch_indices, count);
+
+    if (!APP_SpriteBatch_ReserveInstances(batch, count))
+    {
+        return false;
+    }
+
+    // Note(john): Cycle the transfer buffer so we don't stall on the upload
+    // of the previous frame that may still be in flight.
+    struct APP_SpriteInstance *instances = SDL_MapGPUTransferBuffer(
+            batch->device,
+            batch->instance_transfer_buffer,
+            true
+    );
+
+    if (instances == NULL)
+    {
+        SDL_Log("ERROR: Failed to map sprite transfer buffer. %s", SDL_GetError());
+        return false;
+    }
+
+    struct APP_SpriteDrawBatch *current = NULL;
+
+    for (Uint32 i = 0; i < count; ++i)
+    {
+        const struct APP_Sprite *sprite = &batch->sprites[batch->indices[i]];
+
+        instances[i] = (struct APP_SpriteInstance){
+            sprite->x, sprite->y,
+            sprite->rotation,
+            sprite->scale_x, sprite->scale_y,
+            sprite->u0, sprite->v0, sprite->u1, sprite->v1,
+            sprite->r, sprite->g, sprite->b, sprite->a
+        };
+
+        if (current == NULL || current->texture != sprite->texture)
+        {
+            current = &batch->batches[batch->batch_count++];
+            current->first_instance = i;
+            current->instance_count = 0;
+            current->texture = sprite->texture;
+        }
+
+        current->instance_count++;
+    }
+
+    SDL_UnmapGPUTransferBuffer(batch->device, batch->instance_transfer_buffer);
+
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(cmd_buffer);
+
+    SDL_UploadToGPUBuffer(
+            copy_pass,
+            &(SDL_GPUTransferBufferLocation){ 
+                .transfer_buffer = batch->instance_transfer_buffer, 
+                .offset = 0 
+            },
+            &(SDL_GPUBufferRegion){ 
+                .buffer = batch->instance_buffer, 
+                .offset = 0, 
+                .size = sizeof(struct APP_SpriteInstance) * count 
+            },
+            true
+    );
+
+    SDL_EndGPUCopyPass(copy_pass);
+
+    return true;
+}
+
+// Expects the sprite pipeline to be bound.
+void
+APP_SpriteBatch_Render(
+        struct APP_SpriteBatch *batch,
+        SDL_GPURenderPass *render_pass,
+        SDL_GPUSampler *sampler
+)
+{
+    SDL_BindGPUIndexBuffer(
+            render_pass,
+            &(SDL_GPUBufferBinding){ 
+                .buffer = batch->quad_index_buffer, 
+                .offset = 0 
+            },
+            SDL_GPU_INDEXELEMENTSIZE_16BIT
+    );
+
+    for (Uint32 i = 0; i < batch->batch_count; ++i)
+    {
+        const struct APP_SpriteDrawBatch *draw = &batch->batches[i];
+
+        // Note(john): The instance buffer is bound at the first instance
+        // of the batch instead of relying on first_instance, which not every
+        // backend applies to instance rate attributes.
+        SDL_BindGPUVertexBuffers(
+                render_pass,
+                0,
+                (SDL_GPUBufferBinding[]){
+                    { .buffer = batch->quad_vertex_buffer, .offset = 0 },
+                    { 
+                        .buffer = batch->instance_buffer, 
+                        .offset = draw->first_instance * sizeof(struct APP_SpriteInstance) 
+                    },
+                },
+                2
+        );
+
+        SDL_BindGPUFragmentSamplers(
+                render_pass,
+                0,
+                &(SDL_GPUTextureSamplerBinding){
+                    .texture = batch->textures[draw->texture],
+                    .sampler = sampler,
+                },
+                1
+        );
+
+        SDL_DrawGPUIndexedPrimitives(render_pass, 6, draw->instance_count, 0, 0, 0);
+    }
+}
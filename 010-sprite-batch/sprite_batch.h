@@ -0,0 +1,77 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include "app.h"
+
+#define APP_SPRITE_BATCH_MAX_TEXTURES 256
+
+struct APP_Sprite {
+    float x, y;
+    float rotation;
+    float scale_x, scale_y;
+    // Normalized texture rect, u0/v0 is the top left corner.
+    float u0, v0, u1, v1;
+    Uint8 r, g, b, a;
+    Uint16 layer;
+    Uint16 texture;
+};
+
+// Per instance vertex data of the Sprite.vert shader.
+struct APP_SpriteInstance {
+    float x, y;
+    float rotation;
+    float scale_x, scale_y;
+    float u0, v0, u1, v1;
+    Uint8 r, g, b, a;
+};
+
+struct APP_SpriteDrawBatch {
+    Uint32 first_instance;
+    Uint32 instance_count;
+    Uint16 texture;
+};
+
+struct APP_SpriteBatch {
+    SDL_GPUDevice *device;
+
+    SDL_GPUTexture *textures[APP_SPRITE_BATCH_MAX_TEXTURES];
+    Uint32 texture_count;
+
+    struct APP_Sprite *sprites;
+    Uint32 sprite_count;
+    Uint32 sprite_capacity;
+
+    // Sort keys and sprite indices, the second pair is the radix sort
+    // scratch space.
+    Uint32 *keys;
+    Uint32 *indices;
+    Uint32 *scratch_keys;
+    Uint32 *scratch_indices;
+
+    struct APP_SpriteDrawBatch *batches;
+    Uint32 batch_count;
+
+    SDL_GPUBuffer *quad_vertex_buffer;
+    SDL_GPUBuffer *quad_index_buffer;
+    SDL_GPUBuffer *instance_buffer;
+    SDL_GPUTransferBuffer *instance_transfer_buffer;
+    Uint32 instance_capacity;
+};
+
+struct APP_SpriteBatch *APP_SpriteBatch_Create(SDL_GPUDevice *device, Uint32 initial_capacity);
+void APP_SpriteBatch_Destroy(struct APP_SpriteBatch *batch);
+
+bool APP_SpriteBatch_AddTexture(struct APP_SpriteBatch *batch, SDL_GPUTexture *texture, Uint16 *out_texture);
+void APP_SpriteBatch_SetTexture(struct APP_SpriteBatch *batch, Uint16 texture, SDL_GPUTexture *gpu_texture);
+
+void APP_SpriteBatch_Begin(struct APP_SpriteBatch *batch);
+void APP_SpriteBatch_Draw(struct APP_SpriteBatch *batch, const struct APP_Sprite *sprite);
+bool APP_SpriteBatch_End(struct APP_SpriteBatch *batch, SDL_GPUCommandBuffer *cmd_buffer);
+
+void APP_SpriteBatch_Render(
+        struct APP_SpriteBatch *batch,
+        SDL_GPURenderPass *render_pass,
+        SDL_GPUSampler *sampler
+);
+
+#endif
@@ -0,0 +1,1105 @@
+#include "texstream.h"
+
+#define APP_TEXSTREAM_MAGIC SDL_FOURCC('T', 'X', 'S', 'T')
+#define APP_TEXSTREAM_VERSION 1
+
+// Note(john): Some backends want texture uploads from 512 byte aligned
+// offsets, so every tile starts at one in the transfer buffer.
+#define APP_TEXSTREAM_UPLOAD_ALIGNMENT 512
+
+#define APP_ALIGN_UP(value, alignment) (((value) + (alignment) - 1) & ~((alignment) - 1))
+
+struct APP_StreamedTile {
+    Uint32 x, y;
+    Uint32 width, height;
+    // Where the tile is stored in the baked file, rows tightly packed.
+    Uint32 file_offset;
+    Uint32 size;
+    // Offset into the transfer buffer of its mip.
+    Uint32 upload_offset;
+};
+
+struct APP_StreamedMip {
+    Uint32 width, height;
+    Uint32 first_tile;
+    Uint32 tile_count;
+    Uint32 upload_size;
+    // Last frame a sprite on screen needed this mip.
+    Uint64 last_needed;
+};
+
+struct APP_StreamedTexture {
+    char name[32];
+    SDL_IOStream *io;
+
+    Uint32 mip_count;
+    // The first mip that fits into a single tile, it and all smaller mips
+    // are always resident.
+    Uint32 tail_mip;
+    struct APP_StreamedMip mips[APP_TEXSTREAM_MAX_MIPS];
+    struct APP_StreamedTile *tiles;
+
+    // Holds the mips resident_mip to mip_count - 1, level 0 of the texture
+    // is resident_mip.
+    SDL_GPUTexture *texture;
+    Uint32 resident_mip;
+    Uint32 wanted_mip;
+    float screen_size;
+
+    bool in_flight;
+    bool failed;
+};
+
+enum APP_TextureRequestState {
+    APP_TEXTURE_REQUEST_FREE,
+    APP_TEXTURE_REQUEST_QUEUED,
+    APP_TEXTURE_REQUEST_READING,
+    APP_TEXTURE_REQUEST_DONE,
+    APP_TEXTURE_REQUEST_FAILED
+};
+
+// One mip on its way in. The I/O thread reads the tiles straight into the
+// mapped transfer buffer.
+struct APP_TextureRequest {
+    enum APP_TextureRequestState state;
+    Uint32 texture;
+    Uint32 mip;
+    SDL_GPUTransferBuffer *transfer_buffer;
+    Uint8 *data;
+    Uint64 issued;
+};
+
+struct APP_TextureStream {
+    SDL_GPUDevice *device;
+    Uint64 budget_bytes;
+    Uint64 frame;
+
+    struct APP_StreamedTexture textures[APP_TEXSTREAM_MAX_TEXTURES];
+    Uint32 texture_count;
+
+    // Bytes of all resident mips and of the mips in flight.
+    Uint64 resident_bytes;
+    Uint64 reserved_bytes;
+    Uint64 high_water_bytes;
+
+    Uint32 loaded_mips;
+    Uint32 evicted_mips;
+    Uint32 budget_misses;
+    Uint64 streamed_bytes;
+
+    Uint64 window_start;
+    Uint64 window_read_bytes;
+    Uint64 window_latency_ticks;
+    Uint32 window_loaded;
+
+    // The requests and the counters the I/O thread writes are guarded by
+    // the lock.
+    SDL_Mutex *lock;
+    SDL_Condition *wake;
+    SDL_Thread *thread;
+    bool quit;
+    struct APP_TextureRequest requests[APP_TEXSTREAM_MAX_REQUESTS];
+};
+
+static Uint64
+APP_MipBytes(const struct APP_StreamedMip *mip)
+{
+    return (Uint64)mip->width * mip->height * 4;
+}
+
+// Bytes of the mips first_mip to the last one.
+static Uint64
+APP_ChainBytes(const struct APP_StreamedTexture *texture, Uint32 first_mip)
+{
+    Uint64 bytes = 0;
+
+    for (Uint32 i = first_mip; i < texture->mip_count; ++i)
+    {
+        bytes += APP_MipBytes(&texture->mips[i]);
+    }
+
+    return bytes;
+}
+
+// ====================
+// Baking
+// ====================
+
+// 2x2 box filter, odd sizes repeat the last row or column.
+static void
+APP_DownsampleMip(const Uint32 *src, Uint32 src_width, Uint32 src_height, Uint32 *dst, Uint32 width, Uint32 height)
+{
+    for (Uint32 y = 0; y < height; ++y)
+    {
+        Uint32 y0 = SDL_min(y * 2, src_height - 1);
+        Uint32 y1 = SDL_min(y * 2 + 1, src_height - 1);
+
+        for (Uint32 x = 0; x < width; ++x)
+        {
+            Uint32 x0 = SDL_min(x * 2, src_width - 1);
+            Uint32 x1 = SDL_min(x * 2 + 1, src_width - 1);
+
+            Uint32 p[4] = {
+                src[y0 * src_width + x0],
+                src[y0 * src_width + x1],
+                src[y1 * src_width + x0],
+                src[y1 * src_width + x1]
+            };
+
+            Uint32 result = 0;
+            for (Uint32 shift = 0; shift < 32; shift += 8)
+            {
+                Uint32 sum = ((p[0] >> shift) & 0xFF) + ((p[1] >> shift) & 0xFF)
+                    + ((p[2] >> shift) & 0xFF) + ((p[3] >> shift) & 0xFF);
+                result |= ((sum + 2) / 4) << shift;
+            }
+
+            dst[y * width + x] = result;
+        }
+    }
+}
+
+static Uint32
+APP_TileCount(Uint32 size, Uint32 tile_size)
+{
+    return (size + tile_size - 1) / tile_size;
+}
+
+// File layout, all values little endian Uint32:
+//   magic, version, width, height, mip count, tile size
+//   per mip: width, height
+//   per tile of every mip, mip 0 first, rows top to bottom: offset, size
+//   tile pixels, ABGR8888 rows of the tile tightly packed
+bool
+APP_TextureStream_Bake(SDL_Surface *surface, SDL_IOStream *out)
+{
+    if (surface->format != SDL_PIXELFORMAT_ABGR8888)
+    {
+        SDL_Log("ERROR: Texture streams are baked from ABGR8888 surfaces.");
+        return false;
+    }
+
+    Uint32 *pixels[APP_TEXSTREAM_MAX_MIPS] = { 0 };
+    Uint32 widths[APP_TEXSTREAM_MAX_MIPS];
+    Uint32 heights[APP_TEXSTREAM_MAX_MIPS];
+    Uint32 mip_count = 0;
+    Uint32 tile_count = 0;
+    bool result = false;
+
+    widths[0] = (Uint32)surface->w;
+    heights[0] = (Uint32)surface->h;
+
+    for (;;)
+    {
+        Uint32 width = widths[mip_count];
+        Uint32 height = heights[mip_count];
+
+        pixels[mip_count] = SDL_malloc((size_t)width * height * 4);
+        if (pixels[mip_count] == NULL)
+        {
+            SDL_Log("ERROR: Failed to allocate mip %u.", mip_count);
+            goto done;
+        }
+
+        if (mip_count == 0)
+        {
+            for (Uint32 y = 0; y < height; ++y)
+            {
+                SDL_memcpy(
+                        pixels[0] + y * width,
+                        (const Uint8 *)surface->pixels + y * surface->pitch,
+                        width * 4
+                );
+            }
+        }
+        else
+        {
+            APP_DownsampleMip(
+                    pixels[mip_count - 1],
+                    widths[mip_count - 1],
+                    heights[mip_count - 1],
+                    pixels[mip_count],
+                    width,
+                    height
+            );
+        }
+
+        tile_count += APP_TileCount(width, APP_TEXSTREAM_TILE_SIZE) * APP_TileCount(height, APP_TEXSTREAM_TILE_SIZE);
+        mip_count++;
+
+        if ((width == 1 && height == 1) || mip_count == APP_TEXSTREAM_MAX_MIPS)
+        {
+            break;
+        }
+
+        widths[mip_count] = SDL_max(width / 2, 1);
+        heights[mip_count] = SDL_max(height / 2, 1);
+    }
+
+    bool ok = true;
+    ok &= SDL_WriteU32LE(out, APP_TEXSTREAM_MAGIC);
+    ok &= SDL_WriteU32LE(out, APP_TEXSTREAM_VERSION);
+    ok &= SDL_WriteU32LE(out, widths[0]);
+    ok &= SDL_WriteU32LE(out, heights[0]);
+    ok &= SDL_WriteU32LE(out, mip_count);
+    ok &= SDL_WriteU32LE(out, APP_TEXSTREAM_TILE_SIZE);
+
+    for (Uint32 i = 0; i < mip_count; ++i)
+    {
+        ok &= SDL_WriteU32LE(out, widths[i]);
+        ok &= SDL_WriteU32LE(out, heights[i]);
+    }
+
+    Uint32 offset = (6 + mip_count * 2 + tile_count * 2) * sizeof(Uint32);
+
+    for (Uint32 i = 0; i < mip_count; ++i)
+    {
+        for (Uint32 y = 0; y < heights[i]; y += APP_TEXSTREAM_TILE_SIZE)
+        {
+            for (Uint32 x = 0; x < widths[i]; x += APP_TEXSTREAM_TILE_SIZE)
+            {
+                Uint32 size = SDL_min(APP_TEXSTREAM_TILE_SIZE, widths[i] - x)
+                    * SDL_min(APP_TEXSTREAM_TILE_SIZE, heights[i] - y) * 4;
+
+                ok &= SDL_WriteU32LE(out, offset);
+                ok &= SDL_WriteU32LE(out, size);
+                offset += size;
+            }
+        }
+    }
+
+    for (Uint32 i = 0; i < mip_count && ok; ++i)
+    {
+        for (Uint32 y = 0; y < heights[i]; y += APP_TEXSTREAM_TILE_SIZE)
+        {
+            for (Uint32 x = 0; x < widths[i]; x += APP_TEXSTREAM_TILE_SIZE)
+            {
+                Uint32 tile_width = SDL_min(APP_TEXSTREAM_TILE_SIZE, widths[i] - x);
+                Uint32 tile_height = SDL_min(APP_TEXSTREAM_TILE_SIZE, heights[i] - y);
+
+                for (Uint32 row = 0; row < tile_height; ++row)
+                {
+                    const Uint32 *src = pixels[i] + (y + row) * widths[i] + x;
+                    ok &= SDL_WriteIO(out, src, tile_width * 4) == tile_width * 4;
+                }
+            }
+        }
+    }
+
+    if (!ok)
+    {
+        SDL_Log("ERROR: Failed to write texture stream. %s", SDL_GetError());
+        goto done;
+    }
+
+    result = true;
+
+done:
+    for (Uint32 i = 0; i < APP_TEXSTREAM_MAX_MIPS; ++i)
+    {
+        SDL_free(pixels[i]);
+    }
+
+    return result;
+}
+
+// ====================
+// Reading
+// ====================
+
+// Read the header and the tile table, and place the tiles of every mip in
+// its transfer buffer.
+static bool
+APP_ReadTextureHeader(struct APP_StreamedTexture *texture)
+{
+    Uint32 magic, version, width, height, mip_count, tile_size;
+    SDL_IOStream *io = texture->io;
+
+    bool ok = SDL_ReadU32LE(io, &magic)
+        && SDL_ReadU32LE(io, &version)
+        && SDL_ReadU32LE(io, &width)
+        && SDL_ReadU32LE(io, &height)
+        && SDL_ReadU32LE(io, &mip_count)
+        && SDL_ReadU32LE(io, &tile_size);
+
+    if (!ok || magic != APP_TEXSTREAM_MAGIC || version != APP_TEXSTREAM_VERSION)
+    {
+        SDL_Log("ERROR: '%s' is not a texture stream.", texture->name);
+        return false;
+    }
+
+    if (mip_count == 0 || mip_count > APP_TEXSTREAM_MAX_MIPS || tile_size == 0)
+    {
+        SDL_Log("ERROR: Texture stream '%s' has %u mips of tile size %u.", texture->name, mip_count, tile_size);
+        return false;
+    }
+
+    texture->mip_count = mip_count;
+    texture->tail_mip = mip_count - 1;
+
+    Uint32 tile_count = 0;
+    for (Uint32 i = 0; i < mip_count; ++i)
+    {
+        struct APP_StreamedMip *mip = &texture->mips[i];
+
+        if (!SDL_ReadU32LE(io, &mip->width) || !SDL_ReadU32LE(io, &mip->height))
+        {
+            SDL_Log("ERROR: Failed to read the mips of '%s'.", texture->name);
+            return false;
+        }
+
+        mip->first_tile = tile_count;
+        mip->tile_count = APP_TileCount(mip->width, tile_size) * APP_TileCount(mip->height, tile_size);
+        tile_count += mip->tile_count;
+
+        if (mip->tile_count == 1 && i < texture->tail_mip)
+        {
+            texture->tail_mip = i;
+        }
+    }
+
+    texture->tiles = SDL_calloc(tile_count, sizeof(struct APP_StreamedTile));
+    if (texture->tiles == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate %u tiles.", tile_count);
+        return false;
+    }
+
+    for (Uint32 i = 0; i < mip_count; ++i)
+    {
+        struct APP_StreamedMip *mip = &texture->mips[i];
+        Uint32 upload_offset = 0;
+
+        for (Uint32 t = 0; t < mip->tile_count; ++t)
+        {
+            struct APP_StreamedTile *tile = &texture->tiles[mip->first_tile + t];
+            Uint32 tiles_x = APP_TileCount(mip->width, tile_size);
+
+            tile->x = (t % tiles_x) * tile_size;
+            tile->y = (t / tiles_x) * tile_size;
+            tile->width = SDL_min(tile_size, mip->width - tile->x);
+            tile->height = SDL_min(tile_size, mip->height - tile->y);
+
+            if (!SDL_ReadU32LE(io, &tile->file_offset) || !SDL_ReadU32LE(io, &tile->size))
+            {
+                SDL_Log("ERROR: Failed to read the tiles of '%s'.", texture->name);
+                return false;
+            }
+
+            if (tile->size != tile->width * tile->height * 4)
+            {
+                SDL_Log("ERROR: Tile %u of mip %u of '%s' has the wrong size.", t, i, texture->name);
+                return false;
+            }
+
+            tile->upload_offset = upload_offset;
+            upload_offset = APP_ALIGN_UP(upload_offset + tile->size, APP_TEXSTREAM_UPLOAD_ALIGNMENT);
+        }
+
+        mip->upload_size = upload_offset;
+    }
+
+    return true;
+}
+
+// Read every tile of the mip into dst at its upload offset.
+static bool
+APP_ReadMipTiles(const struct APP_StreamedTexture *texture, Uint32 mip_index, Uint8 *dst)
+{
+    const struct APP_StreamedMip *mip = &texture->mips[mip_index];
+
+    for (Uint32 t = 0; t < mip->tile_count; ++t)
+    {
+        const struct APP_StreamedTile *tile = &texture->tiles[mip->first_tile + t];
+
+        if (SDL_SeekIO(texture->io, tile->file_offset, SDL_IO_SEEK_SET) < 0
+            || SDL_ReadIO(texture->io, dst + tile->upload_offset, tile->size) != tile->size)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void
+APP_UploadMipTiles(
+        SDL_GPUCopyPass *copy_pass,
+        const struct APP_StreamedTexture *texture,
+        Uint32 mip_index,
+        SDL_GPUTransferBuffer *transfer_buffer,
+        Uint32 transfer_offset,
+        SDL_GPUTexture *destination,
+        Uint32 level
+)
+{
+    const struct APP_StreamedMip *mip = &texture->mips[mip_index];
+
+    for (Uint32 t = 0; t < mip->tile_count; ++t)
+    {
+        const struct APP_StreamedTile *tile = &texture->tiles[mip->first_tile + t];
+
+        SDL_UploadToGPUTexture(
+                copy_pass,
+                &(SDL_GPUTextureTransferInfo){
+                    .transfer_buffer = transfer_buffer,
+                    .offset          = transfer_offset + tile->upload_offset,
+                    .pixels_per_row  = tile->width,
+                    .rows_per_layer  = tile->height
+                },
+                &(SDL_GPUTextureRegion){
+                    .texture   = destination,
+                    .mip_level = level,
+                    .x         = tile->x,
+                    .y         = tile->y,
+                    .w         = tile->width,
+                    .h         = tile->height,
+                    .d         = 1
+                },
+                false
+        );
+    }
+}
+
+// The I/O thread. Takes the queued requests one by one and reads their
+// tiles.
+static int
+APP_TextureStream_Worker(void *data)
+{
+    struct APP_TextureStream *stream = data;
+
+    SDL_LockMutex(stream->lock);
+
+    while (!stream->quit)
+    {
+        struct APP_TextureRequest *request = NULL;
+
+        for (Uint32 i = 0; i < APP_TEXSTREAM_MAX_REQUESTS; ++i)
+        {
+            if (stream->requests[i].state == APP_TEXTURE_REQUEST_QUEUED)
+            {
+                request = &stream->requests[i];
+                break;
+            }
+        }
+
+        if (request == NULL)
+        {
+            SDL_WaitCondition(stream->wake, stream->lock);
+            continue;
+        }
+
+        request->state = APP_TEXTURE_REQUEST_READING;
+        SDL_UnlockMutex(stream->lock);
+
+        const struct APP_StreamedTexture *texture = &stream->textures[request->texture];
+        bool ok = APP_ReadMipTiles(texture, request->mip, request->data);
+
+        SDL_LockMutex(stream->lock);
+        request->state = ok ? APP_TEXTURE_REQUEST_DONE : APP_TEXTURE_REQUEST_FAILED;
+
+        if (ok)
+        {
+            stream->window_read_bytes += APP_MipBytes(&texture->mips[request->mip]);
+        }
+    }
+
+    SDL_UnlockMutex(stream->lock);
+    return 0;
+}
+
+// ====================
+// Residency
+// ====================
+
+static SDL_GPUTexture*
+APP_CreateMipChainTexture(struct APP_TextureStream *stream, const struct APP_StreamedTexture *texture, Uint32 first_mip)
+{
+    SDL_GPUTexture *result = SDL_CreateGPUTexture(
+            stream->device,
+            &(SDL_GPUTextureCreateInfo){
+                .type                 = SDL_GPU_TEXTURETYPE_2D,
+                .format               = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+                .width                = texture->mips[first_mip].width,
+                .height               = texture->mips[first_mip].height,
+                .layer_count_or_depth = 1,
+                .num_levels           = texture->mip_count - first_mip,
+                .usage                = SDL_GPU_TEXTUREUSAGE_SAMPLER
+            }
+    );
+
+    if (result == NULL)
+    {
+        SDL_Log("ERROR: Failed to create streamed texture '%s'. %s", texture->name, SDL_GetError());
+        return NULL;
+    }
+
+    SDL_SetGPUTextureName(stream->device, result, texture->name);
+    return result;
+}
+
+// Copy the resident mips from first_mip on out of the current texture.
+static void
+APP_CopyResidentMips(
+        SDL_GPUCopyPass *copy_pass,
+        const struct APP_StreamedTexture *texture,
+        SDL_GPUTexture *destination,
+        Uint32 destination_mip,
+        Uint32 first_mip
+)
+{
+    for (Uint32 i = first_mip; i < texture->mip_count; ++i)
+    {
+        SDL_CopyGPUTextureToTexture(
+                copy_pass,
+                &(SDL_GPUTextureLocation){
+                    .texture   = texture->texture,
+                    .mip_level = i - texture->resident_mip
+                },
+                &(SDL_GPUTextureLocation){
+                    .texture   = destination,
+                    .mip_level = i - destination_mip
+                },
+                texture->mips[i].width,
+                texture->mips[i].height,
+                1,
+                false
+        );
+    }
+}
+
+static SDL_GPUCopyPass*
+APP_GetCopyPass(SDL_GPUCommandBuffer *cmd_buffer, SDL_GPUCopyPass **copy_pass)
+{
+    if (*copy_pass == NULL)
+    {
+        *copy_pass = SDL_BeginGPUCopyPass(cmd_buffer);
+    }
+
+    return *copy_pass;
+}
+
+// Drop the finest resident mip, the texture is replaced by one a level
+// smaller with the remaining mips copied over.
+static bool
+APP_EvictMip(
+        struct APP_TextureStream *stream,
+        struct APP_StreamedTexture *texture,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        SDL_GPUCopyPass **copy_pass
+)
+{
+    Uint32 mip = texture->resident_mip;
+
+    SDL_GPUTexture *smaller = APP_CreateMipChainTexture(stream, texture, mip + 1);
+    if (smaller == NULL)
+    {
+        return false;
+    }
+
+    APP_CopyResidentMips(APP_GetCopyPass(cmd_buffer, copy_pass), texture, smaller, mip + 1, mip + 1);
+
+    SDL_ReleaseGPUTexture(stream->device, texture->texture);
+    texture->texture = smaller;
+    texture->resident_mip = mip + 1;
+
+    stream->resident_bytes -= APP_MipBytes(&texture->mips[mip]);
+    stream->evicted_mips++;
+    return true;
+}
+
+// Evict mips not needed this frame, least recently needed first, until
+// bytes more fit into the budget.
+static bool
+APP_MakeRoom(
+        struct APP_TextureStream *stream,
+        Uint64 bytes,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        SDL_GPUCopyPass **copy_pass
+)
+{
+    if (stream->budget_bytes == 0)
+    {
+        return true;
+    }
+
+    while (stream->resident_bytes + stream->reserved_bytes + bytes > stream->budget_bytes)
+    {
+        struct APP_StreamedTexture *victim = NULL;
+
+        for (Uint32 i = 0; i < stream->texture_count; ++i)
+        {
+            struct APP_StreamedTexture *texture = &stream->textures[i];
+
+            // A texture with a mip in flight keeps its mips, the new one is
+            // put in front of them.
+            if (texture->in_flight || texture->resident_mip >= texture->tail_mip)
+            {
+                continue;
+            }
+
+            Uint64 last_needed = texture->mips[texture->resident_mip].last_needed;
+            if (last_needed < stream->frame
+                && (victim == NULL || last_needed < victim->mips[victim->resident_mip].last_needed))
+            {
+                victim = texture;
+            }
+        }
+
+        if (victim == NULL || !APP_EvictMip(stream, victim, cmd_buffer, copy_pass))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// A mip finished reading: put it in front of the resident ones.
+static void
+APP_CompleteRequest(
+        struct APP_TextureStream *stream,
+        struct APP_TextureRequest *request,
+        SDL_GPUCommandBuffer *cmd_buffer,
+        SDL_GPUCopyPass **copy_pass
+)
+{
+    struct APP_StreamedTexture *texture = &stream->textures[request->texture];
+    Uint64 bytes = APP_MipBytes(&texture->mips[request->mip]);
+
+    SDL_UnmapGPUTransferBuffer(stream->device, request->transfer_buffer);
+
+    texture->in_flight = false;
+    stream->reserved_bytes -= bytes;
+
+    if (request->state == APP_TEXTURE_REQUEST_FAILED)
+    {
+        SDL_Log("ERROR: Failed to read mip %u of '%s', streaming stops for it.", request->mip, texture->name);
+        texture->failed = true;
+        SDL_ReleaseGPUTransferBuffer(stream->device, request->transfer_buffer);
+        return;
+    }
+
+    SDL_GPUTexture *larger = APP_CreateMipChainTexture(stream, texture, request->mip);
+    if (larger == NULL)
+    {
+        texture->failed = true;
+        SDL_ReleaseGPUTransferBuffer(stream->device, request->transfer_buffer);
+        return;
+    }
+
+    SDL_GPUCopyPass *pass = APP_GetCopyPass(cmd_buffer, copy_pass);
+    APP_UploadMipTiles(pass, texture, request->mip, request->transfer_buffer, 0, larger, 0);
+    APP_CopyResidentMips(pass, texture, larger, request->mip, texture->resident_mip);
+
+    SDL_ReleaseGPUTransferBuffer(stream->device, request->transfer_buffer);
+    SDL_ReleaseGPUTexture(stream->device, texture->texture);
+
+    texture->texture = larger;
+    texture->resident_mip = request->mip;
+
+    stream->resident_bytes += bytes;
+    stream->high_water_bytes = SDL_max(stream->high_water_bytes, stream->resident_bytes);
+    stream->streamed_bytes += bytes;
+    stream->loaded_mips++;
+    stream->window_latency_ticks += SDL_GetPerformanceCounter() - request->issued;
+    stream->window_loaded++;
+}
+
+// Queue the next finer mip of the texture. The transfer buffer is mapped
+// here and stays mapped until the read is done.
+static bool
+APP_QueueRequest(struct APP_TextureStream *stream, Uint32 handle)
+{
+    struct APP_StreamedTexture *texture = &stream->textures[handle];
+    Uint32 mip = texture->resident_mip - 1;
+
+    struct APP_TextureRequest *request = NULL;
+    for (Uint32 i = 0; i < APP_TEXSTREAM_MAX_REQUESTS; ++i)
+    {
+        if (stream->requests[i].state == APP_TEXTURE_REQUEST_FREE)
+        {
+            request = &stream->requests[i];
+            break;
+        }
+    }
+
+    if (request == NULL)
+    {
+        return false;
+    }
+
+    SDL_GPUTransferBuffer *transfer_buffer = SDL_CreateGPUTransferBuffer(
+            stream->device,
+            &(SDL_GPUTransferBufferCreateInfo){
+                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                .size  = texture->mips[mip].upload_size
+            }
+    );
+
+    if (transfer_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create mip transfer buffer. %s", SDL_GetError());
+        return false;
+    }
+
+    Uint8 *data = SDL_MapGPUTransferBuffer(stream->device, transfer_buffer, false);
+    if (data == NULL)
+    {
+        SDL_Log("ERROR: Failed to map mip transfer buffer. %s", SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(stream->device, transfer_buffer);
+        return false;
+    }
+
+    texture->in_flight = true;
+    stream->reserved_bytes += APP_MipBytes(&texture->mips[mip]);
+
+    request->texture = handle;
+    request->mip = mip;
+    request->transfer_buffer = transfer_buffer;
+    request->data = data;
+    request->issued = SDL_GetPerformanceCounter();
+
+    SDL_LockMutex(stream->lock);
+    request->state = APP_TEXTURE_REQUEST_QUEUED;
+    SDL_SignalCondition(stream->wake);
+    SDL_UnlockMutex(stream->lock);
+
+    return true;
+}
+
+// ====================
+// API
+// ====================
+
+struct APP_TextureStream*
+APP_TextureStream_Create(SDL_GPUDevice *device, Uint64 budget_bytes)
+{
+    struct APP_TextureStream *stream = SDL_calloc(1, sizeof(struct APP_TextureStream));
+    if (stream == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate texture stream.");
+        return NULL;
+    }
+
+    stream->device = device;
+    stream->budget_bytes = budget_bytes;
+    stream->window_start = SDL_GetPerformanceCounter();
+    stream->lock = SDL_CreateMutex();
+    stream->wake = SDL_CreateCondition();
+
+    if (stream->lock == NULL || stream->wake == NULL)
+    {
+        SDL_Log("ERROR: Failed to create texture stream lock. %s", SDL_GetError());
+        APP_TextureStream_Destroy(stream);
+        return NULL;
+    }
+
+    stream->thread = SDL_CreateThread(APP_TextureStream_Worker, "Texture Stream", stream);
+    if (stream->thread == NULL)
+    {
+        SDL_Log("ERROR: Failed to create texture stream thread. %s", SDL_GetError());
+        APP_TextureStream_Destroy(stream);
+        return NULL;
+    }
+
+    return stream;
+}
+
+void
+APP_TextureStream_Destroy(struct APP_TextureStream *stream)
+{
+    if (stream == NULL)
+    {
+        return;
+    }
+
+    if (stream->thread != NULL)
+    {
+        SDL_LockMutex(stream->lock);
+        stream->quit = true;
+        SDL_SignalCondition(stream->wake);
+        SDL_UnlockMutex(stream->lock);
+
+        SDL_WaitThread(stream->thread, NULL);
+    }
+
+    for (Uint32 i = 0; i < APP_TEXSTREAM_MAX_REQUESTS; ++i)
+    {
+        struct APP_TextureRequest *request = &stream->requests[i];
+
+        if (request->state != APP_TEXTURE_REQUEST_FREE)
+        {
+            SDL_UnmapGPUTransferBuffer(stream->device, request->transfer_buffer);
+            SDL_ReleaseGPUTransferBuffer(stream->device, request->transfer_buffer);
+        }
+    }
+
+    for (Uint32 i = 0; i < stream->texture_count; ++i)
+    {
+        struct APP_StreamedTexture *texture = &stream->textures[i];
+
+        SDL_ReleaseGPUTexture(stream->device, texture->texture);
+        SDL_CloseIO(texture->io);
+        SDL_free(texture->tiles);
+    }
+
+    SDL_DestroyCondition(stream->wake);
+    SDL_DestroyMutex(stream->lock);
+    SDL_free(stream);
+}
+
+// Loads the mip tail synchronously and uploads it with its own command
+// buffer.
+Uint32
+APP_TextureStream_Add(struct APP_TextureStream *stream, SDL_IOStream *io, const char *name)
+{
+    if (stream->texture_count == APP_TEXSTREAM_MAX_TEXTURES)
+    {
+        SDL_Log("ERROR: Too many streamed textures.");
+        SDL_CloseIO(io);
+        return APP_TEXSTREAM_INVALID;
+    }
+
+    Uint32 handle = stream->texture_count;
+    struct APP_StreamedTexture *texture = &stream->textures[handle];
+
+    SDL_zerop(texture);
+    SDL_strlcpy(texture->name, name, sizeof(texture->name));
+    texture->io = io;
+
+    if (!APP_ReadTextureHeader(texture))
+    {
+        goto failed;
+    }
+
+    Uint32 tail_size = 0;
+    for (Uint32 i = texture->tail_mip; i < texture->mip_count; ++i)
+    {
+        tail_size += texture->mips[i].upload_size;
+    }
+
+    SDL_GPUTransferBuffer *transfer_buffer = SDL_CreateGPUTransferBuffer(
+            stream->device,
+            &(SDL_GPUTransferBufferCreateInfo){
+                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                .size  = tail_size
+            }
+    );
+
+    if (transfer_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create mip tail transfer buffer. %s", SDL_GetError());
+        goto failed;
+    }
+
+    Uint8 *data = SDL_MapGPUTransferBuffer(stream->device, transfer_buffer, false);
+    bool ok = data != NULL;
+
+    for (Uint32 i = texture->tail_mip, offset = 0; ok && i < texture->mip_count; ++i)
+    {
+        ok = APP_ReadMipTiles(texture, i, data + offset);
+        offset += texture->mips[i].upload_size;
+    }
+
+    if (data != NULL)
+    {
+        SDL_UnmapGPUTransferBuffer(stream->device, transfer_buffer);
+    }
+
+    texture->resident_mip = texture->tail_mip;
+    texture->wanted_mip = texture->tail_mip;
+    texture->texture = ok ? APP_CreateMipChainTexture(stream, texture, texture->tail_mip) : NULL;
+
+    if (texture->texture == NULL)
+    {
+        SDL_Log("ERROR: Failed to load the mip tail of '%s'.", name);
+        SDL_ReleaseGPUTransferBuffer(stream->device, transfer_buffer);
+        goto failed;
+    }
+
+    SDL_GPUCommandBuffer *cmd_buffer = SDL_AcquireGPUCommandBuffer(stream->device);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(cmd_buffer);
+
+    for (Uint32 i = texture->tail_mip, offset = 0; i < texture->mip_count; ++i)
+    {
+        APP_UploadMipTiles(copy_pass, texture, i, transfer_buffer, offset, texture->texture, i - texture->tail_mip);
+        offset += texture->mips[i].upload_size;
+    }
+
+    SDL_EndGPUCopyPass(copy_pass);
+    SDL_SubmitGPUCommandBuffer(cmd_buffer);
+    SDL_ReleaseGPUTransferBuffer(stream->device, transfer_buffer);
+
+    stream->resident_bytes += APP_ChainBytes(texture, texture->tail_mip);
+    stream->high_water_bytes = SDL_max(stream->high_water_bytes, stream->resident_bytes);
+    stream->texture_count++;
+
+    SDL_Log(
+            "INFO: Streamed texture '%s' %ux%u, %u mips, mips %u-%u resident (%llu bytes)",
+            name,
+            texture->mips[0].width,
+            texture->mips[0].height,
+            texture->mip_count,
+            texture->tail_mip,
+            texture->mip_count - 1,
+            (unsigned long long)APP_ChainBytes(texture, texture->tail_mip)
+    );
+
+    return handle;
+
+failed:
+    SDL_CloseIO(texture->io);
+    SDL_free(texture->tiles);
+    SDL_zerop(texture);
+    return APP_TEXSTREAM_INVALID;
+}
+
+void
+APP_TextureStream_Request(struct APP_TextureStream *stream, Uint32 handle, float screen_size)
+{
+    struct APP_StreamedTexture *texture = &stream->textures[handle];
+    texture->screen_size = SDL_max(texture->screen_size, screen_size);
+}
+
+// The mip whose size is the closest at or above the size on screen.
+static Uint32
+APP_WantedMip(const struct APP_StreamedTexture *texture)
+{
+    float size = (float)SDL_max(texture->mips[0].width, texture->mips[0].height);
+    Uint32 mip = 0;
+
+    while (mip < texture->tail_mip && size * 0.5f >= texture->screen_size)
+    {
+        size *= 0.5f;
+        mip++;
+    }
+
+    return mip;
+}
+
+void
+APP_TextureStream_Update(struct APP_TextureStream *stream, SDL_GPUCommandBuffer *cmd_buffer)
+{
+    SDL_GPUCopyPass *copy_pass = NULL;
+    struct APP_TextureRequest finished[APP_TEXSTREAM_MAX_REQUESTS];
+    Uint32 finished_count = 0;
+
+    stream->frame++;
+
+    SDL_LockMutex(stream->lock);
+    for (Uint32 i = 0; i < APP_TEXSTREAM_MAX_REQUESTS; ++i)
+    {
+        struct APP_TextureRequest *request = &stream->requests[i];
+
+        if (request->state == APP_TEXTURE_REQUEST_DONE || request->state == APP_TEXTURE_REQUEST_FAILED)
+        {
+            finished[finished_count++] = *request;
+            request->state = APP_TEXTURE_REQUEST_FREE;
+        }
+    }
+    SDL_UnlockMutex(stream->lock);
+
+    for (Uint32 i = 0; i < finished_count; ++i)
+    {
+        APP_CompleteRequest(stream, &finished[i], cmd_buffer, &copy_pass);
+    }
+
+    // Textures not drawn this frame need nothing beyond the mip tail, their
+    // mips age and get evicted first.
+    for (Uint32 i = 0; i < stream->texture_count; ++i)
+    {
+        struct APP_StreamedTexture *texture = &stream->textures[i];
+
+        texture->wanted_mip = texture->screen_size > 0.0f ? APP_WantedMip(texture) : texture->tail_mip;
+        texture->screen_size = 0.0f;
+
+        for (Uint32 mip = texture->wanted_mip; mip < texture->mip_count; ++mip)
+        {
+            texture->mips[mip].last_needed = stream->frame;
+        }
+    }
+
+    // Note(john): One mip per texture in flight, coarse to fine, so a
+    // texture gets sharper step by step and the budget check sees every
+    // mip on its own.
+    for (Uint32 i = 0; i < stream->texture_count; ++i)
+    {
+        struct APP_StreamedTexture *texture = &stream->textures[i];
+
+        if (texture->failed || texture->in_flight || texture->wanted_mip >= texture->resident_mip)
+        {
+            continue;
+        }
+
+        Uint64 bytes = APP_MipBytes(&texture->mips[texture->resident_mip - 1]);
+        if (!APP_MakeRoom(stream, bytes, cmd_buffer, &copy_pass))
+        {
+            stream->budget_misses++;
+            continue;
+        }
+
+        if (!APP_QueueRequest(stream, i))
+        {
+            break;
+        }
+    }
+
+    if (copy_pass != NULL)
+    {
+        SDL_EndGPUCopyPass(copy_pass);
+    }
+}
+
+SDL_GPUTexture*
+APP_TextureStream_GetTexture(const struct APP_TextureStream *stream, Uint32 handle)
+{
+    return stream->textures[handle].texture;
+}
+
+// Bandwidth, latency and budget misses cover the time since the last call.
+void
+APP_TextureStream_GetStats(struct APP_TextureStream *stream, struct APP_TextureStreamStats *out_stats)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    double seconds = (double)(now - stream->window_start) / frequency;
+
+    SDL_zerop(out_stats);
+    out_stats->resident_bytes = stream->resident_bytes;
+    out_stats->high_water_bytes = stream->high_water_bytes;
+    out_stats->budget_bytes = stream->budget_bytes;
+    out_stats->texture_count = stream->texture_count;
+    out_stats->budget_misses = stream->budget_misses;
+    out_stats->loaded_mips = stream->loaded_mips;
+    out_stats->evicted_mips = stream->evicted_mips;
+    out_stats->streamed_bytes = stream->streamed_bytes;
+
+    if (stream->window_loaded > 0)
+    {
+        out_stats->average_latency_ms = (double)stream->window_latency_ticks * 1000.0
+            / (frequency * stream->window_loaded);
+    }
+
+    SDL_LockMutex(stream->lock);
+    for (Uint32 i = 0; i < APP_TEXSTREAM_MAX_REQUESTS; ++i)
+    {
+        if (stream->requests[i].state != APP_TEXTURE_REQUEST_FREE)
+        {
+            out_stats->pending_requests++;
+        }
+    }
+
+    if (seconds > 0.0)
+    {
+        out_stats->bandwidth_mb_per_s = (double)stream->window_read_bytes / (1024.0 * 1024.0) / seconds;
+    }
+
+    stream->window_read_bytes = 0;
+    SDL_UnlockMutex(stream->lock);
+
+    stream->window_start = now;
+    stream->window_latency_ticks = 0;
+    stream->window_loaded = 0;
+    stream->budget_misses = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef TEXSTREAM_H
+#define TEXSTREAM_H
+
+#include <SDL3/SDL.h>
+
+// Streams the mip levels of textures stored pre-tiled (APP_TextureStream_Bake)
+// from disk or memory. A texture only keeps the mips from the finest one
+// that is needed down to the smallest one resident, finer mips are read by
+// an I/O thread and uploaded once all of their tiles arrived. Under the
+// budget the least recently needed mips are evicted.
+
+#define APP_TEXSTREAM_TILE_SIZE 64
+#define APP_TEXSTREAM_MAX_MIPS 16
+#define APP_TEXSTREAM_MAX_TEXTURES 32
+#define APP_TEXSTREAM_MAX_REQUESTS 8
+
+#define APP_TEXSTREAM_INVALID 0xFFFFFFFFu
+
+struct APP_TextureStream;
+
+struct APP_TextureStreamStats {
+    Uint64 resident_bytes;
+    Uint64 high_water_bytes;
+    // 0 for no budget.
+    Uint64 budget_bytes;
+
+    Uint32 texture_count;
+    Uint32 pending_requests;
+    // How often a wanted mip didn't fit into the budget since the last
+    // call, once per texture and frame.
+    Uint32 budget_misses;
+
+    Uint32 loaded_mips;
+    Uint32 evicted_mips;
+    Uint64 streamed_bytes;
+
+    // Read from disk and average time from request to upload, both since
+    // the last call.
+    double bandwidth_mb_per_s;
+    double average_latency_ms;
+};
+
+struct APP_TextureStream *APP_TextureStream_Create(SDL_GPUDevice *device, Uint64 budget_bytes);
+void APP_TextureStream_Destroy(struct APP_TextureStream *stream);
+
+// Write an ABGR8888 surface with its full mip chain in the tiled format.
+bool APP_TextureStream_Bake(SDL_Surface *surface, SDL_IOStream *out);
+
+// Add a baked texture, the stream owns io from here on. Only the mip tail
+// (all mips that fit into one tile) is loaded right away. Returns the
+// handle or APP_TEXSTREAM_INVALID.
+Uint32 APP_TextureStream_Add(struct APP_TextureStream *stream, SDL_IOStream *io, const char *name);
+
+// The largest size in pixels the texture covers on screen this frame.
+void APP_TextureStream_Request(struct APP_TextureStream *stream, Uint32 handle, float screen_size);
+
+// Once per frame outside of a render pass: uploads finished reads, evicts
+// under the budget and queues the next reads. Textures can be replaced,
+// fetch them again afterwards.
+void APP_TextureStream_Update(struct APP_TextureStream *stream, SDL_GPUCommandBuffer *cmd_buffer);
+
+SDL_GPUTexture *APP_TextureStream_GetTexture(const struct APP_TextureStream *stream, Uint32 handle);
+
+void APP_TextureStream_GetStats(struct APP_TextureStream *stream, struct APP_TextureStreamStats *out_stats);
+
+#endif
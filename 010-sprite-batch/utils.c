@@ -0,0 +1,470 @@
+#include "app.h"
+#include "pack.h"
+#include "pixels.h"
+#include "qoi.h"
+#include "utils.h"
+
+const void*
+APP_ReadAsset(struct APP_Context *cxt, const char *asset_path, size_t *out_size, void **out_owned)
+{
+    const void *data = APP_Pack_Read(cxt->pack, asset_path, out_size, out_owned);
+    if(data != NULL)
+    {
+        return data;
+    }
+
+    char full_path[256];
+    SDL_snprintf(full_path, sizeof(full_path), "%s%s", cxt->base_path, asset_path);
+
+    *out_owned = SDL_LoadFile(full_path, out_size);
+    return *out_owned;
+}
+
+SDL_IOStream*
+APP_OpenAsset(struct APP_Context *cxt, const char *asset_path)
+{
+    SDL_IOStream *io = APP_Pack_OpenIO(cxt->pack, asset_path);
+    if(io != NULL)
+    {
+        return io;
+    }
+
+    char full_path[256];
+    SDL_snprintf(full_path, sizeof(full_path), "%s%s", cxt->base_path, asset_path);
+
+    return SDL_IOFromFile(full_path, "rb");
+}
+
+// Load a BMP from the images directory, the surface keeps the format of the
+// file.
+static SDL_Surface*
+APP_LoadBMP(struct APP_Context *cxt, const char *image_filename)
+{
+    char asset_path[256];
+
+    SDL_snprintf(asset_path, sizeof(asset_path), "images/%s", image_filename);
+
+    SDL_Log("INFO: Load bmp: %s", asset_path);
+
+    SDL_IOStream *io = APP_OpenAsset(cxt, asset_path);
+    SDL_Surface *result = io != NULL ? SDL_LoadBMP_IO(io, true) : NULL;
+    if(result == NULL)
+    {
+        SDL_Log("ERROR: Failed to load bmp: %s", SDL_GetError());
+        return NULL;
+    }
+
+    SDL_Log("INFO: Image width: %i height: %i", result->w, result->h);
+    return result;
+}
+
+static void
+APP_LogImageConversion(SDL_Surface *image, Uint64 start)
+{
+    double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+        / (double)SDL_GetPerformanceFrequency();
+
+    SDL_Log(
+            "INFO: Converted %ix%i %s to ABGR8888 (%s) in %.3f ms",
+            image->w,
+            image->h,
+            SDL_GetPixelFormatName(image->format),
+            APP_PixelConverterName(image->format),
+            ms
+    );
+}
+
+static bool
+APP_IsQOIFile(const char *image_filename)
+{
+    const char *extension = SDL_strrchr(image_filename, '.');
+    return extension != NULL && SDL_strcasecmp(extension, ".qoi") == 0;
+}
+
+// Read a QOI image from the images directory. Release out_owned with
+// SDL_free once decoded.
+static const void*
+APP_ReadQOI(
+        struct APP_Context *cxt,
+        const char *image_filename,
+        struct APP_QOIInfo *out_info,
+        size_t *out_size,
+        void **out_owned
+)
+{
+    char asset_path[256];
+    SDL_snprintf(asset_path, sizeof(asset_path), "images/%s", image_filename);
+
+    SDL_Log("INFO: Load qoi: %s", asset_path);
+
+    const void *data = APP_ReadAsset(cxt, asset_path, out_size, out_owned);
+    if(data == NULL)
+    {
+        SDL_Log("ERROR: Failed to load qoi: %s", SDL_GetError());
+        return NULL;
+    }
+
+    if(!APP_QOI_ReadInfo(data, *out_size, out_info))
+    {
+        SDL_Log("ERROR: Invalid qoi: %s", asset_path);
+        SDL_free(*out_owned);
+        return NULL;
+    }
+
+    SDL_Log("INFO: Image width: %u height: %u", out_info->width, out_info->height);
+    return data;
+}
+
+// Decode the slices of the QOI on all cores straight into dst.
+static bool
+APP_DecodeQOI(const void *data, size_t size, const struct APP_QOIInfo *info, void *dst, int dst_pitch)
+{
+    Uint32 thread_count = (Uint32)SDL_GetNumLogicalCPUCores();
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    if(!APP_QOI_Decode(data, size, dst, dst_pitch, thread_count))
+    {
+        return false;
+    }
+
+    double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+        / (double)SDL_GetPerformanceFrequency();
+
+    SDL_Log(
+            "INFO: Decoded %ux%u QOI (%zu bytes, %u slices) to ABGR8888 in %.3f ms",
+            info->width,
+            info->height,
+            size,
+            info->slice_count,
+            ms
+    );
+
+    return true;
+}
+
+static SDL_Surface*
+APP_LoadQOIImage(struct APP_Context *cxt, const char *image_filename)
+{
+    struct APP_QOIInfo info;
+    size_t size;
+    void *owned;
+
+    const void *data = APP_ReadQOI(cxt, image_filename, &info, &size, &owned);
+    if(data == NULL)
+    {
+        return NULL;
+    }
+
+    SDL_Surface *result = SDL_CreateSurface((int)info.width, (int)info.height, SDL_PIXELFORMAT_ABGR8888);
+    if(result == NULL)
+    {
+        SDL_Log("ERROR: Failed to create image surface: %s", SDL_GetError());
+    }
+    else if(!APP_DecodeQOI(data, size, &info, result->pixels, result->pitch))
+    {
+        SDL_DestroySurface(result);
+        result = NULL;
+    }
+
+    SDL_free(owned);
+    return result;
+}
+
+// Load a image from a specified path.
+SDL_Surface*
+APP_LoadImage(struct APP_Context *cxt, const char *image_filenamen, int desired_channels)
+{
+    if(desired_channels != 4)
+    {
+        SDL_assert(!"Unexpected desiredChannels");
+        SDL_Log("ERROR: Unexpected desiredChannels");
+        return NULL;
+    }
+
+    if(APP_IsQOIFile(image_filenamen))
+    {
+        return APP_LoadQOIImage(cxt, image_filenamen);
+    }
+
+    SDL_Surface *image = APP_LoadBMP(cxt, image_filenamen);
+    if(image == NULL || image->format == SDL_PIXELFORMAT_ABGR8888)
+    {
+        return image;
+    }
+
+    SDL_Surface *result = SDL_CreateSurface(image->w, image->h, SDL_PIXELFORMAT_ABGR8888);
+    if(result == NULL)
+    {
+        SDL_Log("ERROR: Failed to create image surface: %s", SDL_GetError());
+        SDL_DestroySurface(image);
+        return NULL;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    if(!APP_ConvertSurfaceToABGR8888(image, result->pixels, result->pitch))
+    {
+        SDL_DestroySurface(result);
+        result = NULL;
+    }
+    else
+    {
+        APP_LogImageConversion(image, start);
+    }
+
+    SDL_DestroySurface(image);
+    return result;
+}
+
+// Decode a QOI straight into a mapped upload transfer buffer, the data
+// comes without a copy from the asset pack.
+static SDL_GPUTransferBuffer*
+APP_LoadQOIToTransferBuffer(
+        struct APP_Context *cxt,
+        const char *image_filename,
+        Uint32 *out_width,
+        Uint32 *out_height
+)
+{
+    struct APP_QOIInfo info;
+    size_t size;
+    void *owned;
+
+    const void *data = APP_ReadQOI(cxt, image_filename, &info, &size, &owned);
+    if(data == NULL)
+    {
+        return NULL;
+    }
+
+    SDL_GPUTransferBuffer *transfer_buffer = SDL_CreateGPUTransferBuffer(
+            cxt->device,
+            &(SDL_GPUTransferBufferCreateInfo){
+                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                .size  = info.width * info.height * 4
+            }
+    );
+
+    if(transfer_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create image transfer buffer: %s", SDL_GetError());
+        SDL_free(owned);
+        return NULL;
+    }
+
+    void *pixels = SDL_MapGPUTransferBuffer(cxt->device, transfer_buffer, false);
+    bool decoded = pixels != NULL && APP_DecodeQOI(data, size, &info, pixels, (int)info.width * 4);
+
+    if(pixels != NULL)
+    {
+        SDL_UnmapGPUTransferBuffer(cxt->device, transfer_buffer);
+    }
+
+    SDL_free(owned);
+
+    if(!decoded)
+    {
+        SDL_Log("ERROR: Failed to decode image: %s", image_filename);
+        SDL_ReleaseGPUTransferBuffer(cxt->device, transfer_buffer);
+        return NULL;
+    }
+
+    *out_width = info.width;
+    *out_height = info.height;
+    return transfer_buffer;
+}
+
+// Load a BMP or QOI and write its pixels as ABGR8888 straight into a
+// mapped upload transfer buffer, ready for SDL_UploadToGPUTexture with
+// tightly packed rows. The caller releases the transfer buffer.
+SDL_GPUTransferBuffer*
+APP_LoadImageToTransferBuffer(
+        struct APP_Context *cxt,
+        const char *image_filename,
+        Uint32 *out_width,
+        Uint32 *out_height
+)
+{
+    if(APP_IsQOIFile(image_filename))
+    {
+        return APP_LoadQOIToTransferBuffer(cxt, image_filename, out_width, out_height);
+    }
+
+    SDL_Surface *image = APP_LoadBMP(cxt, image_filename);
+    if(image == NULL)
+    {
+        return NULL;
+    }
+
+    SDL_GPUTransferBuffer *transfer_buffer = SDL_CreateGPUTransferBuffer(
+            cxt->device,
+            &(SDL_GPUTransferBufferCreateInfo){
+                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                .size  = (Uint32)image->w * (Uint32)image->h * 4
+            }
+    );
+
+    if(transfer_buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to create image transfer buffer: %s", SDL_GetError());
+        SDL_DestroySurface(image);
+        return NULL;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    void *pixels = SDL_MapGPUTransferBuffer(cxt->device, transfer_buffer, false);
+    bool converted = pixels != NULL && APP_ConvertSurfaceToABGR8888(image, pixels, image->w * 4);
+
+    if(pixels != NULL)
+    {
+        SDL_UnmapGPUTransferBuffer(cxt->device, transfer_buffer);
+    }
+
+    if(!converted)
+    {
+        SDL_Log("ERROR: Failed to convert image: %s", image_filename);
+        SDL_ReleaseGPUTransferBuffer(cxt->device, transfer_buffer);
+        SDL_DestroySurface(image);
+        return NULL;
+    }
+
+    APP_LogImageConversion(image, start);
+
+    *out_width = (Uint32)image->w;
+    *out_height = (Uint32)image->h;
+
+    SDL_DestroySurface(image);
+    return transfer_buffer;
+}
+
+// Resolve the compiled shader blob for the backend of the device and read
+// it from the pack or disk. Release out_owned with SDL_free.
+static const void*
+APP_LoadShaderCode(
+        struct APP_Context *cxt,
+        const char *shader_filename,
+        SDL_GPUShaderFormat *out_format,
+        const char **out_entrypoint,
+        size_t *out_code_size,
+        void **out_owned
+)
+{
+    char asset_path[256];
+
+    SDL_GPUShaderFormat backend_formats = SDL_GetGPUShaderFormats(cxt->device);
+    SDL_GPUShaderFormat format = SDL_GPU_SHADERFORMAT_INVALID;
+
+    if(backend_formats & SDL_GPU_SHADERFORMAT_SPIRV)
+    {
+        SDL_Log("INFO: Use SPIRV shader format");
+        
+        SDL_snprintf(
+                asset_path, 
+                sizeof(asset_path), 
+                "shaders/compiled/SPIRV/%s.spv", 
+                shader_filename
+        );
+        
+        format = SDL_GPU_SHADERFORMAT_SPIRV;
+    }
+    else if(backend_formats & SDL_GPU_SHADERFORMAT_MSL)
+    {
+        SDL_Log("INFO: Use MSL shader format");
+        SDL_snprintf(
+                asset_path, 
+                sizeof(asset_path), 
+                "shaders/compiled/MSL/%s.msl", 
+                shader_filename
+        );
+
+        format = SDL_GPU_SHADERFORMAT_MSL;
+    }
+    else if(backend_formats & SDL_GPU_SHADERFORMAT_DXIL)
+    {
+        SDL_Log("INFO: Use DXIL shader format");
+
+        SDL_snprintf(
+                asset_path, 
+                sizeof(asset_path), 
+                "shaders/compiled/DXIL/%s.dxil", 
+                shader_filename
+        );
+
+        format = SDL_GPU_SHADERFORMAT_DXIL;
+    }
+    else
+    {
+        SDL_Log("ERROR: Unreconized backend shader format");
+        return NULL;
+    }
+
+    const void *code = APP_ReadAsset(cxt, asset_path, out_code_size, out_owned);
+    if(code == NULL)
+    {
+        SDL_Log("ERROR: Failed to load shader: %s", asset_path);
+        return NULL;
+    }
+
+    *out_format = format;
+    *out_entrypoint = "main";
+    return code;
+}
+
+// Load the compiled shader from a specified path.
+SDL_GPUShader*
+APP_LoadShader(
+        struct APP_Context *cxt, 
+        const char *shader_filename, 
+        Uint32 sampler_count, 
+        Uint32 uniform_buffer_count,
+        Uint32 storage_buffer_count, 
+        Uint32 storage_texture_count
+)
+{
+    SDL_GPUShaderStage stage;
+    if(SDL_strstr(shader_filename, ".vert"))
+    {
+        stage = SDL_GPU_SHADERSTAGE_VERTEX;
+    }
+    else if(SDL_strstr(shader_filename, ".frag"))
+    {
+        stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
+    }
+    else
+    {
+        SDL_Log("ERROR: Invalid shader stage");
+        return NULL;
+    }
+
+    SDL_GPUShaderFormat format;
+    const char *entrypoint;
+    size_t code_size;
+    void *owned;
+
+    const void *code = APP_LoadShaderCode(cxt, shader_filename, &format, &entrypoint, &code_size, &owned);
+    if(code == NULL)
+    {
+        return NULL;
+    }
+
+    SDL_GPUShaderCreateInfo shader_info = {
+        .code                 = code,
+        .code_size            = code_size,
+        .entrypoint           = entrypoint,
+        .format               = format,
+        .stage                = stage,
+        .num_samplers         = sampler_count,
+        .num_uniform_buffers  = uniform_buffer_count,
+        .num_storage_buffers  = storage_buffer_count,
+        .num_storage_textures = storage_texture_count,
+    };
+
+    SDL_GPUShader *shader = SDL_CreateGPUShader(cxt->device, &shader_info);
+    if(shader == NULL)
+    {
+        SDL_Log("ERROR: Failed to create shader.");
+        SDL_free(owned);
+        return NULL;
+    }
+
+    SDL_free(owned);
+    return shader;
+}
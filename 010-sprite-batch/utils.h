@@ -0,0 +1,38 @@
+#ifndef UTILS_H
+#define UTILS_H
+
+#include "app.h"
+
+// Read an asset by its path relative to the example, e.g.
+// "images/default.bmp", from the asset pack if it has the asset and from
+// the loose file otherwise. Data read from disk or decompressed is returned
+// in out_owned, release it with SDL_free. Data from the pack stays valid as
+// long as the pack is open.
+const void *APP_ReadAsset(struct APP_Context *cxt, const char *asset_path, size_t *out_size, void **out_owned);
+
+// The asset as a stream from the asset pack or the loose file.
+SDL_IOStream *APP_OpenAsset(struct APP_Context *cxt, const char *asset_path);
+
+SDL_Surface *APP_LoadImage(
+        struct APP_Context *cxt, 
+        const char *image_filenamen, 
+        int desired_channels
+);
+
+SDL_GPUTransferBuffer *APP_LoadImageToTransferBuffer(
+        struct APP_Context *cxt,
+        const char *image_filename,
+        Uint32 *out_width,
+        Uint32 *out_height
+);
+
+SDL_GPUShader *APP_LoadShader(
+        struct APP_Context *context, 
+        const char *shader_filename,
+        Uint32 sampler_count, 
+        Uint32 uniform_buffer_count,
+        Uint32 storage_buffer_count, 
+        Uint32 storage_texture_count
+);
+
+#endif
@@ -0,0 +1,292 @@
+#define SDL_MAIN_USE_CALLBACKS 1
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+#include "tilemap.h"
+
+#define WINDOW_WIDTH 1280
+#define WINDOW_HEIGHT 720
+
+#define TILE_SIZE 16
+#define TILESET_COLUMNS 4
+#define TILESET_ROWS 2
+#define DEFAULT_MAP_SIZE 1024
+
+#define CAMERA_SPEED 600.0f
+#define STATS_LOG_INTERVAL 120
+
+SDL_Window *window = NULL;
+SDL_Renderer *renderer = NULL;
+SDL_Texture *tileset = NULL;
+
+struct APP_Tilemap *map = NULL;
+SDL_FRect camera = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
+bool per_tile = false;
+
+Uint64 last_frame = 0;
+Uint64 frame_ticks = 0;
+Uint32 frames = 0;
+Uint32 rebuilt_chunks = 0;
+
+// Eight flat colored tiles with a darker border, so the tile grid is
+// visible.
+static SDL_Texture*
+APP_CreateTileset(void)
+{
+    static const SDL_Color colors[TILESET_COLUMNS * TILESET_ROWS] = {
+        {  70, 140,  60, 255 }, {  90, 160,  70, 255 }, { 200, 180, 110, 255 }, { 120, 120, 120, 255 },
+        { 150,  90,  50, 255 }, {  60,  90, 170, 255 }, { 230, 230, 240, 255 }, {  40,  90,  40, 255 },
+    };
+
+    SDL_Surface *surface = SDL_CreateSurface(
+            TILESET_COLUMNS * TILE_SIZE,
+            TILESET_ROWS * TILE_SIZE,
+            SDL_PIXELFORMAT_ABGR8888
+    );
+
+    if (surface == NULL)
+    {
+        SDL_Log("ERROR: Failed to create tileset surface: %s", SDL_GetError());
+        return NULL;
+    }
+
+    for (int i = 0; i < TILESET_COLUMNS * TILESET_ROWS; ++i)
+    {
+        SDL_Color color = colors[i];
+        SDL_Rect cell = {
+            (i % TILESET_COLUMNS) * TILE_SIZE,
+            (i / TILESET_COLUMNS) * TILE_SIZE,
+            TILE_SIZE,
+            TILE_SIZE
+        };
+        SDL_Rect inner = { cell.x + 1, cell.y + 1, TILE_SIZE - 2, TILE_SIZE - 2 };
+
+        SDL_FillSurfaceRect(surface, &cell, SDL_MapSurfaceRGB(surface, color.r * 3 / 4, color.g * 3 / 4, color.b * 3 / 4));
+        SDL_FillSurfaceRect(surface, &inner, SDL_MapSurfaceRGB(surface, color.r, color.g, color.b));
+    }
+
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_DestroySurface(surface);
+
+    if (texture == NULL)
+    {
+        SDL_Log("ERROR: Failed to create tileset texture: %s", SDL_GetError());
+        return NULL;
+    }
+
+    SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+    return texture;
+}
+
+// Fill the map with bands of terrain and leave some holes, so empty tiles
+// are skipped as well.
+static void
+APP_GenerateMap(void)
+{
+    for (int y = 0; y < map->height; ++y)
+    {
+        for (int x = 0; x < map->width; ++x)
+        {
+            float value = SDL_sinf(x * 0.05f) + SDL_cosf(y * 0.07f) + SDL_sinf((x + y) * 0.013f);
+            Uint16 tile = (Uint16)(1 + (int)((value + 3.0f) * 1.33f) % (TILESET_COLUMNS * TILESET_ROWS));
+
+            if (((x * 7 + y * 13) % 97) == 0)
+            {
+                tile = APP_TILE_EMPTY;
+            }
+
+            APP_Tilemap_SetTile(map, x, y, tile);
+        }
+    }
+}
+
+SDL_AppResult
+SDL_AppInit(void **appstate, int argc, char **argv)
+{
+    SDL_SetAppMetadata("Tilemap", "1.0", "com.up.tilemap");
+
+    // Usage: main [--size N] [--per-tile]
+    int map_size = DEFAULT_MAP_SIZE;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (SDL_strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+        {
+            map_size = SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--per-tile") == 0)
+        {
+            per_tile = true;
+        }
+    }
+
+    if (!SDL_Init(SDL_INIT_VIDEO))
+    {
+        SDL_Log("ERROR: Couldn't initialize SDL: %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
+    if (!SDL_CreateWindowAndRenderer("Tilemap", WINDOW_WIDTH, WINDOW_HEIGHT, 0, &window, &renderer))
+    {
+        SDL_Log("ERROR: Couldn't create window/renderer: %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
+    tileset = APP_CreateTileset();
+    if (tileset == NULL)
+    {
+        return SDL_APP_FAILURE;
+    }
+
+    map = APP_Tilemap_Create(map_size, map_size, TILE_SIZE, tileset, TILESET_COLUMNS);
+    if (map == NULL)
+    {
+        SDL_Log("ERROR: Couldn't create tilemap.");
+        return SDL_APP_FAILURE;
+    }
+
+    APP_GenerateMap();
+
+    SDL_Log(
+            "INFO: Map %ix%i tiles in %ix%i chunks",
+            map->width,
+            map->height,
+            map->chunks_x,
+            map->chunks_y
+    );
+
+    last_frame = SDL_GetPerformanceCounter();
+
+    return SDL_APP_CONTINUE;
+}
+
+SDL_AppResult
+SDL_AppEvent(void *appstate, SDL_Event *event)
+{
+    if(event->type == SDL_EVENT_QUIT)
+    {
+        return SDL_APP_SUCCESS;
+    }
+
+    // Note(john): Arrow keys or WASD move the camera, space switches between
+    // the chunked and the per tile path and escape closes the example.
+    if(event->type == SDL_EVENT_KEY_DOWN)
+    {
+        if (event->key.key == SDLK_SPACE)
+        {
+            per_tile = !per_tile;
+            frames = 0;
+            frame_ticks = 0;
+            rebuilt_chunks = 0;
+        }
+        else if (event->key.key == SDLK_ESCAPE)
+        {
+            return SDL_APP_SUCCESS;
+        }
+    }
+
+    return SDL_APP_CONTINUE;
+}
+
+// Move the camera with the keyboard and paint tiles with the mouse. A
+// painted tile only marks its own chunk for a rebuild.
+static void
+APP_UpdateInput(float delta_time)
+{
+    const bool *keys = SDL_GetKeyboardState(NULL);
+    float step = CAMERA_SPEED * delta_time;
+
+    if (keys[SDL_SCANCODE_LEFT] || keys[SDL_SCANCODE_A])
+    {
+        camera.x -= step;
+    }
+    if (keys[SDL_SCANCODE_RIGHT] || keys[SDL_SCANCODE_D])
+    {
+        camera.x += step;
+    }
+    if (keys[SDL_SCANCODE_UP] || keys[SDL_SCANCODE_W])
+    {
+        camera.y -= step;
+    }
+    if (keys[SDL_SCANCODE_DOWN] || keys[SDL_SCANCODE_S])
+    {
+        camera.y += step;
+    }
+
+    float max_x = (float)(map->width * TILE_SIZE) - camera.w;
+    float max_y = (float)(map->height * TILE_SIZE) - camera.h;
+    camera.x = SDL_clamp(camera.x, 0.0f, SDL_max(max_x, 0.0f));
+    camera.y = SDL_clamp(camera.y, 0.0f, SDL_max(max_y, 0.0f));
+
+    float mouse_x = 0;
+    float mouse_y = 0;
+    SDL_MouseButtonFlags buttons = SDL_GetMouseState(&mouse_x, &mouse_y);
+
+    if (buttons & (SDL_BUTTON_LMASK | SDL_BUTTON_RMASK))
+    {
+        int tile_x = (int)((mouse_x + SDL_floorf(camera.x)) / TILE_SIZE);
+        int tile_y = (int)((mouse_y + SDL_floorf(camera.y)) / TILE_SIZE);
+        Uint16 tile = (buttons & SDL_BUTTON_LMASK) ? 7 : APP_TILE_EMPTY;
+
+        APP_Tilemap_SetTile(map, tile_x, tile_y, tile);
+    }
+}
+
+SDL_AppResult
+SDL_AppIterate(void *appstate)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    float delta_time = (float)((double)(now - last_frame) / (double)SDL_GetPerformanceFrequency());
+
+    frame_ticks += now - last_frame;
+    last_frame = now;
+
+    APP_UpdateInput(delta_time);
+
+    SDL_SetRenderDrawColor(renderer, 20, 20, 30, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(renderer);
+
+    if (per_tile)
+    {
+        APP_Tilemap_RenderPerTile(map, renderer, &camera);
+    }
+    else
+    {
+        APP_Tilemap_Render(map, renderer, &camera);
+    }
+
+    SDL_RenderPresent(renderer);
+
+    rebuilt_chunks += map->stats.rebuilt_chunks;
+    frames++;
+
+    if (frames == STATS_LOG_INTERVAL)
+    {
+        double frame_ms = (double)frame_ticks * 1000.0 / ((double)SDL_GetPerformanceFrequency() * frames);
+
+        SDL_Log(
+                "INFO: %s: %i tiles, %i draw calls, %i visible chunks, %u rebuilt, frame %.3f ms",
+                per_tile ? "Per tile" : "Chunked",
+                map->stats.tiles,
+                map->stats.draw_calls,
+                map->stats.visible_chunks,
+                rebuilt_chunks,
+                frame_ms
+        );
+
+        frames = 0;
+        frame_ticks = 0;
+        rebuilt_chunks = 0;
+    }
+
+    return SDL_APP_CONTINUE;
+}
+
+void
+SDL_AppQuit(void *appstate, SDL_AppResult result)
+{
+    APP_Tilemap_Destroy(map);
+    SDL_DestroyTexture(tileset);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+}
@@ -0,0 +1,371 @@
+#include "tilemap.h"
+
+struct APP_TileRange {
+    int min_x, min_y;
+    int max_x, max_y;
+};
+
+// Range of chunks (or tiles with cell_size == tile_size) overlapping the
+// camera, max is exclusive.
+static struct APP_TileRange
+APP_Tilemap_VisibleRange(
+        const SDL_FRect *camera,
+        int cell_size,
+        int count_x,
+        int count_y
+)
+{
+    struct APP_TileRange range;
+
+    range.min_x = (int)SDL_floorf(camera->x / cell_size);
+    range.min_y = (int)SDL_floorf(camera->y / cell_size);
+    range.max_x = (int)SDL_ceilf((camera->x + camera->w) / cell_size);
+    range.max_y = (int)SDL_ceilf((camera->y + camera->h) / cell_size);
+
+    range.min_x = SDL_clamp(range.min_x, 0, count_x);
+    range.min_y = SDL_clamp(range.min_y, 0, count_y);
+    range.max_x = SDL_clamp(range.max_x, 0, count_x);
+    range.max_y = SDL_clamp(range.max_y, 0, count_y);
+
+    return range;
+}
+
+static SDL_FRect
+APP_Tilemap_TileSource(const struct APP_Tilemap *map, Uint16 tile)
+{
+    int cell = tile - 1;
+
+    return (SDL_FRect){
+        .x = (float)((cell % map->tileset_columns) * map->tile_size),
+        .y = (float)((cell / map->tileset_columns) * map->tile_size),
+        .w = (float)map->tile_size,
+        .h = (float)map->tile_size,
+    };
+}
+
+// Write the quads of every non empty tile of the chunk. Only runs for dirty
+// chunks, the result is reused until a tile of the chunk changes.
+static void
+APP_Tilemap_BuildChunk(struct APP_Tilemap *map, int chunk_x, int chunk_y)
+{
+    struct APP_TileChunk *chunk = &map->chunks[chunk_y * map->chunks_x + chunk_x];
+    SDL_FColor white = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    int first_x = chunk_x * APP_TILEMAP_CHUNK_SIZE;
+    int first_y = chunk_y * APP_TILEMAP_CHUNK_SIZE;
+    int last_x = SDL_min(first_x + APP_TILEMAP_CHUNK_SIZE, map->width);
+    int last_y = SDL_min(first_y + APP_TILEMAP_CHUNK_SIZE, map->height);
+
+    chunk->tile_count = 0;
+
+    for (int y = first_y; y < last_y; ++y)
+    {
+        for (int x = first_x; x < last_x; ++x)
+        {
+            Uint16 tile = map->tiles[y * map->width + x];
+            if (tile == APP_TILE_EMPTY)
+            {
+                continue;
+            }
+
+            SDL_FRect source = APP_Tilemap_TileSource(map, tile);
+
+            float u0 = source.x / map->tileset_width;
+            float v0 = source.y / map->tileset_height;
+            float u1 = (source.x + source.w) / map->tileset_width;
+            float v1 = (source.y + source.h) / map->tileset_height;
+
+            float x0 = (float)((x - first_x) * map->tile_size);
+            float y0 = (float)((y - first_y) * map->tile_size);
+            float x1 = x0 + map->tile_size;
+            float y1 = y0 + map->tile_size;
+
+            SDL_Vertex *quad = &chunk->vertices[chunk->tile_count * 4];
+            quad[0] = (SDL_Vertex){ { x0, y0 }, white, { u0, v0 } };
+            quad[1] = (SDL_Vertex){ { x1, y0 }, white, { u1, v0 } };
+            quad[2] = (SDL_Vertex){ { x1, y1 }, white, { u1, v1 } };
+            quad[3] = (SDL_Vertex){ { x0, y1 }, white, { u0, v1 } };
+
+            chunk->tile_count++;
+        }
+    }
+
+    chunk->dirty = false;
+}
+
+// Grow the per frame draw arrays. The indices never change for a given
+// quad, so they are only written for the new part.
+static bool
+APP_Tilemap_ReserveDraw(struct APP_Tilemap *map, int tile_count)
+{
+    if (tile_count <= map->draw_capacity)
+    {
+        return true;
+    }
+
+    int capacity = SDL_max(map->draw_capacity * 2, tile_count);
+
+    SDL_Vertex *vertices = SDL_realloc(map->draw_vertices, sizeof(SDL_Vertex) * 4 * capacity);
+    if (vertices == NULL)
+    {
+        return false;
+    }
+    map->draw_vertices = vertices;
+
+    int *indices = SDL_realloc(map->draw_indices, sizeof(int) * 6 * capacity);
+    if (indices == NULL)
+    {
+        return false;
+    }
+    map->draw_indices = indices;
+
+    for (int i = map->draw_capacity; i < capacity; ++i)
+    {
+        indices[i * 6 + 0] = i * 4 + 0;
+        indices[i * 6 + 1] = i * 4 + 1;
+        indices[i * 6 + 2] = i * 4 + 2;
+        indices[i * 6 + 3] = i * 4 + 0;
+        indices[i * 6 + 4] = i * 4 + 2;
+        indices[i * 6 + 5] = i * 4 + 3;
+    }
+
+    map->draw_capacity = capacity;
+    return true;
+}
+
+struct APP_Tilemap*
+APP_Tilemap_Create(int width, int height, int tile_size, SDL_Texture *tileset, int tileset_columns)
+{
+    struct APP_Tilemap *map = SDL_calloc(1, sizeof(struct APP_Tilemap));
+    if (map == NULL)
+    {
+        return NULL;
+    }
+
+    map->width = width;
+    map->height = height;
+    map->tile_size = tile_size;
+    map->tileset = tileset;
+    map->tileset_columns = tileset_columns;
+    map->chunks_x = (width + APP_TILEMAP_CHUNK_SIZE - 1) / APP_TILEMAP_CHUNK_SIZE;
+    map->chunks_y = (height + APP_TILEMAP_CHUNK_SIZE - 1) / APP_TILEMAP_CHUNK_SIZE;
+
+    SDL_GetTextureSize(tileset, &map->tileset_width, &map->tileset_height);
+
+    map->tiles = SDL_calloc((size_t)width * height, sizeof(Uint16));
+    map->chunks = SDL_calloc((size_t)map->chunks_x * map->chunks_y, sizeof(struct APP_TileChunk));
+
+    if (map->tiles == NULL || map->chunks == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate tilemap %ix%i.", width, height);
+        APP_Tilemap_Destroy(map);
+        return NULL;
+    }
+
+    // Note(john): The vertices of a chunk are allocated for a full chunk
+    // up front, a rebuild never has to allocate.
+    for (int i = 0; i < map->chunks_x * map->chunks_y; ++i)
+    {
+        struct APP_TileChunk *chunk = &map->chunks[i];
+
+        chunk->vertices = SDL_malloc(sizeof(SDL_Vertex) * 4 * APP_TILEMAP_CHUNK_SIZE * APP_TILEMAP_CHUNK_SIZE);
+        chunk->dirty = true;
+
+        if (chunk->vertices == NULL)
+        {
+            SDL_Log("ERROR: Failed to allocate tilemap chunk.");
+            APP_Tilemap_Destroy(map);
+            return NULL;
+        }
+    }
+
+    return map;
+}
+
+void
+APP_Tilemap_Destroy(struct APP_Tilemap *map)
+{
+    if (map == NULL)
+    {
+        return;
+    }
+
+    if (map->chunks != NULL)
+    {
+        for (int i = 0; i < map->chunks_x * map->chunks_y; ++i)
+        {
+            SDL_free(map->chunks[i].vertices);
+        }
+    }
+
+    SDL_free(map->chunks);
+    SDL_free(map->tiles);
+    SDL_free(map->draw_vertices);
+    SDL_free(map->draw_indices);
+    SDL_free(map);
+}
+
+Uint16
+APP_Tilemap_GetTile(const struct APP_Tilemap *map, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height)
+    {
+        return APP_TILE_EMPTY;
+    }
+
+    return map->tiles[y * map->width + x];
+}
+
+// Set a tile and mark its chunk dirty, the chunk is rebuilt the next time
+// it is visible.
+void
+APP_Tilemap_SetTile(struct APP_Tilemap *map, int x, int y, Uint16 tile)
+{
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height)
+    {
+        return;
+    }
+
+    Uint16 *current = &map->tiles[y * map->width + x];
+    if (*current == tile)
+    {
+        return;
+    }
+
+    *current = tile;
+
+    int chunk_x = x / APP_TILEMAP_CHUNK_SIZE;
+    int chunk_y = y / APP_TILEMAP_CHUNK_SIZE;
+    map->chunks[chunk_y * map->chunks_x + chunk_x].dirty = true;
+}
+
+// Draw the part of the map inside the camera rect (in map pixels). Chunks
+// outside the camera are skipped, dirty visible chunks are rebuilt and the
+// cached geometry of all visible chunks goes out in one SDL_RenderGeometry
+// call.
+bool
+APP_Tilemap_Render(struct APP_Tilemap *map, SDL_Renderer *renderer, const SDL_FRect *camera)
+{
+    int chunk_pixels = APP_TILEMAP_CHUNK_SIZE * map->tile_size;
+    struct APP_TileRange range = APP_Tilemap_VisibleRange(
+            camera,
+            chunk_pixels,
+            map->chunks_x,
+            map->chunks_y
+    );
+
+    SDL_zero(map->stats);
+
+    int tile_count = 0;
+
+    for (int chunk_y = range.min_y; chunk_y < range.max_y; ++chunk_y)
+    {
+        for (int chunk_x = range.min_x; chunk_x < range.max_x; ++chunk_x)
+        {
+            struct APP_TileChunk *chunk = &map->chunks[chunk_y * map->chunks_x + chunk_x];
+
+            if (chunk->dirty)
+            {
+                APP_Tilemap_BuildChunk(map, chunk_x, chunk_y);
+                map->stats.rebuilt_chunks++;
+            }
+
+            tile_count += chunk->tile_count;
+            map->stats.visible_chunks++;
+        }
+    }
+
+    if (tile_count == 0)
+    {
+        return true;
+    }
+
+    if (!APP_Tilemap_ReserveDraw(map, tile_count))
+    {
+        SDL_Log("ERROR: Failed to allocate tilemap draw buffers.");
+        return false;
+    }
+
+    // Note(john): SDL_RenderGeometry has no transform, so the cached chunk
+    // vertices are copied with the chunk and camera offset applied. The
+    // camera is snapped to whole pixels, otherwise the tiles bleed into
+    // their neighbours in the tileset.
+    float camera_x = SDL_floorf(camera->x);
+    float camera_y = SDL_floorf(camera->y);
+    SDL_Vertex *out = map->draw_vertices;
+
+    for (int chunk_y = range.min_y; chunk_y < range.max_y; ++chunk_y)
+    {
+        for (int chunk_x = range.min_x; chunk_x < range.max_x; ++chunk_x)
+        {
+            const struct APP_TileChunk *chunk = &map->chunks[chunk_y * map->chunks_x + chunk_x];
+            float offset_x = (float)(chunk_x * chunk_pixels) - camera_x;
+            float offset_y = (float)(chunk_y * chunk_pixels) - camera_y;
+
+            for (int i = 0; i < chunk->tile_count * 4; ++i)
+            {
+                *out = chunk->vertices[i];
+                out->position.x += offset_x;
+                out->position.y += offset_y;
+                out++;
+            }
+        }
+    }
+
+    map->stats.tiles = tile_count;
+    map->stats.draw_calls = 1;
+
+    return SDL_RenderGeometry(
+            renderer,
+            map->tileset,
+            map->draw_vertices,
+            tile_count * 4,
+            map->draw_indices,
+            tile_count * 6
+    );
+}
+
+// Reference path with one SDL_RenderTexture call per visible tile, used to
+// compare against the chunked path.
+bool
+APP_Tilemap_RenderPerTile(struct APP_Tilemap *map, SDL_Renderer *renderer, const SDL_FRect *camera)
+{
+    struct APP_TileRange range = APP_Tilemap_VisibleRange(
+            camera,
+            map->tile_size,
+            map->width,
+            map->height
+    );
+
+    SDL_zero(map->stats);
+
+    float camera_x = SDL_floorf(camera->x);
+    float camera_y = SDL_floorf(camera->y);
+
+    for (int y = range.min_y; y < range.max_y; ++y)
+    {
+        for (int x = range.min_x; x < range.max_x; ++x)
+        {
+            Uint16 tile = map->tiles[y * map->width + x];
+            if (tile == APP_TILE_EMPTY)
+            {
+                continue;
+            }
+
+            SDL_FRect source = APP_Tilemap_TileSource(map, tile);
+            SDL_FRect destination = {
+                .x = (float)(x * map->tile_size) - camera_x,
+                .y = (float)(y * map->tile_size) - camera_y,
+                .w = (float)map->tile_size,
+                .h = (float)map->tile_size,
+            };
+
+            SDL_RenderTexture(renderer, map->tileset, &source, &destination);
+
+            map->stats.tiles++;
+            map->stats.draw_calls++;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,71 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <SDL3/SDL.h>
+
+// Tiles per chunk side.
+#define APP_TILEMAP_CHUNK_SIZE 32
+
+// Tile 0 is empty, tile n uses cell n - 1 of the tileset.
+#define APP_TILE_EMPTY 0
+
+struct APP_TileChunk {
+    // Geometry in chunk local pixels, four vertices per non empty tile.
+    SDL_Vertex *vertices;
+    int tile_count;
+    bool dirty;
+};
+
+struct APP_TilemapStats {
+    int visible_chunks;
+    int rebuilt_chunks;
+    int draw_calls;
+    int tiles;
+};
+
+struct APP_Tilemap {
+    int width, height;
+    int tile_size;
+    Uint16 *tiles;
+
+    SDL_Texture *tileset;
+    int tileset_columns;
+    float tileset_width, tileset_height;
+
+    int chunks_x, chunks_y;
+    struct APP_TileChunk *chunks;
+
+    // Vertices and indices of the visible chunks, moved to screen space.
+    SDL_Vertex *draw_vertices;
+    int *draw_indices;
+    int draw_capacity;
+
+    struct APP_TilemapStats stats;
+};
+
+struct APP_Tilemap *APP_Tilemap_Create(
+        int width,
+        int height,
+        int tile_size,
+        SDL_Texture *tileset,
+        int tileset_columns
+);
+
+void APP_Tilemap_Destroy(struct APP_Tilemap *map);
+
+Uint16 APP_Tilemap_GetTile(const struct APP_Tilemap *map, int x, int y);
+void APP_Tilemap_SetTile(struct APP_Tilemap *map, int x, int y, Uint16 tile);
+
+bool APP_Tilemap_Render(
+        struct APP_Tilemap *map,
+        SDL_Renderer *renderer,
+        const SDL_FRect *camera
+);
+
+bool APP_Tilemap_RenderPerTile(
+        struct APP_Tilemap *map,
+        SDL_Renderer *renderer,
+        const SDL_FRect *camera
+);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#include <SDL3/SDL.h>
+
+// IMA ADPCM as WAV files carry it (format 0x11): 4 bits per sample, a
+// quarter of 16 bit PCM. The samples come in blocks that each start with a
+// full sample and the decoder state of every channel, so decoding can start
+// at any block. Inside a block the channels take turns with groups of eight
+// samples in four bytes.
+
+#define APP_ADPCM_FORMAT_TAG 0x0011
+#define APP_ADPCM_MAX_CHANNELS 2
+// The encoder's default block size per channel, 1017 frames each.
+#define APP_ADPCM_DEFAULT_CHANNEL_BLOCK_BYTES 512
+
+// The blocks as they are in the file.
+struct APP_ADPCMSound {
+    Uint8 *blocks;
+    Uint32 block_count;
+    // Of one block with all channels.
+    Uint32 block_bytes;
+    Uint32 block_frames;
+    Uint32 channels;
+    Uint32 frame_count;
+    int freq;
+};
+
+// Where decoding goes on from, one per voice playing the sound.
+struct APP_ADPCMDecoder {
+    Uint32 frame;
+    Sint32 predictor[APP_ADPCM_MAX_CHANNELS];
+    Sint32 step_index[APP_ADPCM_MAX_CHANNELS];
+};
+
+Uint32 APP_ADPCM_GetBlockFrames(Uint32 block_bytes, Uint32 channels);
+
+// Whether io holds a WAV with IMA ADPCM samples. Reads the header and seeks
+// back to where io was.
+bool APP_ADPCM_IsWAV(SDL_IOStream *io);
+// Reads the blocks into memory as they are, one or two channels. Doesn't
+// close io.
+bool APP_ADPCM_LoadWAV(SDL_IOStream *io, struct APP_ADPCMSound *out_sound);
+void APP_ADPCM_Free(struct APP_ADPCMSound *sound);
+Uint64 APP_ADPCM_GetSize(const struct APP_ADPCMSound *sound);
+
+// Decoding starts over at the block the frame is in and runs up to it.
+void APP_ADPCM_Seek(const struct APP_ADPCMSound *sound, struct APP_ADPCMDecoder *decoder, Uint32 frame);
+// Up to count frames as planar float into dst, one pointer per channel.
+// Returns fewer at the end of the sound.
+Uint32 APP_ADPCM_Decode(const struct APP_ADPCMSound *sound, struct APP_ADPCMDecoder *decoder, float *const *dst, Uint32 count);
+
+// Interleaved 16 bit samples into a WAV, block_bytes per block with all
+// channels, a multiple of 4 per channel.
+bool APP_ADPCM_EncodeWAV(
+        const Sint16 *samples,
+        Uint32 frame_count,
+        Uint32 channels,
+        int freq,
+        Uint32 block_bytes,
+        SDL_IOStream *out
+);
+
+#endif
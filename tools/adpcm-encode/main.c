@@ -0,0 +1,145 @@
+#include "adpcm.h"
+
+// Signal to error of the written file against the input, in dB.
+static double
+APP_MeasureError(const char *path, const Sint16 *samples, Uint32 channels)
+{
+    SDL_IOStream *io = SDL_IOFromFile(path, "rb");
+    if (io == NULL)
+    {
+        return 0.0;
+    }
+
+    struct APP_ADPCMSound sound;
+    bool loaded = APP_ADPCM_LoadWAV(io, &sound);
+    SDL_CloseIO(io);
+
+    if (!loaded)
+    {
+        return 0.0;
+    }
+
+    float decoded[APP_ADPCM_MAX_CHANNELS][256];
+    float *dst[APP_ADPCM_MAX_CHANNELS] = { decoded[0], decoded[1] };
+    struct APP_ADPCMDecoder decoder;
+    APP_ADPCM_Seek(&sound, &decoder, 0);
+
+    double signal = 0.0;
+    double error = 0.0;
+    Uint32 done = 0;
+
+    for (;;)
+    {
+        Uint32 count = APP_ADPCM_Decode(&sound, &decoder, dst, SDL_arraysize(decoded[0]));
+        if (count == 0)
+        {
+            break;
+        }
+
+        for (Uint32 i = 0; i < count; ++i)
+        {
+            for (Uint32 c = 0; c < channels; ++c)
+            {
+                double expected = samples[(done + i) * channels + c] / 32768.0;
+                double diff = decoded[c][i] - expected;
+                signal += expected * expected;
+                error += diff * diff;
+            }
+        }
+
+        done += count;
+    }
+
+    APP_ADPCM_Free(&sound);
+    return error > 0.0 ? 10.0 * SDL_log10(signal / error) : 0.0;
+}
+
+// Usage: adpcm-encode [--block-bytes N] <input.wav> <output.wav>
+int
+main(int argc, char **argv)
+{
+    Uint32 channel_block_bytes = APP_ADPCM_DEFAULT_CHANNEL_BLOCK_BYTES;
+    int first_input = 1;
+
+    for (; first_input < argc; ++first_input)
+    {
+        if (SDL_strcmp(argv[first_input], "--block-bytes") == 0 && first_input + 1 < argc)
+        {
+            channel_block_bytes = (Uint32)SDL_atoi(argv[++first_input]);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argc - first_input != 2)
+    {
+        SDL_Log("Usage: adpcm-encode [--block-bytes N] <input.wav> <output.wav>");
+        SDL_Log("Blocks hold N bytes per channel (default %u, a multiple of 4).", APP_ADPCM_DEFAULT_CHANNEL_BLOCK_BYTES);
+        return 1;
+    }
+
+    const char *input = argv[first_input];
+    const char *output = argv[first_input + 1];
+
+    SDL_AudioSpec spec;
+    Uint8 *wav = NULL;
+    Uint32 wav_length = 0;
+    if (!SDL_LoadWAV(input, &spec, &wav, &wav_length))
+    {
+        SDL_Log("ERROR: Failed to load %s: %s", input, SDL_GetError());
+        return 1;
+    }
+
+    // Note(john): More than two channels are mixed down to stereo, the way
+    // the mixer loads them.
+    const SDL_AudioSpec s16_spec = { SDL_AUDIO_S16LE, SDL_min(spec.channels, APP_ADPCM_MAX_CHANNELS), spec.freq };
+    Sint16 *samples = NULL;
+    int samples_length = 0;
+    bool converted = SDL_ConvertAudioSamples(&spec, wav, (int)wav_length, &s16_spec, (Uint8 **)&samples, &samples_length);
+    SDL_free(wav);
+
+    if (!converted)
+    {
+        SDL_Log("ERROR: Failed to convert %s: %s", input, SDL_GetError());
+        return 1;
+    }
+
+    const Uint32 channels = (Uint32)s16_spec.channels;
+    const Uint32 frame_count = (Uint32)samples_length / (Uint32)(sizeof(Sint16) * channels);
+
+    SDL_IOStream *io = SDL_IOFromFile(output, "wb");
+    if (io == NULL)
+    {
+        SDL_Log("ERROR: Failed to create %s: %s", output, SDL_GetError());
+        SDL_free(samples);
+        return 1;
+    }
+
+    bool encoded = APP_ADPCM_EncodeWAV(samples, frame_count, channels, s16_spec.freq, channel_block_bytes * channels, io);
+    Sint64 size = SDL_GetIOSize(io);
+
+    if (!SDL_CloseIO(io) || !encoded)
+    {
+        SDL_Log("ERROR: Failed to write %s.", output);
+        SDL_RemovePath(output);
+        SDL_free(samples);
+        return 1;
+    }
+
+    Sint64 raw_size = (Sint64)samples_length;
+    SDL_Log(
+            "INFO: Wrote %s, %u Hz %s, %u frames, %lld bytes (%.1f%% of 16 bit), SNR %.1f dB",
+            output,
+            (unsigned)s16_spec.freq,
+            channels == 1 ? "mono" : "stereo",
+            frame_count,
+            (long long)size,
+            raw_size > 0 ? 100.0 * (double)size / (double)raw_size : 0.0,
+            APP_MeasureError(output, samples, channels)
+    );
+
+    SDL_free(samples);
+    return 0;
+}
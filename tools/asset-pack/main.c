@@ -0,0 +1,542 @@
+#include "pack.h"
+
+#define DEFAULT_OUTPUT "assets.pack"
+#define DEFAULT_ALIGNMENT 64
+#define COMPRESS_HASH_BITS 14
+
+struct PackInput {
+    char *name;
+    Uint8 *data;
+    size_t raw_size;
+    size_t size;
+    bool compressed;
+    Uint64 offset;
+    Uint32 name_offset;
+};
+
+struct PackBuilder {
+    struct PackInput *inputs;
+    Uint32 count;
+    Uint32 capacity;
+    const char *output;
+    bool failed;
+};
+
+// ====================
+// Compression
+// ====================
+
+static Uint32
+APP_ReadU32(const Uint8 *p)
+{
+    return (Uint32)p[0] | ((Uint32)p[1] << 8) | ((Uint32)p[2] << 16) | ((Uint32)p[3] << 24);
+}
+
+static bool
+APP_WriteLength(Uint8 **out, Uint8 *out_end, size_t length)
+{
+    while (length >= 255)
+    {
+        if (*out >= out_end)
+        {
+            return false;
+        }
+
+        *(*out)++ = 255;
+        length -= 255;
+    }
+
+    if (*out >= out_end)
+    {
+        return false;
+    }
+
+    *(*out)++ = (Uint8)length;
+    return true;
+}
+
+// One sequence: literals, then a match of at least 4 bytes unless it is the
+// last one.
+static bool
+APP_WriteSequence(
+        Uint8 **out,
+        Uint8 *out_end,
+        const Uint8 *literals,
+        size_t literal_length,
+        size_t offset,
+        size_t match_length
+)
+{
+    if (*out >= out_end)
+    {
+        return false;
+    }
+
+    size_t match_code = match_length > 0 ? match_length - 4 : 0;
+    Uint8 *token = (*out)++;
+    *token = (Uint8)((SDL_min(literal_length, 15) << 4) | SDL_min(match_code, 15));
+
+    if (literal_length >= 15 && !APP_WriteLength(out, out_end, literal_length - 15))
+    {
+        return false;
+    }
+
+    if (literal_length > (size_t)(out_end - *out))
+    {
+        return false;
+    }
+
+    SDL_memcpy(*out, literals, literal_length);
+    *out += literal_length;
+
+    if (match_length == 0)
+    {
+        return true;
+    }
+
+    if (out_end - *out < 2)
+    {
+        return false;
+    }
+
+    *(*out)++ = (Uint8)(offset & 0xFF);
+    *(*out)++ = (Uint8)(offset >> 8);
+
+    return match_code < 15 || APP_WriteLength(out, out_end, match_code - 15);
+}
+
+// Greedy LZ with a hash table of the last position of every 4 byte prefix.
+// Returns the compressed size, 0 if it doesn't fit into dst.
+static size_t
+APP_Compress(const Uint8 *src, size_t size, Uint8 *dst, size_t capacity)
+{
+    static Uint32 table[1 << COMPRESS_HASH_BITS];
+    SDL_memset(table, 0xFF, sizeof(table));
+
+    Uint8 *out = dst;
+    Uint8 *out_end = dst + capacity;
+    size_t anchor = 0;
+    size_t i = 0;
+
+    while (i + 4 <= size)
+    {
+        Uint32 sequence = APP_ReadU32(src + i);
+        Uint32 hash = (sequence * 2654435761u) >> (32 - COMPRESS_HASH_BITS);
+        Uint32 candidate = table[hash];
+        table[hash] = (Uint32)i;
+
+        if (candidate == 0xFFFFFFFFu || i - candidate > 0xFFFF || APP_ReadU32(src + candidate) != sequence)
+        {
+            i++;
+            continue;
+        }
+
+        size_t length = 4;
+        while (i + length < size && src[candidate + length] == src[i + length])
+        {
+            length++;
+        }
+
+        if (!APP_WriteSequence(&out, out_end, src + anchor, i - anchor, i - candidate, length))
+        {
+            return 0;
+        }
+
+        i += length;
+        anchor = i;
+    }
+
+    if (anchor < size && !APP_WriteSequence(&out, out_end, src + anchor, size - anchor, 0, 0))
+    {
+        return 0;
+    }
+
+    return (size_t)(out - dst);
+}
+
+// Keep the compressed bytes only if they save at least an eighth, the
+// rest is read without a copy.
+static void
+APP_CompressInput(struct PackInput *input)
+{
+    if (input->raw_size < 64)
+    {
+        return;
+    }
+
+    size_t capacity = input->raw_size - input->raw_size / 8;
+    Uint8 *compressed = SDL_malloc(capacity);
+    if (compressed == NULL)
+    {
+        return;
+    }
+
+    size_t size = APP_Compress(input->data, input->raw_size, compressed, capacity);
+
+    Uint8 *check = size > 0 ? SDL_malloc(input->raw_size) : NULL;
+    bool valid = check != NULL
+        && APP_Pack_Decompress(compressed, size, check, input->raw_size) == input->raw_size
+        && SDL_memcmp(check, input->data, input->raw_size) == 0;
+
+    SDL_free(check);
+
+    if (!valid)
+    {
+        if (size > 0)
+        {
+            SDL_Log("ERROR: Compression of %s failed to round trip, stored raw.", input->name);
+        }
+
+        SDL_free(compressed);
+        return;
+    }
+
+    SDL_free(input->data);
+    input->data = compressed;
+    input->size = size;
+    input->compressed = true;
+}
+
+// ====================
+// Inputs
+// ====================
+
+static void
+APP_AddFile(struct PackBuilder *builder, const char *path)
+{
+    if (builder->count == builder->capacity)
+    {
+        Uint32 capacity = builder->capacity ? builder->capacity * 2 : 64;
+        void *inputs = SDL_realloc(builder->inputs, capacity * sizeof(struct PackInput));
+        if (inputs == NULL)
+        {
+            SDL_Log("ERROR: Out of memory.");
+            builder->failed = true;
+            return;
+        }
+
+        builder->inputs = inputs;
+        builder->capacity = capacity;
+    }
+
+    struct PackInput *input = &builder->inputs[builder->count];
+    SDL_zerop(input);
+
+    // Names are relative paths with forward slashes.
+    if (SDL_strncmp(path, "./", 2) == 0)
+    {
+        path += 2;
+    }
+
+    input->name = SDL_strdup(path);
+    for (char *c = input->name; *c; ++c)
+    {
+        if (*c == '\\')
+        {
+            *c = '/';
+        }
+    }
+
+    input->data = SDL_LoadFile(path, &input->raw_size);
+    if (input->data == NULL)
+    {
+        SDL_Log("ERROR: Failed to read %s: %s", path, SDL_GetError());
+        SDL_free(input->name);
+        builder->failed = true;
+        return;
+    }
+
+    input->size = input->raw_size;
+    builder->count++;
+}
+
+static void APP_AddPath(struct PackBuilder *builder, const char *path);
+
+static SDL_EnumerationResult
+APP_AddDirectoryEntry(void *userdata, const char *dirname, const char *fname)
+{
+    struct PackBuilder *builder = userdata;
+    char path[1024];
+
+    if (fname[0] == '.')
+    {
+        return SDL_ENUM_CONTINUE;
+    }
+
+    SDL_snprintf(path, sizeof(path), "%s%s", dirname, fname);
+    APP_AddPath(builder, path);
+
+    return builder->failed ? SDL_ENUM_FAILURE : SDL_ENUM_CONTINUE;
+}
+
+static void
+APP_AddPath(struct PackBuilder *builder, const char *path)
+{
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(path, &info))
+    {
+        SDL_Log("ERROR: %s doesn't exist.", path);
+        builder->failed = true;
+        return;
+    }
+
+    if (info.type == SDL_PATHTYPE_DIRECTORY)
+    {
+        SDL_EnumerateDirectory(path, APP_AddDirectoryEntry, builder);
+    }
+    else if (info.type == SDL_PATHTYPE_FILE && SDL_strcmp(path, builder->output) != 0)
+    {
+        APP_AddFile(builder, path);
+    }
+}
+
+static int
+APP_CompareInputs(const void *a, const void *b)
+{
+    return SDL_strcmp(((const struct PackInput *)a)->name, ((const struct PackInput *)b)->name);
+}
+
+// ====================
+// Writing
+// ====================
+
+static bool
+APP_WritePadding(SDL_IOStream *io, Uint64 *position, Uint64 target)
+{
+    static const Uint8 zeros[256];
+
+    while (*position < target)
+    {
+        size_t count = (size_t)SDL_min(target - *position, sizeof(zeros));
+        if (SDL_WriteIO(io, zeros, count) != count)
+        {
+            return false;
+        }
+
+        *position += count;
+    }
+
+    return true;
+}
+
+static bool
+APP_WritePack(struct PackBuilder *builder, Uint32 alignment)
+{
+    // Note(john): At most half full, so a lookup of a missing name ends at
+    // an empty bucket after a few probes.
+    Uint32 bucket_count = 8;
+    while (bucket_count < builder->count * 2)
+    {
+        bucket_count *= 2;
+    }
+
+    Uint32 *buckets = SDL_malloc(bucket_count * sizeof(Uint32));
+    if (buckets == NULL)
+    {
+        return false;
+    }
+
+    SDL_memset(buckets, 0xFF, bucket_count * sizeof(Uint32));
+
+    Uint64 toc_offset = sizeof(struct APP_PackHeader);
+    Uint64 names_offset = toc_offset + (Uint64)builder->count * sizeof(struct APP_PackTocEntry) + bucket_count * sizeof(Uint32);
+    Uint64 names_size = 0;
+
+    for (Uint32 i = 0; i < builder->count; ++i)
+    {
+        struct PackInput *input = &builder->inputs[i];
+        size_t length = SDL_strlen(input->name);
+
+        input->name_offset = (Uint32)names_size;
+        names_size += length + 1;
+
+        Uint32 hash = APP_Pack_Hash(input->name, length);
+        Uint32 bucket = hash & (bucket_count - 1);
+        while (buckets[bucket] != APP_PACK_EMPTY_BUCKET)
+        {
+            bucket = (bucket + 1) & (bucket_count - 1);
+        }
+
+        buckets[bucket] = i;
+    }
+
+    Uint64 offset = names_offset + names_size;
+    for (Uint32 i = 0; i < builder->count; ++i)
+    {
+        offset = (offset + alignment - 1) & ~(Uint64)(alignment - 1);
+        builder->inputs[i].offset = offset;
+        offset += builder->inputs[i].size;
+    }
+
+    SDL_IOStream *io = SDL_IOFromFile(builder->output, "wb");
+    if (io == NULL)
+    {
+        SDL_Log("ERROR: Failed to create %s: %s", builder->output, SDL_GetError());
+        SDL_free(buckets);
+        return false;
+    }
+
+    bool ok = SDL_WriteU32LE(io, APP_PACK_MAGIC)
+        && SDL_WriteU32LE(io, APP_PACK_VERSION)
+        && SDL_WriteU32LE(io, builder->count)
+        && SDL_WriteU32LE(io, bucket_count)
+        && SDL_WriteU64LE(io, toc_offset)
+        && SDL_WriteU64LE(io, names_offset)
+        && SDL_WriteU32LE(io, alignment)
+        && SDL_WriteU32LE(io, 0);
+
+    for (Uint32 i = 0; ok && i < builder->count; ++i)
+    {
+        const struct PackInput *input = &builder->inputs[i];
+        size_t length = SDL_strlen(input->name);
+
+        ok = SDL_WriteU32LE(io, APP_Pack_Hash(input->name, length))
+            && SDL_WriteU32LE(io, input->name_offset)
+            && SDL_WriteU32LE(io, (Uint32)length)
+            && SDL_WriteU32LE(io, input->compressed ? APP_PACK_ENTRY_COMPRESSED : 0)
+            && SDL_WriteU64LE(io, input->offset)
+            && SDL_WriteU64LE(io, input->size)
+            && SDL_WriteU64LE(io, input->raw_size);
+    }
+
+    for (Uint32 i = 0; ok && i < bucket_count; ++i)
+    {
+        ok = SDL_WriteU32LE(io, buckets[i]);
+    }
+
+    for (Uint32 i = 0; ok && i < builder->count; ++i)
+    {
+        size_t length = SDL_strlen(builder->inputs[i].name) + 1;
+        ok = SDL_WriteIO(io, builder->inputs[i].name, length) == length;
+    }
+
+    Uint64 position = names_offset + names_size;
+    for (Uint32 i = 0; ok && i < builder->count; ++i)
+    {
+        const struct PackInput *input = &builder->inputs[i];
+
+        ok = APP_WritePadding(io, &position, input->offset)
+            && SDL_WriteIO(io, input->data, input->size) == input->size;
+        position += input->size;
+    }
+
+    ok = SDL_CloseIO(io) && ok;
+    SDL_free(buckets);
+
+    if (!ok)
+    {
+        SDL_Log("ERROR: Failed to write %s: %s", builder->output, SDL_GetError());
+    }
+
+    return ok;
+}
+
+// Usage: asset-pack [-o assets.pack] [--compress] [--align N] <file or directory>...
+int
+main(int argc, char **argv)
+{
+    struct PackBuilder builder = { 0 };
+    builder.output = DEFAULT_OUTPUT;
+
+    Uint32 alignment = DEFAULT_ALIGNMENT;
+    bool compress = false;
+    int first_input = argc;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (SDL_strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            builder.output = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--compress") == 0)
+        {
+            compress = true;
+        }
+        else if (SDL_strcmp(argv[i], "--align") == 0 && i + 1 < argc)
+        {
+            alignment = (Uint32)SDL_atoi(argv[++i]);
+        }
+        else
+        {
+            first_input = i;
+            break;
+        }
+    }
+
+    if (first_input == argc || alignment == 0 || (alignment & (alignment - 1)) != 0)
+    {
+        SDL_Log("Usage: asset-pack [-o assets.pack] [--compress] [--align N] <file or directory>...");
+        SDL_Log("The alignment is a power of two (default %u).", DEFAULT_ALIGNMENT);
+        return 1;
+    }
+
+    for (int i = first_input; i < argc && !builder.failed; ++i)
+    {
+        APP_AddPath(&builder, argv[i]);
+    }
+
+    int result = 1;
+
+    if (!builder.failed)
+    {
+        SDL_qsort(builder.inputs, builder.count, sizeof(struct PackInput), APP_CompareInputs);
+
+        for (Uint32 i = 1; i < builder.count; ++i)
+        {
+            if (SDL_strcmp(builder.inputs[i - 1].name, builder.inputs[i].name) == 0)
+            {
+                SDL_Log("ERROR: %s was added twice.", builder.inputs[i].name);
+                builder.failed = true;
+            }
+        }
+    }
+
+    if (!builder.failed)
+    {
+        Uint64 raw_bytes = 0;
+        Uint64 packed_bytes = 0;
+
+        for (Uint32 i = 0; i < builder.count; ++i)
+        {
+            struct PackInput *input = &builder.inputs[i];
+
+            if (compress)
+            {
+                APP_CompressInput(input);
+            }
+
+            raw_bytes += input->raw_size;
+            packed_bytes += input->size;
+
+            SDL_Log(
+                    "INFO: %-48s %10zu bytes%s",
+                    input->name,
+                    input->size,
+                    input->compressed ? " (compressed)" : ""
+            );
+        }
+
+        if (APP_WritePack(&builder, alignment))
+        {
+            SDL_Log(
+                    "INFO: Wrote %s, %u assets, %llu bytes of %llu (%.1f%%), aligned to %u",
+                    builder.output,
+                    builder.count,
+                    (unsigned long long)packed_bytes,
+                    (unsigned long long)raw_bytes,
+                    raw_bytes > 0 ? 100.0 * (double)packed_bytes / (double)raw_bytes : 100.0,
+                    alignment
+            );
+            result = 0;
+        }
+    }
+
+    for (Uint32 i = 0; i < builder.count; ++i)
+    {
+        SDL_free(builder.inputs[i].name);
+        SDL_free(builder.inputs[i].data);
+    }
+
+    SDL_free(builder.inputs);
+    return result;
+}
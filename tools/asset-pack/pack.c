@@ -0,0 +1,496 @@
+#include "pack.h"
+
+#if defined(SDL_PLATFORM_WINDOWS)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define APP_PACK_MMAP
+#elif defined(SDL_PLATFORM_UNIX) || defined(SDL_PLATFORM_APPLE)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define APP_PACK_MMAP
+#endif
+
+struct APP_Pack {
+    const Uint8 *data;
+    Uint64 size;
+    // Mapped or, where mapping isn't available or fails, read whole.
+    bool mapped;
+#if defined(SDL_PLATFORM_WINDOWS)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+
+    const struct APP_PackHeader *header;
+    const struct APP_PackTocEntry *entries;
+    const Uint32 *buckets;
+    const char *names;
+    Uint32 entry_count;
+    Uint32 bucket_mask;
+
+    // Assets are read from the loader threads too, the counters are
+    // guarded by the lock.
+    SDL_SpinLock stats_lock;
+    Uint32 zero_copy_reads;
+    Uint32 decompressed_reads;
+    Uint64 decompressed_bytes;
+};
+
+// ====================
+// Mapping
+// ====================
+
+static bool
+APP_Pack_Map(struct APP_Pack *pack, const char *path)
+{
+#if defined(SDL_PLATFORM_WINDOWS)
+    pack->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (pack->file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(pack->file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(pack->file);
+        return false;
+    }
+
+    pack->mapping = CreateFileMappingA(pack->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (pack->mapping == NULL)
+    {
+        CloseHandle(pack->file);
+        return false;
+    }
+
+    pack->data = MapViewOfFile(pack->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (pack->data == NULL)
+    {
+        CloseHandle(pack->mapping);
+        CloseHandle(pack->file);
+        return false;
+    }
+
+    pack->size = (Uint64)size.QuadPart;
+    return true;
+#elif defined(APP_PACK_MMAP)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // Note(john): The mapping stays valid after the descriptor is closed.
+    void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    pack->data = data;
+    pack->size = (Uint64)info.st_size;
+    return true;
+#else
+    return false;
+#endif
+}
+
+static void
+APP_Pack_Unmap(struct APP_Pack *pack)
+{
+    if (!pack->mapped)
+    {
+        SDL_free((void *)pack->data);
+        return;
+    }
+
+#if defined(SDL_PLATFORM_WINDOWS)
+    UnmapViewOfFile(pack->data);
+    CloseHandle(pack->mapping);
+    CloseHandle(pack->file);
+#elif defined(APP_PACK_MMAP)
+    munmap((void *)pack->data, (size_t)pack->size);
+#endif
+}
+
+// ====================
+// Table of contents
+// ====================
+
+Uint32
+APP_Pack_Hash(const char *name, size_t length)
+{
+    return SDL_murmur3_32(name, length, APP_PACK_HASH_SEED);
+}
+
+// Check that every table and every entry lies inside the file, so the
+// lookups can trust them.
+static bool
+APP_Pack_Validate(struct APP_Pack *pack)
+{
+    if (pack->size < sizeof(struct APP_PackHeader))
+    {
+        return false;
+    }
+
+    const struct APP_PackHeader *header = (const struct APP_PackHeader *)pack->data;
+    Uint32 entry_count = SDL_Swap32LE(header->entry_count);
+    Uint32 bucket_count = SDL_Swap32LE(header->bucket_count);
+    Uint64 toc_offset = SDL_Swap64LE(header->toc_offset);
+    Uint64 names_offset = SDL_Swap64LE(header->names_offset);
+
+    if (SDL_Swap32LE(header->magic) != APP_PACK_MAGIC || SDL_Swap32LE(header->version) != APP_PACK_VERSION)
+    {
+        return false;
+    }
+
+    // A power of two with at least one empty bucket, the probing relies on
+    // both.
+    if (bucket_count == 0 || (bucket_count & (bucket_count - 1)) != 0 || bucket_count <= entry_count)
+    {
+        return false;
+    }
+
+    Uint64 buckets_offset = toc_offset + (Uint64)entry_count * sizeof(struct APP_PackTocEntry);
+    if (toc_offset % 8 != 0
+        || buckets_offset + (Uint64)bucket_count * sizeof(Uint32) > names_offset
+        || names_offset > pack->size)
+    {
+        return false;
+    }
+
+    pack->header = header;
+    pack->entries = (const struct APP_PackTocEntry *)(pack->data + toc_offset);
+    pack->buckets = (const Uint32 *)(pack->data + buckets_offset);
+    pack->names = (const char *)(pack->data + names_offset);
+    pack->entry_count = entry_count;
+    pack->bucket_mask = bucket_count - 1;
+
+    for (Uint32 i = 0; i < entry_count; ++i)
+    {
+        const struct APP_PackTocEntry *entry = &pack->entries[i];
+        Uint64 name_end = names_offset + SDL_Swap32LE(entry->name_offset) + SDL_Swap32LE(entry->name_length);
+        Uint64 offset = SDL_Swap64LE(entry->offset);
+        Uint64 size = SDL_Swap64LE(entry->size);
+
+        if (name_end >= pack->size || offset > pack->size || size > pack->size - offset)
+        {
+            return false;
+        }
+    }
+
+    for (Uint32 i = 0; i <= pack->bucket_mask; ++i)
+    {
+        Uint32 index = SDL_Swap32LE(pack->buckets[i]);
+        if (index != APP_PACK_EMPTY_BUCKET && index >= entry_count)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+struct APP_Pack*
+APP_Pack_Open(const char *path)
+{
+    struct APP_Pack *pack = SDL_calloc(1, sizeof(struct APP_Pack));
+    if (pack == NULL)
+    {
+        return NULL;
+    }
+
+    pack->mapped = APP_Pack_Map(pack, path);
+
+    if (!pack->mapped)
+    {
+        size_t size;
+        pack->data = SDL_LoadFile(path, &size);
+        pack->size = size;
+
+        if (pack->data == NULL)
+        {
+            SDL_free(pack);
+            return NULL;
+        }
+    }
+
+    if (!APP_Pack_Validate(pack))
+    {
+        SDL_Log("ERROR: %s is not a valid asset pack.", path);
+        APP_Pack_Close(pack);
+        return NULL;
+    }
+
+    SDL_Log(
+            "INFO: Asset pack %s, %u assets, %llu bytes, %s",
+            path,
+            pack->entry_count,
+            (unsigned long long)pack->size,
+            pack->mapped ? "mapped" : "read"
+    );
+
+    return pack;
+}
+
+void
+APP_Pack_Close(struct APP_Pack *pack)
+{
+    if (pack == NULL)
+    {
+        return;
+    }
+
+    APP_Pack_Unmap(pack);
+    SDL_free(pack);
+}
+
+static const struct APP_PackTocEntry*
+APP_Pack_Find(const struct APP_Pack *pack, const char *name)
+{
+    size_t length = SDL_strlen(name);
+    Uint32 hash = APP_Pack_Hash(name, length);
+
+    for (Uint32 i = hash & pack->bucket_mask;; i = (i + 1) & pack->bucket_mask)
+    {
+        Uint32 index = SDL_Swap32LE(pack->buckets[i]);
+        if (index == APP_PACK_EMPTY_BUCKET)
+        {
+            return NULL;
+        }
+
+        const struct APP_PackTocEntry *entry = &pack->entries[index];
+        if (SDL_Swap32LE(entry->hash) == hash
+            && SDL_Swap32LE(entry->name_length) == length
+            && SDL_memcmp(pack->names + SDL_Swap32LE(entry->name_offset), name, length) == 0)
+        {
+            return entry;
+        }
+    }
+}
+
+const void*
+APP_Pack_Read(struct APP_Pack *pack, const char *name, size_t *out_size, void **out_owned)
+{
+    *out_owned = NULL;
+
+    if (pack == NULL)
+    {
+        return NULL;
+    }
+
+    const struct APP_PackTocEntry *entry = APP_Pack_Find(pack, name);
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+
+    const Uint8 *data = pack->data + SDL_Swap64LE(entry->offset);
+    size_t size = (size_t)SDL_Swap64LE(entry->size);
+    size_t raw_size = (size_t)SDL_Swap64LE(entry->raw_size);
+
+    if ((SDL_Swap32LE(entry->flags) & APP_PACK_ENTRY_COMPRESSED) == 0)
+    {
+        SDL_LockSpinlock(&pack->stats_lock);
+        pack->zero_copy_reads++;
+        SDL_UnlockSpinlock(&pack->stats_lock);
+
+        *out_size = size;
+        return data;
+    }
+
+    Uint8 *buffer = SDL_malloc(raw_size > 0 ? raw_size : 1);
+    if (buffer == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate %zu bytes for %s.", raw_size, name);
+        return NULL;
+    }
+
+    if (APP_Pack_Decompress(data, size, buffer, raw_size) != raw_size)
+    {
+        SDL_Log("ERROR: Asset %s in the pack is corrupt.", name);
+        SDL_free(buffer);
+        return NULL;
+    }
+
+    SDL_LockSpinlock(&pack->stats_lock);
+    pack->decompressed_reads++;
+    pack->decompressed_bytes += raw_size;
+    SDL_UnlockSpinlock(&pack->stats_lock);
+
+    *out_size = raw_size;
+    *out_owned = buffer;
+    return buffer;
+}
+
+SDL_IOStream*
+APP_Pack_OpenIO(struct APP_Pack *pack, const char *name)
+{
+    size_t size;
+    void *owned;
+
+    const void *data = APP_Pack_Read(pack, name, &size, &owned);
+    if (data == NULL)
+    {
+        return NULL;
+    }
+
+    if (owned == NULL)
+    {
+        return SDL_IOFromConstMem(data, size);
+    }
+
+    // Note(john): A memory stream doesn't free its memory, so the
+    // decompressed bytes are handed over to a dynamic one.
+    SDL_IOStream *io = SDL_IOFromDynamicMem();
+    if (io != NULL && (SDL_WriteIO(io, data, size) != size || SDL_SeekIO(io, 0, SDL_IO_SEEK_SET) != 0))
+    {
+        SDL_CloseIO(io);
+        io = NULL;
+    }
+
+    SDL_free(owned);
+    return io;
+}
+
+// ====================
+// Decompression
+// ====================
+
+// Read a length continued by 255 bytes.
+static bool
+APP_Pack_ReadLength(const Uint8 **src, const Uint8 *src_end, size_t *length)
+{
+    Uint8 byte;
+
+    do
+    {
+        if (*src >= src_end)
+        {
+            return false;
+        }
+
+        byte = *(*src)++;
+        *length += byte;
+    } while (byte == 255);
+
+    return true;
+}
+
+size_t
+APP_Pack_Decompress(const Uint8 *src, size_t src_size, Uint8 *dst, size_t dst_size)
+{
+    const Uint8 *src_end = src + src_size;
+    Uint8 *out = dst;
+    Uint8 *out_end = dst + dst_size;
+
+    while (src < src_end)
+    {
+        Uint8 token = *src++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !APP_Pack_ReadLength(&src, src_end, &literal_length))
+        {
+            return 0;
+        }
+
+        if (literal_length > (size_t)(src_end - src) || literal_length > (size_t)(out_end - out))
+        {
+            return 0;
+        }
+
+        SDL_memcpy(out, src, literal_length);
+        src += literal_length;
+        out += literal_length;
+
+        // The last sequence only has literals.
+        if (src == src_end)
+        {
+            break;
+        }
+
+        if (src_end - src < 2)
+        {
+            return 0;
+        }
+
+        size_t offset = (size_t)src[0] | ((size_t)src[1] << 8);
+        src += 2;
+
+        size_t match_length = token & 0xF;
+        if (match_length == 15 && !APP_Pack_ReadLength(&src, src_end, &match_length))
+        {
+            return 0;
+        }
+
+        match_length += 4;
+
+        if (offset == 0 || offset > (size_t)(out - dst) || match_length > (size_t)(out_end - out))
+        {
+            return 0;
+        }
+
+        // Matches may overlap their own output, copy byte by byte.
+        const Uint8 *match = out - offset;
+        for (size_t i = 0; i < match_length; ++i)
+        {
+            out[i] = match[i];
+        }
+
+        out += match_length;
+    }
+
+    return (size_t)(out - dst);
+}
+
+void
+APP_Pack_GetStats(struct APP_Pack *pack, struct APP_PackStats *out_stats)
+{
+    SDL_zerop(out_stats);
+
+    if (pack == NULL)
+    {
+        return;
+    }
+
+    out_stats->entry_count = pack->entry_count;
+    out_stats->file_size = pack->size;
+    out_stats->mapped = pack->mapped;
+
+    SDL_LockSpinlock(&pack->stats_lock);
+    out_stats->zero_copy_reads = pack->zero_copy_reads;
+    out_stats->decompressed_reads = pack->decompressed_reads;
+    out_stats->decompressed_bytes = pack->decompressed_bytes;
+    SDL_UnlockSpinlock(&pack->stats_lock);
+}
+
+void
+APP_Pack_LogStats(struct APP_Pack *pack)
+{
+    if (pack == NULL)
+    {
+        SDL_Log("INFO: Assets read from loose files.");
+        return;
+    }
+
+    struct APP_PackStats stats;
+    APP_Pack_GetStats(pack, &stats);
+
+    SDL_Log(
+            "INFO: Asset pack reads: %u zero copy, %u decompressed (%llu KB)",
+            stats.zero_copy_reads,
+            stats.decompressed_reads,
+            (unsigned long long)(stats.decompressed_bytes / 1024)
+    );
+}
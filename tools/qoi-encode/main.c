@@ -0,0 +1,81 @@
+#include "qoi.h"
+
+#define DEFAULT_SLICE_ROWS 64
+
+// Usage: qoi-encode [--slice-rows N] <input.bmp> <output.qoi>
+int
+main(int argc, char **argv)
+{
+    Uint32 slice_rows = DEFAULT_SLICE_ROWS;
+    int first_input = 1;
+
+    for (; first_input < argc; ++first_input)
+    {
+        if (SDL_strcmp(argv[first_input], "--slice-rows") == 0 && first_input + 1 < argc)
+        {
+            slice_rows = (Uint32)SDL_atoi(argv[++first_input]);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argc - first_input != 2)
+    {
+        SDL_Log("Usage: qoi-encode [--slice-rows N] <input.bmp> <output.qoi>");
+        SDL_Log("A new slice starts every N rows (default %u, 0 for one slice).", DEFAULT_SLICE_ROWS);
+        return 1;
+    }
+
+    const char *input = argv[first_input];
+    const char *output = argv[first_input + 1];
+
+    SDL_Surface *image = SDL_LoadBMP(input);
+    if (image == NULL)
+    {
+        SDL_Log("ERROR: Failed to load %s: %s", input, SDL_GetError());
+        return 1;
+    }
+
+    SDL_Surface *converted = SDL_ConvertSurface(image, SDL_PIXELFORMAT_ABGR8888);
+    SDL_DestroySurface(image);
+
+    if (converted == NULL)
+    {
+        SDL_Log("ERROR: Failed to convert %s: %s", input, SDL_GetError());
+        return 1;
+    }
+
+    SDL_IOStream *io = SDL_IOFromFile(output, "wb");
+    if (io == NULL)
+    {
+        SDL_Log("ERROR: Failed to create %s: %s", output, SDL_GetError());
+        SDL_DestroySurface(converted);
+        return 1;
+    }
+
+    bool encoded = APP_QOI_Encode(converted, slice_rows, io);
+    Sint64 size = SDL_GetIOSize(io);
+
+    if (!SDL_CloseIO(io) || !encoded)
+    {
+        SDL_Log("ERROR: Failed to write %s.", output);
+        SDL_RemovePath(output);
+        SDL_DestroySurface(converted);
+        return 1;
+    }
+
+    Sint64 raw_size = (Sint64)converted->w * converted->h * 4;
+    SDL_Log(
+            "INFO: Wrote %s, %ix%i, %lld bytes (%.1f%% of the pixels)",
+            output,
+            converted->w,
+            converted->h,
+            (long long)size,
+            raw_size > 0 ? 100.0 * (double)size / (double)raw_size : 0.0
+    );
+
+    SDL_DestroySurface(converted);
+    return 0;
+}
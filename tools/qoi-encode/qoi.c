@@ -0,0 +1,547 @@
+#include "qoi.h"
+
+#define QOI_HEADER_SIZE 14
+#define QOI_END_MARKER_SIZE 8
+#define QOI_SLICE_FOOTER_SIZE 8
+// Same limit as the reference implementation.
+#define QOI_MAX_PIXELS 400000000u
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+#define QOI_MASK_2 0xc0
+
+#define QOI_MAX_RUN 62
+
+// Below this many pixels starting threads costs more than it saves.
+#define QOI_PARALLEL_PIXELS (256 * 256)
+
+static const Uint8 QOI_END_MARKER[QOI_END_MARKER_SIZE] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+struct APP_QOIColor {
+    Uint8 r, g, b, a;
+};
+
+struct APP_QOISlice {
+    Uint32 first_row;
+    Uint32 row_count;
+    size_t begin;
+    size_t end;
+};
+
+// A decode shared by the threads, each one takes the next slice.
+struct APP_QOIJob {
+    const Uint8 *data;
+    Uint32 width;
+    Uint8 *dst;
+    int dst_pitch;
+
+    struct APP_QOISlice slices[APP_QOI_MAX_SLICES];
+    Uint32 slice_count;
+
+    SDL_AtomicInt next_slice;
+    SDL_AtomicInt failed;
+};
+
+static Uint32
+APP_QOI_ReadU32(const Uint8 *p)
+{
+    return ((Uint32)p[0] << 24) | ((Uint32)p[1] << 16) | ((Uint32)p[2] << 8) | (Uint32)p[3];
+}
+
+static Uint8*
+APP_QOI_WriteU32(Uint8 *p, Uint32 value)
+{
+    p[0] = (Uint8)(value >> 24);
+    p[1] = (Uint8)(value >> 16);
+    p[2] = (Uint8)(value >> 8);
+    p[3] = (Uint8)value;
+    return p + 4;
+}
+
+static Uint32
+APP_QOI_Hash(struct APP_QOIColor c)
+{
+    return (c.r * 3u + c.g * 5u + c.b * 7u + c.a * 11u) % 64u;
+}
+
+bool
+APP_QOI_IsQOI(const void *data, size_t size)
+{
+    return size >= 4 && SDL_memcmp(data, "qoif", 4) == 0;
+}
+
+// Validate the header and the slice table, a plain image is a single
+// slice over all of the chunks.
+static bool
+APP_QOI_Parse(const Uint8 *data, size_t size, struct APP_QOIInfo *out_info, struct APP_QOISlice *out_slices)
+{
+    if (size < QOI_HEADER_SIZE + QOI_END_MARKER_SIZE || !APP_QOI_IsQOI(data, size))
+    {
+        return false;
+    }
+
+    Uint32 width = APP_QOI_ReadU32(data + 4);
+    Uint32 height = APP_QOI_ReadU32(data + 8);
+    Uint8 channels = data[12];
+    Uint8 colorspace = data[13];
+
+    if (width == 0 || height == 0 || channels < 3 || channels > 4 || colorspace > 1
+        || height >= QOI_MAX_PIXELS / width)
+    {
+        return false;
+    }
+
+    size_t chunks_end = size - QOI_END_MARKER_SIZE;
+    Uint32 slice_count = 1;
+    const Uint8 *table = NULL;
+
+    if (size >= QOI_HEADER_SIZE + QOI_END_MARKER_SIZE + QOI_SLICE_FOOTER_SIZE
+        && SDL_memcmp(data + size - 4, "qslc", 4) == 0)
+    {
+        slice_count = APP_QOI_ReadU32(data + size - 8);
+        size_t table_size = (size_t)slice_count * 8;
+
+        if (slice_count == 0 || slice_count > APP_QOI_MAX_SLICES
+            || table_size > size - QOI_HEADER_SIZE - QOI_END_MARKER_SIZE - QOI_SLICE_FOOTER_SIZE)
+        {
+            return false;
+        }
+
+        table = data + size - QOI_SLICE_FOOTER_SIZE - table_size;
+        chunks_end = (size_t)(table - data) - QOI_END_MARKER_SIZE;
+    }
+
+    if (SDL_memcmp(data + chunks_end, QOI_END_MARKER, QOI_END_MARKER_SIZE) != 0)
+    {
+        return false;
+    }
+
+    if (out_slices != NULL)
+    {
+        for (Uint32 i = 0; i < slice_count; ++i)
+        {
+            Uint32 first_row = table ? APP_QOI_ReadU32(table + i * 8) : 0;
+            size_t begin = table ? APP_QOI_ReadU32(table + i * 8 + 4) : QOI_HEADER_SIZE;
+
+            // Slices follow each other without gaps from the first row
+            // and the first chunk on.
+            bool first = i == 0;
+            if ((first && (first_row != 0 || begin != QOI_HEADER_SIZE))
+                || (!first && (first_row <= out_slices[i - 1].first_row || begin < out_slices[i - 1].begin))
+                || first_row >= height
+                || begin > chunks_end)
+            {
+                return false;
+            }
+
+            out_slices[i].first_row = first_row;
+            out_slices[i].begin = begin;
+
+            if (!first)
+            {
+                out_slices[i - 1].row_count = first_row - out_slices[i - 1].first_row;
+                out_slices[i - 1].end = begin;
+            }
+        }
+
+        out_slices[slice_count - 1].row_count = height - out_slices[slice_count - 1].first_row;
+        out_slices[slice_count - 1].end = chunks_end;
+    }
+
+    out_info->width = width;
+    out_info->height = height;
+    out_info->channels = channels;
+    out_info->slice_count = slice_count;
+    return true;
+}
+
+bool
+APP_QOI_ReadInfo(const void *data, size_t size, struct APP_QOIInfo *out_info)
+{
+    return APP_QOI_Parse(data, size, out_info, NULL);
+}
+
+// ====================
+// Decoding
+// ====================
+
+static bool
+APP_QOI_DecodeSlice(const Uint8 *data, const struct APP_QOISlice *slice, Uint32 width, Uint8 *dst, int dst_pitch)
+{
+    struct APP_QOIColor index[64];
+    struct APP_QOIColor px = { 0, 0, 0, 255 };
+    size_t p = slice->begin;
+    size_t end = slice->end;
+    Uint32 run = 0;
+
+    SDL_zeroa(index);
+
+    for (Uint32 y = 0; y < slice->row_count; ++y)
+    {
+        struct APP_QOIColor *row = (struct APP_QOIColor *)(dst + (size_t)(slice->first_row + y) * dst_pitch);
+
+        for (Uint32 x = 0; x < width; ++x)
+        {
+            if (run > 0)
+            {
+                run--;
+                row[x] = px;
+                continue;
+            }
+
+            if (p >= end)
+            {
+                return false;
+            }
+
+            Uint8 b1 = data[p++];
+
+            if (b1 == QOI_OP_RGB)
+            {
+                if (end - p < 3)
+                {
+                    return false;
+                }
+
+                px.r = data[p];
+                px.g = data[p + 1];
+                px.b = data[p + 2];
+                p += 3;
+            }
+            else if (b1 == QOI_OP_RGBA)
+            {
+                if (end - p < 4)
+                {
+                    return false;
+                }
+
+                px.r = data[p];
+                px.g = data[p + 1];
+                px.b = data[p + 2];
+                px.a = data[p + 3];
+                p += 4;
+            }
+            else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX)
+            {
+                px = index[b1];
+            }
+            else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF)
+            {
+                px.r += ((b1 >> 4) & 0x03) - 2;
+                px.g += ((b1 >> 2) & 0x03) - 2;
+                px.b += (b1 & 0x03) - 2;
+            }
+            else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA)
+            {
+                if (p >= end)
+                {
+                    return false;
+                }
+
+                Uint8 b2 = data[p++];
+                int vg = (b1 & 0x3f) - 32;
+                px.r += vg - 8 + ((b2 >> 4) & 0x0f);
+                px.g += vg;
+                px.b += vg - 8 + (b2 & 0x0f);
+            }
+            else
+            {
+                run = b1 & 0x3f;
+            }
+
+            index[APP_QOI_Hash(px)] = px;
+            row[x] = px;
+        }
+    }
+
+    return true;
+}
+
+static int
+APP_QOI_Worker(void *data)
+{
+    struct APP_QOIJob *job = data;
+
+    for (;;)
+    {
+        int i = SDL_AddAtomicInt(&job->next_slice, 1);
+        if (i >= (int)job->slice_count || SDL_GetAtomicInt(&job->failed))
+        {
+            return 0;
+        }
+
+        if (!APP_QOI_DecodeSlice(job->data, &job->slices[i], job->width, job->dst, job->dst_pitch))
+        {
+            SDL_SetAtomicInt(&job->failed, 1);
+        }
+    }
+}
+
+bool
+APP_QOI_Decode(const void *data, size_t size, void *dst, int dst_pitch, Uint32 thread_count)
+{
+    struct APP_QOIJob *job = SDL_calloc(1, sizeof(struct APP_QOIJob));
+    if (job == NULL)
+    {
+        return false;
+    }
+
+    struct APP_QOIInfo info;
+    if (!APP_QOI_Parse(data, size, &info, job->slices))
+    {
+        SDL_Log("ERROR: Invalid QOI image.");
+        SDL_free(job);
+        return false;
+    }
+
+    job->data = data;
+    job->width = info.width;
+    job->dst = dst;
+    job->dst_pitch = dst_pitch;
+    job->slice_count = info.slice_count;
+
+    if (thread_count > APP_QOI_MAX_THREADS)
+    {
+        thread_count = APP_QOI_MAX_THREADS;
+    }
+
+    if (thread_count > info.slice_count)
+    {
+        thread_count = info.slice_count;
+    }
+
+    if ((Uint64)info.width * info.height < QOI_PARALLEL_PIXELS)
+    {
+        thread_count = 1;
+    }
+
+    // Note(john): The calling thread decodes slices too. If a thread can't
+    // be started the others take over its slices.
+    SDL_Thread *threads[APP_QOI_MAX_THREADS] = { 0 };
+    for (Uint32 i = 1; i < thread_count; ++i)
+    {
+        threads[i] = SDL_CreateThread(APP_QOI_Worker, "QOI Decode", job);
+    }
+
+    APP_QOI_Worker(job);
+
+    for (Uint32 i = 1; i < thread_count; ++i)
+    {
+        SDL_WaitThread(threads[i], NULL);
+    }
+
+    bool decoded = SDL_GetAtomicInt(&job->failed) == 0;
+    if (!decoded)
+    {
+        SDL_Log("ERROR: Corrupt QOI image data.");
+    }
+
+    SDL_free(job);
+    return decoded;
+}
+
+// ====================
+// Encoding
+// ====================
+
+// The channel count in the header is only informative, it tells whether
+// any pixel isn't opaque.
+static bool
+APP_QOI_HasAlpha(SDL_Surface *surface)
+{
+    for (int y = 0; y < surface->h; ++y)
+    {
+        const struct APP_QOIColor *row =
+            (const struct APP_QOIColor *)((const Uint8 *)surface->pixels + (size_t)y * surface->pitch);
+
+        for (int x = 0; x < surface->w; ++x)
+        {
+            if (row[x].a != 255)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool
+APP_QOI_Encode(SDL_Surface *surface, Uint32 slice_rows, SDL_IOStream *out)
+{
+    if (surface->format != SDL_PIXELFORMAT_ABGR8888)
+    {
+        SDL_Log("ERROR: QOI encoding needs an ABGR8888 surface.");
+        return false;
+    }
+
+    Uint32 width = (Uint32)surface->w;
+    Uint32 height = (Uint32)surface->h;
+
+    if (slice_rows == 0 || slice_rows > height)
+    {
+        slice_rows = height;
+    }
+
+    Uint32 slice_count = (height + slice_rows - 1) / slice_rows;
+    if (slice_count > APP_QOI_MAX_SLICES)
+    {
+        slice_rows = (height + APP_QOI_MAX_SLICES - 1) / APP_QOI_MAX_SLICES;
+        slice_count = (height + slice_rows - 1) / slice_rows;
+    }
+
+    // Worst case every pixel is a QOI_OP_RGBA.
+    size_t capacity = QOI_HEADER_SIZE + (size_t)width * height * 5 + QOI_END_MARKER_SIZE
+        + (size_t)slice_count * 8 + QOI_SLICE_FOOTER_SIZE;
+
+    Uint8 *bytes = SDL_malloc(capacity);
+    Uint32 *slice_offsets = SDL_malloc(slice_count * sizeof(Uint32));
+    if (bytes == NULL || slice_offsets == NULL)
+    {
+        SDL_Log("ERROR: Failed to allocate %zu bytes for QOI encoding.", capacity);
+        SDL_free(bytes);
+        SDL_free(slice_offsets);
+        return false;
+    }
+
+    Uint8 *p = bytes;
+    SDL_memcpy(p, "qoif", 4);
+    p = APP_QOI_WriteU32(p + 4, width);
+    p = APP_QOI_WriteU32(p, height);
+    *p++ = APP_QOI_HasAlpha(surface) ? 4 : 3;
+    *p++ = 0;
+
+    struct APP_QOIColor index[64];
+    struct APP_QOIColor prev = { 0, 0, 0, 255 };
+    // Index entries written inside the current slice, only those may be
+    // referenced.
+    Uint64 index_valid = 0;
+    Uint32 run = 0;
+
+    SDL_zeroa(index);
+
+    for (Uint32 y = 0; y < height; ++y)
+    {
+        bool slice_start = y % slice_rows == 0;
+        if (slice_start)
+        {
+            slice_offsets[y / slice_rows] = (Uint32)(p - bytes);
+            index_valid = 0;
+        }
+
+        const struct APP_QOIColor *row =
+            (const struct APP_QOIColor *)((const Uint8 *)surface->pixels + (size_t)y * surface->pitch);
+
+        for (Uint32 x = 0; x < width; ++x)
+        {
+            struct APP_QOIColor px = row[x];
+            bool first = slice_start && x == 0;
+
+            if (!first && SDL_memcmp(&px, &prev, sizeof(px)) == 0)
+            {
+                run++;
+
+                // Runs end with the slice.
+                bool slice_end = x == width - 1 && (y + 1) % slice_rows == 0;
+                if (run == QOI_MAX_RUN || slice_end || (x == width - 1 && y == height - 1))
+                {
+                    *p++ = (Uint8)(QOI_OP_RUN | (run - 1));
+                    run = 0;
+                }
+
+                continue;
+            }
+
+            if (run > 0)
+            {
+                *p++ = (Uint8)(QOI_OP_RUN | (run - 1));
+                run = 0;
+            }
+
+            Uint32 hash = APP_QOI_Hash(px);
+
+            if ((index_valid & ((Uint64)1 << hash)) && SDL_memcmp(&index[hash], &px, sizeof(px)) == 0)
+            {
+                *p++ = (Uint8)(QOI_OP_INDEX | hash);
+            }
+            else
+            {
+                index[hash] = px;
+                index_valid |= (Uint64)1 << hash;
+
+                if (first)
+                {
+                    // Note(john): The first pixel can't depend on the one
+                    // before, a slice decoder doesn't know it.
+                    *p++ = QOI_OP_RGBA;
+                    *p++ = px.r;
+                    *p++ = px.g;
+                    *p++ = px.b;
+                    *p++ = px.a;
+                }
+                else if (px.a == prev.a)
+                {
+                    Sint8 vr = (Sint8)(px.r - prev.r);
+                    Sint8 vg = (Sint8)(px.g - prev.g);
+                    Sint8 vb = (Sint8)(px.b - prev.b);
+                    Sint8 vg_r = (Sint8)(vr - vg);
+                    Sint8 vg_b = (Sint8)(vb - vg);
+
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+                    {
+                        *p++ = (Uint8)(QOI_OP_DIFF | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));
+                    }
+                    else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8)
+                    {
+                        *p++ = (Uint8)(QOI_OP_LUMA | (vg + 32));
+                        *p++ = (Uint8)(((vg_r + 8) << 4) | (vg_b + 8));
+                    }
+                    else
+                    {
+                        *p++ = QOI_OP_RGB;
+                        *p++ = px.r;
+                        *p++ = px.g;
+                        *p++ = px.b;
+                    }
+                }
+                else
+                {
+                    *p++ = QOI_OP_RGBA;
+                    *p++ = px.r;
+                    *p++ = px.g;
+                    *p++ = px.b;
+                    *p++ = px.a;
+                }
+            }
+
+            prev = px;
+        }
+    }
+
+    SDL_memcpy(p, QOI_END_MARKER, QOI_END_MARKER_SIZE);
+    p += QOI_END_MARKER_SIZE;
+
+    if (slice_count > 1)
+    {
+        for (Uint32 i = 0; i < slice_count; ++i)
+        {
+            p = APP_QOI_WriteU32(p, i * slice_rows);
+            p = APP_QOI_WriteU32(p, slice_offsets[i]);
+        }
+
+        p = APP_QOI_WriteU32(p, slice_count);
+        SDL_memcpy(p, "qslc", 4);
+        p += 4;
+    }
+
+    size_t size = (size_t)(p - bytes);
+    bool written = SDL_WriteIO(out, bytes, size) == size;
+
+    SDL_free(bytes);
+    SDL_free(slice_offsets);
+    return written;
+}
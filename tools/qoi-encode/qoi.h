@@ -0,0 +1,40 @@
+#ifndef QOI_H
+#define QOI_H
+
+#include <SDL3/SDL.h>
+
+// Lossless QOI images (qoiformat.org), decoded into ABGR8888 which is the
+// RGBA byte order of QOI.
+//
+// Images written by APP_QOI_Encode are cut into slices of rows that decode
+// in parallel: every slice starts with a full RGBA pixel, no run crosses
+// into it and it only indexes colors seen inside of it. Other decoders
+// still read them as plain QOI. The slices are listed after the end marker,
+// big endian like the rest of QOI:
+//   { Uint32 first_row, Uint32 offset }[slice_count]
+//   Uint32 slice_count
+//   "qslc"
+
+#define APP_QOI_MAX_SLICES 256
+#define APP_QOI_MAX_THREADS 8
+
+struct APP_QOIInfo {
+    Uint32 width;
+    Uint32 height;
+    Uint8 channels;
+    // 1 for images without a slice table.
+    Uint32 slice_count;
+};
+
+bool APP_QOI_IsQOI(const void *data, size_t size);
+bool APP_QOI_ReadInfo(const void *data, size_t size, struct APP_QOIInfo *out_info);
+
+// Decode into ABGR8888 rows of dst. Sliced images are decoded on up to
+// thread_count threads, the calling thread included.
+bool APP_QOI_Decode(const void *data, size_t size, void *dst, int dst_pitch, Uint32 thread_count);
+
+// Encode an ABGR8888 surface with a new slice every slice_rows rows, 0
+// for a single slice.
+bool APP_QOI_Encode(SDL_Surface *surface, Uint32 slice_rows, SDL_IOStream *out);
+
+#endif